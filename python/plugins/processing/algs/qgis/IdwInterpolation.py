@@ -52,6 +52,8 @@ class IdwInterpolation(GeoAlgorithm):
 
     INTERPOLATION_DATA = 'INTERPOLATION_DATA'
     DISTANCE_COEFFICIENT = 'DISTANCE_COEFFICIENT'
+    SEARCH_RADIUS = 'SEARCH_RADIUS'
+    MAX_POINTS = 'MAX_POINTS'
     COLUMNS = 'COLUMNS'
     ROWS = 'ROWS'
     CELLSIZE_X = 'CELLSIZE_X'
@@ -127,6 +129,12 @@ class IdwInterpolation(GeoAlgorithm):
         self.addParameter(ParameterNumber(self.DISTANCE_COEFFICIENT,
                                           self.tr('Distance coefficient P'),
                                           0.0, 99.99, 2.0))
+        self.addParameter(ParameterNumber(self.SEARCH_RADIUS,
+                                          self.tr('Search radius (0 for unlimited)'),
+                                          0.0, None, 0.0, optional=True))
+        self.addParameter(ParameterNumber(self.MAX_POINTS,
+                                          self.tr('Maximum number of points (0 for all)'),
+                                          0, None, 0, optional=True))
         self.addParameter(ParameterNumber(self.COLUMNS,
                                           self.tr('Number of columns'),
                                           0, 10000000, 300))
@@ -148,6 +156,8 @@ class IdwInterpolation(GeoAlgorithm):
     def processAlgorithm(self, context, feedback):
         interpolationData = self.getParameterValue(self.INTERPOLATION_DATA)
         coefficient = self.getParameterValue(self.DISTANCE_COEFFICIENT)
+        searchRadius = self.getParameterValue(self.SEARCH_RADIUS)
+        maxPoints = self.getParameterValue(self.MAX_POINTS)
         columns = self.getParameterValue(self.COLUMNS)
         rows = self.getParameterValue(self.ROWS)
         cellsizeX = self.getParameterValue(self.CELLSIZE_X)
@@ -188,6 +198,10 @@ class IdwInterpolation(GeoAlgorithm):
 
         interpolator = QgsIDWInterpolator(layerData)
         interpolator.setDistanceCoefficient(coefficient)
+        if searchRadius:
+            interpolator.setSearchRadius(searchRadius)
+        if maxPoints:
+            interpolator.setMaxPoints(int(maxPoints))
 
         writer = QgsGridFileWriter(interpolator,
                                    output,
@@ -196,5 +210,7 @@ class IdwInterpolation(GeoAlgorithm):
                                    rows,
                                    cellsizeX,
                                    cellsizeY)
+        if os.path.splitext(output)[1].lower() in ('.tif', '.tiff'):
+            writer.setOutputFormat(QgsGridFileWriter.GeoTiff)
 
         writer.writeFile()
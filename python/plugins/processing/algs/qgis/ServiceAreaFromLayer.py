@@ -216,7 +216,7 @@ class ServiceAreaFromLayer(GeoAlgorithm):
             points.append(f.geometry().asPoint())
 
         feedback.pushInfo(self.tr('Building graph...'))
-        snappedPoints = director.makeGraph(builder, points)
+        snappedPoints = director.makeGraph(builder, points, feedback)
 
         feedback.pushInfo(self.tr('Calculating service areas...'))
         graph = builder.graph()
@@ -204,7 +204,7 @@ class ServiceAreaFromPoint(GeoAlgorithm):
                                   True,
                                   tolerance)
         feedback.pushInfo(self.tr('Building graph...'))
-        snappedPoints = director.makeGraph(builder, [startPoint])
+        snappedPoints = director.makeGraph(builder, [startPoint], feedback)
 
         feedback.pushInfo(self.tr('Calculating service area...'))
         graph = builder.graph()
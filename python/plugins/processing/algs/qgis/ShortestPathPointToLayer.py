@@ -218,7 +218,7 @@ class ShortestPathPointToLayer(GeoAlgorithm):
             points.append(f.geometry().asPoint())
 
         feedback.pushInfo(self.tr('Building graph...'))
-        snappedPoints = director.makeGraph(builder, points)
+        snappedPoints = director.makeGraph(builder, points, feedback)
 
         feedback.pushInfo(self.tr('Calculating shortest paths...'))
         graph = builder.graph()
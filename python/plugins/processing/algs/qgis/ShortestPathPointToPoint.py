@@ -216,7 +216,7 @@ class ShortestPathPointToPoint(GeoAlgorithm):
                                   True,
                                   tolerance)
         feedback.pushInfo(self.tr('Building graph...'))
-        snappedPoints = director.makeGraph(builder, [startPoint, endPoint])
+        snappedPoints = director.makeGraph(builder, [startPoint, endPoint], feedback)
 
         feedback.pushInfo(self.tr('Calculating shortest path...'))
         graph = builder.graph()
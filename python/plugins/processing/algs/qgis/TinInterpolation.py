@@ -220,5 +220,7 @@ class TinInterpolation(GeoAlgorithm):
                                    rows,
                                    cellsizeX,
                                    cellsizeY)
+        if os.path.splitext(output)[1].lower() in ('.tif', '.tiff'):
+            writer.setOutputFormat(QgsGridFileWriter.GeoTiff)
 
         writer.writeFile()
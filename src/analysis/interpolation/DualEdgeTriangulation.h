@@ -120,8 +120,8 @@ class ANALYSIS_EXPORT DualEdgeTriangulation: public Triangulation
     QVector<Point3D *> mPointVector;
     //! Default value for the number of storable HalfEdges at the beginning
     static const unsigned int DEFAULT_STORAGE_FOR_HALF_EDGES = 300006;
-    //! Stores pointers to the HalfEdges
-    QVector<HalfEdge *> mHalfEdge;
+    //! Stores the HalfEdges contiguously, addressed by their number
+    QVector<HalfEdge> mHalfEdge;
     //! Association to an interpolator object
     TriangleInterpolator *mTriangleInterpolator = nullptr;
     //! Member to store the behavior in case of crossing forced segments
@@ -176,6 +176,25 @@ class ANALYSIS_EXPORT DualEdgeTriangulation: public Triangulation
     bool edgeOnConvexHull( int edge );
     //! Function needed for the ruppert algorithm. Tests, if point is in the circle through both endpoints of edge and the endpoint of edge->dual->next->point. If so, the function calls itself recursively for edge->next and edge->next->next. Stops, if it finds a forced edge or a convex hull edge
     void evaluateInfluenceRegion( Point3D *point, int edge, QSet<int> &set );
+
+  private:
+    //! Start edge and results of a point location, corresponding to the members set by 'baseEdgeOfTriangle'
+    struct WalkState
+    {
+      unsigned int edgeInside;
+      unsigned int edgeOutside;
+      unsigned int edgeWithPoint;
+      unsigned int unstableEdge;
+      int twiceInsPoint;
+    };
+    //! Same as 'baseEdgeOfTriangle', but starts at and reports to 'state' instead of the members, so that several threads may locate points at the same time
+    int locatePoint( Point3D *point, WalkState &state ) const;
+    //! Same as 'baseEdgeOfPoint', but starts the search at 'startEdge' and stores the found edge there instead of in 'mEdgeInside'
+    int locateEdgeOfPoint( int point, unsigned int &startEdge ) const;
+    //! Finds the numbers of the vertices of the triangle containing the point with coordinates x and y without modifying the triangulation
+    bool locateTriangle( double x, double y, int &ptnr1, int &ptnr2, int &ptnr3 ) const;
+    //! Returns the edge found by the last location of the calling thread if it belongs to this triangulation, 'mEdgeInside' otherwise
+    unsigned int walkStartEdge() const;
 };
 
 inline DualEdgeTriangulation::DualEdgeTriangulation()
@@ -233,14 +252,14 @@ inline Point3D *DualEdgeTriangulation::getPoint( unsigned int i ) const
 inline bool DualEdgeTriangulation::halfEdgeBBoxTest( int edge, double xlowleft, double ylowleft, double xupright, double yupright ) const
 {
   return (
-           ( getPoint( mHalfEdge[edge]->getPoint() )->getX() >= xlowleft &&
-             getPoint( mHalfEdge[edge]->getPoint() )->getX() <= xupright &&
-             getPoint( mHalfEdge[edge]->getPoint() )->getY() >= ylowleft &&
-             getPoint( mHalfEdge[edge]->getPoint() )->getY() <= yupright ) ||
-           ( getPoint( mHalfEdge[mHalfEdge[edge]->getDual()]->getPoint() )->getX() >= xlowleft &&
-             getPoint( mHalfEdge[mHalfEdge[edge]->getDual()]->getPoint() )->getX() <= xupright &&
-             getPoint( mHalfEdge[mHalfEdge[edge]->getDual()]->getPoint() )->getY() >= ylowleft &&
-             getPoint( mHalfEdge[mHalfEdge[edge]->getDual()]->getPoint() )->getY() <= yupright )
+           ( getPoint( mHalfEdge[edge].getPoint() )->getX() >= xlowleft &&
+             getPoint( mHalfEdge[edge].getPoint() )->getX() <= xupright &&
+             getPoint( mHalfEdge[edge].getPoint() )->getY() >= ylowleft &&
+             getPoint( mHalfEdge[edge].getPoint() )->getY() <= yupright ) ||
+           ( getPoint( mHalfEdge[mHalfEdge[edge].getDual()].getPoint() )->getX() >= xlowleft &&
+             getPoint( mHalfEdge[mHalfEdge[edge].getDual()].getPoint() )->getX() <= xupright &&
+             getPoint( mHalfEdge[mHalfEdge[edge].getDual()].getPoint() )->getY() >= ylowleft &&
+             getPoint( mHalfEdge[mHalfEdge[edge].getDual()].getPoint() )->getY() <= yupright )
          );
 }
 
@@ -18,6 +18,7 @@
 #define HALFEDGE_H
 
 #include "qgis_analysis.h"
+#include <QtGlobal>
 
 /** \ingroup analysis
  * \class HalfEdge
@@ -123,4 +124,7 @@ inline void HalfEdge::setForced( bool f )
   mForced = f;
 }
 
+//! HalfEdges are stored by value in DualEdgeTriangulation and may be moved in memory when the storage grows
+Q_DECLARE_TYPEINFO( HalfEdge, Q_MOVABLE_TYPE );
+
 #endif
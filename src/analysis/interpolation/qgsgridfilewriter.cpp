@@ -21,6 +21,14 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QProgressDialog>
+#include <QtConcurrentMap>
+
+#include <memory>
+
+#include <gdal.h>
+
+//! Number of grid rows which are interpolated and written as one block
+static const int GRID_BLOCK_ROWS = 64;
 
 QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputPath, const QgsRectangle &extent, int nCols, int nRows, double cellSizeX, double cellSizeY )
   : mInterpolator( i )
@@ -47,67 +55,147 @@ QgsGridFileWriter::QgsGridFileWriter()
 int QgsGridFileWriter::writeFile( bool showProgressDialog )
 {
   QFile outputFile( mOutputFilePath );
+  QTextStream outStream;
+  GDALDatasetH outputDataset = nullptr;
+  GDALRasterBandH outputBand = nullptr;
 
-  if ( !outputFile.open( QFile::WriteOnly | QIODevice::Truncate ) )
+  if ( mOutputFormat == GeoTiff )
+  {
+    GDALAllRegister();
+    GDALDriverH driver = GDALGetDriverByName( "GTiff" );
+    if ( !driver )
+      return 1;
+
+    outputDataset = GDALCreate( driver, mOutputFilePath.toUtf8().constData(), mNumColumns, mNumRows, 1, GDT_Float32, nullptr );
+    if ( !outputDataset )
+      return 1;
+    outputBand = GDALGetRasterBand( outputDataset, 1 );
+  }
+  else if ( !outputFile.open( QFile::WriteOnly | QIODevice::Truncate ) )
   {
     return 1;
   }
 
-  if ( !mInterpolator )
+  if ( !mInterpolator || mInterpolator->layerData().isEmpty() )
   {
-    outputFile.remove();
+    if ( outputDataset )
+      GDALClose( outputDataset );
+    QFile::remove( mOutputFilePath );
     return 2;
   }
 
-  QTextStream outStream( &outputFile );
-  outStream.setRealNumberPrecision( 8 );
-  writeHeader( outStream );
+  QgsVectorLayer *vl = mInterpolator->layerData().first().vectorLayer;
+  QString crs = vl ? vl->crs().toWkt() : QString();
+
+  if ( outputDataset )
+  {
+    double geoTransform[6] = { mInterpolationExtent.xMinimum(), mCellSizeX, 0, mInterpolationExtent.yMaximum(), 0, -mCellSizeY };
+    GDALSetGeoTransform( outputDataset, geoTransform );
+    GDALSetProjection( outputDataset, crs.toLocal8Bit().constData() );
+    GDALSetRasterNoDataValue( outputBand, -9999 );
+  }
+  else
+  {
+    outStream.setDevice( &outputFile );
+    outStream.setRealNumberPrecision( 8 );
+    writeHeader( outStream );
+  }
+
+  // cache the base data before the rows are interpolated by several threads
+  if ( mInterpolator->prepare() != 0 )
+  {
+    if ( outputDataset )
+      GDALClose( outputDataset );
+    else
+      outputFile.close();
+    QFile::remove( mOutputFilePath );
+    return 2;
+  }
+  bool concurrent = mInterpolator->supportsConcurrentInterpolation();
 
   double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
-  double currentXValue;
-  double interpolatedValue;
 
-  QProgressDialog *progressDialog = nullptr;
+  std::unique_ptr< QProgressDialog > progressDialog;
   if ( showProgressDialog )
   {
-    progressDialog = new QProgressDialog( QObject::tr( "Interpolating..." ), QObject::tr( "Abort" ), 0, mNumRows, nullptr );
+    progressDialog.reset( new QProgressDialog( QObject::tr( "Interpolating..." ), QObject::tr( "Abort" ), 0, mNumRows, nullptr ) );
     progressDialog->setWindowModality( Qt::WindowModal );
   }
 
-  for ( int i = 0; i < mNumRows; ++i )
+  QVector< double > blockValues( GRID_BLOCK_ROWS * mNumColumns );
+  QVector< float > blockFloatValues;
+  QVector< GridRow > rows;
+  for ( int firstRow = 0; firstRow < mNumRows; firstRow += GRID_BLOCK_ROWS )
   {
-    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
-    for ( int j = 0; j < mNumColumns; ++j )
+    int blockRows = qMin( GRID_BLOCK_ROWS, mNumRows - firstRow );
+    rows.clear();
+    for ( int i = 0; i < blockRows; ++i )
+    {
+      GridRow row;
+      row.y = currentYValue;
+      row.values = blockValues.data() + i * mNumColumns;
+      rows << row;
+      currentYValue -= mCellSizeY;
+    }
+
+    if ( concurrent )
     {
-      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue ) == 0 )
+      QtConcurrent::blockingMap( rows, InterpolateRowWrapper( this ) );
+    }
+    else
+    {
+      for ( GridRow &row : rows )
+        interpolateRow( row );
+    }
+
+    if ( outputDataset )
+    {
+      blockFloatValues.resize( blockRows * mNumColumns );
+      for ( int i = 0; i < blockFloatValues.size(); ++i )
+        blockFloatValues[ i ] = blockValues.at( i );
+      if ( GDALRasterIO( outputBand, GF_Write, 0, firstRow, mNumColumns, blockRows, blockFloatValues.data(),
+                         mNumColumns, blockRows, GDT_Float32, 0, 0 ) != CE_None )
       {
-        outStream << interpolatedValue << ' ';
+        GDALClose( outputDataset );
+        return 1;
       }
-      else
+    }
+    else
+    {
+      for ( int i = 0; i < blockRows; ++i )
       {
-        outStream << "-9999 ";
+        const double *values = blockValues.constData() + i * mNumColumns;
+        for ( int j = 0; j < mNumColumns; ++j )
+        {
+          outStream << values[ j ] << ' ';
+        }
+        outStream << endl;
       }
-      currentXValue += mCellSizeX;
     }
-    outStream << endl;
-    currentYValue -= mCellSizeY;
 
     if ( showProgressDialog )
     {
       if ( progressDialog->wasCanceled() )
       {
-        outputFile.remove();
+        if ( outputDataset )
+          GDALClose( outputDataset );
+        else
+          outputFile.close();
+        QFile::remove( mOutputFilePath );
         return 3;
       }
-      progressDialog->setValue( i );
+      progressDialog->setValue( firstRow + blockRows - 1 );
     }
   }
 
+  if ( outputDataset )
+  {
+    // the CRS is stored in the GeoTIFF itself
+    GDALClose( outputDataset );
+    return 0;
+  }
+
   // create prj file
-  QgsInterpolator::LayerData ld;
-  ld = mInterpolator->layerData().first();
-  QgsVectorLayer *vl = ld.vectorLayer;
-  QString crs = vl->crs().toWkt();
   QFileInfo fi( mOutputFilePath );
   QString fileName = fi.absolutePath() + '/' + fi.completeBaseName() + ".prj";
   QFile prjFile( fileName );
@@ -120,10 +208,32 @@ int QgsGridFileWriter::writeFile( bool showProgressDialog )
   prjStream << endl;
   prjFile.close();
 
-  delete progressDialog;
   return 0;
 }
 
+void QgsGridFileWriter::InterpolateRowWrapper::operator()( GridRow &row )
+{
+  instance->interpolateRow( row );
+}
+
+void QgsGridFileWriter::interpolateRow( GridRow &row )
+{
+  double currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
+  double interpolatedValue;
+  for ( int j = 0; j < mNumColumns; ++j )
+  {
+    if ( mInterpolator->interpolatePoint( currentXValue, row.y, interpolatedValue ) == 0 )
+    {
+      row.values[ j ] = interpolatedValue;
+    }
+    else
+    {
+      row.values[ j ] = -9999;
+    }
+    currentXValue += mCellSizeX;
+  }
+}
+
 int QgsGridFileWriter::writeHeader( QTextStream &outStream )
 {
   outStream << "NCOLS " << mNumColumns << endl;
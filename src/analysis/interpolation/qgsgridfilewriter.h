@@ -26,11 +26,19 @@
 class QgsInterpolator;
 
 /** \ingroup analysis
- * A class that does interpolation to a grid and writes the results to an ascii grid*/
-//todo: extend such that writing to other file types is possible
+ * A class that does interpolation to a grid and writes the results to an ascii grid or a GeoTIFF.
+ * The rows of the grid are interpolated in parallel if the interpolator supports it.*/
 class ANALYSIS_EXPORT QgsGridFileWriter
 {
   public:
+
+    //! Format of the output file
+    enum OutputFormat
+    {
+      AsciiGrid, //!< ESRI ASCII grid, with the CRS in a .prj file
+      GeoTiff, //!< GeoTIFF with 32 bit float values
+    };
+
     QgsGridFileWriter( QgsInterpolator *i, const QString &outputPath, const QgsRectangle &extent, int nCols, int nRows, double cellSizeX, double cellSizeY );
 
     /** Writes the grid file.
@@ -39,11 +47,48 @@ class ANALYSIS_EXPORT QgsGridFileWriter
 
     int writeFile( bool showProgressDialog = false );
 
+    /**
+     * Sets the \a format of the output file. The default is an ASCII grid.
+     * \see outputFormat()
+     * \since QGIS 3.0
+     */
+    void setOutputFormat( OutputFormat format ) { mOutputFormat = format; }
+
+    /**
+     * Returns the format of the output file.
+     * \see setOutputFormat()
+     * \since QGIS 3.0
+     */
+    OutputFormat outputFormat() const { return mOutputFormat; }
+
   private:
 
     QgsGridFileWriter(); //forbidden
     int writeHeader( QTextStream &outStream );
 
+    //! A row of the grid, evaluated by a worker thread
+    struct GridRow
+    {
+      //! y-coordinate of the cell centers
+      double y;
+      //! Interpolated values of the row
+      double *values;
+    };
+
+    //! Interpolates the values of a row, used from the worker threads
+    struct InterpolateRowWrapper
+    {
+      QgsGridFileWriter *instance = nullptr;
+
+      explicit InterpolateRowWrapper( QgsGridFileWriter *_instance )
+        : instance( _instance )
+      {}
+
+      void operator()( GridRow &row );
+    };
+
+    void interpolateRow( GridRow &row );
+
     QgsInterpolator *mInterpolator = nullptr;
     QString mOutputFilePath;
     QgsRectangle mInterpolationExtent;
@@ -52,6 +97,8 @@ class ANALYSIS_EXPORT QgsGridFileWriter
 
     double mCellSizeX;
     double mCellSizeY;
+
+    OutputFormat mOutputFormat = AsciiGrid;
 };
 
 #endif
@@ -18,6 +18,107 @@
 #include "qgsidwinterpolator.h"
 #include <cmath>
 #include <limits>
+#include <algorithm>
+#include <vector>
+
+///@cond PRIVATE
+
+namespace
+{
+  //! Orders the range [begin, end) of the tree indices as a balanced k-d tree
+  void buildKdTree( QVector< int > &tree, const QVector< vertexData > &data, int begin, int end, int axis )
+  {
+    if ( end - begin <= 1 )
+      return;
+
+    int mid = begin + ( end - begin ) / 2;
+    std::nth_element( tree.begin() + begin, tree.begin() + mid, tree.begin() + end, [&data, axis]( int a, int b )
+    {
+      return axis == 0 ? data.at( a ).x < data.at( b ).x : data.at( a ).y < data.at( b ).y;
+    } );
+    buildKdTree( tree, data, begin, mid, 1 - axis );
+    buildKdTree( tree, data, mid + 1, end, 1 - axis );
+  }
+
+  //! Collects the points within a maximum distance, optionally limited to the nearest points
+  struct NeighbourSearch
+  {
+    NeighbourSearch( const QVector< vertexData > &data, const QVector< int > &tree, double x, double y, double maxSqrDist, int maxCount )
+      : data( data )
+      , tree( tree )
+      , x( x )
+      , y( y )
+      , maxSqrDist( maxSqrDist )
+      , maxCount( maxCount )
+    {}
+
+    //! Squared distance a point must not exceed to be added
+    double bound() const
+    {
+      if ( maxCount > 0 && static_cast< int >( neighbours.size() ) == maxCount )
+        return std::min( maxSqrDist, neighbours.front().first );
+      return maxSqrDist;
+    }
+
+    void add( double sqrDist, int index )
+    {
+      if ( maxCount <= 0 )
+      {
+        neighbours.push_back( std::make_pair( sqrDist, index ) );
+        return;
+      }
+
+      // neighbours is a max heap when the number of points is limited
+      if ( static_cast< int >( neighbours.size() ) == maxCount )
+      {
+        if ( sqrDist >= neighbours.front().first )
+          return;
+        std::pop_heap( neighbours.begin(), neighbours.end() );
+        neighbours.pop_back();
+      }
+      neighbours.push_back( std::make_pair( sqrDist, index ) );
+      std::push_heap( neighbours.begin(), neighbours.end() );
+    }
+
+    void search( int begin, int end, int axis )
+    {
+      if ( begin >= end )
+        return;
+
+      int mid = begin + ( end - begin ) / 2;
+      int index = tree.at( mid );
+      const vertexData &vertex = data.at( index );
+      double sqrDist = ( vertex.x - x ) * ( vertex.x - x ) + ( vertex.y - y ) * ( vertex.y - y );
+      if ( sqrDist <= bound() )
+        add( sqrDist, index );
+
+      // search the side of the splitting line containing the point first
+      double diff = axis == 0 ? x - vertex.x : y - vertex.y;
+      if ( diff < 0 )
+      {
+        search( begin, mid, 1 - axis );
+        if ( diff * diff <= bound() )
+          search( mid + 1, end, 1 - axis );
+      }
+      else
+      {
+        search( mid + 1, end, 1 - axis );
+        if ( diff * diff <= bound() )
+          search( begin, mid, 1 - axis );
+      }
+    }
+
+    const QVector< vertexData > &data;
+    const QVector< int > &tree;
+    double x;
+    double y;
+    double maxSqrDist;
+    int maxCount;
+    std::vector< std::pair< double, int > > neighbours;
+  };
+}
+
+///@endcond
 
 QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData> &layerData ): QgsInterpolator( layerData ), mDistanceCoefficient( 2.0 )
 {
@@ -29,30 +130,81 @@ QgsIDWInterpolator::QgsIDWInterpolator(): QgsInterpolator( QList<LayerData>() ),
 
 }
 
+int QgsIDWInterpolator::prepare()
+{
+  int result = QgsInterpolator::prepare();
+  if ( result == 0 && !mTreeBuilt )
+    buildTree();
+  return result;
+}
+
+void QgsIDWInterpolator::buildTree()
+{
+  mTree.resize( mCachedBaseData.size() );
+  for ( int i = 0; i < mTree.size(); ++i )
+    mTree[ i ] = i;
+  buildKdTree( mTree, mCachedBaseData, 0, mTree.size(), 0 );
+  mTreeBuilt = true;
+}
+
 int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result )
 {
-  if ( !mDataIsCached )
+  if ( !mDataIsCached || !mTreeBuilt )
   {
-    cacheBaseData();
+    prepare();
   }
 
+  // only read from the cached data, as this may be called from several threads
+  const QVector< vertexData > &data = mCachedBaseData;
+
   double currentWeight;
   double distance;
 
   double sumCounter = 0;
   double sumDenominator = 0;
 
-  Q_FOREACH ( const vertexData &vertex_it, mCachedBaseData )
+  if ( mSearchRadius <= 0 && mMaxPoints <= 0 )
+  {
+    for ( const vertexData &vertex_it : data )
+    {
+      distance = sqrt( ( vertex_it.x - x ) * ( vertex_it.x - x ) + ( vertex_it.y - y ) * ( vertex_it.y - y ) );
+      if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
+      {
+        result = vertex_it.z;
+        return 0;
+      }
+      currentWeight = 1 / ( pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * vertex_it.z );
+      sumDenominator += currentWeight;
+    }
+  }
+  else
   {
-    distance = sqrt( ( vertex_it.x - x ) * ( vertex_it.x - x ) + ( vertex_it.y - y ) * ( vertex_it.y - y ) );
-    if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
+    double maxSqrDist = mSearchRadius > 0 ? mSearchRadius * mSearchRadius : std::numeric_limits<double>::infinity();
+    NeighbourSearch search( data, mTree, x, y, maxSqrDist, mMaxPoints );
+    search.search( 0, mTree.size(), 0 );
+
+    // a point at the same location determines the value, the first one if there are several
+    int exactMatch = -1;
+    for ( const std::pair< double, int > &neighbour : search.neighbours )
+    {
+      distance = sqrt( neighbour.first );
+      if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
+      {
+        if ( exactMatch < 0 || neighbour.second < exactMatch )
+          exactMatch = neighbour.second;
+        continue;
+      }
+      currentWeight = 1 / ( pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * data.at( neighbour.second ).z );
+      sumDenominator += currentWeight;
+    }
+
+    if ( exactMatch >= 0 )
     {
-      result = vertex_it.z;
+      result = data.at( exactMatch ).z;
       return 0;
     }
-    currentWeight = 1 / ( pow( distance, mDistanceCoefficient ) );
-    sumCounter += ( currentWeight * vertex_it.z );
-    sumDenominator += currentWeight;
   }
 
   if ( sumDenominator == 0.0 )
@@ -36,16 +36,69 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
        \returns 0 in case of success*/
     int interpolatePoint( double x, double y, double &result ) override;
 
+    /**
+     * Caches the base data and builds the spatial index used by the search radius and
+     * maximum number of points.
+     * \returns 0 in case of success
+     */
+    int prepare() override;
+
+    bool supportsConcurrentInterpolation() const override { return true; }
+
     void setDistanceCoefficient( double p ) {mDistanceCoefficient = p;}
 
+    /**
+     * Sets the search \a radius (in map units). Only points within this distance contribute to
+     * an interpolated value. A radius of 0 means the distance is not limited.
+     * \see searchRadius()
+     * \since QGIS 3.0
+     */
+    void setSearchRadius( double radius ) { mSearchRadius = radius; }
+
+    /**
+     * Returns the search radius (in map units), or 0 if the distance is not limited.
+     * \see setSearchRadius()
+     * \since QGIS 3.0
+     */
+    double searchRadius() const { return mSearchRadius; }
+
+    /**
+     * Sets the maximum number of nearest points which contribute to an interpolated value.
+     * A \a count of 0 means all points are used.
+     * \see maxPoints()
+     * \since QGIS 3.0
+     */
+    void setMaxPoints( int count ) { mMaxPoints = count; }
+
+    /**
+     * Returns the maximum number of nearest points which contribute to an interpolated value,
+     * or 0 if all points are used.
+     * \see setMaxPoints()
+     * \since QGIS 3.0
+     */
+    int maxPoints() const { return mMaxPoints; }
+
   private:
 
     QgsIDWInterpolator(); //forbidden
 
+    //! Builds the k-d tree of the cached base data
+    void buildTree();
+
     /** The parameter that sets how the values are weighted with distance.
        Smaller values mean sharper peaks at the data points. The default is a
        value of 2*/
     double mDistanceCoefficient;
+
+    double mSearchRadius = 0;
+    int mMaxPoints = 0;
+
+    /**
+     * Indices of the cached base data, ordered as a balanced k-d tree: the median of a range
+     * is its node, splitting alternately by x and y.
+     */
+    QVector< int > mTree;
+    bool mTreeBuilt = false;
 };
 
 #endif
@@ -35,6 +35,17 @@ QgsInterpolator::QgsInterpolator()
 
 }
 
+int QgsInterpolator::prepare()
+{
+  if ( mDataIsCached )
+    return 0;
+
+  int result = cacheBaseData();
+  // also set if there is no data at all, so that interpolatePoint() never caches it again
+  mDataIsCached = result == 0;
+  return result;
+}
+
 int QgsInterpolator::cacheBaseData()
 {
   if ( mLayerData.size() < 1 )
@@ -326,6 +337,5 @@ int QgsInterpolator::addVerticesToCache( const QgsGeometry &geom, bool zCoord, d
     default:
       break;
   }
-  mDataIsCached = true;
   return 0;
 }
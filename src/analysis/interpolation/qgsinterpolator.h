@@ -67,6 +67,26 @@ class ANALYSIS_EXPORT QgsInterpolator
        \returns 0 in case of success*/
     virtual int interpolatePoint( double x, double y, double &result ) = 0;
 
+    /**
+     * Prepares the interpolator for calls to interpolatePoint(), e.g. by caching the base data.
+     * This is done by the first call to interpolatePoint() otherwise, but it must be done before
+     * interpolatePoint() is called from more than one thread. Once it succeeded, the interpolator
+     * is prepared even if there is no base data, and interpolatePoint() does not modify it anymore.
+     * \returns 0 in case of success. interpolatePoint() must not be called from several threads
+     * if preparing failed.
+     * \see supportsConcurrentInterpolation()
+     * \since QGIS 3.0
+     */
+    virtual int prepare();
+
+    /**
+     * Returns true if interpolatePoint() may be called from several threads at once,
+     * once prepare() has been called.
+     * \see prepare()
+     * \since QGIS 3.0
+     */
+    virtual bool supportsConcurrentInterpolation() const { return false; }
+
     //! \note not available in Python bindings
     QList<LayerData> layerData() const { return mLayerData; } SIP_SKIP
 
@@ -79,7 +99,7 @@ class ANALYSIS_EXPORT QgsInterpolator
 
     QVector<vertexData> mCachedBaseData;
 
-    //! Flag that tells if the cache already has been filled
+    //! Flag that tells if the cache already has been filled, set by prepare()
     bool mDataIsCached;
 
     //Information about the input vector layers and the attributes (or z-values) that are used for interpolation
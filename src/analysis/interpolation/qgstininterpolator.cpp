@@ -25,10 +25,53 @@
 #include "Point3D.h"
 #include "qgsfeature.h"
 #include "qgsgeometry.h"
+#include "qgslogger.h"
 #include "qgsvectorlayer.h"
 #include "qgswkbptr.h"
 #include <QProgressDialog>
 
+#include <algorithm>
+#include <random>
+
+///@cond PRIVATE
+namespace
+{
+  //! Number of points inserted in random order before the insertion follows the Hilbert curve
+  const int FIRST_ROUND_SIZE = 64;
+  //! Order of the Hilbert curve used to sort the points
+  const int HILBERT_ORDER = 16;
+
+  //! Returns the distance along a Hilbert curve of order HILBERT_ORDER to the cell x/y
+  quint64 hilbertIndex( quint32 x, quint32 y )
+  {
+    const quint32 n = 1u << HILBERT_ORDER;
+    quint64 d = 0;
+    for ( quint32 s = n / 2; s > 0; s /= 2 )
+    {
+      quint32 rx = ( x & s ) > 0;
+      quint32 ry = ( y & s ) > 0;
+      d += static_cast< quint64 >( s ) * s * ( ( 3 * rx ) ^ ry );
+      if ( ry == 0 )
+      {
+        if ( rx == 1 )
+        {
+          x = n - 1 - x;
+          y = n - 1 - y;
+        }
+        std::swap( x, y );
+      }
+    }
+    return d;
+  }
+
+  struct HilbertPoint
+  {
+    quint64 index;
+    Point3D *point;
+  };
+}
+///@endcond
+
 QgsTINInterpolator::QgsTINInterpolator( const QList<LayerData> &inputData, TINInterpolation interpolation, bool showProgressDialog )
   : QgsInterpolator( inputData )
   , mTriangulation( nullptr )
@@ -44,6 +87,8 @@ QgsTINInterpolator::~QgsTINInterpolator()
 {
   delete mTriangulation;
   delete mTriangleInterpolator;
+  qDeleteAll( mFreeInterpolators );
+  qDeleteAll( mPendingPoints );
 }
 
 int QgsTINInterpolator::interpolatePoint( double x, double y, double &result )
@@ -59,7 +104,20 @@ int QgsTINInterpolator::interpolatePoint( double x, double y, double &result )
   }
 
   Point3D r;
-  if ( !mTriangleInterpolator->calcPoint( x, y, &r ) )
+  bool pointCalculated = false;
+  if ( mInterpolation == CloughTocher )
+  {
+    //the Clough-Tocher interpolator keeps the control points of the last triangle, so concurrent calls need separate instances
+    CloughTocherInterpolator *interpolator = takeCloughTocherInterpolator();
+    pointCalculated = interpolator->calcPoint( x, y, &r );
+    releaseCloughTocherInterpolator( interpolator );
+  }
+  else
+  {
+    pointCalculated = mTriangleInterpolator->calcPoint( x, y, &r );
+  }
+
+  if ( !pointCalculated )
   {
     return 2;
   }
@@ -67,6 +125,15 @@ int QgsTINInterpolator::interpolatePoint( double x, double y, double &result )
   return 0;
 }
 
+int QgsTINInterpolator::prepare()
+{
+  if ( !mIsInitialized )
+  {
+    initialize();
+  }
+  return mTriangleInterpolator ? 0 : 1;
+}
+
 void QgsTINInterpolator::initialize()
 {
   DualEdgeTriangulation *dualEdgeTriangulation = new DualEdgeTriangulation( 100000, nullptr );
@@ -131,6 +198,10 @@ void QgsTINInterpolator::initialize()
       }
     }
   }
+  if ( insertPendingPoints() != 0 )
+  {
+    QgsDebugMsg( "Some points could not be inserted into the triangulation because of numerical problems" );
+  }
 
   delete progressDialog;
 
@@ -166,6 +237,93 @@ void QgsTINInterpolator::initialize()
   }
 }
 
+int QgsTINInterpolator::insertPendingPoints()
+{
+  if ( mPendingPoints.isEmpty() )
+  {
+    return 0;
+  }
+
+  //Points are located by walking through the triangulation from the last inserted point, so the insertion is
+  //fastest if consecutive points are close to each other. The points are shuffled and split into rounds which
+  //double in size (biased randomized insertion order), and each round is sorted along a Hilbert curve. The random
+  //rounds keep the intermediate triangulations well shaped, the curve keeps the walks short.
+  //std::shuffle is implementation defined, use a plain Fisher-Yates shuffle so that the triangulation is the same on all platforms
+  std::mt19937 generator( 1 );
+  for ( int i = mPendingPoints.size() - 1; i > 0; --i )
+  {
+    std::swap( mPendingPoints[ i ], mPendingPoints[ generator() % ( i + 1 ) ] );
+  }
+
+  double xMin = mPendingPoints.at( 0 )->getX();
+  double xMax = xMin;
+  double yMin = mPendingPoints.at( 0 )->getY();
+  double yMax = yMin;
+  for ( const Point3D *point : mPendingPoints )
+  {
+    xMin = qMin( xMin, point->getX() );
+    xMax = qMax( xMax, point->getX() );
+    yMin = qMin( yMin, point->getY() );
+    yMax = qMax( yMax, point->getY() );
+  }
+  const double maxCell = ( 1u << HILBERT_ORDER ) - 1;
+  double xScale = xMax > xMin ? maxCell / ( xMax - xMin ) : 0;
+  double yScale = yMax > yMin ? maxCell / ( yMax - yMin ) : 0;
+
+  QVector< HilbertPoint > round;
+  int roundStart = qMin( FIRST_ROUND_SIZE, mPendingPoints.size() );
+  while ( roundStart < mPendingPoints.size() )
+  {
+    int roundEnd = qMin( 2 * roundStart, mPendingPoints.size() );
+    round.resize( roundEnd - roundStart );
+    for ( int i = roundStart; i < roundEnd; ++i )
+    {
+      Point3D *point = mPendingPoints.at( i );
+      HilbertPoint &hilbertPoint = round[ i - roundStart ];
+      hilbertPoint.index = hilbertIndex( static_cast< quint32 >( ( point->getX() - xMin ) * xScale ),
+                                         static_cast< quint32 >( ( point->getY() - yMin ) * yScale ) );
+      hilbertPoint.point = point;
+    }
+    std::stable_sort( round.begin(), round.end(), []( const HilbertPoint & a, const HilbertPoint & b )
+    {
+      return a.index < b.index;
+    } );
+    for ( int i = roundStart; i < roundEnd; ++i )
+    {
+      mPendingPoints[ i ] = round.at( i - roundStart ).point;
+    }
+    roundStart = roundEnd;
+  }
+
+  int result = 0;
+  for ( Point3D *point : mPendingPoints )
+  {
+    //keep inserting the other points, the triangulation is still valid
+    if ( mTriangulation->addPoint( point ) == -100 )
+    {
+      result = -1;
+    }
+  }
+  mPendingPoints.clear();
+  return result;
+}
+
+CloughTocherInterpolator *QgsTINInterpolator::takeCloughTocherInterpolator()
+{
+  QMutexLocker locker( &mFreeInterpolatorsMutex );
+  if ( !mFreeInterpolators.isEmpty() )
+  {
+    return mFreeInterpolators.takeLast();
+  }
+  return new CloughTocherInterpolator( static_cast<NormVecDecorator *>( mTriangulation ) );
+}
+
+void QgsTINInterpolator::releaseCloughTocherInterpolator( CloughTocherInterpolator *interpolator )
+{
+  QMutexLocker locker( &mFreeInterpolatorsMutex );
+  mFreeInterpolators.append( interpolator );
+}
+
 int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputType type )
 {
   if ( !f )
@@ -207,6 +365,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
   //maybe a structure or break line
   Line3D *line = nullptr;
 
+  int result = 0;
   QgsWkbTypes::Type wkbType = g.wkbType();
   switch ( wkbType )
   {
@@ -224,11 +383,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
       {
         z = attributeValue;
       }
-      Point3D *point = new Point3D( x, y, z );
-      if ( mTriangulation->addPoint( point ) == -100 )
-      {
-        return -1;
-      }
+      mPendingPoints << new Point3D( x, y, z );
       break;
     }
     case QgsWkbTypes::MultiPoint25D:
@@ -250,6 +405,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
         {
           z = attributeValue;
         }
+        mPendingPoints << new Point3D( x, y, z );
       }
       break;
     }
@@ -278,8 +434,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
         if ( type == POINTS )
         {
-          //todo: handle error code -100
-          mTriangulation->addPoint( new Point3D( x, y, z ) );
+          mPendingPoints << new Point3D( x, y, z );
         }
         else
         {
@@ -289,6 +444,10 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
       if ( type != POINTS )
       {
+        if ( insertPendingPoints() != 0 )
+        {
+          result = -1;
+        }
         mTriangulation->addLine( line, type == BREAK_LINES );
       }
       break;
@@ -322,8 +481,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
           if ( type == POINTS )
           {
-            //todo: handle error code -100
-            mTriangulation->addPoint( new Point3D( x, y, z ) );
+            mPendingPoints << new Point3D( x, y, z );
           }
           else
           {
@@ -332,6 +490,10 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
         }
         if ( type != POINTS )
         {
+          if ( insertPendingPoints() != 0 )
+          {
+            result = -1;
+          }
           mTriangulation->addLine( line, type == BREAK_LINES );
         }
       }
@@ -366,8 +528,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
           }
           if ( type == POINTS )
           {
-            //todo: handle error code -100
-            mTriangulation->addPoint( new Point3D( x, y, z ) );
+            mPendingPoints << new Point3D( x, y, z );
           }
           else
           {
@@ -377,6 +538,10 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
         if ( type != POINTS )
         {
+          if ( insertPendingPoints() != 0 )
+          {
+            result = -1;
+          }
           mTriangulation->addLine( line, type == BREAK_LINES );
         }
       }
@@ -416,8 +581,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
             }
             if ( type == POINTS )
             {
-              //todo: handle error code -100
-              mTriangulation->addPoint( new Point3D( x, y, z ) );
+              mPendingPoints << new Point3D( x, y, z );
             }
             else
             {
@@ -426,6 +590,10 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
           }
           if ( type != POINTS )
           {
+            if ( insertPendingPoints() != 0 )
+            {
+              result = -1;
+            }
             mTriangulation->addLine( line, type == BREAK_LINES );
           }
         }
@@ -437,6 +605,6 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
       break;
   }
 
-  return 0;
+  return result;
 }
 
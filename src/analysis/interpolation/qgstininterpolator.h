@@ -20,10 +20,14 @@
 
 #include "qgsinterpolator.h"
 #include <QString>
+#include <QVector>
+#include <QMutex>
 #include "qgis_analysis.h"
 
 class Triangulation;
 class TriangleInterpolator;
+class CloughTocherInterpolator;
+class Point3D;
 class QgsFeature;
 
 /** \ingroup analysis
@@ -40,6 +44,11 @@ class ANALYSIS_EXPORT QgsTINInterpolator: public QgsInterpolator
     QgsTINInterpolator( const QList<LayerData> &inputData, TINInterpolation interpolation = Linear, bool showProgressDialog = false );
     ~QgsTINInterpolator();
 
+    //! QgsTINInterpolator cannot be copied
+    QgsTINInterpolator( const QgsTINInterpolator &rh ) = delete;
+    //! QgsTINInterpolator cannot be copied
+    QgsTINInterpolator &operator=( const QgsTINInterpolator &rh ) = delete;
+
     /** Calculates interpolation value for map coordinates x, y
        \param x x-coordinate (in map units)
        \param y y-coordinate (in map units)
@@ -47,6 +56,14 @@ class ANALYSIS_EXPORT QgsTINInterpolator: public QgsInterpolator
        \returns 0 in case of success*/
     int interpolatePoint( double x, double y, double &result ) override;
 
+    /**
+     * Builds the triangulation of the base data.
+     * \returns 0 in case of success
+     */
+    int prepare() override;
+
+    bool supportsConcurrentInterpolation() const override { return true; }
+
     void setExportTriangulationToFile( bool e ) {mExportTriangulationToFile = e;}
     void setTriangulationFilePath( const QString &filepath ) {mTriangulationFilePath = filepath;}
 
@@ -61,16 +78,33 @@ class ANALYSIS_EXPORT QgsTINInterpolator: public QgsInterpolator
     QString mTriangulationFilePath;
     //! Type of interpolation
     TINInterpolation mInterpolation;
+    //! Points read from the features, which are not yet inserted into the triangulation
+    QVector<Point3D *> mPendingPoints;
+    //! Clough-Tocher interpolators not used by a concurrent call to interpolatePoint()
+    QList<CloughTocherInterpolator *> mFreeInterpolators;
+    QMutex mFreeInterpolatorsMutex;
 
     //! Create dual edge triangulation
     void initialize();
 
+    /** Inserts the pending points into the triangulation in biased randomized order, spatially sorted within each round.
+      Called before a line is added, so that points and lines keep the order of the features
+      \returns 0 in case of success, -1 if some points could not be inserted because of numerical problems*/
+    int insertPendingPoints();
+
+    //! Returns a Clough-Tocher interpolator for the exclusive use of the calling thread
+    CloughTocherInterpolator *takeCloughTocherInterpolator();
+
+    //! Makes an interpolator returned by takeCloughTocherInterpolator() available to other calls
+    void releaseCloughTocherInterpolator( CloughTocherInterpolator *interpolator );
+
     /** Inserts the vertices of a feature into the triangulation
       \param f the feature
       \param zCoord true if the z coordinate is the interpolation attribute
       \param attr interpolation attribute index (if zCoord is false)
       \param type point/structure line, break line
-      \returns 0 in case of success, -1 if the feature could not be inserted because of numerical problems*/
+      \returns 0 in case of success, -1 if the feature or previously added points could not be inserted because of numerical problems.
+      Points are only inserted once a line is added or all features have been read (see insertPendingPoints())*/
     int insertData( QgsFeature *f, bool zCoord, int attr, InputType type );
 };
 
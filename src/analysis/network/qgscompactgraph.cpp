@@ -0,0 +1,223 @@
+/***************************************************************************
+  qgscompactgraph.cpp
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include "qgscompactgraph.h"
+#include "qgsgraph.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <cstring>
+
+///@cond PRIVATE
+
+//! Identifies graph snapshot files. Also detects snapshots written on a machine with different byte order.
+static const quint32 SNAPSHOT_MAGIC = 0x51474347; // "QGCG"
+static const quint32 SNAPSHOT_VERSION = 1;
+
+/**
+ * Header of the data block. It is followed by the double arrays (vertex x, vertex y, edge costs
+ * of each strategy) and then the integer arrays, so all arrays are properly aligned.
+ */
+struct SnapshotHeader
+{
+  quint32 magic;
+  quint32 version;
+  qint32 vertexCount;
+  qint32 edgeCount;
+  qint32 strategyCount;
+  qint32 reserved;
+};
+
+static qint64 snapshotSize( qint64 vertexCount, qint64 edgeCount, qint64 strategyCount )
+{
+  return static_cast< qint64 >( sizeof( SnapshotHeader ) )
+         + static_cast< qint64 >( sizeof( double ) ) * ( 2 * vertexCount + strategyCount * edgeCount )
+         + static_cast< qint64 >( sizeof( qint32 ) ) * ( 2 * ( vertexCount + 1 ) + 4 * edgeCount );
+}
+
+///@endcond
+
+QgsCompactGraph::QgsCompactGraph( const QgsGraph *graph )
+{
+  int vertexCount = graph ? graph->vertexCount() : 0;
+  int edgeCount = graph ? graph->edgeCount() : 0;
+  int strategyCount = 0;
+  for ( int i = 0; i < edgeCount; ++i )
+    strategyCount = std::max( strategyCount, graph->edge( i ).strategies().size() );
+
+  qint64 size = snapshotSize( vertexCount, edgeCount, strategyCount );
+  mBuffer.fill( 0.0, static_cast< int >( ( size + sizeof( double ) - 1 ) / sizeof( double ) ) );
+  char *data = reinterpret_cast< char * >( mBuffer.data() );
+
+  SnapshotHeader header;
+  header.magic = SNAPSHOT_MAGIC;
+  header.version = SNAPSHOT_VERSION;
+  header.vertexCount = vertexCount;
+  header.edgeCount = edgeCount;
+  header.strategyCount = strategyCount;
+  header.reserved = 0;
+  memcpy( data, &header, sizeof( SnapshotHeader ) );
+  setupArrays( data, size );
+
+  double *x = const_cast< double * >( mX );
+  double *y = const_cast< double * >( mY );
+  double *costs = const_cast< double * >( mCosts );
+  qint32 *outOffsets = const_cast< qint32 * >( mOutOffsets );
+  qint32 *edgeOut = const_cast< qint32 * >( mEdgeOut );
+  qint32 *edgeIn = const_cast< qint32 * >( mEdgeIn );
+  qint32 *inOffsets = const_cast< qint32 * >( mInOffsets );
+  qint32 *inEdges = const_cast< qint32 * >( mInEdges );
+  qint32 *graphEdges = const_cast< qint32 * >( mGraphEdges );
+
+  for ( int i = 0; i < vertexCount; ++i )
+  {
+    QgsPoint point = graph->vertex( i ).point();
+    x[ i ] = point.x();
+    y[ i ] = point.y();
+  }
+
+  // counting sort of the edges by their outgoing vertex, keeping the order of the graph edges of a vertex
+  for ( int i = 0; i < edgeCount; ++i )
+  {
+    const QgsGraphEdge &edge = graph->edge( i );
+    ++outOffsets[ edge.outVertex() + 1 ];
+    ++inOffsets[ edge.inVertex() + 1 ];
+  }
+  for ( int i = 0; i < vertexCount; ++i )
+  {
+    outOffsets[ i + 1 ] += outOffsets[ i ];
+    inOffsets[ i + 1 ] += inOffsets[ i ];
+  }
+
+  QVector< qint32 > outFill( vertexCount );
+  memcpy( outFill.data(), outOffsets, sizeof( qint32 ) * vertexCount );
+  for ( int i = 0; i < edgeCount; ++i )
+  {
+    const QgsGraphEdge &graphEdge = graph->edge( i );
+    int edgeIdx = outFill[ graphEdge.outVertex()]++;
+    edgeOut[ edgeIdx ] = graphEdge.outVertex();
+    edgeIn[ edgeIdx ] = graphEdge.inVertex();
+    graphEdges[ edgeIdx ] = i;
+
+    const QVector< QVariant > strategies = graphEdge.strategies();
+    for ( int strategy = 0; strategy < strategies.size(); ++strategy )
+    {
+      costs[ static_cast< qint64 >( strategy ) * edgeCount + edgeIdx ] = strategies.at( strategy ).toDouble();
+    }
+  }
+
+  QVector< qint32 > inFill( vertexCount );
+  memcpy( inFill.data(), inOffsets, sizeof( qint32 ) * vertexCount );
+  for ( int edgeIdx = 0; edgeIdx < edgeCount; ++edgeIdx )
+  {
+    inEdges[ inFill[ edgeIn[ edgeIdx ] ]++ ] = edgeIdx;
+  }
+}
+
+QgsCompactGraph::~QgsCompactGraph() = default;
+
+bool QgsCompactGraph::setupArrays( const char *data, qint64 size )
+{
+  if ( size < static_cast< qint64 >( sizeof( SnapshotHeader ) ) )
+    return false;
+
+  SnapshotHeader header;
+  memcpy( &header, data, sizeof( SnapshotHeader ) );
+  if ( header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION
+       || header.vertexCount < 0 || header.edgeCount < 0 || header.strategyCount < 0
+       || size < snapshotSize( header.vertexCount, header.edgeCount, header.strategyCount ) )
+    return false;
+
+  mData = data;
+  mDataSize = snapshotSize( header.vertexCount, header.edgeCount, header.strategyCount );
+  mVertexCount = header.vertexCount;
+  mEdgeCount = header.edgeCount;
+  mStrategyCount = header.strategyCount;
+
+  const double *doubles = reinterpret_cast< const double * >( data + sizeof( SnapshotHeader ) );
+  mX = doubles;
+  mY = mX + mVertexCount;
+  mCosts = mY + mVertexCount;
+
+  const qint32 *ints = reinterpret_cast< const qint32 * >( mCosts + static_cast< qint64 >( mStrategyCount ) * mEdgeCount );
+  mOutOffsets = ints;
+  mEdgeOut = mOutOffsets + mVertexCount + 1;
+  mEdgeIn = mEdgeOut + mEdgeCount;
+  mInOffsets = mEdgeIn + mEdgeCount;
+  mInEdges = mInOffsets + mVertexCount + 1;
+  mGraphEdges = mInEdges + mEdgeCount;
+  return true;
+}
+
+bool QgsCompactGraph::isConsistent() const
+{
+  if ( mOutOffsets[ 0 ] != 0 || mOutOffsets[ mVertexCount ] != mEdgeCount
+       || mInOffsets[ 0 ] != 0 || mInOffsets[ mVertexCount ] != mEdgeCount )
+    return false;
+
+  // once the offsets are known to be increasing from 0 to the edge count, the edge ranges are valid
+  for ( int vertex = 0; vertex < mVertexCount; ++vertex )
+  {
+    if ( mOutOffsets[ vertex ] > mOutOffsets[ vertex + 1 ] || mInOffsets[ vertex ] > mInOffsets[ vertex + 1 ] )
+      return false;
+  }
+
+  for ( int vertex = 0; vertex < mVertexCount; ++vertex )
+  {
+    for ( int edgeIdx = mOutOffsets[ vertex ]; edgeIdx < mOutOffsets[ vertex + 1 ]; ++edgeIdx )
+    {
+      if ( mEdgeOut[ edgeIdx ] != vertex || mEdgeIn[ edgeIdx ] < 0 || mEdgeIn[ edgeIdx ] >= mVertexCount
+           || mGraphEdges[ edgeIdx ] < 0 || mGraphEdges[ edgeIdx ] >= mEdgeCount )
+        return false;
+    }
+    for ( int i = mInOffsets[ vertex ]; i < mInOffsets[ vertex + 1 ]; ++i )
+    {
+      if ( mInEdges[ i ] < 0 || mInEdges[ i ] >= mEdgeCount || mEdgeIn[ mInEdges[ i ] ] != vertex )
+        return false;
+    }
+  }
+  return true;
+}
+
+bool QgsCompactGraph::writeToFile( const QString &fileName ) const
+{
+  QFile file( fileName );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    return false;
+
+  return file.write( mData, mDataSize ) == mDataSize;
+}
+
+QgsCompactGraph *QgsCompactGraph::readFromFile( const QString &fileName )
+{
+  std::unique_ptr< QFile > file( new QFile( fileName ) );
+  if ( !file->open( QIODevice::ReadOnly ) )
+    return nullptr;
+
+  qint64 size = file->size();
+  const uchar *data = size > 0 ? file->map( 0, size ) : nullptr;
+  if ( !data )
+    return nullptr;
+
+  std::unique_ptr< QgsCompactGraph > graph( new QgsCompactGraph() );
+  if ( !graph->setupArrays( reinterpret_cast< const char * >( data ), size ) )
+    return nullptr;
+
+  if ( !graph->isConsistent() )
+    return nullptr;
+
+  graph->mFile = std::move( file );
+  return graph.release();
+}
@@ -0,0 +1,197 @@
+/***************************************************************************
+  qgscompactgraph.h
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSCOMPACTGRAPH_H
+#define QGSCOMPACTGRAPH_H
+
+#include <QVector>
+#include <QString>
+
+#include <memory>
+
+#include "qgis.h"
+#include "qgspoint.h"
+#include "qgis_analysis.h"
+
+class QgsGraph;
+class QFile;
+
+/**
+ * \ingroup analysis
+ * \class QgsCompactGraph
+ * \since QGIS 3.0
+ * \brief Immutable graph stored in compressed sparse row form.
+ *
+ * The edges are sorted by their outgoing vertex, so the outgoing edges of a vertex are the
+ * consecutive edge indices from outEdgesBegin() to outEdgesEnd(). Vertex coordinates and the
+ * edge costs of each strategy are kept in plain arrays of doubles, which needs only a fraction
+ * of the memory of a QgsGraph and keeps the data read by a shortest path search close together.
+ *
+ * A compact graph can be saved as a snapshot with writeToFile(). The snapshot is memory mapped
+ * by readFromFile(), so even very large networks are available almost immediately instead of
+ * being built again from the source layer.
+ *
+ * \note edge indices differ from the indices of the QgsGraph the compact graph was created from,
+ * use graphEdge() to get the index of the original edge.
+ */
+class ANALYSIS_EXPORT QgsCompactGraph
+{
+  public:
+
+    /**
+     * Constructor for QgsCompactGraph, which copies the vertices and edges of \a graph.
+     * All edge costs of the graph are converted to doubles.
+     */
+    explicit QgsCompactGraph( const QgsGraph *graph );
+
+    ~QgsCompactGraph();
+
+    //! QgsCompactGraph cannot be copied
+    QgsCompactGraph( const QgsCompactGraph &rh ) = delete;
+    //! QgsCompactGraph cannot be copied
+    QgsCompactGraph &operator=( const QgsCompactGraph &rh ) = delete;
+
+    /**
+     * Returns the number of graph vertices.
+     */
+    int vertexCount() const { return mVertexCount; }
+
+    /**
+     * Returns the number of graph edges.
+     */
+    int edgeCount() const { return mEdgeCount; }
+
+    /**
+     * Returns the number of edge cost strategies.
+     */
+    int strategyCount() const { return mStrategyCount; }
+
+    /**
+     * Returns the point associated with the vertex at index \a vertexIdx.
+     */
+    QgsPoint vertexPoint( int vertexIdx ) const { return QgsPoint( mX[ vertexIdx ], mY[ vertexIdx ] ); }
+
+    /**
+     * Returns the index of the first outgoing edge of the vertex at index \a vertexIdx.
+     * \see outEdgesEnd()
+     */
+    int outEdgesBegin( int vertexIdx ) const { return mOutOffsets[ vertexIdx ]; }
+
+    /**
+     * Returns the index following the last outgoing edge of the vertex at index \a vertexIdx.
+     * \see outEdgesBegin()
+     */
+    int outEdgesEnd( int vertexIdx ) const { return mOutOffsets[ vertexIdx + 1 ]; }
+
+    /**
+     * Returns the position of the first incoming edge of the vertex at index \a vertexIdx in the list
+     * of incoming edges. The edge indices are returned by inEdge().
+     * \see inEdgesEnd()
+     */
+    int inEdgesBegin( int vertexIdx ) const { return mInOffsets[ vertexIdx ]; }
+
+    /**
+     * Returns the position following the last incoming edge of the vertex at index \a vertexIdx in
+     * the list of incoming edges.
+     * \see inEdgesBegin()
+     */
+    int inEdgesEnd( int vertexIdx ) const { return mInOffsets[ vertexIdx + 1 ]; }
+
+    /**
+     * Returns the index of the edge at position \a position in the list of incoming edges.
+     * \see inEdgesBegin()
+     */
+    int inEdge( int position ) const { return mInEdges[ position ]; }
+
+    /**
+     * Returns the index of the outgoing vertex of the edge at index \a edgeIdx.
+     */
+    int edgeOutVertex( int edgeIdx ) const { return mEdgeOut[ edgeIdx ]; }
+
+    /**
+     * Returns the index of the incoming vertex of the edge at index \a edgeIdx.
+     */
+    int edgeInVertex( int edgeIdx ) const { return mEdgeIn[ edgeIdx ]; }
+
+    /**
+     * Returns the cost of the edge at index \a edgeIdx calculated using the strategy with index \a strategyIdx.
+     */
+    double edgeCost( int edgeIdx, int strategyIdx ) const { return mCosts[ static_cast< qint64 >( strategyIdx ) * mEdgeCount + edgeIdx ]; }
+
+    /**
+     * Returns the index of the edge in the QgsGraph the compact graph was created from.
+     */
+    int graphEdge( int edgeIdx ) const { return mGraphEdges[ edgeIdx ]; }
+
+    /**
+     * Returns the costs of all edges calculated using the strategy with index \a strategyIdx,
+     * indexed by edge.
+     * \note not available in Python bindings
+     */
+    const double *edgeCosts( int strategyIdx ) const SIP_SKIP { return mCosts + static_cast< qint64 >( strategyIdx ) * mEdgeCount; }
+
+    /**
+     * Saves a snapshot of the graph to the file \a fileName.
+     * \returns true if the file was written successfully
+     * \see readFromFile()
+     */
+    bool writeToFile( const QString &fileName ) const;
+
+    /**
+     * Opens a snapshot written by writeToFile(). The file is memory mapped and must not be modified
+     * while the graph exists. All the vertex and edge indices of the snapshot are validated, so that a
+     * corrupted file can not cause out of bounds accesses. Returns nullptr if the file could not be read
+     * or is not a valid snapshot.
+     * \see writeToFile()
+     */
+    static QgsCompactGraph *readFromFile( const QString &fileName ) SIP_FACTORY;
+
+  private:
+
+#ifdef SIP_RUN
+    QgsCompactGraph( const QgsCompactGraph &rh );
+#endif
+
+    QgsCompactGraph() = default;
+
+    //! Points the array pointers into the data block, returns false if the block is too small
+    bool setupArrays( const char *data, qint64 size );
+
+    //! Returns true if all offsets and vertex and edge indices of the arrays are consistent
+    bool isConsistent() const;
+
+    //! Owned data block, for graphs which were not read from a snapshot
+    QVector< double > mBuffer;
+    //! Mapped snapshot file
+    std::unique_ptr< QFile > mFile;
+
+    const char *mData = nullptr;
+    qint64 mDataSize = 0;
+
+    int mVertexCount = 0;
+    int mEdgeCount = 0;
+    int mStrategyCount = 0;
+
+    const double *mX = nullptr;
+    const double *mY = nullptr;
+    const double *mCosts = nullptr;
+    const qint32 *mOutOffsets = nullptr;
+    const qint32 *mEdgeOut = nullptr;
+    const qint32 *mEdgeIn = nullptr;
+    const qint32 *mInOffsets = nullptr;
+    const qint32 *mInEdges = nullptr;
+    const qint32 *mGraphEdges = nullptr;
+};
+
+#endif // QGSCOMPACTGRAPH_H
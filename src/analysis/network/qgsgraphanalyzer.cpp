@@ -14,75 +14,199 @@
 ***************************************************************************/
 
 #include <limits>
+#include <cmath>
 
-#include <QMap>
 #include <QVector>
-#include <QPair>
 
 #include "qgsgraph.h"
+#include "qgscompactgraph.h"
 #include "qgsgraphanalyzer.h"
+#include "qgsgraphheap_p.h"
+#include "qgsnetworkstrategy.h"
 
-void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+///@cond PRIVATE
+
+namespace
 {
-  QVector< double > *result = nullptr;
-  if ( resultCost )
-  {
-    result = resultCost;
-  }
-  else
+  //! Gives the shortest path search access to the edges of a QgsGraph
+  class GraphAccess
   {
-    result = new QVector<double>();
-  }
+    public:
+      GraphAccess( const QgsGraph *graph, int criterionNum )
+        : mGraph( graph )
+        , mCriterionNum( criterionNum )
+      {}
+
+      int vertexCount() const { return mGraph->vertexCount(); }
+      QgsPoint vertexPoint( int vertexIdx ) const { return mGraph->vertex( vertexIdx ).point(); }
+      int edgeOutVertex( int edgeIdx ) const { return mGraph->edge( edgeIdx ).outVertex(); }
+
+      //! Calls \a visit with the index, incoming vertex and cost of each outgoing edge of \a vertexIdx
+      template <typename Visit>
+      void visitOutEdges( int vertexIdx, Visit visit ) const
+      {
+        const QgsGraphEdgeIds &outEdges = mGraph->vertex( vertexIdx ).outEdges();
+        for ( int edgeIdx : outEdges )
+        {
+          const QgsGraphEdge &edge = mGraph->edge( edgeIdx );
+          visit( edgeIdx, edge.inVertex(), edge.cost( mCriterionNum ).toDouble() );
+        }
+      }
 
-  result->clear();
-  result->insert( result->begin(), source->vertexCount(), std::numeric_limits<double>::infinity() );
-  ( *result )[ startPointIdx ] = 0.0;
+    private:
+      const QgsGraph *mGraph = nullptr;
+      int mCriterionNum;
+  };
 
-  if ( resultTree )
+  //! Gives the shortest path search access to the edges of a QgsCompactGraph
+  class CompactGraphAccess
   {
-    resultTree->clear();
-    resultTree->insert( resultTree->begin(), source->vertexCount(), -1 );
-  }
+    public:
+      CompactGraphAccess( const QgsCompactGraph *graph, int criterionNum )
+        : mGraph( graph )
+        , mCosts( graph->edgeCosts( criterionNum ) )
+      {}
+
+      int vertexCount() const { return mGraph->vertexCount(); }
+      QgsPoint vertexPoint( int vertexIdx ) const { return mGraph->vertexPoint( vertexIdx ); }
+      int edgeOutVertex( int edgeIdx ) const { return mGraph->edgeOutVertex( edgeIdx ); }
+
+      template <typename Visit>
+      void visitOutEdges( int vertexIdx, Visit visit ) const
+      {
+        for ( int edgeIdx = mGraph->outEdgesBegin( vertexIdx ); edgeIdx < mGraph->outEdgesEnd( vertexIdx ); ++edgeIdx )
+        {
+          visit( edgeIdx, mGraph->edgeInVertex( edgeIdx ), mCosts[ edgeIdx ] );
+        }
+      }
 
-  // QMultiMap< cost, vertexIdx > not_begin
-  // I use it and don't create any struct or class
-  QMultiMap< double, int > not_begin;
-  QMultiMap< double, int >::iterator it;
+    private:
+      const QgsCompactGraph *mGraph = nullptr;
+      const double *mCosts = nullptr;
+  };
 
-  not_begin.insert( 0.0, startPointIdx );
+}
+
+/**
+ * Shortest path search from \a startVertexIdx. If \a endVertexIdx is -1 the search builds the complete
+ * shortest path tree, otherwise it stops once the end vertex is settled. \a estimate returns a lower bound
+ * of the remaining cost from a vertex to the end vertex (A* search), or 0 for Dijkstra's algorithm.
+ */
+template <typename Graph, typename Estimate>
+static void shortestPathSearch( const Graph &source, int startVertexIdx, int endVertexIdx,
+                                QVector<double> &resultCost, QVector<int> &resultTree, Estimate estimate )
+{
+  resultCost.fill( std::numeric_limits<double>::infinity(), source.vertexCount() );
+  resultTree.fill( -1, source.vertexCount() );
+  resultCost[ startVertexIdx ] = 0.0;
+
+  QgsGraphVertexHeap heap( source.vertexCount() );
+  heap.push( startVertexIdx, estimate( startVertexIdx ) );
 
-  while ( !not_begin.empty() )
+  while ( !heap.isEmpty() )
   {
-    it = not_begin.begin();
-    double curCost = it.key();
-    int curVertex = it.value();
-    not_begin.erase( it );
-
-    // edge index list
-    QgsGraphEdgeIds l = source->vertex( curVertex ).outEdges();
-    QgsGraphEdgeIds::iterator arcIt;
-    for ( arcIt = l.begin(); arcIt != l.end(); ++arcIt )
-    {
-      const QgsGraphEdge arc = source->edge( *arcIt );
-      double cost = arc.cost( criterionNum ).toDouble() + curCost;
+    int curVertex = heap.pop();
+    if ( curVertex == endVertexIdx )
+      break;
 
-      if ( cost < ( *result )[ arc.inVertex()] )
+    double curCost = resultCost.at( curVertex );
+    source.visitOutEdges( curVertex, [&]( int edgeIdx, int inVertex, double edgeCost )
+    {
+      double cost = edgeCost + curCost;
+      if ( cost < resultCost.at( inVertex ) )
       {
-        ( *result )[ arc.inVertex()] = cost;
-        if ( resultTree )
-        {
-          ( *resultTree )[ arc.inVertex()] = *arcIt;
-        }
-        not_begin.insert( cost, arc.inVertex() );
+        resultCost[ inVertex ] = cost;
+        resultTree[ inVertex ] = edgeIdx;
+        heap.push( inVertex, cost + estimate( inVertex ) );
       }
-    }
+    } );
   }
-  if ( !resultCost )
+}
+
+//! Collects the edges leading from the root of a shortest path tree to \a endVertexIdx
+template <typename Graph>
+static void pathFromTree( const Graph &source, const QVector<int> &tree, int endVertexIdx, QVector<int> &path )
+{
+  path.clear();
+  int edgeIdx = tree.at( endVertexIdx );
+  while ( edgeIdx != -1 )
   {
-    delete result;
+    path.prepend( edgeIdx );
+    edgeIdx = tree.at( source.edgeOutVertex( edgeIdx ) );
   }
 }
 
+template <typename Graph>
+static double pointToPointSearch( const Graph &source, int startVertexIdx, int endVertexIdx, QVector<int> *resultPath )
+{
+  QVector< double > cost;
+  QVector< int > tree;
+  shortestPathSearch( source, startVertexIdx, endVertexIdx, cost, tree, []( int ) { return 0.0; } );
+
+  if ( resultPath )
+    pathFromTree( source, tree, endVertexIdx, *resultPath );
+  return cost.at( endVertexIdx );
+}
+
+template <typename Graph>
+static double aStarSearch( const Graph &source, int startVertexIdx, int endVertexIdx, const QgsNetworkStrategy *strategy, QVector<int> *resultPath )
+{
+  double costPerDistance = strategy ? strategy->minimumCostPerDistance() : 0.0;
+  QgsPoint endPoint = source.vertexPoint( endVertexIdx );
+
+  QVector< double > cost;
+  QVector< int > tree;
+  shortestPathSearch( source, startVertexIdx, endVertexIdx, cost, tree,
+                      [&source, &endPoint, costPerDistance]( int vertexIdx )
+  {
+    return costPerDistance * std::sqrt( source.vertexPoint( vertexIdx ).sqrDist( endPoint ) );
+  } );
+
+  if ( resultPath )
+    pathFromTree( source, tree, endVertexIdx, *resultPath );
+  return cost.at( endVertexIdx );
+}
+
+///@endcond
+
+void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  QVector< double > cost;
+  QVector< int > tree;
+  shortestPathSearch( GraphAccess( source, criterionNum ), startPointIdx, -1, resultCost ? *resultCost : cost,
+                      resultTree ? *resultTree : tree, []( int ) { return 0.0; } );
+}
+
+void QgsGraphAnalyzer::dijkstra( const QgsCompactGraph *source, int startVertexIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  QVector< double > cost;
+  QVector< int > tree;
+  shortestPathSearch( CompactGraphAccess( source, criterionNum ), startVertexIdx, -1, resultCost ? *resultCost : cost,
+                      resultTree ? *resultTree : tree, []( int ) { return 0.0; } );
+}
+
+double QgsGraphAnalyzer::shortestPath( const QgsGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum, QVector<int> *resultPath )
+{
+  return pointToPointSearch( GraphAccess( source, criterionNum ), startVertexIdx, endVertexIdx, resultPath );
+}
+
+double QgsGraphAnalyzer::shortestPath( const QgsCompactGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum, QVector<int> *resultPath )
+{
+  return pointToPointSearch( CompactGraphAccess( source, criterionNum ), startVertexIdx, endVertexIdx, resultPath );
+}
+
+double QgsGraphAnalyzer::aStar( const QgsGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum,
+                                const QgsNetworkStrategy *strategy, QVector<int> *resultPath )
+{
+  return aStarSearch( GraphAccess( source, criterionNum ), startVertexIdx, endVertexIdx, strategy, resultPath );
+}
+
+double QgsGraphAnalyzer::aStar( const QgsCompactGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum,
+                                const QgsNetworkStrategy *strategy, QVector<int> *resultPath )
+{
+  return aStarSearch( CompactGraphAccess( source, criterionNum ), startVertexIdx, endVertexIdx, strategy, resultPath );
+}
+
 QgsGraph *QgsGraphAnalyzer::shortestTree( const QgsGraph *source, int startVertexIdx, int criterionNum )
 {
   QgsGraph *treeResult = new QgsGraph();
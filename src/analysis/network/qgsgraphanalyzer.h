@@ -22,10 +22,13 @@
 #include "qgis_analysis.h"
 
 class QgsGraph;
+class QgsCompactGraph;
+class QgsNetworkStrategy;
 
 /** \ingroup analysis
  *  This class performs graph analysis, e.g. calculates shortest path between two
  * points using different strategies with Dijkstra algorithm
+ * \see QgsGraphContractionHierarchy for repeated queries on the same graph
  */
 
 class ANALYSIS_EXPORT QgsGraphAnalyzer
@@ -73,6 +76,18 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
     % End
 #endif
 
+    /**
+     * Solve shortest path problem on a compact graph using Dijkstra algorithm.
+     * \param source source graph
+     * \param startVertexIdx index of the start vertex
+     * \param criterionNum index of the optimization strategy
+     * \param resultTree array that represents shortest path tree. resultTree[ vertexIndex ] == inboundingArcIndex if vertex reachable, otherwise resultTree[ vertexIndex ] == -1
+     * \param resultCost array of the paths costs
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    static void dijkstra( const QgsCompactGraph *source, int startVertexIdx, int criterionNum, QVector<int> *resultTree = nullptr, QVector<double> *resultCost = nullptr ) SIP_SKIP;
+
     /**
      * Returns shortest path tree with root-node in startVertexIdx
      * \param source source graph
@@ -80,6 +95,67 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
      * \param criterionNum index of the optimization strategy
      */
     static QgsGraph *shortestTree( const QgsGraph *source, int startVertexIdx, int criterionNum );
+
+    /**
+     * Solves the shortest path problem between two vertices using Dijkstra algorithm. Unlike dijkstra(),
+     * the search stops as soon as the end vertex is reached.
+     * \param source source graph
+     * \param startVertexIdx index of the start vertex
+     * \param endVertexIdx index of the end vertex
+     * \param criterionNum index of the optimization strategy
+     * \param resultPath indices of the edges of the path, from the start vertex to the end vertex
+     * \returns cost of the path, or infinity if the end vertex is not reachable
+     * \since QGIS 3.0
+     */
+    static double shortestPath( const QgsGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum, QVector<int> *resultPath SIP_OUT = nullptr );
+
+    /**
+     * Solves the shortest path problem between two vertices of a compact graph using Dijkstra algorithm.
+     * The search stops as soon as the end vertex is reached.
+     * \param source source graph
+     * \param startVertexIdx index of the start vertex
+     * \param endVertexIdx index of the end vertex
+     * \param criterionNum index of the optimization strategy
+     * \param resultPath indices of the edges of the path, from the start vertex to the end vertex
+     * \returns cost of the path, or infinity if the end vertex is not reachable
+     * \since QGIS 3.0
+     */
+    static double shortestPath( const QgsCompactGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum, QVector<int> *resultPath SIP_OUT = nullptr );
+
+    /**
+     * Solves the shortest path problem between two vertices using A* search. The remaining cost to
+     * the end vertex is estimated as the straight line distance between the vertices' points
+     * multiplied by QgsNetworkStrategy::minimumCostPerDistance() of \a strategy, which
+     * directs the search towards the end vertex and visits far fewer vertices than shortestPath().
+     * \param source source graph
+     * \param startVertexIdx index of the start vertex
+     * \param endVertexIdx index of the end vertex
+     * \param criterionNum index of the optimization strategy
+     * \param strategy the strategy which calculated the costs for \a criterionNum
+     * \param resultPath indices of the edges of the path, from the start vertex to the end vertex
+     * \returns cost of the path, or infinity if the end vertex is not reachable
+     * \note the estimate is only a lower bound if minimumCostPerDistance() is not larger than the cost per unit
+     * of distance in the graph's coordinates of any edge, otherwise the result may not be the shortest path.
+     * QgsNetworkDistanceStrategy returns 0 unless a bound is set with setMinimumCostPerDistance()
+     * \since QGIS 3.0
+     */
+    static double aStar( const QgsGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum,
+                         const QgsNetworkStrategy *strategy, QVector<int> *resultPath SIP_OUT = nullptr );
+
+    /**
+     * Solves the shortest path problem between two vertices of a compact graph using A* search.
+     * \param source source graph
+     * \param startVertexIdx index of the start vertex
+     * \param endVertexIdx index of the end vertex
+     * \param criterionNum index of the optimization strategy
+     * \param strategy the strategy which calculated the costs for \a criterionNum
+     * \param resultPath indices of the edges of the path, from the start vertex to the end vertex
+     * \returns cost of the path, or infinity if the end vertex is not reachable
+     * \see aStar() for a QgsGraph
+     * \since QGIS 3.0
+     */
+    static double aStar( const QgsCompactGraph *source, int startVertexIdx, int endVertexIdx, int criterionNum,
+                         const QgsNetworkStrategy *strategy, QVector<int> *resultPath SIP_OUT = nullptr );
 };
 
 #endif // QGSGRAPHANALYZER_H
@@ -0,0 +1,533 @@
+/***************************************************************************
+  qgsgraphcontractionhierarchy.cpp
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include "qgsgraphcontractionhierarchy.h"
+#include "qgsgraph.h"
+#include "qgscompactgraph.h"
+#include "qgsgraphheap_p.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QPair>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//! Identifies contraction hierarchy files
+static const quint32 CH_FILE_MAGIC = 0x51474348; // "QGCH"
+static const quint32 CH_FILE_VERSION = 1;
+
+//! Maximum number of vertices settled by a witness search before giving up (and adding the shortcut)
+static const int CH_WITNESS_SETTLED_LIMIT = 500;
+
+///@cond PRIVATE
+
+class QgsGraphContractionHierarchy::Builder
+{
+  public:
+    Builder( QgsGraphContractionHierarchy &hierarchy, int vertexCount );
+
+    //! Adds an edge of the graph
+    void addGraphEdge( int graphEdgeIdx, int outVertex, int inVertex, double cost );
+
+    void contractAll();
+
+  private:
+
+    //! Contracts \a vertex, or only counts the required shortcuts if \a simulate is true
+    int contract( int vertex, bool simulate );
+
+    //! Calculates the contraction priority of \a vertex, lower values are contracted first
+    double priority( int vertex );
+
+    //! Searches the paths from \a source which do not pass \a excluded and cost at most \a maxCost
+    void witnessSearch( int source, int excluded, double maxCost );
+
+    void addEdge( const Edge &edge );
+
+    QgsGraphContractionHierarchy &mHierarchy;
+    QVector< Edge > &mEdges;
+    QVector< QVector< int > > mOutEdges;
+    QVector< QVector< int > > mInEdges;
+    QVector< bool > mContracted;
+    QVector< int > mContractedNeighbors;
+    QHash< QPair< int, int >, int > mGraphEdgeIndex;
+
+    QgsGraphVertexHeap mWitnessHeap;
+    QVector< double > mWitnessCost;
+    QVector< int > mWitnessTouched;
+};
+
+QgsGraphContractionHierarchy::Builder::Builder( QgsGraphContractionHierarchy &hierarchy, int vertexCount )
+  : mHierarchy( hierarchy )
+  , mEdges( hierarchy.mEdges )
+  , mOutEdges( vertexCount )
+  , mInEdges( vertexCount )
+  , mContracted( vertexCount, false )
+  , mContractedNeighbors( vertexCount, 0 )
+  , mWitnessHeap( vertexCount )
+  , mWitnessCost( vertexCount, std::numeric_limits<double>::infinity() )
+{
+}
+
+void QgsGraphContractionHierarchy::Builder::addGraphEdge( int graphEdgeIdx, int outVertex, int inVertex, double cost )
+{
+  if ( outVertex == inVertex )
+    return;
+
+  // only the cheapest of parallel edges can be part of a shortest path
+  QPair< int, int > key( outVertex, inVertex );
+  auto it = mGraphEdgeIndex.constFind( key );
+  if ( it != mGraphEdgeIndex.constEnd() )
+  {
+    Edge &existing = mEdges[ it.value()];
+    if ( cost < existing.cost )
+    {
+      existing.cost = cost;
+      existing.graphEdge = graphEdgeIdx;
+    }
+    return;
+  }
+
+  Edge edge;
+  edge.from = outVertex;
+  edge.to = inVertex;
+  edge.cost = cost;
+  edge.graphEdge = graphEdgeIdx;
+  edge.firstChild = -1;
+  edge.secondChild = -1;
+  mGraphEdgeIndex.insert( key, mEdges.size() );
+  addEdge( edge );
+}
+
+void QgsGraphContractionHierarchy::Builder::addEdge( const Edge &edge )
+{
+  mOutEdges[ edge.from ].append( mEdges.size() );
+  mInEdges[ edge.to ].append( mEdges.size() );
+  mEdges.append( edge );
+}
+
+void QgsGraphContractionHierarchy::Builder::witnessSearch( int source, int excluded, double maxCost )
+{
+  for ( int vertex : mWitnessTouched )
+    mWitnessCost[ vertex ] = std::numeric_limits<double>::infinity();
+  mWitnessTouched.clear();
+  mWitnessHeap.clear();
+
+  mWitnessCost[ source ] = 0.0;
+  mWitnessTouched.append( source );
+  mWitnessHeap.push( source, 0.0 );
+
+  int settled = 0;
+  while ( !mWitnessHeap.isEmpty() && mWitnessHeap.topKey() <= maxCost && settled < CH_WITNESS_SETTLED_LIMIT )
+  {
+    int vertex = mWitnessHeap.pop();
+    ++settled;
+    double vertexCost = mWitnessCost.at( vertex );
+    for ( int edgeIdx : mOutEdges.at( vertex ) )
+    {
+      const Edge &edge = mEdges.at( edgeIdx );
+      if ( edge.to == excluded || mContracted.at( edge.to ) )
+        continue;
+
+      double cost = vertexCost + edge.cost;
+      if ( cost < mWitnessCost.at( edge.to ) )
+      {
+        if ( std::isinf( mWitnessCost.at( edge.to ) ) )
+          mWitnessTouched.append( edge.to );
+        mWitnessCost[ edge.to ] = cost;
+        mWitnessHeap.push( edge.to, cost );
+      }
+    }
+  }
+}
+
+int QgsGraphContractionHierarchy::Builder::contract( int vertex, bool simulate )
+{
+  int shortcuts = 0;
+
+  // the edge lists may grow while adding shortcuts, so work on copies
+  const QVector< int > inEdges = mInEdges.at( vertex );
+  const QVector< int > outEdges = mOutEdges.at( vertex );
+  for ( int inEdgeIdx : inEdges )
+  {
+    int source = mEdges.at( inEdgeIdx ).from;
+    if ( mContracted.at( source ) )
+      continue;
+
+    double inCost = mEdges.at( inEdgeIdx ).cost;
+    double maxCost = -1;
+    for ( int outEdgeIdx : outEdges )
+    {
+      const Edge &outEdge = mEdges.at( outEdgeIdx );
+      if ( mContracted.at( outEdge.to ) || outEdge.to == source )
+        continue;
+      maxCost = std::max( maxCost, inCost + outEdge.cost );
+    }
+    if ( maxCost < 0 )
+      continue;
+
+    witnessSearch( source, vertex, maxCost );
+
+    for ( int outEdgeIdx : outEdges )
+    {
+      const Edge outEdge = mEdges.at( outEdgeIdx );
+      if ( mContracted.at( outEdge.to ) || outEdge.to == source )
+        continue;
+
+      double viaCost = inCost + outEdge.cost;
+      if ( mWitnessCost.at( outEdge.to ) <= viaCost )
+        continue;
+
+      ++shortcuts;
+      if ( !simulate )
+      {
+        Edge shortcut;
+        shortcut.from = source;
+        shortcut.to = outEdge.to;
+        shortcut.cost = viaCost;
+        shortcut.graphEdge = -1;
+        shortcut.firstChild = inEdgeIdx;
+        shortcut.secondChild = outEdgeIdx;
+        addEdge( shortcut );
+      }
+    }
+  }
+  return shortcuts;
+}
+
+double QgsGraphContractionHierarchy::Builder::priority( int vertex )
+{
+  int removedEdges = 0;
+  for ( int edgeIdx : mInEdges.at( vertex ) )
+  {
+    if ( !mContracted.at( mEdges.at( edgeIdx ).from ) )
+      ++removedEdges;
+  }
+  for ( int edgeIdx : mOutEdges.at( vertex ) )
+  {
+    if ( !mContracted.at( mEdges.at( edgeIdx ).to ) )
+      ++removedEdges;
+  }
+
+  // edge difference, plus a term spreading the contraction uniformly over the graph
+  return contract( vertex, true ) - removedEdges + mContractedNeighbors.at( vertex );
+}
+
+void QgsGraphContractionHierarchy::Builder::contractAll()
+{
+  int vertexCount = mContracted.size();
+  QgsGraphVertexHeap queue( vertexCount );
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+    queue.push( vertex, priority( vertex ) );
+
+  int rank = 0;
+  while ( !queue.isEmpty() )
+  {
+    int vertex = queue.pop();
+
+    // priorities are updated lazily, the vertex is only contracted if it is still the least important one
+    double currentPriority = priority( vertex );
+    if ( !queue.isEmpty() && currentPriority > queue.topKey() )
+    {
+      queue.push( vertex, currentPriority );
+      continue;
+    }
+
+    contract( vertex, false );
+    mContracted[ vertex ] = true;
+    mHierarchy.mRank[ vertex ] = rank++;
+
+    QVector< int > neighbors;
+    for ( int edgeIdx : mInEdges.at( vertex ) )
+      neighbors << mEdges.at( edgeIdx ).from;
+    for ( int edgeIdx : mOutEdges.at( vertex ) )
+      neighbors << mEdges.at( edgeIdx ).to;
+    for ( int neighbor : neighbors )
+    {
+      if ( mContracted.at( neighbor ) )
+        continue;
+      ++mContractedNeighbors[ neighbor ];
+      queue.push( neighbor, priority( neighbor ) );
+    }
+  }
+}
+
+///@endcond
+
+QgsGraphContractionHierarchy::QgsGraphContractionHierarchy( const QgsGraph *graph, int criterionNum )
+{
+  if ( !graph )
+    return;
+
+  mGraphEdgeCount = graph->edgeCount();
+  mRank.fill( 0, graph->vertexCount() );
+
+  Builder builder( *this, graph->vertexCount() );
+  for ( int i = 0; i < graph->edgeCount(); ++i )
+  {
+    const QgsGraphEdge &edge = graph->edge( i );
+    builder.addGraphEdge( i, edge.outVertex(), edge.inVertex(), edge.cost( criterionNum ).toDouble() );
+  }
+  builder.contractAll();
+
+  buildSearchGraph();
+  mValid = true;
+}
+
+QgsGraphContractionHierarchy::QgsGraphContractionHierarchy( const QgsCompactGraph *graph, int criterionNum )
+{
+  if ( !graph )
+    return;
+
+  mGraphEdgeCount = graph->edgeCount();
+  mRank.fill( 0, graph->vertexCount() );
+
+  Builder builder( *this, graph->vertexCount() );
+  const double *costs = graph->edgeCosts( criterionNum );
+  for ( int i = 0; i < graph->edgeCount(); ++i )
+  {
+    builder.addGraphEdge( i, graph->edgeOutVertex( i ), graph->edgeInVertex( i ), costs[ i ] );
+  }
+  builder.contractAll();
+
+  buildSearchGraph();
+  mValid = true;
+}
+
+bool QgsGraphContractionHierarchy::isCompatible( const QgsGraph *graph ) const
+{
+  return mValid && graph && graph->vertexCount() == mRank.size() && graph->edgeCount() == mGraphEdgeCount;
+}
+
+bool QgsGraphContractionHierarchy::isCompatible( const QgsCompactGraph *graph ) const
+{
+  return mValid && graph && graph->vertexCount() == mRank.size() && graph->edgeCount() == mGraphEdgeCount;
+}
+
+int QgsGraphContractionHierarchy::shortcutCount() const
+{
+  int count = 0;
+  for ( const Edge &edge : mEdges )
+  {
+    if ( edge.graphEdge < 0 )
+      ++count;
+  }
+  return count;
+}
+
+void QgsGraphContractionHierarchy::buildSearchGraph()
+{
+  int vertexCount = mRank.size();
+  mUpOffsets.fill( 0, vertexCount + 1 );
+  mDownOffsets.fill( 0, vertexCount + 1 );
+  for ( const Edge &edge : mEdges )
+  {
+    if ( mRank.at( edge.from ) < mRank.at( edge.to ) )
+      ++mUpOffsets[ edge.from + 1 ];
+    else
+      ++mDownOffsets[ edge.to + 1 ];
+  }
+  for ( int i = 0; i < vertexCount; ++i )
+  {
+    mUpOffsets[ i + 1 ] += mUpOffsets.at( i );
+    mDownOffsets[ i + 1 ] += mDownOffsets.at( i );
+  }
+
+  mUpEdges.resize( mUpOffsets.at( vertexCount ) );
+  mDownEdges.resize( mDownOffsets.at( vertexCount ) );
+  QVector< int > upFill = mUpOffsets;
+  QVector< int > downFill = mDownOffsets;
+  for ( int i = 0; i < mEdges.size(); ++i )
+  {
+    const Edge &edge = mEdges.at( i );
+    if ( mRank.at( edge.from ) < mRank.at( edge.to ) )
+      mUpEdges[ upFill[ edge.from ]++ ] = i;
+    else
+      mDownEdges[ downFill[ edge.to ]++ ] = i;
+  }
+}
+
+double QgsGraphContractionHierarchy::shortestPath( int startVertexIdx, int endVertexIdx, QVector<int> *resultPath ) const
+{
+  if ( resultPath )
+    resultPath->clear();
+
+  const double infinity = std::numeric_limits<double>::infinity();
+  int vertexCount = mRank.size();
+  if ( !mValid || startVertexIdx < 0 || startVertexIdx >= vertexCount || endVertexIdx < 0 || endVertexIdx >= vertexCount )
+    return infinity;
+  if ( startVertexIdx == endVertexIdx )
+    return 0.0;
+
+  // bidirectional search, both directions only follow edges towards vertices of higher rank
+  QVector< double > forwardCost( vertexCount, infinity );
+  QVector< double > backwardCost( vertexCount, infinity );
+  QVector< int > forwardEdge( vertexCount, -1 );
+  QVector< int > backwardEdge( vertexCount, -1 );
+  QgsGraphVertexHeap forwardQueue( vertexCount );
+  QgsGraphVertexHeap backwardQueue( vertexCount );
+
+  forwardCost[ startVertexIdx ] = 0.0;
+  forwardQueue.push( startVertexIdx, 0.0 );
+  backwardCost[ endVertexIdx ] = 0.0;
+  backwardQueue.push( endVertexIdx, 0.0 );
+
+  double bestCost = infinity;
+  int meetingVertex = -1;
+  while ( !forwardQueue.isEmpty() || !backwardQueue.isEmpty() )
+  {
+    double forwardMin = forwardQueue.isEmpty() ? infinity : forwardQueue.topKey();
+    double backwardMin = backwardQueue.isEmpty() ? infinity : backwardQueue.topKey();
+    if ( std::min( forwardMin, backwardMin ) >= bestCost )
+      break;
+
+    bool forward = forwardMin <= backwardMin;
+    QgsGraphVertexHeap &queue = forward ? forwardQueue : backwardQueue;
+    QVector< double > &cost = forward ? forwardCost : backwardCost;
+    QVector< int > &treeEdge = forward ? forwardEdge : backwardEdge;
+    const QVector< double > &otherCost = forward ? backwardCost : forwardCost;
+    const QVector< int > &offsets = forward ? mUpOffsets : mDownOffsets;
+    const QVector< int > &edges = forward ? mUpEdges : mDownEdges;
+
+    int vertex = queue.pop();
+    double vertexCost = cost.at( vertex );
+    if ( vertexCost + otherCost.at( vertex ) < bestCost )
+    {
+      bestCost = vertexCost + otherCost.at( vertex );
+      meetingVertex = vertex;
+    }
+
+    for ( int i = offsets.at( vertex ); i < offsets.at( vertex + 1 ); ++i )
+    {
+      int edgeIdx = edges.at( i );
+      const Edge &edge = mEdges.at( edgeIdx );
+      int next = forward ? edge.to : edge.from;
+      double nextCost = vertexCost + edge.cost;
+      if ( nextCost < cost.at( next ) )
+      {
+        cost[ next ] = nextCost;
+        treeEdge[ next ] = edgeIdx;
+        queue.push( next, nextCost );
+      }
+    }
+  }
+
+  if ( resultPath && meetingVertex != -1 )
+  {
+    QVector< int > forwardPath;
+    for ( int vertex = meetingVertex; forwardEdge.at( vertex ) != -1; vertex = mEdges.at( forwardEdge.at( vertex ) ).from )
+      forwardPath.prepend( forwardEdge.at( vertex ) );
+    for ( int edgeIdx : forwardPath )
+      unpackEdge( edgeIdx, *resultPath );
+    for ( int vertex = meetingVertex; backwardEdge.at( vertex ) != -1; vertex = mEdges.at( backwardEdge.at( vertex ) ).to )
+      unpackEdge( backwardEdge.at( vertex ), *resultPath );
+  }
+
+  return bestCost;
+}
+
+void QgsGraphContractionHierarchy::unpackEdge( int edgeIdx, QVector<int> &path ) const
+{
+  // shortcuts may be nested deeply, so avoid recursion
+  QVector< int > stack;
+  stack << edgeIdx;
+  while ( !stack.isEmpty() )
+  {
+    const Edge &edge = mEdges.at( stack.takeLast() );
+    if ( edge.graphEdge >= 0 )
+    {
+      path << edge.graphEdge;
+    }
+    else
+    {
+      stack << edge.secondChild << edge.firstChild;
+    }
+  }
+}
+
+bool QgsGraphContractionHierarchy::writeToFile( const QString &fileName ) const
+{
+  if ( !mValid )
+    return false;
+
+  QFile file( fileName );
+  if ( !file.open( QIODevice::WriteOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  stream << CH_FILE_MAGIC << CH_FILE_VERSION;
+  stream << static_cast< qint32 >( mGraphEdgeCount ) << mRank;
+  stream << static_cast< qint32 >( mEdges.size() );
+  for ( const Edge &edge : mEdges )
+  {
+    stream << static_cast< qint32 >( edge.from ) << static_cast< qint32 >( edge.to ) << edge.cost
+           << static_cast< qint32 >( edge.graphEdge ) << static_cast< qint32 >( edge.firstChild ) << static_cast< qint32 >( edge.secondChild );
+  }
+  return stream.status() == QDataStream::Ok;
+}
+
+bool QgsGraphContractionHierarchy::readFromFile( const QString &fileName )
+{
+  mValid = false;
+
+  QFile file( fileName );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  quint32 magic = 0;
+  quint32 version = 0;
+  stream >> magic >> version;
+  if ( magic != CH_FILE_MAGIC || version != CH_FILE_VERSION )
+    return false;
+
+  qint32 graphEdgeCount = 0;
+  qint32 edgeCount = 0;
+  stream >> graphEdgeCount >> mRank >> edgeCount;
+  if ( stream.status() != QDataStream::Ok || edgeCount < 0 )
+    return false;
+
+  int vertexCount = mRank.size();
+  mEdges.clear();
+  mEdges.reserve( edgeCount );
+  for ( int i = 0; i < edgeCount; ++i )
+  {
+    qint32 from, to, graphEdge, firstChild, secondChild;
+    Edge edge;
+    stream >> from >> to >> edge.cost >> graphEdge >> firstChild >> secondChild;
+    if ( stream.status() != QDataStream::Ok || from < 0 || from >= vertexCount || to < 0 || to >= vertexCount
+         || graphEdge >= graphEdgeCount || firstChild >= i || secondChild >= i || ( graphEdge < 0 && ( firstChild < 0 || secondChild < 0 ) ) )
+    {
+      mEdges.clear();
+      mRank.clear();
+      return false;
+    }
+    edge.from = from;
+    edge.to = to;
+    edge.graphEdge = graphEdge;
+    edge.firstChild = firstChild;
+    edge.secondChild = secondChild;
+    mEdges << edge;
+  }
+
+  mGraphEdgeCount = graphEdgeCount;
+  buildSearchGraph();
+  mValid = true;
+  return true;
+}
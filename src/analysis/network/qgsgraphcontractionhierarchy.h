@@ -0,0 +1,151 @@
+/***************************************************************************
+  qgsgraphcontractionhierarchy.h
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSGRAPHCONTRACTIONHIERARCHY_H
+#define QGSGRAPHCONTRACTIONHIERARCHY_H
+
+#include <QVector>
+#include <QString>
+
+#include "qgis.h"
+#include "qgis_analysis.h"
+
+class QgsGraph;
+class QgsCompactGraph;
+
+/**
+ * \ingroup analysis
+ * \class QgsGraphContractionHierarchy
+ * \since QGIS 3.0
+ * \brief Preprocessed representation of a graph for fast repeated shortest path queries.
+ *
+ * Building the hierarchy contracts the vertices of the graph one after another, adding shortcut
+ * edges which preserve the shortest path costs between the remaining vertices. A query then only
+ * needs two small searches from the start and the end vertex towards the more important vertices,
+ * which is orders of magnitude faster than QgsGraphAnalyzer::shortestPath() on large road networks.
+ *
+ * As building the hierarchy is expensive, it can be saved to a file with writeToFile() and
+ * restored later with readFromFile(), as long as the graph is built again from the same data.
+ */
+class ANALYSIS_EXPORT QgsGraphContractionHierarchy
+{
+  public:
+
+    /**
+     * Constructor for an invalid QgsGraphContractionHierarchy. Use readFromFile() to restore a saved hierarchy.
+     */
+    QgsGraphContractionHierarchy() = default;
+
+    /**
+     * Constructor for QgsGraphContractionHierarchy, which preprocesses \a graph for the costs
+     * of the optimization strategy with index \a criterionNum.
+     */
+    QgsGraphContractionHierarchy( const QgsGraph *graph, int criterionNum );
+
+    /**
+     * Constructor for QgsGraphContractionHierarchy, which preprocesses the compact \a graph for the costs
+     * of the optimization strategy with index \a criterionNum. The paths returned by shortestPath()
+     * consist of edge indices of the compact graph.
+     */
+    QgsGraphContractionHierarchy( const QgsCompactGraph *graph, int criterionNum );
+
+    /**
+     * Returns true if the hierarchy has been built or read successfully.
+     */
+    bool isValid() const { return mValid; }
+
+    /**
+     * Returns true if the hierarchy may be used for \a graph, i.e. the graph has the same number
+     * of vertices and edges as the graph the hierarchy was built from.
+     */
+    bool isCompatible( const QgsGraph *graph ) const;
+
+    /**
+     * Returns true if the hierarchy may be used for the compact \a graph, i.e. the graph has the same number
+     * of vertices and edges as the graph the hierarchy was built from.
+     */
+    bool isCompatible( const QgsCompactGraph *graph ) const;
+
+    /**
+     * Returns the number of vertices of the graph.
+     */
+    int vertexCount() const { return mRank.size(); }
+
+    /**
+     * Returns the number of shortcut edges added by the preprocessing.
+     */
+    int shortcutCount() const;
+
+    /**
+     * Calculates the shortest path between two vertices.
+     * \param startVertexIdx index of the start vertex in the graph
+     * \param endVertexIdx index of the end vertex in the graph
+     * \param resultPath indices of the graph edges of the path, from the start vertex to the end vertex
+     * \returns cost of the path, or infinity if the end vertex is not reachable
+     */
+    double shortestPath( int startVertexIdx, int endVertexIdx, QVector<int> *resultPath SIP_OUT = nullptr ) const;
+
+    /**
+     * Saves the hierarchy to the file \a fileName.
+     * \returns true if the file was written successfully
+     * \see readFromFile()
+     */
+    bool writeToFile( const QString &fileName ) const;
+
+    /**
+     * Restores a hierarchy previously saved with writeToFile() from the file \a fileName.
+     * \returns true if the file was read successfully
+     * \see writeToFile()
+     */
+    bool readFromFile( const QString &fileName );
+
+  private:
+
+    //! Contracts the vertices of a graph
+    class Builder;
+
+    struct Edge
+    {
+      int from;
+      int to;
+      double cost;
+      //! Index of the graph edge, or -1 for shortcuts
+      int graphEdge;
+      //! Indices of the two edges replaced by a shortcut
+      int firstChild;
+      int secondChild;
+    };
+
+    //! Builds the adjacency lists of the upward and downward edges used by the queries
+    void buildSearchGraph();
+
+    //! Appends the graph edges represented by the edge with index \a edgeIdx to \a path
+    void unpackEdge( int edgeIdx, QVector<int> &path ) const;
+
+    bool mValid = false;
+    int mGraphEdgeCount = 0;
+
+    //! Contraction order of the vertices
+    QVector< int > mRank;
+    QVector< Edge > mEdges;
+
+    //! Edges to vertices of higher rank, grouped by their start vertex
+    QVector< int > mUpOffsets;
+    QVector< int > mUpEdges;
+    //! Edges from vertices of higher rank, grouped by their end vertex
+    QVector< int > mDownOffsets;
+    QVector< int > mDownEdges;
+};
+
+#endif // QGSGRAPHCONTRACTIONHIERARCHY_H
@@ -26,6 +26,7 @@
 #include "qgis_analysis.h"
 
 class QgsGraphBuilderInterface;
+class QgsFeedback;
 
 #ifdef SIP_RUN
 % ModuleHeaderCode
@@ -69,15 +70,18 @@ class ANALYSIS_EXPORT QgsGraphDirector : public QObject
      * \param builder the graph builder
      * \param additionalPoints list of points that should be snapped to the graph
      * \param snappedPoints list of snapped points
+     * \param feedback optional feedback object for reporting progress and cancelation (since QGIS 3.0)
      * \note if snappedPoints[i] == QgsPoint(0.0,0.0) then snapping failed.
      */
     virtual void makeGraph( QgsGraphBuilderInterface *builder,
                             const QVector< QgsPoint > &additionalPoints,
-                            QVector< QgsPoint > &snappedPoints SIP_OUT ) const
+                            QVector< QgsPoint > &snappedPoints SIP_OUT,
+                            QgsFeedback *feedback = nullptr ) const
     {
       Q_UNUSED( builder );
       Q_UNUSED( additionalPoints );
       Q_UNUSED( snappedPoints );
+      Q_UNUSED( feedback );
     }
 
     //! Add optimization strategy
@@ -0,0 +1,164 @@
+/***************************************************************************
+  qgsgraphheap_p.h
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSGRAPHHEAP_P_H
+#define QGSGRAPHHEAP_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include <QVector>
+
+///@cond PRIVATE
+
+/**
+ * \ingroup analysis
+ * Binary min-heap of graph vertices, indexed by vertex so that the key of a vertex which is
+ * already queued can be changed in logarithmic time. Used by the shortest path searches
+ * instead of a multimap holding duplicated entries for every improved vertex.
+ * \note not available in Python bindings
+ */
+class QgsGraphVertexHeap
+{
+  public:
+
+    /**
+     * Constructor for QgsGraphVertexHeap, for vertex indices between 0 and \a vertexCount - 1.
+     */
+    explicit QgsGraphVertexHeap( int vertexCount = 0 )
+      : mPositions( vertexCount, -1 )
+    {}
+
+    //! Returns true if no vertex is queued
+    bool isEmpty() const { return mEntries.isEmpty(); }
+
+    //! Returns the number of queued vertices
+    int size() const { return mEntries.size(); }
+
+    //! Returns true if \a vertex is queued
+    bool contains( int vertex ) const { return mPositions.at( vertex ) >= 0; }
+
+    //! Returns the smallest key of the queued vertices. The heap must not be empty.
+    double topKey() const { return mEntries.at( 0 ).key; }
+
+    //! Returns the vertex with the smallest key. The heap must not be empty.
+    int top() const { return mEntries.at( 0 ).vertex; }
+
+    //! Removes the vertex with the smallest key from the heap and returns it. The heap must not be empty.
+    int pop()
+    {
+      int vertex = mEntries.at( 0 ).vertex;
+      mPositions[ vertex ] = -1;
+      Entry last = mEntries.last();
+      mEntries.removeLast();
+      if ( !mEntries.isEmpty() )
+      {
+        mEntries[ 0 ] = last;
+        mPositions[ last.vertex ] = 0;
+        siftDown( 0 );
+      }
+      return vertex;
+    }
+
+    //! Queues \a vertex with \a key, or changes its key if the vertex is already queued
+    void push( int vertex, double key )
+    {
+      int pos = mPositions.at( vertex );
+      if ( pos < 0 )
+      {
+        Entry entry;
+        entry.key = key;
+        entry.vertex = vertex;
+        mEntries.append( entry );
+        mPositions[ vertex ] = mEntries.size() - 1;
+        siftUp( mEntries.size() - 1 );
+      }
+      else if ( key < mEntries.at( pos ).key )
+      {
+        mEntries[ pos ].key = key;
+        siftUp( pos );
+      }
+      else
+      {
+        mEntries[ pos ].key = key;
+        siftDown( pos );
+      }
+    }
+
+    //! Removes all queued vertices. Only touches the queued vertices, so the heap can be reused cheaply.
+    void clear()
+    {
+      for ( const Entry &entry : mEntries )
+        mPositions[ entry.vertex ] = -1;
+      mEntries.clear();
+    }
+
+  private:
+
+    struct Entry
+    {
+      double key;
+      int vertex;
+    };
+
+    void siftUp( int pos )
+    {
+      Entry entry = mEntries.at( pos );
+      while ( pos > 0 )
+      {
+        int parent = ( pos - 1 ) / 2;
+        if ( mEntries.at( parent ).key <= entry.key )
+          break;
+        mEntries[ pos ] = mEntries.at( parent );
+        mPositions[ mEntries.at( pos ).vertex ] = pos;
+        pos = parent;
+      }
+      mEntries[ pos ] = entry;
+      mPositions[ entry.vertex ] = pos;
+    }
+
+    void siftDown( int pos )
+    {
+      Entry entry = mEntries.at( pos );
+      int count = mEntries.size();
+      while ( true )
+      {
+        int child = 2 * pos + 1;
+        if ( child >= count )
+          break;
+        if ( child + 1 < count && mEntries.at( child + 1 ).key < mEntries.at( child ).key )
+          ++child;
+        if ( entry.key <= mEntries.at( child ).key )
+          break;
+        mEntries[ pos ] = mEntries.at( child );
+        mPositions[ mEntries.at( pos ).vertex ] = pos;
+        pos = child;
+      }
+      mEntries[ pos ] = entry;
+      mPositions[ entry.vertex ] = pos;
+    }
+
+    QVector< Entry > mEntries;
+    QVector< int > mPositions;
+};
+
+///@endcond
+
+#endif // QGSGRAPHHEAP_P_H
@@ -20,3 +20,8 @@ QVariant QgsNetworkDistanceStrategy::cost( double distance, const QgsFeature &f
   Q_UNUSED( f );
   return QVariant( distance );
 }
+
+double QgsNetworkDistanceStrategy::minimumCostPerDistance() const
+{
+  return mMinimumCostPerDistance;
+}
@@ -29,6 +29,30 @@ class ANALYSIS_EXPORT QgsNetworkDistanceStrategy : public QgsNetworkStrategy
 {
   public:
     virtual QVariant cost( double distance, const QgsFeature & ) const override;
+
+    /**
+     * Returns the lower bound of the edge length per unit of distance in the graph's coordinates,
+     * which defaults to 0.
+     * \see setMinimumCostPerDistance()
+     */
+    virtual double minimumCostPerDistance() const override;
+
+    /**
+     * Sets the lower bound of the edge length per unit of distance in the graph's coordinates,
+     * which is used by QgsGraphAnalyzer::aStar() to estimate the remaining cost.
+     *
+     * The edge lengths are measured by the graph builder, usually on an ellipsoid, and their ratio to
+     * the distances between the vertex points depends on the CRS of the graph. It is only
+     * safe to set it to 1 if the builder measures the lengths in the graph's CRS units without an
+     * ellipsoid. A value that is larger than the actual ratio of any edge makes aStar() return paths
+     * which are not the shortest.
+     * \see minimumCostPerDistance()
+     */
+    void setMinimumCostPerDistance( double costPerDistance ) { mMinimumCostPerDistance = costPerDistance; }
+
+  private:
+
+    double mMinimumCostPerDistance = 0.0;
 };
 
 #endif // QGSNETWORKDISTANCESTRATEGY_H
@@ -73,6 +73,15 @@ class ANALYSIS_EXPORT QgsNetworkStrategy
      * Returns edge cost
      */
     virtual QVariant cost( double distance, const QgsFeature &f ) const = 0;
+
+    /**
+     * Returns a lower bound of the edge cost per unit of edge length. It is used by
+     * QgsGraphAnalyzer::aStar() to estimate the remaining cost to the destination vertex,
+     * so it must never be larger than the actual cost per unit of any edge.
+     * The default implementation returns 0, which disables the estimate.
+     * \since QGIS 3.0
+     */
+    virtual double minimumCostPerDistance() const { return 0.0; }
 };
 
 #endif // QGSNETWORKSTRATERGY_H
@@ -28,9 +28,15 @@
 #include <qgsgeometry.h>
 #include <qgsdistancearea.h>
 #include <qgswkbtypes.h>
+#include <qgsfeedback.h>
 
 #include <QString>
 #include <QtAlgorithms>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 /** \ingroup analysis
  * \class QgsPointCompare
@@ -102,6 +108,343 @@ bool TiePointInfoCompare( const TiePointInfo &a, const TiePointInfo &b )
   return a.mFirstPoint.x() == b.mFirstPoint.x() ? a.mFirstPoint.y() < b.mFirstPoint.y() : a.mFirstPoint.x() < b.mFirstPoint.x();
 }
 
+//! Number of features which are read and then processed by the worker threads at once
+static const int FEATURE_BATCH_SIZE = 1000;
+
+///@cond PRIVATE
+
+namespace
+{
+  //! A segment of a line, in destination coordinates
+  struct LineSegment
+  {
+    QgsPoint first;
+    QgsPoint last;
+  };
+
+  //! Returns the lines of a line or multi line feature
+  QgsMultiPolyline featureLines( const QgsFeature &feature )
+  {
+    QgsMultiPolyline mpl;
+    if ( !feature.hasGeometry() )
+      return mpl;
+
+    if ( QgsWkbTypes::flatType( feature.geometry().geometry()->wkbType() ) == QgsWkbTypes::MultiLineString )
+      mpl = feature.geometry().asMultiPolyline();
+    else if ( QgsWkbTypes::flatType( feature.geometry().geometry()->wkbType() ) == QgsWkbTypes::LineString )
+      mpl.push_back( feature.geometry().asPolyline() );
+    return mpl;
+  }
+
+  //! Transforms the lines of a feature, run by the worker threads
+  struct TransformLinesWrapper
+  {
+    const QgsCoordinateTransform *transform = nullptr;
+
+    explicit TransformLinesWrapper( const QgsCoordinateTransform *_transform )
+      : transform( _transform )
+    {}
+
+    void operator()( QgsMultiPolyline &lines )
+    {
+      for ( QgsPolyline &line : lines )
+      {
+        for ( QgsPoint &point : line )
+          point = transform->transform( point );
+      }
+    }
+  };
+
+  /**
+   * Uniform grid of line segments, used to find the segment closest to a point without
+   * testing all segments.
+   */
+  class SegmentGrid
+  {
+    public:
+      explicit SegmentGrid( const QVector< LineSegment > &segments )
+        : mSegments( segments )
+      {
+        if ( segments.isEmpty() )
+          return;
+
+        mXMin = mXMax = segments.at( 0 ).first.x();
+        mYMin = mYMax = segments.at( 0 ).first.y();
+        for ( const LineSegment &segment : segments )
+        {
+          mXMin = std::min( mXMin, std::min( segment.first.x(), segment.last.x() ) );
+          mXMax = std::max( mXMax, std::max( segment.first.x(), segment.last.x() ) );
+          mYMin = std::min( mYMin, std::min( segment.first.y(), segment.last.y() ) );
+          mYMax = std::max( mYMax, std::max( segment.first.y(), segment.last.y() ) );
+        }
+
+        // about one segment per cell
+        double width = mXMax - mXMin;
+        double height = mYMax - mYMin;
+        mCellSize = std::sqrt( width * height / segments.size() );
+        mCellSize = std::max( mCellSize, std::max( width, height ) / 4096.0 );
+        if ( mCellSize <= 0 )
+          mCellSize = 1.0;
+        mColumns = static_cast< int >( width / mCellSize ) + 1;
+        mRows = static_cast< int >( height / mCellSize ) + 1;
+
+        // compressed cell lists: count, accumulate, fill
+        mCellOffsets.fill( 0, mColumns * mRows + 1 );
+        for ( const LineSegment &segment : segments )
+        {
+          forEachCell( segment, [this]( int cell ) { ++mCellOffsets[ cell + 1 ]; } );
+        }
+        for ( int i = 0; i < mColumns * mRows; ++i )
+          mCellOffsets[ i + 1 ] += mCellOffsets.at( i );
+
+        mCellSegments.resize( mCellOffsets.last() );
+        QVector< int > fill = mCellOffsets;
+        for ( int i = 0; i < segments.size(); ++i )
+        {
+          forEachCell( segments.at( i ), [this, &fill, i]( int cell ) { mCellSegments[ fill[ cell ]++ ] = i; } );
+        }
+      }
+
+      /**
+       * Finds the segment closest to \a point. If several segments have the same distance, the one
+       * with the lowest index is returned.
+       * \returns index of the segment or -1 if there are no segments
+       */
+      int closestSegment( const QgsPoint &point, double &sqrDist, QgsPoint &closestPoint ) const
+      {
+        int bestSegment = -1;
+        sqrDist = std::numeric_limits<double>::infinity();
+        if ( mSegments.isEmpty() )
+          return -1;
+
+        int column = clamp( static_cast< int >( std::floor( ( point.x() - mXMin ) / mCellSize ) ), mColumns );
+        int row = clamp( static_cast< int >( std::floor( ( point.y() - mYMin ) / mCellSize ) ), mRows );
+
+        for ( int radius = 0; ; ++radius )
+        {
+          int c0 = column - radius;
+          int c1 = column + radius;
+          int r0 = row - radius;
+          int r1 = row + radius;
+
+          // only the cells on the border of the current ring are new
+          for ( int r = std::max( r0, 0 ); r <= std::min( r1, mRows - 1 ); ++r )
+          {
+            for ( int c = std::max( c0, 0 ); c <= std::min( c1, mColumns - 1 ); ++c )
+            {
+              if ( r != r0 && r != r1 && c != c0 && c != c1 )
+                continue;
+
+              int cell = r * mColumns + c;
+              for ( int i = mCellOffsets.at( cell ); i < mCellOffsets.at( cell + 1 ); ++i )
+              {
+                int segmentIdx = mCellSegments.at( i );
+                const LineSegment &segment = mSegments.at( segmentIdx );
+                QgsPoint segmentPoint;
+                double dist;
+                if ( segment.first == segment.last )
+                {
+                  dist = point.sqrDist( segment.first );
+                  segmentPoint = segment.first;
+                }
+                else
+                {
+                  dist = point.sqrDistToSegment( segment.first.x(), segment.first.y(),
+                                                 segment.last.x(), segment.last.y(), segmentPoint );
+                }
+                if ( dist < sqrDist || ( dist == sqrDist && segmentIdx < bestSegment ) )
+                {
+                  sqrDist = dist;
+                  bestSegment = segmentIdx;
+                  closestPoint = segmentPoint;
+                }
+              }
+            }
+          }
+
+          if ( c0 <= 0 && r0 <= 0 && c1 >= mColumns - 1 && r1 >= mRows - 1 )
+            break;
+
+          // distance from the point to the cells which have not been searched yet
+          double unsearched = std::numeric_limits<double>::infinity();
+          if ( c0 > 0 )
+            unsearched = std::min( unsearched, point.x() - ( mXMin + c0 * mCellSize ) );
+          if ( c1 < mColumns - 1 )
+            unsearched = std::min( unsearched, mXMin + ( c1 + 1 ) * mCellSize - point.x() );
+          if ( r0 > 0 )
+            unsearched = std::min( unsearched, point.y() - ( mYMin + r0 * mCellSize ) );
+          if ( r1 < mRows - 1 )
+            unsearched = std::min( unsearched, mYMin + ( r1 + 1 ) * mCellSize - point.y() );
+          unsearched = std::max( unsearched, 0.0 );
+          if ( sqrDist < unsearched * unsearched )
+            break;
+        }
+        return bestSegment;
+      }
+
+    private:
+
+      static int clamp( int value, int count )
+      {
+        return std::max( 0, std::min( value, count - 1 ) );
+      }
+
+      template <typename Func>
+      void forEachCell( const LineSegment &segment, Func func ) const
+      {
+        int c0 = clamp( static_cast< int >( ( std::min( segment.first.x(), segment.last.x() ) - mXMin ) / mCellSize ), mColumns );
+        int c1 = clamp( static_cast< int >( ( std::max( segment.first.x(), segment.last.x() ) - mXMin ) / mCellSize ), mColumns );
+        int r0 = clamp( static_cast< int >( ( std::min( segment.first.y(), segment.last.y() ) - mYMin ) / mCellSize ), mRows );
+        int r1 = clamp( static_cast< int >( ( std::max( segment.first.y(), segment.last.y() ) - mYMin ) / mCellSize ), mRows );
+        for ( int r = r0; r <= r1; ++r )
+        {
+          for ( int c = c0; c <= c1; ++c )
+            func( r * mColumns + c );
+        }
+      }
+
+      const QVector< LineSegment > &mSegments;
+      double mXMin = 0;
+      double mXMax = 0;
+      double mYMin = 0;
+      double mYMax = 0;
+      double mCellSize = 1;
+      int mColumns = 0;
+      int mRows = 0;
+      QVector< int > mCellOffsets;
+      QVector< int > mCellSegments;
+  };
+
+  //! Snaps the additional points to the closest segment, run by the worker threads
+  struct SnapPointWrapper
+  {
+    const SegmentGrid *grid = nullptr;
+    const QVector< LineSegment > *segments = nullptr;
+    const QVector< QgsPoint > *additionalPoints = nullptr;
+    QVector< TiePointInfo > *pointLengthMap = nullptr;
+
+    SnapPointWrapper( const SegmentGrid *_grid, const QVector< LineSegment > *_segments,
+                      const QVector< QgsPoint > *_additionalPoints, QVector< TiePointInfo > *_pointLengthMap )
+      : grid( _grid )
+      , segments( _segments )
+      , additionalPoints( _additionalPoints )
+      , pointLengthMap( _pointLengthMap )
+    {}
+
+    void operator()( int pointIdx )
+    {
+      TiePointInfo info;
+      int segmentIdx = grid->closestSegment( additionalPoints->at( pointIdx ), info.mLength, info.mTiedPoint );
+      if ( segmentIdx < 0 )
+        return;
+
+      info.mFirstPoint = segments->at( segmentIdx ).first;
+      info.mLastPoint = segments->at( segmentIdx ).last;
+      ( *pointLengthMap )[ pointIdx ] = info;
+    }
+  };
+
+  //! An edge of the graph, before the strategy costs are calculated
+  struct GraphEdgeInfo
+  {
+    int pt1idx;
+    QgsPoint pt1;
+    int pt2idx;
+    QgsPoint pt2;
+    double distance;
+  };
+
+  //! A feature of the second pass, and the edges created from its lines by a worker thread
+  struct FeatureEdges
+  {
+    QgsFeature feature;
+    QVector< GraphEdgeInfo > edges;
+  };
+
+  //! Splits the lines of a feature at the vertices and tie points, run by the worker threads
+  struct SplitFeatureWrapper
+  {
+    const QgsCoordinateTransform *transform = nullptr;
+    const QgsDistanceArea *distanceArea = nullptr;
+    const QVector< QgsPoint > *points = nullptr;
+    const QVector< TiePointInfo > *pointLengthMap = nullptr;
+    QgsPointCompare pointCompare;
+
+    SplitFeatureWrapper( const QgsCoordinateTransform *_transform, const QgsDistanceArea *_distanceArea,
+                         const QVector< QgsPoint > *_points, const QVector< TiePointInfo > *_pointLengthMap,
+                         const QgsPointCompare &_pointCompare )
+      : transform( _transform )
+      , distanceArea( _distanceArea )
+      , points( _points )
+      , pointLengthMap( _pointLengthMap )
+      , pointCompare( _pointCompare )
+    {}
+
+    void operator()( FeatureEdges &featureEdges )
+    {
+      QgsMultiPolyline mpl = featureLines( featureEdges.feature );
+      for ( const QgsPolyline &line : mpl )
+      {
+        QgsPoint pt1, pt2;
+        bool isFirstPoint = true;
+        for ( const QgsPoint &point : line )
+        {
+          pt2 = transform->transform( point );
+          if ( !isFirstPoint )
+            splitSegment( pt1, pt2, featureEdges.edges );
+          pt1 = pt2;
+          isFirstPoint = false;
+        }
+      }
+    }
+
+    void splitSegment( const QgsPoint &first, const QgsPoint &last, QVector< GraphEdgeInfo > &edges ) const
+    {
+      QMap< double, QgsPoint > pointsOnArc;
+      pointsOnArc[ 0.0 ] = first;
+      pointsOnArc[ first.sqrDist( last )] = last;
+
+      // all points tied to this segment
+      TiePointInfo t;
+      t.mFirstPoint = first;
+      t.mLastPoint  = last;
+      t.mLength = 0.0;
+      auto range = std::equal_range( pointLengthMap->constBegin(), pointLengthMap->constEnd(), t, TiePointInfoCompare );
+      for ( auto it = range.first; it != range.second; ++it )
+      {
+        pointsOnArc[ first.sqrDist( it->mTiedPoint )] = it->mTiedPoint;
+      }
+
+      QgsPoint pt1;
+      QgsPoint pt2;
+      int pt1idx = -1, pt2idx = -1;
+      bool isFirstPoint = true;
+      for ( auto pointsIt = pointsOnArc.constBegin(); pointsIt != pointsOnArc.constEnd(); ++pointsIt )
+      {
+        QVector< QgsPoint >::const_iterator tmp = my_binary_search( points->constBegin(), points->constEnd(), *pointsIt, pointCompare );
+        pt2 = *tmp;
+        pt2idx = tmp - points->constBegin();
+
+        if ( !isFirstPoint && pt1 != pt2 )
+        {
+          GraphEdgeInfo edge;
+          edge.pt1idx = pt1idx;
+          edge.pt1 = pt1;
+          edge.pt2idx = pt2idx;
+          edge.pt2 = pt2;
+          edge.distance = distanceArea->measureLine( pt1, pt2 );
+          edges << edge;
+        }
+        pt1idx = pt2idx;
+        pt1 = pt2;
+        isFirstPoint = false;
+      }
+    }
+  };
+}
+
+///@endcond
+
 QgsVectorLayerDirector::QgsVectorLayerDirector( QgsVectorLayer *myLayer,
     int directionFieldId,
     const QString &directDirectionValue,
@@ -124,7 +467,7 @@ QString QgsVectorLayerDirector::name() const
 }
 
 void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const QVector< QgsPoint > &additionalPoints,
-                                        QVector< QgsPoint > &snappedPoints ) const
+                                        QVector< QgsPoint > &snappedPoints, QgsFeedback *feedback ) const
 {
   QgsVectorLayer *vl = mVectorLayer;
 
@@ -151,69 +494,74 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
   tmpInfo.mLength = std::numeric_limits<double>::infinity();
 
   QVector< TiePointInfo > pointLengthMap( additionalPoints.size(), tmpInfo );
-  QVector< TiePointInfo >::iterator pointLengthIt;
 
   //Graph's points;
   QVector< QgsPoint > points;
+  //Graph's segments, in the order of the features
+  QVector< LineSegment > segments;
 
   QgsFeatureIterator fit = vl->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
 
   // begin: tie points to the graph
-  QgsAttributeList la;
+  // read the features in batches, the lines are transformed by worker threads
   QgsFeature feature;
-  while ( fit.nextFeature( feature ) )
+  bool hasMoreFeatures = true;
+  while ( hasMoreFeatures )
   {
-    QgsMultiPolyline mpl;
-    if ( QgsWkbTypes::flatType( feature.geometry().geometry()->wkbType() ) == QgsWkbTypes::MultiLineString )
-      mpl = feature.geometry().asMultiPolyline();
-    else if ( QgsWkbTypes::flatType( feature.geometry().geometry()->wkbType() ) == QgsWkbTypes::LineString )
-      mpl.push_back( feature.geometry().asPolyline() );
+    if ( feedback && feedback->isCanceled() )
+      return;
 
-    QgsMultiPolyline::iterator mplIt;
-    for ( mplIt = mpl.begin(); mplIt != mpl.end(); ++mplIt )
+    QVector< QgsMultiPolyline > batch;
+    while ( batch.size() < FEATURE_BATCH_SIZE )
     {
-      QgsPoint pt1, pt2;
-      bool isFirstPoint = true;
-      QgsPolyline::iterator pointIt;
-      for ( pointIt = mplIt->begin(); pointIt != mplIt->end(); ++pointIt )
+      if ( !fit.nextFeature( feature ) )
       {
-        pt2 = ct.transform( *pointIt );
-        points.push_back( pt2 );
+        hasMoreFeatures = false;
+        break;
+      }
+      batch << featureLines( feature );
+    }
+
+    QtConcurrent::blockingMap( batch, TransformLinesWrapper( &ct ) );
 
-        if ( !isFirstPoint )
+    for ( const QgsMultiPolyline &mpl : batch )
+    {
+      for ( const QgsPolyline &line : mpl )
+      {
+        for ( int i = 0; i < line.size(); ++i )
         {
-          int i = 0;
-          for ( i = 0; i != additionalPoints.size(); ++i )
+          points.push_back( line.at( i ) );
+          if ( i > 0 )
           {
-            TiePointInfo info;
-            if ( pt1 == pt2 )
-            {
-              info.mLength = additionalPoints[ i ].sqrDist( pt1 );
-              info.mTiedPoint = pt1;
-            }
-            else
-            {
-              info.mLength = additionalPoints[ i ].sqrDistToSegment( pt1.x(), pt1.y(),
-                             pt2.x(), pt2.y(), info.mTiedPoint );
-            }
-
-            if ( pointLengthMap[ i ].mLength > info.mLength )
-            {
-              Q_UNUSED( info.mTiedPoint );
-              info.mFirstPoint = pt1;
-              info.mLastPoint = pt2;
-
-              pointLengthMap[ i ] = info;
-              snappedPoints[ i ] = info.mTiedPoint;
-            }
+            LineSegment segment;
+            segment.first = line.at( i - 1 );
+            segment.last = line.at( i );
+            segments << segment;
           }
         }
-        pt1 = pt2;
-        isFirstPoint = false;
       }
+      emit buildProgress( ++step, featureCount );
     }
-    emit buildProgress( ++step, featureCount );
+    if ( feedback && featureCount > 0 )
+      feedback->setProgress( 100.0 * step / featureCount );
   }
+
+  if ( !additionalPoints.isEmpty() )
+  {
+    SegmentGrid grid( segments );
+    QVector< int > pointIndices;
+    pointIndices.reserve( additionalPoints.size() );
+    for ( int i = 0; i < additionalPoints.size(); ++i )
+      pointIndices << i;
+    QtConcurrent::blockingMap( pointIndices, SnapPointWrapper( &grid, &segments, &additionalPoints, &pointLengthMap ) );
+
+    for ( int i = 0; i < pointLengthMap.size(); ++i )
+    {
+      if ( pointLengthMap.at( i ).mLength < std::numeric_limits<double>::infinity() )
+        snappedPoints[ i ] = pointLengthMap.at( i ).mTiedPoint;
+    }
+  }
+  segments.clear();
   // end: tie points to graph
 
   // add tied point to graph
@@ -240,6 +588,7 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
 
   std::sort( pointLengthMap.begin(), pointLengthMap.end(), TiePointInfoCompare );
 
+  QgsAttributeList la;
   {
     // fill attribute list 'la'
     QgsAttributeList tmpAttr;
@@ -276,117 +625,72 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
   } // end fill attribute list 'la'
 
   // begin graph construction
+  // the lines are split by worker threads, the strategies and the builder are only used in this thread
+  SplitFeatureWrapper splitFeature( &ct, builder->distanceArea(), &points, &pointLengthMap, pointCompare );
   fit = vl->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( la ) );
-  while ( fit.nextFeature( feature ) )
+  hasMoreFeatures = true;
+  while ( hasMoreFeatures )
   {
-    Direction directionType = mDefaultDirection;
+    if ( feedback && feedback->isCanceled() )
+      return;
 
-    // What direction have feature?
-    QString str = feature.attribute( mDirectionFieldId ).toString();
-    if ( str == mBothDirectionValue )
-    {
-      directionType = Direction::DirectionBoth;
-    }
-    else if ( str == mDirectDirectionValue )
-    {
-      directionType = Direction::DirectionForward;
-    }
-    else if ( str == mReverseDirectionValue )
+    QVector< FeatureEdges > batch;
+    while ( batch.size() < FEATURE_BATCH_SIZE )
     {
-      directionType = Direction::DirectionBackward;
+      FeatureEdges featureEdges;
+      if ( !fit.nextFeature( featureEdges.feature ) )
+      {
+        hasMoreFeatures = false;
+        break;
+      }
+      batch << featureEdges;
     }
 
-    // begin features segments and add arc to the Graph;
-    QgsMultiPolyline mpl;
-    if ( QgsWkbTypes::flatType( feature.geometry().geometry()->wkbType() ) == QgsWkbTypes::MultiLineString )
-      mpl = feature.geometry().asMultiPolyline();
-    else if ( QgsWkbTypes::flatType( feature.geometry().geometry()->wkbType() ) == QgsWkbTypes::LineString )
-      mpl.push_back( feature.geometry().asPolyline() );
+    QtConcurrent::blockingMap( batch, splitFeature );
 
-    QgsMultiPolyline::iterator mplIt;
-    for ( mplIt = mpl.begin(); mplIt != mpl.end(); ++mplIt )
+    for ( const FeatureEdges &featureEdges : batch )
     {
-      QgsPoint pt1, pt2;
+      const QgsFeature &feature = featureEdges.feature;
+      Direction directionType = mDefaultDirection;
 
-      bool isFirstPoint = true;
-      QgsPolyline::iterator pointIt;
-      for ( pointIt = mplIt->begin(); pointIt != mplIt->end(); ++pointIt )
+      // What direction have feature?
+      QString str = feature.attribute( mDirectionFieldId ).toString();
+      if ( str == mBothDirectionValue )
+      {
+        directionType = Direction::DirectionBoth;
+      }
+      else if ( str == mDirectDirectionValue )
       {
-        pt2 = ct.transform( *pointIt );
+        directionType = Direction::DirectionForward;
+      }
+      else if ( str == mReverseDirectionValue )
+      {
+        directionType = Direction::DirectionBackward;
+      }
 
-        if ( !isFirstPoint )
+      for ( const GraphEdgeInfo &edge : featureEdges.edges )
+      {
+        QVector< QVariant > prop;
+        QList< QgsNetworkStrategy * >::const_iterator it;
+        for ( it = mStrategies.begin(); it != mStrategies.end(); ++it )
         {
-          QMap< double, QgsPoint > pointsOnArc;
-          pointsOnArc[ 0.0 ] = pt1;
-          pointsOnArc[ pt1.sqrDist( pt2 )] = pt2;
-
-          TiePointInfo t;
-          t.mFirstPoint = pt1;
-          t.mLastPoint  = pt2;
-          t.mLength = 0.0;
-          pointLengthIt = my_binary_search( pointLengthMap.begin(), pointLengthMap.end(), t, TiePointInfoCompare );
-
-          if ( pointLengthIt != pointLengthMap.end() )
-          {
-            QVector< TiePointInfo >::iterator it;
-            for ( it = pointLengthIt; it - pointLengthMap.begin() >= 0; --it )
-            {
-              if ( it->mFirstPoint == pt1 && it->mLastPoint == pt2 )
-              {
-                pointsOnArc[ pt1.sqrDist( it->mTiedPoint )] = it->mTiedPoint;
-              }
-            }
-            for ( it = pointLengthIt + 1; it != pointLengthMap.end(); ++it )
-            {
-              if ( it->mFirstPoint == pt1 && it->mLastPoint == pt2 )
-              {
-                pointsOnArc[ pt1.sqrDist( it->mTiedPoint )] = it->mTiedPoint;
-              }
-            }
-          }
-
-          QMap< double, QgsPoint >::iterator pointsIt;
-          QgsPoint pt1;
-          QgsPoint pt2;
-          int pt1idx = -1, pt2idx = -1;
-          bool isFirstPoint = true;
-          for ( pointsIt = pointsOnArc.begin(); pointsIt != pointsOnArc.end(); ++pointsIt )
-          {
-            pt2 = *pointsIt;
-            tmp = my_binary_search( points.begin(), points.end(), pt2, pointCompare );
-            pt2 = *tmp;
-            pt2idx = tmp - points.begin();
-
-            if ( !isFirstPoint && pt1 != pt2 )
-            {
-              double distance = builder->distanceArea()->measureLine( pt1, pt2 );
-              QVector< QVariant > prop;
-              QList< QgsNetworkStrategy * >::const_iterator it;
-              for ( it = mStrategies.begin(); it != mStrategies.end(); ++it )
-              {
-                prop.push_back( ( *it )->cost( distance, feature ) );
-              }
+          prop.push_back( ( *it )->cost( edge.distance, feature ) );
+        }
 
-              if ( directionType == Direction::DirectionForward ||
-                   directionType == Direction::DirectionBoth )
-              {
-                builder->addEdge( pt1idx, pt1, pt2idx, pt2, prop );
-              }
-              if ( directionType == Direction::DirectionBackward ||
-                   directionType == Direction::DirectionBoth )
-              {
-                builder->addEdge( pt2idx, pt2, pt1idx, pt1, prop );
-              }
-            }
-            pt1idx = pt2idx;
-            pt1 = pt2;
-            isFirstPoint = false;
-          }
-        } // if ( !isFirstPoint )
-        pt1 = pt2;
-        isFirstPoint = false;
-      } // for (it = pl.begin(); it != pl.end(); ++it)
+        if ( directionType == Direction::DirectionForward ||
+             directionType == Direction::DirectionBoth )
+        {
+          builder->addEdge( edge.pt1idx, edge.pt1, edge.pt2idx, edge.pt2, prop );
+        }
+        if ( directionType == Direction::DirectionBackward ||
+             directionType == Direction::DirectionBoth )
+        {
+          builder->addEdge( edge.pt2idx, edge.pt2, edge.pt1idx, edge.pt1, prop );
+        }
+      }
+      emit buildProgress( ++step, featureCount );
     }
-    emit buildProgress( ++step, featureCount );
+    if ( feedback && featureCount > 0 )
+      feedback->setProgress( 100.0 * step / featureCount );
   } // while( vl->nextFeature(feature) )
 } // makeGraph( QgsGraphBuilderInterface *builder, const QVector< QgsPoint >& additionalPoints, QVector< QgsPoint >& tiedPoint )
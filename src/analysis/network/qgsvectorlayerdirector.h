@@ -72,9 +72,15 @@ class ANALYSIS_EXPORT QgsVectorLayerDirector : public QgsGraphDirector
     /*
      * MANDATORY DIRECTOR PROPERTY DECLARATION
      */
+    /**
+     * Makes a graph from the lines of the vector layer. The features are read in batches, and the
+     * lines of each batch are transformed and split at the snapped points by worker threads.
+     * Snapping the additional points uses a grid index of the line segments.
+     */
     void makeGraph( QgsGraphBuilderInterface *builder,
                     const QVector< QgsPoint > &additionalPoints,
-                    QVector< QgsPoint> &snappedPoints SIP_OUT ) const override;
+                    QVector< QgsPoint> &snappedPoints SIP_OUT,
+                    QgsFeedback *feedback = nullptr ) const override;
 
     QString name() const override;
 
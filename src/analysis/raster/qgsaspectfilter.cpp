@@ -17,6 +17,8 @@
 
 #include "qgsaspectfilter.h"
 
+#include <QVector>
+
 QgsAspectFilter::QgsAspectFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : QgsDerivativeFilter( inputFile, outputFile, outputFormat )
 {
@@ -43,3 +45,22 @@ float QgsAspectFilter::processNineCellWindow(
   }
 }
 
+void QgsAspectFilter::processNineCellRow( float *rowAbove, float *rowCurrent, float *rowBelow, float *resultRow, int xSize )
+{
+  //the derivatives in x-direction are stored in the result row and replaced by the aspect values
+  QVector<float> derY( xSize );
+  calcFirstDerRow( rowAbove, rowCurrent, rowBelow, resultRow, derY.data(), xSize );
+
+  for ( int j = 0; j < xSize; ++j )
+  {
+    float derX = resultRow[j];
+    if ( derX == mOutputNodataValue ||
+         derY[j] == mOutputNodataValue ||
+         ( derX == 0.0 && derY[j] == 0.0 ) )
+    {
+      resultRow[j] = mOutputNodataValue;
+      continue;
+    }
+    resultRow[j] = 180.0 + atan2( derX, derY[j] ) * 180.0 / M_PI;
+  }
+}
@@ -34,6 +34,8 @@ class ANALYSIS_EXPORT QgsAspectFilter: public QgsDerivativeFilter
                                  float *x12, float *x22, float *x32,
                                  float *x13, float *x23, float *x33 ) override;
 
+    void processNineCellRow( float *rowAbove, float *rowCurrent, float *rowBelow, float *resultRow, int xSize ) override;
+
 };
 
 #endif // QGSASPECTFILTER_H
@@ -157,7 +157,15 @@ float QgsDerivativeFilter::calcFirstDerY( float *x11, float *x21, float *x31, fl
   return sum / ( weight * mCellSizeY * mZFactor );
 }
 
-
-
-
-
+void QgsDerivativeFilter::calcFirstDerRow( float *rowAbove, float *rowCurrent, float *rowBelow, float *derX, float *derY, int xSize )
+{
+  for ( int j = 0; j < xSize; ++j )
+  {
+    derX[j] = calcFirstDerX( &rowAbove[j], &rowAbove[j + 1], &rowAbove[j + 2],
+                             &rowCurrent[j], &rowCurrent[j + 1], &rowCurrent[j + 2],
+                             &rowBelow[j], &rowBelow[j + 1], &rowBelow[j + 2] );
+    derY[j] = calcFirstDerY( &rowAbove[j], &rowAbove[j + 1], &rowAbove[j + 2],
+                             &rowCurrent[j], &rowCurrent[j + 1], &rowCurrent[j + 2],
+                             &rowBelow[j], &rowBelow[j + 1], &rowBelow[j + 2] );
+  }
+}
@@ -38,6 +38,13 @@ class ANALYSIS_EXPORT QgsDerivativeFilter : public QgsNineCellFilter
     float calcFirstDerX( float *x11, float *x21, float *x31, float *x12, float *x22, float *x32, float *x13, float *x23, float *x33 );
     //! Calculates the first order derivative in y-direction according to Horn (1981)
     float calcFirstDerY( float *x11, float *x21, float *x31, float *x12, float *x22, float *x32, float *x13, float *x23, float *x33 );
+
+    /** Calculates the first order derivatives in x- and y-direction for a whole row of cells. The input rows are padded
+     * as described in processNineCellRow(). Each of \a derX and \a derY receives \a xSize values, which are set to the
+     * output nodata value where the derivative cannot be calculated.
+     * \since QGIS 3.0
+     */
+    void calcFirstDerRow( float *rowAbove, float *rowCurrent, float *rowBelow, float *derX, float *derY, int xSize );
 };
 
 #endif // QGSDERIVATIVEFILTER_H
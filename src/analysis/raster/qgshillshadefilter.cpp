@@ -17,6 +17,8 @@
 
 #include "qgshillshadefilter.h"
 
+#include <QVector>
+
 QgsHillshadeFilter::QgsHillshadeFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat, double lightAzimuth,
                                         double lightAngle )
   : QgsDerivativeFilter( inputFile, outputFile, outputFormat )
@@ -51,3 +53,38 @@ float QgsHillshadeFilter::processNineCellWindow( float *x11, float *x21, float *
   }
   return qMax( 0.0, 255.0 * ( ( cos( zenith_rad ) * cos( slope_rad ) ) + ( sin( zenith_rad ) * sin( slope_rad ) * cos( azimuth_rad - aspect_rad ) ) ) );
 }
+
+void QgsHillshadeFilter::processNineCellRow( float *rowAbove, float *rowCurrent, float *rowBelow, float *resultRow, int xSize )
+{
+  //the derivatives in x-direction are stored in the result row and replaced by the hillshade values
+  QVector<float> derY( xSize );
+  calcFirstDerRow( rowAbove, rowCurrent, rowBelow, resultRow, derY.data(), xSize );
+
+  //terms depending on the light source only are the same for the whole row
+  float zenith_rad = mLightAngle * M_PI / 180.0;
+  float azimuth_rad = mLightAzimuth * M_PI / 180.0;
+  const auto cosZenith = cos( zenith_rad );
+  const auto sinZenith = sin( zenith_rad );
+
+  for ( int j = 0; j < xSize; ++j )
+  {
+    float derX = resultRow[j];
+    if ( derX == mOutputNodataValue || derY[j] == mOutputNodataValue )
+    {
+      resultRow[j] = mOutputNodataValue;
+      continue;
+    }
+
+    float slope_rad = atan( sqrt( derX * derX + derY[j] * derY[j] ) );
+    float aspect_rad = 0;
+    if ( derX == 0 && derY[j] == 0 ) //aspect undefined, take a neutral value
+    {
+      aspect_rad = azimuth_rad / 2.0;
+    }
+    else
+    {
+      aspect_rad = M_PI + atan2( derX, derY[j] );
+    }
+    resultRow[j] = qMax( 0.0, 255.0 * ( ( cosZenith * cos( slope_rad ) ) + ( sinZenith * sin( slope_rad ) * cos( azimuth_rad - aspect_rad ) ) ) );
+  }
+}
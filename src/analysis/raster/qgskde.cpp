@@ -17,8 +17,17 @@
 #include "qgsvectorlayer.h"
 #include "qgsgeometry.h"
 
+#include <QtConcurrentMap>
+
 #define NO_DATA -9999
 
+//! Width and height of the in-memory tiles of the output raster, in pixels
+static const int KDE_TILE_SIZE = 256;
+//! Number of points which are collected before they are added to the tiles by the worker threads
+static const int KDE_BATCH_POINTS = 100000;
+//! Maximum number of tiles kept in memory before they are written to the output raster
+static const int KDE_MAX_CACHED_TILES = 1024;
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -34,9 +43,15 @@ QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEs
   , mShape( parameters.shape )
   , mDecay( parameters.decayRatio )
   , mOutputValues( parameters.outputValues )
-  , mBufferSize( -1 )
   , mDatasetH( nullptr )
   , mRasterBandH( nullptr )
+  , mRows( 0 )
+  , mColumns( 0 )
+  , mTileColumns( 0 )
+  , mTileRows( 0 )
+  , mCachedTileCount( 0 )
+  , mMaxCachedTiles( KDE_MAX_CACHED_TILES )
+  , mBatchPoints( KDE_BATCH_POINTS )
 {
   if ( !parameters.radiusField.isEmpty() )
     mRadiusField = mInputLayer->fields().lookupField( parameters.radiusField );
@@ -100,9 +115,19 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::prepare()
   if ( !mRasterBandH )
     return FileCreationError;
 
-  mBufferSize = -1;
+  mRows = rows;
+  mColumns = cols;
+  mTileColumns = ( cols + KDE_TILE_SIZE - 1 ) / KDE_TILE_SIZE;
+  mTileRows = ( rows + KDE_TILE_SIZE - 1 ) / KDE_TILE_SIZE;
+  mTiles = QVector< QVector< float > >( mTileColumns * mTileRows );
+  mTileWritten = QVector< bool >( mTileColumns * mTileRows, false );
+  mTilePoints = QVector< QVector< int > >( mTileColumns * mTileRows );
+  mCachedTileCount = 0;
+
+  mPendingPoints.clear();
+  mFootprints.clear();
   if ( mRadiusField < 0 )
-    mBufferSize = radiusSizeInPixels( mRadius );
+    mFootprints << footprint( mRadius );
 
   return Success;
 }
@@ -131,15 +156,18 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
     multiPoints = featureGeometry.asMultiPoint();
   }
 
-  // if radius is variable then fetch it and calculate new pixel buffer size
-  double radius = mRadius;
-  int buffer = mBufferSize;
+  // if radius is variable then fetch it and calculate a new footprint
+  int footprintIdx = 0;
   if ( mRadiusField >= 0 )
   {
-    radius = feature.attribute( mRadiusField ).toDouble();
-    buffer = radiusSizeInPixels( radius );
+    double radius = feature.attribute( mRadiusField ).toDouble();
+    if ( radius <= 0 )
+      return Success;
+
+    if ( mFootprints.isEmpty() || mFootprints.last().radius != radius )
+      mFootprints << footprint( radius );
+    footprintIdx = mFootprints.size() - 1;
   }
-  int blockSize = 2 * buffer + 1; //Block SIDE would be more appropriate
 
   // calculate weight
   double weight = 1.0;
@@ -148,8 +176,6 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
     weight = feature.attribute( mWeightField ).toDouble();
   }
 
-  Result result = Success;
-
   //loop through all points in multipoint
   for ( QgsMultiPoint::const_iterator pointIt = multiPoints.constBegin(); pointIt != multiPoints.constEnd(); ++pointIt )
   {
@@ -159,59 +185,268 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
       continue;
     }
 
-    // calculate the pixel position
-    unsigned int xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
+    PendingPoint point;
+    point.x = pointIt->x();
+    point.y = pointIt->y();
+    point.weight = weight;
+    point.footprint = footprintIdx;
+    mPendingPoints << point;
+  }
+
+  // the points are added to the surface in batches
+  if ( mPendingPoints.size() >= mBatchPoints )
+    return addPendingPoints();
+
+  return Success;
+}
+
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
+{
+  Result result = addPendingPoints();
+  if ( !writeTiles() )
+    result = RasterIoError;
+
+  mTiles.clear();
+  mTileWritten.clear();
+  mTilePoints.clear();
+  mFootprints.clear();
+
+  GDALClose( ( GDALDatasetH ) mDatasetH );
+  mDatasetH = nullptr;
+  mRasterBandH = nullptr;
+  return result;
+}
+
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addPendingPoints()
+{
+  if ( mPendingPoints.isEmpty() )
+    return Success;
 
-    // get the data
-    float *dataBuffer = ( float * ) CPLMalloc( sizeof( float ) * blockSize * blockSize );
-    if ( GDALRasterIO( mRasterBandH, GF_Read, xPosition, yPosition, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
+  Result result = Success;
+
+  // sort the points into the tiles touched by their kernels, keeping the order in which they were added
+  QVector< int > tiles;
+  for ( int i = 0; i < mPendingPoints.size(); ++i )
+  {
+    const PendingPoint &point = mPendingPoints.at( i );
+    int buffer = mFootprints.at( point.footprint ).buffer;
+    int xPosition = static_cast< int >( ( point.x - mBounds.xMinimum() ) / mPixelSize ) - buffer;
+    int yPosition = static_cast< int >( ( point.y - mBounds.yMinimum() ) / mPixelSize ) - buffer;
+
+    int firstTileColumn = qMax( xPosition, 0 ) / KDE_TILE_SIZE;
+    int lastTileColumn = qMin( xPosition + 2 * buffer, mColumns - 1 ) / KDE_TILE_SIZE;
+    int firstTileRow = qMax( yPosition, 0 ) / KDE_TILE_SIZE;
+    int lastTileRow = qMin( yPosition + 2 * buffer, mRows - 1 ) / KDE_TILE_SIZE;
+    for ( int tileRow = firstTileRow; tileRow <= lastTileRow; ++tileRow )
     {
-      result = RasterIoError;
+      for ( int tileColumn = firstTileColumn; tileColumn <= lastTileColumn; ++tileColumn )
+      {
+        int tileIdx = tileRow * mTileColumns + tileColumn;
+        if ( mTilePoints.at( tileIdx ).isEmpty() )
+          tiles << tileIdx;
+        mTilePoints[ tileIdx ] << i;
+      }
     }
+  }
+
+  // tiles are read from the output raster in this thread, GDAL datasets must not be shared between threads
+  for ( int tileIdx : tiles )
+  {
+    if ( !loadTile( tileIdx ) )
+      result = RasterIoError;
+  }
+
+  // each tile is only modified by a single worker thread
+  QtConcurrent::blockingMap( tiles, AddPointsWrapper( this ) );
+
+  for ( int tileIdx : tiles )
+    mTilePoints[ tileIdx ].clear();
+  mPendingPoints.clear();
+  if ( mRadiusField >= 0 )
+    mFootprints.clear();
+
+  if ( mCachedTileCount > mMaxCachedTiles && !writeTiles() )
+    result = RasterIoError;
+
+  return result;
+}
+
+void QgsKernelDensityEstimation::AddPointsWrapper::operator()( int tileIdx )
+{
+  instance->addPointsToTile( tileIdx );
+}
+
+///@cond PRIVATE
+
+/**
+ * Kernel functions relative to their value at distance 0, in terms of the ratio of the squared
+ * distance to the squared bandwidth. See the kernel functions of QgsKernelDensityEstimation.
+ */
+template <QgsKernelDensityEstimation::KernelShape Shape> inline double kernelProfile( double squaredRatio, double decay );
 
-    for ( int xp = 0; xp < blockSize; xp++ )
+template <> inline double kernelProfile< QgsKernelDensityEstimation::KernelQuartic >( double squaredRatio, double )
+{
+  double v = 1. - squaredRatio;
+  return v * v;
+}
+
+template <> inline double kernelProfile< QgsKernelDensityEstimation::KernelTriangular >( double squaredRatio, double decay )
+{
+  return 1. - ( 1. - decay ) * sqrt( squaredRatio );
+}
+
+template <> inline double kernelProfile< QgsKernelDensityEstimation::KernelUniform >( double, double )
+{
+  return 1.;
+}
+
+template <> inline double kernelProfile< QgsKernelDensityEstimation::KernelTriweight >( double squaredRatio, double )
+{
+  double v = 1. - squaredRatio;
+  return v * v * v;
+}
+
+template <> inline double kernelProfile< QgsKernelDensityEstimation::KernelEpanechnikov >( double squaredRatio, double )
+{
+  return 1. - squaredRatio;
+}
+
+///@endcond
+
+template <QgsKernelDensityEstimation::KernelShape Shape>
+void QgsKernelDensityEstimation::addPointToTile( const PendingPoint &point, const KernelFootprint &footprint, int tileIdx )
+{
+  int tileX = ( tileIdx % mTileColumns ) * KDE_TILE_SIZE;
+  int tileY = ( tileIdx / mTileColumns ) * KDE_TILE_SIZE;
+
+  // pixel block of the kernel, clipped to the tile
+  int xPosition = static_cast< int >( ( point.x - mBounds.xMinimum() ) / mPixelSize ) - footprint.buffer;
+  int yPosition = static_cast< int >( ( point.y - mBounds.yMinimum() ) / mPixelSize ) - footprint.buffer;
+  int xStart = qMax( xPosition, tileX );
+  int xEnd = qMin( qMin( xPosition + 2 * footprint.buffer + 1, tileX + KDE_TILE_SIZE ), mColumns );
+  int yStart = qMax( yPosition, tileY );
+  int yEnd = qMin( qMin( yPosition + 2 * footprint.buffer + 1, tileY + KDE_TILE_SIZE ), mRows );
+  if ( xStart >= xEnd || yStart >= yEnd )
+    return;
+
+  // squared horizontal distances are the same for all rows
+  double squaredDx[ KDE_TILE_SIZE ];
+  for ( int x = xStart; x < xEnd; ++x )
+  {
+    double dx = ( x + 0.5 ) * mPixelSize + mBounds.xMinimum() - point.x;
+    squaredDx[ x - xStart ] = dx * dx;
+  }
+
+  double scale = point.weight * footprint.scale;
+  float *tile = mTiles[ tileIdx ].data();
+  for ( int y = yStart; y < yEnd; ++y )
+  {
+    double dy = ( y + 0.5 ) * mPixelSize + mBounds.yMinimum() - point.y;
+    double squaredDy = dy * dy;
+    // is row outside search bandwidth of feature?
+    if ( squaredDy > footprint.squaredRadius )
+      continue;
+
+    float *row = tile + ( y - tileY ) * KDE_TILE_SIZE - tileX;
+    for ( int x = xStart; x < xEnd; ++x )
     {
-      for ( int yp = 0; yp < blockSize; yp++ )
+      double squaredDistance = squaredDx[ x - xStart ] + squaredDy;
+      // is pixel outside search bandwidth of feature?
+      if ( squaredDistance > footprint.squaredRadius )
+        continue;
+
+      if ( row[ x ] == NO_DATA )
       {
-        double pixelCentroidX = ( xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
-        double pixelCentroidY = ( yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
-
-        double distance = sqrt( pow( pixelCentroidX - ( *pointIt ).x(), 2.0 ) + pow( pixelCentroidY - ( *pointIt ).y(), 2.0 ) );
-
-        // is pixel outside search bandwidth of feature?
-        if ( distance > radius )
-        {
-          continue;
-        }
-
-        double pixelValue = weight * calculateKernelValue( distance, radius, mShape, mOutputValues );
-        int pos = xp + blockSize * yp;
-        if ( dataBuffer[ pos ] == NO_DATA )
-        {
-          dataBuffer[ pos ] = 0;
-        }
-        dataBuffer[ pos ] += pixelValue;
+        row[ x ] = 0;
       }
+      row[ x ] += scale * kernelProfile< Shape >( squaredDistance / footprint.squaredRadius, footprint.decay );
     }
-    if ( GDALRasterIO( mRasterBandH, GF_Write, xPosition, yPosition, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
+  }
+}
+
+void QgsKernelDensityEstimation::addPointsToTile( int tileIdx )
+{
+  // the kernel shape is resolved once per tile instead of for every pixel
+  for ( int pointIdx : mTilePoints.at( tileIdx ) )
+  {
+    const PendingPoint &point = mPendingPoints.at( pointIdx );
+    const KernelFootprint &footprint = mFootprints.at( point.footprint );
+    switch ( footprint.shape )
     {
-      result = RasterIoError;
+      case KernelQuartic:
+        addPointToTile< KernelQuartic >( point, footprint, tileIdx );
+        break;
+      case KernelTriangular:
+        addPointToTile< KernelTriangular >( point, footprint, tileIdx );
+        break;
+      case KernelUniform:
+        addPointToTile< KernelUniform >( point, footprint, tileIdx );
+        break;
+      case KernelTriweight:
+        addPointToTile< KernelTriweight >( point, footprint, tileIdx );
+        break;
+      case KernelEpanechnikov:
+        addPointToTile< KernelEpanechnikov >( point, footprint, tileIdx );
+        break;
     }
-    CPLFree( dataBuffer );
   }
+}
+
+bool QgsKernelDensityEstimation::loadTile( int tileIdx )
+{
+  QVector< float > &tile = mTiles[ tileIdx ];
+  if ( !tile.isEmpty() )
+    return true;
+
+  tile.fill( NO_DATA, KDE_TILE_SIZE * KDE_TILE_SIZE );
+  ++mCachedTileCount;
+  if ( !mTileWritten.at( tileIdx ) )
+    return true;
+
+  int tileX = ( tileIdx % mTileColumns ) * KDE_TILE_SIZE;
+  int tileY = ( tileIdx / mTileColumns ) * KDE_TILE_SIZE;
+  int width = qMin( KDE_TILE_SIZE, mColumns - tileX );
+  int height = qMin( KDE_TILE_SIZE, mRows - tileY );
+  return GDALRasterIO( mRasterBandH, GF_Read, tileX, tileY, width, height, tile.data(), width, height,
+                       GDT_Float32, 0, sizeof( float ) * KDE_TILE_SIZE ) == CE_None;
+}
 
+bool QgsKernelDensityEstimation::writeTiles()
+{
+  bool result = true;
+  for ( int tileIdx = 0; tileIdx < mTiles.size(); ++tileIdx )
+  {
+    QVector< float > &tile = mTiles[ tileIdx ];
+    if ( tile.isEmpty() )
+      continue;
+
+    int tileX = ( tileIdx % mTileColumns ) * KDE_TILE_SIZE;
+    int tileY = ( tileIdx / mTileColumns ) * KDE_TILE_SIZE;
+    int width = qMin( KDE_TILE_SIZE, mColumns - tileX );
+    int height = qMin( KDE_TILE_SIZE, mRows - tileY );
+    if ( GDALRasterIO( mRasterBandH, GF_Write, tileX, tileY, width, height, tile.data(), width, height,
+                       GDT_Float32, 0, sizeof( float ) * KDE_TILE_SIZE ) != CE_None )
+    {
+      result = false;
+    }
+    mTileWritten[ tileIdx ] = true;
+    tile = QVector< float >();
+  }
+  mCachedTileCount = 0;
   return result;
 }
 
-QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
+QgsKernelDensityEstimation::KernelFootprint QgsKernelDensityEstimation::footprint( double radius ) const
 {
-  GDALClose( ( GDALDatasetH ) mDatasetH );
-  mDatasetH = nullptr;
-  mRasterBandH = nullptr;
-  return Success;
+  KernelFootprint footprint;
+  footprint.shape = mShape;
+  footprint.radius = radius;
+  footprint.squaredRadius = radius * radius;
+  footprint.buffer = radiusSizeInPixels( radius );
+  // all kernels have their maximum value at distance 0
+  footprint.scale = calculateKernelValue( 0.0, radius, mShape, mOutputValues );
+  footprint.decay = mDecay;
+  return footprint;
 }
 
 int QgsKernelDensityEstimation::radiusSizeInPixels( double radius ) const
@@ -18,6 +18,7 @@
 
 #include "qgsrectangle.h"
 #include <QString>
+#include <QVector>
 
 // GDAL includes
 #include <gdal.h>
@@ -161,14 +162,91 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
     double mDecay;
     OutputValues mOutputValues;
 
-    int mBufferSize;
-
     GDALDatasetH mDatasetH;
     GDALRasterBandH mRasterBandH;
 
+    //! A point waiting to be added to the surface
+    struct PendingPoint
+    {
+      double x;
+      double y;
+      double weight;
+      //! Index of the kernel footprint of the point
+      int footprint;
+    };
+
+    /**
+     * Kernel shape and output type combination with its constants precomputed for a radius,
+     * so that only the squared distance is needed for each pixel.
+     */
+    struct KernelFootprint
+    {
+      KernelShape shape;
+      double radius;
+      double squaredRadius;
+      //! Radius in pixels
+      int buffer;
+      //! Value of the kernel at distance 0, including the normalizing constant
+      double scale;
+      //! Decay ratio, for triangular kernels
+      double decay;
+    };
+
+    //! Adds the points of a batch to the tiles which are touched by their kernels
+    struct AddPointsWrapper
+    {
+      QgsKernelDensityEstimation *instance = nullptr;
+
+      explicit AddPointsWrapper( QgsKernelDensityEstimation *_instance )
+        : instance( _instance )
+      {}
+
+      void operator()( int tileIdx );
+    };
+
+    int mRows;
+    int mColumns;
+    int mTileColumns;
+    int mTileRows;
+
+    //! Cached tiles of the output raster, empty if a tile is not in memory
+    QVector< QVector< float > > mTiles;
+    //! True for tiles which have been written to the output raster before
+    QVector< bool > mTileWritten;
+    //! Number of tiles in memory
+    int mCachedTileCount;
+    //! Maximum number of tiles kept in memory before they are written to the output raster
+    int mMaxCachedTiles;
+    //! Number of points which are collected before they are added to the tiles
+    int mBatchPoints;
+
+    //! Points which have not been added to the tiles yet
+    QVector< PendingPoint > mPendingPoints;
+    //! Indices of the pending points touching each tile
+    QVector< QVector< int > > mTilePoints;
+
+    //! Footprints used by the pending points. For a fixed radius this is a single footprint.
+    QVector< KernelFootprint > mFootprints;
+
     //! Creates a new raster layer and initializes it to the no data value
     bool createEmptyLayer( GDALDriverH driver, const QgsRectangle &bounds, int rows, int columns ) const;
     int radiusSizeInPixels( double radius ) const;
+
+    //! Precomputes the kernel constants for a radius
+    KernelFootprint footprint( double radius ) const;
+
+    //! Adds the pending points to the tiles, using worker threads
+    Result addPendingPoints();
+    //! Adds the pending points touching a tile to the tile
+    void addPointsToTile( int tileIdx );
+    //! Adds a single point to a tile, evaluating the kernel for each pixel within the radius
+    template <KernelShape Shape> void addPointToTile( const PendingPoint &point, const KernelFootprint &footprint, int tileIdx );
+    //! Loads a tile into memory, from the output raster if it has been written before
+    bool loadTile( int tileIdx );
+    //! Writes all cached tiles to the output raster and removes them from memory
+    bool writeTiles();
+
+    friend class TestQgsKde;
 };
 
 
@@ -20,6 +20,10 @@
 #include "cpl_string.h"
 #include <QProgressDialog>
 #include <QFile>
+#include <QtConcurrentMap>
+
+//! Number of raster rows which are read, processed and written as one block
+static const int NINE_CELL_BLOCK_HEIGHT = 128;
 
 QgsNineCellFilter::QgsNineCellFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : mInputFile( inputFile )
@@ -96,12 +100,14 @@ int QgsNineCellFilter::processRaster( QProgressDialog *p )
     return 6;
   }
 
-  //keep only three scanlines in memory at a time
-  float *scanLine1 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float *scanLine2 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float *scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-
-  float *resultLine = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+  //the raster is processed in blocks of NINE_CELL_BLOCK_HEIGHT rows. Every block is read with one row above and below it
+  //and every row is padded with a nodata cell on the left and right side, so that the rows of the block can be
+  //processed independently (and concurrently) without special handling of the border cells
+  const int paddedXSize = xSize + 2;
+  QVector<float> inputBlock( ( NINE_CELL_BLOCK_HEIGHT + 2 ) * paddedXSize );
+  QVector<float> resultBlock( NINE_CELL_BLOCK_HEIGHT * xSize );
+  QVector<int> rows;
+  rows.reserve( NINE_CELL_BLOCK_HEIGHT );
 
   if ( p )
   {
@@ -109,11 +115,11 @@ int QgsNineCellFilter::processRaster( QProgressDialog *p )
   }
 
   //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
-  for ( int i = 0; i < ySize; ++i )
+  for ( int blockTop = 0; blockTop < ySize; blockTop += NINE_CELL_BLOCK_HEIGHT )
   {
     if ( p )
     {
-      p->setValue( i );
+      p->setValue( blockTop );
     }
 
     if ( p && p->wasCanceled() )
@@ -121,62 +127,27 @@ int QgsNineCellFilter::processRaster( QProgressDialog *p )
       break;
     }
 
-    if ( i == 0 )
-    {
-      //fill scanline 1 with (input) nodata for the values above the first row and feed scanline2 with the first row
-      for ( int a = 0; a < xSize; ++a )
-      {
-        scanLine1[a] = mInputNodataValue;
-      }
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, 0, xSize, 1, scanLine2, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( "Raster IO Error" );
-      }
-    }
-    else
-    {
-      //normally fetch only scanLine3 and release scanline 1 if we move forward one row
-      CPLFree( scanLine1 );
-      scanLine1 = scanLine2;
-      scanLine2 = scanLine3;
-      scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-    }
+    int blockHeight = std::min( NINE_CELL_BLOCK_HEIGHT, ySize - blockTop );
+    inputBlock.fill( mInputNodataValue );
 
-    if ( i == ySize - 1 ) //fill the row below the bottom with nodata values
-    {
-      for ( int a = 0; a < xSize; ++a )
-      {
-        scanLine3[a] = mInputNodataValue;
-      }
-    }
-    else
+    //fetch the block including the neighbouring rows. Rows above the first and below the last raster row stay nodata
+    int firstRow = std::max( 0, blockTop - 1 );
+    int lastRow = std::min( ySize - 1, blockTop + blockHeight );
+    float *firstRowStart = inputBlock.data() + ( firstRow - blockTop + 1 ) * paddedXSize + 1;
+    if ( GDALRasterIO( rasterBand, GF_Read, 0, firstRow, xSize, lastRow - firstRow + 1, firstRowStart, xSize, lastRow - firstRow + 1,
+                       GDT_Float32, 0, sizeof( float ) * paddedXSize ) != CE_None )
     {
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, i + 1, xSize, 1, scanLine3, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( "Raster IO Error" );
-      }
+      QgsDebugMsg( "Raster IO Error" );
     }
 
-    for ( int j = 0; j < xSize; ++j )
+    rows.resize( blockHeight );
+    for ( int i = 0; i < blockHeight; ++i )
     {
-      if ( j == 0 )
-      {
-        resultLine[j] = processNineCellWindow( &mInputNodataValue, &scanLine1[j], &scanLine1[j + 1], &mInputNodataValue, &scanLine2[j],
-                                               &scanLine2[j + 1], &mInputNodataValue, &scanLine3[j], &scanLine3[j + 1] );
-      }
-      else if ( j == xSize - 1 )
-      {
-        resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &mInputNodataValue, &scanLine2[j - 1], &scanLine2[j],
-                                               &mInputNodataValue, &scanLine3[j - 1], &scanLine3[j], &mInputNodataValue );
-      }
-      else
-      {
-        resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &scanLine1[j + 1], &scanLine2[j - 1], &scanLine2[j],
-                                               &scanLine2[j + 1], &scanLine3[j - 1], &scanLine3[j], &scanLine3[j + 1] );
-      }
+      rows[i] = i;
     }
+    QtConcurrent::blockingMap( rows, ProcessRowWrapper( this, inputBlock.data(), resultBlock.data(), xSize ) );
 
-    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, i, xSize, 1, resultLine, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
+    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, blockTop, xSize, blockHeight, resultBlock.data(), xSize, blockHeight, GDT_Float32, 0, 0 ) != CE_None )
     {
       QgsDebugMsg( "Raster IO Error" );
     }
@@ -187,11 +158,6 @@ int QgsNineCellFilter::processRaster( QProgressDialog *p )
     p->setValue( ySize );
   }
 
-  CPLFree( resultLine );
-  CPLFree( scanLine1 );
-  CPLFree( scanLine2 );
-  CPLFree( scanLine3 );
-
   GDALClose( inputDataset );
 
   if ( p && p->wasCanceled() )
@@ -205,6 +171,24 @@ int QgsNineCellFilter::processRaster( QProgressDialog *p )
   return 0;
 }
 
+void QgsNineCellFilter::processNineCellRow( float *rowAbove, float *rowCurrent, float *rowBelow, float *resultRow, int xSize )
+{
+  for ( int j = 0; j < xSize; ++j )
+  {
+    resultRow[j] = processNineCellWindow( &rowAbove[j], &rowAbove[j + 1], &rowAbove[j + 2],
+                                          &rowCurrent[j], &rowCurrent[j + 1], &rowCurrent[j + 2],
+                                          &rowBelow[j], &rowBelow[j + 1], &rowBelow[j + 2] );
+  }
+}
+
+void QgsNineCellFilter::ProcessRowWrapper::operator()( int row )
+{
+  //row 0 of the block is stored in the second row of the input block, after the row above the block
+  const int paddedXSize = xSize + 2;
+  float *rowAbove = inputBlock + row * paddedXSize;
+  instance->processNineCellRow( rowAbove, rowAbove + paddedXSize, rowAbove + 2 * paddedXSize, resultBlock + row * xSize, xSize );
+}
+
 GDALDatasetH QgsNineCellFilter::openInputFile( int &nCellsX, int &nCellsY )
 {
   GDALDatasetH inputDataset = GDALOpen( mInputFile.toUtf8().constData(), GA_ReadOnly );
@@ -60,10 +60,37 @@ class ANALYSIS_EXPORT QgsNineCellFilter
                                          float *x12, float *x22, float *x32,
                                          float *x13, float *x23, float *x33 ) = 0;
 
+    /**
+     * Calculates a whole row of output values. \a rowAbove, \a rowCurrent and \a rowBelow each hold \a xSize + 2 values:
+     * the cells of one raster row with an (input) nodata value prepended and appended for the cells outside of the
+     * raster border. \a resultRow receives \a xSize output values.
+     * The default implementation calls processNineCellWindow() for every cell. Subclasses may reimplement this method
+     * to calculate a row in one pass without a virtual call per cell.
+     * \note rows are processed concurrently from several threads, so implementations must not modify the filter state.
+     * \since QGIS 3.0
+     */
+    virtual void processNineCellRow( float *rowAbove, float *rowCurrent, float *rowBelow, float *resultRow, int xSize );
+
   private:
     //default constructor forbidden. We need input file, output file and format obligatory
     QgsNineCellFilter();
 
+    //! Processes a single row of a block, used from the worker threads
+    struct ProcessRowWrapper
+    {
+      QgsNineCellFilter *instance = nullptr;
+      float *inputBlock = nullptr;
+      float *resultBlock = nullptr;
+      int xSize = 0;
+      explicit ProcessRowWrapper( QgsNineCellFilter *_instance, float *inputBlock, float *resultBlock, int xSize )
+        : instance( _instance )
+        , inputBlock( inputBlock )
+        , resultBlock( resultBlock )
+        , xSize( xSize )
+      {}
+      void operator()( int row );
+    };
+
     //! Opens the input file and returns the dataset handle and the number of pixels in x-/y- direction
     GDALDatasetH openInputFile( int &nCellsX, int &nCellsY );
 
@@ -85,13 +85,27 @@ QgsRasterCalcNode::~QgsRasterCalcNode()
 
 bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData, QgsRasterMatrix &result, int row ) const
 {
-  //if type is raster ref: return a copy of the corresponding matrix
+  QList<QgsRasterMatrix *> scratch;
+  bool ok = calculate( rasterData, result, row, scratch, 0 );
+  qDeleteAll( scratch );
+  return ok;
+}
+
+bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData, QgsRasterMatrix &result, int row, QList<QgsRasterMatrix *> &scratch ) const
+{
+  return calculate( rasterData, result, row, scratch, 0 );
+}
+
+bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData, QgsRasterMatrix &result, int row, QList<QgsRasterMatrix *> &scratch, int depth ) const
+{
+  //if type is raster ref: copy the corresponding block values into the result
 
   //if type is operator, call the proper matrix operations
   if ( mType == tRasterRef )
   {
-    QMap<QString, QgsRasterBlock *>::iterator it = rasterData.find( mRasterName );
-    if ( it == rasterData.end() )
+    //constFind, as this may be called from several threads at once
+    QMap<QString, QgsRasterBlock *>::const_iterator it = rasterData.constFind( mRasterName );
+    if ( it == rasterData.constEnd() )
     {
       return false;
     }
@@ -100,8 +114,9 @@ bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData,
     int startRow = ( row >= 0 ? row : 0 );
     int endRow = startRow + nRows;
     int nCols = ( *it )->width();
-    int nEntries = nCols * nRows;
-    double *data = new double[nEntries];
+    result.resize( nCols, nRows );
+    double *data = result.data();
+    const double nodataValue = result.nodataValue();
 
     //convert input raster values to double, also convert input no data to result no data
 
@@ -110,122 +125,129 @@ bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData,
     {
       for ( int dataCol = 0; dataCol < nCols; ++dataCol )
       {
-        data[ dataCol + nCols * outRow] = ( *it )->isNoData( dataRow, dataCol ) ? result.nodataValue() : ( *it )->value( dataRow, dataCol );
+        data[ dataCol + nCols * outRow] = ( *it )->isNoData( dataRow, dataCol ) ? nodataValue : ( *it )->value( dataRow, dataCol );
       }
     }
-    result.setData( nCols, nRows, data, result.nodataValue() );
     return true;
   }
   else if ( mType == tOperator )
   {
-    QgsRasterMatrix leftMatrix, rightMatrix;
-    leftMatrix.setNodataValue( result.nodataValue() );
-    rightMatrix.setNodataValue( result.nodataValue() );
-
-    if ( !mLeft || !mLeft->calculate( rasterData, leftMatrix, row ) )
+    //the left operand is calculated directly into the result, the right one into a scratch matrix.
+    //Nodes below the right operand use the following scratch matrices, so they don't overwrite it
+    const double nodataValue = result.nodataValue();
+    if ( !mLeft || !mLeft->calculate( rasterData, result, row, scratch, depth ) )
     {
       return false;
     }
-    if ( mRight && !mRight->calculate( rasterData, rightMatrix, row ) )
+
+    QgsRasterMatrix *rightMatrix = nullptr;
+    if ( mRight )
     {
-      return false;
+      while ( scratch.size() <= depth )
+      {
+        scratch.append( new QgsRasterMatrix() );
+      }
+      rightMatrix = scratch.at( depth );
+      rightMatrix->setNodataValue( nodataValue );
+      if ( !mRight->calculate( rasterData, *rightMatrix, row, scratch, depth + 1 ) )
+      {
+        return false;
+      }
     }
 
+    QgsRasterMatrix emptyMatrix;
+    const QgsRasterMatrix &other = rightMatrix ? *rightMatrix : emptyMatrix;
     switch ( mOperator )
     {
       case opPLUS:
-        leftMatrix.add( rightMatrix );
+        result.add( other );
         break;
       case opMINUS:
-        leftMatrix.subtract( rightMatrix );
+        result.subtract( other );
         break;
       case opMUL:
-        leftMatrix.multiply( rightMatrix );
+        result.multiply( other );
         break;
       case opDIV:
-        leftMatrix.divide( rightMatrix );
+        result.divide( other );
         break;
       case opPOW:
-        leftMatrix.power( rightMatrix );
+        result.power( other );
         break;
       case opEQ:
-        leftMatrix.equal( rightMatrix );
+        result.equal( other );
         break;
       case opNE:
-        leftMatrix.notEqual( rightMatrix );
+        result.notEqual( other );
         break;
       case opGT:
-        leftMatrix.greaterThan( rightMatrix );
+        result.greaterThan( other );
         break;
       case opLT:
-        leftMatrix.lesserThan( rightMatrix );
+        result.lesserThan( other );
         break;
       case opGE:
-        leftMatrix.greaterEqual( rightMatrix );
+        result.greaterEqual( other );
         break;
       case opLE:
-        leftMatrix.lesserEqual( rightMatrix );
+        result.lesserEqual( other );
         break;
       case opAND:
-        leftMatrix.logicalAnd( rightMatrix );
+        result.logicalAnd( other );
         break;
       case opOR:
-        leftMatrix.logicalOr( rightMatrix );
+        result.logicalOr( other );
         break;
       case opSQRT:
-        leftMatrix.squareRoot();
+        result.squareRoot();
         break;
       case opSIN:
-        leftMatrix.sinus();
+        result.sinus();
         break;
       case opCOS:
-        leftMatrix.cosinus();
+        result.cosinus();
         break;
       case opTAN:
-        leftMatrix.tangens();
+        result.tangens();
         break;
       case opASIN:
-        leftMatrix.asinus();
+        result.asinus();
         break;
       case opACOS:
-        leftMatrix.acosinus();
+        result.acosinus();
         break;
       case opATAN:
-        leftMatrix.atangens();
+        result.atangens();
         break;
       case opSIGN:
-        leftMatrix.changeSign();
+        result.changeSign();
         break;
       case opLOG:
-        leftMatrix.log();
+        result.log();
         break;
       case opLOG10:
-        leftMatrix.log10();
+        result.log10();
         break;
       default:
         return false;
     }
-    int newNColumns = leftMatrix.nColumns();
-    int newNRows = leftMatrix.nRows();
-    result.setData( newNColumns, newNRows, leftMatrix.takeData(), leftMatrix.nodataValue() );
     return true;
   }
   else if ( mType == tNumber )
   {
-    double *data = new double[1];
-    data[0] = mNumber;
-    result.setData( 1, 1, data, result.nodataValue() );
+    result.resize( 1, 1 );
+    result.data()[0] = mNumber;
     return true;
   }
   else if ( mType == tMatrix )
   {
     int nEntries = mMatrix->nColumns() * mMatrix->nRows();
-    double *data = new double[nEntries];
+    result.resize( mMatrix->nColumns(), mMatrix->nRows() );
+    double *data = result.data();
     for ( int i = 0; i < nEntries; ++i )
     {
       data[i] = mMatrix->data()[i] == mMatrix->nodataValue() ? result.nodataValue() : mMatrix->data()[i];
     }
-    result.setData( mMatrix->nColumns(), mMatrix->nRows(), data, result.nodataValue() );
     return true;
   }
   return false;
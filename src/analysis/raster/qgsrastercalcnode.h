@@ -19,6 +19,7 @@
 #ifndef QGSRASTERCALCNODE_H
 #define QGSRASTERCALCNODE_H
 
+#include <QList>
 #include <QMap>
 #include "qgis_sip.h"
 #include "qgis.h"
@@ -100,9 +101,26 @@ class ANALYSIS_EXPORT QgsRasterCalcNode
      */
     bool calculate( QMap<QString, QgsRasterBlock * > &rasterData, QgsRasterMatrix &result, int row = -1 ) const SIP_SKIP;
 
+    /** Calculates result of raster calculation, using the matrices in \a scratch for the intermediate results.
+     * Missing scratch matrices are created and appended to the list, the caller keeps their ownership. Reusing
+     * the same result and scratch matrices for many rows avoids allocating new matrices for every node and row.
+     * This method only reads from the nodes and raster data, so it can be called concurrently from several threads
+     * as long as every thread uses its own result and scratch matrices.
+     * \param rasterData input raster data references, map of raster name to raster data block
+     * \param result destination raster matrix for calculation results
+     * \param row row number to calculate, or -1 to calculate entire result
+     * \param scratch intermediate matrices
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    bool calculate( QMap<QString, QgsRasterBlock * > &rasterData, QgsRasterMatrix &result, int row, QList<QgsRasterMatrix *> &scratch ) const SIP_SKIP;
+
     static QgsRasterCalcNode *parseRasterCalcString( const QString &str, QString &parserErrorMsg ) SIP_FACTORY;
 
   private:
+    //! Calculates the result, using scratch matrices from index \a depth on for the intermediate results
+    bool calculate( QMap<QString, QgsRasterBlock * > &rasterData, QgsRasterMatrix &result, int row, QList<QgsRasterMatrix *> &scratch, int depth ) const;
+
     Type mType;
     QgsRasterCalcNode *mLeft = nullptr;
     QgsRasterCalcNode *mRight = nullptr;
@@ -25,6 +25,8 @@
 
 #include <QProgressDialog>
 #include <QFile>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include <cpl_string.h>
 #include <gdalwarper.h>
@@ -56,6 +58,56 @@ QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QS
 {
 }
 
+///@cond PRIVATE
+
+//! Approximate number of cells which are read and calculated as one tile
+static const int RASTER_CALC_TILE_CELLS = 1 << 20;
+
+namespace
+{
+  //! Range of tile rows which is calculated by one thread
+  struct RowRange
+  {
+    int startRow;
+    int endRow;
+  };
+
+  //! Calculates a range of rows of the current tile, reusing the matrices for all rows of the range
+  struct ProcessRowsWrapper
+  {
+    const QgsRasterCalcNode *node = nullptr;
+    QMap< QString, QgsRasterBlock * > *inputBlocks = nullptr;
+    float *result = nullptr;
+    int nColumns = 0;
+    float nodataValue = 0;
+    void operator()( const RowRange &range ) const
+    {
+      QgsRasterMatrix resultMatrix;
+      resultMatrix.setNodataValue( nodataValue );
+      QList< QgsRasterMatrix * > scratch;
+
+      for ( int i = range.startRow; i < range.endRow; ++i )
+      {
+        float *calcData = result + i * nColumns;
+        if ( !node->calculate( *inputBlocks, resultMatrix, i, scratch ) )
+        {
+          std::fill( calcData, calcData + nColumns, nodataValue );
+          continue;
+        }
+
+        bool resultIsNumber = resultMatrix.isNumber();
+        for ( int j = 0; j < nColumns; ++j )
+        {
+          calcData[j] = ( float )( resultIsNumber ? resultMatrix.number() : resultMatrix.data()[j] );
+        }
+      }
+      qDeleteAll( scratch );
+    }
+  };
+}
+
+///@endcond
+
 int QgsRasterCalculator::processCalculation( QProgressDialog *p )
 {
   //prepare search string / tree
@@ -67,46 +119,21 @@ int QgsRasterCalculator::processCalculation( QProgressDialog *p )
     return static_cast<int>( ParserError );
   }
 
-  QMap< QString, QgsRasterBlock * > inputBlocks;
   QVector<QgsRasterCalculatorEntry>::const_iterator it = mRasterEntries.constBegin();
   for ( ; it != mRasterEntries.constEnd(); ++it )
   {
     if ( !it->raster ) // no raster layer in entry
     {
       delete calcNode;
-      qDeleteAll( inputBlocks );
       return static_cast< int >( InputLayerError );
     }
-
-    QgsRasterBlock *block = nullptr;
-    // if crs transform needed
-    if ( it->raster->crs() != mOutputCrs )
-    {
-      QgsRasterProjector proj;
-      proj.setCrs( it->raster->crs(), mOutputCrs );
-      proj.setInput( it->raster->dataProvider() );
-      proj.setPrecision( QgsRasterProjector::Exact );
-
-      block = proj.block( it->bandNumber, mOutputRectangle, mNumOutputColumns, mNumOutputRows );
-    }
-    else
-    {
-      block = it->raster->dataProvider()->block( it->bandNumber, mOutputRectangle, mNumOutputColumns, mNumOutputRows );
-    }
-    if ( block->isEmpty() )
-    {
-      delete block;
-      delete calcNode;
-      qDeleteAll( inputBlocks );
-      return static_cast<int>( MemoryError );
-    }
-    inputBlocks.insert( it->ref, block );
   }
 
   //open output dataset for writing
   GDALDriverH outputDriver = openOutputDriver();
   if ( !outputDriver )
   {
+    delete calcNode;
     return static_cast< int >( CreateOutputError );
   }
 
@@ -122,15 +149,18 @@ int QgsRasterCalculator::processCalculation( QProgressDialog *p )
     p->setMaximum( mNumOutputRows );
   }
 
-  QgsRasterMatrix resultMatrix;
-  resultMatrix.setNodataValue( outputNodataValue );
+  //the output is calculated in tiles of full rows. The input blocks are only read for the current tile
+  //and the rows of a tile are calculated concurrently
+  const int tileRows = qBound( 1, RASTER_CALC_TILE_CELLS / qMax( 1, mNumOutputColumns ), qMax( 1, mNumOutputRows ) );
+  const double rowHeight = mOutputRectangle.height() / mNumOutputRows;
+  const int nThreads = qMax( 1, QThread::idealThreadCount() );
+  QVector<float> tileData( tileRows * mNumOutputColumns );
 
-  //read / write line by line
-  for ( int i = 0; i < mNumOutputRows; ++i )
+  for ( int tileTop = 0; tileTop < mNumOutputRows; tileTop += tileRows )
   {
     if ( p )
     {
-      p->setValue( i );
+      p->setValue( tileTop );
     }
 
     if ( p && p->wasCanceled() )
@@ -138,25 +168,65 @@ int QgsRasterCalculator::processCalculation( QProgressDialog *p )
       break;
     }
 
-    if ( calcNode->calculate( inputBlocks, resultMatrix, i ) )
+    int nRows = qMin( tileRows, mNumOutputRows - tileTop );
+    QgsRectangle tileExtent( mOutputRectangle.xMinimum(), mOutputRectangle.yMaximum() - ( tileTop + nRows ) * rowHeight,
+                             mOutputRectangle.xMaximum(), mOutputRectangle.yMaximum() - tileTop * rowHeight );
+
+    QMap< QString, QgsRasterBlock * > inputBlocks;
+    for ( it = mRasterEntries.constBegin(); it != mRasterEntries.constEnd(); ++it )
     {
-      bool resultIsNumber = resultMatrix.isNumber();
-      float *calcData = new float[mNumOutputColumns];
+      QgsRasterBlock *block = nullptr;
+      // if crs transform needed
+      if ( it->raster->crs() != mOutputCrs )
+      {
+        QgsRasterProjector proj;
+        proj.setCrs( it->raster->crs(), mOutputCrs );
+        proj.setInput( it->raster->dataProvider() );
+        proj.setPrecision( QgsRasterProjector::Exact );
 
-      for ( int j = 0; j < mNumOutputColumns; ++j )
+        block = proj.block( it->bandNumber, tileExtent, mNumOutputColumns, nRows );
+      }
+      else
       {
-        calcData[j] = ( float )( resultIsNumber ? resultMatrix.number() : resultMatrix.data()[j] );
+        block = it->raster->dataProvider()->block( it->bandNumber, tileExtent, mNumOutputColumns, nRows );
       }
-
-      //write scanline to the dataset
-      if ( GDALRasterIO( outputRasterBand, GF_Write, 0, i, mNumOutputColumns, 1, calcData, mNumOutputColumns, 1, GDT_Float32, 0, 0 ) != CE_None )
+      if ( block->isEmpty() )
       {
-        QgsDebugMsg( "RasterIO error!" );
+        delete block;
+        delete calcNode;
+        qDeleteAll( inputBlocks );
+        GDALClose( outputDataset );
+        return static_cast<int>( MemoryError );
       }
+      inputBlocks.insert( it->ref, block );
+    }
 
-      delete[] calcData;
+    //split the tile into a few row ranges per thread, so that the load is balanced between the threads
+    QVector< RowRange > ranges;
+    int rangeRows = qMax( 1, nRows / ( 4 * nThreads ) );
+    for ( int startRow = 0; startRow < nRows; startRow += rangeRows )
+    {
+      RowRange range;
+      range.startRow = startRow;
+      range.endRow = qMin( startRow + rangeRows, nRows );
+      ranges << range;
     }
 
+    ProcessRowsWrapper wrapper;
+    wrapper.node = calcNode;
+    wrapper.inputBlocks = &inputBlocks;
+    wrapper.result = tileData.data();
+    wrapper.nColumns = mNumOutputColumns;
+    wrapper.nodataValue = outputNodataValue;
+    QtConcurrent::blockingMap( ranges, wrapper );
+
+    qDeleteAll( inputBlocks );
+
+    //write the tile to the dataset
+    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, tileTop, mNumOutputColumns, nRows, tileData.data(), mNumOutputColumns, nRows, GDT_Float32, 0, 0 ) != CE_None )
+    {
+      QgsDebugMsg( "RasterIO error!" );
+    }
   }
 
   if ( p )
@@ -166,8 +236,6 @@ int QgsRasterCalculator::processCalculation( QProgressDialog *p )
 
   //close datasets and release memory
   delete calcNode;
-  qDeleteAll( inputBlocks );
-  inputBlocks.clear();
 
   if ( p && p->wasCanceled() )
   {
@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsrastermatrix.h"
+#include <algorithm>
 #include <cstring>
 #include <qmath.h>
 
@@ -31,6 +32,7 @@ QgsRasterMatrix::QgsRasterMatrix( int nCols, int nRows, double *data, double nod
   : mColumns( nCols )
   , mRows( nRows )
   , mData( data )
+  , mCapacity( nCols * nRows )
   , mNodataValue( nodataValue )
 {
 }
@@ -55,6 +57,7 @@ QgsRasterMatrix &QgsRasterMatrix::operator=( const QgsRasterMatrix &m )
   mRows = m.nRows();
   int nEntries = mColumns * mRows;
   mData = new double[nEntries];
+  mCapacity = nEntries;
   memcpy( mData, m.mData, sizeof( double ) * nEntries );
   mNodataValue = m.nodataValue();
   return *this;
@@ -66,15 +69,30 @@ void QgsRasterMatrix::setData( int cols, int rows, double *data, double nodataVa
   mColumns = cols;
   mRows = rows;
   mData = data;
+  mCapacity = cols * rows;
   mNodataValue = nodataValue;
 }
 
+void QgsRasterMatrix::resize( int cols, int rows )
+{
+  int nEntries = cols * rows;
+  if ( nEntries > mCapacity )
+  {
+    delete[] mData;
+    mData = new double[nEntries];
+    mCapacity = nEntries;
+  }
+  mColumns = cols;
+  mRows = rows;
+}
+
 double *QgsRasterMatrix::takeData()
 {
   double *data = mData;
   mData = nullptr;
   mColumns = 0;
   mRows = 0;
+  mCapacity = 0;
   return data;
 }
 
@@ -193,6 +211,20 @@ bool QgsRasterMatrix::log10()
   return oneArgumentOperation( opLOG10 );
 }
 
+template <typename F>
+void QgsRasterMatrix::applyOneArgumentOperation( F f )
+{
+  //work on local copies, so that the compiler does not need to assume that writing entries changes the members
+  double *data = mData;
+  const int nEntries = mColumns * mRows;
+  const double nodataValue = mNodataValue;
+  for ( int i = 0; i < nEntries; ++i )
+  {
+    const double value = data[i];
+    data[i] = value == nodataValue ? nodataValue : f( value, nodataValue );
+  }
+}
+
 bool QgsRasterMatrix::oneArgumentOperation( OneArgOperator op )
 {
   if ( !mData )
@@ -200,68 +232,40 @@ bool QgsRasterMatrix::oneArgumentOperation( OneArgOperator op )
     return false;
   }
 
-  int nEntries = mColumns * mRows;
-  double value;
-  for ( int i = 0; i < nEntries; ++i )
+  //choose the operation once per matrix instead of once per entry, so that the loops can be vectorized
+  switch ( op )
   {
-    value = mData[i];
-    if ( value != mNodataValue )
-    {
-      switch ( op )
-      {
-        case opSQRT:
-          if ( value < 0 ) //no complex numbers
-          {
-            mData[i] = mNodataValue;
-          }
-          else
-          {
-            mData[i] = sqrt( value );
-          }
-          break;
-        case opSIN:
-          mData[i] = sin( value );
-          break;
-        case opCOS:
-          mData[i] = cos( value );
-          break;
-        case opTAN:
-          mData[i] = tan( value );
-          break;
-        case opASIN:
-          mData[i] = asin( value );
-          break;
-        case opACOS:
-          mData[i] = acos( value );
-          break;
-        case opATAN:
-          mData[i] = atan( value );
-          break;
-        case opSIGN:
-          mData[i] = -value;
-          break;
-        case opLOG:
-          if ( value <= 0 )
-          {
-            mData[i] = mNodataValue;
-          }
-          else
-          {
-            mData[i] = ::log( value );
-          }
-          break;
-        case opLOG10:
-          if ( value <= 0 )
-          {
-            mData[i] = mNodataValue;
-          }
-          else
-          {
-            mData[i] = ::log10( value );
-          }
-          break;
-      }
-    }
+    case opSQRT:
+      //no complex numbers
+      applyOneArgumentOperation( []( double value, double nodataValue ) { return value < 0 ? nodataValue : sqrt( value ); } );
+      break;
+    case opSIN:
+      applyOneArgumentOperation( []( double value, double ) { return sin( value ); } );
+      break;
+    case opCOS:
+      applyOneArgumentOperation( []( double value, double ) { return cos( value ); } );
+      break;
+    case opTAN:
+      applyOneArgumentOperation( []( double value, double ) { return tan( value ); } );
+      break;
+    case opASIN:
+      applyOneArgumentOperation( []( double value, double ) { return asin( value ); } );
+      break;
+    case opACOS:
+      applyOneArgumentOperation( []( double value, double ) { return acos( value ); } );
+      break;
+    case opATAN:
+      applyOneArgumentOperation( []( double value, double ) { return atan( value ); } );
+      break;
+    case opSIGN:
+      applyOneArgumentOperation( []( double value, double ) { return -value; } );
+      break;
+    case opLOG:
+      applyOneArgumentOperation( []( double value, double nodataValue ) { return value <= 0 ? nodataValue : ::log( value ); } );
+      break;
+    case opLOG10:
+      applyOneArgumentOperation( []( double value, double nodataValue ) { return value <= 0 ? nodataValue : ::log10( value ); } );
+      break;
   }
   return true;
 }
@@ -314,103 +318,126 @@ double QgsRasterMatrix::calculateTwoArgumentOp( TwoArgOperator op, double arg1,
   return mNodataValue;
 }
 
-bool QgsRasterMatrix::twoArgumentOperation( TwoArgOperator op, const QgsRasterMatrix &other )
+template <typename F>
+void QgsRasterMatrix::applyTwoArgumentOperation( const QgsRasterMatrix &other, F f )
 {
-  if ( isNumber() && other.isNumber() ) //operation on two 1x1 matrices
+  //operations with nodata values always generate nodata
+  if ( !isNumber() && !other.isNumber() ) //two matrices
   {
-    //operations with nodata values always generate nodata
-    if ( mData[0] == mNodataValue || other.number() == other.nodataValue() )
-    {
-      mData[0] = mNodataValue;
-    }
-    else
-    {
-      mData[0] = calculateTwoArgumentOp( op, mData[0], other.number() );
-    }
-    return true;
-  }
-
-  //two matrices
-  if ( !isNumber() && !other.isNumber() )
-  {
-    double *matrix = other.mData;
-    int nEntries = mColumns * mRows;
-    double value1, value2;
-
+    double *data = mData;
+    const double *otherData = other.mData;
+    const int nEntries = mColumns * mRows;
+    const double nodataValue = mNodataValue;
+    const double otherNodataValue = other.mNodataValue;
     for ( int i = 0; i < nEntries; ++i )
     {
-      value1 = mData[i];
-      value2 = matrix[i];
-      if ( value1 == mNodataValue || value2 == other.mNodataValue )
-      {
-        mData[i] = mNodataValue;
-      }
-      else
-      {
-        mData[i] = calculateTwoArgumentOp( op, value1, value2 );
-      }
+      const double value1 = data[i];
+      const double value2 = otherData[i];
+      data[i] = ( value1 == nodataValue || value2 == otherNodataValue ) ? nodataValue : f( value1, value2, nodataValue );
     }
-    return true;
   }
-
-  //this matrix is a single number and the other one a real matrix
-  if ( isNumber() )
+  else if ( isNumber() ) //this matrix is a single number and the other one a real matrix
   {
-    double *matrix = other.mData;
-    int nEntries = other.nColumns() * other.nRows();
-    double value = mData[0];
-    delete[] mData;
-    mData = new double[nEntries];
-    mColumns = other.nColumns();
-    mRows = other.nRows();
+    const double value = mData[0];
+    resize( other.nColumns(), other.nRows() );
     mNodataValue = other.nodataValue();
 
-    if ( value == mNodataValue )
+    double *data = mData;
+    const double *otherData = other.mData;
+    const int nEntries = mColumns * mRows;
+    const double nodataValue = mNodataValue;
+    if ( value == nodataValue )
     {
-      for ( int i = 0; i < nEntries; ++i )
-      {
-        mData[i] = mNodataValue;
-      }
-      return true;
+      std::fill( data, data + nEntries, nodataValue );
+      return;
     }
 
     for ( int i = 0; i < nEntries; ++i )
     {
-      if ( matrix[i] == other.mNodataValue )
-      {
-        mData[i] = mNodataValue;
-        continue;
-      }
-
-      mData[i] = calculateTwoArgumentOp( op, value, matrix[i] );
+      const double value2 = otherData[i];
+      data[i] = value2 == nodataValue ? nodataValue : f( value, value2, nodataValue );
     }
-    return true;
   }
   else //this matrix is a real matrix and the other a number
   {
-    double value = other.number();
-    int nEntries = mColumns * mRows;
-
-    if ( other.number() == other.mNodataValue )
+    double *data = mData;
+    const int nEntries = mColumns * mRows;
+    const double nodataValue = mNodataValue;
+    const double value = other.number();
+    if ( value == other.mNodataValue )
     {
-      for ( int i = 0; i < nEntries; ++i )
-      {
-        mData[i] = mNodataValue;
-      }
-      return true;
+      std::fill( data, data + nEntries, nodataValue );
+      return;
     }
 
     for ( int i = 0; i < nEntries; ++i )
     {
-      if ( mData[i] == mNodataValue )
-      {
-        continue;
-      }
+      const double value1 = data[i];
+      data[i] = value1 == nodataValue ? nodataValue : f( value1, value, nodataValue );
+    }
+  }
+}
 
-      mData[i] = calculateTwoArgumentOp( op, mData[i], value );
+bool QgsRasterMatrix::twoArgumentOperation( TwoArgOperator op, const QgsRasterMatrix &other )
+{
+  if ( isNumber() && other.isNumber() ) //operation on two 1x1 matrices
+  {
+    //operations with nodata values always generate nodata
+    if ( mData[0] == mNodataValue || other.number() == other.nodataValue() )
+    {
+      mData[0] = mNodataValue;
+    }
+    else
+    {
+      mData[0] = calculateTwoArgumentOp( op, mData[0], other.number() );
     }
     return true;
   }
+
+  //choose the operation once per matrix instead of once per entry, so that the loops can be vectorized
+  switch ( op )
+  {
+    case opPLUS:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 + arg2; } );
+      break;
+    case opMINUS:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 - arg2; } );
+      break;
+    case opMUL:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 * arg2; } );
+      break;
+    case opDIV:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double nodataValue ) { return arg2 == 0 ? nodataValue : arg1 / arg2; } );
+      break;
+    case opPOW:
+      applyTwoArgumentOperation( other, [this]( double arg1, double arg2, double nodataValue ) { return testPowerValidity( arg1, arg2 ) ? qPow( arg1, arg2 ) : nodataValue; } );
+      break;
+    case opEQ:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 == arg2 ? 1.0 : 0.0; } );
+      break;
+    case opNE:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 == arg2 ? 0.0 : 1.0; } );
+      break;
+    case opGT:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 > arg2 ? 1.0 : 0.0; } );
+      break;
+    case opLT:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 < arg2 ? 1.0 : 0.0; } );
+      break;
+    case opGE:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 >= arg2 ? 1.0 : 0.0; } );
+      break;
+    case opLE:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 <= arg2 ? 1.0 : 0.0; } );
+      break;
+    case opAND:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 && arg2 ? 1.0 : 0.0; } );
+      break;
+    case opOR:
+      applyTwoArgumentOperation( other, []( double arg1, double arg2, double ) { return arg1 || arg2 ? 1.0 : 0.0; } );
+      break;
+  }
+  return true;
 }
 
 bool QgsRasterMatrix::testPowerValidity( double base, double power ) const
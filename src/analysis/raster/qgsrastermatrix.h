@@ -79,6 +79,14 @@ class ANALYSIS_EXPORT QgsRasterMatrix
 
     void setData( int cols, int rows, double *data, double nodataValue );
 
+    /** Resizes the matrix to \a cols x \a rows entries. The data array is only reallocated if it is too small
+     * for the new number of entries, so a matrix can be reused for many calculations without new allocations.
+     * Entry values are undefined after resizing.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void resize( int cols, int rows ) SIP_SKIP;
+
     int nColumns() const { return mColumns; }
     int nRows() const { return mRows; }
 
@@ -117,14 +125,21 @@ class ANALYSIS_EXPORT QgsRasterMatrix
     int mColumns;
     int mRows;
     double *mData = nullptr;
+    //! Number of entries allocated for mData, may be larger than mColumns * mRows
+    int mCapacity = 0;
     double mNodataValue;
 
     //! +,-,*,/,^,<,>,<=,>=,=,!=, and, or
     bool twoArgumentOperation( TwoArgOperator op, const QgsRasterMatrix &other );
     double calculateTwoArgumentOp( TwoArgOperator op, double arg1, double arg2 ) const;
 
+    //! Applies a two argument function to the entries of this matrix and a matrix or number with nodata handling
+    template <typename F> void applyTwoArgumentOperation( const QgsRasterMatrix &other, F f );
+
     /*sqrt, sin, cos, tan, asin, acos, atan*/
     bool oneArgumentOperation( OneArgOperator op );
+    //! Applies a one argument function to all entries of this matrix which are not nodata
+    template <typename F> void applyOneArgumentOperation( F f );
     bool testPowerValidity( double base, double power ) const;
 };
 
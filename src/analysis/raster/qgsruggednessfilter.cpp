@@ -86,3 +86,13 @@ float QgsRuggednessFilter::processNineCellWindow( float *x11, float *x21, float
   return sqrt( sum );
 }
 
+void QgsRuggednessFilter::processNineCellRow( float *rowAbove, float *rowCurrent, float *rowBelow, float *resultRow, int xSize )
+{
+  //qualified call, so that the compiler can inline the window calculation
+  for ( int j = 0; j < xSize; ++j )
+  {
+    resultRow[j] = QgsRuggednessFilter::processNineCellWindow( &rowAbove[j], &rowAbove[j + 1], &rowAbove[j + 2],
+                   &rowCurrent[j], &rowCurrent[j + 1], &rowCurrent[j + 2],
+                   &rowBelow[j], &rowBelow[j + 1], &rowBelow[j + 2] );
+  }
+}
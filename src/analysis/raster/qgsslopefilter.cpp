@@ -17,6 +17,8 @@
 
 #include "qgsslopefilter.h"
 
+#include <QVector>
+
 QgsSlopeFilter::QgsSlopeFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : QgsDerivativeFilter( inputFile, outputFile, outputFormat )
 {
@@ -37,3 +39,20 @@ float QgsSlopeFilter::processNineCellWindow( float *x11, float *x21, float *x31,
   return atan( sqrt( derX * derX + derY * derY ) ) * 180.0 / M_PI;
 }
 
+void QgsSlopeFilter::processNineCellRow( float *rowAbove, float *rowCurrent, float *rowBelow, float *resultRow, int xSize )
+{
+  //the derivatives in x-direction are stored in the result row and replaced by the slope values
+  QVector<float> derY( xSize );
+  calcFirstDerRow( rowAbove, rowCurrent, rowBelow, resultRow, derY.data(), xSize );
+
+  for ( int j = 0; j < xSize; ++j )
+  {
+    float derX = resultRow[j];
+    if ( derX == mOutputNodataValue || derY[j] == mOutputNodataValue )
+    {
+      resultRow[j] = mOutputNodataValue;
+      continue;
+    }
+    resultRow[j] = atan( sqrt( derX * derX + derY[j] * derY[j] ) ) * 180.0 / M_PI;
+  }
+}
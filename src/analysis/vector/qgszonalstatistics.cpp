@@ -28,10 +28,138 @@
 
 #include <QProgressDialog>
 #include <QFile>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+
+///@cond PRIVATE
+
+//! Maximum number of features which are read and then processed concurrently
+static const int ZONAL_STATS_BATCH_FEATURES = 1000;
+//! Maximum number of raster cells which are held in memory for a batch
+static const qint64 ZONAL_STATS_BATCH_CELLS = 16 * 1024 * 1024;
+
+struct QgsZonalStatistics::FeatureJob
+{
+  QgsFeatureId id;
+  QgsGeometry geometry;
+  //! Position of the top left cell in the raster
+  int offsetX = 0;
+  int offsetY = 0;
+  int nCellsX = 0;
+  int nCellsY = 0;
+  //! One block per raster band
+  QList< QgsRasterBlock * > blocks;
+  QgsAttributeMap attributes;
+};
+
+namespace
+{
+  //! Description of the field created for a statistic
+  struct StatisticField
+  {
+    QgsZonalStatistics::Statistic statistic;
+    const char *name;
+    QVariant::Type type;
+    const char *typeName;
+  };
+
+  const StatisticField STATISTIC_FIELDS[] =
+  {
+    { QgsZonalStatistics::Count, "count", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::Sum, "sum", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::Mean, "mean", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::Median, "median", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::StDev, "stdev", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::Min, "min", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::Max, "max", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::Range, "range", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::Minority, "minority", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::Majority, "majority", QVariant::Double, "double precision" },
+    { QgsZonalStatistics::Variety, "variety", QVariant::Int, "int" },
+  };
+
+  //! Returns the polygons of a (multi)polygon geometry
+  QgsMultiPolygon polygonsFromGeometry( const QgsGeometry &geometry )
+  {
+    if ( geometry.isMultipart() )
+      return geometry.asMultiPolygon();
+
+    QgsMultiPolygon polygons;
+    QgsPolygon polygon = geometry.asPolygon();
+    if ( !polygon.isEmpty() )
+      polygons << polygon;
+    return polygons;
+  }
+
+  //! Clips a ring against one side of a rectangle (one step of the Sutherland-Hodgman algorithm)
+  template <typename Inside, typename Intersect>
+  void clipRing( const QVector<QgsPoint> &in, QVector<QgsPoint> &out, Inside inside, Intersect intersect )
+  {
+    out.clear();
+    if ( in.isEmpty() )
+      return;
+
+    QgsPoint previous = in.last();
+    bool previousInside = inside( previous );
+    for ( const QgsPoint &current : in )
+    {
+      bool currentInside = inside( current );
+      if ( currentInside != previousInside )
+        out << intersect( previous, current );
+      if ( currentInside )
+        out << current;
+      previous = current;
+      previousInside = currentInside;
+    }
+  }
+
+  //! Returns the area of the part of a ring which is inside a rectangle
+  double clippedRingArea( const QgsPolyline &ring, const QgsRectangle &rect, QVector<QgsPoint> &buffer1, QVector<QgsPoint> &buffer2 )
+  {
+    //the rings are closed, the clipping works on open rings
+    buffer1 = ring;
+    if ( buffer1.size() > 1 && buffer1.first() == buffer1.last() )
+      buffer1.removeLast();
+
+    const double xMin = rect.xMinimum();
+    const double xMax = rect.xMaximum();
+    const double yMin = rect.yMinimum();
+    const double yMax = rect.yMaximum();
+
+    clipRing( buffer1, buffer2, [xMin]( const QgsPoint & p ) { return p.x() >= xMin; },
+              [xMin]( const QgsPoint & p1, const QgsPoint & p2 ) { return QgsPoint( xMin, p1.y() + ( xMin - p1.x() ) * ( p2.y() - p1.y() ) / ( p2.x() - p1.x() ) ); } );
+    clipRing( buffer2, buffer1, [xMax]( const QgsPoint & p ) { return p.x() <= xMax; },
+              [xMax]( const QgsPoint & p1, const QgsPoint & p2 ) { return QgsPoint( xMax, p1.y() + ( xMax - p1.x() ) * ( p2.y() - p1.y() ) / ( p2.x() - p1.x() ) ); } );
+    clipRing( buffer1, buffer2, [yMin]( const QgsPoint & p ) { return p.y() >= yMin; },
+              [yMin]( const QgsPoint & p1, const QgsPoint & p2 ) { return QgsPoint( p1.x() + ( yMin - p1.y() ) * ( p2.x() - p1.x() ) / ( p2.y() - p1.y() ), yMin ); } );
+    clipRing( buffer2, buffer1, [yMax]( const QgsPoint & p ) { return p.y() <= yMax; },
+              [yMax]( const QgsPoint & p1, const QgsPoint & p2 ) { return QgsPoint( p1.x() + ( yMax - p1.y() ) * ( p2.x() - p1.x() ) / ( p2.y() - p1.y() ), yMax ); } );
+
+    //shoelace formula
+    double area = 0;
+    int n = buffer1.size();
+    for ( int i = 0, j = n - 1; i < n; j = i++ )
+    {
+      area += ( buffer1.at( j ).x() - buffer1.at( i ).x() ) * ( buffer1.at( j ).y() + buffer1.at( i ).y() );
+    }
+    return qAbs( area ) / 2.0;
+  }
+}
+
+///@endcond
 
 QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QString &attributePrefix, int rasterBand, Statistics stats )
   : mRasterLayer( rasterLayer )
-  , mRasterBand( rasterBand )
+  , mRasterBands( QList<int>() << rasterBand )
+  , mPolygonLayer( polygonLayer )
+  , mAttributePrefix( attributePrefix )
+  , mStatistics( stats )
+{}
+
+QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QList<int> &rasterBands, const QString &attributePrefix, Statistics stats )
+  : mRasterLayer( rasterLayer )
+  , mRasterBands( rasterBands )
   , mPolygonLayer( polygonLayer )
   , mAttributePrefix( attributePrefix )
   , mStatistics( stats )
@@ -55,138 +183,76 @@ int QgsZonalStatistics::calculateStatistics( QProgressDialog *p )
     return 3;
   }
 
-  if ( mRasterLayer->bandCount() < mRasterBand )
+  if ( mRasterBands.isEmpty() )
   {
     return 4;
   }
+  Q_FOREACH ( int band, mRasterBands )
+  {
+    if ( band < 1 || mRasterLayer->bandCount() < band )
+    {
+      return 4;
+    }
+  }
 
   mRasterProvider = mRasterLayer->dataProvider();
-  mInputNodataValue = mRasterProvider->sourceNoDataValue( mRasterBand );
+  mInputNodataValues.clear();
+  Q_FOREACH ( int band, mRasterBands )
+  {
+    mInputNodataValues << mRasterProvider->sourceNoDataValue( band );
+  }
 
   //get geometry info about raster layer
   int nCellsXProvider = mRasterProvider->xSize();
   int nCellsYProvider = mRasterProvider->ySize();
-  double cellsizeX = mRasterLayer->rasterUnitsPerPixelX();
-  if ( cellsizeX < 0 )
+  mCellSizeX = mRasterLayer->rasterUnitsPerPixelX();
+  if ( mCellSizeX < 0 )
   {
-    cellsizeX = -cellsizeX;
+    mCellSizeX = -mCellSizeX;
   }
-  double cellsizeY = mRasterLayer->rasterUnitsPerPixelY();
-  if ( cellsizeY < 0 )
+  mCellSizeY = mRasterLayer->rasterUnitsPerPixelY();
+  if ( mCellSizeY < 0 )
   {
-    cellsizeY = -cellsizeY;
+    mCellSizeY = -mCellSizeY;
   }
-  QgsRectangle rasterBBox = mRasterProvider->extent();
+  mRasterBBox = mRasterProvider->extent();
 
   //add the new fields to the provider
   QList<QgsField> newFieldList;
-  QString countFieldName;
-  if ( mStatistics & QgsZonalStatistics::Count )
-  {
-    countFieldName = getUniqueFieldName( mAttributePrefix + "count", newFieldList );
-    QgsField countField( countFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( countField );
-  }
-  QString sumFieldName;
-  if ( mStatistics & QgsZonalStatistics::Sum )
-  {
-    sumFieldName = getUniqueFieldName( mAttributePrefix + "sum", newFieldList );
-    QgsField sumField( sumFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( sumField );
-  }
-  QString meanFieldName;
-  if ( mStatistics & QgsZonalStatistics::Mean )
-  {
-    meanFieldName = getUniqueFieldName( mAttributePrefix + "mean", newFieldList );
-    QgsField meanField( meanFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( meanField );
-  }
-  QString medianFieldName;
-  if ( mStatistics & QgsZonalStatistics::Median )
-  {
-    medianFieldName = getUniqueFieldName( mAttributePrefix + "median", newFieldList );
-    QgsField medianField( medianFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( medianField );
-  }
-  QString stdevFieldName;
-  if ( mStatistics & QgsZonalStatistics::StDev )
-  {
-    stdevFieldName = getUniqueFieldName( mAttributePrefix + "stdev", newFieldList );
-    QgsField stdField( stdevFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( stdField );
-  }
-  QString minFieldName;
-  if ( mStatistics & QgsZonalStatistics::Min )
-  {
-    minFieldName = getUniqueFieldName( mAttributePrefix + "min", newFieldList );
-    QgsField minField( minFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( minField );
-  }
-  QString maxFieldName;
-  if ( mStatistics & QgsZonalStatistics::Max )
-  {
-    maxFieldName = getUniqueFieldName( mAttributePrefix + "max", newFieldList );
-    QgsField maxField( maxFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( maxField );
-  }
-  QString rangeFieldName;
-  if ( mStatistics & QgsZonalStatistics::Range )
-  {
-    rangeFieldName = getUniqueFieldName( mAttributePrefix + "range", newFieldList );
-    QgsField rangeField( rangeFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( rangeField );
-  }
-  QString minorityFieldName;
-  if ( mStatistics & QgsZonalStatistics::Minority )
-  {
-    minorityFieldName = getUniqueFieldName( mAttributePrefix + "minority", newFieldList );
-    QgsField minorityField( minorityFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( minorityField );
-  }
-  QString majorityFieldName;
-  if ( mStatistics & QgsZonalStatistics::Majority )
-  {
-    majorityFieldName = getUniqueFieldName( mAttributePrefix + "majority", newFieldList );
-    QgsField majField( majorityFieldName, QVariant::Double, QStringLiteral( "double precision" ) );
-    newFieldList.push_back( majField );
-  }
-  QString varietyFieldName;
-  if ( mStatistics & QgsZonalStatistics::Variety )
+  QList< QMap< QgsZonalStatistics::Statistic, QString > > fieldNames;
+  Q_FOREACH ( int band, mRasterBands )
   {
-    varietyFieldName = getUniqueFieldName( mAttributePrefix + "variety", newFieldList );
-    QgsField varietyField( varietyFieldName, QVariant::Int, QStringLiteral( "int" ) );
-    newFieldList.push_back( varietyField );
+    QString prefix = mRasterBands.size() > 1 ? mAttributePrefix + QString::number( band ) + '_' : mAttributePrefix;
+    QMap< QgsZonalStatistics::Statistic, QString > bandFieldNames;
+    for ( const StatisticField &statisticField : STATISTIC_FIELDS )
+    {
+      if ( !( mStatistics & statisticField.statistic ) )
+        continue;
+
+      QString fieldName = getUniqueFieldName( prefix + statisticField.name, newFieldList );
+      newFieldList.push_back( QgsField( fieldName, statisticField.type, QString( statisticField.typeName ) ) );
+      bandFieldNames.insert( statisticField.statistic, fieldName );
+    }
+    fieldNames << bandFieldNames;
   }
   vectorProvider->addAttributes( newFieldList );
 
   //index of the new fields
-  int countIndex = mStatistics & QgsZonalStatistics::Count ? vectorProvider->fieldNameIndex( countFieldName ) : -1;
-  int sumIndex = mStatistics & QgsZonalStatistics::Sum ? vectorProvider->fieldNameIndex( sumFieldName ) : -1;
-  int meanIndex = mStatistics & QgsZonalStatistics::Mean ? vectorProvider->fieldNameIndex( meanFieldName ) : -1;
-  int medianIndex = mStatistics & QgsZonalStatistics::Median ? vectorProvider->fieldNameIndex( medianFieldName ) : -1;
-  int stdevIndex = mStatistics & QgsZonalStatistics::StDev ? vectorProvider->fieldNameIndex( stdevFieldName ) : -1;
-  int minIndex = mStatistics & QgsZonalStatistics::Min ? vectorProvider->fieldNameIndex( minFieldName ) : -1;
-  int maxIndex = mStatistics & QgsZonalStatistics::Max ? vectorProvider->fieldNameIndex( maxFieldName ) : -1;
-  int rangeIndex = mStatistics & QgsZonalStatistics::Range ? vectorProvider->fieldNameIndex( rangeFieldName ) : -1;
-  int minorityIndex = mStatistics & QgsZonalStatistics::Minority ? vectorProvider->fieldNameIndex( minorityFieldName ) : -1;
-  int majorityIndex = mStatistics & QgsZonalStatistics::Majority ? vectorProvider->fieldNameIndex( majorityFieldName ) : -1;
-  int varietyIndex = mStatistics & QgsZonalStatistics::Variety ? vectorProvider->fieldNameIndex( varietyFieldName ) : -1;
-
-  if ( ( mStatistics & QgsZonalStatistics::Count && countIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Sum && sumIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Mean && meanIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Median && medianIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::StDev && stdevIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Min && minIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Max && maxIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Range && rangeIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Minority && minorityIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Majority && majorityIndex == -1 )
-       || ( mStatistics & QgsZonalStatistics::Variety && varietyIndex == -1 )
-     )
+  mFieldIndices.clear();
+  for ( const QMap< QgsZonalStatistics::Statistic, QString > &bandFieldNames : fieldNames )
   {
-    //failed to create a required field
-    return 8;
+    StatisticFieldIndices bandFieldIndices;
+    for ( auto it = bandFieldNames.constBegin(); it != bandFieldNames.constEnd(); ++it )
+    {
+      int index = vectorProvider->fieldNameIndex( it.value() );
+      if ( index == -1 )
+      {
+        //failed to create a required field
+        return 8;
+      }
+      bandFieldIndices.insert( it.key(), index );
+    }
+    mFieldIndices << bandFieldIndices;
   }
 
   //progress dialog
@@ -202,16 +268,12 @@ int QgsZonalStatistics::calculateStatistics( QProgressDialog *p )
   QgsFeatureIterator fi = vectorProvider->getFeatures( request );
   QgsFeature f;
 
-  bool statsStoreValues = ( mStatistics & QgsZonalStatistics::Median ) ||
-                          ( mStatistics & QgsZonalStatistics::StDev );
-  bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Minority ) ||
-                              ( mStatistics & QgsZonalStatistics::Majority );
-
-  FeatureStats featureStats( statsStoreValues, statsStoreValueCount );
   int featureCounter = 0;
+  bool hasMoreFeatures = true;
 
   QgsChangedAttributesMap changeMap;
-  while ( fi.nextFeature( f ) )
+  QVector< FeatureJob > jobs;
+  while ( hasMoreFeatures )
   {
     if ( p )
     {
@@ -223,114 +285,69 @@ int QgsZonalStatistics::calculateStatistics( QProgressDialog *p )
       break;
     }
 
-    if ( !f.hasGeometry() )
-    {
-      ++featureCounter;
-      continue;
-    }
-    QgsGeometry featureGeometry = f.geometry();
-
-    QgsRectangle featureRect = featureGeometry.boundingBox().intersect( &rasterBBox );
-    if ( featureRect.isEmpty() )
+    //read the polygons and raster blocks of a batch of features. Reading is done in this thread, as
+    //data providers must not be used from several threads
+    jobs.clear();
+    qint64 batchCells = 0;
+    while ( jobs.size() < ZONAL_STATS_BATCH_FEATURES && batchCells < ZONAL_STATS_BATCH_CELLS )
     {
+      if ( !fi.nextFeature( f ) )
+      {
+        hasMoreFeatures = false;
+        break;
+      }
       ++featureCounter;
-      continue;
-    }
 
-    int offsetX, offsetY, nCellsX, nCellsY;
-    if ( cellInfoForBBox( rasterBBox, featureRect, cellsizeX, cellsizeY, offsetX, offsetY, nCellsX, nCellsY ) != 0 )
-    {
-      ++featureCounter;
-      continue;
-    }
+      if ( !f.hasGeometry() )
+      {
+        continue;
+      }
 
-    //avoid access to cells outside of the raster (may occur because of rounding)
-    if ( ( offsetX + nCellsX ) > nCellsXProvider )
-    {
-      nCellsX = nCellsXProvider - offsetX;
-    }
-    if ( ( offsetY + nCellsY ) > nCellsYProvider )
-    {
-      nCellsY = nCellsYProvider - offsetY;
-    }
+      FeatureJob job;
+      job.id = f.id();
+      job.geometry = f.geometry();
 
-    statisticsFromMiddlePointTest( featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                   rasterBBox, featureStats );
+      QgsRectangle featureRect = job.geometry.boundingBox().intersect( &mRasterBBox );
+      if ( featureRect.isEmpty() )
+      {
+        continue;
+      }
 
-    if ( featureStats.count <= 1 )
-    {
-      //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
-      statisticsFromPreciseIntersection( featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                         rasterBBox, featureStats );
-    }
+      if ( cellInfoForBBox( mRasterBBox, featureRect, mCellSizeX, mCellSizeY, job.offsetX, job.offsetY, job.nCellsX, job.nCellsY ) != 0 )
+      {
+        continue;
+      }
 
-    //write the statistics value to the vector data provider
-    QgsAttributeMap changeAttributeMap;
-    if ( mStatistics & QgsZonalStatistics::Count )
-      changeAttributeMap.insert( countIndex, QVariant( featureStats.count ) );
-    if ( mStatistics & QgsZonalStatistics::Sum )
-      changeAttributeMap.insert( sumIndex, QVariant( featureStats.sum ) );
-    if ( featureStats.count > 0 )
-    {
-      double mean = featureStats.sum / featureStats.count;
-      if ( mStatistics & QgsZonalStatistics::Mean )
-        changeAttributeMap.insert( meanIndex, QVariant( mean ) );
-      if ( mStatistics & QgsZonalStatistics::Median )
+      //avoid access to cells outside of the raster (may occur because of rounding)
+      if ( ( job.offsetX + job.nCellsX ) > nCellsXProvider )
       {
-        std::sort( featureStats.values.begin(), featureStats.values.end() );
-        int size =  featureStats.values.count();
-        bool even = ( size % 2 ) < 1;
-        double medianValue;
-        if ( even )
-        {
-          medianValue = ( featureStats.values.at( size / 2 - 1 ) + featureStats.values.at( size / 2 ) ) / 2;
-        }
-        else //odd
-        {
-          medianValue = featureStats.values.at( ( size + 1 ) / 2 - 1 );
-        }
-        changeAttributeMap.insert( medianIndex, QVariant( medianValue ) );
+        job.nCellsX = nCellsXProvider - job.offsetX;
       }
-      if ( mStatistics & QgsZonalStatistics::StDev )
+      if ( ( job.offsetY + job.nCellsY ) > nCellsYProvider )
       {
-        double sumSquared = 0;
-        for ( int i = 0; i < featureStats.values.count(); ++i )
-        {
-          double diff = featureStats.values.at( i ) - mean;
-          sumSquared += diff * diff;
-        }
-        double stdev = qPow( sumSquared / featureStats.values.count(), 0.5 );
-        changeAttributeMap.insert( stdevIndex, QVariant( stdev ) );
+        job.nCellsY = nCellsYProvider - job.offsetY;
       }
-      if ( mStatistics & QgsZonalStatistics::Min )
-        changeAttributeMap.insert( minIndex, QVariant( featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Max )
-        changeAttributeMap.insert( maxIndex, QVariant( featureStats.max ) );
-      if ( mStatistics & QgsZonalStatistics::Range )
-        changeAttributeMap.insert( rangeIndex, QVariant( featureStats.max - featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority )
+
+      QgsRectangle intersectBBox = mRasterBBox.intersect( &featureRect );
+      Q_FOREACH ( int band, mRasterBands )
       {
-        QList<int> vals = featureStats.valueCount.values();
-        std::sort( vals.begin(), vals.end() );
-        if ( mStatistics & QgsZonalStatistics::Minority )
-        {
-          float minorityKey = featureStats.valueCount.key( vals.first() );
-          changeAttributeMap.insert( minorityIndex, QVariant( minorityKey ) );
-        }
-        if ( mStatistics & QgsZonalStatistics::Majority )
-        {
-          float majKey = featureStats.valueCount.key( vals.last() );
-          changeAttributeMap.insert( majorityIndex, QVariant( majKey ) );
-        }
+        job.blocks << mRasterProvider->block( band, intersectBBox, job.nCellsX, job.nCellsY );
       }
-      if ( mStatistics & QgsZonalStatistics::Variety )
-        changeAttributeMap.insert( varietyIndex, QVariant( featureStats.valueCount.count() ) );
+      batchCells += static_cast< qint64 >( job.nCellsX ) * job.nCellsY * mRasterBands.size();
+      jobs << job;
     }
 
-    changeMap.insert( f.id(), changeAttributeMap );
-    ++featureCounter;
+    //calculate the statistics of the independent polygons concurrently
+    QtConcurrent::blockingMap( jobs, ProcessFeatureWrapper( this ) );
+
+    for ( FeatureJob &job : jobs )
+    {
+      changeMap.insert( job.id, job.attributes );
+      qDeleteAll( job.blocks );
+    }
   }
 
+  //write the statistics values of all features to the vector data provider at once
   vectorProvider->changeAttributeValues( changeMap );
 
   if ( p )
@@ -348,6 +365,106 @@ int QgsZonalStatistics::calculateStatistics( QProgressDialog *p )
   return 0;
 }
 
+void QgsZonalStatistics::ProcessFeatureWrapper::operator()( FeatureJob &job )
+{
+  instance->processFeature( job );
+}
+
+void QgsZonalStatistics::processFeature( FeatureJob &job ) const
+{
+  bool statsStoreValues = ( mStatistics & QgsZonalStatistics::Median ) ||
+                          ( mStatistics & QgsZonalStatistics::StDev );
+  bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Minority ) ||
+                              ( mStatistics & QgsZonalStatistics::Majority );
+  FeatureStats featureStats( statsStoreValues, statsStoreValueCount );
+
+  //the cell coverage is the same for all bands, so it is only calculated once
+  QVector<double> middlePointCoverage;
+  QVector<double> preciseCoverage;
+  coverageFromMiddlePointTest( job, middlePointCoverage );
+
+  for ( int i = 0; i < job.blocks.size(); ++i )
+  {
+    statisticsFromCoverage( job.blocks.at( i ), mInputNodataValues.at( i ), middlePointCoverage, featureStats );
+
+    if ( featureStats.count <= 1 )
+    {
+      //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
+      if ( preciseCoverage.isEmpty() )
+      {
+        coverageFromPreciseIntersection( job, preciseCoverage );
+      }
+      statisticsFromCoverage( job.blocks.at( i ), mInputNodataValues.at( i ), preciseCoverage, featureStats );
+    }
+
+    writeStatistics( featureStats, mFieldIndices.at( i ), job.attributes );
+  }
+}
+
+void QgsZonalStatistics::writeStatistics( FeatureStats &featureStats, const StatisticFieldIndices &fieldIndices, QgsAttributeMap &changeAttributeMap ) const
+{
+  if ( mStatistics & QgsZonalStatistics::Count )
+    changeAttributeMap.insert( fieldIndices.value( Count ), QVariant( featureStats.count ) );
+  if ( mStatistics & QgsZonalStatistics::Sum )
+    changeAttributeMap.insert( fieldIndices.value( Sum ), QVariant( featureStats.sum ) );
+  if ( featureStats.count > 0 )
+  {
+    double mean = featureStats.sum / featureStats.count;
+    if ( mStatistics & QgsZonalStatistics::Mean )
+      changeAttributeMap.insert( fieldIndices.value( Mean ), QVariant( mean ) );
+    if ( mStatistics & QgsZonalStatistics::Median )
+    {
+      std::sort( featureStats.values.begin(), featureStats.values.end() );
+      int size =  featureStats.values.count();
+      bool even = ( size % 2 ) < 1;
+      double medianValue;
+      if ( even )
+      {
+        medianValue = ( featureStats.values.at( size / 2 - 1 ) + featureStats.values.at( size / 2 ) ) / 2;
+      }
+      else //odd
+      {
+        medianValue = featureStats.values.at( ( size + 1 ) / 2 - 1 );
+      }
+      changeAttributeMap.insert( fieldIndices.value( Median ), QVariant( medianValue ) );
+    }
+    if ( mStatistics & QgsZonalStatistics::StDev )
+    {
+      double sumSquared = 0;
+      for ( int i = 0; i < featureStats.values.count(); ++i )
+      {
+        double diff = featureStats.values.at( i ) - mean;
+        sumSquared += diff * diff;
+      }
+      double stdev = qPow( sumSquared / featureStats.values.count(), 0.5 );
+      changeAttributeMap.insert( fieldIndices.value( StDev ), QVariant( stdev ) );
+    }
+    if ( mStatistics & QgsZonalStatistics::Min )
+      changeAttributeMap.insert( fieldIndices.value( Min ), QVariant( featureStats.min ) );
+    if ( mStatistics & QgsZonalStatistics::Max )
+      changeAttributeMap.insert( fieldIndices.value( Max ), QVariant( featureStats.max ) );
+    if ( mStatistics & QgsZonalStatistics::Range )
+      changeAttributeMap.insert( fieldIndices.value( Range ), QVariant( featureStats.max - featureStats.min ) );
+    if ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority )
+    {
+      QList<int> vals = featureStats.valueCount.values();
+      std::sort( vals.begin(), vals.end() );
+      if ( mStatistics & QgsZonalStatistics::Minority )
+      {
+        float minorityKey = featureStats.valueCount.key( vals.first() );
+        changeAttributeMap.insert( fieldIndices.value( Minority ), QVariant( minorityKey ) );
+      }
+      if ( mStatistics & QgsZonalStatistics::Majority )
+      {
+        float majKey = featureStats.valueCount.key( vals.last() );
+        changeAttributeMap.insert( fieldIndices.value( Majority ), QVariant( majKey ) );
+      }
+    }
+    if ( mStatistics & QgsZonalStatistics::Variety )
+      changeAttributeMap.insert( fieldIndices.value( Variety ), QVariant( featureStats.valueCount.count() ) );
+  }
+}
+
 int QgsZonalStatistics::cellInfoForBBox( const QgsRectangle &rasterBBox, const QgsRectangle &featureBBox, double cellSizeX, double cellSizeY,
     int &offsetX, int &offsetY, int &nCellsX, int &nCellsY ) const
 {
@@ -375,116 +492,116 @@ int QgsZonalStatistics::cellInfoForBBox( const QgsRectangle &rasterBBox, const Q
   return 0;
 }
 
-void QgsZonalStatistics::statisticsFromMiddlePointTest( const QgsGeometry &poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats )
+void QgsZonalStatistics::coverageFromMiddlePointTest( const FeatureJob &job, QVector<double> &coverage ) const
 {
-  double cellCenterX, cellCenterY;
+  coverage.fill( 0.0, job.nCellsX * job.nCellsY );
 
-  cellCenterY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
-  stats.reset();
+  QgsMultiPolygon polygons = polygonsFromGeometry( job.geometry );
+  double originX = mRasterBBox.xMinimum() + job.offsetX * mCellSizeX;
+  double cellCenterY = mRasterBBox.yMaximum() - job.offsetY * mCellSizeY - mCellSizeY / 2;
 
-  GEOSGeometry *polyGeos = poly.exportToGeos();
-  if ( !polyGeos )
+  //for each row, the intersections of the line through the cell centers with the polygon rings are
+  //calculated. Following the even-odd rule, the cells between two consecutive intersections are inside
+  QVector<double> intersections;
+  for ( int i = 0; i < job.nCellsY; ++i, cellCenterY -= mCellSizeY )
   {
-    return;
-  }
+    intersections.clear();
+    for ( const QgsPolygon &polygon : polygons )
+    {
+      for ( const QgsPolyline &ring : polygon )
+      {
+        for ( int k = 1; k < ring.size(); ++k )
+        {
+          const QgsPoint &p1 = ring.at( k - 1 );
+          const QgsPoint &p2 = ring.at( k );
+          if ( ( p1.y() > cellCenterY ) != ( p2.y() > cellCenterY ) )
+          {
+            intersections << p1.x() + ( cellCenterY - p1.y() ) * ( p2.x() - p1.x() ) / ( p2.y() - p1.y() );
+          }
+        }
+      }
+    }
+    std::sort( intersections.begin(), intersections.end() );
 
-  GEOSContextHandle_t geosctxt = QgsGeometry::getGEOSHandler();
-  const GEOSPreparedGeometry *polyGeosPrepared = GEOSPrepare_r( geosctxt, polyGeos );
-  if ( !polyGeosPrepared )
-  {
-    GEOSGeom_destroy_r( geosctxt, polyGeos );
-    return;
+    double *rowCoverage = coverage.data() + i * job.nCellsX;
+    for ( int k = 0; k + 1 < intersections.size(); k += 2 )
+    {
+      //cells with a center strictly between the two intersections
+      int firstColumn = qMax( 0, static_cast< int >( std::floor( ( intersections.at( k ) - originX ) / mCellSizeX - 0.5 ) ) + 1 );
+      int lastColumn = qMin( job.nCellsX - 1, static_cast< int >( std::ceil( ( intersections.at( k + 1 ) - originX ) / mCellSizeX - 0.5 ) ) - 1 );
+      for ( int j = firstColumn; j <= lastColumn; ++j )
+      {
+        rowCoverage[j] = 1.0;
+      }
+    }
   }
+}
 
-  GEOSCoordSequence *cellCenterCoords = nullptr;
-  GEOSGeometry *currentCellCenter = nullptr;
+void QgsZonalStatistics::coverageFromPreciseIntersection( const FeatureJob &job, QVector<double> &coverage ) const
+{
+  coverage.fill( 0.0, job.nCellsX * job.nCellsY );
 
-  QgsRectangle featureBBox = poly.boundingBox().intersect( &rasterBBox );
-  QgsRectangle intersectBBox = rasterBBox.intersect( &featureBBox );
+  QgsMultiPolygon polygons = polygonsFromGeometry( job.geometry );
+  double pixelArea = mCellSizeX * mCellSizeY;
+  double originX = mRasterBBox.xMinimum() + job.offsetX * mCellSizeX;
+  double originY = mRasterBBox.yMaximum() - job.offsetY * mCellSizeY;
 
-  QgsRasterBlock *block = mRasterProvider->block( mRasterBand, intersectBBox, nCellsX, nCellsY );
-  for ( int i = 0; i < nCellsY; ++i )
+  QVector<QgsPoint> buffer1;
+  QVector<QgsPoint> buffer2;
+  for ( int i = 0; i < job.nCellsY; ++i )
   {
-    cellCenterX = rasterBBox.xMinimum() + pixelOffsetX * cellSizeX + cellSizeX / 2;
-    for ( int j = 0; j < nCellsX; ++j )
+    for ( int j = 0; j < job.nCellsX; ++j )
     {
-      if ( validPixel( block->value( i, j ) ) )
+      QgsRectangle cellRect( originX + j * mCellSizeX, originY - ( i + 1 ) * mCellSizeY,
+                             originX + ( j + 1 ) * mCellSizeX, originY - i * mCellSizeY );
+
+      //area of the exterior rings minus the area of the holes
+      double intersectionArea = 0;
+      for ( const QgsPolygon &polygon : polygons )
       {
-        GEOSGeom_destroy_r( geosctxt, currentCellCenter );
-        cellCenterCoords = GEOSCoordSeq_create_r( geosctxt, 1, 2 );
-        GEOSCoordSeq_setX_r( geosctxt, cellCenterCoords, 0, cellCenterX );
-        GEOSCoordSeq_setY_r( geosctxt, cellCenterCoords, 0, cellCenterY );
-        currentCellCenter = GEOSGeom_createPoint_r( geosctxt, cellCenterCoords );
-        if ( GEOSPreparedContains_r( geosctxt, polyGeosPrepared, currentCellCenter ) )
+        for ( int ringIndex = 0; ringIndex < polygon.size(); ++ringIndex )
         {
-          stats.addValue( block->value( i, j ) );
+          double ringArea = clippedRingArea( polygon.at( ringIndex ), cellRect, buffer1, buffer2 );
+          intersectionArea += ringIndex == 0 ? ringArea : -ringArea;
         }
       }
-      cellCenterX += cellSizeX;
+      coverage[i * job.nCellsX + j] = qMax( 0.0, intersectionArea / pixelArea );
     }
-    cellCenterY -= cellSizeY;
   }
-
-  GEOSGeom_destroy_r( geosctxt, currentCellCenter );
-  GEOSPreparedGeom_destroy_r( geosctxt, polyGeosPrepared );
-  GEOSGeom_destroy_r( geosctxt, polyGeos );
-  delete block;
 }
 
-void QgsZonalStatistics::statisticsFromPreciseIntersection( const QgsGeometry &poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats )
+void QgsZonalStatistics::statisticsFromCoverage( QgsRasterBlock *block, float nodataValue, const QVector<double> &coverage, FeatureStats &stats ) const
 {
   stats.reset();
+  if ( !block )
+  {
+    return;
+  }
 
-  double currentY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
-  QgsGeometry pixelRectGeometry;
-
-  double hCellSizeX = cellSizeX / 2.0;
-  double hCellSizeY = cellSizeY / 2.0;
-  double pixelArea = cellSizeX * cellSizeY;
-  double weight = 0;
-
-  QgsRectangle featureBBox = poly.boundingBox().intersect( &rasterBBox );
-  QgsRectangle intersectBBox = rasterBBox.intersect( &featureBBox );
-
-  QgsRasterBlock *block = mRasterProvider->block( mRasterBand, intersectBBox, nCellsX, nCellsY );
+  int nCellsX = block->width();
+  int nCellsY = block->height();
   for ( int i = 0; i < nCellsY; ++i )
   {
-    double currentX = rasterBBox.xMinimum() + cellSizeX / 2.0 + pixelOffsetX * cellSizeX;
     for ( int j = 0; j < nCellsX; ++j )
     {
-      if ( !validPixel( block->value( i, j ) ) )
+      double weight = coverage.at( i * nCellsX + j );
+      if ( weight <= 0.0 )
       {
         continue;
       }
 
-      pixelRectGeometry = QgsGeometry::fromRect( QgsRectangle( currentX - hCellSizeX, currentY - hCellSizeY, currentX + hCellSizeX, currentY + hCellSizeY ) );
-      if ( !pixelRectGeometry.isNull() )
+      float value = block->value( i, j );
+      if ( validPixel( value, nodataValue ) )
       {
-        //intersection
-        QgsGeometry intersectGeometry = pixelRectGeometry.intersection( poly );
-        if ( !intersectGeometry.isNull() )
-        {
-          double intersectionArea = intersectGeometry.area();
-          if ( intersectionArea >= 0.0 )
-          {
-            weight = intersectionArea / pixelArea;
-            stats.addValue( block->value( i, j ), weight );
-          }
-        }
-        pixelRectGeometry = QgsGeometry();
+        stats.addValue( value, weight );
       }
-      currentX += cellSizeX;
     }
-    currentY -= cellSizeY;
   }
-  delete block;
 }
 
-bool QgsZonalStatistics::validPixel( float value ) const
+bool QgsZonalStatistics::validPixel( float value, float nodataValue ) const
 {
-  if ( value == mInputNodataValue || qIsNaN( value ) )
+  if ( value == nodataValue || qIsNaN( value ) )
   {
     return false;
   }
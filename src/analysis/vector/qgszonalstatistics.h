@@ -20,17 +20,19 @@
 
 #include <QString>
 #include <QMap>
+#include <QVector>
 #include <limits>
 #include <cfloat>
 #include "qgis_analysis.h"
+#include "qgsrectangle.h"
 
 class QgsGeometry;
 class QgsVectorLayer;
 class QgsRasterLayer;
 class QgsRasterDataProvider;
 class QProgressDialog;
-class QgsRectangle;
 class QgsField;
+class QgsRasterBlock;
 
 /** \ingroup analysis
  *  A class that calculates raster statistics (count, sum, mean) for a polygon or multipolygon layer and appends the results as attributes*/
@@ -62,7 +64,16 @@ class ANALYSIS_EXPORT QgsZonalStatistics
     QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QString &attributePrefix = "", int rasterBand = 1,
                         Statistics stats = Statistics( Count | Sum | Mean ) );
 
-    /** Starts the calculation
+    /**
+     * Constructor for QgsZonalStatistics which calculates the statistics of several raster bands in one pass.
+     * If more than one band is given, the band number is inserted between the attribute prefix and the
+     * statistic name of the new fields, e.g. "prefix2_mean" for the mean of band 2.
+     * \since QGIS 3.0
+     */
+    QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QList<int> &rasterBands, const QString &attributePrefix = "",
+                        Statistics stats = Statistics( Count | Sum | Mean ) );
+
+    /** Starts the calculation. The polygons are processed concurrently in batches.
       \returns 0 in case of success*/
     int calculateStatistics( QProgressDialog *p );
 
@@ -110,33 +121,67 @@ class ANALYSIS_EXPORT QgsZonalStatistics
         bool mStoreValueCounts;
     };
 
+    //! Polygon, raster cells and results of a single feature, processed by a worker thread
+    struct FeatureJob;
+
+    //! Field indices of the statistics of one raster band
+    typedef QMap< QgsZonalStatistics::Statistic, int > StatisticFieldIndices;
+
+    struct ProcessFeatureWrapper
+    {
+      const QgsZonalStatistics *instance = nullptr;
+      explicit ProcessFeatureWrapper( const QgsZonalStatistics *_instance )
+        : instance( _instance )
+      {}
+      void operator()( FeatureJob &job );
+    };
+
     /** Analysis what cells need to be considered to cover the bounding box of a feature
       \returns 0 in case of success*/
     int cellInfoForBBox( const QgsRectangle &rasterBBox, const QgsRectangle &featureBBox, double cellSizeX, double cellSizeY,
                          int &offsetX, int &offsetY, int &nCellsX, int &nCellsY ) const;
 
-    //! Returns statistics by considering the pixels where the center point is within the polygon (fast)
-    void statisticsFromMiddlePointTest( const QgsGeometry &poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                        double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats );
+    //! Calculates the statistics of all bands for the polygon of a job
+    void processFeature( FeatureJob &job ) const;
+
+    /** Sets the coverage of the cells whose center point is within the polygon to 1 (fast). The cells are found
+     * with a scanline fill of the polygon rings, so no geometry needs to be constructed and no point in polygon
+     * test is run per cell. A prepared geometry would not speed this up, as it only helps repeated GEOS predicates.
+     */
+    void coverageFromMiddlePointTest( const FeatureJob &job, QVector<double> &coverage ) const;
 
-    //! Returns statistics with precise pixel - polygon intersection test (slow)
-    void statisticsFromPreciseIntersection( const QgsGeometry &poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                            double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats );
+    /** Sets the coverage of each cell to the exact fraction of its area covered by the polygon. The polygon
+     * rings are clipped to each cell, which only needs to be done for small polygons.
+     */
+    void coverageFromPreciseIntersection( const FeatureJob &job, QVector<double> &coverage ) const;
+
+    //! Adds the values of the cells with a coverage > 0 to the statistics, weighted by the coverage
+    void statisticsFromCoverage( QgsRasterBlock *block, float nodataValue, const QVector<double> &coverage, FeatureStats &stats ) const;
+
+    //! Inserts the requested statistics into an attribute map
+    void writeStatistics( FeatureStats &stats, const StatisticFieldIndices &fieldIndices, QMap<int, QVariant> &attributes ) const;
 
     //! Tests whether a pixel's value should be included in the result
-    bool validPixel( float value ) const;
+    bool validPixel( float value, float nodataValue ) const;
 
     QString getUniqueFieldName( const QString &fieldName, const QList<QgsField> &newFields );
 
     QgsRasterLayer *mRasterLayer = nullptr;
     QgsRasterDataProvider *mRasterProvider = nullptr;
-    //! Raster band to calculate statistics
-    int mRasterBand = 0;
+    //! Raster bands to calculate statistics
+    QList<int> mRasterBands;
     QgsVectorLayer *mPolygonLayer = nullptr;
     QString mAttributePrefix;
-    //! The nodata value of the input layer
-    float mInputNodataValue = -1;
+    //! The nodata values of the input bands
+    QVector<float> mInputNodataValues;
     Statistics mStatistics = QgsZonalStatistics::All;
+
+    //! Raster geometry for the current calculation
+    QgsRectangle mRasterBBox;
+    double mCellSizeX = 0;
+    double mCellSizeY = 0;
+    //! Field indices for each raster band
+    QList< StatisticFieldIndices > mFieldIndices;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsZonalStatistics::Statistics )
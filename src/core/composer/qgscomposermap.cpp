@@ -144,6 +144,13 @@ void QgsComposerMap::draw( QPainter *painter, const QgsRectangle &extent, QSizeF
     return;
   }
 
+  if ( !mPrerenderedImage.isNull() && mCurrentExportLayer == -1 && mPrerenderedExtent == extent
+       && qgsDoubleNear( dpi, mPrerenderedDpi ) && mPrerenderedImage.size() == size.toSize() )
+  {
+    painter->drawImage( 0, 0, mPrerenderedImage );
+    return;
+  }
+
   // render
   QgsMapRendererCustomPainterJob job( mapSettings( extent, size, dpi ), painter );
   // Render the map in this thread. This is done because of problems
@@ -210,6 +217,23 @@ QgsMapSettings QgsComposerMap::mapSettings( const QgsRectangle &extent, QSizeF s
   return jobMapSettings;
 }
 
+QgsMapSettings QgsComposerMap::printMapSettings( int dpi ) const
+{
+  // same size as when the map is drawn by paint()
+  QgsRectangle cExtent = *currentMapExtent();
+  QSizeF size( cExtent.width() * mapUnitsToMM(), cExtent.height() * mapUnitsToMM() );
+  size *= dpi / 25.4;
+
+  return mapSettings( cExtent, size, dpi );
+}
+
+void QgsComposerMap::setPrerenderedImage( const QImage &image, const QgsRectangle &extent, int dpi )
+{
+  mPrerenderedImage = image;
+  mPrerenderedExtent = extent;
+  mPrerenderedDpi = dpi;
+}
+
 void QgsComposerMap::recreateCachedImageInBackground()
 {
   if ( mPainterJob )
@@ -29,6 +29,7 @@
 #include "qgsmaplayerref.h"
 #include <QFont>
 #include <QGraphicsRectItem>
+#include <QImage>
 
 class QgsComposition;
 class QgsComposerMapOverviewStack;
@@ -100,6 +101,24 @@ class CORE_EXPORT QgsComposerMap : public QgsComposerItem
      *  \since QGIS 2.6 */
     QgsMapSettings mapSettings( const QgsRectangle &extent, QSizeF size, int dpi ) const;
 
+    /**
+     * Returns the map settings used to draw the current extent of the map when the
+     * composition is printed at \a dpi.
+     * \see setPrerenderedImage()
+     * \since QGIS 3.0
+     */
+    QgsMapSettings printMapSettings( int dpi ) const;
+
+    /**
+     * Sets an image of the map rendered beforehand with the settings returned by printMapSettings().
+     * When the composition is printed at \a dpi and the map still has the same \a extent, the image
+     * is drawn instead of rendering the map layers. This allows the maps of a composition to be
+     * rendered concurrently before printing it. Set a null image to clear the prerendered image.
+     * \see printMapSettings()
+     * \since QGIS 3.0
+     */
+    void setPrerenderedImage( const QImage &image, const QgsRectangle &extent, int dpi );
+
     //! \brief Get identification number
     int id() const {return mId;}
 
@@ -527,6 +546,11 @@ class CORE_EXPORT QgsComposerMap : public QgsComposerItem
     double mLastRenderedImageOffsetX = 0.0;
     double mLastRenderedImageOffsetY = 0.0;
 
+    //! Image of the map rendered beforehand for printing
+    QImage mPrerenderedImage;
+    QgsRectangle mPrerenderedExtent;
+    int mPrerenderedDpi = 0;
+
     //! Map rotation
     double mMapRotation = 0;
 
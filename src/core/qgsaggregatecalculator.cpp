@@ -22,6 +22,9 @@
 #include "qgsgeometry.h"
 #include "qgsvectorlayer.h"
 
+//! Number of features for which the expressions are evaluated at once
+static const int EXPRESSION_BATCH_SIZE = 1024;
+
 
 
 QgsAggregateCalculator::QgsAggregateCalculator( const QgsVectorLayer *layer )
@@ -406,16 +409,30 @@ QVariant QgsAggregateCalculator::calculateNumericAggregate( QgsFeatureIterator &
   QgsStatisticalSummary s( stat );
   QgsFeature f;
 
-  while ( fit.nextFeature( f ) )
+  if ( expression )
   {
-    if ( expression )
+    // the expression is evaluated for blocks of features at once
+    Q_ASSERT( context );
+    QgsFeatureList features;
+    features.reserve( EXPRESSION_BATCH_SIZE );
+    bool hasNext = true;
+    while ( hasNext )
     {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addVariant( v );
+      hasNext = fit.nextFeature( f );
+      if ( hasNext )
+        features << f;
+
+      if ( features.size() == EXPRESSION_BATCH_SIZE || !hasNext )
+      {
+        Q_FOREACH ( const QVariant &v, expression->evaluate( features, context ) )
+          s.addVariant( v );
+        features.clear();
+      }
     }
-    else
+  }
+  else
+  {
+    while ( fit.nextFeature( f ) )
     {
       s.addVariant( f.attribute( attr ) );
     }
@@ -23,6 +23,7 @@
 #include <QColor>
 #include <QUuid>
 #include <QMutex>
+#include <QVarLengthArray>
 
 #include <cmath>
 #include <limits>
@@ -4145,16 +4146,19 @@ const QList<QgsExpression::Function *> &QgsExpression::Functions()
 
     StaticFunction *areaFunc = new StaticFunction( QStringLiteral( "$area" ), 0, fcnGeomArea, QStringLiteral( "GeometryGroup" ), QString(), true );
     areaFunc->setIsStatic( false );
+    areaFunc->setIsCacheable( true );
     sFunctions << areaFunc;
 
     sFunctions << new StaticFunction( QStringLiteral( "area" ), 1, fcnArea, QStringLiteral( "GeometryGroup" ) );
 
     StaticFunction *lengthFunc =  new StaticFunction( QStringLiteral( "$length" ), 0, fcnGeomLength, QStringLiteral( "GeometryGroup" ), QString(), true );
     lengthFunc->setIsStatic( false );
+    lengthFunc->setIsCacheable( true );
     sFunctions << lengthFunc;
 
     StaticFunction *perimeterFunc =  new StaticFunction( QStringLiteral( "$perimeter" ), 0, fcnGeomPerimeter, QStringLiteral( "GeometryGroup" ), QString(), true );
     perimeterFunc->setIsStatic( false );
+    perimeterFunc->setIsCacheable( true );
     sFunctions << perimeterFunc;
 
     sFunctions << new StaticFunction( QStringLiteral( "perimeter" ), 1, fcnPerimeter, QStringLiteral( "GeometryGroup" ) );
@@ -4219,8 +4223,14 @@ const QList<QgsExpression::Function *> &QgsExpression::Functions()
         << new StaticFunction( QStringLiteral( "y_max" ), 1, fcnYMax, QStringLiteral( "GeometryGroup" ), QString(), false, QSet<QString>(), false, QStringList() << QStringLiteral( "ymax" ) )
         << new StaticFunction( QStringLiteral( "geom_from_wkt" ), 1, fcnGeomFromWKT, QStringLiteral( "GeometryGroup" ), QString(), false, QSet<QString>(), false, QStringList() << QStringLiteral( "geomFromWKT" ) )
         << new StaticFunction( QStringLiteral( "geom_from_gml" ), 1, fcnGeomFromGML, QStringLiteral( "GeometryGroup" ), QString(), false, QSet<QString>(), false, QStringList() << QStringLiteral( "geomFromGML" ) )
-        << new StaticFunction( QStringLiteral( "relate" ), -1, fcnRelate, QStringLiteral( "GeometryGroup" ) )
         << new StaticFunction( QStringLiteral( "intersects_bbox" ), 2, fcnBbox, QStringLiteral( "GeometryGroup" ), QString(), false, QSet<QString>(), false, QStringList() << QStringLiteral( "bbox" ) )
+        << new StaticFunction( QStringLiteral( "translate" ), 3, fcnTranslate, QStringLiteral( "GeometryGroup" ) );
+
+    // the spatial predicates and buffers are costly, and often evaluated several times for the same
+    // geometries (e.g. by the rules of a renderer), so their results are cached in the context
+    QList< StaticFunction * > cachedGeometryFunctions;
+    cachedGeometryFunctions
+        << new StaticFunction( QStringLiteral( "relate" ), -1, fcnRelate, QStringLiteral( "GeometryGroup" ) )
         << new StaticFunction( QStringLiteral( "disjoint" ), 2, fcnDisjoint, QStringLiteral( "GeometryGroup" ) )
         << new StaticFunction( QStringLiteral( "intersects" ), 2, fcnIntersects, QStringLiteral( "GeometryGroup" ) )
         << new StaticFunction( QStringLiteral( "touches" ), 2, fcnTouches, QStringLiteral( "GeometryGroup" ) )
@@ -4228,8 +4238,14 @@ const QList<QgsExpression::Function *> &QgsExpression::Functions()
         << new StaticFunction( QStringLiteral( "contains" ), 2, fcnContains, QStringLiteral( "GeometryGroup" ) )
         << new StaticFunction( QStringLiteral( "overlaps" ), 2, fcnOverlaps, QStringLiteral( "GeometryGroup" ) )
         << new StaticFunction( QStringLiteral( "within" ), 2, fcnWithin, QStringLiteral( "GeometryGroup" ) )
-        << new StaticFunction( QStringLiteral( "translate" ), 3, fcnTranslate, QStringLiteral( "GeometryGroup" ) )
-        << new StaticFunction( QStringLiteral( "buffer" ), -1, fcnBuffer, QStringLiteral( "GeometryGroup" ) )
+        << new StaticFunction( QStringLiteral( "buffer" ), -1, fcnBuffer, QStringLiteral( "GeometryGroup" ) );
+    Q_FOREACH ( StaticFunction *function, cachedGeometryFunctions )
+    {
+      function->setIsCacheable( true );
+      sFunctions << function;
+    }
+
+    sFunctions
         << new StaticFunction( QStringLiteral( "offset_curve" ), ParameterList() << Parameter( QStringLiteral( "geometry" ) )
                                << Parameter( QStringLiteral( "distance" ) )
                                << Parameter( QStringLiteral( "segments" ), true, 8.0 )
@@ -4493,6 +4509,7 @@ bool QgsExpression::checkExpression( const QString &text, const QgsExpressionCon
 void QgsExpression::setExpression( const QString &expression )
 {
   detach();
+  d->mBytecode.reset();
   d->mRootNode = ::parseExpression( expression, d->mParserErrorString );
   d->mEvalErrorString = QString();
   d->mExp = expression;
@@ -4652,6 +4669,14 @@ QSet<QString> QgsExpression::referencedVariables() const
   return d->mRootNode->referencedVariables();
 }
 
+QSet<QString> QgsExpression::referencedFunctions() const
+{
+  if ( !d->mRootNode )
+    return QSet<QString>();
+
+  return d->mRootNode->referencedFunctions();
+}
+
 bool QgsExpression::NodeInOperator::needsGeometry() const
 {
   bool needs = false;
@@ -4721,6 +4746,7 @@ void QgsExpression::setGeomCalculator( const QgsDistanceArea *calc )
 bool QgsExpression::prepare( const QgsExpressionContext *context )
 {
   detach();
+  d->mBytecode.reset();
   d->mEvalErrorString = QString();
   if ( !d->mRootNode )
   {
@@ -4736,7 +4762,11 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
     return false;
   }
 
-  return d->mRootNode->prepare( this, context );
+  bool prepared = d->mRootNode->prepare( this, context );
+
+  // the program mirrors the prepared tree, including the nodes which could not be prepared
+  d->mBytecode.reset( QgsExpressionBytecode::compile( d->mRootNode, context ) );
+  return prepared;
 }
 
 QVariant QgsExpression::evaluate()
@@ -4748,6 +4778,9 @@ QVariant QgsExpression::evaluate()
     return QVariant();
   }
 
+  if ( d->mBytecode )
+    return d->mBytecode->evaluate( this, nullptr );
+
   return d->mRootNode->eval( this, static_cast<const QgsExpressionContext *>( nullptr ) );
 }
 
@@ -4760,9 +4793,68 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
     return QVariant();
   }
 
+  if ( d->mBytecode )
+    return d->mBytecode->evaluate( this, context );
+
   return d->mRootNode->eval( this, context );
 }
 
+QVariantList QgsExpression::evaluate( const QList< QgsFeature > &features, QgsExpressionContext *context )
+{
+  return evaluateBatch( QgsExpressionBatch( features ), context );
+}
+
+QVariantList QgsExpression::evaluateColumns( const QList< QVariantList > &columns, int rowCount, QgsExpressionContext *context )
+{
+  QgsFields fields = context ? context->fields() : QgsFields();
+  return evaluateBatch( QgsExpressionBatch( columns, rowCount, fields ), context );
+}
+
+QVariantList QgsExpression::evaluateBatch( const QgsExpressionBatch &batch, QgsExpressionContext *context )
+{
+  QVariantList results;
+  QVector< int > rowsLeft;
+  d->mEvalErrorString = QString();
+  if ( !d->mBytecode || !d->mBytecode->evaluate( batch, results, rowsLeft ) )
+  {
+    results = QVariantList();
+    rowsLeft.clear();
+    results.reserve( batch.rowCount() );
+    for ( int row = 0; row < batch.rowCount(); ++row )
+    {
+      results << QVariant();
+      rowsLeft << row;
+    }
+  }
+
+  if ( rowsLeft.isEmpty() )
+    return results;
+
+  QgsExpressionContext defaultContext;
+  if ( !context )
+    context = &defaultContext;
+
+  bool hadFeature = context->hasFeature();
+  QgsFeature previousFeature = hadFeature ? context->feature() : QgsFeature();
+
+  QString error;
+  Q_FOREACH ( int row, rowsLeft )
+  {
+    context->setFeature( batch.feature( row ) );
+    results[row] = evaluate( context );
+    if ( error.isNull() )
+      error = d->mEvalErrorString;
+  }
+
+  if ( hadFeature )
+    context->setFeature( previousFeature );
+  else
+    context->lastScope()->removeFeature();
+
+  d->mEvalErrorString = error;
+  return results;
+}
+
 bool QgsExpression::hasEvalError() const
 {
   return !d->mEvalErrorString.isNull();
@@ -4932,6 +5024,11 @@ QVariant QgsExpression::NodeUnaryOperator::evalNode( QgsExpression *parent, cons
   QVariant val = mOperand->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
 
+  return evalOperation( val, parent );
+}
+
+QVariant QgsExpression::NodeUnaryOperator::evalOperation( const QVariant &val, QgsExpression *parent )
+{
   switch ( mOp )
   {
     case uoNot:
@@ -4974,6 +5071,11 @@ QSet<QString> QgsExpression::NodeUnaryOperator::referencedVariables() const
   return mOperand->referencedVariables();
 }
 
+QSet<QString> QgsExpression::NodeUnaryOperator::referencedFunctions() const
+{
+  return mOperand->referencedFunctions();
+}
+
 QgsExpression::Node *QgsExpression::NodeUnaryOperator::clone() const
 {
   NodeUnaryOperator *copy = new NodeUnaryOperator( mOp, mOperand->clone() );
@@ -4992,9 +5094,26 @@ QVariant QgsExpression::NodeBinaryOperator::evalNode( QgsExpression *parent, con
 {
   QVariant vL = mOpLeft->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
+
+  if ( mOp == boAnd || mOp == boOr )
+  {
+    // short-circuit evaluation: the right operand is not evaluated when the left one decides the result
+    TVL tvlL = getTVLValue( vL, parent );
+    ENSURE_NO_EVAL_ERROR;
+    if ( mOp == boAnd && tvlL == False )
+      return TVL_False;
+    if ( mOp == boOr && tvlL == True )
+      return TVL_True;
+  }
+
   QVariant vR = mOpRight->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
 
+  return evalOperation( vL, vR, parent, context );
+}
+
+QVariant QgsExpression::NodeBinaryOperator::evalOperation( const QVariant &vL, const QVariant &vR, QgsExpression *parent, const QgsExpressionContext *context )
+{
   switch ( mOp )
   {
     case boPlus:
@@ -5542,6 +5661,11 @@ QSet<QString> QgsExpression::NodeBinaryOperator::referencedVariables() const
   return mOpLeft->referencedVariables() + mOpRight->referencedVariables();
 }
 
+QSet<QString> QgsExpression::NodeBinaryOperator::referencedFunctions() const
+{
+  return mOpLeft->referencedFunctions() + mOpRight->referencedFunctions();
+}
+
 bool QgsExpression::NodeBinaryOperator::needsGeometry() const
 {
   return mOpLeft->needsGeometry() || mOpRight->needsGeometry();
@@ -5677,14 +5801,54 @@ QVariant QgsExpression::NodeFunction::evalNode( QgsExpression *parent, const Qgs
     }
   }
 
+  // reuse the result of a previous call with the same arguments
+  QVariantList cacheArguments;
+  bool cacheable = context && fd->isCacheable() && functionCacheArguments( fd, argValues, parent, context, cacheArguments );
+  if ( cacheable )
+  {
+    QVariant res;
+    if ( context->cachedFunctionResult( name, cacheArguments, res ) )
+      return res;
+  }
+
   // run the function
   QVariant res = fd->func( argValues, context, parent );
   ENSURE_NO_EVAL_ERROR;
 
+  if ( cacheable )
+    context->setCachedFunctionResult( name, cacheArguments, res );
+
   // everything went fine
   return res;
 }
 
+bool QgsExpression::NodeFunction::functionCacheArguments( Function *fd, const QVariantList &values, QgsExpression *parent, const QgsExpressionContext *context, QVariantList &arguments ) const
+{
+  // geometries are matched by identity, other custom types cannot be compared
+  Q_FOREACH ( const QVariant &value, values )
+  {
+    if ( value.userType() >= QMetaType::User && value.userType() != qMetaTypeId< QgsGeometry >() )
+      return false;
+  }
+  arguments = values;
+
+  if ( fd->usesGeometry( this ) )
+  {
+    // the geometry of the feature and the settings of the distance calculator are implicit arguments
+    if ( !context->hasFeature() )
+      return false;
+
+    arguments << QVariant::fromValue( context->feature().geometry() )
+              << static_cast< int >( parent->distanceUnits() )
+              << static_cast< int >( parent->areaUnits() );
+    if ( QgsDistanceArea *calc = parent->geomCalculator() )
+    {
+      arguments << calc->ellipsoid() << calc->sourceCrs().toProj4();
+    }
+  }
+  return true;
+}
+
 QgsExpression::NodeFunction::NodeFunction( int fnIndex, QgsExpression::NodeList *args )
   : mFnIndex( fnIndex )
 {
@@ -5797,6 +5961,21 @@ QSet<QString> QgsExpression::NodeFunction::referencedVariables() const
   }
 }
 
+QSet<QString> QgsExpression::NodeFunction::referencedFunctions() const
+{
+  QSet<QString> functions = QSet<QString>() << Functions()[mFnIndex]->name();
+
+  if ( !mArgs )
+    return functions;
+
+  Q_FOREACH ( Node *n, mArgs->list() )
+  {
+    functions.unite( n->referencedFunctions() );
+  }
+
+  return functions;
+}
+
 bool QgsExpression::NodeFunction::needsGeometry() const
 {
   bool needs = Functions()[mFnIndex]->usesGeometry( this );
@@ -5940,6 +6119,11 @@ QSet<QString> QgsExpression::NodeLiteral::referencedVariables() const
   return QSet<QString>();
 }
 
+QSet<QString> QgsExpression::NodeLiteral::referencedFunctions() const
+{
+  return QSet<QString>();
+}
+
 QgsExpression::Node *QgsExpression::NodeLiteral::clone() const
 {
   NodeLiteral *copy = new NodeLiteral( mValue );
@@ -6017,6 +6201,11 @@ QSet<QString> QgsExpression::NodeColumnRef::referencedVariables() const
   return QSet<QString>();
 }
 
+QSet<QString> QgsExpression::NodeColumnRef::referencedFunctions() const
+{
+  return QSet<QString>();
+}
+
 QgsExpression::Node *QgsExpression::NodeColumnRef::clone() const
 {
   NodeColumnRef *copy = new NodeColumnRef( mName );
@@ -6122,6 +6311,20 @@ QSet<QString> QgsExpression::NodeCondition::referencedVariables() const
   return lst;
 }
 
+QSet<QString> QgsExpression::NodeCondition::referencedFunctions() const
+{
+  QSet<QString> lst;
+  Q_FOREACH ( WhenThen *cond, mConditions )
+  {
+    lst += cond->mWhenExp->referencedFunctions() + cond->mThenExp->referencedFunctions();
+  }
+
+  if ( mElseExp )
+    lst += mElseExp->referencedFunctions();
+
+  return lst;
+}
+
 bool QgsExpression::NodeCondition::needsGeometry() const
 {
   Q_FOREACH ( WhenThen *cond, mConditions )
@@ -6524,6 +6727,14 @@ QSet<QString> QgsExpression::NodeInOperator::referencedVariables() const
   return lst;
 }
 
+QSet<QString> QgsExpression::NodeInOperator::referencedFunctions() const
+{
+  QSet<QString> lst( mNode->referencedFunctions() );
+  Q_FOREACH ( const Node *n, mList->list() )
+    lst.unite( n->referencedFunctions() );
+  return lst;
+}
+
 bool QgsExpression::Function::usesGeometry( const QgsExpression::NodeFunction *node ) const
 {
   Q_UNUSED( node )
@@ -6687,3 +6898,1057 @@ QgsExpression::WhenThen *QgsExpression::WhenThen::clone() const
 {
   return new WhenThen( mWhenExp->clone(), mThenExp->clone() );
 }
+
+//
+
+///@cond PRIVATE
+
+void QgsExpressionBytecode::Register::setVariant( const QVariant &value )
+{
+  if ( isNull( value ) )
+  {
+    type = Null;
+    variant = value;
+    return;
+  }
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+      setInt( value.toInt() );
+      break;
+    case QVariant::LongLong:
+      setLongLong( value.toLongLong() );
+      break;
+    case QVariant::Double:
+      setDouble( value.toDouble() );
+      break;
+    case QVariant::String:
+      setString( value.toString() );
+      break;
+    default:
+      type = Variant;
+      variant = value;
+      break;
+  }
+}
+
+QVariant QgsExpressionBytecode::Register::toVariant() const
+{
+  switch ( type )
+  {
+    case Int:
+      return QVariant( static_cast< int >( intValue ) );
+    case LongLong:
+      return QVariant( intValue );
+    case Double:
+      return QVariant( doubleValue );
+    case String:
+      return QVariant( stringValue );
+    case Null:
+    case Variant:
+      break;
+  }
+  return variant;
+}
+
+bool QgsExpressionBytecode::Register::isNumeric() const
+{
+  // getDoubleValue() rejects the NaN and infinite values
+  return type == Int || type == LongLong || ( type == Double && qIsFinite( doubleValue ) );
+}
+
+QgsExpressionBytecode *QgsExpressionBytecode::compile( QgsExpression::Node *root, const QgsExpressionContext *context )
+{
+  std::unique_ptr< QgsExpressionBytecode > bytecode( new QgsExpressionBytecode() );
+  int result = bytecode->allocateRegister();
+  bytecode->compileNode( root, result, context );
+
+  if ( bytecode->mCode.size() == 1 && ( bytecode->mCode.at( 0 ).op == LoadConstant || bytecode->mCode.at( 0 ).op == EvalNode ) )
+    return nullptr;
+
+  bytecode->mVectorizable = true;
+  for ( const Instruction &instruction : bytecode->mCode )
+  {
+    switch ( instruction.op )
+    {
+      case LoadConstant:
+        if ( !bytecode->mConstants.at( instruction.a ).isNumeric() )
+          bytecode->mVectorizable = false;
+        break;
+
+      case LoadAttribute:
+      case ToBoolean:
+      case Not:
+      case Negate:
+      case And:
+      case Or:
+      case Arithmetic:
+      case Comparison:
+      case Math:
+      case JumpIfFalse:
+      case JumpIfTrue:
+        break;
+
+      case EvalNode:
+      case Concat:
+      case BinaryOperation:
+      case Jump:
+      case JumpIfNotTrue:
+        bytecode->mVectorizable = false;
+        break;
+    }
+  }
+
+  return bytecode.release();
+}
+
+void QgsExpressionBytecode::compileNode( QgsExpression::Node *node, int dest, const QgsExpressionContext *context )
+{
+  if ( node->mHasCachedValue )
+  {
+    // static nodes were already evaluated by prepare()
+    addConstant( node->mCachedStaticValue, dest );
+    return;
+  }
+
+  switch ( node->nodeType() )
+  {
+    case QgsExpression::ntLiteral:
+      addConstant( static_cast< QgsExpression::NodeLiteral * >( node )->value(), dest );
+      return;
+
+    case QgsExpression::ntColumnRef:
+    {
+      QgsExpression::NodeColumnRef *columnRef = static_cast< QgsExpression::NodeColumnRef * >( node );
+      if ( columnRef->mIndex < 0 )
+        break;
+
+      addInstruction( LoadAttribute, dest, columnRef->mIndex, -1, node );
+      return;
+    }
+
+    case QgsExpression::ntUnaryOperator:
+    {
+      QgsExpression::NodeUnaryOperator *unary = static_cast< QgsExpression::NodeUnaryOperator * >( node );
+      compileNode( unary->mOperand, dest, context );
+      if ( unary->mOp == QgsExpression::uoNot )
+      {
+        addInstruction( ToBoolean, dest );
+        addInstruction( Not, dest );
+      }
+      else
+      {
+        addInstruction( Negate, dest, -1, -1, node );
+      }
+      return;
+    }
+
+    case QgsExpression::ntBinaryOperator:
+    {
+      QgsExpression::NodeBinaryOperator *binary = static_cast< QgsExpression::NodeBinaryOperator * >( node );
+      compileNode( binary->mOpLeft, dest, context );
+      int right = allocateRegister();
+
+      if ( binary->mOp == QgsExpression::boAnd || binary->mOp == QgsExpression::boOr )
+      {
+        // the right operand is skipped when the left one decides the result, which is then already in dest
+        addInstruction( ToBoolean, dest );
+        int shortCircuit = addInstruction( binary->mOp == QgsExpression::boAnd ? JumpIfFalse : JumpIfTrue, -1, dest );
+        compileNode( binary->mOpRight, right, context );
+        addInstruction( ToBoolean, right );
+        addInstruction( binary->mOp == QgsExpression::boAnd ? And : Or, dest, right );
+        mCode[ shortCircuit ].b = mCode.size();
+      }
+      else
+      {
+        compileNode( binary->mOpRight, right, context );
+
+        OpCode op = BinaryOperation;
+        switch ( binary->mOp )
+        {
+          case QgsExpression::boPlus:
+          case QgsExpression::boMinus:
+          case QgsExpression::boMul:
+          case QgsExpression::boDiv:
+          case QgsExpression::boIntDiv:
+          case QgsExpression::boMod:
+          case QgsExpression::boPow:
+            op = Arithmetic;
+            break;
+          case QgsExpression::boEQ:
+          case QgsExpression::boNE:
+          case QgsExpression::boLT:
+          case QgsExpression::boGT:
+          case QgsExpression::boLE:
+          case QgsExpression::boGE:
+            op = Comparison;
+            break;
+          case QgsExpression::boConcat:
+            op = Concat;
+            break;
+          default:
+            break;
+        }
+        addInstruction( op, dest, right, -1, node );
+      }
+
+      releaseRegister();
+      return;
+    }
+
+    case QgsExpression::ntCondition:
+    {
+      QgsExpression::NodeCondition *condition = static_cast< QgsExpression::NodeCondition * >( node );
+      QList< int > jumpsToEnd;
+      int when = allocateRegister();
+      Q_FOREACH ( QgsExpression::WhenThen *whenThen, condition->mConditions )
+      {
+        compileNode( whenThen->mWhenExp, when, context );
+        addInstruction( ToBoolean, when );
+        int jumpToNext = addInstruction( JumpIfNotTrue, -1, when );
+        compileNode( whenThen->mThenExp, dest, context );
+        jumpsToEnd << addInstruction( Jump, -1 );
+        mCode[ jumpToNext ].b = mCode.size();
+      }
+      releaseRegister();
+
+      if ( condition->mElseExp )
+        compileNode( condition->mElseExp, dest, context );
+      else
+        addConstant( QVariant(), dest );
+
+      Q_FOREACH ( int jump, jumpsToEnd )
+        mCode[ jump ].b = mCode.size();
+      return;
+    }
+
+    case QgsExpression::ntFunction:
+    {
+      // functions are resolved against the context used to prepare the expression
+      QgsExpression::NodeFunction *function = static_cast< QgsExpression::NodeFunction * >( node );
+      QgsExpression::Function *fd = QgsExpression::Functions()[function->fnIndex()];
+      int math = mathFunction( fd->name() );
+      if ( math < 0 || !function->args() || function->args()->count() != 1 || fd->lazyEval() || fd->handlesNull()
+           || ( context && context->hasFunction( fd->name() ) ) )
+        break;
+
+      compileNode( function->args()->at( 0 ), dest, context );
+      addInstruction( Math, dest, math, -1, node );
+      return;
+    }
+
+    case QgsExpression::ntInOperator:
+      break;
+  }
+
+  // not compiled, evaluated by the tree
+  addInstruction( EvalNode, dest, -1, -1, node );
+}
+
+void QgsExpressionBytecode::addConstant( const QVariant &value, int dest )
+{
+  Register constant;
+  constant.setVariant( value );
+  mConstants << constant;
+  addInstruction( LoadConstant, dest, mConstants.size() - 1 );
+}
+
+int QgsExpressionBytecode::addInstruction( OpCode op, int dest, int a, int b, QgsExpression::Node *node )
+{
+  Instruction instruction;
+  instruction.op = op;
+  instruction.dest = dest;
+  instruction.a = a;
+  instruction.b = b;
+  instruction.node = node;
+  mCode << instruction;
+  return mCode.size() - 1;
+}
+
+int QgsExpressionBytecode::allocateRegister()
+{
+  int index = mNextRegister++;
+  mRegisterCount = qMax( mRegisterCount, mNextRegister );
+  return index;
+}
+
+int QgsExpressionBytecode::mathFunction( const QString &name )
+{
+  if ( name == QLatin1String( "sqrt" ) )
+    return Sqrt;
+  if ( name == QLatin1String( "abs" ) )
+    return Abs;
+  if ( name == QLatin1String( "sin" ) )
+    return Sin;
+  if ( name == QLatin1String( "cos" ) )
+    return Cos;
+  if ( name == QLatin1String( "tan" ) )
+    return Tan;
+  if ( name == QLatin1String( "asin" ) )
+    return Asin;
+  if ( name == QLatin1String( "acos" ) )
+    return Acos;
+  if ( name == QLatin1String( "atan" ) )
+    return Atan;
+  if ( name == QLatin1String( "exp" ) )
+    return Exp;
+  if ( name == QLatin1String( "ln" ) )
+    return Ln;
+  if ( name == QLatin1String( "log10" ) )
+    return Log10;
+  if ( name == QLatin1String( "floor" ) )
+    return Floor;
+  if ( name == QLatin1String( "ceil" ) )
+    return Ceil;
+  return -1;
+}
+
+bool QgsExpressionBytecode::evalOperation( QgsExpression::NodeBinaryOperator *node, Register &left, const Register &right, QgsExpression *parent, const QgsExpressionContext *context )
+{
+  QVariant result = node->evalOperation( left.toVariant(), right.toVariant(), parent, context );
+  if ( parent->hasEvalError() )
+    return false;
+
+  left.setVariant( result );
+  return true;
+}
+
+QVariant QgsExpressionBytecode::evaluate( QgsExpression *parent, const QgsExpressionContext *context ) const
+{
+  QVarLengthArray< Register, 16 > registers( mRegisterCount );
+  QgsFeature feature;
+  bool featureLoaded = false;
+
+  int pc = 0;
+  const int size = mCode.size();
+  while ( pc < size )
+  {
+    const Instruction &instruction = mCode.at( pc++ );
+    switch ( instruction.op )
+    {
+      case LoadConstant:
+        registers[ instruction.dest ] = mConstants.at( instruction.a );
+        break;
+
+      case LoadAttribute:
+        if ( context && context->hasFeature() )
+        {
+          if ( !featureLoaded )
+          {
+            feature = context->feature();
+            featureLoaded = true;
+          }
+          registers[ instruction.dest ].setVariant( feature.attribute( instruction.a ) );
+          break;
+        }
+        FALLTHROUGH;
+
+      case EvalNode:
+        registers[ instruction.dest ].setVariant( instruction.node->eval( parent, context ) );
+        if ( parent->hasEvalError() )
+          return QVariant();
+        break;
+
+      case ToBoolean:
+      {
+        Register &value = registers[ instruction.dest ];
+        switch ( value.type )
+        {
+          case Register::Null:
+            value.setNull();
+            break;
+          case Register::Int:
+            value.setInt( value.intValue != 0 ? 1 : 0 );
+            break;
+          case Register::LongLong:
+          case Register::Double:
+            value.setInt( !qgsDoubleNear( value.toDouble(), 0.0 ) ? 1 : 0 );
+            break;
+          case Register::String:
+          case Register::Variant:
+          {
+            TVL tvl = getTVLValue( value.toVariant(), parent );
+            if ( parent->hasEvalError() )
+              return QVariant();
+            if ( tvl == Unknown )
+              value.setNull();
+            else
+              value.setInt( tvl == True ? 1 : 0 );
+            break;
+          }
+        }
+        break;
+      }
+
+      case Not:
+      {
+        Register &value = registers[ instruction.dest ];
+        if ( value.type == Register::Int )
+          value.setInt( value.intValue ? 0 : 1 );
+        else
+          value.setNull();
+        break;
+      }
+
+      case And:
+      case Or:
+      {
+        Register &left = registers[ instruction.dest ];
+        const Register &right = registers[ instruction.a ];
+        TVL tvlL = left.type == Register::Int ? ( left.intValue ? True : False ) : Unknown;
+        TVL tvlR = right.type == Register::Int ? ( right.intValue ? True : False ) : Unknown;
+        TVL tvl = instruction.op == And ? AND[tvlL][tvlR] : OR[tvlL][tvlR];
+        if ( tvl == Unknown )
+          left.setNull();
+        else
+          left.setInt( tvl == True ? 1 : 0 );
+        break;
+      }
+
+      case Negate:
+      {
+        Register &value = registers[ instruction.dest ];
+        if ( value.isInteger() )
+        {
+          value.setLongLong( -value.intValue );
+        }
+        else if ( value.isNumeric() )
+        {
+          value.setDouble( -value.doubleValue );
+        }
+        else
+        {
+          QVariant result = static_cast< QgsExpression::NodeUnaryOperator * >( instruction.node )->evalOperation( value.toVariant(), parent );
+          if ( parent->hasEvalError() )
+            return QVariant();
+          value.setVariant( result );
+        }
+        break;
+      }
+
+      case Arithmetic:
+      {
+        QgsExpression::NodeBinaryOperator *binary = static_cast< QgsExpression::NodeBinaryOperator * >( instruction.node );
+        Register &left = registers[ instruction.dest ];
+        const Register &right = registers[ instruction.a ];
+        if ( !left.isNumeric() || !right.isNumeric() )
+        {
+          if ( !evalOperation( binary, left, right, parent, context ) )
+            return QVariant();
+          break;
+        }
+
+        const QgsExpression::BinaryOperator op = binary->mOp;
+        if ( op != QgsExpression::boDiv && op != QgsExpression::boIntDiv && op != QgsExpression::boPow
+             && left.isInteger() && right.isInteger() )
+        {
+          if ( op == QgsExpression::boMod && right.intValue == 0 )
+            left.setNull();
+          else
+            left.setLongLong( binary->computeInt( left.intValue, right.intValue ) );
+          break;
+        }
+
+        double fL = left.toDouble();
+        double fR = right.toDouble();
+        if ( op == QgsExpression::boPow )
+          left.setDouble( pow( fL, fR ) );
+        else if ( ( op == QgsExpression::boDiv || op == QgsExpression::boMod || op == QgsExpression::boIntDiv ) && fR == 0. )
+          left.setNull(); // silently handle division by zero and return NULL
+        else if ( op == QgsExpression::boIntDiv )
+          left.setInt( qFloor( fL / fR ) );
+        else
+          left.setDouble( binary->computeDouble( fL, fR ) );
+        break;
+      }
+
+      case Comparison:
+      {
+        QgsExpression::NodeBinaryOperator *binary = static_cast< QgsExpression::NodeBinaryOperator * >( instruction.node );
+        Register &left = registers[ instruction.dest ];
+        const Register &right = registers[ instruction.a ];
+        if ( left.type == Register::Null || right.type == Register::Null )
+          left.setNull();
+        else if ( left.isNumeric() && right.isNumeric() )
+          left.setInt( binary->compare( left.toDouble() - right.toDouble() ) ? 1 : 0 );
+        else if ( left.type == Register::String && right.type == Register::String )
+          left.setInt( binary->compare( QString::compare( left.stringValue, right.stringValue ) ) ? 1 : 0 );
+        else if ( !evalOperation( binary, left, right, parent, context ) )
+          return QVariant();
+        break;
+      }
+
+      case Concat:
+      {
+        Register &left = registers[ instruction.dest ];
+        const Register &right = registers[ instruction.a ];
+        if ( left.type == Register::Null || right.type == Register::Null )
+          left.setNull();
+        else if ( left.type == Register::String && right.type == Register::String )
+          left.setString( left.stringValue + right.stringValue );
+        else if ( !evalOperation( static_cast< QgsExpression::NodeBinaryOperator * >( instruction.node ), left, right, parent, context ) )
+          return QVariant();
+        break;
+      }
+
+      case BinaryOperation:
+        if ( !evalOperation( static_cast< QgsExpression::NodeBinaryOperator * >( instruction.node ), registers[ instruction.dest ], registers[ instruction.a ], parent, context ) )
+          return QVariant();
+        break;
+
+      case Math:
+      {
+        Register &value = registers[ instruction.dest ];
+        if ( value.type == Register::Null )
+        {
+          // functions return NULL when a parameter is NULL
+          value.setNull();
+          break;
+        }
+
+        if ( !value.isNumeric() )
+        {
+          QgsExpression::Function *fd = QgsExpression::Functions()[static_cast< QgsExpression::NodeFunction * >( instruction.node )->fnIndex()];
+          QVariant result = fd->func( QVariantList() << value.toVariant(), context, parent );
+          if ( parent->hasEvalError() )
+            return QVariant();
+          value.setVariant( result );
+          break;
+        }
+
+        double x = value.toDouble();
+        switch ( static_cast< MathFunction >( instruction.a ) )
+        {
+          case Sqrt:
+            value.setDouble( sqrt( x ) );
+            break;
+          case Abs:
+            value.setDouble( fabs( x ) );
+            break;
+          case Sin:
+            value.setDouble( sin( x ) );
+            break;
+          case Cos:
+            value.setDouble( cos( x ) );
+            break;
+          case Tan:
+            value.setDouble( tan( x ) );
+            break;
+          case Asin:
+            value.setDouble( asin( x ) );
+            break;
+          case Acos:
+            value.setDouble( acos( x ) );
+            break;
+          case Atan:
+            value.setDouble( atan( x ) );
+            break;
+          case Exp:
+            value.setDouble( exp( x ) );
+            break;
+          case Ln:
+            if ( x <= 0 )
+              value.setNull();
+            else
+              value.setDouble( log( x ) );
+            break;
+          case Log10:
+            if ( x <= 0 )
+              value.setNull();
+            else
+              value.setDouble( log10( x ) );
+            break;
+          case Floor:
+            value.setDouble( floor( x ) );
+            break;
+          case Ceil:
+            value.setDouble( ceil( x ) );
+            break;
+        }
+        break;
+      }
+
+      case Jump:
+        pc = instruction.b;
+        break;
+
+      case JumpIfFalse:
+        if ( registers[ instruction.a ].type == Register::Int && registers[ instruction.a ].intValue == 0 )
+          pc = instruction.b;
+        break;
+
+      case JumpIfTrue:
+        if ( registers[ instruction.a ].type == Register::Int && registers[ instruction.a ].intValue == 1 )
+          pc = instruction.b;
+        break;
+
+      case JumpIfNotTrue:
+        if ( registers[ instruction.a ].type != Register::Int || registers[ instruction.a ].intValue != 1 )
+          pc = instruction.b;
+        break;
+    }
+  }
+
+  return registers[ 0 ].toVariant();
+}
+
+QVariant QgsExpressionBatch::attribute( int row, int index ) const
+{
+  if ( mFeatures )
+    return mFeatures->at( row ).attribute( index );
+
+  if ( index < 0 || index >= mColumns->size() || row >= mColumns->at( index ).size() )
+    return QVariant();
+  return mColumns->at( index ).at( row );
+}
+
+QgsFeature QgsExpressionBatch::feature( int row ) const
+{
+  if ( mFeatures )
+    return mFeatures->at( row );
+
+  QgsFeature feature( mFields, row );
+  QgsAttributes attributes( qMax( mFields.count(), mColumns->size() ) );
+  for ( int i = 0; i < mColumns->size(); ++i )
+  {
+    if ( row < mColumns->at( i ).size() )
+      attributes[i] = mColumns->at( i ).at( row );
+  }
+  feature.setAttributes( attributes );
+  feature.setValid( true );
+  return feature;
+}
+
+QVector< double > QgsExpressionBytecode::doubleValues( const Column &column, char *slowRows )
+{
+  if ( column.type == Register::Double )
+  {
+    // getDoubleValue() rejects the NaN and infinite values
+    const int size = column.doubles.size();
+    const double *values = column.doubles.constData();
+    for ( int i = 0; i < size; ++i )
+    {
+      if ( !qIsFinite( values[i] ) )
+        slowRows[i] = 1;
+    }
+    return column.doubles;
+  }
+
+  const int size = column.ints.size();
+  QVector< double > values( size );
+  const qlonglong *in = column.ints.constData();
+  double *out = values.data();
+  for ( int i = 0; i < size; ++i )
+    out[i] = in[i];
+  return values;
+}
+
+bool QgsExpressionBytecode::evaluate( const QgsExpressionBatch &batch, QVariantList &results, QVector< int > &rowsLeft ) const
+{
+  if ( !mVectorizable )
+    return false;
+
+  const int n = batch.rowCount();
+  QVector< Column > columns( mRegisterCount );
+  QVector< char > slow( n, 0 );
+  char *slowRows = slow.data();
+
+  for ( const Instruction &instruction : mCode )
+  {
+    switch ( instruction.op )
+    {
+      case LoadConstant:
+      {
+        const Register &constant = mConstants.at( instruction.a );
+        Column &column = columns[instruction.dest];
+        column.type = constant.type;
+        if ( constant.isInteger() )
+          column.ints.fill( constant.intValue, n );
+        else
+          column.doubles.fill( constant.doubleValue, n );
+        break;
+      }
+
+      case LoadAttribute:
+      {
+        // the column takes the type of the first value, the rows with other types are evaluated one by one
+        Column &column = columns[instruction.dest];
+        column.type = Register::Null;
+        for ( int row = 0; row < n; ++row )
+        {
+          QVariant value = batch.attribute( row, instruction.a );
+          Register::Type type = Register::Null;
+          if ( !isNull( value ) )
+          {
+            switch ( value.type() )
+            {
+              case QVariant::Int:
+                type = Register::Int;
+                break;
+              case QVariant::LongLong:
+                type = Register::LongLong;
+                break;
+              case QVariant::Double:
+                type = Register::Double;
+                break;
+              default:
+                break;
+            }
+          }
+
+          if ( type != Register::Null && column.type == Register::Null )
+          {
+            column.type = type;
+            if ( column.isInteger() )
+              column.ints.resize( n );
+            else
+              column.doubles.resize( n );
+          }
+
+          if ( type == Register::Null || type != column.type )
+            slowRows[row] = 1;
+          else if ( column.isInteger() )
+            column.ints[row] = value.toLongLong();
+          else
+            column.doubles[row] = value.toDouble();
+        }
+
+        if ( column.type == Register::Null )
+        {
+          column.type = Register::Double;
+          column.doubles.fill( 0, n );
+        }
+        break;
+      }
+
+      case ToBoolean:
+      {
+        Column &column = columns[instruction.dest];
+        QVector< qlonglong > values( n );
+        qlonglong *out = values.data();
+        if ( column.isInteger() )
+        {
+          const qlonglong *in = column.ints.constData();
+          for ( int i = 0; i < n; ++i )
+            out[i] = in[i] != 0;
+        }
+        else
+        {
+          const double *in = column.doubles.constData();
+          for ( int i = 0; i < n; ++i )
+            out[i] = !qgsDoubleNear( in[i], 0.0 );
+        }
+        column.type = Register::Int;
+        column.ints = values;
+        break;
+      }
+
+      case Not:
+      {
+        Column &column = columns[instruction.dest];
+        qlonglong *values = column.ints.data();
+        for ( int i = 0; i < n; ++i )
+          values[i] = !values[i];
+        break;
+      }
+
+      case And:
+      case Or:
+      {
+        // the values are not NULL, so the right operand does not change the result when the left one decides it
+        qlonglong *left = columns[instruction.dest].ints.data();
+        const qlonglong *right = columns.at( instruction.a ).ints.constData();
+        if ( instruction.op == And )
+        {
+          for ( int i = 0; i < n; ++i )
+            left[i] = left[i] & right[i];
+        }
+        else
+        {
+          for ( int i = 0; i < n; ++i )
+            left[i] = left[i] | right[i];
+        }
+        break;
+      }
+
+      case Negate:
+      {
+        Column &column = columns[instruction.dest];
+        if ( column.isInteger() )
+        {
+          qlonglong *values = column.ints.data();
+          for ( int i = 0; i < n; ++i )
+            values[i] = -values[i];
+          column.type = Register::LongLong;
+        }
+        else
+        {
+          QVector< double > values = doubleValues( column, slowRows );
+          double *out = values.data();
+          for ( int i = 0; i < n; ++i )
+            out[i] = -out[i];
+          column.doubles = values;
+        }
+        break;
+      }
+
+      case Arithmetic:
+      {
+        QgsExpression::NodeBinaryOperator *binary = static_cast< QgsExpression::NodeBinaryOperator * >( instruction.node );
+        const QgsExpression::BinaryOperator op = binary->mOp;
+        Column &left = columns[instruction.dest];
+        const Column &right = columns.at( instruction.a );
+
+        if ( left.isInteger() && right.isInteger() &&
+             ( op == QgsExpression::boPlus || op == QgsExpression::boMinus || op == QgsExpression::boMul || op == QgsExpression::boMod ) )
+        {
+          QVector< qlonglong > values( n );
+          qlonglong *out = values.data();
+          const qlonglong *a = left.ints.constData();
+          const qlonglong *b = right.ints.constData();
+          switch ( op )
+          {
+            case QgsExpression::boPlus:
+              for ( int i = 0; i < n; ++i )
+                out[i] = a[i] + b[i];
+              break;
+            case QgsExpression::boMinus:
+              for ( int i = 0; i < n; ++i )
+                out[i] = a[i] - b[i];
+              break;
+            case QgsExpression::boMul:
+              for ( int i = 0; i < n; ++i )
+                out[i] = a[i] * b[i];
+              break;
+            default:
+              for ( int i = 0; i < n; ++i )
+              {
+                // the modulo by zero is NULL
+                if ( b[i] == 0 )
+                  slowRows[i] = 1;
+                else
+                  out[i] = a[i] % b[i];
+              }
+              break;
+          }
+          left.type = Register::LongLong;
+          left.ints = values;
+          break;
+        }
+
+        const QVector< double > leftValues = doubleValues( left, slowRows );
+        const QVector< double > rightValues = doubleValues( right, slowRows );
+        const double *a = leftValues.constData();
+        const double *b = rightValues.constData();
+
+        if ( op == QgsExpression::boIntDiv )
+        {
+          QVector< qlonglong > values( n );
+          qlonglong *out = values.data();
+          for ( int i = 0; i < n; ++i )
+          {
+            if ( b[i] == 0. )
+              slowRows[i] = 1;
+            else
+              out[i] = qFloor( a[i] / b[i] );
+          }
+          left.type = Register::Int;
+          left.ints = values;
+          break;
+        }
+
+        QVector< double > values( n );
+        double *out = values.data();
+        switch ( op )
+        {
+          case QgsExpression::boPlus:
+            for ( int i = 0; i < n; ++i )
+              out[i] = a[i] + b[i];
+            break;
+          case QgsExpression::boMinus:
+            for ( int i = 0; i < n; ++i )
+              out[i] = a[i] - b[i];
+            break;
+          case QgsExpression::boMul:
+            for ( int i = 0; i < n; ++i )
+              out[i] = a[i] * b[i];
+            break;
+          case QgsExpression::boDiv:
+            for ( int i = 0; i < n; ++i )
+            {
+              // the division by zero is NULL
+              if ( b[i] == 0. )
+                slowRows[i] = 1;
+              else
+                out[i] = a[i] / b[i];
+            }
+            break;
+          case QgsExpression::boMod:
+            for ( int i = 0; i < n; ++i )
+            {
+              if ( b[i] == 0. )
+                slowRows[i] = 1;
+              else
+                out[i] = fmod( a[i], b[i] );
+            }
+            break;
+          default:
+            for ( int i = 0; i < n; ++i )
+              out[i] = pow( a[i], b[i] );
+            break;
+        }
+        left.type = Register::Double;
+        left.doubles = values;
+        left.ints.clear();
+        break;
+      }
+
+      case Comparison:
+      {
+        QgsExpression::NodeBinaryOperator *binary = static_cast< QgsExpression::NodeBinaryOperator * >( instruction.node );
+        Column &left = columns[instruction.dest];
+        const QVector< double > leftValues = doubleValues( left, slowRows );
+        const QVector< double > rightValues = doubleValues( columns.at( instruction.a ), slowRows );
+        const double *a = leftValues.constData();
+        const double *b = rightValues.constData();
+
+        QVector< qlonglong > values( n );
+        qlonglong *out = values.data();
+        switch ( binary->mOp )
+        {
+          case QgsExpression::boEQ:
+            for ( int i = 0; i < n; ++i )
+              out[i] = qgsDoubleNear( a[i] - b[i], 0.0 );
+            break;
+          case QgsExpression::boNE:
+            for ( int i = 0; i < n; ++i )
+              out[i] = !qgsDoubleNear( a[i] - b[i], 0.0 );
+            break;
+          case QgsExpression::boLT:
+            for ( int i = 0; i < n; ++i )
+              out[i] = a[i] < b[i];
+            break;
+          case QgsExpression::boGT:
+            for ( int i = 0; i < n; ++i )
+              out[i] = a[i] > b[i];
+            break;
+          case QgsExpression::boLE:
+            for ( int i = 0; i < n; ++i )
+              out[i] = a[i] <= b[i];
+            break;
+          default:
+            for ( int i = 0; i < n; ++i )
+              out[i] = a[i] >= b[i];
+            break;
+        }
+        left.type = Register::Int;
+        left.ints = values;
+        left.doubles.clear();
+        break;
+      }
+
+      case Math:
+      {
+        Column &column = columns[instruction.dest];
+        QVector< double > values = doubleValues( column, slowRows );
+        double *x = values.data();
+        switch ( static_cast< MathFunction >( instruction.a ) )
+        {
+          case Sqrt:
+            for ( int i = 0; i < n; ++i )
+              x[i] = sqrt( x[i] );
+            break;
+          case Abs:
+            for ( int i = 0; i < n; ++i )
+              x[i] = fabs( x[i] );
+            break;
+          case Sin:
+            for ( int i = 0; i < n; ++i )
+              x[i] = sin( x[i] );
+            break;
+          case Cos:
+            for ( int i = 0; i < n; ++i )
+              x[i] = cos( x[i] );
+            break;
+          case Tan:
+            for ( int i = 0; i < n; ++i )
+              x[i] = tan( x[i] );
+            break;
+          case Asin:
+            for ( int i = 0; i < n; ++i )
+              x[i] = asin( x[i] );
+            break;
+          case Acos:
+            for ( int i = 0; i < n; ++i )
+              x[i] = acos( x[i] );
+            break;
+          case Atan:
+            for ( int i = 0; i < n; ++i )
+              x[i] = atan( x[i] );
+            break;
+          case Exp:
+            for ( int i = 0; i < n; ++i )
+              x[i] = exp( x[i] );
+            break;
+          case Ln:
+          case Log10:
+            for ( int i = 0; i < n; ++i )
+            {
+              // the logarithm of a value <= 0 is NULL
+              if ( x[i] <= 0 )
+                slowRows[i] = 1;
+              else
+                x[i] = instruction.a == Ln ? log( x[i] ) : log10( x[i] );
+            }
+            break;
+          case Floor:
+            for ( int i = 0; i < n; ++i )
+              x[i] = floor( x[i] );
+            break;
+          case Ceil:
+            for ( int i = 0; i < n; ++i )
+              x[i] = ceil( x[i] );
+            break;
+        }
+        column.type = Register::Double;
+        column.doubles = values;
+        column.ints.clear();
+        break;
+      }
+
+      case JumpIfFalse:
+      case JumpIfTrue:
+        // AND and OR are computed for all the rows
+        break;
+
+      case EvalNode:
+      case Concat:
+      case BinaryOperation:
+      case Jump:
+      case JumpIfNotTrue:
+        Q_ASSERT( false );
+        return false;
+    }
+  }
+
+  const Column &result = columns.at( 0 );
+  results.reserve( results.size() + n );
+  for ( int row = 0; row < n; ++row )
+  {
+    if ( slowRows[row] )
+    {
+      results << QVariant();
+      rowsLeft << row;
+    }
+    else if ( result.type == Register::Int )
+      results << QVariant( static_cast< int >( result.ints.at( row ) ) );
+    else if ( result.type == Register::LongLong )
+      results << QVariant( result.ints.at( row ) );
+    else
+      results << QVariant( result.doubles.at( row ) );
+  }
+  return true;
+}
+
+///@endcond
@@ -41,6 +41,8 @@ class QgsDistanceArea;
 class QDomElement;
 class QgsExpressionContext;
 class QgsExpressionPrivate;
+class QgsExpressionBytecode;
+class QgsExpressionBatch;
 
 /** \ingroup core
 Class for parsing and evaluation of expressions (formerly called "search strings").
@@ -195,6 +197,13 @@ class CORE_EXPORT QgsExpression
      */
     QSet<QString> referencedVariables() const;
 
+    /**
+     * Return a list of the names of all the functions which are used in this expression.
+     *
+     * \since QGIS 3.0
+     */
+    QSet<QString> referencedFunctions() const;
+
     /**
      * Return a list of field name indexes obtained from the provided fields.
      *
@@ -220,6 +229,38 @@ class CORE_EXPORT QgsExpression
      */
     QVariant evaluate( const QgsExpressionContext *context );
 
+    /** Evaluates the expression for a block of \a features at once.
+     *
+     * This gives the same results as setting each feature to the \a context in turn and calling
+     * evaluate(), but the arithmetic and comparison expressions over numeric attributes are
+     * computed column by column for the whole block. The feature of the context is restored
+     * after the evaluation.
+     * \param features features to evaluate the expression for
+     * \param context context for evaluating expression
+     * \returns the result for each feature, NULL for the features whose evaluation failed.
+     * hasEvalError() then returns true and evalErrorString() describes the first failure.
+     * \note prepare() should be called before calling this method.
+     * \since QGIS 3.0
+     */
+    QVariantList evaluate( const QList< QgsFeature > &features, QgsExpressionContext *context );
+
+    /** Evaluates the expression for rows given as columns of attribute values.
+     *
+     * The values of the attribute with index i, in the fields of the \a context, are given by
+     * columns[i]. The columns of the attributes which are not used by the expression may be empty,
+     * the other ones must hold \a rowCount values. The rows are evaluated as features which only
+     * have these attributes and the number of the row as id.
+     * \param columns attribute values
+     * \param rowCount number of rows
+     * \param context context for evaluating expression
+     * \returns the result for each row
+     * \note prepare() should be called before calling this method.
+     * \note not available in Python bindings
+     * \see evaluate()
+     * \since QGIS 3.0
+     */
+    QVariantList evaluateColumns( const QList< QVariantList > &columns, int rowCount, QgsExpressionContext *context ) SIP_SKIP;
+
     //! Returns true if an error occurred when evaluating last input
     bool hasEvalError() const;
     //! Returns evaluation error
@@ -650,6 +691,15 @@ class CORE_EXPORT QgsExpression
 
         virtual bool handlesNull() const { return mHandlesNull; }
 
+        /** Returns true if the result of a call of the function only depends on its arguments, and
+         * on the geometry of the feature of the context for the functions which use the geometry.
+         * The results of such functions are cached in the expression context, and reused for the next
+         * calls with the same arguments.
+         * \since QGIS 3.0
+         * \see QgsExpressionContext::cachedFunctionResult()
+         */
+        virtual bool isCacheable() const { return false; }
+
       protected:
 
         /**
@@ -811,6 +861,17 @@ class CORE_EXPORT QgsExpression
          */
         void setPrepareFunction( std::function < bool( const NodeFunction *node, QgsExpression *parent, const QgsExpressionContext *context ) > prepareFunc );
 
+        virtual bool isCacheable() const override { return mIsCacheable; }
+
+        /**
+         * Tag this function as cacheable or not. The results of cacheable functions are kept in the
+         * expression context and reused for the next calls with the same arguments.
+         *
+         * \see isCacheable()
+         * \since QGIS 3.0
+         */
+        void setIsCacheable( bool cacheable ) { mIsCacheable = cacheable; }
+
 
       private:
         FcnEval mFnc;
@@ -822,6 +883,7 @@ class CORE_EXPORT QgsExpression
         std::function < bool( const NodeFunction *node,  QgsExpression *parent, const QgsExpressionContext *context ) > mPrepareFunc;
         QSet<QString> mReferencedColumns;
         bool mIsStatic = false;
+        bool mIsCacheable = false;
     };
 #endif
 
@@ -1002,6 +1064,12 @@ class CORE_EXPORT QgsExpression
          */
         virtual QSet<QString> referencedVariables() const = 0;
 
+        /**
+         * Return a set of the names of all the functions which are used in this expression.
+         * \since QGIS 3.0
+         */
+        virtual QSet<QString> referencedFunctions() const = 0;
+
         /**
          * Abstract virtual method which returns if the geometry is required to evaluate
          * this expression.
@@ -1064,6 +1132,8 @@ class CORE_EXPORT QgsExpression
 
         bool mHasCachedValue = false;
         QVariant mCachedStaticValue;
+
+        friend class ::QgsExpressionBytecode;
     };
 
     //! Named node
@@ -1166,14 +1236,23 @@ class CORE_EXPORT QgsExpression
 
         virtual QSet<QString> referencedColumns() const override;
         virtual QSet<QString> referencedVariables() const override;
+        virtual QSet<QString> referencedFunctions() const override;
         virtual bool needsGeometry() const override { return mOperand->needsGeometry(); }
         virtual QgsExpression::Node *clone() const override;
 
         virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
 
       private:
+
+        /** Applies the operator to the value of the operand.
+         * Errors are reported to the parent
+         */
+        QVariant evalOperation( const QVariant &val, QgsExpression *parent );
+
         UnaryOperator mOp;
         Node *mOperand = nullptr;
+
+        friend class ::QgsExpressionBytecode;
     };
 
     /** \ingroup core
@@ -1203,6 +1282,7 @@ class CORE_EXPORT QgsExpression
 
         virtual QSet<QString> referencedColumns() const override;
         virtual QSet<QString> referencedVariables() const override;
+        virtual QSet<QString> referencedFunctions() const override;
         virtual bool needsGeometry() const override;
         virtual QgsExpression::Node *clone() const override;
         virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
@@ -1211,6 +1291,12 @@ class CORE_EXPORT QgsExpression
         bool leftAssociative() const;
 
       private:
+
+        /** Applies the operator to the values of the operands.
+         * Errors are reported to the parent
+         */
+        QVariant evalOperation( const QVariant &vL, const QVariant &vR, QgsExpression *parent, const QgsExpressionContext *context );
+
         bool compare( double diff );
         qlonglong computeInt( qlonglong x, qlonglong y );
         double computeDouble( double x, double y );
@@ -1224,6 +1310,8 @@ class CORE_EXPORT QgsExpression
         BinaryOperator mOp;
         Node *mOpLeft = nullptr;
         Node *mOpRight = nullptr;
+
+        friend class ::QgsExpressionBytecode;
     };
 
     /** \ingroup core
@@ -1253,6 +1341,7 @@ class CORE_EXPORT QgsExpression
 
         virtual QSet<QString> referencedColumns() const override;
         virtual QSet<QString> referencedVariables() const override;
+        virtual QSet<QString> referencedFunctions() const override;
         virtual bool needsGeometry() const override;
         virtual QgsExpression::Node *clone() const override;
         virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
@@ -1287,6 +1376,7 @@ class CORE_EXPORT QgsExpression
 
         virtual QSet<QString> referencedColumns() const override;
         virtual QSet<QString> referencedVariables() const override;
+        virtual QSet<QString> referencedFunctions() const override;
         virtual bool needsGeometry() const override;
         virtual QgsExpression::Node *clone() const override;
         virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
@@ -1295,6 +1385,13 @@ class CORE_EXPORT QgsExpression
         static bool validateParams( int fnIndex, QgsExpression::NodeList *args, QString &error );
 
       private:
+
+        /** Sets \a arguments to the values identifying a call of the cacheable function \a fd with the
+         * argument \a values, which are used as key of the cached function results of the \a context.
+         * \returns false if the call cannot be cached
+         */
+        bool functionCacheArguments( QgsExpression::Function *fd, const QVariantList &values, QgsExpression *parent, const QgsExpressionContext *context, QVariantList &arguments ) const;
+
         int mFnIndex;
         NodeList *mArgs = nullptr;
 
@@ -1319,6 +1416,7 @@ class CORE_EXPORT QgsExpression
 
         virtual QSet<QString> referencedColumns() const override;
         virtual QSet<QString> referencedVariables() const override;
+        virtual QSet<QString> referencedFunctions() const override;
         virtual bool needsGeometry() const override { return false; }
         virtual QgsExpression::Node *clone() const override;
         virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
@@ -1347,6 +1445,7 @@ class CORE_EXPORT QgsExpression
 
         virtual QSet<QString> referencedColumns() const override;
         virtual QSet<QString> referencedVariables() const override;
+        virtual QSet<QString> referencedFunctions() const override;
         virtual bool needsGeometry() const override { return false; }
 
         virtual QgsExpression::Node *clone() const override;
@@ -1355,6 +1454,8 @@ class CORE_EXPORT QgsExpression
       private:
         QString mName;
         int mIndex;
+
+        friend class ::QgsExpressionBytecode;
     };
 
     class NodeCondition;
@@ -1389,6 +1490,7 @@ class CORE_EXPORT QgsExpression
         Node *mThenExp = nullptr;
 
         friend class NodeCondition;
+        friend class ::QgsExpressionBytecode;
 
     };
     typedef QList<QgsExpression::WhenThen *> WhenThenList;
@@ -1421,6 +1523,7 @@ class CORE_EXPORT QgsExpression
 
         virtual QSet<QString> referencedColumns() const override;
         virtual QSet<QString> referencedVariables() const override;
+        virtual QSet<QString> referencedFunctions() const override;
         virtual bool needsGeometry() const override;
         virtual QgsExpression::Node *clone() const override;
         virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
@@ -1428,6 +1531,8 @@ class CORE_EXPORT QgsExpression
       private:
         WhenThenList mConditions;
         Node *mElseExp = nullptr;
+
+        friend class ::QgsExpressionBytecode;
     };
 
     /** Returns the help text for a specified function.
@@ -1542,6 +1647,9 @@ class CORE_EXPORT QgsExpression
      */
     void detach() SIP_SKIP;
 
+    //! Evaluates the expression for each row of \a batch
+    QVariantList evaluateBatch( const QgsExpressionBatch &batch, QgsExpressionContext *context ) SIP_SKIP;
+
     QgsExpressionPrivate *d = nullptr;
 
     static QHash<QString, Help> sFunctionHelpTexts;
@@ -31,6 +31,7 @@
 
 #include <QSettings>
 #include <QDir>
+#include <QMutexLocker>
 
 
 const QString QgsExpressionContext::EXPR_FIELDS( QStringLiteral( "_fields_" ) );
@@ -228,7 +229,10 @@ QgsExpressionContext::QgsExpressionContext( const QgsExpressionContext &other )
     mStack << new QgsExpressionContextScope( *scope );
   }
   mHighlightedVariables = other.mHighlightedVariables;
+
+  QMutexLocker locker( &other.mCacheMutex );
   mCachedValues = other.mCachedValues;
+  mCachedFunctionResults = other.mCachedFunctionResults;
 }
 
 QgsExpressionContext &QgsExpressionContext::operator=( QgsExpressionContext &&other ) noexcept
@@ -241,7 +245,11 @@ QgsExpressionContext &QgsExpressionContext::operator=( QgsExpressionContext &&ot
     other.mStack.clear();
 
     mHighlightedVariables = other.mHighlightedVariables;
+
+    QMutexLocker locker( &mCacheMutex );
+    QMutexLocker otherLocker( &other.mCacheMutex );
     mCachedValues = other.mCachedValues;
+    mCachedFunctionResults = other.mCachedFunctionResults;
   }
   return *this;
 }
@@ -255,7 +263,14 @@ QgsExpressionContext &QgsExpressionContext::operator=( const QgsExpressionContex
     mStack << new QgsExpressionContextScope( *scope );
   }
   mHighlightedVariables = other.mHighlightedVariables;
-  mCachedValues = other.mCachedValues;
+
+  if ( this != &other )
+  {
+    QMutexLocker locker( &mCacheMutex );
+    QMutexLocker otherLocker( &other.mCacheMutex );
+    mCachedValues = other.mCachedValues;
+    mCachedFunctionResults = other.mCachedFunctionResults;
+  }
   return *this;
 }
 
@@ -520,22 +535,122 @@ void QgsExpressionContext::setOriginalValueVariable( const QVariant &value )
 
 void QgsExpressionContext::setCachedValue( const QString &key, const QVariant &value ) const
 {
+  QMutexLocker locker( &mCacheMutex );
   mCachedValues.insert( key, value );
 }
 
 bool QgsExpressionContext::hasCachedValue( const QString &key ) const
 {
+  QMutexLocker locker( &mCacheMutex );
   return mCachedValues.contains( key );
 }
 
 QVariant QgsExpressionContext::cachedValue( const QString &key ) const
 {
+  QMutexLocker locker( &mCacheMutex );
   return mCachedValues.value( key, QVariant() );
 }
 
 void QgsExpressionContext::clearCachedValues() const
 {
+  QMutexLocker locker( &mCacheMutex );
   mCachedValues.clear();
+  mCachedFunctionResults.clear();
+}
+
+///@cond PRIVATE
+
+//! Maximal number of cached function results, the cache is emptied when it is full
+static const int MAX_CACHED_FUNCTION_RESULTS = 1000;
+
+static uint functionArgumentHash( const QVariant &value )
+{
+  if ( value.userType() == qMetaTypeId< QgsGeometry >() )
+    return qHash( value.value< QgsGeometry >().geometry() );
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Bool:
+      return qHash( value.toLongLong() );
+    case QVariant::Double:
+      return qHash( value.toDouble() );
+    default:
+      return qHash( value.toString() );
+  }
+}
+
+static bool sameFunctionArguments( const QVariantList &arguments, const QVariantList &otherArguments )
+{
+  if ( arguments.size() != otherArguments.size() )
+    return false;
+
+  for ( int i = 0; i < arguments.size(); ++i )
+  {
+    const QVariant &value = arguments.at( i );
+    const QVariant &otherValue = otherArguments.at( i );
+    if ( value.userType() != otherValue.userType() )
+      return false;
+
+    // the cached arguments hold a reference to their geometry, so that it cannot be replaced by another
+    // geometry at the same address
+    if ( value.userType() == qMetaTypeId< QgsGeometry >() )
+    {
+      if ( value.value< QgsGeometry >().geometry() != otherValue.value< QgsGeometry >().geometry() )
+        return false;
+    }
+    else if ( value != otherValue )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint functionCallHash( const QString &function, const QVariantList &arguments )
+{
+  uint hash = qHash( function );
+  Q_FOREACH ( const QVariant &value, arguments )
+  {
+    hash = 31 * hash + functionArgumentHash( value );
+  }
+  return hash;
+}
+
+///@endcond
+
+bool QgsExpressionContext::cachedFunctionResult( const QString &function, const QVariantList &arguments, QVariant &result ) const
+{
+  uint hash = functionCallHash( function, arguments );
+
+  QMutexLocker locker( &mCacheMutex );
+  QMultiHash< uint, FunctionResult >::const_iterator it = mCachedFunctionResults.constFind( hash );
+  for ( ; it != mCachedFunctionResults.constEnd() && it.key() == hash; ++it )
+  {
+    if ( it->function == function && sameFunctionArguments( it->arguments, arguments ) )
+    {
+      result = it->result;
+      return true;
+    }
+  }
+  return false;
+}
+
+void QgsExpressionContext::setCachedFunctionResult( const QString &function, const QVariantList &arguments, const QVariant &result ) const
+{
+  FunctionResult functionResult;
+  functionResult.function = function;
+  functionResult.arguments = arguments;
+  functionResult.result = result;
+  uint hash = functionCallHash( function, arguments );
+
+  QMutexLocker locker( &mCacheMutex );
+  if ( mCachedFunctionResults.size() >= MAX_CACHED_FUNCTION_RESULTS )
+    mCachedFunctionResults.clear();
+  mCachedFunctionResults.insert( hash, functionResult );
 }
 
 
@@ -20,6 +20,7 @@
 #include "qgis.h"
 #include <QVariant>
 #include <QHash>
+#include <QMutex>
 #include <QString>
 #include <QStringList>
 #include <QSet>
@@ -583,14 +584,40 @@ class CORE_EXPORT QgsExpressionContext
      */
     QVariant cachedValue( const QString &key ) const;
 
-    /** Clears all cached values from the context.
+    /** Clears all cached values and function results from the context.
      * \see setCachedValue()
      * \see hasCachedValue()
      * \see cachedValue()
+     * \see setCachedFunctionResult()
      * \since QGIS 2.16
      */
     void clearCachedValues() const;
 
+    /** Retrieves the result of a previous call of an expression function with the same arguments.
+     * Arguments holding geometries match when they share the same geometry object, which is the
+     * case for the copies of the geometry of a feature, and the other arguments when they are equal.
+     * \param function name of the function
+     * \param arguments values of the arguments of the call
+     * \param result will be set to the cached result of the call
+     * \returns true if a result was cached for the call
+     * \note not available in Python bindings
+     * \see setCachedFunctionResult()
+     * \see QgsExpression::Function::isCacheable()
+     * \since QGIS 3.0
+     */
+    bool cachedFunctionResult( const QString &function, const QVariantList &arguments, QVariant &result ) const SIP_SKIP;
+
+    /** Caches the result of a call of an expression function, so that the next calls with the same
+     * arguments can reuse it. Only the most recent results are kept.
+     * \param function name of the function
+     * \param arguments values of the arguments of the call
+     * \param result result of the call
+     * \note not available in Python bindings
+     * \see cachedFunctionResult()
+     * \since QGIS 3.0
+     */
+    void setCachedFunctionResult( const QString &function, const QVariantList &arguments, const QVariant &result ) const SIP_SKIP;
+
     //! Inbuilt variable name for fields storage
     static const QString EXPR_FIELDS;
     //! Inbuilt variable name for value original value variable
@@ -620,6 +647,21 @@ class CORE_EXPORT QgsExpressionContext
     // Cache is mutable because we want to be able to add cached values to const contexts
     mutable QMap< QString, QVariant > mCachedValues;
 
+    //! Result of a call of an expression function
+    struct FunctionResult
+    {
+      QString function;
+      QVariantList arguments;
+      QVariant result;
+    };
+    //! Cached function results, by hash of the call
+    mutable QMultiHash< uint, FunctionResult > mCachedFunctionResults;
+
+    /** Protects the cached values and function results only. The scopes and the feature of the context are
+     * not protected, so each thread evaluating expressions must still use its own copy of the context.
+     */
+    mutable QMutex mCacheMutex;
+
 };
 
 /** \ingroup core
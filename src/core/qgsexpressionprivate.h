@@ -18,14 +18,222 @@
 #define QGSEXPRESSIONPRIVATE_H
 
 #include <QString>
+#include <QVariant>
+#include <QVector>
 #include <memory>
 
 #include "qgsexpression.h"
 #include "qgsdistancearea.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
 #include "qgsunittypes.h"
 
 ///@cond
 
+/**
+ * Block of rows evaluated at once by an expression, given either as features
+ * or as columns of attribute values.
+ */
+class QgsExpressionBatch
+{
+  public:
+
+    //! Batch of \a features, which must outlive the batch
+    explicit QgsExpressionBatch( const QList< QgsFeature > &features )
+      : mFeatures( &features )
+      , mRowCount( features.size() )
+    {}
+
+    //! Batch of \a columns of values of the \a fields, which must outlive the batch
+    QgsExpressionBatch( const QList< QVariantList > &columns, int rowCount, const QgsFields &fields )
+      : mColumns( &columns )
+      , mRowCount( rowCount )
+      , mFields( fields )
+    {}
+
+    int rowCount() const { return mRowCount; }
+
+    //! Returns the value of the attribute with the given \a index for \a row
+    QVariant attribute( int row, int index ) const;
+
+    //! Returns the feature of \a row
+    QgsFeature feature( int row ) const;
+
+  private:
+    const QList< QgsFeature > *mFeatures = nullptr;
+    const QList< QVariantList > *mColumns = nullptr;
+    int mRowCount = 0;
+    QgsFields mFields;
+};
+
+/**
+ * Flat register based program compiled from the prepared tree of an expression.
+ *
+ * The values computed by the program are kept in registers which hold integers,
+ * doubles and strings unboxed. Booleans are stored as integers 0 and 1, like the
+ * three-valued logic results of the tree. Static nodes are folded to constants,
+ * the attributes whose index was resolved by prepare() are read directly from the
+ * feature and AND, OR and CASE jump over the operands they do not need.
+ * The nodes which are not compiled, e.g. most function calls or IN, are evaluated
+ * by the tree.
+ *
+ * Batches of rows are evaluated instruction by instruction over columns of values
+ * when the program only does numeric operations. The rows for which the result
+ * is not a number, e.g. because of a NULL attribute or a division by zero, are
+ * left to the evaluation row by row.
+ *
+ * The program refers to the nodes of the tree it was compiled from and must be
+ * compiled again whenever the tree is prepared again.
+ */
+class QgsExpressionBytecode
+{
+  public:
+
+    /**
+     * Compiles the prepared tree of \a root.
+     * Returns nullptr if the program would not be faster than the tree, i.e. if the
+     * whole expression is a constant or a node which cannot be compiled.
+     */
+    static QgsExpressionBytecode *compile( QgsExpression::Node *root, const QgsExpressionContext *context );
+
+    /**
+     * Evaluates the program, the result and the errors are the ones of the tree.
+     * The registers are local to each call, so the program can be shared.
+     */
+    QVariant evaluate( QgsExpression *parent, const QgsExpressionContext *context ) const;
+
+    /**
+     * Evaluates the program column by column for the rows of \a batch.
+     * The results are appended to \a results, with a NULL placeholder for the rows
+     * which must be evaluated one by one, whose numbers are appended to \a rowsLeft.
+     * Returns false if the program cannot be evaluated column by column, nothing is done then.
+     */
+    bool evaluate( const QgsExpressionBatch &batch, QVariantList &results, QVector< int > &rowsLeft ) const;
+
+  private:
+
+    //! Math functions computed by the program
+    enum MathFunction
+    {
+      Sqrt,
+      Abs,
+      Sin,
+      Cos,
+      Tan,
+      Asin,
+      Acos,
+      Atan,
+      Exp,
+      Ln,
+      Log10,
+      Floor,
+      Ceil
+    };
+
+    //! Instructions, the operands of the operators are the dest register and the register a
+    enum OpCode
+    {
+      LoadConstant, //!< dest = constant a
+      LoadAttribute, //!< dest = attribute a of the context feature
+      EvalNode, //!< dest = node, evaluated by the tree
+      ToBoolean, //!< dest = dest converted to 0, 1 or NULL
+      Not, //!< dest = NOT dest, with a boolean
+      Negate, //!< dest = - dest
+      And, //!< dest = dest AND a, with booleans
+      Or, //!< dest = dest OR a, with booleans
+      Arithmetic, //!< dest = dest op a for +, -, *, /, //, % and ^
+      Comparison, //!< dest = dest op a for =, <>, <, >, <= and >=
+      Concat, //!< dest = dest || a
+      BinaryOperation, //!< dest = dest op a for the other operators, computed by the node
+      Math, //!< dest = math function a of dest
+      Jump, //!< jumps to instruction b
+      JumpIfFalse, //!< jumps to instruction b if register a is 0
+      JumpIfTrue, //!< jumps to instruction b if register a is 1
+      JumpIfNotTrue //!< jumps to instruction b if register a is not 1
+    };
+
+    struct Instruction
+    {
+      OpCode op;
+      int dest;
+      int a;
+      int b;
+      QgsExpression::Node *node;
+    };
+
+    struct Register
+    {
+      enum Type
+      {
+        Null,
+        Int,
+        LongLong,
+        Double,
+        String,
+        Variant
+      };
+
+      Type type = Null;
+      qlonglong intValue = 0;
+      double doubleValue = 0;
+      QString stringValue;
+      //! Value of the Null and Variant registers, NULL values keep their type
+      QVariant variant;
+
+      void setNull() { type = Null; variant = QVariant(); }
+      void setInt( qlonglong value ) { type = Int; intValue = value; }
+      void setLongLong( qlonglong value ) { type = LongLong; intValue = value; }
+      void setDouble( double value ) { type = Double; doubleValue = value; }
+      void setString( const QString &value ) { type = String; stringValue = value; }
+      void setVariant( const QVariant &value );
+      QVariant toVariant() const;
+
+      //! Returns true if the register holds an integer or a finite double
+      bool isNumeric() const;
+      bool isInteger() const { return type == Int || type == LongLong; }
+      double toDouble() const { return type == Double ? doubleValue : intValue; }
+    };
+
+    //! Values of a register for a batch of rows, all of the same numeric type
+    struct Column
+    {
+      Register::Type type = Register::Double;
+      QVector< qlonglong > ints;
+      QVector< double > doubles;
+
+      bool isInteger() const { return type == Register::Int || type == Register::LongLong; }
+    };
+
+    QgsExpressionBytecode() = default;
+
+    void compileNode( QgsExpression::Node *node, int dest, const QgsExpressionContext *context );
+    void addConstant( const QVariant &value, int dest );
+    int addInstruction( OpCode op, int dest, int a = -1, int b = -1, QgsExpression::Node *node = nullptr );
+    int allocateRegister();
+    void releaseRegister() { --mNextRegister; }
+    static int mathFunction( const QString &name );
+
+    /**
+     * Computes a binary operation with the node of the tree.
+     * Returns false if the evaluation failed.
+     */
+    static bool evalOperation( QgsExpression::NodeBinaryOperator *node, Register &left, const Register &right, QgsExpression *parent, const QgsExpressionContext *context );
+
+    /**
+     * Returns the values of \a column as doubles, flagging in \a slowRows the
+     * rows whose value is not finite.
+     */
+    static QVector< double > doubleValues( const Column &column, char *slowRows );
+
+    QVector< Instruction > mCode;
+    QVector< Register > mConstants;
+    int mRegisterCount = 0;
+    int mNextRegister = 0;
+
+    //! True if the program only does numeric operations, which can be evaluated column by column
+    bool mVectorizable = false;
+};
+
 /**
  * This class exists only for implicit sharing of QgsExpression
  * and is not part of the public API.
@@ -51,7 +259,9 @@ class QgsExpressionPrivate
       , mCalc( other.mCalc )
       , mDistanceUnit( other.mDistanceUnit )
       , mAreaUnit( other.mAreaUnit )
-    {}
+    {
+      // the bytecode refers to the nodes of the other tree, it is compiled again when the copy is prepared
+    }
 
     ~QgsExpressionPrivate()
     {
@@ -70,6 +280,9 @@ class QgsExpressionPrivate
     std::shared_ptr<QgsDistanceArea> mCalc;
     QgsUnitTypes::DistanceUnit mDistanceUnit;
     QgsUnitTypes::AreaUnit mAreaUnit;
+
+    //! Program compiled from the prepared tree
+    std::unique_ptr< QgsExpressionBytecode > mBytecode;
 };
 ///@endcond
 
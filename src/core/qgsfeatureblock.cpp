@@ -0,0 +1,264 @@
+/***************************************************************************
+                          qgsfeatureblock.cpp
+                          -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfeatureblock.h"
+#include "qgsfeatureblock_p.h"
+
+///@cond PRIVATE
+
+QgsFeatureBlockColumn::QgsFeatureBlockColumn( QVariant::Type type )
+  : mType( type )
+{
+  switch ( type )
+  {
+    case QVariant::Int:
+    case QVariant::Bool:
+      mStorage = Int;
+      break;
+    case QVariant::LongLong:
+      mStorage = LongLong;
+      break;
+    case QVariant::Double:
+      mStorage = Double;
+      break;
+    case QVariant::String:
+      mStorage = String;
+      mStringOffsets << 0;
+      break;
+    default:
+      mStorage = Variant;
+      break;
+  }
+}
+
+void QgsFeatureBlockColumn::append( const QVariant &value )
+{
+  if ( mStorage != Variant && value.isValid() && value.type() != mType )
+    convertToVariants();
+
+  if ( mStorage == Variant )
+  {
+    mVariants.append( value );
+    ++mSize;
+    return;
+  }
+
+  bool isNull = value.isNull();
+  mNulls.resize( mSize + 1 );
+  mInvalids.resize( mSize + 1 );
+  if ( !value.isValid() )
+    mInvalids.setBit( mSize );
+  else if ( isNull )
+    mNulls.setBit( mSize );
+
+  switch ( mStorage )
+  {
+    case Int:
+      mInts.append( isNull ? 0 : value.toInt() );
+      break;
+    case LongLong:
+      mLongLongs.append( isNull ? 0 : value.toLongLong() );
+      break;
+    case Double:
+      mDoubles.append( isNull ? 0.0 : value.toDouble() );
+      break;
+    case String:
+      if ( !isNull )
+        mCharacters.append( value.toString() );
+      mStringOffsets.append( mCharacters.size() );
+      break;
+    case Variant:
+      break;
+  }
+  ++mSize;
+}
+
+QVariant QgsFeatureBlockColumn::value( int index ) const
+{
+  if ( mStorage == Variant )
+    return mVariants.at( index );
+
+  if ( mInvalids.testBit( index ) )
+    return QVariant();
+  if ( mNulls.testBit( index ) )
+    return QVariant( mType );
+
+  switch ( mStorage )
+  {
+    case Int:
+      return mType == QVariant::Bool ? QVariant( mInts.at( index ) != 0 ) : QVariant( mInts.at( index ) );
+    case LongLong:
+      return QVariant( mLongLongs.at( index ) );
+    case Double:
+      return QVariant( mDoubles.at( index ) );
+    case String:
+    {
+      int start = mStringOffsets.at( index );
+      return QVariant( QString( mCharacters.constData() + start, mStringOffsets.at( index + 1 ) - start ) );
+    }
+    case Variant:
+      break;
+  }
+  return QVariant();
+}
+
+void QgsFeatureBlockColumn::convertToVariants()
+{
+  QVector< QVariant > variants;
+  variants.reserve( mSize );
+  for ( int i = 0; i < mSize; ++i )
+  {
+    variants << value( i );
+  }
+
+  mStorage = Variant;
+  mVariants = variants;
+  mInts.clear();
+  mLongLongs.clear();
+  mDoubles.clear();
+  mCharacters.clear();
+  mStringOffsets.clear();
+  mNulls.clear();
+  mInvalids.clear();
+}
+
+///@endcond
+
+QgsFeatureBlock::QgsFeatureBlock( const QgsFields &fields )
+  : d( new QgsFeatureBlockPrivate( fields ) )
+{
+}
+
+QgsFeatureBlock::QgsFeatureBlock( const QgsFeatureBlock &other ) //NOLINT
+  : d( other.d )
+{
+}
+
+QgsFeatureBlock &QgsFeatureBlock::operator=( const QgsFeatureBlock &other )  //NOLINT
+{
+  d = other.d;
+  return *this;
+}
+
+QgsFeatureBlock::~QgsFeatureBlock() //NOLINT
+{
+}
+
+QgsFields QgsFeatureBlock::fields() const
+{
+  return d->fields;
+}
+
+void QgsFeatureBlock::setFields( const QgsFields &fields )
+{
+  d->fields = fields;
+}
+
+int QgsFeatureBlock::count() const
+{
+  return d->ids.size();
+}
+
+void QgsFeatureBlock::append( const QgsFeature &feature )
+{
+  const QgsAttributes attributes = feature.attributes();
+  int index = d->ids.size();
+
+  d->ids.append( feature.id() );
+  d->geometries.append( feature.geometry() );
+  d->valid.resize( index + 1 );
+  d->valid.setBit( index, feature.isValid() );
+  d->attributeCounts.append( attributes.size() );
+
+  // the columns are created by the first feature which has the attribute
+  for ( int i = d->columns.size(); i < attributes.size(); ++i )
+  {
+    QgsFeatureBlockColumn column( i < d->fields.count() ? d->fields.at( i ).type() : attributes.at( i ).type() );
+    for ( int j = 0; j < index; ++j )
+    {
+      column.append( QVariant() );
+    }
+    d->columns.append( column );
+  }
+
+  for ( int i = 0; i < d->columns.size(); ++i )
+  {
+    d->columns[i].append( i < attributes.size() ? attributes.at( i ) : QVariant() );
+  }
+}
+
+void QgsFeatureBlock::append( const QgsFeatureList &features )
+{
+  Q_FOREACH ( const QgsFeature &feature, features )
+  {
+    append( feature );
+  }
+}
+
+void QgsFeatureBlock::clear()
+{
+  d = new QgsFeatureBlockPrivate( d->fields );
+}
+
+QgsFeature QgsFeatureBlock::feature( int index ) const
+{
+  QgsFeature feature( d->ids.at( index ) );
+  feature.setFields( d->fields );
+  feature.setAttributes( attributes( index ) );
+  feature.setGeometry( d->geometries.at( index ) );
+  feature.setValid( d->valid.testBit( index ) );
+  return feature;
+}
+
+QgsFeatureList QgsFeatureBlock::features() const
+{
+  QgsFeatureList features;
+  features.reserve( count() );
+  for ( int i = 0; i < count(); ++i )
+  {
+    features << feature( i );
+  }
+  return features;
+}
+
+QgsFeatureId QgsFeatureBlock::id( int index ) const
+{
+  return d->ids.at( index );
+}
+
+QgsGeometry QgsFeatureBlock::geometry( int index ) const
+{
+  return d->geometries.at( index );
+}
+
+QgsAttributes QgsFeatureBlock::attributes( int index ) const
+{
+  int attributeCount = d->attributeCounts.at( index );
+  QgsAttributes attributes( attributeCount );
+  for ( int i = 0; i < attributeCount; ++i )
+  {
+    attributes[i] = d->columns.at( i ).value( index );
+  }
+  return attributes;
+}
+
+QVariant QgsFeatureBlock::attribute( int index, int attributeIndex ) const
+{
+  if ( attributeIndex < 0 || attributeIndex >= d->attributeCounts.at( index ) )
+    return QVariant();
+
+  return d->columns.at( attributeIndex ).value( index );
+}
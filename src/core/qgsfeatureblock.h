@@ -0,0 +1,110 @@
+/***************************************************************************
+                          qgsfeatureblock.h
+                          -----------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFEATUREBLOCK_H
+#define QGSFEATUREBLOCK_H
+
+#include "qgis_core.h"
+#include "qgis.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+
+#include <QSharedDataPointer>
+
+class QgsFeatureBlockPrivate;
+
+/** \ingroup core
+ * A block of features with the same fields, whose attributes are stored in typed columns.
+ *
+ * The integer, floating point and string attributes of the features are stored in arrays
+ * of native values shared by all the features of the block, with the NULL values flagged
+ * in bit arrays. Only the attributes of the other types are kept as QVariant. This takes a
+ * fraction of the memory used by a list of features holding a QVariant per attribute.
+ *
+ * The QVariant values and the QgsFeature objects are only created when the features
+ * are read back from the block. The values are returned with the same type as they were
+ * added.
+ *
+ * QgsFeatureBlock objects are implicitly shared.
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsFeatureBlock
+{
+  public:
+
+    /** Constructor for an empty block of features.
+     * \param fields the fields of the features. The types of the fields give the
+     * storage of the columns, the type of the first value added is used for the
+     * columns without field.
+     */
+    explicit QgsFeatureBlock( const QgsFields &fields = QgsFields() );
+
+    QgsFeatureBlock( const QgsFeatureBlock &other );
+    QgsFeatureBlock &operator=( const QgsFeatureBlock &other );
+    ~QgsFeatureBlock();
+
+    /** Returns the fields of the features.
+     * \see setFields()
+     */
+    QgsFields fields() const;
+
+    /** Sets the \a fields of the features. The attributes of the features are not changed.
+     * \see fields()
+     */
+    void setFields( const QgsFields &fields );
+
+    //! Returns the number of features in the block
+    int count() const;
+
+    //! Returns true if the block contains no feature
+    bool isEmpty() const { return count() == 0; }
+
+    //! Adds a \a feature at the end of the block
+    void append( const QgsFeature &feature );
+
+    //! Adds some \a features at the end of the block
+    void append( const QgsFeatureList &features );
+
+    //! Removes all the features from the block
+    void clear();
+
+    /** Returns the feature at \a index, which must be a valid index in the block
+     * (i.e., 0 <= index < count()). The feature is created from the columns of the block.
+     */
+    QgsFeature feature( int index ) const;
+
+    //! Returns all the features of the block, which are created from the columns of the block
+    QgsFeatureList features() const;
+
+    //! Returns the id of the feature at \a index
+    QgsFeatureId id( int index ) const;
+
+    //! Returns the geometry of the feature at \a index
+    QgsGeometry geometry( int index ) const;
+
+    //! Returns the attributes of the feature at \a index
+    QgsAttributes attributes( int index ) const;
+
+    /** Returns the value of the attribute \a attributeIndex of the feature at \a index,
+     * or an invalid QVariant if the feature has no such attribute.
+     */
+    QVariant attribute( int index, int attributeIndex ) const;
+
+  private:
+    QSharedDataPointer< QgsFeatureBlockPrivate > d;
+};
+
+#endif // QGSFEATUREBLOCK_H
@@ -0,0 +1,127 @@
+/***************************************************************************
+                          qgsfeatureblock_p.h
+                          -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFEATUREBLOCK_PRIVATE_H
+#define QGSFEATUREBLOCK_PRIVATE_H
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgsfeature.h"
+#include "qgsfields.h"
+#include "qgsgeometry.h"
+
+#include <QBitArray>
+#include <QSharedData>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * The values of an attribute for all the features of a block.
+ *
+ * The values of the type of the column are stored in an array of native values, or
+ * in a single buffer for the strings. The column falls back to an array of QVariant
+ * when a value of another type is added.
+ */
+class QgsFeatureBlockColumn
+{
+  public:
+
+    //! Storage of the values
+    enum Storage
+    {
+      Int, //!< Integer and boolean values
+      LongLong, //!< 64 bit integer values
+      Double, //!< Floating point values
+      String, //!< Strings, stored in a single buffer
+      Variant //!< Values of any type
+    };
+
+    //! Constructor for a column storing values of \a type
+    explicit QgsFeatureBlockColumn( QVariant::Type type = QVariant::Invalid );
+
+    //! Returns the number of values in the column
+    int size() const { return mSize; }
+
+    //! Adds a \a value at the end of the column
+    void append( const QVariant &value );
+
+    //! Returns the value at \a index, converted to a QVariant of the type it was added with
+    QVariant value( int index ) const;
+
+  private:
+
+    //! Moves the values to an array of QVariant, so that values of any type can be added
+    void convertToVariants();
+
+    QVariant::Type mType;
+    Storage mStorage;
+    int mSize = 0;
+
+    QVector< int > mInts;
+    QVector< qlonglong > mLongLongs;
+    QVector< double > mDoubles;
+    //! Characters of all the strings, and start of the string of each value
+    QString mCharacters;
+    QVector< int > mStringOffsets;
+    QVector< QVariant > mVariants;
+
+    //! Values which are NULL values of the type of the column
+    QBitArray mNulls;
+    //! Values which are invalid QVariant
+    QBitArray mInvalids;
+};
+
+class QgsFeatureBlockPrivate : public QSharedData
+{
+  public:
+
+    explicit QgsFeatureBlockPrivate( const QgsFields &fields )
+      : fields( fields )
+    {
+    }
+
+    //! Fields of the features
+    QgsFields fields;
+
+    //! Feature IDs
+    QVector< QgsFeatureId > ids;
+
+    //! Geometries, may be empty if the features have no geometry
+    QVector< QgsGeometry > geometries;
+
+    //! Flags to indicate if the features are valid
+    QBitArray valid;
+
+    //! Number of attributes of each feature
+    QVector< int > attributeCounts;
+
+    //! Values of the attributes
+    QVector< QgsFeatureBlockColumn > columns;
+};
+
+/// @endcond
+
+#endif // QGSFEATUREBLOCK_PRIVATE_H
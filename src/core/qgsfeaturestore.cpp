@@ -22,24 +22,19 @@ QgsFeatureStore::QgsFeatureStore()
 QgsFeatureStore::QgsFeatureStore( const QgsFields &fields, const QgsCoordinateReferenceSystem &crs )
   : mFields( fields )
   , mCrs( crs )
+  , mFeatures( fields )
 {
 }
 
 void QgsFeatureStore::setFields( const QgsFields &fields )
 {
   mFields = fields;
-  QgsFeatureList::iterator it = mFeatures.begin();
-  for ( ; it != mFeatures.end(); ++it )
-  {
-    ( *it ).setFields( mFields );
-  }
+  mFeatures.setFields( mFields );
 }
 
 bool QgsFeatureStore::addFeature( QgsFeature &feature )
 {
-  QgsFeature f( feature );
-  f.setFields( mFields );
-  mFeatures.append( f );
+  mFeatures.append( feature );
   return true;
 }
 
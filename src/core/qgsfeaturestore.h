@@ -18,6 +18,7 @@
 #include "qgis_core.h"
 #include "qgis.h"
 #include "qgsfeature.h"
+#include "qgsfeatureblock.h"
 #include "qgsfields.h"
 #include "qgsfeaturesink.h"
 #include "qgscoordinatereferencesystem.h"
@@ -27,6 +28,9 @@
 
 /** \ingroup core
  * A container for features with the same fields and crs.
+ *
+ * The features are kept in a QgsFeatureBlock, which stores their attributes in typed
+ * columns. The QgsFeature objects are created again when the features are retrieved.
  */
 class CORE_EXPORT QgsFeatureStore : public QgsFeatureSink
 {
@@ -67,7 +71,7 @@ class CORE_EXPORT QgsFeatureStore : public QgsFeatureSink
     /**
      * Returns the number of features contained in the store.
      */
-    int count() const { return mFeatures.size(); }
+    int count() const { return mFeatures.count(); }
 
 #ifdef SIP_RUN
 
@@ -82,8 +86,17 @@ class CORE_EXPORT QgsFeatureStore : public QgsFeatureSink
 
     /**
      * Returns the list of features contained in the store.
+     * \see featureBlock()
      */
-    QgsFeatureList features() const { return mFeatures; }
+    QgsFeatureList features() const { return mFeatures.features(); }
+
+    /**
+     * Returns the block holding the features contained in the store, which gives access
+     * to single features and attributes without creating all the features.
+     * \see features()
+     * \since QGIS 3.0
+     */
+    QgsFeatureBlock featureBlock() const { return mFeatures; }
 
     /**
      * Sets a map of optional \a parameters for the store.
@@ -102,7 +115,7 @@ class CORE_EXPORT QgsFeatureStore : public QgsFeatureSink
 
     QgsCoordinateReferenceSystem mCrs;
 
-    QgsFeatureList mFeatures;
+    QgsFeatureBlock mFeatures;
 
     // Optional parameters
     QMap<QString, QVariant> mParams;
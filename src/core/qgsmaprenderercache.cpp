@@ -33,6 +33,7 @@ void QgsMapRendererCache::clearInternal()
 {
   mExtent.setMinimal();
   mScale = 0;
+  mCrs = QgsCoordinateReferenceSystem();
 
   // make sure we are disconnected from all layers
   Q_FOREACH ( const QgsWeakMapLayerPointer &layer, mConnectedLayers )
@@ -78,20 +79,23 @@ QSet<QgsWeakMapLayerPointer > QgsMapRendererCache::dependentLayers() const
   return result;
 }
 
-bool QgsMapRendererCache::init( const QgsRectangle &extent, double scale )
+bool QgsMapRendererCache::init( const QgsRectangle &extent, double scale, const QgsCoordinateReferenceSystem &crs )
 {
   QMutexLocker lock( &mMutex );
 
   // check whether the params are the same
-  if ( extent == mExtent &&
-       qgsDoubleNear( scale, mScale ) )
+  bool sameScale = qgsDoubleNear( scale, mScale ) && crs == mCrs;
+  if ( extent == mExtent && sameScale )
     return true;
 
-  clearInternal();
+  // images rendered at the same scale can be partially reused for the new extent
+  if ( !sameScale )
+    clearInternal();
 
   // set new params
   mExtent = extent;
   mScale = scale;
+  mCrs = crs;
 
   return false;
 }
@@ -102,6 +106,7 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
 
   CacheParameters params;
   params.cachedImage = image;
+  params.extent = mExtent;
 
   // connect to the layer to listen to layer's repaintRequested() signals
   Q_FOREACH ( QgsMapLayer *layer, dependentLayers )
@@ -123,13 +128,31 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
 
 bool QgsMapRendererCache::hasCacheImage( const QString &cacheKey ) const
 {
-  return mCachedImages.contains( cacheKey );
+  QMutexLocker lock( &mMutex );
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  return it != mCachedImages.constEnd() && it.value().extent == mExtent;
 }
 
 QImage QgsMapRendererCache::cacheImage( const QString &cacheKey ) const
 {
   QMutexLocker lock( &mMutex );
-  return mCachedImages.value( cacheKey ).cachedImage;
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  if ( it == mCachedImages.constEnd() || it.value().extent != mExtent )
+    return QImage();
+  return it.value().cachedImage;
+}
+
+QImage QgsMapRendererCache::previousCacheImage( const QString &cacheKey, QgsRectangle &extent ) const
+{
+  QMutexLocker lock( &mMutex );
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  if ( it == mCachedImages.constEnd() )
+  {
+    extent = QgsRectangle();
+    return QImage();
+  }
+  extent = it.value().extent;
+  return it.value().cachedImage;
 }
 
 QList< QgsMapLayer * > QgsMapRendererCache::dependentLayers( const QString &cacheKey ) const
@@ -23,6 +23,7 @@
 
 #include "qgsrectangle.h"
 #include "qgsmaplayer.h"
+#include "qgscoordinatereferencesystem.h"
 
 
 /** \ingroup core
@@ -34,6 +35,11 @@
  * If triggered, the cache removes the rendered image (and disconnects from the
  * layers).
  *
+ * When the cache is initialized with another extent at the same scale and CRS (e.g.
+ * after a pan), the images rendered for the previous extent are kept: they are no longer
+ * returned by cacheImage(), but previousCacheImage() still gives access to them so that
+ * the part of the map which remains visible does not need to be rendered again.
+ *
  * The class is thread-safe (multiple classes can access the same instance safely).
  *
  * \since QGIS 2.4
@@ -52,11 +58,13 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     void clear();
 
     /**
-     * Initialize cache: set new parameters and clears the cache if any
-     * parameters have changed since last initialization.
+     * Initialize cache: set new parameters and clears the cache if the scale
+     * or the \a crs have changed since last initialization. If only the extent
+     * has changed, the cached images are kept as previous images.
      * \returns flag whether the parameters are the same as last time
+     * \see previousCacheImage()
      */
-    bool init( const QgsRectangle &extent, double scale );
+    bool init( const QgsRectangle &extent, double scale, const QgsCoordinateReferenceSystem &crs = QgsCoordinateReferenceSystem() );
 
     /**
      * Set the cached \a image for a particular \a cacheKey. The \a cacheKey usually
@@ -84,6 +92,16 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     QImage cacheImage( const QString &cacheKey ) const;
 
+    /**
+     * Returns the image cached for the specified \a cacheKey, either for the current
+     * extent or for a previous extent at the same scale and CRS, and sets \a extent
+     * to the extent it was rendered for.
+     * Returns a null image if there is no image for the key.
+     * \since QGIS 3.0
+     * \see cacheImage()
+     */
+    QImage previousCacheImage( const QString &cacheKey, QgsRectangle &extent SIP_OUT ) const;
+
     /**
      * Returns a list of map layers on which an image in the cache depends.
      * \since QGIS 3.0
@@ -105,6 +123,8 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     struct CacheParameters
     {
       QImage cachedImage;
+      //! Extent the image was rendered for
+      QgsRectangle extent;
       QgsWeakMapLayerPointerList dependentLayers;
     };
 
@@ -119,6 +139,7 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     mutable QMutex mMutex;
     QgsRectangle mExtent;
     double mScale = 0;
+    QgsCoordinateReferenceSystem mCrs;
 
     //! Map of cache key to cache parameters
     QMap<QString, CacheParameters> mCachedImages;
@@ -254,7 +254,8 @@ void QgsMapRendererCustomPainterJob::doRender()
       QTime layerTime;
       layerTime.start();
 
-      if ( job.img )
+      // a reused cached image is already initialized
+      if ( job.img && !job.imageInitialized )
       {
         job.img->fill( 0 );
         job.imageInitialized = true;
@@ -36,11 +36,120 @@
 #include "qgsmaplayerlistutils.h"
 #include "qgsvectorlayerlabeling.h"
 #include "qgssettings.h"
+#include "qgsrenderer.h"
+#include "qgssymbol.h"
+#include "qgssymbollayer.h"
+#include "qgssymbollayerutils.h"
+#include "qgslinesymbollayer.h"
+#include "qgsfillsymbollayer.h"
+#include "qgspainteffect.h"
 
 ///@cond PRIVATE
 
 const QString QgsMapRendererJob::LABEL_CACHE_ID = QStringLiteral( "_labels_" );
 
+/**
+ * Width in pixels of the band of a reused cached image which is rendered again along
+ * the exposed area, so that the symbols of the features around the border are complete.
+ */
+static const int CACHE_REUSE_MARGIN = 32;
+
+/**
+ * Returns true if the symbol layers of \a symbol are rendered the same way when only the exposed
+ * area of a reused cached image is rendered, and do not extend beyond CACHE_REUSE_MARGIN pixels.
+ * Lines and polygons are clipped to the rendered extent, so the symbol layers depending on the
+ * clipped geometry (dash patterns, interval or central markers, gradients, shapeburst or centroid
+ * fills) would leave seams, as well as the patterns anchored to the origin of the image.
+ */
+static bool symbolAllowsCacheReuse( QgsSymbol *symbol, QgsRenderContext &context )
+{
+  if ( !symbol )
+    return false;
+
+  Q_FOREACH ( QgsSymbolLayer *layer, symbol->symbolLayers() )
+  {
+    if ( layer->dataDefinedProperties().hasActiveProperties() )
+      return false;
+    if ( layer->paintEffect() && layer->paintEffect()->enabled() )
+      return false;
+
+    QString type = layer->layerType();
+    if ( layer->type() == QgsSymbol::Marker )
+    {
+      // points are not clipped, the markers only need to fit in the margin
+      if ( layer->subSymbol() && !symbolAllowsCacheReuse( layer->subSymbol(), context ) )
+        return false;
+    }
+    else if ( type == QLatin1String( "SimpleLine" ) )
+    {
+      QgsSimpleLineSymbolLayer *lineLayer = static_cast< QgsSimpleLineSymbolLayer * >( layer );
+      if ( lineLayer->penStyle() != Qt::SolidLine || lineLayer->useCustomDashPattern() )
+        return false;
+    }
+    else if ( type == QLatin1String( "MarkerLine" ) )
+    {
+      QgsMarkerLineSymbolLayer *markerLineLayer = static_cast< QgsMarkerLineSymbolLayer * >( layer );
+      if ( markerLineLayer->placement() != QgsMarkerLineSymbolLayer::Vertex
+           && markerLineLayer->placement() != QgsMarkerLineSymbolLayer::FirstVertex
+           && markerLineLayer->placement() != QgsMarkerLineSymbolLayer::LastVertex )
+        return false;
+      if ( !symbolAllowsCacheReuse( layer->subSymbol(), context ) )
+        return false;
+    }
+    else if ( type == QLatin1String( "SimpleFill" ) )
+    {
+      QgsSimpleFillSymbolLayer *fillLayer = static_cast< QgsSimpleFillSymbolLayer * >( layer );
+      if ( ( fillLayer->brushStyle() != Qt::SolidPattern && fillLayer->brushStyle() != Qt::NoBrush )
+           || ( fillLayer->strokeStyle() != Qt::SolidLine && fillLayer->strokeStyle() != Qt::NoPen ) )
+        return false;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  double size = 0;
+  if ( symbol->type() == QgsSymbol::Marker )
+  {
+    QRectF bounds = static_cast< QgsMarkerSymbol * >( symbol )->bounds( QPointF( 0, 0 ), context );
+    size = qMax( qMax( -bounds.left(), bounds.right() ), qMax( -bounds.top(), bounds.bottom() ) );
+  }
+  else
+  {
+    size = QgsSymbolLayerUtils::estimateMaxSymbolBleed( symbol, context );
+  }
+  return size <= CACHE_REUSE_MARGIN;
+}
+
+/**
+ * Returns true if the features of \a layer can be rendered only in the exposed area of a reused
+ * cached image, i.e. if its renderer draws each feature independently with symbols allowing it.
+ */
+static bool layerAllowsCacheReuse( QgsMapLayer *layer, QgsRenderContext &context )
+{
+  QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( layer );
+  if ( !vl )
+    return true;
+
+  QgsFeatureRenderer *renderer = vl->renderer();
+  if ( !renderer || ( renderer->paintEffect() && renderer->paintEffect()->enabled() ) )
+    return false;
+
+  // other renderers, such as heatmaps, point displacement or inverted polygons, depend on the rendered extent
+  QString type = renderer->type();
+  if ( type != QLatin1String( "singleSymbol" ) && type != QLatin1String( "categorizedSymbol" )
+       && type != QLatin1String( "graduatedSymbol" ) && type != QLatin1String( "RuleRenderer" ) )
+    return false;
+
+  Q_FOREACH ( QgsSymbol *symbol, renderer->symbols( context ) )
+  {
+    if ( !symbolAllowsCacheReuse( symbol, context ) )
+      return false;
+  }
+  return true;
+}
+
 QgsMapRendererJob::QgsMapRendererJob( const QgsMapSettings &settings )
   : mSettings( settings )
   , mCache( nullptr )
@@ -219,7 +328,7 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
 
   if ( mCache )
   {
-    bool cacheValid = mCache->init( mSettings.visibleExtent(), mSettings.scale() );
+    bool cacheValid = mCache->init( mSettings.visibleExtent(), mSettings.scale(), mSettings.destinationCrs() );
     Q_UNUSED( cacheValid );
     QgsDebugMsg( QString( "CACHE VALID: %1" ).arg( cacheValid ) );
   }
@@ -325,9 +434,41 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
       }
 
       job.img = mypFlattenedImage;
+
+      // after a pan, only the area which was not visible in the previous image of the
+      // layer is rendered. Labels and diagrams need all the features to be registered.
+      // The style overrides are not applied yet, so their symbols cannot be checked.
+      QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
+      QRect exposedRect;
+      bool reused = mCache && !( labelingEngine2 && vl && QgsPalLabeling::staticWillUseLayer( vl ) )
+                    && !mSettings.layerStyleOverrides().contains( ml->id() )
+                    && layerAllowsCacheReuse( ml, job.context )
+                    && reuseCachedImage( ml, *job.img, exposedRect );
+
       QPainter *mypPainter = new QPainter( job.img );
       mypPainter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
       job.context.setPainter( mypPainter );
+
+      if ( reused )
+      {
+        job.imageInitialized = true;
+        mypPainter->setClipRect( exposedRect );
+
+        // features just outside the exposed area may have symbols overlapping it
+        const QgsMapToPixel &mtp = mSettings.mapToPixel();
+        QRect renderRect = exposedRect.adjusted( -CACHE_REUSE_MARGIN, -CACHE_REUSE_MARGIN, CACHE_REUSE_MARGIN, CACHE_REUSE_MARGIN );
+        QgsRectangle exposedExtent( mtp.toMapCoordinates( renderRect.left(), renderRect.top() ),
+                                    mtp.toMapCoordinates( renderRect.right() + 1, renderRect.bottom() + 1 ) );
+        QgsRectangle r3;
+        if ( ct.isValid() )
+        {
+          reprojectToLayerExtent( ml, ct, exposedExtent, r3 );
+        }
+        if ( exposedExtent.isFinite() )
+        {
+          job.context.setExtent( exposedExtent );
+        }
+      }
     }
 
     bool hasStyleOverride = mSettings.layerStyleOverrides().contains( ml->id() );
@@ -344,6 +485,67 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
   return layerJobs;
 }
 
+bool QgsMapRendererJob::reuseCachedImage( const QgsMapLayer *ml, QImage &image, QRect &exposedRect ) const
+{
+  if ( !qgsDoubleNear( mSettings.rotation(), 0.0 ) )
+    return false;
+
+  QgsRectangle cachedExtent;
+  QImage cachedImage = mCache->previousCacheImage( ml->id(), cachedExtent );
+  if ( cachedImage.isNull() || cachedImage.size() != image.size() || cachedExtent.isEmpty() )
+    return false;
+
+  // the previous image must have the same resolution
+  double mupp = mSettings.mapUnitsPerPixel();
+  if ( !qgsDoubleNear( cachedExtent.width() / cachedImage.width(), mupp, mupp * 1e-6 ) )
+    return false;
+
+  // ... and be aligned on the pixels of the new one
+  QgsRectangle extent = mSettings.visibleExtent();
+  double dx = ( cachedExtent.xMinimum() - extent.xMinimum() ) / mupp;
+  double dy = ( extent.yMaximum() - cachedExtent.yMaximum() ) / mupp;
+  int offsetX = qRound( dx );
+  int offsetY = qRound( dy );
+  if ( !qgsDoubleNear( dx, offsetX, 0.01 ) || !qgsDoubleNear( dy, offsetY, 0.01 ) )
+    return false;
+
+  // the layer is rendered with a single extent: a diagonal pan exposes an L shaped area
+  // whose bounding box is the whole map, which is rendered again
+  if ( ( offsetX != 0 ) == ( offsetY != 0 ) )
+    return false;
+
+  QRect imageRect( QPoint( 0, 0 ), image.size() );
+  QRect reusedRect = QRect( QPoint( offsetX, offsetY ), cachedImage.size() ).intersected( imageRect );
+  if ( offsetX > 0 )
+    reusedRect.setLeft( reusedRect.left() + CACHE_REUSE_MARGIN );
+  else if ( offsetX < 0 )
+    reusedRect.setRight( reusedRect.right() - CACHE_REUSE_MARGIN );
+  else if ( offsetY > 0 )
+    reusedRect.setTop( reusedRect.top() + CACHE_REUSE_MARGIN );
+  else
+    reusedRect.setBottom( reusedRect.bottom() - CACHE_REUSE_MARGIN );
+  if ( reusedRect.isEmpty() )
+    return false;
+
+  if ( offsetX > 0 )
+    exposedRect = QRect( 0, 0, reusedRect.left(), image.height() );
+  else if ( offsetX < 0 )
+    exposedRect = QRect( reusedRect.right() + 1, 0, image.width() - reusedRect.right() - 1, image.height() );
+  else if ( offsetY > 0 )
+    exposedRect = QRect( 0, 0, image.width(), reusedRect.top() );
+  else
+    exposedRect = QRect( 0, reusedRect.bottom() + 1, image.width(), image.height() - reusedRect.bottom() - 1 );
+
+  image.fill( 0 );
+  QPainter painter( &image );
+  painter.setCompositionMode( QPainter::CompositionMode_Source );
+  painter.drawImage( reusedRect.topLeft(), cachedImage, reusedRect.translated( -offsetX, -offsetY ) );
+  painter.end();
+
+  QgsDebugMsgLevel( QString( "reusing cached image of layer %1, rendering %2x%3 pixels" ).arg( ml->id() ).arg( exposedRect.width() ).arg( exposedRect.height() ), 2 );
+  return true;
+}
+
 LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabelingEngine *labelingEngine2, bool canUseLabelCache )
 {
   LabelRenderJob job;
@@ -497,6 +699,13 @@ QImage QgsMapRendererJob::composeImage( const QgsMapSettings &settings, const La
 
 void QgsMapRendererJob::logRenderingTime( const LayerRenderJobs &jobs, const LabelRenderJob &labelJob )
 {
+  mPerLayerRenderingTime.clear();
+  Q_FOREACH ( const LayerRenderJob &job, jobs )
+  {
+    if ( job.layer )
+      mPerLayerRenderingTime[ job.layer->id()] += job.renderingTime;
+  }
+
   QgsSettings settings;
   if ( !settings.value( QStringLiteral( "Map/logCanvasRefreshEvent" ), false ).toBool() )
     return;
@@ -21,6 +21,7 @@
 #include "qgis.h"
 #include <QtConcurrentRun>
 #include <QFutureWatcher>
+#include <QHash>
 #include <QImage>
 #include <QPainter>
 #include <QObject>
@@ -190,6 +191,14 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
     //! Find out how long it took to finish the job (in milliseconds)
     int renderingTime() const { return mRenderingTime; }
 
+    /**
+     * Returns how long it took to render each layer (in milliseconds), by layer ID.
+     * Available when the rendering has been finished.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QHash< QString, int > perLayerRenderingTime() const { return mPerLayerRenderingTime; } SIP_SKIP
+
     /**
      * Return map settings with which this job was started.
      * \returns A QgsMapSettings instance with render settings
@@ -227,6 +236,9 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     int mRenderingTime = 0;
 
+    //! Render time of the layers by layer ID
+    QHash< QString, int > mPerLayerRenderingTime;
+
     /**
      * Prepares the cache for storing the result of labeling. Returns false if
      * the render cannot use cached labels and should not cache the result.
@@ -276,6 +288,15 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     bool needTemporaryImage( QgsMapLayer *ml );
 
+    /**
+     * Copies into \a image the part of the image cached for \a ml at a previous extent
+     * which is still visible, when the map has been panned horizontally or vertically.
+     * Returns false if no cached image can be reused, otherwise \a exposedRect is set
+     * to the area of the image which remains to be rendered. The symbols of the layer
+     * must allow rendering only this area, which prepareJobs() checks beforehand.
+     */
+    bool reuseCachedImage( const QgsMapLayer *ml, QImage &image, QRect &exposedRect ) const;
+
     const QgsFeatureFilterProvider *mFeatureFilterProvider = nullptr;
 };
 
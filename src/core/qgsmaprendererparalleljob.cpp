@@ -241,7 +241,8 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
   if ( job.cached )
     return;
 
-  if ( job.img )
+  // a reused cached image is already initialized
+  if ( job.img && !job.imageInitialized )
   {
     job.img->fill( 0 );
     job.imageInitialized = true;
@@ -27,6 +27,7 @@
 #include "qgspluginlayer.h"
 #include "qgspluginlayerregistry.h"
 #include "qgsprojectfiletransform.h"
+#include "qgsprojectsnapshot.h"
 #include "qgssnappingconfig.h"
 #include "qgspathresolver.h"
 #include "qgsprojectversion.h"
@@ -662,7 +663,8 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
 
   bool returnStatus = true;
 
-  emit layerLoaded( 0, nl.count() );
+  if ( !mDeferLayerLoading )
+    emit layerLoaded( 0, nl.count() );
 
   // order layers based on their dependencies
   QgsLayerDefinition::DependencySorter depSorter( doc );
@@ -676,6 +678,13 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
   {
     QDomElement element = node.toElement();
 
+    // the layer is read when it is first requested
+    if ( mDeferLayerLoading && element.attribute( QStringLiteral( "embedded" ) ) != QLatin1String( "1" ) )
+    {
+      mDeferredLayerElements.insert( element.firstChildElement( QStringLiteral( "id" ) ).text(), element );
+      continue;
+    }
+
     QString name = node.namedItem( QStringLiteral( "layername" ) ).toElement().text();
     if ( !name.isNull() )
       emit loadingLayer( tr( "Loading layer %1" ).arg( name ) );
@@ -758,46 +767,78 @@ bool QgsProject::read( const QString &filename )
   return read();
 }
 
+void QgsProject::setUseSnapshot( bool useSnapshot )
+{
+  mUseSnapshot = useSnapshot;
+}
+
+bool QgsProject::useSnapshot() const
+{
+  return mUseSnapshot;
+}
+
+void QgsProject::setDeferLayerLoading( bool defer )
+{
+  mDeferLayerLoading = defer;
+}
+
+bool QgsProject::deferLayerLoading() const
+{
+  return mDeferLayerLoading;
+}
+
 bool QgsProject::read()
 {
   clearError();
 
   std::unique_ptr<QDomDocument> doc( new QDomDocument( QStringLiteral( "qgis" ) ) );
 
-  if ( !mFile.open( QIODevice::ReadOnly | QIODevice::Text ) )
+  // the snapshot spares parsing the XML of large projects
+  if ( !mUseSnapshot || !QgsProjectSnapshot::read( mFile.fileName(), *doc ) )
   {
-    mFile.close();
+    // not in text mode, the raw bytes are hashed for the snapshot and the parser handles the line endings
+    if ( !mFile.open( QIODevice::ReadOnly ) )
+    {
+      mFile.close();
 
-    setError( tr( "Unable to open %1" ).arg( mFile.fileName() ) );
+      setError( tr( "Unable to open %1" ).arg( mFile.fileName() ) );
 
-    return false;
-  }
+      return false;
+    }
 
-  // location of problem associated with errorMsg
-  int line, column;
-  QString errorMsg;
+    // location of problem associated with errorMsg
+    int line, column;
+    QString errorMsg;
 
-  if ( !doc->setContent( &mFile, &errorMsg, &line, &column ) )
-  {
-    // want to make this class as GUI independent as possible; so commented out
+    // the snapshot is written for the very content which is parsed
+    QByteArray content = mFile.readAll();
+    if ( !doc->setContent( content, &errorMsg, &line, &column ) )
+    {
+      // want to make this class as GUI independent as possible; so commented out
 #if 0
-    QMessageBox::critical( 0, tr( "Project File Read Error" ),
-                           tr( "%1 at line %2 column %3" ).arg( errorMsg ).arg( line ).arg( column ) );
+      QMessageBox::critical( 0, tr( "Project File Read Error" ),
+                             tr( "%1 at line %2 column %3" ).arg( errorMsg ).arg( line ).arg( column ) );
 #endif
 
-    QString errorString = tr( "Project file read error in file %1: %2 at line %3 column %4" )
-                          .arg( mFile.fileName() ).arg( errorMsg ).arg( line ).arg( column );
+      QString errorString = tr( "Project file read error in file %1: %2 at line %3 column %4" )
+                            .arg( mFile.fileName() ).arg( errorMsg ).arg( line ).arg( column );
 
-    QgsDebugMsg( errorString );
+      QgsDebugMsg( errorString );
 
-    mFile.close();
+      mFile.close();
 
-    setError( tr( "%1 for file %2" ).arg( errorString, mFile.fileName() ) );
+      setError( tr( "%1 for file %2" ).arg( errorString, mFile.fileName() ) );
 
-    return false;
-  }
+      return false;
+    }
 
-  mFile.close();
+    mFile.close();
+
+    if ( mUseSnapshot )
+    {
+      QgsProjectSnapshot::write( mFile.fileName(), *doc, content );
+    }
+  }
 
 
   QgsDebugMsg( "Opened document " + mFile.fileName() );
@@ -919,8 +960,10 @@ bool QgsProject::read()
   // load embedded groups and layers
   loadEmbeddedNodes( mRootGroup );
 
-  // now that layers are loaded, we can resolve layer tree's references to the layers
-  mRootGroup->resolveReferences( this );
+  // now that layers are loaded, we can resolve layer tree's references to the layers,
+  // the nodes of deferred layers are resolved when the layers are read
+  if ( mDeferredLayerElements.isEmpty() )
+    mRootGroup->resolveReferences( this );
 
 
   if ( !layerTreeElem.isNull() )
@@ -935,7 +978,8 @@ bool QgsProject::read()
   }
 
   // make sure the are just valid layers
-  QgsLayerTreeUtils::removeInvalidLayers( mRootGroup );
+  if ( mDeferredLayerElements.isEmpty() )
+    QgsLayerTreeUtils::removeInvalidLayers( mRootGroup );
 
   mRootGroup->removeCustomProperty( QStringLiteral( "loading" ) );
 
@@ -950,7 +994,7 @@ bool QgsProject::read()
   mLayoutManager->readXml( doc->documentElement(), *doc );
 
   // reassign change dependencies now that all layers are loaded
-  QMap<QString, QgsMapLayer *> existingMaps = mapLayers();
+  QMap<QString, QgsMapLayer *> existingMaps = mLayerStore->mapLayers();
   for ( QMap<QString, QgsMapLayer *>::iterator it = existingMaps.begin(); it != existingMaps.end(); it++ )
   {
     it.value()->setDependencies( it.value()->dependencies() );
@@ -980,6 +1024,10 @@ bool QgsProject::read()
   // read the project: used by map canvas and legend
   emit readProject( *doc );
 
+  // keep the elements of the layers not read yet
+  if ( !mDeferredLayerElements.isEmpty() )
+    mDeferredLayersDocument = std::move( doc );
+
   // if all went well, we're allegedly in pristine state
   if ( clean )
     setDirty( false );
@@ -1225,6 +1273,9 @@ bool QgsProject::write()
 {
   clearError();
 
+  // write all the layers, including the ones not read yet
+  readDeferredLayers();
+
   // if we have problems creating or otherwise writing to the project file,
   // let's find out up front before we go through all the hand-waving
   // necessary to create all the Dom objects
@@ -2046,7 +2097,7 @@ QMap<QPair<QString, QString>, QgsTransactionGroup *> QgsProject::transactionGrou
 
 int QgsProject::count() const
 {
-  return mLayerStore->count();
+  return mLayerStore->count() + mDeferredLayerElements.count();
 }
 
 QgsMapLayer *QgsProject::mapLayer( const QString &layerId ) const
@@ -2085,6 +2136,10 @@ QgsProject::addMapLayer( QgsMapLayer *layer,
 
 void QgsProject::removeMapLayers( const QStringList &layerIds )
 {
+  Q_FOREACH ( const QString &layerId, layerIds )
+  {
+    removeDeferredLayer( layerId );
+  }
   mLayerStore->removeMapLayers( layerIds );
 }
 
@@ -2095,6 +2150,7 @@ void QgsProject::removeMapLayers( const QList<QgsMapLayer *> &layers )
 
 void QgsProject::removeMapLayer( const QString &layerId )
 {
+  removeDeferredLayer( layerId );
   mLayerStore->removeMapLayer( layerId );
 }
 
@@ -2110,6 +2166,8 @@ QgsMapLayer *QgsProject::takeMapLayer( QgsMapLayer *layer )
 
 void QgsProject::removeAllMapLayers()
 {
+  mDeferredLayerElements.clear();
+  mDeferredLayersDocument.reset();
   mLayerStore->removeAllMapLayers();
 }
 
@@ -2128,4 +2186,88 @@ QMap<QString, QgsMapLayer *> QgsProject::mapLayers() const
   return mLayerStore->mapLayers();
 }
 
+QStringList QgsProject::deferredLayerIds() const
+{
+  return mDeferredLayerElements.keys();
+}
+
+QgsMapLayer *QgsProject::readDeferredLayer( const QString &layerId )
+{
+  QDomElement element = mDeferredLayerElements.take( layerId );
+  if ( element.isNull() )
+    return nullptr;
+
+  QgsDebugMsg( "Reading deferred layer " + layerId );
+
+  QgsReadWriteContext context;
+  context.setPathResolver( pathResolver() );
+
+  // the layer tree already has the nodes of the layer
+  bool bridgeEnabled = mLayerTreeRegistryBridge->isEnabled();
+  mLayerTreeRegistryBridge->setEnabled( false );
+  QList<QDomNode> brokenNodes;
+  bool added = addLayer( element, brokenNodes, context );
+  mLayerTreeRegistryBridge->setEnabled( bridgeEnabled );
+
+  if ( mDeferredLayerElements.isEmpty() )
+    mDeferredLayersDocument.reset();
+
+  QgsMapLayer *layer = added ? mLayerStore->mapLayer( layerId ) : nullptr;
+  if ( !layer )
+  {
+    QgsMessageLog::logMessage( tr( "Unable to read layer %1" ).arg( layerId ), tr( "Project" ) );
+    return nullptr;
+  }
+
+  // the layers referenced by the layer are read too
+  Q_FOREACH ( const QgsMapLayerDependency &dependency, layer->dependencies() )
+  {
+    readDeferredLayer( dependency.layerId() );
+  }
+  if ( QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( layer ) )
+  {
+    Q_FOREACH ( const QgsVectorLayerJoinInfo &join, vl->vectorJoins() )
+    {
+      readDeferredLayer( join.joinLayerId() );
+    }
+    vl->resolveReferences( this );
+  }
+  layer->setDependencies( layer->dependencies() );
+
+  Q_FOREACH ( QgsLayerTreeLayer *node, mRootGroup->findLayers() )
+  {
+    if ( node->layerId() == layerId )
+      node->resolveReferences( this );
+  }
+
+  return layer;
+}
+
+void QgsProject::removeDeferredLayer( const QString &layerId )
+{
+  if ( !mDeferredLayerElements.remove( layerId ) )
+    return;
+
+  // as the layer tree registry bridge does for the layers which are read
+  Q_FOREACH ( QgsLayerTreeLayer *node, mRootGroup->findLayers() )
+  {
+    if ( node->layerId() == layerId )
+    {
+      if ( QgsLayerTreeGroup *group = qobject_cast<QgsLayerTreeGroup *>( node->parent() ) )
+        group->removeChildNode( node );
+    }
+  }
+
+  if ( mDeferredLayerElements.isEmpty() )
+    mDeferredLayersDocument.reset();
+}
+
+void QgsProject::readDeferredLayers()
+{
+  while ( !mDeferredLayerElements.isEmpty() )
+  {
+    readDeferredLayer( mDeferredLayerElements.constBegin().key() );
+  }
+}
+
 
@@ -25,6 +25,8 @@
 #include "qgis_sip.h"
 #include "qgis.h"
 #include <memory>
+#include <QDomDocument>
+#include <QDomElement>
 #include <QHash>
 #include <QList>
 #include <QObject>
@@ -186,6 +188,64 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
      */
     bool read();
 
+    /** Sets whether the project is read from a binary snapshot of the project file.
+     * When enabled, read() loads the project document from the snapshot stored next
+     * to the project file if it matches the content of the file, and writes the
+     * snapshot when the project is read from its XML.
+     * \see useSnapshot()
+     * \see QgsProjectSnapshot
+     * \since QGIS 3.0
+     */
+    void setUseSnapshot( bool useSnapshot );
+
+    /** Returns true if the project is read from a binary snapshot of the project file.
+     * \see setUseSnapshot()
+     * \since QGIS 3.0
+     */
+    bool useSnapshot() const;
+
+    /** Sets whether the layers are read on demand.
+     * When enabled, read() does not create the layers of the project file. A layer is
+     * read, and its data provider opened, by readDeferredLayer() or readDeferredLayers().
+     * The layer tree nodes of a layer are attached to it when it is read. Embedded layers
+     * are read with the project.
+     * \note mapLayer(), mapLayersByName(), mapLayers() and layerStore() only return the
+     * layers which are already read, they never modify the project.
+     * \see deferLayerLoading()
+     * \see deferredLayerIds()
+     * \since QGIS 3.0
+     */
+    void setDeferLayerLoading( bool defer );
+
+    /** Returns true if the layers are read on demand.
+     * \see setDeferLayerLoading()
+     * \since QGIS 3.0
+     */
+    bool deferLayerLoading() const;
+
+    /** Returns the ids of the layers which are not read yet.
+     * \see setDeferLayerLoading()
+     * \see readDeferredLayer()
+     * \since QGIS 3.0
+     */
+    QStringList deferredLayerIds() const;
+
+    /** Reads the deferred layer \a layerId, with the deferred layers referenced by its
+     * joins and dependencies.
+     * \returns the layer, or nullptr if it is not a deferred layer or cannot be read
+     * \see setDeferLayerLoading()
+     * \see readDeferredLayers()
+     * \since QGIS 3.0
+     */
+    QgsMapLayer *readDeferredLayer( const QString &layerId );
+
+    /** Reads all the deferred layers.
+     * \see setDeferLayerLoading()
+     * \see readDeferredLayer()
+     * \since QGIS 3.0
+     */
+    void readDeferredLayers();
+
     /** Reads the layer described in the associated DOM node.
      *
      * \note This method is mainly for use by QgsProjectBadLayerHandler subclasses
@@ -1004,6 +1064,9 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
     //! \note not available in Python bindings
     void loadEmbeddedNodes( QgsLayerTreeGroup *group ) SIP_SKIP;
 
+    //! Removes the deferred layer \a layerId and its layer tree nodes
+    void removeDeferredLayer( const QString &layerId ) SIP_SKIP;
+
     std::unique_ptr< QgsMapLayerStore > mLayerStore;
 
     QString mErrorMessage;
@@ -1043,6 +1106,10 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
     bool mEvaluateDefaultValues; // evaluate default values immediately
     QgsCoordinateReferenceSystem mCrs;
     bool mDirty;                 // project has been modified since it has been read or saved
+    bool mUseSnapshot = false;   // read the project from its binary snapshot
+    bool mDeferLayerLoading = false; // read the layers on demand
+    QHash< QString, QDomElement > mDeferredLayerElements; // elements of the layers not read yet, by layer id
+    std::unique_ptr< QDomDocument > mDeferredLayersDocument; // document holding the elements of the deferred layers
 };
 
 /** Return the version string found in the given DOM document
@@ -0,0 +1,409 @@
+/***************************************************************************
+                          qgsprojectsnapshot.cpp
+                          ----------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsprojectsnapshot.h"
+#include "qgis.h"
+#include "qgslogger.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDomDocument>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSaveFile>
+#include <QVector>
+
+namespace
+{
+  const quint32 SNAPSHOT_MAGIC = 0x51475353; // "QGSS"
+  const quint32 SNAPSHOT_FORMAT = 1;
+
+  //! Node types of the snapshot, the other DOM nodes are not stored
+  enum NodeType
+  {
+    ElementNode = 1,
+    TextNode,
+    CDATASectionNode,
+    CommentNode,
+    ProcessingInstructionNode
+  };
+
+  //! Size and hash of the content of a project file
+  struct FileSignature
+  {
+    qint64 size = -1;
+    QByteArray hash;
+  };
+
+  bool fileSignature( const QString &path, FileSignature &signature )
+  {
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) )
+      return false;
+
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    if ( !hash.addData( &file ) )
+      return false;
+
+    signature.size = file.size();
+    signature.hash = hash.result();
+    return true;
+  }
+
+  FileSignature contentSignature( const QByteArray &content )
+  {
+    FileSignature signature;
+    signature.size = content.size();
+    signature.hash = QCryptographicHash::hash( content, QCryptographicHash::Sha1 );
+    return signature;
+  }
+
+  //! Writes the nodes with the strings replaced by their index in a shared table
+  class SnapshotWriter
+  {
+    public:
+      explicit SnapshotWriter( QDataStream &stream )
+        : mStream( stream )
+      {}
+
+      void writeChildren( const QDomNode &parent )
+      {
+        QList< QDomNode > children;
+        for ( QDomNode child = parent.firstChild(); !child.isNull(); child = child.nextSibling() )
+        {
+          switch ( child.nodeType() )
+          {
+            case QDomNode::ElementNode:
+            case QDomNode::TextNode:
+            case QDomNode::CDATASectionNode:
+            case QDomNode::CommentNode:
+            case QDomNode::ProcessingInstructionNode:
+              children << child;
+              break;
+            default:
+              break;
+          }
+        }
+
+        mStream << static_cast< quint32 >( children.size() );
+        Q_FOREACH ( const QDomNode &child, children )
+        {
+          writeNode( child );
+        }
+      }
+
+      const QVector< QString > &strings() const { return mStrings; }
+
+    private:
+      void writeNode( const QDomNode &node )
+      {
+        switch ( node.nodeType() )
+        {
+          case QDomNode::ElementNode:
+          {
+            QDomElement element = node.toElement();
+            mStream << static_cast< quint8 >( ElementNode ) << stringIndex( element.tagName() );
+            QDomNamedNodeMap attributes = element.attributes();
+            mStream << static_cast< quint32 >( attributes.count() );
+            for ( int i = 0; i < attributes.count(); ++i )
+            {
+              QDomAttr attribute = attributes.item( i ).toAttr();
+              mStream << stringIndex( attribute.name() ) << stringIndex( attribute.value() );
+            }
+            writeChildren( node );
+            break;
+          }
+          case QDomNode::TextNode:
+            mStream << static_cast< quint8 >( TextNode ) << stringIndex( node.nodeValue() );
+            break;
+          case QDomNode::CDATASectionNode:
+            mStream << static_cast< quint8 >( CDATASectionNode ) << stringIndex( node.nodeValue() );
+            break;
+          case QDomNode::CommentNode:
+            mStream << static_cast< quint8 >( CommentNode ) << stringIndex( node.nodeValue() );
+            break;
+          case QDomNode::ProcessingInstructionNode:
+          {
+            QDomProcessingInstruction instruction = node.toProcessingInstruction();
+            mStream << static_cast< quint8 >( ProcessingInstructionNode ) << stringIndex( instruction.target() ) << stringIndex( instruction.data() );
+            break;
+          }
+          default:
+            break;
+        }
+      }
+
+      quint32 stringIndex( const QString &string )
+      {
+        QHash< QString, quint32 >::const_iterator it = mStringIndexes.constFind( string );
+        if ( it != mStringIndexes.constEnd() )
+          return it.value();
+
+        quint32 index = static_cast< quint32 >( mStrings.size() );
+        mStrings << string;
+        mStringIndexes.insert( string, index );
+        return index;
+      }
+
+      QDataStream &mStream;
+      QVector< QString > mStrings;
+      QHash< QString, quint32 > mStringIndexes;
+  };
+
+  //! Rebuilds the nodes, sharing the strings of the table between them
+  class SnapshotReader
+  {
+    public:
+      SnapshotReader( QDataStream &stream, const QVector< QString > &strings, QDomDocument &doc, bool namespaceProcessing )
+        : mStream( stream )
+        , mStrings( strings )
+        , mDoc( doc )
+        , mNamespaceProcessing( namespaceProcessing )
+      {
+        // the prefix bound by the XML specification
+        mNamespaces << QHash< QString, QString >();
+        mNamespaces.last().insert( QStringLiteral( "xml" ), QStringLiteral( "http://www.w3.org/XML/1998/namespace" ) );
+      }
+
+      bool readChildren( QDomNode &parent )
+      {
+        quint32 count = 0;
+        mStream >> count;
+        for ( quint32 i = 0; i < count; ++i )
+        {
+          if ( mStream.status() != QDataStream::Ok || !readNode( parent ) )
+            return false;
+        }
+        return mStream.status() == QDataStream::Ok;
+      }
+
+    private:
+      bool readNode( QDomNode &parent )
+      {
+        quint8 type = 0;
+        mStream >> type;
+        switch ( type )
+        {
+          case ElementNode:
+          {
+            QString tagName;
+            quint32 attributeCount = 0;
+            if ( !readString( tagName ) )
+              return false;
+            mStream >> attributeCount;
+
+            QList< QPair< QString, QString > > attributes;
+            for ( quint32 i = 0; i < attributeCount; ++i )
+            {
+              QString name;
+              QString value;
+              if ( !readString( name ) || !readString( value ) )
+                return false;
+              attributes << qMakePair( name, value );
+            }
+
+            if ( !mNamespaceProcessing )
+            {
+              QDomElement element = mDoc.createElement( tagName );
+              for ( int i = 0; i < attributes.size(); ++i )
+              {
+                element.setAttribute( attributes.at( i ).first, attributes.at( i ).second );
+              }
+              parent.appendChild( element );
+              return readChildren( element );
+            }
+
+            // the snapshot is written from a document parsed without namespace processing,
+            // the namespace declarations are resolved as the XML parser would do
+            QHash< QString, QString > namespaces = mNamespaces.last();
+            for ( int i = 0; i < attributes.size(); ++i )
+            {
+              const QString &name = attributes.at( i ).first;
+              if ( name == QLatin1String( "xmlns" ) )
+                namespaces.insert( QString(), attributes.at( i ).second );
+              else if ( name.startsWith( QLatin1String( "xmlns:" ) ) )
+                namespaces.insert( name.mid( 6 ), attributes.at( i ).second );
+            }
+
+            QString namespaceUri;
+            if ( !resolveNamespace( namespaces, tagName, true, namespaceUri ) )
+              return false;
+            QDomElement element = mDoc.createElementNS( namespaceUri, tagName );
+            for ( int i = 0; i < attributes.size(); ++i )
+            {
+              const QString &name = attributes.at( i ).first;
+              // the namespace declarations are not attributes of a namespace aware document
+              if ( name == QLatin1String( "xmlns" ) || name.startsWith( QLatin1String( "xmlns:" ) ) )
+                continue;
+              if ( !resolveNamespace( namespaces, name, false, namespaceUri ) )
+                return false;
+              element.setAttributeNS( namespaceUri, name, attributes.at( i ).second );
+            }
+            parent.appendChild( element );
+
+            mNamespaces << namespaces;
+            bool ok = readChildren( element );
+            mNamespaces.removeLast();
+            return ok;
+          }
+          case TextNode:
+          case CDATASectionNode:
+          case CommentNode:
+          {
+            QString value;
+            if ( !readString( value ) )
+              return false;
+            if ( type == TextNode )
+              parent.appendChild( mDoc.createTextNode( value ) );
+            else if ( type == CDATASectionNode )
+              parent.appendChild( mDoc.createCDATASection( value ) );
+            else
+              parent.appendChild( mDoc.createComment( value ) );
+            return true;
+          }
+          case ProcessingInstructionNode:
+          {
+            QString target;
+            QString data;
+            if ( !readString( target ) || !readString( data ) )
+              return false;
+            parent.appendChild( mDoc.createProcessingInstruction( target, data ) );
+            return true;
+          }
+          default:
+            return false;
+        }
+      }
+
+      /** Returns the namespace URI of the qualified name of an element or an attribute,
+       * unprefixed attributes have no namespace. Returns false for an undeclared prefix.
+       */
+      static bool resolveNamespace( const QHash< QString, QString > &namespaces, const QString &qualifiedName, bool isElement, QString &namespaceUri )
+      {
+        int colon = qualifiedName.indexOf( ':' );
+        if ( colon < 0 )
+        {
+          namespaceUri = isElement ? namespaces.value( QString() ) : QString();
+          return true;
+        }
+
+        QHash< QString, QString >::const_iterator it = namespaces.constFind( qualifiedName.left( colon ) );
+        if ( it == namespaces.constEnd() )
+          return false;
+        namespaceUri = it.value();
+        return true;
+      }
+
+      bool readString( QString &string )
+      {
+        quint32 index = 0;
+        mStream >> index;
+        if ( mStream.status() != QDataStream::Ok || index >= static_cast< quint32 >( mStrings.size() ) )
+          return false;
+        string = mStrings.at( index );
+        return true;
+      }
+
+      QDataStream &mStream;
+      const QVector< QString > &mStrings;
+      QDomDocument &mDoc;
+      bool mNamespaceProcessing;
+      //! Namespace URIs by prefix in the scope of the elements being read
+      QList< QHash< QString, QString > > mNamespaces;
+  };
+}
+
+QString QgsProjectSnapshot::snapshotPath( const QString &projectPath )
+{
+  return projectPath + QStringLiteral( ".snapshot" );
+}
+
+bool QgsProjectSnapshot::read( const QString &projectPath, QDomDocument &doc, bool namespaceProcessing )
+{
+  QFile file( snapshotPath( projectPath ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QByteArray content = file.readAll();
+  file.close();
+
+  QDataStream stream( content );
+  stream.setVersion( QDataStream::Qt_5_0 );
+
+  quint32 magic = 0;
+  quint32 format = 0;
+  qint32 qgisVersion = 0;
+  FileSignature snapshotSignature;
+  stream >> magic >> format >> qgisVersion >> snapshotSignature.size >> snapshotSignature.hash;
+  if ( stream.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || format != SNAPSHOT_FORMAT || qgisVersion != Qgis::QGIS_VERSION_INT )
+    return false;
+
+  FileSignature projectSignature;
+  if ( !fileSignature( projectPath, projectSignature )
+       || projectSignature.size != snapshotSignature.size
+       || projectSignature.hash != snapshotSignature.hash )
+  {
+    QgsDebugMsg( QString( "Snapshot of project %1 is outdated" ).arg( projectPath ) );
+    return false;
+  }
+
+  QVector< QString > strings;
+  stream >> strings;
+  if ( stream.status() != QDataStream::Ok )
+    return false;
+
+  doc.clear();
+  SnapshotReader reader( stream, strings, doc, namespaceProcessing );
+  if ( !reader.readChildren( doc ) || doc.documentElement().isNull() )
+  {
+    QgsDebugMsg( QString( "Snapshot of project %1 is corrupted" ).arg( projectPath ) );
+    doc.clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool QgsProjectSnapshot::write( const QString &projectPath, const QDomDocument &doc, const QByteArray &content )
+{
+  // the signature of the parsed content, the file could have been modified since it was read
+  FileSignature signature = contentSignature( content );
+
+  QByteArray nodes;
+  QDataStream nodeStream( &nodes, QIODevice::WriteOnly );
+  nodeStream.setVersion( QDataStream::Qt_5_0 );
+  SnapshotWriter writer( nodeStream );
+  writer.writeChildren( doc );
+
+  QSaveFile file( snapshotPath( projectPath ) );
+  if ( !file.open( QIODevice::WriteOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  stream << SNAPSHOT_MAGIC << SNAPSHOT_FORMAT << static_cast< qint32 >( Qgis::QGIS_VERSION_INT )
+         << signature.size << signature.hash << writer.strings();
+  stream.writeRawData( nodes.constData(), nodes.size() );
+
+  if ( stream.status() != QDataStream::Ok || !file.commit() )
+  {
+    QgsDebugMsg( QString( "Cannot write the snapshot of project %1" ).arg( projectPath ) );
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+                          qgsprojectsnapshot.h
+                          --------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPROJECTSNAPSHOT_H
+#define QGSPROJECTSNAPSHOT_H
+
+#include "qgis_core.h"
+
+#include <QString>
+#include <QByteArray>
+
+class QDomDocument;
+
+/** \ingroup core
+ * Binary snapshot of the DOM document of a project file.
+ *
+ * The snapshot is stored next to the project file and holds the parsed document
+ * in a compact binary form, which is much faster to load than the XML of large
+ * projects. A snapshot is only valid for the exact content of the project file
+ * it was written for: it is validated against the size and the SHA-1 hash of
+ * the project file, so that a modified project is always read from its XML.
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsProjectSnapshot
+{
+  public:
+
+    /** Returns the path of the snapshot of the project file \a projectPath.
+     */
+    static QString snapshotPath( const QString &projectPath );
+
+    /** Reads the snapshot of a project file.
+     * \param projectPath the path of the project file
+     * \param doc the document to fill with the content of the snapshot
+     * \param namespaceProcessing true to resolve the namespaces of the elements and
+     * attributes, giving the same document as QDomDocument::setContent() with namespace
+     * processing. The namespace declarations are then not stored as attributes.
+     * \returns false if there is no valid snapshot for the current content of the project file
+     */
+    static bool read( const QString &projectPath, QDomDocument &doc, bool namespaceProcessing = false );
+
+    /** Writes the snapshot of a project file.
+     * \param projectPath the path of the project file
+     * \param doc the document parsed from \a content
+     * \param content the content of the project file which \a doc has been parsed from. The snapshot
+     * is only valid while the project file has this content, so it must be the very bytes which were parsed
+     * and not the content of the file read again, which could have been modified in the meantime.
+     * \returns false if the snapshot cannot be written, e.g. in a read only directory
+     */
+    static bool write( const QString &projectPath, const QDomDocument &doc, const QByteArray &content );
+};
+
+#endif // QGSPROJECTSNAPSHOT_H
@@ -32,6 +32,7 @@
 #include <QDomNode>
 #include <QVector>
 #include <QStringBuilder>
+#include <QMutexLocker>
 
 #include "qgssettings.h"
 #include "qgsvectorlayer.h"
@@ -168,6 +169,15 @@ QgsVectorLayer::QgsVectorLayer( const QString &vectorLayerPath,
   }
 
   connect( this, &QgsVectorLayer::selectionChanged, this, [ = ] { emit repaintRequested(); } );
+
+  connect( this, &QgsVectorLayer::dataChanged, this, &QgsVectorLayer::invalidateAggregateCache );
+  connect( this, &QgsVectorLayer::layerModified, this, &QgsVectorLayer::invalidateAggregateCache );
+  connect( this, &QgsVectorLayer::editingStopped, this, &QgsVectorLayer::invalidateAggregateCache );
+  connect( this, &QgsVectorLayer::updatedFields, this, &QgsVectorLayer::invalidateAggregateCache );
+  connect( this, &QgsVectorLayer::featureAdded, this, &QgsVectorLayer::invalidateAggregateCache );
+  connect( this, &QgsVectorLayer::featureDeleted, this, &QgsVectorLayer::invalidateAggregateCache );
+  connect( this, &QgsVectorLayer::attributeValueChanged, this, &QgsVectorLayer::invalidateAggregateCache );
+  connect( this, &QgsVectorLayer::geometryChanged, this, &QgsVectorLayer::invalidateAggregateCache );
   connect( QgsProject::instance()->relationManager(), &QgsRelationManager::relationsLoaded, this, &QgsVectorLayer::onRelationsLoaded );
 
   // Default simplify drawing settings
@@ -241,6 +251,7 @@ void QgsVectorLayer::reload()
   {
     mDataProvider->reloadData();
     updateFields();
+    invalidateAggregateCache();
   }
 }
 
@@ -826,6 +837,7 @@ bool QgsVectorLayer::setSubsetString( const QString &subset )
   mDataSource = mDataProvider->dataSourceUri();
   updateExtents();
   updateFields();
+  invalidateAggregateCache();
 
   if ( res )
     emit repaintRequested();
@@ -3302,6 +3314,71 @@ QVariant QgsVectorLayer::maximumValue( int index ) const
   return QVariant();
 }
 
+///@cond PRIVATE
+
+//! Maximal number of aggregates in the cache of a layer, the cache is emptied when it is full
+static const int MAX_CACHED_AGGREGATES = 1000;
+
+//! Returns true if the field at \a index of \a fields is read from the data provider, i.e. is neither joined nor virtual
+static bool isProviderField( const QgsFields &fields, int index )
+{
+  return index >= 0 && fields.fieldOrigin( index ) == QgsFields::OriginProvider;
+}
+
+/** Returns true if the result of \a expression evaluated for the features of a layer with \a fields only depends
+ * on the data of the layer, i.e. if the expression only reads the fields of the data provider, and uses
+ * no variable and only builtin functions which do not read other layers, the selection or the clock.
+ */
+static bool isCacheableAggregateExpression( const QString &expression, const QgsFields &fields )
+{
+  if ( expression.isEmpty() )
+    return true;
+
+  int fieldIndex = fields.lookupField( expression );
+  if ( fieldIndex >= 0 )
+    return isProviderField( fields, fieldIndex );
+
+  QgsExpression exp( expression );
+  if ( exp.hasParserError() || !exp.referencedVariables().isEmpty() )
+    return false;
+
+  // the joined fields come from other layers, the virtual fields may use any function
+  Q_FOREACH ( const QString &column, exp.referencedColumns() )
+  {
+    if ( column == QgsFeatureRequest::ALL_ATTRIBUTES )
+    {
+      for ( int i = 0; i < fields.count(); ++i )
+      {
+        if ( !isProviderField( fields, i ) )
+          return false;
+      }
+    }
+    else if ( !isProviderField( fields, fields.lookupField( column ) ) )
+    {
+      return false;
+    }
+  }
+
+  static const QSet< QString > sContextDependentFunctions = QSet< QString >()
+      << QStringLiteral( "rand" ) << QStringLiteral( "randf" ) << QStringLiteral( "uuid" ) << QStringLiteral( "now" )
+      << QStringLiteral( "get_feature" ) << QStringLiteral( "is_selected" ) << QStringLiteral( "num_selected" )
+      << QStringLiteral( "layer_property" ) << QStringLiteral( "eval" );
+
+  Q_FOREACH ( const QString &name, exp.referencedFunctions() )
+  {
+    int index = QgsExpression::functionIndex( name );
+    if ( index < 0 || !QgsExpression::BuiltinFunctions().contains( name ) )
+      return false;
+
+    QgsExpression::Function *function = QgsExpression::Functions().at( index );
+    if ( function->isContextual() || function->groups().contains( QStringLiteral( "Aggregates" ) ) || sContextDependentFunctions.contains( name ) )
+      return false;
+  }
+  return true;
+}
+
+///@endcond
+
 QVariant QgsVectorLayer::aggregate( QgsAggregateCalculator::Aggregate aggregate, const QString &fieldOrExpression,
                                     const QgsAggregateCalculator::AggregateParameters &parameters, QgsExpressionContext *context, bool *ok ) const
 {
@@ -3313,6 +3390,29 @@ QVariant QgsVectorLayer::aggregate( QgsAggregateCalculator::Aggregate aggregate,
     return QVariant();
   }
 
+  // the aggregates which only depend on the data of the layer are kept until the data change
+  QString cacheKey;
+  int cacheGeneration = 0;
+  if ( mAggregateCacheEnabled && isCacheableAggregateExpression( fieldOrExpression, mFields )
+       && isCacheableAggregateExpression( parameters.filter, mFields ) )
+  {
+    cacheKey = QStringLiteral( "%1:%2:%3:%4:" ).arg( aggregate ).arg( fieldOrExpression.length() ).arg( parameters.filter.length() ).arg( parameters.delimiter.length() )
+               + fieldOrExpression + parameters.filter + parameters.delimiter;
+
+    QMutexLocker locker( &mAggregateCacheMutex );
+    QHash< QString, QVariant >::const_iterator it = mAggregateCache.constFind( cacheKey );
+    if ( it != mAggregateCache.constEnd() )
+    {
+      if ( ok )
+        *ok = true;
+      return it.value();
+    }
+    cacheGeneration = mAggregateCacheGeneration;
+  }
+
+  QVariant result;
+  bool calculated = false;
+
   // test if we are calculating based on a field
   int attrIndex = mFields.lookupField( fieldOrExpression );
   if ( attrIndex >= 0 )
@@ -3322,22 +3422,41 @@ QVariant QgsVectorLayer::aggregate( QgsAggregateCalculator::Aggregate aggregate,
     QgsFields::FieldOrigin origin = mFields.fieldOrigin( attrIndex );
     if ( origin == QgsFields::OriginProvider )
     {
-      bool providerOk = false;
-      QVariant val = mDataProvider->aggregate( aggregate, attrIndex, parameters, context, providerOk );
-      if ( providerOk )
-      {
-        // provider handled calculation
-        if ( ok )
-          *ok = true;
-        return val;
-      }
+      result = mDataProvider->aggregate( aggregate, attrIndex, parameters, context, calculated );
     }
   }
 
-  // fallback to using aggregate calculator to determine aggregate
-  QgsAggregateCalculator c( this );
-  c.setParameters( parameters );
-  return c.calculate( aggregate, fieldOrExpression, context, ok );
+  if ( !calculated )
+  {
+    // fallback to using aggregate calculator to determine aggregate
+    QgsAggregateCalculator c( this );
+    c.setParameters( parameters );
+    result = c.calculate( aggregate, fieldOrExpression, context, &calculated );
+  }
+
+  if ( ok )
+    *ok = calculated;
+
+  if ( calculated && !cacheKey.isEmpty() )
+  {
+    QMutexLocker locker( &mAggregateCacheMutex );
+    // the data may have changed while the aggregate was calculated
+    if ( cacheGeneration == mAggregateCacheGeneration )
+    {
+      if ( mAggregateCache.size() >= MAX_CACHED_AGGREGATES )
+        mAggregateCache.clear();
+      mAggregateCache.insert( cacheKey, result );
+    }
+  }
+
+  return result;
+}
+
+void QgsVectorLayer::setAggregateCacheEnabled( bool enabled )
+{
+  mAggregateCacheEnabled = enabled;
+  if ( !enabled )
+    invalidateAggregateCache();
 }
 
 QList<QVariant> QgsVectorLayer::getValues( const QString &fieldOrExpression, bool &ok, bool selectedOnly, QgsFeedback *feedback ) const
@@ -3902,6 +4021,13 @@ void QgsVectorLayer::onJoinedFieldsChanged()
   updateFields();
 }
 
+void QgsVectorLayer::invalidateAggregateCache()
+{
+  QMutexLocker locker( &mAggregateCacheMutex );
+  mAggregateCache.clear();
+  ++mAggregateCacheGeneration;
+}
+
 void QgsVectorLayer::onFeatureDeleted( QgsFeatureId fid )
 {
   if ( mEditCommandActive )
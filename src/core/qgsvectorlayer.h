@@ -1453,6 +1453,24 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
                         QgsExpressionContext *context = nullptr,
                         bool *ok = nullptr ) const;
 
+    /** Sets whether the aggregates calculated by aggregate() are cached, including the aggregates of the
+     * aggregate() and relation_aggregate() expression functions. Only the aggregates whose expression and
+     * filter neither depend on the expression context nor read joined or virtual fields are cached.
+     * They are discarded when the layer is edited or reloaded, or when its data provider reports
+     * changed data. Data written directly through the data provider or by another application are not
+     * reported, so the cache should only be enabled for layers whose data do not change that way.
+     * The cache is disabled by default.
+     * \see aggregateCacheEnabled()
+     * \since QGIS 3.0
+     */
+    void setAggregateCacheEnabled( bool enabled );
+
+    /** Returns true if the aggregates calculated by aggregate() are cached.
+     * \see setAggregateCacheEnabled()
+     * \since QGIS 3.0
+     */
+    bool aggregateCacheEnabled() const { return mAggregateCacheEnabled; }
+
     /** Fetches all values from a specified field name or expression.
      * \param fieldOrExpression field name or an expression string
      * \param ok will be set to false if field or expression is invalid, otherwise true
@@ -1858,6 +1876,7 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
 
   private slots:
     void onJoinedFieldsChanged();
+    void invalidateAggregateCache();
     void onFeatureDeleted( QgsFeatureId fid );
     void onRelationsLoaded();
     void onSymbolsCounted();
@@ -2010,6 +2029,15 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
 
     mutable QMutex mFeatureSourceConstructorMutex;
 
+    //! True if the aggregates are cached
+    bool mAggregateCacheEnabled = false;
+    //! Aggregates which do not depend on the expression context, kept until the data of the layer change
+    mutable QHash< QString, QVariant > mAggregateCache;
+    //! Incremented when the aggregate cache is invalidated, so that the aggregates calculated meanwhile are discarded
+    int mAggregateCacheGeneration = 0;
+    //! Protects the aggregate cache, which is filled by the threads evaluating expressions
+    mutable QMutex mAggregateCacheMutex;
+
     QgsVectorLayerFeatureCounter *mFeatureCounter = nullptr;
 
     friend class QgsVectorLayerFeatureSource;
@@ -19,12 +19,31 @@
 //for CMAKE_INSTALL_PREFIX
 #include "qgsconfig.h"
 #include "qgsserver.h"
+#include "qgsserverinterfaceimpl.h"
 #include "qgsfcgiserverresponse.h"
 #include "qgsfcgiserverrequest.h"
+#include "qgsserversettings.h"
+
+#include <QMutex>
+#include <QThread>
 
 #include <fcgi_stdio.h>
 #include <cstdlib>
 
+//! Configures the streaming and the compression of \a response
+void setupResponse( QgsFcgiServerResponse &response, const QgsServerRequest &request, const QgsServerSettings &settings, QgsServer &server )
+{
+  // The filters must get the whole body in their sendResponse() method, which streamed data would bypass
+  if ( server.serverInterface()->filters().isEmpty() )
+  {
+    response.setFlushThreshold( settings.responseFlushThreshold() );
+  }
+  if ( settings.responseCompression() )
+  {
+    response.setAcceptedEncoding( QgsServerCompressor::acceptedEncoding( request.header( QStringLiteral( "Accept-Encoding" ) ) ) );
+  }
+}
+
 int fcgi_accept()
 {
 #ifdef Q_OS_WIN
@@ -37,6 +56,59 @@ int fcgi_accept()
 #endif
 }
 
+/**
+ * Worker thread accepting and handling FastCGI requests, when several
+ * requests are handled in parallel.
+ */
+class QgsFcgiRequestThread : public QThread
+{
+  public:
+    QgsFcgiRequestThread( QgsServer &server, const QgsServerSettings &settings, QMutex &acceptMutex )
+      : mServer( server )
+      , mSettings( settings )
+      , mAcceptMutex( acceptMutex )
+    {}
+
+  protected:
+    void run() override
+    {
+      FCGX_Request fcgiRequest;
+      FCGX_InitRequest( &fcgiRequest, 0, 0 );
+
+      while ( true )
+      {
+        int rc;
+        {
+          // Some platforms require accept() serialization
+          QMutexLocker locker( &mAcceptMutex );
+          rc = FCGX_Accept_r( &fcgiRequest );
+        }
+        if ( rc < 0 )
+          break;
+
+        {
+          QgsFcgiServerRequest  request( &fcgiRequest );
+          QgsFcgiServerResponse response( &fcgiRequest, request.method() );
+          setupResponse( response, request, mSettings, mServer );
+          if ( ! request.hasError() )
+          {
+            mServer.handleRequest( request, response );
+          }
+          else
+          {
+            response.sendError( 400, "Bad request" );
+          }
+        }
+        FCGX_Finish_r( &fcgiRequest );
+      }
+    }
+
+  private:
+    QgsServer &mServer;
+    const QgsServerSettings &mSettings;
+    QMutex &mAcceptMutex;
+};
+
 int main( int argc, char *argv[] )
 {
   QgsApplication app( argc, argv, getenv( "DISPLAY" ), QString(), QStringLiteral( "server" ) );
@@ -44,11 +116,40 @@ int main( int argc, char *argv[] )
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   server.initPython();
 #endif
+
+  const QgsServerSettings settings;
+  const int parallelRequests = settings.parallelRequests();
+  if ( parallelRequests > 1 && !FCGX_IsCGI() )
+  {
+    // Worker threads accept the requests while the main thread runs the event
+    // loop, which executes the requests that cannot run concurrently
+    FCGX_Init();
+    QMutex acceptMutex;
+    QList< QgsFcgiRequestThread * > threads;
+    int runningThreads = parallelRequests;
+    for ( int i = 0; i < parallelRequests; ++i )
+    {
+      QgsFcgiRequestThread *thread = new QgsFcgiRequestThread( server, settings, acceptMutex );
+      QObject::connect( thread, &QThread::finished, &app, [&runningThreads]
+      {
+        if ( --runningThreads == 0 )
+          QCoreApplication::quit();
+      } );
+      threads << thread;
+      thread->start();
+    }
+    app.exec();
+    qDeleteAll( threads );
+    app.exitQgis();
+    return 0;
+  }
+
   // Starts FCGI loop
   while ( fcgi_accept() >= 0 )
   {
     QgsFcgiServerRequest  request;
     QgsFcgiServerResponse response( request.method() );
+    setupResponse( response, request, settings, server );
     if ( ! request.hasError() )
     {
       server.handleRequest( request, response );
@@ -16,8 +16,31 @@
  ***************************************************************************/
 
 #include "qgscapabilitiescache.h"
+#include "qgsservercompressor.h"
+#include "qgis.h"
 #include "qgslogger.h"
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+
+namespace
+{
+  const quint32 RESPONSE_MAGIC = 0x51474343; // "QGCC"
+  const quint32 RESPONSE_FORMAT = 1;
+
+  //! Maximal number of projects with cached capabilities
+  const int MAX_CACHED_PROJECTS = 40;
+
+  QString hashName( const QString &string )
+  {
+    return QString::fromLatin1( QCryptographicHash::hash( string.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+  }
+}
 
 QgsCapabilitiesCache::QgsCapabilitiesCache()
 {
@@ -32,40 +55,198 @@ const QDomDocument *QgsCapabilitiesCache::searchCapabilitiesDocument( const QStr
   {
     return &mCachedCapabilities[ configFilePath ][ key ];
   }
-  else
+
+  // the server only caches the encoded responses, their document is parsed when it is first searched
+  CapabilitiesResponse response;
+  QDomDocument doc;
+  if ( searchCapabilitiesResponse( configFilePath, key, response ) && doc.setContent( response.content ) )
   {
-    return nullptr;
+    mCachedCapabilities[ configFilePath ].insert( key, doc );
+    return &mCachedCapabilities[ configFilePath ][ key ];
   }
+  return nullptr;
 }
 
 void QgsCapabilitiesCache::insertCapabilitiesDocument( const QString &configFilePath, const QString &key, const QDomDocument *doc )
 {
-  if ( mCachedCapabilities.size() > 40 )
+  prepareEntry( configFilePath );
+  mCachedCapabilities[ configFilePath ].insert( key, doc->cloneNode().toDocument() );
+
+  // the response is encoded again from the inserted document
+  if ( mCachedResponses.contains( configFilePath ) )
   {
-    //remove another cache entry to avoid memory problems
-    QHash<QString, QHash<QString, QDomDocument> >::iterator capIt = mCachedCapabilities.begin();
-    mFileSystemWatcher.removePath( capIt.key() );
-    mCachedCapabilities.erase( capIt );
+    mCachedResponses[ configFilePath ].remove( key );
   }
-
-  if ( !mCachedCapabilities.contains( configFilePath ) )
+  if ( !mCacheDirectory.isEmpty() )
   {
-    mFileSystemWatcher.addPath( configFilePath );
-    mCachedCapabilities.insert( configFilePath, QHash<QString, QDomDocument>() );
+    QFile::remove( responseCacheFile( configFilePath, key ) );
   }
-
-  mCachedCapabilities[ configFilePath ].insert( key, doc->cloneNode().toDocument() );
 }
 
 void QgsCapabilitiesCache::removeCapabilitiesDocument( const QString &path )
 {
   mCachedCapabilities.remove( path );
+  mCachedResponses.remove( path );
   mFileSystemWatcher.removePath( path );
+  if ( !mCacheDirectory.isEmpty() )
+  {
+    QDir( projectCacheDirectory( path ) ).removeRecursively();
+  }
+}
+
+void QgsCapabilitiesCache::setCacheDirectory( const QString &directory )
+{
+  mCacheDirectory = directory;
+}
+
+bool QgsCapabilitiesCache::searchCapabilitiesResponse( const QString &configFilePath, const QString &key, CapabilitiesResponse &response )
+{
+  QCoreApplication::processEvents(); //get updates from file system watcher
+
+  QHash< QString, QHash< QString, CapabilitiesResponse > >::const_iterator projectIt = mCachedResponses.constFind( configFilePath );
+  if ( projectIt != mCachedResponses.constEnd() )
+  {
+    QHash< QString, CapabilitiesResponse >::const_iterator it = projectIt->constFind( key );
+    if ( it != projectIt->constEnd() )
+    {
+      response = it.value();
+      return true;
+    }
+  }
+
+  if ( mCacheDirectory.isEmpty() || !readResponse( configFilePath, key, response ) )
+  {
+    return false;
+  }
+
+  QgsDebugMsg( "Read capabilities response from the cache directory" );
+  prepareEntry( configFilePath );
+  mCachedResponses[ configFilePath ].insert( key, response );
+  // the document of the new response is parsed when it is searched
+  if ( mCachedCapabilities.contains( configFilePath ) )
+  {
+    mCachedCapabilities[ configFilePath ].remove( key );
+  }
+  return true;
+}
+
+QgsCapabilitiesCache::CapabilitiesResponse QgsCapabilitiesCache::insertCapabilitiesResponse( const QString &configFilePath, const QString &key, const QDomDocument &doc )
+{
+  CapabilitiesResponse response = encodeCapabilitiesDocument( doc, true );
+
+  prepareEntry( configFilePath );
+  mCachedResponses[ configFilePath ].insert( key, response );
+  // the document of the new response is parsed when it is searched
+  if ( mCachedCapabilities.contains( configFilePath ) )
+  {
+    mCachedCapabilities[ configFilePath ].remove( key );
+  }
+  if ( !mCacheDirectory.isEmpty() )
+  {
+    writeResponse( configFilePath, key, response );
+  }
+  return response;
+}
+
+QgsCapabilitiesCache::CapabilitiesResponse QgsCapabilitiesCache::encodeCapabilitiesDocument( const QDomDocument &doc, bool compress )
+{
+  CapabilitiesResponse response;
+  response.content = doc.toByteArray();
+  if ( compress )
+    response.gzipContent = QgsServerCompressor::compress( response.content, QgsServerCompressor::Gzip, 9 );
+  response.etag = '"' + QCryptographicHash::hash( response.content, QCryptographicHash::Sha1 ).toHex() + '"';
+  // HTTP dates have a precision of one second
+  QDateTime now = QDateTime::currentDateTimeUtc();
+  response.lastModified = now.addMSecs( -now.time().msec() );
+  return response;
+}
+
+void QgsCapabilitiesCache::prepareEntry( const QString &configFilePath )
+{
+  if ( mCachedCapabilities.contains( configFilePath ) || mCachedResponses.contains( configFilePath ) )
+  {
+    return;
+  }
+
+  QSet< QString > projects = mCachedCapabilities.keys().toSet() + mCachedResponses.keys().toSet();
+  if ( projects.size() > MAX_CACHED_PROJECTS )
+  {
+    //remove another cache entry to avoid memory problems
+    QString path = *projects.constBegin();
+    mCachedCapabilities.remove( path );
+    mCachedResponses.remove( path );
+    mFileSystemWatcher.removePath( path );
+  }
+
+  mFileSystemWatcher.addPath( configFilePath );
+}
+
+QString QgsCapabilitiesCache::projectCacheDirectory( const QString &configFilePath ) const
+{
+  return mCacheDirectory + '/' + hashName( configFilePath );
+}
+
+QString QgsCapabilitiesCache::responseCacheFile( const QString &configFilePath, const QString &key ) const
+{
+  return projectCacheDirectory( configFilePath ) + '/' + hashName( key );
+}
+
+bool QgsCapabilitiesCache::readResponse( const QString &configFilePath, const QString &key, CapabilitiesResponse &response ) const
+{
+  QFile file( responseCacheFile( configFilePath, key ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+
+  quint32 magic = 0;
+  quint32 format = 0;
+  qint32 qgisVersion = 0;
+  QString path;
+  QString cacheKey;
+  qint64 projectSize = -1;
+  QDateTime projectModified;
+  stream >> magic >> format >> qgisVersion >> path >> cacheKey >> projectSize >> projectModified;
+  if ( stream.status() != QDataStream::Ok || magic != RESPONSE_MAGIC || format != RESPONSE_FORMAT
+       || qgisVersion != Qgis::QGIS_VERSION_INT || path != configFilePath || cacheKey != key )
+    return false;
+
+  // the response is outdated if the project has changed since it was written
+  QFileInfo projectInfo( configFilePath );
+  if ( !projectInfo.exists() || projectInfo.size() != projectSize || projectInfo.lastModified().toUTC() != projectModified )
+    return false;
+
+  stream >> response.content >> response.gzipContent >> response.etag >> response.lastModified;
+  return stream.status() == QDataStream::Ok;
+}
+
+void QgsCapabilitiesCache::writeResponse( const QString &configFilePath, const QString &key, const CapabilitiesResponse &response ) const
+{
+  QFileInfo projectInfo( configFilePath );
+  if ( !projectInfo.exists() || !QDir().mkpath( projectCacheDirectory( configFilePath ) ) )
+    return;
+
+  QSaveFile file( responseCacheFile( configFilePath, key ) );
+  if ( !file.open( QIODevice::WriteOnly ) )
+    return;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  stream << RESPONSE_MAGIC << RESPONSE_FORMAT << static_cast< qint32 >( Qgis::QGIS_VERSION_INT )
+         << configFilePath << key << projectInfo.size() << projectInfo.lastModified().toUTC()
+         << response.content << response.gzipContent << response.etag << response.lastModified;
+
+  if ( stream.status() != QDataStream::Ok || !file.commit() )
+  {
+    QgsDebugMsg( QString( "Cannot write the capabilities response of project %1" ).arg( configFilePath ) );
+  }
 }
 
 void QgsCapabilitiesCache::removeChangedEntry( const QString &path )
 {
   QgsDebugMsg( "Remove capabilities cache entry because file changed" );
   mCachedCapabilities.remove( path );
+  mCachedResponses.remove( path );
   mFileSystemWatcher.removePath( path );
 }
@@ -18,11 +18,14 @@
 #ifndef QGSCAPABILITIESCACHE_H
 #define QGSCAPABILITIESCACHE_H
 
+#include <QByteArray>
+#include <QDateTime>
 #include <QDomDocument>
 #include <QFileSystemWatcher>
 #include <QHash>
 #include <QObject>
 #include "qgis_server.h"
+#include "qgis_sip.h"
 
 /** \ingroup server
  * A cache for capabilities xml documents (by configuration file path)
@@ -31,15 +34,33 @@ class SERVER_EXPORT QgsCapabilitiesCache : public QObject
 {
     Q_OBJECT
   public:
+
+    /** Capabilities document encoded for the responses
+     * \since QGIS 3.0
+     */
+    struct CapabilitiesResponse
+    {
+      //! UTF-8 encoded document
+      QByteArray content;
+      //! gzip compressed content
+      QByteArray gzipContent;
+      //! Quoted entity tag of the content, the responses sending the gzip content add a "-gzip" suffix to it
+      QByteArray etag;
+      //! Time the document was generated
+      QDateTime lastModified;
+    };
+
     QgsCapabilitiesCache();
 
-    /** Returns cached capabilities document (or 0 if document for configuration file not in cache)
+    /** Returns cached capabilities document (or 0 if document for configuration file not in cache).
+     * The server caches the encoded responses, the document of a cached response is parsed when it is first searched.
      * \param configFilePath the progect file path
      * \param key key used to separate different version in different cache
      */
     const QDomDocument *searchCapabilitiesDocument( const QString &configFilePath, const QString &key );
 
-    /** Inserts new capabilities document (creates a copy of the document, does not take ownership)
+    /** Inserts new capabilities document (creates a copy of the document, does not take ownership).
+     * The responses of the server are then encoded from this document.
      * \param configFilePath the project file path
      * \param key key used to separate different version in different cache
      * \param doc the DOM document
@@ -52,9 +73,57 @@ class SERVER_EXPORT QgsCapabilitiesCache : public QObject
      */
     void removeCapabilitiesDocument( const QString &path );
 
+    /** Sets the directory where the encoded capabilities responses are persisted, so that
+     * they survive a restart of the server. An empty directory disables the persistence.
+     * \since QGIS 3.0
+     */
+    void setCacheDirectory( const QString &directory );
+
+    /** Searches a cached capabilities response, in memory then in the cache directory.
+     * \param configFilePath the project file path
+     * \param key key used to separate different version in different cache
+     * \param response out: the cached response
+     * \returns false if the response is not in cache
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    bool searchCapabilitiesResponse( const QString &configFilePath, const QString &key, CapabilitiesResponse &response ) SIP_SKIP;
+
+    /** Encodes a capabilities document and inserts the response in cache.
+     * \param configFilePath the project file path
+     * \param key key used to separate different version in different cache
+     * \param doc the DOM document
+     * \returns the encoded response
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    CapabilitiesResponse insertCapabilitiesResponse( const QString &configFilePath, const QString &key, const QDomDocument &doc ) SIP_SKIP;
+
+    /** Encodes a capabilities document without caching it.
+     * \param doc the DOM document
+     * \param compress true to compute the gzip compressed content
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    static CapabilitiesResponse encodeCapabilitiesDocument( const QDomDocument &doc, bool compress ) SIP_SKIP;
+
   private:
     QHash< QString, QHash< QString, QDomDocument > > mCachedCapabilities;
+    QHash< QString, QHash< QString, CapabilitiesResponse > > mCachedResponses;
     QFileSystemWatcher mFileSystemWatcher;
+    QString mCacheDirectory;
+
+    //! Watches the project file and makes room for its entries
+    void prepareEntry( const QString &configFilePath );
+
+    //! Returns the directory of the persisted responses of a project
+    QString projectCacheDirectory( const QString &configFilePath ) const;
+
+    //! Returns the file of a persisted response
+    QString responseCacheFile( const QString &configFilePath, const QString &key ) const;
+
+    bool readResponse( const QString &configFilePath, const QString &key, CapabilitiesResponse &response ) const;
+    void writeResponse( const QString &configFilePath, const QString &key, const CapabilitiesResponse &response ) const;
 
   private slots:
     //! Removes changed entry from this cache
@@ -22,8 +22,10 @@
 #include "qgssldconfigparser.h"
 #include "qgsaccesscontrol.h"
 #include "qgsproject.h"
+#include "qgsprojectsnapshot.h"
 
 #include <QFile>
+#include <QMutexLocker>
 
 QgsConfigCache *QgsConfigCache::instance()
 {
@@ -36,12 +38,15 @@ QgsConfigCache *QgsConfigCache::instance()
 }
 
 QgsConfigCache::QgsConfigCache()
+  : mMutex( QMutex::Recursive )
 {
-  QObject::connect( &mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsConfigCache::removeChangedEntry );
+  QObject::connect( &mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsConfigCache::addChangedEntry );
 }
 
 QgsServerProjectParser *QgsConfigCache::serverConfiguration( const QString &filePath )
 {
+  QMutexLocker locker( &mMutex );
+
   QgsMessageLog::logMessage(
     QStringLiteral( "Open the project file '%1'." )
     .arg( filePath ),
@@ -81,6 +86,8 @@ QgsWmsConfigParser *QgsConfigCache::wmsConfiguration(
   , const QMap<QString, QString> &parameterMap
 )
 {
+  QMutexLocker locker( &mMutex );
+
   QgsWmsConfigParser *p = mWMSConfigCache.object( filePath );
   if ( !p )
   {
@@ -113,8 +120,15 @@ QgsWmsConfigParser *QgsConfigCache::wmsConfiguration(
   return p;
 }
 
+void QgsConfigCache::setUseProjectSnapshot( bool use )
+{
+  mUseProjectSnapshot = use;
+}
+
 QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
 {
+  QMutexLocker locker( &mMutex );
+
   //first open file
   QFile configFile( filePath );
   if ( !configFile.exists() )
@@ -133,11 +147,15 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
   QDomDocument *xmlDoc = mXmlDocumentCache.object( filePath );
   if ( !xmlDoc )
   {
-    //then create xml document
+    //then create xml document, from the snapshot written when the project has been read if it is enabled and up to date
     xmlDoc = new QDomDocument();
     QString errorMsg;
     int line, column;
-    if ( !xmlDoc->setContent( &configFile, true, &errorMsg, &line, &column ) )
+    if ( mUseProjectSnapshot && QgsProjectSnapshot::read( filePath, *xmlDoc, true ) )
+    {
+      QgsMessageLog::logMessage( "Read configuration file '" + filePath + "' from its snapshot", QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    }
+    else if ( !xmlDoc->setContent( &configFile, true, &errorMsg, &line, &column ) )
     {
       QgsMessageLog::logMessage( "Error parsing file '" + filePath +
                                  QStringLiteral( "': parse error %1 at row %2, column %3" ).arg( errorMsg ).arg( line ).arg( column ), QStringLiteral( "Server" ), QgsMessageLog::CRITICAL );
@@ -145,26 +163,57 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
       return nullptr;
     }
     mXmlDocumentCache.insert( filePath, xmlDoc );
-    mFileSystemWatcher.addPath( filePath );
+    // the watcher belongs to the main thread
+    QMetaObject::invokeMethod( this, "watchFile", Qt::AutoConnection, Q_ARG( QString, filePath ) );
     xmlDoc = mXmlDocumentCache.object( filePath );
     Q_ASSERT( xmlDoc );
   }
   return xmlDoc;
 }
 
-void QgsConfigCache::removeChangedEntry( const QString &path )
+void QgsConfigCache::watchFile( const QString &path )
 {
-  mWMSConfigCache.remove( path );
+  mFileSystemWatcher.addPath( path );
+}
 
-  //xml document must be removed last, as other config cache destructors may require it
-  mXmlDocumentCache.remove( path );
+void QgsConfigCache::addChangedEntry( const QString &path )
+{
+  QMutexLocker locker( &mMutex );
+  mChangedEntries.insert( path );
+}
 
-  mFileSystemWatcher.removePath( path );
+bool QgsConfigCache::hasChangedEntries() const
+{
+  QMutexLocker locker( &mMutex );
+  return !mChangedEntries.isEmpty();
 }
 
+void QgsConfigCache::removeChangedEntries()
+{
+  QSet<QString> changedEntries;
+  {
+    QMutexLocker locker( &mMutex );
+    changedEntries.swap( mChangedEntries );
+  }
+
+  Q_FOREACH ( const QString &path, changedEntries )
+  {
+    removeEntry( path );
+  }
+}
 
 void QgsConfigCache::removeEntry( const QString &path )
 {
-  removeChangedEntry( path );
-}
+  {
+    QMutexLocker locker( &mMutex );
+
+    mWMSConfigCache.remove( path );
+
+    //xml document must be removed last, as other config cache destructors may require it
+    mXmlDocumentCache.remove( path );
 
+    mFileSystemWatcher.removePath( path );
+  }
+
+  emit entryRemoved( path );
+}
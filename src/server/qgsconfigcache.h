@@ -23,8 +23,10 @@
 #include <QCache>
 #include <QFileSystemWatcher>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QDomDocument>
+#include <QSet>
 
 #include "qgis_server.h"
 #include "qgswmsconfigparser.h"
@@ -32,10 +34,20 @@
 class QgsServerProjectParser;
 class QgsAccessControl;
 
+/** \ingroup server
+ * A cache for xml documents (by configuration file path).
+ *
+ * The cache may be used by concurrent requests. The configurations it returns are
+ * owned by the cache and are only removed by removeEntry() and removeChangedEntries(),
+ * which must not be called while other requests are executed: the changes of the
+ * configuration files are recorded until removeChangedEntries() is called.
+ */
 class SERVER_EXPORT QgsConfigCache : public QObject
 {
     Q_OBJECT
   public:
+
+    //! Returns the cache, which must be created in the main thread
     static QgsConfigCache *instance();
 
     QgsServerProjectParser *serverConfiguration( const QString &filePath );
@@ -47,21 +59,58 @@ class SERVER_EXPORT QgsConfigCache : public QObject
 
     void removeEntry( const QString &path );
 
+    /** Returns true if configuration files have changed since the last call to removeChangedEntries()
+     * \since QGIS 3.0
+     */
+    bool hasChangedEntries() const;
+
+    /** Removes the entries of the configuration files which have changed
+     * \see hasChangedEntries()
+     * \since QGIS 3.0
+     */
+    void removeChangedEntries();
+
+    /** Sets whether the configuration files are read from the project snapshot written
+     * next to them, when it is up to date. Disabled by default.
+     * \see QgsServerSettings::projectSnapshot()
+     * \since QGIS 3.0
+     */
+    void setUseProjectSnapshot( bool use );
+
+  signals:
+
+    /** Emitted when the entries of the configuration file \a path are removed from the cache,
+     * e.g. because the file has changed. Other caches of the file content should be cleared.
+     * \since QGIS 3.0
+     */
+    void entryRemoved( const QString &path );
+
   private:
     QgsConfigCache();
 
     //! Check for configuration file updates (remove entry from cache if file changes)
     QFileSystemWatcher mFileSystemWatcher;
 
+    //! Protects the caches, the parsers may read other configurations
+    mutable QMutex mMutex;
+
+    //! Configuration files changed since the last call to removeChangedEntries()
+    QSet<QString> mChangedEntries;
+
     //! Returns xml document for project file / sld or 0 in case of errors
     QDomDocument *xmlDocument( const QString &filePath );
 
     QCache<QString, QDomDocument> mXmlDocumentCache;
     QCache<QString, QgsWmsConfigParser> mWMSConfigCache;
 
+    bool mUseProjectSnapshot = false;
+
   private slots:
-    //! Removes changed entry from this cache
-    void removeChangedEntry( const QString &path );
+    //! Records a changed entry, which is removed by removeChangedEntries()
+    void addChangedEntry( const QString &path );
+
+    //! Watches the configuration file \a path, in the thread of the cache
+    void watchFile( const QString &path );
 };
 
 #endif // QGSCONFIGCACHE_H
@@ -26,8 +26,16 @@
 
 #include <QDebug>
 
+#include <algorithm>
+
 
 QgsFcgiServerRequest::QgsFcgiServerRequest()
+  : QgsFcgiServerRequest( nullptr )
+{
+}
+
+QgsFcgiServerRequest::QgsFcgiServerRequest( FCGX_Request *request )
+  : mRequest( request )
 {
   mHasError  = false;
 
@@ -35,10 +43,10 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
 
   // Get the REQUEST_URI from the environment
   QUrl url;
-  QString uri = getenv( "REQUEST_URI" );
+  QString uri = param( "REQUEST_URI" );
   if ( uri.isEmpty() )
   {
-    uri = getenv( "SCRIPT_NAME" );
+    uri = param( "SCRIPT_NAME" );
   }
 
   url.setUrl( uri );
@@ -46,13 +54,13 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   // Check if host is defined
   if ( url.host().isEmpty() )
   {
-    url.setHost( getenv( "SERVER_NAME" ) );
+    url.setHost( param( "SERVER_NAME" ) );
   }
 
   // Port ?
   if ( url.port( -1 ) == -1 )
   {
-    QString portString = getenv( "SERVER_PORT" );
+    QString portString = param( "SERVER_PORT" );
     if ( !portString.isEmpty() )
     {
       bool portOk;
@@ -67,7 +75,7 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   // scheme
   if ( url.scheme().isEmpty() )
   {
-    QString( getenv( "HTTPS" ) ).compare( QLatin1String( "on" ), Qt::CaseInsensitive ) == 0
+    QString( param( "HTTPS" ) ).compare( QLatin1String( "on" ), Qt::CaseInsensitive ) == 0
     ? url.setScheme( QStringLiteral( "https" ) )
     : url.setScheme( QStringLiteral( "http" ) );
   }
@@ -75,7 +83,7 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   // XXX OGC paremetrs are passed with the query string
   // we override the query string url in case it is
   // defined independently of REQUEST_URI
-  const char *qs = getenv( "QUERY_STRING" );
+  const char *qs = param( "QUERY_STRING" );
   if ( qs )
   {
     url.setQuery( qs );
@@ -88,7 +96,7 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   QgsServerRequest::Method method = GetMethod;
 
   // Get method
-  const char *me = getenv( "REQUEST_METHOD" );
+  const char *me = param( "REQUEST_METHOD" );
 
   if ( me )
   {
@@ -119,6 +127,22 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   setUrl( url );
   setMethod( method );
 
+  // HTTP headers used by the services to negotiate the responses
+  const char *const httpHeaders[][2] =
+  {
+    { "HTTP_ACCEPT_ENCODING", "Accept-Encoding" },
+    { "HTTP_IF_NONE_MATCH", "If-None-Match" },
+    { "HTTP_IF_MODIFIED_SINCE", "If-Modified-Since" }
+  };
+  for ( const auto &httpHeader : httpHeaders )
+  {
+    const char *value = param( httpHeader[0] );
+    if ( value )
+    {
+      setHeader( QString( httpHeader[1] ), QString( value ) );
+    }
+  }
+
   // Output debug infos
   QgsMessageLog::MessageLevel logLevel = QgsServerLogger::instance()->logLevel();
   if ( logLevel <= QgsMessageLog::INFO )
@@ -137,11 +161,16 @@ QByteArray QgsFcgiServerRequest::data() const
   return mData;
 }
 
+const char *QgsFcgiServerRequest::param( const char *name ) const
+{
+  return mRequest ? FCGX_GetParam( name, mRequest->envp ) : getenv( name );
+}
+
 // Read post put data
 void QgsFcgiServerRequest::readData()
 {
   // Check if we have CONTENT_LENGTH defined
-  const char *lengthstr = getenv( "CONTENT_LENGTH" );
+  const char *lengthstr = param( "CONTENT_LENGTH" );
   if ( lengthstr )
   {
 #ifdef QGISDEBUG
@@ -151,10 +180,18 @@ void QgsFcgiServerRequest::readData()
     int length = QString( lengthstr ).toInt( &success );
     if ( success )
     {
-      // XXX This not efficiont at all  !!
-      for ( int i = 0; i < length; ++i )
+      if ( mRequest )
+      {
+        mData.resize( length );
+        mData.resize( std::max( FCGX_GetStr( mData.data(), length, mRequest->in ), 0 ) );
+      }
+      else
       {
-        mData.append( getchar() );
+        // XXX This not efficiont at all  !!
+        for ( int i = 0; i < length; ++i )
+        {
+          mData.append( getchar() );
+        }
       }
     }
     else
@@ -173,48 +210,48 @@ void QgsFcgiServerRequest::readData()
 void QgsFcgiServerRequest::printRequestInfos()
 {
   QgsMessageLog::logMessage( QStringLiteral( "******************** New request ***************" ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
-  if ( getenv( "REMOTE_ADDR" ) )
+  if ( param( "REMOTE_ADDR" ) )
   {
-    QgsMessageLog::logMessage( "REMOTE_ADDR: " + QString( getenv( "REMOTE_ADDR" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "REMOTE_ADDR: " + QString( param( "REMOTE_ADDR" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "REMOTE_HOST" ) )
+  if ( param( "REMOTE_HOST" ) )
   {
-    QgsMessageLog::logMessage( "REMOTE_HOST: " + QString( getenv( "REMOTE_HOST" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "REMOTE_HOST: " + QString( param( "REMOTE_HOST" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "REMOTE_USER" ) )
+  if ( param( "REMOTE_USER" ) )
   {
-    QgsMessageLog::logMessage( "REMOTE_USER: " + QString( getenv( "REMOTE_USER" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "REMOTE_USER: " + QString( param( "REMOTE_USER" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "REMOTE_IDENT" ) )
+  if ( param( "REMOTE_IDENT" ) )
   {
-    QgsMessageLog::logMessage( "REMOTE_IDENT: " + QString( getenv( "REMOTE_IDENT" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "REMOTE_IDENT: " + QString( param( "REMOTE_IDENT" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "CONTENT_TYPE" ) )
+  if ( param( "CONTENT_TYPE" ) )
   {
-    QgsMessageLog::logMessage( "CONTENT_TYPE: " + QString( getenv( "CONTENT_TYPE" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "CONTENT_TYPE: " + QString( param( "CONTENT_TYPE" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "AUTH_TYPE" ) )
+  if ( param( "AUTH_TYPE" ) )
   {
-    QgsMessageLog::logMessage( "AUTH_TYPE: " + QString( getenv( "AUTH_TYPE" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "AUTH_TYPE: " + QString( param( "AUTH_TYPE" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "HTTP_USER_AGENT" ) )
+  if ( param( "HTTP_USER_AGENT" ) )
   {
-    QgsMessageLog::logMessage( "HTTP_USER_AGENT: " + QString( getenv( "HTTP_USER_AGENT" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "HTTP_USER_AGENT: " + QString( param( "HTTP_USER_AGENT" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "HTTP_PROXY" ) )
+  if ( param( "HTTP_PROXY" ) )
   {
-    QgsMessageLog::logMessage( "HTTP_PROXY: " + QString( getenv( "HTTP_PROXY" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "HTTP_PROXY: " + QString( param( "HTTP_PROXY" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "HTTPS_PROXY" ) )
+  if ( param( "HTTPS_PROXY" ) )
   {
-    QgsMessageLog::logMessage( "HTTPS_PROXY: " + QString( getenv( "HTTPS_PROXY" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "HTTPS_PROXY: " + QString( param( "HTTPS_PROXY" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "NO_PROXY" ) )
+  if ( param( "NO_PROXY" ) )
   {
-    QgsMessageLog::logMessage( "NO_PROXY: " + QString( getenv( "NO_PROXY" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "NO_PROXY: " + QString( param( "NO_PROXY" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
-  if ( getenv( "HTTP_AUTHORIZATION" ) )
+  if ( param( "HTTP_AUTHORIZATION" ) )
   {
-    QgsMessageLog::logMessage( "HTTP_AUTHORIZATION: " + QString( getenv( "HTTP_AUTHORIZATION" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    QgsMessageLog::logMessage( "HTTP_AUTHORIZATION: " + QString( param( "HTTP_AUTHORIZATION" ) ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   }
 }
@@ -23,6 +23,8 @@
 
 #include <QBuffer>
 
+struct FCGX_Request;
+
 /**
  * \ingroup server
  * QgsFcgiServerResquest
@@ -31,7 +33,17 @@
 class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
 {
   public:
+
+    //! Creates the request accepted by FCGI_Accept() from the environment and the standard input
     QgsFcgiServerRequest();
+
+    /**
+     * Creates the request accepted by FCGX_Accept_r() from the parameters and the input stream
+     * of \a request, which allows several requests to be read by different threads.
+     * \since QGIS 3.0
+     */
+    explicit QgsFcgiServerRequest( FCGX_Request *request );
+
     ~QgsFcgiServerRequest();
 
     virtual QByteArray data() const override;
@@ -42,6 +54,9 @@ class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
     bool hasError() const { return mHasError; }
 
   private:
+    //! Returns the value of the CGI variable \a name, or nullptr if it is not defined
+    const char *param( const char *name ) const;
+
     void readData();
 
     // Log request info: print debug infos
@@ -49,6 +64,7 @@ class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
     void printRequestInfos();
 
 
+    FCGX_Request *mRequest = nullptr;
     QByteArray mData;
     bool       mHasError;
 };
@@ -26,12 +26,56 @@
 
 #include <QDebug>
 
+//
+// QgsFcgiServerResponse::BodyDevice
+//
+
+//! Device receiving the body of the response, which is buffered or streamed by writeBody()
+class QgsFcgiServerResponse::BodyDevice : public QIODevice
+{
+  public:
+    explicit BodyDevice( QgsFcgiServerResponse *response )
+      : mResponse( response )
+    {
+      open( QIODevice::WriteOnly | QIODevice::Unbuffered );
+    }
+
+    bool isSequential() const override { return true; }
+
+  protected:
+    qint64 readData( char *data, qint64 maxSize ) override
+    {
+      Q_UNUSED( data );
+      Q_UNUSED( maxSize );
+      return -1;
+    }
+
+    qint64 writeData( const char *data, qint64 length ) override
+    {
+      mResponse->writeBody( data, length );
+      return length;
+    }
+
+  private:
+    QgsFcgiServerResponse *mResponse = nullptr;
+};
+
 //
 // QgsFcgiServerResponse
 //
 
 QgsFcgiServerResponse::QgsFcgiServerResponse( QgsServerRequest::Method method )
-  : mMethod( method )
+  : mDevice( new BodyDevice( this ) )
+  , mMethod( method )
+{
+  mBuffer.open( QIODevice::ReadWrite );
+  setDefaultHeaders();
+}
+
+QgsFcgiServerResponse::QgsFcgiServerResponse( FCGX_Request *request, QgsServerRequest::Method method )
+  : mRequest( request )
+  , mDevice( new BodyDevice( this ) )
+  , mMethod( method )
 {
   mBuffer.open( QIODevice::ReadWrite );
   setDefaultHeaders();
@@ -86,7 +130,7 @@ void QgsFcgiServerResponse::sendError( int code,  const QString &message )
 
 QIODevice *QgsFcgiServerResponse::io()
 {
-  return &mBuffer;
+  return mDevice.get();
 }
 
 void QgsFcgiServerResponse::finish()
@@ -99,12 +143,14 @@ void QgsFcgiServerResponse::finish()
 
   if ( !mHeadersSent )
   {
-    if ( ! mHeaders.contains( "Content-Length" ) )
-    {
-      mHeaders.insert( QStringLiteral( "Content-Length" ), QStringLiteral( "%1" ).arg( mBuffer.pos() ) );
-    }
+    sendHeaders( true );
   }
   flush();
+  if ( mCompressor )
+  {
+    sendData( mCompressor->finish() );
+    mCompressor.reset();
+  }
   mFinished = true;
 }
 
@@ -112,41 +158,131 @@ void QgsFcgiServerResponse::flush()
 {
   if ( ! mHeadersSent )
   {
-    // Send all headers
-    QMap<QString, QString>::const_iterator it;
-    for ( it = mHeaders.constBegin(); it != mHeaders.constEnd(); ++it )
-    {
-      fputs( it.key().toUtf8(), FCGI_stdout );
-      fputs( ": ", FCGI_stdout );
-      fputs( it.value().toUtf8(), FCGI_stdout );
-      fputs( "\n", FCGI_stdout );
-    }
-    fputs( "\n", FCGI_stdout );
-    mHeadersSent = true;
+    sendHeaders( false );
   }
 
-  mBuffer.seek( 0 );
   if ( mMethod == QgsServerRequest::HeadMethod )
   {
     // Ignore data for head method as we only
     // write headers for HEAD requests
     mBuffer.buffer().clear();
   }
-  else if ( mBuffer.bytesAvailable() > 0 )
+  else if ( !mBuffer.buffer().isEmpty() )
   {
     QByteArray &ba = mBuffer.buffer();
-    size_t count   = fwrite( ( void * )ba.data(), ba.size(), 1, FCGI_stdout );
+    sendBody( ba.constData(), ba.size() );
+    // Reset the internal buffer
+    ba.clear();
+  }
+  mBuffer.seek( 0 );
+}
+
+void QgsFcgiServerResponse::writeBody( const char *data, qint64 length )
+{
+  if ( mFlushThreshold > 0 && mMethod != QgsServerRequest::HeadMethod
+       && mBuffer.buffer().size() + length >= mFlushThreshold )
+  {
+    // Send what is buffered, then the data without copying them
+    flush();
+    sendBody( data, length );
+  }
+  else
+  {
+    mBuffer.write( data, length );
+  }
+}
+
+void QgsFcgiServerResponse::sendHeaders( bool complete )
+{
+  // A body already encoded by the service (e.g. a cached gzip document) is sent as is
+  if ( mAcceptedEncoding != QgsServerCompressor::Identity
+       && mMethod != QgsServerRequest::HeadMethod
+       && mStatusCode != 204 && mStatusCode != 304
+       && !mHeaders.contains( QStringLiteral( "Content-Encoding" ) )
+       && QgsServerCompressor::isCompressible( mHeaders.value( QStringLiteral( "Content-Type" ) ) ) )
+  {
+    mHeaders.insert( QStringLiteral( "Content-Encoding" ), QgsServerCompressor::encodingName( mAcceptedEncoding ) );
+    QString vary = mHeaders.value( QStringLiteral( "Vary" ) );
+    if ( !vary.contains( QLatin1String( "Accept-Encoding" ), Qt::CaseInsensitive ) )
+    {
+      mHeaders.insert( QStringLiteral( "Vary" ), vary.isEmpty() ? QStringLiteral( "Accept-Encoding" ) : vary + QStringLiteral( ", Accept-Encoding" ) );
+    }
+
+    if ( complete )
+    {
+      // The whole body is buffered: it is compressed at once to send its length
+      mBuffer.buffer() = QgsServerCompressor::compress( mBuffer.buffer(), mAcceptedEncoding );
+      mHeaders.insert( QStringLiteral( "Content-Length" ), QString::number( mBuffer.buffer().size() ) );
+    }
+    else
+    {
+      // The length set by the service is the one of the uncompressed body
+      mHeaders.remove( QStringLiteral( "Content-Length" ) );
+      mCompressor.reset( new QgsServerCompressor( mAcceptedEncoding ) );
+    }
+  }
+  else if ( complete && ! mHeaders.contains( "Content-Length" ) )
+  {
+    mHeaders.insert( QStringLiteral( "Content-Length" ), QStringLiteral( "%1" ).arg( mBuffer.buffer().size() ) );
+  }
+
+  // Send all headers
+  QByteArray headers;
+  QMap<QString, QString>::const_iterator it;
+  for ( it = mHeaders.constBegin(); it != mHeaders.constEnd(); ++it )
+  {
+    headers.append( it.key().toUtf8() );
+    headers.append( ": " );
+    headers.append( it.value().toUtf8() );
+    headers.append( "\n" );
+  }
+  headers.append( "\n" );
+  sendData( headers );
+  mHeadersSent = true;
+}
+
+void QgsFcgiServerResponse::sendBody( const char *data, qint64 length )
+{
+  if ( mCompressor )
+  {
+    sendData( mCompressor->compress( data, length ) );
+  }
+  else
+  {
+    sendData( data, length );
+  }
+}
+
+void QgsFcgiServerResponse::sendData( const QByteArray &data )
+{
+  sendData( data.constData(), data.size() );
+}
+
+void QgsFcgiServerResponse::sendData( const char *data, qint64 length )
+{
+  if ( length <= 0 )
+    return;
+
+  if ( mRequest )
+  {
+    int count = FCGX_PutStr( data, static_cast< int >( length ), mRequest->out );
 #ifdef QGISDEBUG
-    qDebug() << QStringLiteral( "Sent %1 blocks of %2 bytes" ).arg( count ).arg( ba.size() );
+    qDebug() << QStringLiteral( "Sent %1 of %2 bytes" ).arg( count ).arg( length );
+#else
+    Q_UNUSED( count );
+#endif
+  }
+  else
+  {
+    size_t count = fwrite( ( void * )data, length, 1, FCGI_stdout );
+#ifdef QGISDEBUG
+    qDebug() << QStringLiteral( "Sent %1 blocks of %2 bytes" ).arg( count ).arg( length );
 #else
     Q_UNUSED( count );
 #endif
-    // Reset the internal buffer
-    ba.clear();
   }
 }
 
-
 void QgsFcgiServerResponse::clear()
 {
   mHeaders.clear();
@@ -21,9 +21,14 @@
 
 #include "qgsserverrequest.h"
 #include "qgsserverresponse.h"
+#include "qgsservercompressor.h"
 
 #include <QBuffer>
 
+#include <memory>
+
+struct FCGX_Request;
+
 /**
  * \ingroup server
  * QgsFcgiServerResponse
@@ -33,7 +38,15 @@ class SERVER_EXPORT QgsFcgiServerResponse: public QgsServerResponse
 {
   public:
 
+    //! Creates a response written to the standard output of the request accepted by FCGI_Accept()
     QgsFcgiServerResponse( QgsServerRequest::Method method = QgsServerRequest::GetMethod );
+
+    /**
+     * Creates a response written to the output stream of \a request, which has been accepted
+     * by FCGX_Accept_r() and may be answered while other threads answer other requests.
+     * \since QGIS 3.0
+     */
+    QgsFcgiServerResponse( FCGX_Request *request, QgsServerRequest::Method method = QgsServerRequest::GetMethod );
     ~QgsFcgiServerResponse();
 
     void setHeader( const QString &key, const QString &value ) override;
@@ -69,9 +82,53 @@ class SERVER_EXPORT QgsFcgiServerResponse: public QgsServerResponse
      */
     void setDefaultHeaders();
 
+    /**
+     * Sets the content coding accepted by the client. Text bodies (XML, GML, JSON, HTML...)
+     * are then compressed on the fly, unless a Content-Encoding header has already been set.
+     * \see QgsServerCompressor::acceptedEncoding()
+     * \since QGIS 3.0
+     */
+    void setAcceptedEncoding( QgsServerCompressor::Encoding encoding ) { mAcceptedEncoding = encoding; }
+
+    /**
+     * Sets the size of the body from which the response is streamed to the client. Once the
+     * written data reach \a threshold bytes, the headers are sent without Content-Length, and the
+     * data are written directly to the output stream of the request instead of being buffered.
+     * The default of 0 buffers the whole body until finish() or flush().
+     * \note data streamed this way do not go through the sendResponse() method of the server filters,
+     * the FastCGI server therefore does not stream the responses when filters are registered
+     * \since QGIS 3.0
+     */
+    void setFlushThreshold( qint64 threshold ) { mFlushThreshold = threshold; }
+
   private:
+    class BodyDevice;
+
+    //! Writes the body, either in the buffer or to the output stream once the flush threshold is reached
+    void writeBody( const char *data, qint64 length );
+
+    /**
+     * Sends the headers, after having set the content coding of the body.
+     * \param complete true if the whole body is buffered, to send its length
+     */
+    void sendHeaders( bool complete );
+
+    //! Writes a part of the body to the output stream, compressed if needed
+    void sendBody( const char *data, qint64 length );
+
+    //! Writes \a data to the output stream of the request
+    void sendData( const QByteArray &data );
+
+    //! Writes \a length bytes of \a data to the output stream of the request
+    void sendData( const char *data, qint64 length );
+
+    FCGX_Request *mRequest = nullptr;
     QMap<QString, QString> mHeaders;
     QBuffer mBuffer;
+    std::unique_ptr< QIODevice > mDevice;
+    QgsServerCompressor::Encoding mAcceptedEncoding = QgsServerCompressor::Identity;
+    std::unique_ptr< QgsServerCompressor > mCompressor;
+    qint64 mFlushThreshold = 0;
     bool mFinished    = false;
     bool mHeadersSent = false;
     QgsServerRequest::Method mMethod;
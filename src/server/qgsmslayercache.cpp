@@ -22,7 +22,10 @@
 #include "qgsvectorlayer.h"
 #include "qgslogger.h"
 #include "qgsserversettings.h"
+#include "qgsserverrequestproject.h"
 #include <QFile>
+#include <QMutexLocker>
+#include <QThread>
 
 QgsMSLayerCache *QgsMSLayerCache::instance()
 {
@@ -33,8 +36,9 @@ QgsMSLayerCache *QgsMSLayerCache::instance()
 }
 
 QgsMSLayerCache::QgsMSLayerCache()
+  : mMutex( QMutex::Recursive )
 {
-  QObject::connect( &mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsMSLayerCache::removeProjectFileLayers );
+  QObject::connect( &mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsMSLayerCache::addChangedProject );
 }
 
 QgsMSLayerCache::~QgsMSLayerCache()
@@ -49,15 +53,35 @@ QgsMSLayerCache::~QgsMSLayerCache()
 
 void QgsMSLayerCache::setMaxCacheLayers( int maxCacheLayers )
 {
+  QMutexLocker locker( &mMutex );
   mDefaultMaxLayers = maxCacheLayers;
 }
 
+int QgsMSLayerCache::projectsMaxLayers() const
+{
+  QMutexLocker locker( &mMutex );
+  return mProjectMaxLayers;
+}
+
+void QgsMSLayerCache::setProjectMaxLayers( int n )
+{
+  QMutexLocker locker( &mMutex );
+  mProjectMaxLayers = n;
+}
+
 void QgsMSLayerCache::insertLayer( const QString &url, const QString &layerName, QgsMapLayer *layer, const QString &configFile, const QList<QString> &tempFiles )
 {
   QgsMessageLog::logMessage( "Layer cache: insert Layer '" + layerName + "' configFile: " + configFile, QStringLiteral( "Server" ), QgsMessageLog::INFO );
-  if ( mEntries.size() > qMax( mDefaultMaxLayers, mProjectMaxLayers ) ) //force cache layer examination after 10 inserted layers
+  QMutexLocker locker( &mMutex );
+  updateEntries();
+
+  QThread *thread = QThread::currentThread();
+  if ( !mThreads.contains( thread ) )
   {
-    updateEntries();
+    // the layers belong to the thread, they are deleted by the thread when it finishes
+    mThreads.insert( thread );
+    QObject::connect( thread, &QThread::finished, this, [this, thread] { removeThreadLayers( thread ); }, Qt::DirectConnection );
+    QObject::connect( thread, &QObject::destroyed, this, [this, thread] { removeThreadLayers( thread ); }, Qt::DirectConnection );
   }
 
   QPair<QString, QString> urlLayerPair = qMakePair( url, layerName );
@@ -69,6 +93,7 @@ void QgsMSLayerCache::insertLayer( const QString &url, const QString &layerName,
   newEntry.lastUsedTime = time( nullptr );
   newEntry.temporaryFiles = tempFiles;
   newEntry.configFile = configFile;
+  newEntry.thread = thread;
 
   mEntries.insert( urlLayerPair, newEntry );
 
@@ -79,7 +104,8 @@ void QgsMSLayerCache::insertLayer( const QString &url, const QString &layerName,
     if ( configIt == mConfigFiles.constEnd() )
     {
       mConfigFiles.insert( configFile, 1 );
-      mFileSystemWatcher.addPath( configFile );
+      // the watcher belongs to the main thread
+      QMetaObject::invokeMethod( this, "watchFile", Qt::AutoConnection, Q_ARG( QString, configFile ) );
     }
     else
     {
@@ -91,31 +117,59 @@ void QgsMSLayerCache::insertLayer( const QString &url, const QString &layerName,
 QgsMapLayer *QgsMSLayerCache::searchLayer( const QString &url, const QString &layerName, const QString &configFile )
 {
   QPair<QString, QString> urlNamePair = qMakePair( url, layerName );
-  if ( !mEntries.contains( urlNamePair ) )
-  {
-    QgsMessageLog::logMessage( "Layer '" + layerName + "' configFile: " + configFile + " not found in layer cache'", QStringLiteral( "Server" ), QgsMessageLog::INFO );
-    return nullptr;
-  }
-  else
+  QThread *thread = QThread::currentThread();
+
+  QMutexLocker locker( &mMutex );
+  QMultiHash<QPair<QString, QString>, QgsMSLayerCacheEntry>::iterator layerIt = mEntries.find( urlNamePair );
+  for ( ; layerIt != mEntries.end() && layerIt.key() == urlNamePair; ++layerIt )
   {
-    QList< QgsMSLayerCacheEntry > layers = mEntries.values( urlNamePair );
-    QList< QgsMSLayerCacheEntry >::iterator layerIt = layers.begin();
-    for ( ; layerIt != layers.end(); ++layerIt )
+    if ( layerIt->thread == thread && ( configFile.isEmpty() || layerIt->configFile == configFile ) )
     {
-      if ( configFile.isEmpty() || layerIt->configFile == configFile )
-      {
-        layerIt->lastUsedTime = time( nullptr );
-        QgsMessageLog::logMessage( "Layer '" + layerName + "' configFile: " + configFile + " found in layer cache", QStringLiteral( "Server" ), QgsMessageLog::INFO );
-        return layerIt->layerPointer;
-      }
+      layerIt->lastUsedTime = time( nullptr );
+      QgsMessageLog::logMessage( "Layer '" + layerName + "' configFile: " + configFile + " found in layer cache", QStringLiteral( "Server" ), QgsMessageLog::INFO );
+      return layerIt->layerPointer;
     }
-    QgsMessageLog::logMessage( "Layer '" + layerName + "' configFile: " + configFile + " not found in layer cache'", QStringLiteral( "Server" ), QgsMessageLog::INFO );
-    return nullptr;
+  }
+  QgsMessageLog::logMessage( "Layer '" + layerName + "' configFile: " + configFile + " not found in layer cache'", QStringLiteral( "Server" ), QgsMessageLog::INFO );
+  return nullptr;
+}
+
+void QgsMSLayerCache::addChangedProject( const QString &project )
+{
+  QMutexLocker locker( &mMutex );
+  mChangedProjects.insert( project );
+}
+
+bool QgsMSLayerCache::hasChangedProjects() const
+{
+  QMutexLocker locker( &mMutex );
+  return !mChangedProjects.isEmpty();
+}
+
+void QgsMSLayerCache::removeChangedProjectLayers()
+{
+  QMutexLocker locker( &mMutex );
+  QSet< QString > changedProjects;
+  changedProjects.swap( mChangedProjects );
+  Q_FOREACH ( const QString &project, changedProjects )
+  {
+    removeProjectFileLayers( project );
   }
 }
 
+void QgsMSLayerCache::watchFile( const QString &path )
+{
+  mFileSystemWatcher.addPath( path );
+}
+
+void QgsMSLayerCache::unwatchFile( const QString &path )
+{
+  mFileSystemWatcher.removePath( path );
+}
+
 void QgsMSLayerCache::removeProjectFileLayers( const QString &project )
 {
+  QMutexLocker locker( &mMutex );
   QgsMessageLog::logMessage( "Removing cache entries for project file: " + project, QStringLiteral( "Server" ), QgsMessageLog::INFO );
   QVector< QPair< QString, QString > > removeEntries;
   QVector< QgsMSLayerCacheEntry > removeEntriesValues;
@@ -140,10 +194,45 @@ void QgsMSLayerCache::removeProjectFileLayers( const QString &project )
   }
 }
 
+void QgsMSLayerCache::removeThreadLayers( QThread *thread )
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mThreads.remove( thread ) )
+  {
+    return;
+  }
+
+  QMultiHash<QPair<QString, QString>, QgsMSLayerCacheEntry>::iterator entryIt = mEntries.begin();
+  while ( entryIt != mEntries.end() )
+  {
+    if ( entryIt->thread == thread )
+    {
+      // the thread has finished its requests, the layer is not registered in a project anymore
+      entryIt->thread = nullptr;
+      freeEntryResources( *entryIt );
+      entryIt = mEntries.erase( entryIt );
+    }
+    else
+    {
+      ++entryIt;
+    }
+  }
+}
+
 void QgsMSLayerCache::updateEntries()
 {
   QgsDebugMsg( "updateEntries" );
-  int entriesToDelete = mEntries.size() - qMax( mDefaultMaxLayers, mProjectMaxLayers );
+  QThread *thread = QThread::currentThread();
+  int threadEntries = 0;
+  Q_FOREACH ( const QgsMSLayerCacheEntry &entry, mEntries )
+  {
+    if ( entry.thread == thread )
+    {
+      ++threadEntries;
+    }
+  }
+
+  int entriesToDelete = threadEntries - qMax( mDefaultMaxLayers, mProjectMaxLayers );
   if ( entriesToDelete < 1 )
   {
     return;
@@ -157,24 +246,23 @@ void QgsMSLayerCache::updateEntries()
 
 void QgsMSLayerCache::removeLeastUsedEntry()
 {
-  if ( mEntries.size() < 1 )
-  {
-    return;
-  }
-
+  QThread *thread = QThread::currentThread();
   QHash<QPair<QString, QString>, QgsMSLayerCacheEntry>::iterator it = mEntries.begin();
-  QHash<QPair<QString, QString>, QgsMSLayerCacheEntry>::iterator lowest_it = it;
-  time_t lowest_time = it->lastUsedTime;
+  QHash<QPair<QString, QString>, QgsMSLayerCacheEntry>::iterator lowest_it = mEntries.end();
 
   for ( ; it != mEntries.end(); ++it )
   {
-    if ( it->lastUsedTime < lowest_time )
+    if ( it->thread == thread && ( lowest_it == mEntries.end() || it->lastUsedTime < lowest_it->lastUsedTime ) )
     {
       lowest_it = it;
-      lowest_time = it->lastUsedTime;
     }
   }
 
+  if ( lowest_it == mEntries.end() )
+  {
+    return;
+  }
+
   QgsMessageLog::logMessage( "Removing last accessed layer '" + lowest_it.value().layerPointer->name() + "' project file " + lowest_it.value().configFile + " from cache", QStringLiteral( "Server" ), QgsMessageLog::INFO );
   freeEntryResources( *lowest_it );
   mEntries.erase( lowest_it );
@@ -182,9 +270,14 @@ void QgsMSLayerCache::removeLeastUsedEntry()
 
 void QgsMSLayerCache::freeEntryResources( QgsMSLayerCacheEntry &entry )
 {
-  // remove layer from QgsProject before delete it
-  if ( QgsProject::instance()->mapLayer( entry.layerPointer->id() ) )
-    QgsProject::instance()->removeMapLayer( entry.layerPointer->id() );
+  // remove layer from the project of the request before delete it, the layers
+  // of the other threads are not registered in the projects of this thread
+  if ( entry.thread == QThread::currentThread() )
+  {
+    QgsProject *project = QgsServerRequestProject::current();
+    if ( project->mapLayer( entry.layerPointer->id() ) == entry.layerPointer )
+      project->removeMapLayer( entry.layerPointer->id() );
+  }
 
   delete entry.layerPointer;
 
@@ -207,7 +300,7 @@ void QgsMSLayerCache::freeEntryResources( QgsMSLayerCacheEntry &entry )
     if ( configFileCount < 2 )
     {
       mConfigFiles.remove( entry.configFile );
-      mFileSystemWatcher.removePath( entry.configFile );
+      QMetaObject::invokeMethod( this, "unwatchFile", Qt::AutoConnection, Q_ARG( QString, entry.configFile ) );
     }
     else
     {
@@ -218,6 +311,7 @@ void QgsMSLayerCache::freeEntryResources( QgsMSLayerCacheEntry &entry )
 
 void QgsMSLayerCache::logCacheContents() const
 {
+  QMutexLocker locker( &mMutex );
   QgsMessageLog::logMessage( QStringLiteral( "Layer cache contents:" ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   QHash<QPair<QString, QString>, QgsMSLayerCacheEntry>::const_iterator it = mEntries.constBegin();
   for ( ; it != mEntries.constEnd(); ++it )
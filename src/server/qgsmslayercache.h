@@ -21,11 +21,14 @@
 #include <time.h>
 #include <QFileSystemWatcher>
 #include <QMultiHash>
+#include <QMutex>
 #include <QObject>
 #include <QPair>
+#include <QSet>
 #include <QString>
 
 class QgsMapLayer;
+class QThread;
 
 struct QgsMSLayerCacheEntry
 {
@@ -35,6 +38,7 @@ struct QgsMSLayerCacheEntry
   QgsMapLayer *layerPointer = nullptr;
   QList<QString> temporaryFiles; //path to the temporary files written for the layer
   QString configFile; //path to the project file associated with the layer
+  QThread *thread = nullptr; //thread using the layer, the layers are not shared between the threads
 
   bool operator==( const QgsMSLayerCacheEntry &other ) const
   {
@@ -43,12 +47,19 @@ struct QgsMSLayerCacheEntry
              && url == other.url
              && layerPointer == other.layerPointer
              && temporaryFiles == other.temporaryFiles
-             && configFile == other.configFile );
+             && configFile == other.configFile
+             && thread == other.thread );
   }
 };
 
 /** A singleton class that caches layer objects for the
-QGIS mapserver*/
+QGIS mapserver.
+
+The requests may modify the layers they use (filters, selections, opacity...), so the
+layers are cached for each thread and are only returned to the thread which inserted them.
+The layers of a thread are removed when it finishes. The layers of a project file which
+has changed are removed by removeChangedProjectLayers(), which must not be called while
+other requests are executed.*/
 class QgsMSLayerCache: public QObject
 {
     Q_OBJECT
@@ -74,9 +85,9 @@ class QgsMSLayerCache: public QObject
      \returns a pointer to the layer or 0 if no such layer*/
     QgsMapLayer *searchLayer( const QString &url, const QString &layerName, const QString &configFile = QString() );
 
-    int projectsMaxLayers() const { return mProjectMaxLayers; }
+    int projectsMaxLayers() const;
 
-    void setProjectMaxLayers( int n ) { mProjectMaxLayers = n; }
+    void setProjectMaxLayers( int n );
 
     //for debugging
     void logCacheContents() const;
@@ -84,15 +95,26 @@ class QgsMSLayerCache: public QObject
     //! Expose method for use in server interface
     void removeProjectLayers( const QString &path );
 
+    /** Returns true if project files have changed since the last call to removeChangedProjectLayers()
+     * \since QGIS 3.0
+     */
+    bool hasChangedProjects() const;
+
+    /** Removes the layers of the project files which have changed
+     * \see hasChangedProjects()
+     * \since QGIS 3.0
+     */
+    void removeChangedProjectLayers();
+
   protected:
     //! Protected singleton constructor
     QgsMSLayerCache();
 
-    /** Goes through the list and removes entries and layers
+    /** Goes through the list and removes entries and layers of the current thread
      depending on their time stamps and the number of other
     layers*/
     void updateEntries();
-    //! Removes the cash entry with the lowest 'lastUsedTime'
+    //! Removes the cash entry of the current thread with the lowest 'lastUsedTime'
     void removeLeastUsedEntry();
     //! Frees memory and removes temporary files of an entry
     void freeEntryResources( QgsMSLayerCacheEntry &entry );
@@ -116,10 +138,31 @@ class QgsMSLayerCache: public QObject
     //! Maximum number of layers in the cache, overrides DEFAULT_MAX_N_LAYERS if larger
     int mProjectMaxLayers = 100;
 
-  private slots:
+    //! Protects the entries, which are used by concurrent requests
+    mutable QMutex mMutex;
+
+    //! Threads having layers in the cache
+    QSet< QThread * > mThreads;
+
+    //! Project files changed since the last call to removeChangedProjectLayers()
+    QSet< QString > mChangedProjects;
 
     //! Removes entries from a project (e.g. if a project file has changed)
     void removeProjectFileLayers( const QString &project );
+
+    //! Removes the entries of a finished \a thread
+    void removeThreadLayers( QThread *thread );
+
+  private slots:
+
+    //! Records a changed project file, its layers are removed by removeChangedProjectLayers()
+    void addChangedProject( const QString &project );
+
+    //! Watches the configuration file \a path, in the thread of the cache
+    void watchFile( const QString &path );
+
+    //! Stops watching the configuration file \a path, in the thread of the cache
+    void unwatchFile( const QString &path );
 };
 
 #endif
@@ -25,6 +25,7 @@
 #include "qgsmapsettings.h"
 #include "qgsauthmanager.h"
 #include "qgscapabilitiescache.h"
+#include "qgsconfigcache.h"
 #include "qgsfontutils.h"
 #include "qgsrequesthandler.h"
 #include "qgsproject.h"
@@ -39,7 +40,9 @@
 #include "qgsbufferserverrequest.h"
 #include "qgsfilterresponsedecorator.h"
 #include "qgsservice.h"
+#include "qgsservermetrics.h"
 #include "qgsserverprojectutils.h"
+#include "qgsserverrequestproject.h"
 #include "qgsgui.h"
 
 #include <QDomDocument>
@@ -47,6 +50,12 @@
 #include <QImage>
 #include <QSettings>
 #include <QDateTime>
+#include <QEvent>
+#include <QSemaphore>
+#include <QThread>
+
+#include <functional>
+#include <memory>
 
 // TODO: remove, it's only needed by a single debug message
 #include <fcgi_stdio.h>
@@ -67,6 +76,50 @@ QgsServerSettings QgsServer::sSettings;
 
 QgsServiceRegistry QgsServer::sServiceRegistry;
 
+QReadWriteLock QgsServer::sRequestLock;
+
+///@cond PRIVATE
+namespace
+{
+
+  //! Event posted by a worker thread to execute an exclusive request in the main thread
+  class ExclusiveRequestEvent : public QEvent
+  {
+    public:
+      ExclusiveRequestEvent( const std::function< void() > &function, QSemaphore *done )
+        : QEvent( QEvent::User )
+        , mFunction( function )
+        , mDone( done )
+      {}
+
+      ~ExclusiveRequestEvent()
+      {
+        // wake up the worker thread, even if the event is discarded on exit
+        mDone->release();
+      }
+
+      void execute() { mFunction(); }
+
+    private:
+      std::function< void() > mFunction;
+      QSemaphore *mDone = nullptr;
+  };
+
+  //! Executes the exclusive requests posted to the main thread
+  class ExclusiveRequestExecutor : public QObject
+  {
+    protected:
+      void customEvent( QEvent *event ) override
+      {
+        static_cast< ExclusiveRequestEvent * >( event )->execute();
+      }
+  };
+
+  ExclusiveRequestExecutor *sExclusiveRequestExecutor = nullptr;
+
+}
+///@endcond
+
 QgsServer::QgsServer( )
 {
   // QgsApplication must exist
@@ -223,6 +276,7 @@ bool QgsServer::init( )
   // init and configure cache
   QgsMSLayerCache::instance();
   QgsMSLayerCache::instance()->setMaxCacheLayers( sSettings.maxCacheLayers() );
+  QgsConfigCache::instance()->setUseProjectSnapshot( sSettings.projectSnapshot() );
 
   // log settings currently used
   sSettings.logSummary();
@@ -267,6 +321,7 @@ bool QgsServer::init( )
 
   //create cache for capabilities XML
   sCapabilitiesCache = new QgsCapabilitiesCache();
+  sCapabilitiesCache->setCacheDirectory( sSettings.capabilitiesCacheDirectory() );
 
 #ifdef ENABLE_MS_TESTS
   QgsFontUtils::loadStandardTestFonts( QStringList() << QStringLiteral( "Roman" ) << QStringLiteral( "Bold" ) );
@@ -276,11 +331,20 @@ bool QgsServer::init( )
 
   sServerInterface = new QgsServerInterfaceImpl( sCapabilitiesCache, &sServiceRegistry, &sSettings );
 
+  // created in the main thread, which executes the exclusive requests of worker threads
+  sExclusiveRequestExecutor = new ExclusiveRequestExecutor();
+  sExclusiveRequestExecutor->setParent( qApp );
+
   // Load service module
   QString modulePath =  QgsApplication::libexecPath() + "server";
   qDebug() << "Initializing server modules from " << modulePath << endl;
   sServiceRegistry.init( modulePath,  sServerInterface );
 
+  if ( sSettings.metrics() )
+  {
+    QgsServerMetrics::registerService( sServiceRegistry );
+  }
+
   sInitialized = true;
   QgsMessageLog::logMessage( QStringLiteral( "Server initialized" ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
   return true;
@@ -296,6 +360,7 @@ void QgsServer::putenv( const QString &var, const QString &val )
   setenv( var.toStdString().c_str(), val.toStdString().c_str(), 1 );
 #endif
   sSettings.load( var );
+  QgsConfigCache::instance()->setUseProjectSnapshot( sSettings.projectSnapshot() );
 }
 
 /**
@@ -305,18 +370,107 @@ void QgsServer::putenv( const QString &var, const QString &val )
  */
 
 void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &response )
+{
+  if ( QThread::currentThread() == qApp->thread() )
+  {
+    // wait for the concurrent requests, executing the exclusive requests of the worker threads meanwhile
+    while ( !sRequestLock.tryLockForWrite( 10 ) )
+    {
+      QCoreApplication::sendPostedEvents( sExclusiveRequestExecutor );
+    }
+    executeRequest( request, response, true );
+    sRequestLock.unlock();
+    return;
+  }
+
+  // Request accepted by a worker thread
+  {
+    QReadLocker locker( &sRequestLock );
+    if ( allowConcurrentRequest( request ) )
+    {
+      executeRequest( request, response, false );
+      return;
+    }
+  }
+
+  QWriteLocker locker( &sRequestLock );
+  QSemaphore done;
+  QCoreApplication::postEvent( sExclusiveRequestExecutor, new ExclusiveRequestEvent( [this, &request, &response]
+  {
+    executeRequest( request, response, true );
+  }, &done ) );
+  done.acquire();
+}
+
+bool QgsServer::allowConcurrentRequest( const QgsServerRequest &request ) const
+{
+  // Plugins may change the request and the project layers, and they share the Python interpreter
+  if ( !QgsServerPlugins::serverPlugins().isEmpty() || !sServerInterface->filters().isEmpty() )
+  {
+    return false;
+  }
+
+  // Changed configuration files are removed from the caches by exclusive requests
+  if ( QgsConfigCache::instance()->hasChangedEntries() || QgsMSLayerCache::instance()->hasChangedProjects() )
+  {
+    return false;
+  }
+
+  // Projects are only loaded by exclusive requests
+  QMap<QString, QString> parameterMap = request.parameters();
+  if ( !mProjectRegistry.contains( configPath( *sConfigFilePath, parameterMap ) ) )
+  {
+    return false;
+  }
+
+  QgsService *requestService = service( parameterMap );
+  return requestService && requestService->allowConcurrentRequest( request );
+}
+
+QgsService *QgsServer::service( const QMap<QString, QString> &parameterMap )
+{
+  QString serviceString = parameterMap.value( QStringLiteral( "SERVICE" ) );
+
+  if ( serviceString.isEmpty() )
+  {
+    // SERVICE not mandatory for WMS 1.3.0 GetMap & GetFeatureInfo
+    QString requestString = parameterMap.value( QStringLiteral( "REQUEST" ) );
+    if ( requestString == QLatin1String( "GetMap" ) || requestString == QLatin1String( "GetFeatureInfo" ) )
+    {
+      serviceString = QStringLiteral( "WMS" );
+    }
+  }
+
+  QString versionString = parameterMap.value( QStringLiteral( "VERSION" ) );
+
+  return sServiceRegistry.getService( serviceString, versionString );
+}
+
+void QgsServer::executeRequest( QgsServerRequest &request, QgsServerResponse &response, bool exclusive )
 {
   QgsMessageLog::MessageLevel logLevel = QgsServerLogger::instance()->logLevel();
   QTime time; //used for measuring request time if loglevel < 1
-  QgsProject::instance()->removeAllMapLayers();
+  if ( exclusive )
+  {
+    QgsProject::instance()->removeAllMapLayers();
+
+    qApp->processEvents();
 
-  qApp->processEvents();
+    // no other request uses the caches now
+    QgsMSLayerCache::instance()->removeChangedProjectLayers();
+    QgsConfigCache::instance()->removeChangedEntries();
+  }
 
   if ( logLevel == QgsMessageLog::INFO )
   {
     time.start();
   }
 
+  if ( sSettings.metrics() )
+  {
+    QgsServerMetrics::startRequest();
+  }
+
   // Pass the filters to the requestHandler, this is needed for the following reasons:
   // Allow server request to call sendResponse plugin hook if enabled
   QgsFilterResponseDecorator responseDecorator( sServerInterface->filters(), response );
@@ -336,10 +490,18 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
   }
 
   // Set the request handler into the interface for plugins to manipulate it
-  sServerInterface->setRequestHandler( &requestHandler );
+  if ( exclusive )
+  {
+    sServerInterface->setRequestHandler( &requestHandler );
+  }
 
   // Call  requestReady() method (if enabled)
-  responseDecorator.start();
+  {
+    QgsServerMetrics::StageTimer stage( QStringLiteral( "filters" ) );
+    responseDecorator.start();
+  }
+
+  QString serviceName;
 
   // Plugins may have set exceptions
   if ( !requestHandler.exceptionRaised() )
@@ -352,39 +514,58 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
       //Config file path
       QString configFilePath = configPath( *sConfigFilePath, parameterMap );
 
-      // load the project if needed and not empty
-      auto projectIt = mProjectRegistry.find( configFilePath );
-      if ( projectIt == mProjectRegistry.constEnd() )
+      // Lookup for service
+      QgsService *requestService = service( parameterMap );
+      if ( requestService )
       {
-        // load the project
-        QgsProject *project = new QgsProject();
-        project->setFileName( configFilePath );
-        if ( project->read() )
-        {
-          projectIt = mProjectRegistry.insert( configFilePath, project );
-        }
-        else
-        {
-          throw QgsServerException( QStringLiteral( "Project file error" ) );
-        }
+        serviceName = requestService->name();
       }
 
-      sServerInterface->setConfigFilePath( configFilePath );
-
-      //Service parameter
-      QString serviceString = parameterMap.value( QStringLiteral( "SERVICE" ) );
-
-      if ( serviceString.isEmpty() )
+      // load the project if needed and not empty, the metrics of the server do not depend on a project
+      const QgsProject *project = nullptr;
+      if ( serviceName != QLatin1String( "METRICS" ) )
       {
-        // SERVICE not mandatory for WMS 1.3.0 GetMap & GetFeatureInfo
-        QString requestString = parameterMap.value( QStringLiteral( "REQUEST" ) );
-        if ( requestString == QLatin1String( "GetMap" ) || requestString == QLatin1String( "GetFeatureInfo" ) )
+        QgsServerMetrics::StageTimer stage( QStringLiteral( "config" ) );
+        auto projectIt = mProjectRegistry.find( configFilePath );
+        if ( projectIt == mProjectRegistry.constEnd() )
         {
-          serviceString = QStringLiteral( "WMS" );
+          // load the project
+          QgsProject *newProject = new QgsProject();
+          newProject->setFileName( configFilePath );
+          newProject->setUseSnapshot( sSettings.projectSnapshot() );
+          // the WMS configuration parser reads its layers itself, only the WFS and WCS layers
+          // are looked up in the project
+          newProject->setDeferLayerLoading( true );
+          if ( newProject->read() )
+          {
+            // the projects are only loaded by exclusive requests, the layers are read now so
+            // that the concurrent requests never modify the project
+            QStringList layerIds = QgsServerProjectUtils::wfsLayerIds( *newProject ) + QgsServerProjectUtils::wcsLayers( *newProject );
+            Q_FOREACH ( const QString &layerId, layerIds )
+            {
+              newProject->readDeferredLayer( layerId );
+            }
+            projectIt = mProjectRegistry.insert( configFilePath, newProject );
+          }
+          else
+          {
+            throw QgsServerException( QStringLiteral( "Project file error" ) );
+          }
         }
+        project = projectIt.value();
       }
 
-      QString versionString = parameterMap.value( QStringLiteral( "VERSION" ) );
+      // the layers of a concurrent request are registered in its own project
+      std::unique_ptr< QgsServerRequestProject > requestProject;
+      if ( !exclusive )
+      {
+        requestProject.reset( new QgsServerRequestProject( configFilePath ) );
+      }
+
+      if ( exclusive )
+      {
+        sServerInterface->setConfigFilePath( configFilePath );
+      }
 
       //possibility for client to suggest a download filename
       QString outputFileName = parameterMap.value( QStringLiteral( "FILE_NAME" ) );
@@ -393,11 +574,9 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
         requestHandler.setResponseHeader( QStringLiteral( "Content-Disposition" ), "attachment; filename=\"" + outputFileName + "\"" );
       }
 
-      // Lookup for service
-      QgsService *service = sServiceRegistry.getService( serviceString, versionString );
-      if ( service )
+      if ( requestService )
       {
-        service->executeRequest( request, responseDecorator, projectIt.value() );
+        requestService->executeRequest( request, responseDecorator, project );
       }
       else
       {
@@ -415,12 +594,25 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
       response.sendError( 500, ex.what() );
     }
   }
+  if ( sSettings.metrics() )
+  {
+    QString serverTiming = QgsServerMetrics::endRequest( serviceName.isEmpty() ? QStringLiteral( "unknown" ) : serviceName,
+                           request.parameter( QStringLiteral( "REQUEST" ) ) );
+    if ( !responseDecorator.headersSent() )
+    {
+      responseDecorator.setHeader( QStringLiteral( "Server-Timing" ), serverTiming );
+    }
+  }
+
   // Terminate the response
   responseDecorator.finish();
 
   // We are done using requestHandler in plugins, make sure we don't access
   // to a deleted request handler from Python bindings
-  sServerInterface->clearRequestHandler();
+  if ( exclusive )
+  {
+    sServerInterface->clearRequestHandler();
+  }
 
   if ( logLevel == QgsMessageLog::INFO )
   {
@@ -28,6 +28,7 @@
 #define QGSSERVER_H
 
 #include <QFileInfo>
+#include <QReadWriteLock>
 #include "qgsrequesthandler.h"
 #include "qgsapplication.h"
 #include "qgsconfigcache.h"
@@ -47,6 +48,16 @@ class QgsProject;
 
 /** \ingroup server
  * The QgsServer class provides OGC web services.
+ *
+ * Requests are usually handled one after the other in the main thread. A multi-threaded
+ * server may also call handleRequest() from worker threads while the main thread runs
+ * the application event loop: requests are then executed concurrently in the worker
+ * threads when their service allows it (see QgsService::allowConcurrentRequest()), their
+ * project has already been loaded and no server plugins are loaded. Concurrent requests
+ * register their layers in their own QgsServerRequestProject. All the other requests are
+ * executed exclusively in the main thread, which owns the QgsProject::instance() singleton
+ * and the Python interpreter, and removes the QgsConfigCache and QgsMSLayerCache entries of
+ * the configuration files which have changed.
  */
 class SERVER_EXPORT QgsServer
 {
@@ -70,6 +81,7 @@ class SERVER_EXPORT QgsServer
      *
      * \param request a QgsServerRequest holding request parameters
      * \param response a QgsServerResponse for handling response I/O)
+     * \note may be called from several threads, see the class documentation
      */
     void handleRequest( QgsServerRequest &request, QgsServerResponse &response );
 
@@ -88,6 +100,18 @@ class SERVER_EXPORT QgsServer
     //! Server initialization
     static bool init();
 
+    /**
+     * Executes the request, \a exclusive is false for requests executed concurrently
+     * by worker threads, which must not change the state shared by the requests.
+     */
+    void executeRequest( QgsServerRequest &request, QgsServerResponse &response, bool exclusive );
+
+    //! Returns true if the request may be executed concurrently with other requests
+    bool allowConcurrentRequest( const QgsServerRequest &request ) const;
+
+    //! Returns the service requested by the parameters, or nullptr if it is unknown
+    static QgsService *service( const QMap<QString, QString> &parameterMap );
+
     // All functions that where previously in the main file are now
     // static methods of this class
     static QString configPath( const QString &defaultConfigPath,
@@ -123,6 +147,9 @@ class SERVER_EXPORT QgsServer
 
     static QgsServerSettings sSettings;
 
+    //! Held for reading by concurrent requests and for writing by exclusive requests
+    static QReadWriteLock sRequestLock;
+
     // map of QgsProject
     QMap<QString, const QgsProject *> mProjectRegistry;
 };
@@ -0,0 +1,168 @@
+/***************************************************************************
+                          qgsservercompressor.cpp
+                          -----------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsservercompressor.h"
+#include "qgsmessagelog.h"
+
+#include <QStringList>
+
+#include <zlib.h>
+
+namespace
+{
+  //! Size of the chunks of compressed data
+  const int CHUNK_SIZE = 16384;
+}
+
+QgsServerCompressor::Encoding QgsServerCompressor::acceptedEncoding( const QString &acceptEncoding )
+{
+  double gzipQuality = 0;
+  double deflateQuality = 0;
+  double anyQuality = 0;
+  bool gzipListed = false;
+  bool deflateListed = false;
+
+  Q_FOREACH ( const QString &coding, acceptEncoding.split( ',', QString::SkipEmptyParts ) )
+  {
+    QStringList parameters = coding.split( ';' );
+    QString name = parameters.at( 0 ).trimmed().toLower();
+    double quality = 1;
+    for ( int i = 1; i < parameters.size(); ++i )
+    {
+      QString parameter = parameters.at( i ).trimmed();
+      if ( parameter.startsWith( QLatin1String( "q=" ) ) )
+        quality = parameter.mid( 2 ).toDouble();
+    }
+
+    if ( name == QLatin1String( "gzip" ) || name == QLatin1String( "x-gzip" ) )
+    {
+      gzipQuality = quality;
+      gzipListed = true;
+    }
+    else if ( name == QLatin1String( "deflate" ) )
+    {
+      deflateQuality = quality;
+      deflateListed = true;
+    }
+    else if ( name == QLatin1String( "*" ) )
+    {
+      anyQuality = quality;
+    }
+  }
+
+  if ( !gzipListed )
+    gzipQuality = anyQuality;
+  if ( !deflateListed )
+    deflateQuality = anyQuality;
+
+  // gzip is preferred, as some clients do not handle deflate correctly
+  if ( gzipQuality > 0 && gzipQuality >= deflateQuality )
+    return Gzip;
+  if ( deflateQuality > 0 )
+    return Deflate;
+  return Identity;
+}
+
+QString QgsServerCompressor::encodingName( Encoding encoding )
+{
+  switch ( encoding )
+  {
+    case Gzip:
+      return QStringLiteral( "gzip" );
+    case Deflate:
+      return QStringLiteral( "deflate" );
+    case Identity:
+      break;
+  }
+  return QStringLiteral( "identity" );
+}
+
+bool QgsServerCompressor::isCompressible( const QString &contentType )
+{
+  QString type = contentType.section( ';', 0, 0 ).trimmed().toLower();
+  return type.startsWith( QLatin1String( "text/" ) )
+         || type.contains( QLatin1String( "xml" ) )
+         || type.contains( QLatin1String( "json" ) )
+         || type.contains( QLatin1String( "gml" ) )
+         || type.contains( QLatin1String( "javascript" ) );
+}
+
+QByteArray QgsServerCompressor::compress( const QByteArray &data, Encoding encoding, int level )
+{
+  QgsServerCompressor compressor( encoding, level );
+  return compressor.compress( data.constData(), data.size() ) + compressor.finish();
+}
+
+QgsServerCompressor::QgsServerCompressor( Encoding encoding, int level )
+  : mStream( new z_stream )
+{
+  mStream->zalloc = Z_NULL;
+  mStream->zfree = Z_NULL;
+  mStream->opaque = Z_NULL;
+
+  // 16 is added to the window bits to write a gzip header and trailer instead of the zlib ones
+  int windowBits = encoding == Gzip ? 15 + 16 : 15;
+  mValid = encoding != Identity && deflateInit2( mStream.get(), level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY ) == Z_OK;
+  if ( !mValid && encoding != Identity )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Cannot initialize the compression of the response" ), QStringLiteral( "Server" ), QgsMessageLog::CRITICAL );
+  }
+}
+
+QgsServerCompressor::~QgsServerCompressor()
+{
+  if ( mValid )
+  {
+    deflateEnd( mStream.get() );
+  }
+}
+
+QByteArray QgsServerCompressor::compress( const char *data, qint64 length )
+{
+  return deflate( data, length, Z_NO_FLUSH );
+}
+
+QByteArray QgsServerCompressor::finish()
+{
+  return deflate( nullptr, 0, Z_FINISH );
+}
+
+QByteArray QgsServerCompressor::deflate( const char *data, qint64 length, int flush )
+{
+  QByteArray result;
+  if ( !mValid )
+    return result;
+
+  mStream->next_in = reinterpret_cast< Bytef * >( const_cast< char * >( data ) );
+  mStream->avail_in = static_cast< uInt >( length );
+
+  char chunk[CHUNK_SIZE];
+  do
+  {
+    mStream->next_out = reinterpret_cast< Bytef * >( chunk );
+    mStream->avail_out = CHUNK_SIZE;
+    int rc = ::deflate( mStream.get(), flush );
+    if ( rc == Z_STREAM_ERROR )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Compression of the response failed" ), QStringLiteral( "Server" ), QgsMessageLog::CRITICAL );
+      break;
+    }
+    result.append( chunk, CHUNK_SIZE - static_cast< int >( mStream->avail_out ) );
+  }
+  while ( mStream->avail_out == 0 );
+
+  return result;
+}
@@ -0,0 +1,96 @@
+/***************************************************************************
+                          qgsservercompressor.h
+                          ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERCOMPRESSOR_H
+#define QGSSERVERCOMPRESSOR_H
+
+#include "qgis_server.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <memory>
+
+struct z_stream_s;
+
+/** \ingroup server
+ * Streaming compressor of the bodies of the HTTP responses.
+ *
+ * The data are compressed in the gzip (RFC 1952) or the zlib (RFC 1950) format, which
+ * are the formats of the "gzip" and "deflate" HTTP content codings.
+ * \since QGIS 3.0
+ */
+class SERVER_EXPORT QgsServerCompressor
+{
+  public:
+
+    //! HTTP content codings
+    enum Encoding
+    {
+      Identity, //!< Not compressed
+      Gzip, //!< gzip format
+      Deflate //!< zlib format
+    };
+
+    /** Returns the preferred content coding of a client.
+     * \param acceptEncoding the value of the Accept-Encoding header of the request
+     * \returns the coding, Identity if the client accepts neither gzip nor deflate
+     */
+    static Encoding acceptedEncoding( const QString &acceptEncoding );
+
+    //! Returns the name of \a encoding, as used in the Content-Encoding header
+    static QString encodingName( Encoding encoding );
+
+    /** Returns true if a content of type \a contentType is worth compressing,
+     * i.e. if it is text such as XML, GML, JSON or HTML and not an already compressed image.
+     */
+    static bool isCompressible( const QString &contentType );
+
+    /** Compresses \a data at once.
+     * \param data the data to compress
+     * \param encoding the content coding
+     * \param level the zlib compression level, from 1 (fastest) to 9 (smallest), -1 for the default
+     */
+    static QByteArray compress( const QByteArray &data, Encoding encoding, int level = -1 );
+
+    /** Constructor for a compressor of a stream.
+     * \param encoding the content coding, Gzip or Deflate
+     * \param level the zlib compression level, from 1 (fastest) to 9 (smallest), -1 for the default
+     */
+    explicit QgsServerCompressor( Encoding encoding, int level = -1 );
+
+    ~QgsServerCompressor();
+
+    /** Compresses the next \a length bytes of the stream.
+     * \returns the compressed data available, which may be empty
+     * \note available in Python bindings as compressPart()
+     */
+    QByteArray compress( const char *data, qint64 length );
+
+    //! Ends the stream and returns the remaining compressed data
+    QByteArray finish();
+
+  private:
+    QgsServerCompressor( const QgsServerCompressor & ) = delete;
+    QgsServerCompressor &operator=( const QgsServerCompressor & ) = delete;
+
+    QByteArray deflate( const char *data, qint64 length, int flush );
+
+    std::unique_ptr< z_stream_s > mStream;
+    bool mValid = false;
+};
+
+#endif // QGSSERVERCOMPRESSOR_H
@@ -0,0 +1,290 @@
+/***************************************************************************
+                          qgsservermetrics.cpp
+                          --------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsservermetrics.h"
+#include "qgsmaplayer.h"
+#include "qgsmaprendererjob.h"
+#include "qgsruntimeprofiler.h"
+#include "qgsservice.h"
+#include "qgsserviceregistry.h"
+
+#include <QMutexLocker>
+#include <QSet>
+#include <QStringList>
+#include <QThreadStorage>
+#include <QTime>
+
+namespace
+{
+  //! Upper bounds of the buckets of the request duration histogram, in seconds
+  const double DURATION_BUCKETS[] = { 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10 };
+  const int DURATION_BUCKET_COUNT = sizeof( DURATION_BUCKETS ) / sizeof( DURATION_BUCKETS[0] );
+
+  //! Maximal number of request kinds, the names of the requests come from the clients
+  const int MAX_REQUEST_KINDS = 100;
+
+  //! Timings of the request executed by a thread
+  struct RequestTimings
+  {
+    QTime time;
+    QgsRuntimeProfiler profiler;
+    int stageDepth = 0;
+
+    struct LayerRendering
+    {
+      QString id;
+      QString name;
+      int milliseconds;
+      bool error;
+    };
+    QList< LayerRendering > layers;
+  };
+
+  QThreadStorage< RequestTimings * > &requestTimings()
+  {
+    static QThreadStorage< RequestTimings * > sRequestTimings;
+    return sRequestTimings;
+  }
+
+  //! Returns the timings of the request of the current thread, or nullptr if no request is started
+  RequestTimings *currentRequest()
+  {
+    return requestTimings().hasLocalData() ? requestTimings().localData() : nullptr;
+  }
+
+  QString labelValue( const QString &value )
+  {
+    QString escaped = value;
+    escaped.replace( '\\', QLatin1String( "\\\\" ) );
+    escaped.replace( '"', QLatin1String( "\\\"" ) );
+    escaped.replace( '\n', QLatin1String( "\\n" ) );
+    return '"' + escaped + '"';
+  }
+
+  //! Publishes the metrics of the server
+  class QgsServerMetricsService : public QgsService
+  {
+    public:
+
+      QString name() const override { return QStringLiteral( "METRICS" ); }
+
+      QString version() const override { return QStringLiteral( "1.0.0" ); }
+
+      bool allowMethod( QgsServerRequest::Method method ) const override
+      {
+        return method == QgsServerRequest::GetMethod;
+      }
+
+      void executeRequest( const QgsServerRequest &request, QgsServerResponse &response,
+                           const QgsProject *project ) override
+      {
+        Q_UNUSED( request );
+        Q_UNUSED( project );
+        response.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "text/plain; version=0.0.4" ) );
+        response.write( QgsServerMetrics::instance()->prometheusText() );
+      }
+  };
+}
+
+QgsServerMetrics::StageTimer::StageTimer( const QString &name )
+{
+  RequestTimings *timings = currentRequest();
+  if ( timings && timings->stageDepth++ == 0 )
+  {
+    timings->profiler.start( name );
+  }
+}
+
+QgsServerMetrics::StageTimer::~StageTimer()
+{
+  RequestTimings *timings = currentRequest();
+  if ( timings && timings->stageDepth > 0 && --timings->stageDepth == 0 )
+  {
+    timings->profiler.end();
+  }
+}
+
+QgsServerMetrics *QgsServerMetrics::instance()
+{
+  static QgsServerMetrics sInstance;
+  return &sInstance;
+}
+
+void QgsServerMetrics::registerService( QgsServiceRegistry &registry )
+{
+  registry.registerService( new QgsServerMetricsService() );
+}
+
+void QgsServerMetrics::startRequest()
+{
+  RequestTimings *timings = new RequestTimings;
+  timings->time.start();
+  // deletes the timings of a previous request which was not ended
+  requestTimings().setLocalData( timings );
+}
+
+QString QgsServerMetrics::endRequest( const QString &service, const QString &request )
+{
+  RequestTimings *timings = currentRequest();
+  if ( !timings )
+    return QString();
+
+  double totalSeconds = timings->time.elapsed() / 1000.0;
+
+  // the same stage may be timed several times during a request
+  QStringList stageNames;
+  QMap< QString, double > stages;
+  typedef QPair< QString, double > ProfileTime;
+  Q_FOREACH ( const ProfileTime &profileTime, timings->profiler.profileTimes() )
+  {
+    if ( !stages.contains( profileTime.first ) )
+      stageNames << profileTime.first;
+    stages[ profileTime.first ] += profileTime.second;
+  }
+
+  QStringList serverTiming;
+  Q_FOREACH ( const QString &stage, stageNames )
+  {
+    serverTiming << QStringLiteral( "%1;dur=%2" ).arg( stage ).arg( stages.value( stage ) * 1000, 0, 'f', 0 );
+  }
+  Q_FOREACH ( const RequestTimings::LayerRendering &layer, timings->layers )
+  {
+    serverTiming << QStringLiteral( "layer;desc=%1;dur=%2" ).arg( labelValue( layer.id ) ).arg( layer.milliseconds );
+  }
+  serverTiming << QStringLiteral( "total;dur=%1" ).arg( totalSeconds * 1000, 0, 'f', 0 );
+
+  QgsServerMetrics *metrics = instance();
+  {
+    QMutexLocker locker( &metrics->mMutex );
+
+    QPair< QString, QString > kind( service, request );
+    if ( !metrics->mRequests.contains( kind ) && metrics->mRequests.size() >= MAX_REQUEST_KINDS )
+      kind = qMakePair( service, QStringLiteral( "other" ) );
+    RequestMetrics &requestMetrics = metrics->mRequests[ kind ];
+    if ( requestMetrics.buckets.isEmpty() )
+      requestMetrics.buckets.fill( 0, DURATION_BUCKET_COUNT );
+    for ( int i = 0; i < DURATION_BUCKET_COUNT; ++i )
+    {
+      if ( totalSeconds <= DURATION_BUCKETS[i] )
+        ++requestMetrics.buckets[i];
+    }
+    ++requestMetrics.count;
+    requestMetrics.seconds += totalSeconds;
+
+    for ( QMap< QString, double >::const_iterator it = stages.constBegin(); it != stages.constEnd(); ++it )
+    {
+      metrics->mStages[ it.key()] += it.value();
+    }
+
+    Q_FOREACH ( const RequestTimings::LayerRendering &layer, timings->layers )
+    {
+      LayerMetrics &layerMetrics = metrics->mLayers[ layer.id ];
+      layerMetrics.name = layer.name;
+      ++layerMetrics.count;
+      if ( layer.error )
+        ++layerMetrics.errors;
+      layerMetrics.seconds += layer.milliseconds / 1000.0;
+    }
+  }
+
+  requestTimings().setLocalData( nullptr );
+  return serverTiming.join( QStringLiteral( ", " ) );
+}
+
+void QgsServerMetrics::addLayerRendering( const QString &layerId, const QString &layerName, int milliseconds, bool error )
+{
+  RequestTimings *timings = currentRequest();
+  if ( !timings )
+    return;
+
+  RequestTimings::LayerRendering layer;
+  layer.id = layerId;
+  layer.name = layerName;
+  layer.milliseconds = milliseconds;
+  layer.error = error;
+  timings->layers << layer;
+}
+
+void QgsServerMetrics::addLayerRenderings( const QgsMapRendererJob &job )
+{
+  if ( !currentRequest() )
+    return;
+
+  QSet<QString> failedLayerIds;
+  Q_FOREACH ( const QgsMapRendererJob::Error &error, job.errors() )
+  {
+    failedLayerIds << error.layerID;
+  }
+
+  QHash<QString, int> renderingTimes = job.perLayerRenderingTime();
+  Q_FOREACH ( QgsMapLayer *layer, job.mapSettings().layers() )
+  {
+    if ( layer && ( renderingTimes.contains( layer->id() ) || failedLayerIds.contains( layer->id() ) ) )
+    {
+      addLayerRendering( layer->id(), layer->name(), renderingTimes.value( layer->id() ), failedLayerIds.contains( layer->id() ) );
+    }
+  }
+}
+
+QByteArray QgsServerMetrics::prometheusText() const
+{
+  QMutexLocker locker( &mMutex );
+
+  QStringList lines;
+  lines << QStringLiteral( "# HELP qgis_server_request_duration_seconds Duration of the requests." )
+        << QStringLiteral( "# TYPE qgis_server_request_duration_seconds histogram" );
+  for ( QMap< QPair< QString, QString >, RequestMetrics >::const_iterator it = mRequests.constBegin(); it != mRequests.constEnd(); ++it )
+  {
+    QString labels = QStringLiteral( "service=%1,request=%2" ).arg( labelValue( it.key().first ), labelValue( it.key().second ) );
+    for ( int i = 0; i < DURATION_BUCKET_COUNT; ++i )
+    {
+      lines << QStringLiteral( "qgis_server_request_duration_seconds_bucket{%1,le=\"%2\"} %3" ).arg( labels ).arg( DURATION_BUCKETS[i] ).arg( it.value().buckets.at( i ) );
+    }
+    lines << QStringLiteral( "qgis_server_request_duration_seconds_bucket{%1,le=\"+Inf\"} %2" ).arg( labels ).arg( it.value().count )
+          << QStringLiteral( "qgis_server_request_duration_seconds_sum{%1} %2" ).arg( labels ).arg( it.value().seconds )
+          << QStringLiteral( "qgis_server_request_duration_seconds_count{%1} %2" ).arg( labels ).arg( it.value().count );
+  }
+
+  lines << QStringLiteral( "# HELP qgis_server_stage_seconds_total Time spent in the stages of the requests." )
+        << QStringLiteral( "# TYPE qgis_server_stage_seconds_total counter" );
+  for ( QMap< QString, double >::const_iterator it = mStages.constBegin(); it != mStages.constEnd(); ++it )
+  {
+    lines << QStringLiteral( "qgis_server_stage_seconds_total{stage=%1} %2" ).arg( labelValue( it.key() ) ).arg( it.value() );
+  }
+
+  lines << QStringLiteral( "# HELP qgis_server_layer_render_seconds_total Time spent rendering the layers." )
+        << QStringLiteral( "# TYPE qgis_server_layer_render_seconds_total counter" );
+  for ( QMap< QString, LayerMetrics >::const_iterator it = mLayers.constBegin(); it != mLayers.constEnd(); ++it )
+  {
+    lines << QStringLiteral( "qgis_server_layer_render_seconds_total{layer=%1,name=%2} %3" ).arg( labelValue( it.key() ), labelValue( it.value().name ) ).arg( it.value().seconds );
+  }
+
+  lines << QStringLiteral( "# HELP qgis_server_layer_renders_total Number of renderings of the layers." )
+        << QStringLiteral( "# TYPE qgis_server_layer_renders_total counter" );
+  for ( QMap< QString, LayerMetrics >::const_iterator it = mLayers.constBegin(); it != mLayers.constEnd(); ++it )
+  {
+    lines << QStringLiteral( "qgis_server_layer_renders_total{layer=%1,name=%2} %3" ).arg( labelValue( it.key() ), labelValue( it.value().name ) ).arg( it.value().count );
+  }
+
+  lines << QStringLiteral( "# HELP qgis_server_layer_render_errors_total Number of renderings of the layers which failed." )
+        << QStringLiteral( "# TYPE qgis_server_layer_render_errors_total counter" );
+  for ( QMap< QString, LayerMetrics >::const_iterator it = mLayers.constBegin(); it != mLayers.constEnd(); ++it )
+  {
+    lines << QStringLiteral( "qgis_server_layer_render_errors_total{layer=%1,name=%2} %3" ).arg( labelValue( it.key() ), labelValue( it.value().name ) ).arg( it.value().errors );
+  }
+
+  return ( lines.join( '\n' ) + '\n' ).toUtf8();
+}
@@ -0,0 +1,133 @@
+/***************************************************************************
+                          qgsservermetrics.h
+                          ------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERMETRICS_H
+#define QGSSERVERMETRICS_H
+
+#include "qgis_server.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class QgsMapRendererJob;
+class QgsServiceRegistry;
+
+/** \ingroup server
+ * Timings of the requests handled by the server.
+ *
+ * The timings of a request are collected by the thread executing it, between
+ * startRequest() and endRequest(). The stages of the request (loading the project,
+ * resolving the layers, applying the access control filters, rendering, encoding...)
+ * are timed with a StageTimer, and the rendering time of each layer is reported
+ * with addLayerRenderings() once the rendering job is finished. All these calls are
+ * no-ops in a thread which has not started a request, i.e. when the metrics are
+ * disabled, or in the rendering threads of a job: the layers are reported by the
+ * thread executing the request, from the timings collected by the job.
+ *
+ * The timings of all the requests are accumulated and published in the Prometheus
+ * text exposition format by the METRICS service.
+ * \since QGIS 3.0
+ */
+class SERVER_EXPORT QgsServerMetrics
+{
+  public:
+
+    /** Times a stage of the current request for the lifetime of the object.
+     * Stages do not nest: a stage started within another one is part of the outer stage.
+     */
+    class StageTimer
+    {
+      public:
+        //! Starts timing the stage \a name
+        explicit StageTimer( const QString &name );
+        //! Ends the stage
+        ~StageTimer();
+
+      private:
+        StageTimer( const StageTimer & ) = delete;
+        StageTimer &operator=( const StageTimer & ) = delete;
+    };
+
+    //! Returns the metrics of the server
+    static QgsServerMetrics *instance();
+
+    //! Registers the METRICS service publishing the metrics in \a registry
+    static void registerService( QgsServiceRegistry &registry );
+
+    //! Starts collecting the timings of a request in the current thread
+    static void startRequest();
+
+    /** Ends the request of the current thread and accumulates its timings in the metrics of the server.
+     * \param service the name of the service executing the request
+     * \param request the name of the request
+     * \returns the timings of the request formatted as the value of a Server-Timing header,
+     * or an empty string if no request was started in the current thread
+     */
+    static QString endRequest( const QString &service, const QString &request );
+
+    /** Adds the rendering of a layer to the timings of the current request.
+     * \param layerId the ID of the layer
+     * \param layerName the name of the layer
+     * \param milliseconds the rendering time
+     * \param error true if the rendering of the layer failed
+     */
+    static void addLayerRendering( const QString &layerId, const QString &layerName, int milliseconds, bool error );
+
+    /** Adds the rendering of the layers of a finished job to the timings of the current request,
+     * with the failure of the layers which have rendering errors.
+     * \note must be called by the thread executing the request, not by the rendering threads
+     */
+    static void addLayerRenderings( const QgsMapRendererJob &job );
+
+    //! Returns the metrics in the Prometheus text exposition format
+    QByteArray prometheusText() const;
+
+  private:
+
+    //! Durations of a kind of request
+    struct RequestMetrics
+    {
+      //! Number of requests by upper bound of the histogram buckets
+      QVector< quint64 > buckets;
+      quint64 count = 0;
+      double seconds = 0;
+    };
+
+    //! Rendering of a layer
+    struct LayerMetrics
+    {
+      QString name;
+      quint64 count = 0;
+      quint64 errors = 0;
+      double seconds = 0;
+    };
+
+    QgsServerMetrics() = default;
+
+    mutable QMutex mMutex;
+    //! Requests by service and request name
+    QMap< QPair< QString, QString >, RequestMetrics > mRequests;
+    //! Seconds spent in the stages of the requests, by stage name
+    QMap< QString, double > mStages;
+    //! Rendering of the layers by layer ID
+    QMap< QString, LayerMetrics > mLayers;
+};
+
+#endif // QGSSERVERMETRICS_H
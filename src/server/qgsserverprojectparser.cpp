@@ -26,6 +26,7 @@
 #include "qgspathresolver.h"
 #include "qgsrasterlayer.h"
 #include "qgsreadwritecontext.h"
+#include "qgsserverrequestproject.h"
 #include "qgsvectorlayerjoinbuffer.h"
 #include "qgseditorwidgetregistry.h"
 #include "qgslayertreegroup.h"
@@ -60,6 +61,19 @@ QgsServerProjectParser::QgsServerProjectParser( QDomDocument *xmlDoc, const QStr
         lName = layerName( currentElement );
       mProjectLayerElementsByName.insert( lName, currentElement );
       mProjectLayerElementsById.insert( layerId( currentElement ), currentElement );
+
+      //convert relative paths to absolute ones once, the document is then only read by the requests
+      QDomElement dataSourceElem = currentElement.firstChildElement( QStringLiteral( "datasource" ) );
+      if ( !dataSourceElem.isNull() )
+      {
+        QString uri = dataSourceElem.text();
+        QString absoluteUri = convertDataSourceToAbsolutePath( uri );
+        if ( uri != absoluteUri )
+        {
+          QDomText absoluteTextNode = mXMLDoc->createTextNode( absoluteUri );
+          dataSourceElem.replaceChild( absoluteTextNode, dataSourceElem.firstChild() );
+        }
+      }
     }
 
     mLegendGroupElements = findLegendGroupElements();
@@ -79,11 +93,11 @@ QgsServerProjectParser::QgsServerProjectParser( QDomDocument *xmlDoc, const QStr
       }
     }
   }
-  // Setting the QgsProject instance fileName
+  // Setting the fileName of the project of the request
   // to help converting relative paths to absolute
   if ( !mProjectPath.isEmpty() )
   {
-    QgsProject::instance()->setFileName( mProjectPath );
+    QgsServerRequestProject::current()->setFileName( mProjectPath );
   }
 }
 
@@ -160,6 +174,42 @@ QString QgsServerProjectParser::convertToAbsolutePath( const QString &file ) con
   return projElems.join( QStringLiteral( "/" ) );
 }
 
+QString QgsServerProjectParser::convertDataSourceToAbsolutePath( const QString &uri ) const
+{
+  if ( uri.startsWith( QLatin1String( "dbname" ) ) ) //database
+  {
+    QgsDataSourceUri dsUri( uri );
+    if ( dsUri.host().isEmpty() ) //only convert path for file based databases
+    {
+      QString dbnameUri = dsUri.database();
+      QString dbNameUriAbsolute = convertToAbsolutePath( dbnameUri );
+      if ( dbnameUri != dbNameUriAbsolute )
+      {
+        dsUri.setDatabase( dbNameUriAbsolute );
+        return dsUri.uri();
+      }
+    }
+    return uri;
+  }
+  else if ( uri.startsWith( QLatin1String( "file:" ) ) ) //a file based datasource in url notation (e.g. delimited text layer)
+  {
+    QString filePath = uri.mid( 5, uri.indexOf( QLatin1String( "?" ) ) - 5 );
+    QString absoluteFilePath = convertToAbsolutePath( filePath );
+    if ( filePath != absoluteFilePath )
+    {
+      QUrl destUrl = QUrl::fromEncoded( uri.toLatin1() );
+      destUrl.setScheme( QStringLiteral( "file" ) );
+      destUrl.setPath( absoluteFilePath );
+      return destUrl.toEncoded();
+    }
+    return uri;
+  }
+  else //file based data source
+  {
+    return convertToAbsolutePath( uri );
+  }
+}
+
 QgsMapLayer *QgsServerProjectParser::createLayerFromElement( const QDomElement &elem, bool useCache ) const
 {
   if ( elem.isNull() || !mXMLDoc )
@@ -170,58 +220,8 @@ QgsMapLayer *QgsServerProjectParser::createLayerFromElement( const QDomElement &
   addJoinLayersForElement( elem );
   addGetFeatureLayers( elem );
 
-  QDomElement dataSourceElem = elem.firstChildElement( QStringLiteral( "datasource" ) );
-  QString uri = dataSourceElem.text();
-  QString absoluteUri;
-  // If QgsProject instance fileName is set,
-  // Is converting relative paths to absolute still relevant ?
-  if ( !dataSourceElem.isNull() )
-  {
-    //convert relative paths to absolute ones if necessary
-    if ( uri.startsWith( QLatin1String( "dbname" ) ) ) //database
-    {
-      QgsDataSourceUri dsUri( uri );
-      if ( dsUri.host().isEmpty() ) //only convert path for file based databases
-      {
-        QString dbnameUri = dsUri.database();
-        QString dbNameUriAbsolute = convertToAbsolutePath( dbnameUri );
-        if ( dbnameUri != dbNameUriAbsolute )
-        {
-          dsUri.setDatabase( dbNameUriAbsolute );
-          absoluteUri = dsUri.uri();
-          QDomText absoluteTextNode = mXMLDoc->createTextNode( absoluteUri );
-          dataSourceElem.replaceChild( absoluteTextNode, dataSourceElem.firstChild() );
-        }
-      }
-    }
-    else if ( uri.startsWith( QLatin1String( "file:" ) ) ) //a file based datasource in url notation (e.g. delimited text layer)
-    {
-      QString filePath = uri.mid( 5, uri.indexOf( QLatin1String( "?" ) ) - 5 );
-      QString absoluteFilePath = convertToAbsolutePath( filePath );
-      if ( filePath != absoluteFilePath )
-      {
-        QUrl destUrl = QUrl::fromEncoded( uri.toLatin1() );
-        destUrl.setScheme( QStringLiteral( "file" ) );
-        destUrl.setPath( absoluteFilePath );
-        absoluteUri = destUrl.toEncoded();
-        QDomText absoluteTextNode = mXMLDoc->createTextNode( absoluteUri );
-        dataSourceElem.replaceChild( absoluteTextNode, dataSourceElem.firstChild() );
-      }
-      else
-      {
-        absoluteUri = uri;
-      }
-    }
-    else //file based data source
-    {
-      absoluteUri = convertToAbsolutePath( uri );
-      if ( uri != absoluteUri )
-      {
-        QDomText absoluteTextNode = mXMLDoc->createTextNode( absoluteUri );
-        dataSourceElem.replaceChild( absoluteTextNode, dataSourceElem.firstChild() );
-      }
-    }
-  }
+  //relative paths have been converted to absolute ones by the constructor
+  QString absoluteUri = elem.firstChildElement( QStringLiteral( "datasource" ) ).text();
 
   QString id = layerId( elem );
   QgsMapLayer *layer = nullptr;
@@ -232,15 +232,15 @@ QgsMapLayer *QgsServerProjectParser::createLayerFromElement( const QDomElement &
 
   if ( layer )
   {
-    if ( !QgsProject::instance()->mapLayer( id ) )
-      QgsProject::instance()->addMapLayer( layer, false, false );
+    if ( !QgsServerRequestProject::current()->mapLayer( id ) )
+      QgsServerRequestProject::current()->addMapLayer( layer, false, false );
     if ( layer->type() == QgsMapLayer::VectorLayer )
     {
       QgsVectorLayer *vlayer = qobject_cast<QgsVectorLayer *>( layer );
       addValueRelationLayersForLayer( vlayer );
       QgsVectorLayerJoinBuffer *joinBuffer = vlayer->joinBuffer();
       joinBuffer->readXml( const_cast<QDomElement &>( elem ) );
-      joinBuffer->resolveReferences( QgsProject::instance() );
+      joinBuffer->resolveReferences( QgsServerRequestProject::current() );
     }
 
     return layer;
@@ -277,7 +277,7 @@ QgsMapLayer *QgsServerProjectParser::createLayerFromElement( const QDomElement &
     }
 
     QgsReadWriteContext context;
-    context.setPathResolver( QgsProject::instance()->pathResolver() );
+    context.setPathResolver( QgsPathResolver( mProjectPath ) );
 
     layer->readLayerXml( const_cast<QDomElement &>( elem ), context ); //should be changed to const in QgsMapLayer
     //layer->setLayerName( layerName( elem ) );
@@ -287,8 +287,8 @@ QgsMapLayer *QgsServerProjectParser::createLayerFromElement( const QDomElement &
       return nullptr;
     }
     // Insert layer in registry and cache before addValueRelationLayersForLayer
-    if ( !QgsProject::instance()->mapLayer( id ) )
-      QgsProject::instance()->addMapLayer( layer, false, false );
+    if ( !QgsServerRequestProject::current()->mapLayer( id ) )
+      QgsServerRequestProject::current()->addMapLayer( layer, false, false );
     if ( useCache )
     {
       QgsMSLayerCache::instance()->insertLayer( absoluteUri, id, layer, mProjectPath );
@@ -1528,9 +1528,9 @@ void QgsServerProjectParser::addJoinLayersForElement( const QDomElement &layerEl
   {
     QString id = joinNodeList.at( i ).toElement().attribute( QStringLiteral( "joinLayerId" ) );
     QgsMapLayer *layer = mapLayerFromLayerId( id );
-    if ( layer && !QgsProject::instance()->mapLayer( id ) )
+    if ( layer && !QgsServerRequestProject::current()->mapLayer( id ) )
     {
-      QgsProject::instance()->addMapLayer( layer, false, false );
+      QgsServerRequestProject::current()->addMapLayer( layer, false, false );
     }
   }
 }
@@ -1551,14 +1551,14 @@ void QgsServerProjectParser::addValueRelationLayersForLayer( const QgsVectorLaye
       continue;
 
     QString layerId = cfg.value( QStringLiteral( "Layer" ) ).toString();
-    if ( QgsProject::instance()->mapLayer( layerId ) )
+    if ( QgsServerRequestProject::current()->mapLayer( layerId ) )
       continue;
 
     QgsMapLayer *layer = mapLayerFromLayerId( layerId );
     if ( !layer )
       continue;
 
-    QgsProject::instance()->addMapLayer( layer, false, false );
+    QgsServerRequestProject::current()->addMapLayer( layer, false, false );
   }
 }
 
@@ -1590,7 +1590,7 @@ void QgsServerProjectParser::addGetFeatureLayers( const QDomElement &layerElem )
 
     if ( ml )
     {
-      QgsProject::instance()->addMapLayer( ml, false, false );
+      QgsServerRequestProject::current()->addMapLayer( ml, false, false );
     }
     idx += rx.matchedLength();
   }
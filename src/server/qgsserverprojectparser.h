@@ -50,6 +50,11 @@ class SERVER_EXPORT QgsServerProjectParser
     //! Converts a (possibly relative) path to absolute
     QString convertToAbsolutePath( const QString &file ) const;
 
+    /** Converts the (possibly relative) paths of a layer datasource to absolute
+     * \since QGIS 3.0
+     */
+    QString convertDataSourceToAbsolutePath( const QString &uri ) const;
+
     /** Creates a maplayer object from <maplayer> element. The layer cash owns the maplayer, so don't delete it
     \returns the maplayer or 0 in case of error*/
     QgsMapLayer *createLayerFromElement( const QDomElement &elem, bool useCache = true ) const;
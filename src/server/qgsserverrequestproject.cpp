@@ -0,0 +1,44 @@
+/***************************************************************************
+                          qgsserverrequestproject.cpp
+                          ---------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsserverrequestproject.h"
+#include "qgsproject.h"
+
+namespace
+{
+  //! Project of the request executed by the current thread
+  thread_local QgsProject *sCurrentProject = nullptr;
+}
+
+QgsServerRequestProject::QgsServerRequestProject( const QString &filePath )
+  : mProject( new QgsProject() )
+  , mPreviousProject( sCurrentProject )
+{
+  // the file name is needed to resolve the relative paths of the layers
+  mProject->setFileName( filePath );
+  sCurrentProject = mProject.get();
+}
+
+QgsServerRequestProject::~QgsServerRequestProject()
+{
+  // the layers of the layer cache are not owned by the project, they are only removed from it
+  sCurrentProject = mPreviousProject;
+}
+
+QgsProject *QgsServerRequestProject::current()
+{
+  return sCurrentProject ? sCurrentProject : QgsProject::instance();
+}
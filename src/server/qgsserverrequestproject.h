@@ -0,0 +1,60 @@
+/***************************************************************************
+                          qgsserverrequestproject.h
+                          -------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERREQUESTPROJECT_H
+#define QGSSERVERREQUESTPROJECT_H
+
+#include "qgis_server.h"
+
+#include <QString>
+
+#include <memory>
+
+class QgsProject;
+
+/** \ingroup server
+ * Project registering the map layers of a request executed concurrently with other requests.
+ *
+ * The configuration parsers and the WMS renderer register the layers they read in the
+ * current() project of the thread. For the exclusive requests, it is the QgsProject::instance().
+ * A concurrent request creates its own project for its lifetime instead, so that the
+ * layers of the other requests are neither visible nor removed.
+ * \since QGIS 3.0
+ */
+class SERVER_EXPORT QgsServerRequestProject
+{
+  public:
+
+    /** Creates the project of a request reading the configuration file \a filePath,
+     * and makes it the current project of the thread until it is destroyed.
+     */
+    explicit QgsServerRequestProject( const QString &filePath );
+
+    //! Restores the previous current project of the thread
+    ~QgsServerRequestProject();
+
+    //! Returns the project of the request executed by the current thread, or the QgsProject::instance() if there is none
+    static QgsProject *current();
+
+  private:
+    QgsServerRequestProject( const QgsServerRequestProject & ) = delete;
+    QgsServerRequestProject &operator=( const QgsServerRequestProject & ) = delete;
+
+    std::unique_ptr< QgsProject > mProject;
+    QgsProject *mPreviousProject = nullptr;
+};
+
+#endif // QGSSERVERREQUESTPROJECT_H
@@ -130,6 +130,138 @@ void QgsServerSettings::initSettings()
                                QVariant()
                              };
   mSettings[ sCacheSize.envVar ] = sCacheSize;
+
+  // parallel requests
+  const Setting sParRequests = { QgsServerSettingsEnv::QGIS_SERVER_PARALLEL_REQUESTS,
+                                 QgsServerSettingsEnv::DEFAULT_VALUE,
+                                 "Number of worker threads accepting FastCGI requests",
+                                 "/qgis/parallel_requests",
+                                 QVariant::Int,
+                                 QVariant( 1 ),
+                                 QVariant()
+                               };
+  mSettings[ sParRequests.envVar ] = sParRequests;
+
+  // tile cache size
+  const Setting sTileCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_SIZE,
+                                   QgsServerSettingsEnv::DEFAULT_VALUE,
+                                   "Specify the memory size of the WMS tile cache, 0 to disable it",
+                                   "/tilecache/size",
+                                   QVariant::LongLong,
+                                   QVariant( 0 ),
+                                   QVariant()
+                                 };
+  mSettings[ sTileCacheSize.envVar ] = sTileCacheSize;
+
+  // tile cache directory
+  const Setting sTileCacheDir = { QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_DIRECTORY,
+                                  QgsServerSettingsEnv::DEFAULT_VALUE,
+                                  "Specify the directory of the WMS tile cache, empty to cache tiles in memory only",
+                                  "/tilecache/directory",
+                                  QVariant::String,
+                                  QVariant( "" ),
+                                  QVariant()
+                                };
+  mSettings[ sTileCacheDir.envVar ] = sTileCacheDir;
+
+  // metatile size
+  const Setting sMetatileSize = { QgsServerSettingsEnv::QGIS_SERVER_METATILE_SIZE,
+                                  QgsServerSettingsEnv::DEFAULT_VALUE,
+                                  "Number of tiles rendered at once in each direction by the WMS tile cache",
+                                  "/tilecache/metatile_size",
+                                  QVariant::Int,
+                                  QVariant( 4 ),
+                                  QVariant()
+                                };
+  mSettings[ sMetatileSize.envVar ] = sMetatileSize;
+
+  // png8 palette cache
+  const Setting sPng8PaletteCache = { QgsServerSettingsEnv::QGIS_SERVER_PNG8_PALETTE_CACHE,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      "Share the palette of 8 bit PNG images between the GetMap requests of a layer set",
+                                      "/qgis/png8_palette_cache",
+                                      QVariant::Bool,
+                                      QVariant( false ),
+                                      QVariant()
+                                    };
+  mSettings[ sPng8PaletteCache.envVar ] = sPng8PaletteCache;
+
+  // feature info index
+  const Setting sFeatureInfoIndex = { QgsServerSettingsEnv::QGIS_SERVER_FEATURE_INFO_INDEX_MAX_FEATURES,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      "Maximum number of features of a layer indexed for GetFeatureInfo requests",
+                                      "/qgis/feature_info_index_max_features",
+                                      QVariant::Int,
+                                      QVariant( 0 ),
+                                      QVariant()
+                                    };
+  mSettings[ sFeatureInfoIndex.envVar ] = sFeatureInfoIndex;
+
+  // project snapshot
+  const Setting sProjectSnapshot = { QgsServerSettingsEnv::QGIS_SERVER_PROJECT_SNAPSHOT,
+                                     QgsServerSettingsEnv::DEFAULT_VALUE,
+                                     "Read projects from a binary snapshot written next to the project file",
+                                     "/qgis/project_snapshot",
+                                     QVariant::Bool,
+                                     QVariant( false ),
+                                     QVariant()
+                                   };
+  mSettings[ sProjectSnapshot.envVar ] = sProjectSnapshot;
+
+  // metrics
+  const Setting sMetrics = { QgsServerSettingsEnv::QGIS_SERVER_METRICS,
+                             QgsServerSettingsEnv::DEFAULT_VALUE,
+                             "Collect the timings of the requests and publish them with the METRICS service",
+                             "/qgis/server_metrics",
+                             QVariant::Bool,
+                             QVariant( false ),
+                             QVariant()
+                           };
+  mSettings[ sMetrics.envVar ] = sMetrics;
+
+  // capabilities cache directory
+  const Setting sCapabilitiesCacheDir = { QgsServerSettingsEnv::QGIS_SERVER_CAPABILITIES_CACHE_DIRECTORY,
+                                          QgsServerSettingsEnv::DEFAULT_VALUE,
+                                          "Specify the directory where the capabilities responses are persisted, empty to cache them in memory only",
+                                          "/qgis/capabilities_cache_directory",
+                                          QVariant::String,
+                                          QVariant( "" ),
+                                          QVariant()
+                                        };
+  mSettings[ sCapabilitiesCacheDir.envVar ] = sCapabilitiesCacheDir;
+
+  // capabilities conditional requests
+  const Setting sCapabilitiesConditional = { QgsServerSettingsEnv::QGIS_SERVER_CAPABILITIES_CONDITIONAL_REQUESTS,
+                                             QgsServerSettingsEnv::DEFAULT_VALUE,
+                                             "Send ETag and Last-Modified headers with the capabilities and answer conditional requests",
+                                             "/qgis/capabilities_conditional_requests",
+                                             QVariant::Bool,
+                                             QVariant( false ),
+                                             QVariant()
+                                           };
+  mSettings[ sCapabilitiesConditional.envVar ] = sCapabilitiesConditional;
+
+  // response compression
+  const Setting sResponseCompression = { QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_COMPRESSION,
+                                         QgsServerSettingsEnv::DEFAULT_VALUE,
+                                         "Compress the text responses with the gzip or deflate coding accepted by the client",
+                                         "/qgis/response_compression",
+                                         QVariant::Bool,
+                                         QVariant( false ),
+                                         QVariant()
+                                       };
+  mSettings[ sResponseCompression.envVar ] = sResponseCompression;
+
+  // response flush threshold
+  const Setting sResponseFlushThreshold = { QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD,
+                                            QgsServerSettingsEnv::DEFAULT_VALUE,
+                                            "Size in bytes from which the body of a response is streamed to the client (0 to buffer the whole body)",
+                                            "/qgis/response_flush_threshold",
+                                            QVariant::LongLong,
+                                            QVariant( 0 ),
+                                            QVariant()
+                                          };
+  mSettings[ sResponseFlushThreshold.envVar ] = sResponseFlushThreshold;
 }
 
 void QgsServerSettings::load()
@@ -305,3 +437,63 @@ QString QgsServerSettings::cacheDirectory() const
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_CACHE_DIRECTORY ).toString();
 }
+
+int QgsServerSettings::parallelRequests() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_PARALLEL_REQUESTS ).toInt();
+}
+
+qint64 QgsServerSettings::tileCacheSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_SIZE ).toLongLong();
+}
+
+QString QgsServerSettings::tileCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_DIRECTORY ).toString();
+}
+
+int QgsServerSettings::metatileSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_METATILE_SIZE ).toInt();
+}
+
+bool QgsServerSettings::png8PaletteCache() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_PNG8_PALETTE_CACHE ).toBool();
+}
+
+int QgsServerSettings::featureInfoIndexMaxFeatures() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_FEATURE_INFO_INDEX_MAX_FEATURES ).toInt();
+}
+
+bool QgsServerSettings::projectSnapshot() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_PROJECT_SNAPSHOT ).toBool();
+}
+
+bool QgsServerSettings::metrics() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_METRICS ).toBool();
+}
+
+QString QgsServerSettings::capabilitiesCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_CAPABILITIES_CACHE_DIRECTORY ).toString();
+}
+
+bool QgsServerSettings::capabilitiesConditionalRequests() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_CAPABILITIES_CONDITIONAL_REQUESTS ).toBool();
+}
+
+bool QgsServerSettings::responseCompression() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_COMPRESSION ).toBool();
+}
+
+qint64 QgsServerSettings::responseFlushThreshold() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD ).toLongLong();
+}
@@ -54,7 +54,19 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_PROJECT_FILE,
       MAX_CACHE_LAYERS,
       QGIS_SERVER_CACHE_DIRECTORY,
-      QGIS_SERVER_CACHE_SIZE
+      QGIS_SERVER_CACHE_SIZE,
+      QGIS_SERVER_PARALLEL_REQUESTS,
+      QGIS_SERVER_TILE_CACHE_SIZE,
+      QGIS_SERVER_TILE_CACHE_DIRECTORY,
+      QGIS_SERVER_METATILE_SIZE,
+      QGIS_SERVER_PNG8_PALETTE_CACHE,
+      QGIS_SERVER_FEATURE_INFO_INDEX_MAX_FEATURES,
+      QGIS_SERVER_PROJECT_SNAPSHOT,
+      QGIS_SERVER_METRICS,
+      QGIS_SERVER_CAPABILITIES_CACHE_DIRECTORY,
+      QGIS_SERVER_CAPABILITIES_CONDITIONAL_REQUESTS,
+      QGIS_SERVER_RESPONSE_COMPRESSION,
+      QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD
     };
     Q_ENUM( EnvVar )
 };
@@ -141,6 +153,71 @@ class SERVER_EXPORT QgsServerSettings
       */
     QString cacheDirectory() const;
 
+    /** Returns the number of worker threads accepting FastCGI requests.
+      * Only the WFS and WCS requests (except WFS Transaction) and the WMS GetMap and
+      * GetFeatureInfo requests are executed concurrently by the worker threads, the other
+      * requests and the requests of servers with plugins are still executed one at a time.
+      * \returns the number of threads, 1 if requests are handled sequentially.
+      */
+    int parallelRequests() const;
+
+    /** Returns the memory size of the WMS tile cache.
+      * \returns the size in bytes, 0 if the tile cache is disabled.
+      */
+    qint64 tileCacheSize() const;
+
+    /** Returns the directory where the WMS tile cache stores tiles on disk.
+      * \returns the directory or an empty string if tiles are only cached in memory.
+      */
+    QString tileCacheDirectory() const;
+
+    /** Returns the number of tiles rendered at once in each direction by the WMS tile cache.
+      * \returns the metatile size.
+      */
+    int metatileSize() const;
+
+    /** Returns true if the palette of 8 bit PNG images is shared by the GetMap requests of a layer set.
+      * \returns true if the palettes are cached, false if each image has its own palette.
+      */
+    bool png8PaletteCache() const;
+
+    /** Returns the maximum number of features of a layer indexed for GetFeatureInfo requests.
+      * The index of a layer is built by the first GetFeatureInfo request on the layer.
+      * \returns the number of features, 0 (the default) if the index is disabled.
+      */
+    int featureInfoIndexMaxFeatures() const;
+
+    /** Returns true if projects are read from a binary snapshot written next to the project file.
+      * \returns true if project snapshots are used, false otherwise.
+      */
+    bool projectSnapshot() const;
+
+    /** Returns true if the timings of the requests are collected.
+      * \returns true if the Server-Timing header and the METRICS service are enabled, false otherwise.
+      */
+    bool metrics() const;
+
+    /** Returns the directory where the capabilities responses are persisted.
+      * \returns the directory or an empty string if the capabilities are only cached in memory.
+      */
+    QString capabilitiesCacheDirectory() const;
+
+    /** Returns true if the capabilities responses have ETag and Last-Modified headers and
+      * conditional requests are answered with a 304 Not Modified status.
+      * \returns true if conditional requests are supported, false otherwise.
+      */
+    bool capabilitiesConditionalRequests() const;
+
+    /** Returns true if the text responses are compressed with the gzip or deflate coding accepted by the client.
+      * \returns true if the responses are compressed, false otherwise.
+      */
+    bool responseCompression() const;
+
+    /** Returns the size from which the body of a response is streamed to the client instead of being buffered.
+      * \returns the size in bytes, 0 if the responses are fully buffered.
+      */
+    qint64 responseFlushThreshold() const;
+
   private:
     void initSettings();
     QVariant value( QgsServerSettingsEnv::EnvVar envVar ) const;
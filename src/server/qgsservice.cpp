@@ -26,3 +26,8 @@ QgsService::QgsService()
 
 }
 
+bool QgsService::allowConcurrentRequest( const QgsServerRequest &request ) const
+{
+  Q_UNUSED( request );
+  return false;
+}
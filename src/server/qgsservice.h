@@ -68,6 +68,18 @@ class SERVER_EXPORT QgsService
     virtual void executeRequest( const QgsServerRequest &request,
                                  QgsServerResponse &response,
                                  const QgsProject *project ) = 0;
+
+    /**
+     * Returns true if executeRequest() may be called for \a request from a worker thread
+     * while other requests are executed concurrently.
+     *
+     * This is only safe for requests which read the project without modifying it, and
+     * which register the layers they read in the QgsServerRequestProject::current() project
+     * instead of the QgsProject::instance() singleton. Requests for which false is returned,
+     * which is the default, are executed exclusively in the main thread.
+     * \since QGIS 3.0
+     */
+    virtual bool allowConcurrentRequest( const QgsServerRequest &request ) const;
 };
 
 #endif
@@ -109,7 +109,7 @@ QgsService *QgsServiceRegistry::getService( const QString &name, const QString &
     {
       // Return the dofault version
       QgsMessageLog::logMessage( QString( "Service %1 %2 not found, returning default" ).arg( name, version ) );
-      service = mServices[v->second].get();
+      service = mServices.value( v->second ).get();
     }
   }
   else
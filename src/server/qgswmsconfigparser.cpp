@@ -22,6 +22,7 @@
 #include "qgspallabeling.h"
 #include "qgsproject.h"
 #include "qgsmapserviceexception.h"
+#include "qgsserverrequestproject.h"
 
 #include "qgscomposerlabel.h"
 #include "qgscomposerlegend.h"
@@ -198,7 +199,7 @@ QgsComposition *QgsWmsConfigParser::createPrintComposition( const QString &compo
     QList<QgsMapLayer *> layers;
     Q_FOREACH ( const QString &layerId, layerSet )
     {
-      if ( QgsMapLayer *layer = QgsProject::instance()->mapLayer( layerId ) )
+      if ( QgsMapLayer *layer = QgsServerRequestProject::current()->mapLayer( layerId ) )
         layers << layer;
     }
 
@@ -355,7 +356,7 @@ QStringList QgsWmsConfigParser::addHighlightLayers( const QMap<QString, QString>
     layer->setRenderer( renderer.release() );
     layerSet.prepend( layer->id() );
     highlightLayers.append( layer->id() );
-    QgsProject::instance()->addMapLayers( QList<QgsMapLayer *>() << layer.release() );
+    QgsServerRequestProject::current()->addMapLayers( QList<QgsMapLayer *>() << layer.release() );
   }
   return highlightLayers;
 }
@@ -554,7 +555,7 @@ void QgsWmsConfigParser::removeHighlightLayers( const QStringList &layerIds )
   QStringList::const_iterator idIt = layerIds.constBegin();
   for ( ; idIt != layerIds.constEnd(); ++idIt )
   {
-    QgsProject::instance()->removeMapLayers( QStringList() << *idIt );
+    QgsServerRequestProject::current()->removeMapLayers( QStringList() << *idIt );
   }
 }
 
@@ -42,8 +42,10 @@
 #include "qgslayertreelayer.h"
 #include "qgslayertree.h"
 #include "qgsaccesscontrol.h"
+#include "qgsserverrequestproject.h"
 
 #include <QFileInfo>
+#include <QMutexLocker>
 #include <QTextDocument>
 
 // style name to use for the unnamed style of layers (must not be empty name in WMS)
@@ -442,7 +444,7 @@ QgsComposition *QgsWmsProjectParser::initComposition( const QString &composerTem
     return nullptr;
   }
 
-  QgsComposition *composition = new QgsComposition( QgsProject::instance() ); //set resolution, paper size from composer element attributes
+  QgsComposition *composition = new QgsComposition( QgsServerRequestProject::current() ); //set resolution, paper size from composer element attributes
   if ( !composition->readXml( compositionElem, *( mProjectParser->xmlDocument() ) ) )
   {
     delete composition;
@@ -499,7 +501,7 @@ QgsComposition *QgsWmsProjectParser::initComposition( const QString &composerTem
         // load it if the layer id is not QgsProject
         Q_FOREACH ( const QString &layerId, layerIds )
         {
-          QgsMapLayer *layer = QgsProject::instance()->mapLayer( layerId );
+          QgsMapLayer *layer = QgsServerRequestProject::current()->mapLayer( layerId );
           if ( layer )
           {
             continue;
@@ -520,7 +522,7 @@ QgsComposition *QgsWmsProjectParser::initComposition( const QString &composerTem
               layer = mProjectParser->createLayerFromElement( layerElemIt.value(), true );
             }
           }
-          QgsProject::instance()->addMapLayer( layer );
+          QgsServerRequestProject::current()->addMapLayer( layer );
         }
         legend->updateLegend();
       }
@@ -2106,6 +2108,8 @@ void QgsWmsProjectParser::drawOverlays( QPainter *p, int dpi, int width, int hei
   //consider DPI
   double scaleFactor = dpi / 88.0; //assume 88 as standard dpi
 
+  QMutexLocker locker( &mAnnotationMutex );
+
   //text annotations
   QList< QPair< QTextDocument *, QDomElement > >::const_iterator textIt = mTextAnnotationItems.constBegin();
   for ( ; textIt != mTextAnnotationItems.constEnd(); ++textIt )
@@ -2185,17 +2189,17 @@ void QgsWmsProjectParser::loadLabelSettings() const
 
   readLabelSettings( searchMethod, nCandPoint, nCandLine, nCandPoly, showingCandidates, drawRectOnly, showingShadowRects, showingAllLabels, showingPartialsLabels, drawOutlineLabels );
 
-  QgsProject::instance()->writeEntry( "PAL", "/SearchMethod", searchMethod );
-  QgsProject::instance()->writeEntry( "PAL", "/CandidatesPoint", nCandPoint );
-  QgsProject::instance()->writeEntry( "PAL", "/CandidatesLine", nCandLine );
-  QgsProject::instance()->writeEntry( "PAL", "/CandidatesPolygon", nCandPoly );
-
-  QgsProject::instance()->writeEntry( "PAL", "/ShowingCandidates", showingCandidates );
-  QgsProject::instance()->writeEntry( "PAL", "/DrawRectOnly", drawRectOnly );
-  QgsProject::instance()->writeEntry( "PAL", "/ShowingShadowRects", showingShadowRects );
-  QgsProject::instance()->writeEntry( "PAL", "/ShowingAllLabels", showingAllLabels );
-  QgsProject::instance()->writeEntry( "PAL", "/ShowingPartialsLabels", showingPartialsLabels );
-  QgsProject::instance()->writeEntry( "PAL", "/DrawOutlineLabels", drawOutlineLabels );
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/SearchMethod", searchMethod );
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/CandidatesPoint", nCandPoint );
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/CandidatesLine", nCandLine );
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/CandidatesPolygon", nCandPoly );
+
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/ShowingCandidates", showingCandidates );
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/DrawRectOnly", drawRectOnly );
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/ShowingShadowRects", showingShadowRects );
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/ShowingAllLabels", showingAllLabels );
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/ShowingPartialsLabels", showingPartialsLabels );
+  QgsServerRequestProject::current()->writeEntry( "PAL", "/DrawOutlineLabels", drawOutlineLabels );
 }
 
 void QgsWmsProjectParser::readLabelSettings( int &searchMethod, int &nCandPoint, int &nCandLine, int &nCandPoly, bool &showingCandidates, bool &drawRectOnly, bool &showingShadowRects, bool &showingAllLabels, bool &showingPartialsLabels, bool &drawOutlineLabels ) const
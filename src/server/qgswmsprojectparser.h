@@ -22,6 +22,8 @@
 #include "qgsserverprojectparser.h"
 #include "qgis_server.h"
 
+#include <QMutex>
+
 class QgsAccessControl;
 
 class QTextDocument;
@@ -134,6 +136,8 @@ class SERVER_EXPORT QgsWmsProjectParser : public QgsWmsConfigParser
     QList< QPair< QTextDocument *, QDomElement > > mTextAnnotationItems;
     //! Watermark items (content cached in QgsSVGCache)
     QList< QPair< QSvgRenderer *, QDomElement > > mSvgAnnotationElems;
+    //! Protects the annotation items, which are drawn by concurrent GetMap requests
+    mutable QMutex mAnnotationMutex;
 
     //! Returns an ID-list of layers which are not queryable (comes from <properties> -> <Identify> -> <disabledLayers in the project file
     virtual QStringList identifyDisabledLayers() const override;
@@ -45,6 +45,13 @@ namespace QgsWcs
         return method == QgsServerRequest::GetMethod || method == QgsServerRequest::PostMethod;
       }
 
+      bool allowConcurrentRequest( const QgsServerRequest &request ) const
+      {
+        // Coverages are read from a clone of the layer data provider
+        Q_UNUSED( request );
+        return true;
+      }
+
       void executeRequest( const QgsServerRequest &request, QgsServerResponse &response,
                            const QgsProject *project )
       {
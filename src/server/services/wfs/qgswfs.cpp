@@ -49,6 +49,13 @@ namespace QgsWfs
         return method == QgsServerRequest::GetMethod || method == QgsServerRequest::PostMethod;
       }
 
+      bool allowConcurrentRequest( const QgsServerRequest &request ) const
+      {
+        // Transactions edit the layers which are read by the other requests
+        QString req = request.parameters().value( QStringLiteral( "REQUEST" ) );
+        return !QSTR_COMPARE( req, "Transaction" );
+      }
+
       void executeRequest( const QgsServerRequest &request, QgsServerResponse &response,
                            const QgsProject *project )
       {
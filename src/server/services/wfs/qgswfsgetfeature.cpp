@@ -24,6 +24,11 @@
 #include "qgsfields.h"
 #include "qgsexpression.h"
 #include "qgsgeometry.h"
+#include "qgsgeometrycollection.h"
+#include "qgslinestring.h"
+#include "qgspointv2.h"
+#include "qgspolygon.h"
+#include "qgswkbtypes.h"
 #include "qgsmaplayer.h"
 #include "qgsfeatureiterator.h"
 #include "qgscoordinatereferencesystem.h"
@@ -38,31 +43,79 @@
 
 #include <QStringList>
 
+#include <memory>
+
 namespace QgsWfs
 {
 
   namespace
   {
 
-    QString createFeatureGeoJSON( QgsFeature *feat, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes,
-                                  const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom,
-                                  const QString &geometryName );
-
-    QDomElement createFeatureGML2( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs,
-                                   const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
-                                   bool withGeom, const QString &geometryName );
-
-    QDomElement createFeatureGML3( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs,
-                                   const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
-                                   bool withGeom, const QString geometryName );
+    /**
+     * Serializes the features of a GetFeature response into a reusable buffer, which is
+     * written to the response in chunks. GML features are written element by element with
+     * the formatting of QDomDocument::toByteArray(), without building a document for each feature.
+     */
+    class FeatureWriter
+    {
+      public:
+        FeatureWriter( QgsServerResponse &response, const QString &format );
+
+        //! Prepares the serialization of the features of a layer
+        void setLayer( const QString &typeName, const QgsFields &fields, const QgsAttributeList &attrIndexes,
+                       const QSet<QString> &excludedAttributes, int prec, const QgsCoordinateReferenceSystem &crs,
+                       bool withGeom, const QString &geometryName );
+
+        //! Writes a feature, \a featIdx is the index of the feature in the response
+        void writeFeature( const QgsFeature &feat, int featIdx );
+
+        //! Writes the buffered features to the response
+        void flush();
+
+      private:
+        void writeFeatureGeoJSON( const QgsFeature &feat, int featIdx );
+        void writeFeatureGML( const QgsFeature &feat );
+        void writeBoundingBox( const QgsRectangle &box );
+        void writeGeometry( const QgsAbstractGeometry *geom, const QString &srsName );
+        void writePositions( const QgsLineString *line );
+
+        // XML events, formatted like QDomDocument::toByteArray()
+        void startElement( const QByteArray &name );
+        void attribute( const QByteArray &name, const QString &value );
+        void text( const QString &value );
+        void number( double value );
+        void character( char c );
+        void endElement();
+        void element( const QDomElement &elem );
+        void closeStartTag();
+        void appendEscaped( const QString &value, bool attributeValue );
+
+        QgsServerResponse &mResponse;
+        bool mGeoJSON = false;
+        bool mGML3 = false;
+
+        QByteArray mBuffer;
+        QVector< QByteArray > mElements;
+        bool mStartTagOpen = false;
+        bool mTextContent = false;
+
+        // current layer
+        QString mTypeName;
+        QByteArray mTypeNameElement;
+        QVector< QPair< int, QByteArray > > mAttributes;
+        int mPrecision = 8;
+        QgsCoordinateReferenceSystem mCrs;
+        bool mWithGeom = true;
+        QString mGeometryName;
+        std::unique_ptr< QgsJSONExporter > mJsonExporter;
+
+        //! Document of the geometries which are not serialized element by element
+        QDomDocument mDoc;
+    };
 
     void startGetFeature( const QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project, const QString &format,
                           int prec, QgsCoordinateReferenceSystem &crs, QgsRectangle *rect, const QStringList &typeNames );
 
-    void setGetFeature( QgsServerResponse &response, const QString &format, QgsFeature *feat, int featIdx, int prec,
-                        QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes,
-                        const QString &typeName, bool withGeom, const QString &geometryName );
-
     void endGetFeature( QgsServerResponse &response, const QString &format );
 
   }
@@ -167,6 +220,7 @@ namespace QgsWfs
     long iteratedFeatures = 0;
     // sent features
     QgsFeature feature;
+    FeatureWriter writer( response, aRequest.outputFormat );
     qIt = aRequest.queries.begin();
     for ( ; qIt != aRequest.queries.end(); ++qIt )
     {
@@ -307,6 +361,8 @@ namespace QgsWfs
         geometryName = QLatin1String( "NONE" );
       }
 
+      writer.setLayer( typeName, vlayer->pendingFields(), attrIndexes, layerExcludedAttributes, layerPrecision, layerCrs, withGeom, geometryName );
+
       // Iterate through features
       QgsFeatureIterator fit = vlayer->getFeatures( featureRequest );
       while ( fit.nextFeature( feature ) && ( aRequest.maxFeatures == -1 || sentFeatures < aRequest.maxFeatures ) )
@@ -316,8 +372,7 @@ namespace QgsWfs
 
         if ( iteratedFeatures >= aRequest.startIndex )
         {
-          setGetFeature( response, aRequest.outputFormat, &feature, sentFeatures, layerPrecision, layerCrs, attrIndexes, layerExcludedAttributes,
-                         typeName, withGeom, geometryName );
+          writer.writeFeature( feature, sentFeatures );
           ++sentFeatures;
         }
         ++iteratedFeatures;
@@ -332,6 +387,7 @@ namespace QgsWfs
     // End of GetFeature
     if ( iteratedFeatures <= aRequest.startIndex )
       startGetFeature( request, response, project, aRequest.outputFormat, requestPrecision, requestCrs, &requestRect, typeNameList );
+    writer.flush();
     endGetFeature( response, aRequest.outputFormat );
 
   }
@@ -933,46 +989,6 @@ namespace QgsWfs
       }
     }
 
-    void setGetFeature( QgsServerResponse &response, const QString &format, QgsFeature *feat, int featIdx, int prec,
-                        QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes,
-                        const QString &typeName, bool withGeom, const QString &geometryName )
-    {
-      if ( !feat->isValid() )
-        return;
-
-      if ( format == QLatin1String( "GeoJSON" ) )
-      {
-        QString fcString;
-        if ( featIdx == 0 )
-          fcString += QLatin1String( "  " );
-        else
-          fcString += QLatin1String( " ," );
-        fcString += createFeatureGeoJSON( feat, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
-        fcString += QLatin1String( "\n" );
-
-        response.write( fcString.toUtf8() );
-      }
-      else
-      {
-        QDomDocument gmlDoc;
-        QDomElement featureElement;
-        if ( format == QLatin1String( "GML3" ) )
-        {
-          featureElement = createFeatureGML3( feat, gmlDoc, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
-          gmlDoc.appendChild( featureElement );
-        }
-        else
-        {
-          featureElement = createFeatureGML2( feat, gmlDoc, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
-          gmlDoc.appendChild( featureElement );
-        }
-        response.write( gmlDoc.toByteArray() );
-      }
-
-      // Stream partial content
-      response.flush();
-    }
-
     void endGetFeature( QgsServerResponse &response, const QString &format )
     {
       QString fcString;
@@ -988,41 +1004,32 @@ namespace QgsWfs
       response.write( fcString.toUtf8() );
     }
 
+    //! Size of the chunks written to the response
+    const int FEATURE_CHUNK_SIZE = 65536;
 
-    QString createFeatureGeoJSON( QgsFeature *feat, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
+    FeatureWriter::FeatureWriter( QgsServerResponse &response, const QString &format )
+      : mResponse( response )
+      , mGeoJSON( format == QLatin1String( "GeoJSON" ) )
+      , mGML3( format == QLatin1String( "GML3" ) )
     {
-      QString id = QStringLiteral( "%1.%2" ).arg( typeName, FID_TO_STRING( feat->id() ) );
-
-      QgsJSONExporter exporter;
-      exporter.setSourceCrs( crs );
-      //QgsJSONExporter force transform geometry to ESPG:4326
-      //and the RFC 7946 GeoJSON specification recommends limiting coordinate precision to 6
-      Q_UNUSED( prec );
-      //exporter.setPrecision( prec );
-
-      //copy feature so we can modify its geometry as required
-      QgsFeature f( *feat );
-      QgsGeometry geom = feat->geometry();
-      exporter.setIncludeGeometry( false );
-      if ( !geom.isNull() && withGeom && geometryName != QLatin1String( "NONE" ) )
-      {
-        exporter.setIncludeGeometry( true );
-        if ( geometryName == QLatin1String( "EXTENT" ) )
-        {
-          QgsRectangle box = geom.boundingBox();
-          f.setGeometry( QgsGeometry::fromRect( box ) );
-        }
-        else if ( geometryName == QLatin1String( "CENTROID" ) )
-        {
-          f.setGeometry( geom.centroid() );
-        }
-      }
+      mBuffer.reserve( 2 * FEATURE_CHUNK_SIZE );
+    }
 
-      QgsFields fields = feat->fields();
+    void FeatureWriter::setLayer( const QString &typeName, const QgsFields &fields, const QgsAttributeList &attrIndexes,
+                                  const QSet<QString> &excludedAttributes, int prec, const QgsCoordinateReferenceSystem &crs,
+                                  bool withGeom, const QString &geometryName )
+    {
+      mTypeName = typeName;
+      mTypeNameElement = QString( "qgs:" + typeName ).toUtf8();
+      mPrecision = prec;
+      mCrs = crs;
+      mWithGeom = withGeom;
+      mGeometryName = geometryName;
+
+      mAttributes.clear();
       QgsAttributeList attrsToExport;
-      for ( int i = 0; i < attrIndexes.count(); ++i )
+      for ( int idx : attrIndexes )
       {
-        int idx = attrIndexes[i];
         if ( idx >= fields.count() )
         {
           continue;
@@ -1035,181 +1042,468 @@ namespace QgsWfs
         }
 
         attrsToExport << idx;
+        mAttributes << qMakePair( idx, QString( "qgs:" + attributeName.replace( QStringLiteral( " " ), QStringLiteral( "_" ) ) ).toUtf8() );
       }
 
-      exporter.setIncludeAttributes( !attrsToExport.isEmpty() );
-      exporter.setAttributes( attrsToExport );
+      if ( mGeoJSON )
+      {
+        mJsonExporter.reset( new QgsJSONExporter() );
+        mJsonExporter->setSourceCrs( crs );
+        //QgsJSONExporter force transform geometry to ESPG:4326
+        //and the RFC 7946 GeoJSON specification recommends limiting coordinate precision to 6
+        mJsonExporter->setIncludeAttributes( !attrsToExport.isEmpty() );
+        mJsonExporter->setAttributes( attrsToExport );
+      }
+    }
 
-      return exporter.exportFeature( f, QVariantMap(), id );
+    void FeatureWriter::writeFeature( const QgsFeature &feat, int featIdx )
+    {
+      if ( !feat.isValid() )
+        return;
+
+      if ( mGeoJSON )
+        writeFeatureGeoJSON( feat, featIdx );
+      else
+        writeFeatureGML( feat );
+
+      // Stream partial content
+      if ( mBuffer.size() >= FEATURE_CHUNK_SIZE )
+        flush();
+    }
+
+    void FeatureWriter::flush()
+    {
+      if ( mBuffer.isEmpty() )
+        return;
+
+      mResponse.write( mBuffer );
+      mResponse.flush();
+      // keeps the reserved capacity
+      mBuffer.resize( 0 );
     }
 
+    void FeatureWriter::writeFeatureGeoJSON( const QgsFeature &feat, int featIdx )
+    {
+      QString id = QStringLiteral( "%1.%2" ).arg( mTypeName, FID_TO_STRING( feat.id() ) );
+
+      //copy feature so we can modify its geometry as required
+      QgsFeature f( feat );
+      QgsGeometry geom = feat.geometry();
+      mJsonExporter->setIncludeGeometry( false );
+      if ( !geom.isNull() && mWithGeom && mGeometryName != QLatin1String( "NONE" ) )
+      {
+        mJsonExporter->setIncludeGeometry( true );
+        if ( mGeometryName == QLatin1String( "EXTENT" ) )
+        {
+          QgsRectangle box = geom.boundingBox();
+          f.setGeometry( QgsGeometry::fromRect( box ) );
+        }
+        else if ( mGeometryName == QLatin1String( "CENTROID" ) )
+        {
+          f.setGeometry( geom.centroid() );
+        }
+      }
+
+      mBuffer.append( featIdx == 0 ? "  " : " ," );
+      mBuffer.append( mJsonExporter->exportFeature( f, QVariantMap(), id ).toUtf8() );
+      mBuffer.append( '\n' );
+    }
 
-    QDomElement createFeatureGML2( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
+    void FeatureWriter::writeFeatureGML( const QgsFeature &feat )
     {
       //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      startElement( "gml:featureMember" );
 
       //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + typeName /*qgs:%TYPENAME%*/ );
-      typeNameElement.setAttribute( QStringLiteral( "fid" ), typeName + "." + QString::number( feat->id() ) );
-      featureElement.appendChild( typeNameElement );
+      startElement( mTypeNameElement );
+      attribute( mGML3 ? "gml:id" : "fid", mTypeName + "." + QString::number( feat.id() ) );
 
-      if ( withGeom && geometryName != QLatin1String( "NONE" ) )
+      if ( mWithGeom && mGeometryName != QLatin1String( "NONE" ) )
       {
         //add geometry column (as gml)
-        QgsGeometry geom = feat->geometry();
+        QgsGeometry geom = feat.geometry();
+        QString srsName = mCrs.isValid() ? mCrs.authid() : QString();
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
-        QDomElement gmlElem;
-        if ( geometryName == QLatin1String( "EXTENT" ) )
+        if ( mGeometryName == QLatin1String( "EXTENT" ) || mGeometryName == QLatin1String( "CENTROID" ) )
         {
-          QgsGeometry bbox = QgsGeometry::fromRect( geom.boundingBox() );
-          gmlElem = QgsOgcUtils::geometryToGML( &bbox, doc, prec );
-        }
-        else if ( geometryName == QLatin1String( "CENTROID" ) )
-        {
-          QgsGeometry centroid = geom.centroid();
-          gmlElem = QgsOgcUtils::geometryToGML( &centroid, doc, prec );
-        }
-        else
-        {
-          QgsAbstractGeometry *abstractGeom = geom.geometry();
-          if ( abstractGeom )
+          QgsGeometry gmlGeom = mGeometryName == QLatin1String( "EXTENT" ) ? QgsGeometry::fromRect( geom.boundingBox() ) : geom.centroid();
+          QDomElement gmlElem = mGML3 ? QgsOgcUtils::geometryToGML( &gmlGeom, mDoc, QStringLiteral( "GML3" ), mPrecision )
+                                : QgsOgcUtils::geometryToGML( &gmlGeom, mDoc, mPrecision );
+          if ( !gmlElem.isNull() )
           {
-            gmlElem = abstractGeom->asGML2( doc, prec, "http://www.opengis.net/gml" );
+            writeBoundingBox( geom.boundingBox() );
+            if ( !srsName.isEmpty() )
+              gmlElem.setAttribute( QStringLiteral( "srsName" ), srsName );
+            startElement( "qgs:geometry" );
+            element( gmlElem );
+            endElement();
           }
         }
-
-        if ( !gmlElem.isNull() )
+        else if ( geom.geometry() )
         {
-          QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
-          QDomElement boxElem = QgsOgcUtils::rectangleToGMLBox( &box, doc, prec );
-
-          if ( crs.isValid() )
-          {
-            boxElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-            gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-          }
-
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
-
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+          writeBoundingBox( geom.boundingBox() );
+          startElement( "qgs:geometry" );
+          writeGeometry( geom.geometry(), srsName );
+          endElement();
         }
       }
 
       //read all attribute values from the feature
-      QgsAttributes featureAttributes = feat->attributes();
-      QgsFields fields = feat->fields();
-      for ( int i = 0; i < attrIndexes.count(); ++i )
+      QgsAttributes featureAttributes = feat.attributes();
+      for ( const QPair< int, QByteArray > &attr : mAttributes )
       {
-        int idx = attrIndexes[i];
-        if ( idx >= fields.count() )
-        {
-          continue;
-        }
-        QString attributeName = fields.at( idx ).name();
-        //skip attribute if it is excluded from WFS publication
-        if ( excludedAttributes.contains( attributeName ) )
-        {
-          continue;
-        }
-
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( QStringLiteral( " " ), QStringLiteral( "_" ) ) );
-        QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
+        startElement( attr.second );
+        text( featureAttributes.value( attr.first ).toString() );
+        endElement();
       }
 
-      return featureElement;
+      endElement();
+      endElement();
     }
 
-    QDomElement createFeatureGML3( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString geometryName )
+    void FeatureWriter::writeBoundingBox( const QgsRectangle &box )
     {
-      //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
-
-      //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + typeName /*qgs:%TYPENAME%*/ );
-      typeNameElement.setAttribute( QStringLiteral( "gml:id" ), typeName + "." + QString::number( feat->id() ) );
-      featureElement.appendChild( typeNameElement );
+      startElement( "gml:boundedBy" );
+      if ( mGML3 )
+      {
+        startElement( "gml:Envelope" );
+        if ( mCrs.isValid() )
+          attribute( "srsName", mCrs.authid() );
+        startElement( "gml:lowerCorner" );
+        closeStartTag();
+        number( box.xMinimum() );
+        character( ' ' );
+        number( box.yMinimum() );
+        endElement();
+        startElement( "gml:upperCorner" );
+        closeStartTag();
+        number( box.xMaximum() );
+        character( ' ' );
+        number( box.yMaximum() );
+        endElement();
+        endElement();
+      }
+      else
+      {
+        startElement( "gml:Box" );
+        if ( mCrs.isValid() )
+          attribute( "srsName", mCrs.authid() );
+        startElement( "gml:coordinates" );
+        attribute( "cs", QStringLiteral( "," ) );
+        attribute( "ts", QStringLiteral( " " ) );
+        closeStartTag();
+        number( box.xMinimum() );
+        character( ',' );
+        number( box.yMinimum() );
+        character( ' ' );
+        number( box.xMaximum() );
+        character( ',' );
+        number( box.yMaximum() );
+        endElement();
+        endElement();
+      }
+      endElement();
+    }
 
-      if ( withGeom && geometryName != QLatin1String( "NONE" ) )
+    void FeatureWriter::writeGeometry( const QgsAbstractGeometry *geom, const QString &srsName )
+    {
+      // elements are in the GML namespace like the ones of QgsAbstractGeometry::asGML2() and asGML3()
+      auto startGmlElement = [this, &srsName]( const QByteArray & name, bool top )
       {
-        //add geometry column (as gml)
-        QgsGeometry geom = feat->geometry();
+        startElement( name );
+        attribute( "xmlns", GML_NAMESPACE );
+        if ( top && !srsName.isEmpty() )
+          attribute( "srsName", srsName );
+      };
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
-        QDomElement gmlElem;
-        if ( geometryName == QLatin1String( "EXTENT" ) )
+      switch ( QgsWkbTypes::flatType( geom->wkbType() ) )
+      {
+        case QgsWkbTypes::Point:
         {
-          QgsGeometry bbox = QgsGeometry::fromRect( geom.boundingBox() );
-          gmlElem = QgsOgcUtils::geometryToGML( &bbox, doc, QStringLiteral( "GML3" ), prec );
+          const QgsPointV2 *point = static_cast< const QgsPointV2 * >( geom );
+          startGmlElement( "Point", true );
+          if ( mGML3 )
+          {
+            startGmlElement( "pos", false );
+            attribute( "srsDimension", point->is3D() ? QStringLiteral( "3" ) : QStringLiteral( "2" ) );
+            closeStartTag();
+            number( point->x() );
+            character( ' ' );
+            number( point->y() );
+            if ( point->is3D() )
+            {
+              character( ' ' );
+              number( point->z() );
+            }
+          }
+          else
+          {
+            startGmlElement( "coordinates", false );
+            closeStartTag();
+            number( point->x() );
+            character( ',' );
+            number( point->y() );
+          }
+          endElement();
+          endElement();
+          return;
         }
-        else if ( geometryName == QLatin1String( "CENTROID" ) )
+
+        case QgsWkbTypes::LineString:
         {
-          QgsGeometry centroid = geom.centroid();
-          gmlElem = QgsOgcUtils::geometryToGML( &centroid, doc, QStringLiteral( "GML3" ), prec );
+          startGmlElement( "LineString", true );
+          writePositions( static_cast< const QgsLineString * >( geom ) );
+          endElement();
+          return;
         }
-        else
+
+        case QgsWkbTypes::Polygon:
         {
-          QgsAbstractGeometry *abstractGeom = geom.geometry();
-          if ( abstractGeom )
+          const QgsPolygonV2 *polygon = static_cast< const QgsPolygonV2 * >( geom );
+          bool linearRings = dynamic_cast< const QgsLineString * >( polygon->exteriorRing() );
+          for ( int i = 0; linearRings && i < polygon->numInteriorRings(); ++i )
+            linearRings = dynamic_cast< const QgsLineString * >( polygon->interiorRing( i ) );
+          if ( !linearRings )
+            break;
+
+          startGmlElement( "Polygon", true );
+          startGmlElement( mGML3 ? "exterior" : "outerBoundaryIs", false );
+          startGmlElement( "LinearRing", false );
+          writePositions( static_cast< const QgsLineString * >( polygon->exteriorRing() ) );
+          endElement();
+          endElement();
+          if ( mGML3 )
           {
-            gmlElem = abstractGeom->asGML3( doc, prec, "http://www.opengis.net/gml" );
+            for ( int i = 0; i < polygon->numInteriorRings(); ++i )
+            {
+              startGmlElement( "interior", false );
+              startGmlElement( "LinearRing", false );
+              writePositions( static_cast< const QgsLineString * >( polygon->interiorRing( i ) ) );
+              endElement();
+              endElement();
+            }
           }
+          else
+          {
+            // GML2 polygons always have an innerBoundaryIs element
+            startGmlElement( "innerBoundaryIs", false );
+            for ( int i = 0; i < polygon->numInteriorRings(); ++i )
+            {
+              startGmlElement( "LinearRing", false );
+              writePositions( static_cast< const QgsLineString * >( polygon->interiorRing( i ) ) );
+              endElement();
+            }
+            endElement();
+          }
+          endElement();
+          return;
         }
 
-        if ( !gmlElem.isNull() )
+        case QgsWkbTypes::MultiPoint:
+        case QgsWkbTypes::MultiLineString:
+        case QgsWkbTypes::MultiPolygon:
+        case QgsWkbTypes::GeometryCollection:
         {
-          QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
-          QDomElement boxElem = QgsOgcUtils::rectangleToGMLEnvelope( &box, doc, prec );
-
-          if ( crs.isValid() )
+          const QgsGeometryCollection *collection = static_cast< const QgsGeometryCollection * >( geom );
+          QByteArray collectionName;
+          QByteArray memberName;
+          switch ( QgsWkbTypes::flatType( geom->wkbType() ) )
           {
-            boxElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-            gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
+            case QgsWkbTypes::MultiPoint:
+              collectionName = "MultiPoint";
+              memberName = "pointMember";
+              break;
+            case QgsWkbTypes::MultiLineString:
+              collectionName = mGML3 ? "MultiCurve" : "MultiLineString";
+              memberName = mGML3 ? "curveMember" : "lineStringMember";
+              break;
+            case QgsWkbTypes::MultiPolygon:
+              collectionName = "MultiPolygon";
+              memberName = "polygonMember";
+              break;
+            default:
+              collectionName = "MultiGeometry";
+              memberName = "geometryMember";
+              break;
           }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
-
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+          startGmlElement( collectionName, true );
+          for ( int i = 0; i < collection->numGeometries(); ++i )
+          {
+            startGmlElement( memberName, false );
+            writeGeometry( collection->geometryN( i ), QString() );
+            endElement();
+          }
+          endElement();
+          return;
         }
+
+        default:
+          break;
       }
 
-      //read all attribute values from the feature
-      QgsAttributes featureAttributes = feat->attributes();
-      QgsFields fields = feat->fields();
-      for ( int i = 0; i < attrIndexes.count(); ++i )
+      // curved geometries are serialized as a document
+      QDomElement gmlElem = mGML3 ? geom->asGML3( mDoc, mPrecision, GML_NAMESPACE ) : geom->asGML2( mDoc, mPrecision, GML_NAMESPACE );
+      if ( !srsName.isEmpty() )
+        gmlElem.setAttribute( QStringLiteral( "srsName" ), srsName );
+      element( gmlElem );
+    }
+
+    void FeatureWriter::writePositions( const QgsLineString *line )
+    {
+      startElement( mGML3 ? "posList" : "coordinates" );
+      attribute( "xmlns", GML_NAMESPACE );
+      bool is3D = mGML3 && line->is3D();
+      if ( mGML3 )
+        attribute( "srsDimension", is3D ? QStringLiteral( "3" ) : QStringLiteral( "2" ) );
+      closeStartTag();
+      for ( int i = 0, n = line->numPoints(); i < n; ++i )
       {
-        int idx = attrIndexes[i];
-        if ( idx >= fields.count() )
-        {
-          continue;
-        }
-        QString attributeName = fields.at( idx ).name();
-        //skip attribute if it is excluded from WFS publication
-        if ( excludedAttributes.contains( attributeName ) )
+        if ( i > 0 )
+          character( ' ' );
+        number( line->xAt( i ) );
+        character( mGML3 ? ' ' : ',' );
+        number( line->yAt( i ) );
+        if ( is3D )
         {
-          continue;
+          character( ' ' );
+          number( line->zAt( i ) );
         }
+      }
+      endElement();
+    }
+
+    void FeatureWriter::startElement( const QByteArray &name )
+    {
+      if ( mStartTagOpen )
+        mBuffer.append( ">\n" );
+      mBuffer.append( QByteArray( mElements.size(), ' ' ) );
+      mBuffer.append( '<' );
+      mBuffer.append( name );
+      mElements.append( name );
+      mStartTagOpen = true;
+      mTextContent = false;
+    }
+
+    void FeatureWriter::attribute( const QByteArray &name, const QString &value )
+    {
+      mBuffer.append( ' ' );
+      mBuffer.append( name );
+      mBuffer.append( "=\"" );
+      appendEscaped( value, true );
+      mBuffer.append( '"' );
+    }
+
+    void FeatureWriter::text( const QString &value )
+    {
+      closeStartTag();
+      appendEscaped( value, false );
+    }
 
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( QStringLiteral( " " ), QStringLiteral( "_" ) ) );
-        QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
+    void FeatureWriter::number( double value )
+    {
+      // same as qgsDoubleToString()
+      QByteArray str = QByteArray::number( value, 'f', mPrecision );
+      if ( mPrecision > 0 && str.contains( '.' ) )
+      {
+        int end = str.size();
+        while ( str.at( end - 1 ) == '0' )
+          --end;
+        if ( str.at( end - 1 ) == '.' )
+          --end;
+        str.truncate( end );
       }
+      mBuffer.append( str );
+    }
+
+    void FeatureWriter::character( char c )
+    {
+      mBuffer.append( c );
+    }
 
-      return featureElement;
+    void FeatureWriter::closeStartTag()
+    {
+      if ( mStartTagOpen )
+      {
+        mBuffer.append( '>' );
+        mStartTagOpen = false;
+      }
+      mTextContent = true;
     }
 
+    void FeatureWriter::endElement()
+    {
+      QByteArray name = mElements.takeLast();
+      if ( mStartTagOpen )
+      {
+        mBuffer.append( "/>\n" );
+      }
+      else
+      {
+        if ( !mTextContent )
+          mBuffer.append( QByteArray( mElements.size(), ' ' ) );
+        mBuffer.append( "</" );
+        mBuffer.append( name );
+        mBuffer.append( ">\n" );
+      }
+      mStartTagOpen = false;
+      mTextContent = false;
+    }
 
+    void FeatureWriter::element( const QDomElement &elem )
+    {
+      QString name = elem.prefix().isEmpty() ? elem.nodeName() : elem.prefix() + ':' + elem.nodeName();
+      startElement( name.toUtf8() );
+      if ( !elem.namespaceURI().isNull() )
+        attribute( elem.prefix().isEmpty() ? QByteArray( "xmlns" ) : QString( "xmlns:" + elem.prefix() ).toUtf8(), elem.namespaceURI() );
+      QDomNamedNodeMap attributes = elem.attributes();
+      for ( int i = 0; i < attributes.count(); ++i )
+      {
+        QDomNode attr = attributes.item( i );
+        attribute( attr.nodeName().toUtf8(), attr.nodeValue() );
+      }
+      for ( QDomNode child = elem.firstChild(); !child.isNull(); child = child.nextSibling() )
+      {
+        if ( child.isElement() )
+          element( child.toElement() );
+        else if ( child.isText() )
+          text( child.nodeValue() );
+      }
+      endElement();
+    }
 
+    void FeatureWriter::appendEscaped( const QString &value, bool attributeValue )
+    {
+      // same escaping as QDomDocument::toByteArray()
+      int start = 0;
+      for ( int i = 0; i < value.size(); ++i )
+      {
+        const QChar c = value.at( i );
+        const char *replacement = nullptr;
+        if ( c == '<' )
+          replacement = "&lt;";
+        else if ( c == '&' )
+          replacement = "&amp;";
+        else if ( c == '>' && i >= 2 && value.at( i - 1 ) == ']' && value.at( i - 2 ) == ']' )
+          replacement = "&gt;";
+        else if ( c == '"' && attributeValue )
+          replacement = "&quot;";
+        else if ( c == '\r' )
+          replacement = "&#xd;";
+        else if ( c == '\n' && attributeValue )
+          replacement = "&#xa;";
+        else if ( c == '\t' && attributeValue )
+          replacement = "&#x9;";
+
+        if ( replacement )
+        {
+          mBuffer.append( value.midRef( start, i - start ).toUtf8() );
+          mBuffer.append( replacement );
+          start = i + 1;
+        }
+      }
+      mBuffer.append( value.midRef( start ).toUtf8() );
+    }
 
   } // namespace
 
@@ -18,6 +18,7 @@
 #include "qgsmaprendererjobproxy.h"
 
 #include "qgsmessagelog.h"
+#include "qgsservermetrics.h"
 #include "qgsmaprendererparalleljob.h"
 #include "qgsmaprenderercustompainterjob.h"
 
@@ -58,6 +59,7 @@ namespace QgsWms
       renderJob.start();
       renderJob.waitForFinished();
       *image = renderJob.renderedImage();
+      QgsServerMetrics::addLayerRenderings( renderJob );
       mPainter.reset( new QPainter( image ) );
     }
     else
@@ -68,6 +70,7 @@ namespace QgsWms
       renderJob.setFeatureFilterProvider( mAccessControl );
 #endif
       renderJob.renderSynchronously();
+      QgsServerMetrics::addLayerRenderings( renderJob );
     }
   }
 
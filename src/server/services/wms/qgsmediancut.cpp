@@ -21,305 +21,440 @@
 
 #include "qgsmediancut.h"
 
-#include <QList>
-#include <QMultiMap>
-#include <QHash>
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
 
 namespace QgsWms
 {
 
-  typedef QList< QPair<QRgb, int> > QgsColorBox; //Color / number of pixels
-  typedef QMultiMap< int, QgsColorBox > QgsColorBoxMap; // sum of pixels / color box
-
   namespace
   {
 
-    void imageColors( QHash<QRgb, int> &colors, const QImage &image )
-    {
-      colors.clear();
-      int width = image.width();
-      int height = image.height();
+    // The histogram is a cube with 5 bits per color channel and 4 classes of alpha values
+    const int CUBE_BITS = 5;
+    const int CUBE_SIDE = 1 << CUBE_BITS;
+    const int ALPHA_CLASSES = 4;
+    const int HISTOGRAM_SIZE = ALPHA_CLASSES * CUBE_SIDE * CUBE_SIDE * CUBE_SIDE;
 
-      const QRgb *currentScanLine = nullptr;
-      QHash<QRgb, int>::iterator colorIt;
-      for ( int i = 0; i < height; ++i )
-      {
-        currentScanLine = ( const QRgb * )( image.scanLine( i ) );
-        for ( int j = 0; j < width; ++j )
-        {
-          colorIt = colors.find( currentScanLine[j] );
-          if ( colorIt == colors.end() )
-          {
-            colors.insert( currentScanLine[j], 1 );
-          }
-          else
-          {
-            colorIt.value()++;
-          }
-        }
-      }
-    }
+    //! Maximum number of cached palettes
+    const int MAX_CACHED_PALETTES = 100;
 
-    bool minMaxRange( const QgsColorBox &colorBox, int &redRange, int &greenRange, int &blueRange, int &alphaRange )
+    //! Color axes of the histogram: alpha class, red, green and blue
+    enum Axis
     {
-      if ( colorBox.size() < 1 )
-      {
-        return false;
-      }
-
-      int rMin = INT_MAX;
-      int gMin = INT_MAX;
-      int bMin = INT_MAX;
-      int aMin = INT_MAX;
-      int rMax = INT_MIN;
-      int gMax = INT_MIN;
-      int bMax = INT_MIN;
-      int aMax = INT_MIN;
-
-      int currentRed = 0;
-      int currentGreen = 0;
-      int currentBlue = 0;
-      int currentAlpha = 0;
-
-      for ( auto colorBoxIt = colorBox.constBegin() ; colorBoxIt != colorBox.constEnd(); ++colorBoxIt )
-      {
-        currentRed = qRed( colorBoxIt->first );
-        if ( currentRed > rMax )
-        {
-          rMax = currentRed;
-        }
-        if ( currentRed < rMin )
-        {
-          rMin = currentRed;
-        }
-
-        currentGreen = qGreen( colorBoxIt->first );
-        if ( currentGreen > gMax )
-        {
-          gMax = currentGreen;
-        }
-        if ( currentGreen < gMin )
-        {
-          gMin = currentGreen;
-        }
-
-        currentBlue = qBlue( colorBoxIt->first );
-        if ( currentBlue > bMax )
-        {
-          bMax = currentBlue;
-        }
-        if ( currentBlue < bMin )
-        {
-          bMin = currentBlue;
-        }
-
-        currentAlpha = qAlpha( colorBoxIt->first );
-        if ( currentAlpha > aMax )
-        {
-          aMax = currentAlpha;
-        }
-        if ( currentAlpha < aMin )
-        {
-          aMin = currentAlpha;
-        }
-      }
+      AlphaAxis = 0,
+      RedAxis,
+      GreenAxis,
+      BlueAxis
+    };
 
-      redRange = rMax - rMin;
-      greenRange = gMax - gMin;
-      blueRange = bMax - bMin;
-      alphaRange = aMax - aMin;
-      return true;
+    inline int alphaClass( int alpha )
+    {
+      return alpha == 255 ? 3 : ( alpha >= 128 ? 2 : ( alpha > 0 ? 1 : 0 ) );
     }
 
-    bool redCompare( QPair<QRgb, int> c1, QPair<QRgb, int> c2 )
+    inline int histogramIndex( QRgb color )
     {
-      return qRed( c1.first ) < qRed( c2.first );
+      return ( alphaClass( qAlpha( color ) ) << ( 3 * CUBE_BITS ) )
+             | ( ( qRed( color ) >> ( 8 - CUBE_BITS ) ) << ( 2 * CUBE_BITS ) )
+             | ( ( qGreen( color ) >> ( 8 - CUBE_BITS ) ) << CUBE_BITS )
+             | ( qBlue( color ) >> ( 8 - CUBE_BITS ) );
     }
 
-    bool greenCompare( QPair<QRgb, int> c1, QPair<QRgb, int> c2 )
+    inline int histogramIndex( const int coords[4] )
     {
-      return qGreen( c1.first ) < qGreen( c2.first );
+      return ( coords[AlphaAxis] << ( 3 * CUBE_BITS ) ) | ( coords[RedAxis] << ( 2 * CUBE_BITS ) ) | ( coords[GreenAxis] << CUBE_BITS ) | coords[BlueAxis];
     }
 
-    bool blueCompare( QPair<QRgb, int> c1, QPair<QRgb, int> c2 )
+    //! Returns the non premultiplied color of a pixel, transparent pixels are all mapped to the same color
+    inline QRgb pixelColor( QRgb pixel, bool premultiplied )
     {
-      return qBlue( c1.first ) < qBlue( c2.first );
+      if ( qAlpha( pixel ) == 0 )
+        return 0;
+      return premultiplied ? qUnpremultiply( pixel ) : pixel;
     }
 
-    bool alphaCompare( QPair<QRgb, int> c1, QPair<QRgb, int> c2 )
+    //! Returns a 32 bit image which may be read by pixelColor()
+    QImage sourceImage( const QImage &image, bool &premultiplied )
     {
-      return qAlpha( c1.first ) < qAlpha( c2.first );
+      premultiplied = image.format() == QImage::Format_ARGB32_Premultiplied;
+      if ( premultiplied || image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_RGB32 )
+        return image;
+      return image.convertToFormat( QImage::Format_ARGB32 );
     }
 
-    QRgb boxColor( const QgsColorBox &box, int boxPixels )
+    /**
+     * Hash table of the exact colors of an image, as long as the image does not have
+     * more than a maximum number of colors.
+     */
+    class ExactColors
     {
-      double avRed = 0;
-      double avGreen = 0;
-      double avBlue = 0;
-      double avAlpha = 0;
-      QRgb currentColor;
-      int currentPixel;
+      public:
+        explicit ExactColors( int maxColors )
+          : mMaxColors( maxColors )
+        {
+          int size = 16;
+          while ( size < 4 * maxColors )
+            size *= 2;
+          mKeys.resize( size );
+          mIndexes.fill( -1, size );
+        }
+
+        //! Returns the index of \a color, or -1 if the image has too many colors
+        int index( QRgb color )
+        {
+          // images have long runs of the same color
+          if ( color == mLastColor && mLastIndex >= 0 )
+            return mLastIndex;
 
-      double weight;
+          int mask = mKeys.size() - 1;
+          int slot = static_cast< int >( ( color * 2654435761U ) >> 16 ) & mask;
+          while ( mIndexes.at( slot ) >= 0 && mKeys.at( slot ) != color )
+            slot = ( slot + 1 ) & mask;
 
-      for ( auto colorBoxIt = box.constBegin(); colorBoxIt != box.constEnd(); ++colorBoxIt )
-      {
-        currentColor = colorBoxIt->first;
-        currentPixel = colorBoxIt->second;
-        weight = ( double )currentPixel / boxPixels;
-        avRed   += ( qRed( currentColor ) * weight );
-        avGreen += ( qGreen( currentColor ) * weight );
-        avBlue  += ( qBlue( currentColor ) * weight );
-        avAlpha += ( qAlpha( currentColor ) * weight );
-      }
+          if ( mIndexes.at( slot ) < 0 )
+          {
+            if ( mColors.size() == mMaxColors )
+              return -1;
+            mKeys[slot] = color;
+            mIndexes[slot] = mColors.size();
+            mColors << color;
+          }
+          mLastColor = color;
+          mLastIndex = mIndexes.at( slot );
+          return mLastIndex;
+        }
 
-      return qRgba( avRed, avGreen, avBlue, avAlpha );
-    }
+        QVector<QRgb> colors() const { return mColors; }
 
+      private:
+        int mMaxColors;
+        QVector<QRgb> mKeys;
+        QVector<int> mIndexes;
+        QVector<QRgb> mColors;
+        QRgb mLastColor = 0;
+        int mLastIndex = -1;
+    };
 
-    void splitColorBox( QgsColorBox &colorBox, QgsColorBoxMap &colorBoxMap,
-                        QMap<int, QgsColorBox>::iterator colorBoxMapIt )
+    //! Box of the color cube
+    struct ColorBox
     {
+      int min[4];
+      int max[4];
+      qint64 count;
 
-      if ( colorBox.size() < 2 )
+      bool isSplittable() const
       {
-        return; //need at least two colors for a split
+        return min[AlphaAxis] < max[AlphaAxis] || min[RedAxis] < max[RedAxis] || min[GreenAxis] < max[GreenAxis] || min[BlueAxis] < max[BlueAxis];
       }
+    };
 
-      //a,r,g,b ranges
-      int redRange = 0;
-      int greenRange = 0;
-      int blueRange = 0;
-      int alphaRange = 0;
-
-      if ( !minMaxRange( colorBox, redRange, greenRange, blueRange, alphaRange ) )
+    //! Calls \a func with the histogram index of each cell of \a box
+    template <typename Func>
+    void forEachCell( const ColorBox &box, Func func )
+    {
+      int coords[4];
+      for ( coords[AlphaAxis] = box.min[AlphaAxis]; coords[AlphaAxis] <= box.max[AlphaAxis]; ++coords[AlphaAxis] )
       {
-        return;
+        for ( coords[RedAxis] = box.min[RedAxis]; coords[RedAxis] <= box.max[RedAxis]; ++coords[RedAxis] )
+        {
+          for ( coords[GreenAxis] = box.min[GreenAxis]; coords[GreenAxis] <= box.max[GreenAxis]; ++coords[GreenAxis] )
+          {
+            coords[BlueAxis] = box.min[BlueAxis];
+            int index = histogramIndex( coords );
+            for ( ; coords[BlueAxis] <= box.max[BlueAxis]; ++coords[BlueAxis], ++index )
+            {
+              func( index, coords );
+            }
+          }
+        }
       }
+    }
 
-      //sort color box for a/r/g/b
-      if ( redRange >= greenRange && redRange >= blueRange && redRange >= alphaRange )
+    //! Reduces \a box to the cells containing pixels and counts the pixels
+    void shrinkColorBox( ColorBox &box, const QVector<quint32> &histogram )
+    {
+      ColorBox shrunk;
+      for ( int axis = 0; axis < 4; ++axis )
       {
-        std::sort( colorBox.begin(), colorBox.end(), redCompare );
+        shrunk.min[axis] = box.max[axis];
+        shrunk.max[axis] = box.min[axis];
       }
-      else if ( greenRange >= redRange && greenRange >= blueRange && greenRange >= alphaRange )
+      shrunk.count = 0;
+
+      forEachCell( box, [&shrunk, &histogram]( int index, const int coords[4] )
       {
-        std::sort( colorBox.begin(), colorBox.end(), greenCompare );
-      }
-      else if ( blueRange >= redRange && blueRange >= greenRange && blueRange >= alphaRange )
+        quint32 count = histogram.at( index );
+        if ( count == 0 )
+          return;
+        shrunk.count += count;
+        for ( int axis = 0; axis < 4; ++axis )
+        {
+          shrunk.min[axis] = std::min( shrunk.min[axis], coords[axis] );
+          shrunk.max[axis] = std::max( shrunk.max[axis], coords[axis] );
+        }
+      } );
+      box = shrunk;
+    }
+
+    //! Splits \a box at the median of its longest axis, \a box keeps the lower half
+    ColorBox splitColorBox( ColorBox &box, const QVector<quint32> &histogram )
+    {
+      // alpha classes are farther apart than color cells
+      int axis = AlphaAxis;
+      int longest = ( box.max[AlphaAxis] - box.min[AlphaAxis] ) * CUBE_SIDE / 2;
+      for ( int colorAxis = RedAxis; colorAxis <= BlueAxis; ++colorAxis )
       {
-        std::sort( colorBox.begin(), colorBox.end(), blueCompare );
+        if ( box.max[colorAxis] - box.min[colorAxis] > longest )
+        {
+          axis = colorAxis;
+          longest = box.max[colorAxis] - box.min[colorAxis];
+        }
       }
-      else
+
+      qint64 counts[CUBE_SIDE] = { 0 };
+      forEachCell( box, [&counts, &histogram, axis]( int index, const int coords[4] )
       {
-        std::sort( colorBox.begin(), colorBox.end(), alphaCompare );
+        counts[coords[axis]] += histogram.at( index );
+      } );
+
+      // both halves contain pixels as the box is shrunk
+      int median = box.min[axis];
+      qint64 sum = counts[median];
+      while ( median < box.max[axis] - 1 && 2 * sum < box.count )
+      {
+        ++median;
+        sum += counts[median];
       }
 
-      //get median
-      double halfSum = colorBoxMapIt.key() / 2.0;
-      int currentSum = 0;
-      int currentListIndex = 0;
+      ColorBox upper = box;
+      upper.min[axis] = median + 1;
+      box.max[axis] = median;
+      shrinkColorBox( box, histogram );
+      shrinkColorBox( upper, histogram );
+      return upper;
+    }
+
+    //! Median cut of the histogram, returns the palette index of each histogram cell
+    QVector<quint8> medianCut( const QVector<quint32> &histogram, int nColors )
+    {
+      ColorBox firstBox;
+      for ( int axis = 0; axis < 4; ++axis )
+      {
+        firstBox.min[axis] = 0;
+        firstBox.max[axis] = axis == AlphaAxis ? ALPHA_CLASSES - 1 : CUBE_SIDE - 1;
+      }
+      shrinkColorBox( firstBox, histogram );
 
-      auto colorBoxIt = colorBox.begin();
-      for ( ; colorBoxIt != colorBox.end(); ++colorBoxIt )
+      QVector<ColorBox> boxes;
+      boxes << firstBox;
+      while ( boxes.size() < nColors )
       {
-        currentSum += colorBoxIt->second;
-        if ( currentSum >= halfSum )
+        // split the box with the most pixels
+        int boxIndex = -1;
+        for ( int i = 0; i < boxes.size(); ++i )
         {
-          break;
+          if ( boxes.at( i ).isSplittable() && ( boxIndex < 0 || boxes.at( i ).count > boxes.at( boxIndex ).count ) )
+            boxIndex = i;
         }
-        ++currentListIndex;
+        if ( boxIndex < 0 )
+          break;
+
+        boxes << splitColorBox( boxes[boxIndex], histogram );
       }
 
-      if ( currentListIndex > ( colorBox.size() - 2 ) ) //if the median is contained in the last color, split one item before that
+      QVector<quint8> lookup( HISTOGRAM_SIZE, 0 );
+      for ( int i = 0; i < boxes.size(); ++i )
       {
-        --currentListIndex;
-        currentSum -= colorBoxIt->second;
+        forEachCell( boxes.at( i ), [&lookup, i]( int index, const int * )
+        {
+          lookup[index] = static_cast< quint8 >( i );
+        } );
       }
-      else
+      return lookup;
+    }
+
+    //! Palette shared by the images of a layer set
+    struct CachedPalette
+    {
+      QVector<QRgb> colors;
+      //! Palette index of each histogram cell, -1 until a pixel of the cell is mapped
+      QVector<qint16> lookup;
+    };
+
+    QMutex sPaletteMutex;
+    QCache<QString, CachedPalette> sPalettes( MAX_CACHED_PALETTES );
+
+    int nearestColor( QRgb color, const QVector<QRgb> &colors, int &distance )
+    {
+      int nearest = -1;
+      distance = INT_MAX;
+      for ( int i = 0; i < colors.size(); ++i )
       {
-        ++colorBoxIt; //the iterator needs to point behind the last item to remove
+        QRgb c = colors.at( i );
+        int dr = qRed( c ) - qRed( color );
+        int dg = qGreen( c ) - qGreen( color );
+        int db = qBlue( c ) - qBlue( color );
+        int da = qAlpha( c ) - qAlpha( color );
+        int d = dr * dr + dg * dg + db * db + 2 * da * da;
+        if ( d < distance )
+        {
+          nearest = i;
+          distance = d;
+        }
       }
+      return nearest;
+    }
 
-      //do split: replace old color box, insert new one
-      QgsColorBox newColorBox1 = colorBox.mid( 0, currentListIndex + 1 );
-      colorBoxMap.insert( currentSum, newColorBox1 );
+    //! Maps the pixels of \a source to \a palette, adding the missing colors while the palette is not full
+    QImage mapToPalette( const QImage &source, bool premultiplied, CachedPalette &palette, int nColors )
+    {
+      // colors closer than the size of a histogram cell are not added
+      const int cellSize = 1 << ( 8 - CUBE_BITS );
+      const int maxDistance = 3 * cellSize * cellSize;
 
-      colorBox.erase( colorBox.begin(), colorBoxIt );
-      QgsColorBox newColorBox2 = colorBox;
-      colorBoxMap.erase( colorBoxMapIt );
-      colorBoxMap.insert( halfSum * 2.0 - currentSum, newColorBox2 );
+      int width = source.width();
+      int height = source.height();
+      QImage result( width, height, QImage::Format_Indexed8 );
+      for ( int i = 0; i < height; ++i )
+      {
+        const QRgb *sourceLine = reinterpret_cast< const QRgb * >( source.constScanLine( i ) );
+        uchar *resultLine = result.scanLine( i );
+        for ( int j = 0; j < width; ++j )
+        {
+          QRgb color = pixelColor( sourceLine[j], premultiplied );
+          int index = histogramIndex( color );
+          qint16 colorIndex = palette.lookup.at( index );
+          if ( colorIndex < 0 )
+          {
+            int distance = 0;
+            colorIndex = nearestColor( color, palette.colors, distance );
+            if ( ( colorIndex < 0 || distance > maxDistance ) && palette.colors.size() < nColors )
+            {
+              colorIndex = palette.colors.size();
+              palette.colors << color;
+            }
+            palette.lookup[index] = colorIndex;
+          }
+          resultLine[j] = static_cast< uchar >( colorIndex );
+        }
+      }
+      result.setColorTable( palette.colors );
+      return result;
     }
 
   } // namespace
 
-  void medianCut( QVector<QRgb> &colorTable, int nColors, const QImage &inputImage )
+  QImage quantizeImage( const QImage &inputImage, int nColors, const QString &paletteKey )
   {
-    QHash<QRgb, int> inputColors;
-    imageColors( inputColors, inputImage );
+    nColors = qBound( 1, nColors, 256 );
+
+    bool premultiplied = false;
+    QImage source = sourceImage( inputImage, premultiplied );
+    int width = source.width();
+    int height = source.height();
 
-    if ( inputColors.size() <= nColors ) //all the colors in the image can be mapped to one palette color
+    QImage result;
+    if ( !paletteKey.isEmpty() )
     {
-      colorTable.resize( inputColors.size() );
-      int index = 0;
-      for ( auto inputColorIt = inputColors.constBegin(); inputColorIt != inputColors.constEnd(); ++inputColorIt )
+      QMutexLocker locker( &sPaletteMutex );
+      CachedPalette *palette = sPalettes.object( paletteKey );
+      if ( palette )
       {
-        colorTable[index] = inputColorIt.key();
-        ++index;
+        result = mapToPalette( source, premultiplied, *palette, nColors );
+        result.setDotsPerMeterX( inputImage.dotsPerMeterX() );
+        result.setDotsPerMeterY( inputImage.dotsPerMeterY() );
+        return result;
       }
-      return;
     }
 
-    //create first box
-    QgsColorBox firstBox; //QList< QPair<QRgb, int> >
-    int firstBoxPixelSum = 0;
-    for ( auto  inputColorIt = inputColors.constBegin(); inputColorIt != inputColors.constEnd(); ++inputColorIt )
+    // histogram and exact colors as long as there are not too many of them
+    QVector<quint32> histogram( HISTOGRAM_SIZE, 0 );
+    ExactColors exactColors( nColors );
+    bool exact = true;
+    for ( int i = 0; i < height; ++i )
     {
-      firstBox.push_back( qMakePair( inputColorIt.key(), inputColorIt.value() ) );
-      firstBoxPixelSum += inputColorIt.value();
+      const QRgb *sourceLine = reinterpret_cast< const QRgb * >( source.constScanLine( i ) );
+      for ( int j = 0; j < width; ++j )
+      {
+        QRgb color = pixelColor( sourceLine[j], premultiplied );
+        ++histogram[histogramIndex( color )];
+        if ( exact && exactColors.index( color ) < 0 )
+          exact = false;
+      }
     }
 
-    QgsColorBoxMap colorBoxMap; //QMultiMap< int, ColorBox >
-    colorBoxMap.insert( firstBoxPixelSum, firstBox );
-    QMap<int, QgsColorBox>::iterator colorBoxMapIt = colorBoxMap.end();
-
-    //split boxes until number of boxes == nColors or all the boxes have color count 1
-    bool allColorsMapped = false;
-    while ( colorBoxMap.size() < nColors )
+    result = QImage( width, height, QImage::Format_Indexed8 );
+    if ( exact )
     {
-      //start at the end of colorBoxMap and pick the first entry with number of colors < 1
-      colorBoxMapIt = colorBoxMap.end();
-      while ( true )
+      for ( int i = 0; i < height; ++i )
       {
-        --colorBoxMapIt;
-        if ( colorBoxMapIt.value().size() > 1 )
+        const QRgb *sourceLine = reinterpret_cast< const QRgb * >( source.constScanLine( i ) );
+        uchar *resultLine = result.scanLine( i );
+        for ( int j = 0; j < width; ++j )
         {
-          splitColorBox( colorBoxMapIt.value(), colorBoxMap, colorBoxMapIt );
-          break;
+          resultLine[j] = static_cast< uchar >( exactColors.index( pixelColor( sourceLine[j], premultiplied ) ) );
         }
-        if ( colorBoxMapIt == colorBoxMap.begin() )
+      }
+      result.setColorTable( exactColors.colors() );
+    }
+    else
+    {
+      QVector<quint8> lookup = medianCut( histogram, nColors );
+
+      // the palette colors are the mean colors of their pixels
+      quint64 sums[256][4];
+      quint64 counts[256];
+      std::memset( sums, 0, sizeof( sums ) );
+      std::memset( counts, 0, sizeof( counts ) );
+      int paletteSize = 0;
+      for ( int i = 0; i < height; ++i )
+      {
+        const QRgb *sourceLine = reinterpret_cast< const QRgb * >( source.constScanLine( i ) );
+        uchar *resultLine = result.scanLine( i );
+        for ( int j = 0; j < width; ++j )
         {
-          allColorsMapped = true;
-          break;
+          QRgb color = pixelColor( sourceLine[j], premultiplied );
+          quint8 colorIndex = lookup.at( histogramIndex( color ) );
+          resultLine[j] = colorIndex;
+          sums[colorIndex][0] += qRed( color );
+          sums[colorIndex][1] += qGreen( color );
+          sums[colorIndex][2] += qBlue( color );
+          sums[colorIndex][3] += qAlpha( color );
+          ++counts[colorIndex];
+          paletteSize = std::max( paletteSize, colorIndex + 1 );
         }
       }
 
-      if ( allColorsMapped )
+      QVector<QRgb> colorTable( paletteSize, 0 );
+      for ( int i = 0; i < paletteSize; ++i )
       {
-        break;
+        if ( counts[i] == 0 )
+          continue;
+        colorTable[i] = qRgba( static_cast< int >( ( sums[i][0] + counts[i] / 2 ) / counts[i] ),
+                               static_cast< int >( ( sums[i][1] + counts[i] / 2 ) / counts[i] ),
+                               static_cast< int >( ( sums[i][2] + counts[i] / 2 ) / counts[i] ),
+                               static_cast< int >( ( sums[i][3] + counts[i] / 2 ) / counts[i] ) );
       }
+      result.setColorTable( colorTable );
     }
+    result.setDotsPerMeterX( inputImage.dotsPerMeterX() );
+    result.setDotsPerMeterY( inputImage.dotsPerMeterY() );
 
-    //get representative colors for the boxes
-    int index = 0;
-    colorTable.resize( colorBoxMap.size() );
-    for ( auto colorBoxIt = colorBoxMap.constBegin(); colorBoxIt != colorBoxMap.constEnd(); ++colorBoxIt )
+    if ( !paletteKey.isEmpty() )
     {
-      colorTable[index] = boxColor( colorBoxIt.value(), colorBoxIt.key() );
-      ++index;
+      CachedPalette *palette = new CachedPalette;
+      palette->colors = result.colorTable();
+      palette->lookup.fill( -1, HISTOGRAM_SIZE );
+      QMutexLocker locker( &sPaletteMutex );
+      sPalettes.insert( paletteKey, palette );
     }
+    return result;
   }
 
 } // namespace QgsWms
-
-
@@ -35,12 +35,18 @@ namespace QgsWms
 {
 
   /**
-   * Median cut implementation used when reducing RGB colors to palletized colors
+   * Converts \a inputImage to an 8 bit indexed image with at most \a nColors colors.
+   *
+   * Images with few colors keep their exact colors. Otherwise the colors are reduced with
+   * a median cut of the histogram of a color cube with 5 bits per channel, and the palette
+   * colors are the mean colors of the pixels mapped to them.
+   *
+   * If \a paletteKey is not empty, the palette is cached for the images of the same key,
+   * e.g. the tiles of a layer set, which are then only mapped to the palette. Colors which
+   * are missing in the cached palette are added as long as it has less than \a nColors colors.
    */
-  void medianCut( QVector<QRgb> &colorTable, int nColors, const QImage &inputImage );
+  QImage quantizeImage( const QImage &inputImage, int nColors, const QString &paletteKey = QString() );
 
 } // namespace QgsWms
 
 #endif
-
-
@@ -56,6 +56,22 @@ namespace QgsWms
         return method == QgsServerRequest::GetMethod;
       }
 
+      bool allowConcurrentRequest( const QgsServerRequest &request ) const
+      {
+        // GetMap and GetFeatureInfo register their layers in the project of the request
+        // and use the layers cached for their thread. The other requests still use the
+        // configuration file path and the QgsProject::instance() singleton, like the DXF
+        // export, and are executed one at a time in the main thread
+        QgsServerRequest::Parameters params = request.parameters();
+        QString req = params.value( QStringLiteral( "REQUEST" ) );
+        if ( QSTR_COMPARE( req, "GetMap" ) )
+        {
+          QString format = params.value( QStringLiteral( "FORMAT" ) );
+          return !QSTR_COMPARE( format, "application/dxf" );
+        }
+        return QSTR_COMPARE( req, "GetFeatureInfo" );
+      }
+
       void executeRequest( const QgsServerRequest &request, QgsServerResponse &response,
                            const QgsProject *project )
       {
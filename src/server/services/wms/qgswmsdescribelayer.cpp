@@ -40,7 +40,7 @@ namespace QgsWms
     Q_UNUSED( version );
 
     QgsServerRequest::Parameters parameters = request.parameters();
-    QgsWmsConfigParser *configParser = getConfigParser( serverIface );
+    QgsWmsConfigParser *configParser = getConfigParser( serverIface, project );
 
     if ( !parameters.contains( QStringLiteral( "SLD_VERSION" ) ) )
     {
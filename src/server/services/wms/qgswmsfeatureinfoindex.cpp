@@ -0,0 +1,207 @@
+/***************************************************************************
+                qgswmsfeatureinfoindex.cpp
+                --------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*   This program is free software; you can redistribute it and/or modify  *
+*   it under the terms of the GNU General Public License as published by  *
+*   the Free Software Foundation; either version 2 of the License, or     *
+*   (at your option) any later version.                                   *
+*                                                                         *
+***************************************************************************/
+
+#include "qgswmsfeatureinfoindex.h"
+
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturerequest.h"
+#include "qgsmessagelog.h"
+#include "qgsserversettings.h"
+#include "qgsvectorlayer.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+namespace QgsWms
+{
+
+  namespace
+  {
+    //! Maximal number of vertices of the prepared geometries kept for a layer
+    const int MAX_PREPARED_VERTICES = 2000000;
+  }
+
+  QgsWmsFeatureInfoIndex *QgsWmsFeatureInfoIndex::instance( const QgsServerSettings &settings )
+  {
+    static QgsWmsFeatureInfoIndex *sInstance = settings.featureInfoIndexMaxFeatures() > 0 ?
+        new QgsWmsFeatureInfoIndex( settings.featureInfoIndexMaxFeatures() ) : nullptr;
+    return sInstance;
+  }
+
+  QgsWmsFeatureInfoIndex::QgsWmsFeatureInfoIndex( int maxFeatures )
+    : mMaxFeatures( maxFeatures )
+    , mMutex( QMutex::Recursive )
+  {
+  }
+
+  bool QgsWmsFeatureInfoIndex::intersects( QgsVectorLayer *layer, const QgsRectangle &rect, QgsFeatureIds &featureIds )
+  {
+    QMutexLocker locker( &mMutex );
+
+    LayerIndex *index = layerIndex( layer );
+    if ( !index->indexed || index->subsetString != layer->subsetString() )
+    {
+      return false;
+    }
+
+    featureIds.clear();
+    QList<QgsFeatureId> candidates = index->index.intersects( rect );
+    if ( candidates.isEmpty() )
+    {
+      return true;
+    }
+
+    // the bounding box of a single point is its geometry
+    if ( layer->geometryType() == QgsWkbTypes::PointGeometry && QgsWkbTypes::isSingleType( layer->wkbType() ) )
+    {
+      featureIds = candidates.toSet();
+      return true;
+    }
+
+    // fetch the geometries which are not prepared yet
+    QgsFeatureIds missingIds;
+    Q_FOREACH ( QgsFeatureId id, candidates )
+    {
+      if ( !index->geometries.contains( id ) )
+        missingIds << id;
+    }
+    if ( !missingIds.isEmpty() )
+    {
+      QgsFeatureRequest request;
+      request.setFilterFids( missingIds );
+      request.setSubsetOfAttributes( QgsAttributeList() );
+      QgsFeatureIterator fit = layer->getFeatures( request );
+      QgsFeature feature;
+      while ( fit.nextFeature( feature ) )
+      {
+        if ( !feature.hasGeometry() )
+          continue;
+
+        PreparedGeometry *prepared = new PreparedGeometry;
+        prepared->geometry = feature.geometry();
+        prepared->engine.reset( QgsGeometry::createGeometryEngine( prepared->geometry.geometry() ) );
+        prepared->engine->prepareGeometry();
+        index->geometries.insert( feature.id(), prepared, std::max( 1, prepared->geometry.geometry()->nCoordinates() ) );
+      }
+    }
+
+    QgsGeometry rectGeometry = QgsGeometry::fromRect( rect );
+    Q_FOREACH ( QgsFeatureId id, candidates )
+    {
+      PreparedGeometry *prepared = index->geometries.object( id );
+      if ( !prepared )
+      {
+        // no geometry, or already evicted from the cache by a larger geometry of this request
+        QgsFeature feature;
+        if ( layer->getFeatures( QgsFeatureRequest( id ).setSubsetOfAttributes( QgsAttributeList() ) ).nextFeature( feature )
+             && feature.hasGeometry() && feature.geometry().intersects( rectGeometry ) )
+        {
+          featureIds << id;
+        }
+        continue;
+      }
+
+      if ( prepared->engine->intersects( *rectGeometry.geometry() ) )
+      {
+        featureIds << id;
+      }
+    }
+    return true;
+  }
+
+  QgsWmsFeatureInfoIndex::LayerIndex *QgsWmsFeatureInfoIndex::layerIndex( QgsVectorLayer *layer )
+  {
+    LayerIndex *index = mLayers.value( layer );
+    if ( index && index->valid )
+    {
+      return index;
+    }
+
+    if ( !index )
+    {
+      index = new LayerIndex;
+      mLayers.insert( layer, index );
+
+      // the layer is deleted with its entry of the layer cache
+      index->connections << QObject::connect( layer, &QObject::destroyed, [this, layer]
+      {
+        removeLayer( layer );
+      } );
+      // editing or reloading the layer invalidates the index
+      auto invalidate = [this, layer]
+      {
+        QMutexLocker locker( &mMutex );
+        if ( LayerIndex *entry = mLayers.value( layer ) )
+          entry->valid = false;
+      };
+      index->connections << QObject::connect( layer, &QgsMapLayer::dataChanged, invalidate );
+      index->connections << QObject::connect( layer, &QgsVectorLayer::editingStopped, invalidate );
+    }
+
+    index->indexed = buildIndex( layer, index );
+    index->valid = true;
+    return index;
+  }
+
+  bool QgsWmsFeatureInfoIndex::buildIndex( QgsVectorLayer *layer, LayerIndex *index ) const
+  {
+    index->index = QgsSpatialIndex();
+    index->geometries.clear();
+    index->geometries.setMaxCost( MAX_PREPARED_VERTICES );
+    index->subsetString = layer->subsetString();
+
+    if ( layer->featureCount() > mMaxFeatures )
+    {
+      return false;
+    }
+
+    QgsFeatureRequest request;
+    request.setSubsetOfAttributes( QgsAttributeList() );
+    QgsFeatureIterator fit = layer->getFeatures( request );
+    QgsFeature feature;
+    int count = 0;
+    while ( fit.nextFeature( feature ) )
+    {
+      // the feature count of some providers is an estimate
+      if ( ++count > mMaxFeatures )
+      {
+        index->index = QgsSpatialIndex();
+        return false;
+      }
+      index->index.insertFeature( feature );
+    }
+
+    QgsMessageLog::logMessage( QStringLiteral( "Feature info index: indexed %1 features of layer '%2'" ).arg( count ).arg( layer->name() ),
+                               QStringLiteral( "Server" ), QgsMessageLog::INFO );
+    return true;
+  }
+
+  void QgsWmsFeatureInfoIndex::removeLayer( const QgsVectorLayer *layer )
+  {
+    QMutexLocker locker( &mMutex );
+    LayerIndex *index = mLayers.take( layer );
+    if ( index )
+    {
+      Q_FOREACH ( const QMetaObject::Connection &connection, index->connections )
+      {
+        QObject::disconnect( connection );
+      }
+      delete index;
+    }
+  }
+
+} // namespace QgsWms
@@ -0,0 +1,112 @@
+/***************************************************************************
+                qgswmsfeatureinfoindex.h
+                ------------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*   This program is free software; you can redistribute it and/or modify  *
+*   it under the terms of the GNU General Public License as published by  *
+*   the Free Software Foundation; either version 2 of the License, or     *
+*   (at your option) any later version.                                   *
+*                                                                         *
+***************************************************************************/
+
+#ifndef QGSWMSFEATUREINFOINDEX_H
+#define QGSWMSFEATUREINFOINDEX_H
+
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgsgeometryengine.h"
+#include "qgsspatialindex.h"
+
+#include <QCache>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include <memory>
+
+class QgsRectangle;
+class QgsServerSettings;
+class QgsVectorLayer;
+
+namespace QgsWms
+{
+
+  /** \ingroup server
+    * Spatial index of the vector layers queried by GetFeatureInfo requests.
+    *
+    * The index of a layer is built at the first request on the layer and kept as long as
+    * the layer lives, i.e. as long as its entry in QgsMSLayerCache. The geometries of the
+    * features found by the hit tests are kept prepared, so that the exact intersection
+    * test of a feature with a complex geometry is only expensive the first time.
+    *
+    * The index of a layer is discarded when the layer is edited or reloaded. Changes of the
+    * data made outside of the server are not detected.
+    * \since QGIS 3.0
+    */
+  class QgsWmsFeatureInfoIndex
+  {
+    public:
+
+      /** Returns the index configured by \a settings, or nullptr if the index is disabled.
+        */
+      static QgsWmsFeatureInfoIndex *instance( const QgsServerSettings &settings );
+
+      /** Searches the features of a layer intersecting a rectangle.
+        * \param layer the layer
+        * \param rect the rectangle in layer coordinates
+        * \param featureIds out: the identifiers of the features whose geometry intersects the rectangle
+        * \returns false if the layer cannot be searched with the index, e.g. because it
+        * has too many features or a subset string differing from the indexed one
+        */
+      bool intersects( QgsVectorLayer *layer, const QgsRectangle &rect, QgsFeatureIds &featureIds );
+
+    private:
+
+      //! Geometry of a feature prepared for repeated intersection tests
+      struct PreparedGeometry
+      {
+        QgsGeometry geometry;
+        std::unique_ptr< QgsGeometryEngine > engine;
+      };
+
+      //! Index of a layer
+      struct LayerIndex
+      {
+        //! False if the layer has too many features to be indexed
+        bool indexed = false;
+        //! False if the layer data has changed since the index was built
+        bool valid = true;
+        //! Subset string of the layer when the index was built
+        QString subsetString;
+        QgsSpatialIndex index;
+        //! Prepared geometries by feature id, the cost is the number of vertices
+        QCache< QgsFeatureId, PreparedGeometry > geometries;
+        QList< QMetaObject::Connection > connections;
+      };
+
+      explicit QgsWmsFeatureInfoIndex( int maxFeatures );
+
+      //! Returns the index of \a layer, building it if needed
+      LayerIndex *layerIndex( QgsVectorLayer *layer );
+
+      //! Builds the index of \a layer, returns false if the layer has too many features
+      bool buildIndex( QgsVectorLayer *layer, LayerIndex *index ) const;
+
+      //! Removes the index of \a layer
+      void removeLayer( const QgsVectorLayer *layer );
+
+      int mMaxFeatures;
+
+      QMutex mMutex;
+      QHash< const QgsVectorLayer *, LayerIndex * > mLayers;
+  };
+
+} // namespace QgsWms
+
+#endif
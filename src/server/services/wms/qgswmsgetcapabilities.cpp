@@ -21,6 +21,8 @@
 #include "qgswmsutils.h"
 #include "qgswmsgetcapabilities.h"
 #include "qgsserverprojectutils.h"
+#include "qgscapabilitiescache.h"
+#include "qgsservercompressor.h"
 
 #include "qgslayoutmanager.h"
 #include "qgscomposition.h"
@@ -29,9 +31,60 @@
 #include "qgscomposerhtml.h"
 #include "qgscomposerframe.h"
 
+#include <QLocale>
+
 
 namespace QgsWms
 {
+
+  namespace
+  {
+    const QString HTTP_DATE_FORMAT = QStringLiteral( "ddd, dd MMM yyyy hh:mm:ss 'GMT'" );
+
+    QString httpDate( const QDateTime &dateTime )
+    {
+      return QLocale::c().toString( dateTime.toUTC(), HTTP_DATE_FORMAT );
+    }
+
+    /** Returns the entity tag of the encoding of the capabilities sent to the client,
+     * a strong entity tag must differ between the identity and gzip encoded contents
+     */
+    QByteArray encodingEtag( const QByteArray &etag, bool gzip )
+    {
+      if ( !gzip || !etag.endsWith( '"' ) )
+        return etag;
+      return etag.left( etag.size() - 1 ) + "-gzip\"";
+    }
+
+    //! Returns true if the client has the current version of the capabilities
+    bool notModified( const QgsServerRequest &request, const QByteArray &etag, const QDateTime &lastModified )
+    {
+      // If-Modified-Since is ignored when If-None-Match is sent
+      QString ifNoneMatch = request.header( QStringLiteral( "If-None-Match" ) );
+      if ( !ifNoneMatch.isEmpty() )
+      {
+        Q_FOREACH ( QString requestEtag, ifNoneMatch.split( ',' ) )
+        {
+          requestEtag = requestEtag.trimmed();
+          if ( requestEtag.startsWith( QLatin1String( "W/" ) ) )
+            requestEtag = requestEtag.mid( 2 );
+          if ( requestEtag == QLatin1String( "*" ) || requestEtag.toLatin1() == etag )
+            return true;
+        }
+        return false;
+      }
+
+      QString ifModifiedSince = request.header( QStringLiteral( "If-Modified-Since" ) );
+      if ( !ifModifiedSince.isEmpty() )
+      {
+        QDateTime since = QLocale::c().toDateTime( ifModifiedSince.trimmed(), HTTP_DATE_FORMAT );
+        since.setTimeSpec( Qt::UTC );
+        return since.isValid() && lastModified <= since;
+      }
+      return false;
+    }
+  }
+
   void writeGetCapabilities( QgsServerInterface *serverIface, const QgsProject *project,
                              const QString &version, const QgsServerRequest &request,
                              QgsServerResponse &response, bool projectSettings )
@@ -50,24 +103,31 @@ namespace QgsWms
       cache = accessControl->fillCacheKey( cacheKeyList );
 #endif
 
-    QDomDocument doc;
+    bool gzip = QgsServerCompressor::acceptedEncoding( request.header( QStringLiteral( "Accept-Encoding" ) ) ) == QgsServerCompressor::Gzip;
     QString cacheKey = cacheKeyList.join( QStringLiteral( "-" ) );
-    const QDomDocument *capabilitiesDocument = capabilitiesCache->searchCapabilitiesDocument( configFilePath, cacheKey );
-    if ( !capabilitiesDocument ) //capabilities xml not in cache. Create a new one
+    QgsCapabilitiesCache::CapabilitiesResponse capabilities;
+    if ( !capabilitiesCache->searchCapabilitiesResponse( configFilePath, cacheKey, capabilities ) ) //capabilities xml not in cache. Create a new one
     {
-      QgsMessageLog::logMessage( QStringLiteral( "Capabilities document not found in cache" ) );
-
-      doc = getCapabilities( serverIface, project, version, request, projectSettings );
+      // a document inserted in cache by a plugin is served, otherwise a new one is created
+      const QDomDocument *capabilitiesDocument = cache ? capabilitiesCache->searchCapabilitiesDocument( configFilePath, cacheKey ) : nullptr;
+      QDomDocument doc;
+      if ( capabilitiesDocument )
+      {
+        doc = *capabilitiesDocument;
+      }
+      else
+      {
+        QgsMessageLog::logMessage( QStringLiteral( "Capabilities document not found in cache" ) );
+        doc = getCapabilities( serverIface, project, version, request, projectSettings );
+      }
 
       if ( cache )
       {
-        capabilitiesCache->insertCapabilitiesDocument( configFilePath, cacheKey, &doc );
-        capabilitiesDocument = capabilitiesCache->searchCapabilitiesDocument( configFilePath, cacheKey );
+        capabilities = capabilitiesCache->insertCapabilitiesResponse( configFilePath, cacheKey, doc );
       }
       else
       {
-        doc = doc.cloneNode().toDocument();
-        capabilitiesDocument = &doc;
+        capabilities = QgsCapabilitiesCache::encodeCapabilitiesDocument( doc, gzip );
       }
     }
     else
@@ -76,7 +136,32 @@ namespace QgsWms
     }
 
     response.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "text/xml; charset=utf-8" ) );
-    response.write( capabilitiesDocument->toByteArray() );
+    gzip = gzip && !capabilities.gzipContent.isEmpty();
+
+    // the validators of the documents which are not cached change at each request
+    if ( cache && serverIface->serverSettings()->capabilitiesConditionalRequests() )
+    {
+      QByteArray etag = encodingEtag( capabilities.etag, gzip );
+      response.setHeader( QStringLiteral( "ETag" ), QString::fromLatin1( etag ) );
+      response.setHeader( QStringLiteral( "Last-Modified" ), httpDate( capabilities.lastModified ) );
+      response.setHeader( QStringLiteral( "Vary" ), QStringLiteral( "Accept-Encoding" ) );
+      if ( notModified( request, etag, capabilities.lastModified ) )
+      {
+        response.setStatusCode( 304 );
+        return;
+      }
+    }
+
+    if ( gzip )
+    {
+      response.setHeader( QStringLiteral( "Content-Encoding" ), QStringLiteral( "gzip" ) );
+      response.setHeader( QStringLiteral( "Vary" ), QStringLiteral( "Accept-Encoding" ) );
+      response.write( capabilities.gzipContent );
+    }
+    else
+    {
+      response.write( capabilities.content );
+    }
   }
 
   QDomDocument getCapabilities( QgsServerInterface *serverIface, const QgsProject *project,
@@ -86,7 +171,7 @@ namespace QgsWms
     QDomDocument doc;
     QDomElement wmsCapabilitiesElement;
 
-    QgsWmsConfigParser *configParser = getConfigParser( serverIface );
+    QgsWmsConfigParser *configParser = getConfigParser( serverIface, project );
 
     QgsServerRequest::Parameters parameters = request.parameters();
 
@@ -40,7 +40,7 @@ namespace QgsWms
   {
     Q_UNUSED( version );
 
-    QgsWmsConfigParser  *configParser = getConfigParser( serverIface );
+    QgsWmsConfigParser  *configParser = getConfigParser( serverIface, project );
 
     QDomDocument doc;
     QDomProcessingInstruction xmlDeclaration = doc.createProcessingInstruction( QStringLiteral( "xml" ),
@@ -21,6 +21,10 @@
 #include "qgswmsutils.h"
 #include "qgswmsgetmap.h"
 #include "qgswmsrenderer.h"
+#include "qgswmstilecache.h"
+#include "qgsproject.h"
+#include "qgsservermetrics.h"
+#include "qgsserversettings.h"
 
 #include <QImage>
 
@@ -34,13 +38,35 @@ namespace QgsWms
     Q_UNUSED( version );
 
     QgsServerRequest::Parameters params = request.parameters();
-    QgsRenderer renderer( serverIface, project, params, getConfigParser( serverIface ) );
+    QgsWmsConfigParser *configParser = getConfigParser( serverIface, project );
 
-    std::unique_ptr<QImage> result( renderer.getMap() );
+    // tiled requests are rendered as metatiles when the tile cache is enabled,
+    // which builds a renderer only when the tiles are not in the cache
+    std::unique_ptr<QImage> result;
+    QgsWmsTileCache *tileCache = QgsWmsTileCache::instance( *serverIface->serverSettings() );
+    if ( tileCache )
+    {
+      result.reset( tileCache->getMap( serverIface, project, params ) );
+    }
+    else
+    {
+      QgsRenderer renderer( serverIface, project, params, configParser );
+      result.reset( renderer.getMap() );
+    }
     if ( result )
     {
       QString format = params.value( QStringLiteral( "FORMAT" ), QStringLiteral( "PNG" ) );
-      writeImage( response, *result, format, renderer.getImageQuality() );
+
+      // the images of a layer set share the same 8 bit palette
+      QString paletteKey;
+      if ( serverIface->serverSettings()->png8PaletteCache() )
+      {
+        paletteKey = ( QStringList() << project->fileName()
+                       << params.value( QStringLiteral( "LAYERS" ) )
+                       << params.value( QStringLiteral( "STYLES" ) ) ).join( QStringLiteral( "\n" ) );
+      }
+      QgsServerMetrics::StageTimer stage( QStringLiteral( "encode" ) );
+      writeImage( response, *result, format, imageQuality( configParser, params ), paletteKey );
     }
     else
     {
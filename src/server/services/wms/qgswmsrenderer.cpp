@@ -20,6 +20,7 @@
 
 #include "qgswmsutils.h"
 #include "qgswmsrenderer.h"
+#include "qgswmsfeatureinfoindex.h"
 #include "qgsfilterrestorer.h"
 #include "qgscapabilitiescache.h"
 #include "qgscsexception.h"
@@ -57,6 +58,8 @@
 #include "qgsmaprendererjobproxy.h"
 #include "qgswmsserviceexception.h"
 #include "qgsserverprojectutils.h"
+#include "qgsservermetrics.h"
+#include "qgsserverrequestproject.h"
 #include "qgsgui.h"
 
 #include <QImage>
@@ -66,8 +69,12 @@
 #include <QTextStream>
 #include <QDir>
 
+#include <vector>
+
 //for printing
 #include "qgscomposition.h"
+#include "qgscomposermap.h"
+#include "qgsmaprendererparalleljob.h"
 #include <QBuffer>
 #include <QPrinter>
 #include <QSvgGenerator>
@@ -235,7 +242,7 @@ namespace QgsWms
     Q_FOREACH ( const QString &layerId, layerIds )
     {
       // get layer
-      QgsMapLayer *ml = QgsProject::instance()->mapLayer( layerId );
+      QgsMapLayer *ml = QgsServerRequestProject::current()->mapLayer( layerId );
       // create tree layer node
       QgsLayerTreeLayer *layer = rootGroup.addLayer( ml );
       // store the layer's name
@@ -335,7 +342,7 @@ namespace QgsWms
         legendNode->drawSymbol( legendSettings, &ctx, itemHeight );
       }
 
-      QgsProject::instance()->removeAllMapLayers();
+      QgsServerRequestProject::current()->removeAllMapLayers();
       return paintImage;
     }
 
@@ -392,11 +399,11 @@ namespace QgsWms
     // reset layers' name
     Q_FOREACH ( const QString &layerId, layerIds )
     {
-      QgsMapLayer *ml = QgsProject::instance()->mapLayer( layerId );
+      QgsMapLayer *ml = QgsServerRequestProject::current()->mapLayer( layerId );
       ml->setName( layerNameMap[ layerId ] );
     }
     //  clear map layer registry
-    QgsProject::instance()->removeAllMapLayers();
+    QgsServerRequestProject::current()->removeAllMapLayers();
     return paintImage;
   }
 
@@ -407,7 +414,7 @@ namespace QgsWms
 
     Q_FOREACH ( const QString &layerID, mapSettings.layerIds() )
     {
-      QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( QgsProject::instance()->mapLayer( layerID ) );
+      QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( QgsServerRequestProject::current()->mapLayer( layerID ) );
       if ( !vl || !vl->renderer() )
         continue;
 
@@ -560,7 +567,7 @@ namespace QgsWms
     delete image;
 
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
-    Q_FOREACH ( QgsMapLayer *layer, QgsProject::instance()->mapLayers() )
+    Q_FOREACH ( QgsMapLayer *layer, QgsServerRequestProject::current()->mapLayers() )
     {
       if ( !mAccessControl->layerReadPermission( layer ) )
       {
@@ -609,6 +616,15 @@ namespace QgsWms
     QByteArray *ba = nullptr;
     c->setPlotStyle( QgsComposition::Print );
 
+    // raster outputs only print the first page, the vector outputs keep the maps as vectors
+    bool rasterOutput = formatString.compare( QLatin1String( "png" ), Qt::CaseInsensitive ) == 0
+                        || formatString.compare( QLatin1String( "jpg" ), Qt::CaseInsensitive ) == 0
+                        || ( formatString.compare( QLatin1String( "svg" ), Qt::CaseInsensitive ) == 0 && c->printAsRaster() );
+    if ( rasterOutput && mSettings.parallelRendering() )
+    {
+      prerenderComposerMaps( c );
+    }
+
     //SVG export without a running X-Server is a problem. See e.g. http://developer.qt.nokia.com/forums/viewthread/2038
     if ( formatString.compare( QLatin1String( "svg" ), Qt::CaseInsensitive ) == 0 )
     {
@@ -675,6 +691,54 @@ namespace QgsWms
     return ba;
   }
 
+  void QgsRenderer::prerenderComposerMaps( QgsComposition *composition ) const
+  {
+    QgsServerMetrics::StageTimer stage( QStringLiteral( "render" ) );
+
+    int dpi = composition->printResolution();
+    QList<QgsComposerMap *> maps;
+    composition->composerItemsOnPage( maps, 0 );
+
+    QList<QgsComposerMap *> prerenderedMaps;
+    std::vector< std::unique_ptr< QgsMapRendererParallelJob > > jobs;
+    Q_FOREACH ( QgsComposerMap *map, maps )
+    {
+      QgsMapSettings settings = map->printMapSettings( dpi );
+      if ( settings.outputSize().isEmpty() )
+        continue;
+
+      // blending modes are applied to the page when the map is rendered on it
+      bool blending = false;
+      Q_FOREACH ( QgsMapLayer *layer, settings.layers() )
+      {
+        QgsVectorLayer *vectorLayer = qobject_cast<QgsVectorLayer *>( layer );
+        if ( layer->blendMode() != QPainter::CompositionMode_SourceOver
+             || ( vectorLayer && vectorLayer->featureBlendMode() != QPainter::CompositionMode_SourceOver ) )
+        {
+          blending = true;
+          break;
+        }
+      }
+      if ( blending )
+        continue;
+
+      // all the maps are rendered at the same time, each one with its layers in parallel
+      std::unique_ptr< QgsMapRendererParallelJob > job( new QgsMapRendererParallelJob( settings ) );
+      job->start();
+      jobs.push_back( std::move( job ) );
+      prerenderedMaps << map;
+    }
+
+    for ( int i = 0; i < prerenderedMaps.size(); ++i )
+    {
+      QgsMapRendererParallelJob *job = jobs[i].get();
+      job->waitForFinished();
+      // the layers are rendered by other threads, their timings are reported by the thread of the request
+      QgsServerMetrics::addLayerRenderings( *job );
+      prerenderedMaps[i]->setPrerenderedImage( job->renderedImage(), *prerenderedMaps[i]->currentMapExtent(), dpi );
+    }
+  }
+
 #if 0
   QImage *QgsWMSServer::printCompositionToImage( QgsComposition *c ) const
   {
@@ -707,25 +771,33 @@ namespace QgsWms
                                     QStringLiteral( "The requested map size is too large" ) );
     }
     QStringList layersList, stylesList, layerIdList;
-    QImage *image = initializeRendering( layersList, stylesList, layerIdList, mapSettings );
+    QImage *image = nullptr;
+    QStringList highlightLayersId;
+    {
+      QgsServerMetrics::StageTimer stage( QStringLiteral( "layers" ) );
+      image = initializeRendering( layersList, stylesList, layerIdList, mapSettings );
 
-    QStringList layerSetIds = mapSettings.layerIds();
+      QStringList layerSetIds = mapSettings.layerIds();
 
-    QStringList highlightLayersId = QgsWmsConfigParser::addHighlightLayers( mParameters, layerSetIds );
+      highlightLayersId = QgsWmsConfigParser::addHighlightLayers( mParameters, layerSetIds );
 
-    QList<QgsMapLayer *>  layerSet;
-    Q_FOREACH ( QString layerSetId, layerSetIds )
-    {
-      layerSet.append( QgsProject::instance()->mapLayer( layerSetId ) );
+      QList<QgsMapLayer *>  layerSet;
+      Q_FOREACH ( QString layerSetId, layerSetIds )
+      {
+        layerSet.append( QgsServerRequestProject::current()->mapLayer( layerSetId ) );
+      }
+      mapSettings.setLayers( layerSet );
     }
-    mapSettings.setLayers( layerSet );
 
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
-    Q_FOREACH ( QgsMapLayer *layer, QgsProject::instance()->mapLayers() )
     {
-      if ( !mAccessControl->layerReadPermission( layer ) )
+      QgsServerMetrics::StageTimer stage( QStringLiteral( "access_control" ) );
+      Q_FOREACH ( QgsMapLayer *layer, QgsServerRequestProject::current()->mapLayers() )
       {
-        throw QgsSecurityException( QStringLiteral( "You are not allowed to access to the layer: %1" ).arg( layer->name() ) );
+        if ( !mAccessControl->layerReadPermission( layer ) )
+        {
+          throw QgsSecurityException( QStringLiteral( "You are not allowed to access to the layer: %1" ).arg( layer->name() ) );
+        }
       }
     }
 #endif
@@ -758,8 +830,12 @@ namespace QgsWms
     else
     {
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
-      mAccessControl->resolveFilterFeatures( mapSettings.layers() );
+      {
+        QgsServerMetrics::StageTimer stage( QStringLiteral( "access_control" ) );
+        mAccessControl->resolveFilterFeatures( mapSettings.layers() );
+      }
 #endif
+      QgsServerMetrics::StageTimer stage( QStringLiteral( "render" ) );
       QgsMapRendererJobProxy renderJob( mSettings.parallelRendering(), mSettings.maxThreads(), mAccessControl );
       renderJob.render( mapSettings, image );
       painter.reset( renderJob.takePainter() );
@@ -776,7 +852,7 @@ namespace QgsWms
     QgsWmsConfigParser::removeHighlightLayers( highlightLayersId );
 
     if ( !hitTest )
-      QgsProject::instance()->removeAllMapLayers();
+      QgsServerRequestProject::current()->removeAllMapLayers();
 
     painter->end();
 
@@ -982,7 +1058,7 @@ namespace QgsWms
         {
           continue;
         }
-        QgsMapLayer *registeredMapLayer = QgsProject::instance()->mapLayer( currentLayer->id() );
+        QgsMapLayer *registeredMapLayer = QgsServerRequestProject::current()->mapLayer( currentLayer->id() );
         if ( registeredMapLayer )
         {
           currentLayer = registeredMapLayer;
@@ -1113,7 +1189,7 @@ namespace QgsWms
     //force restoration of original filters
     filterRestorer.reset();
 
-    QgsProject::instance()->removeAllMapLayers();
+    QgsServerRequestProject::current()->removeAllMapLayers();
 
     return result;
   }
@@ -1166,7 +1242,7 @@ namespace QgsWms
     QList<QgsMapLayer *>  layers;
     Q_FOREACH ( QString layerId, layerIdList )
     {
-      layers.append( QgsProject::instance()->mapLayer( layerId ) );
+      layers.append( QgsServerRequestProject::current()->mapLayer( layerId ) );
     }
     mapSettings.setLayers( layers );
 
@@ -1485,6 +1561,27 @@ namespace QgsWms
     fReq.setSubsetOfAttributes( attributes, layer->pendingFields() );
 #endif
 
+    //serve the hit test of the info point from the feature info index if the layer is not filtered by the request
+    QgsFeatureIds indexedFeatureIds;
+    bool indexed = false;
+    if ( infoPoint && !searchRect.isEmpty() && layer->wkbType() != QgsWkbTypes::NoGeometry
+         && mParameters.value( QStringLiteral( "FILTER" ) ).isEmpty() )
+    {
+      QgsWmsFeatureInfoIndex *featureInfoIndex = QgsWmsFeatureInfoIndex::instance( mSettings );
+      indexed = featureInfoIndex && featureInfoIndex->intersects( layer, searchRect, indexedFeatureIds );
+    }
+    if ( indexed )
+    {
+      if ( indexedFeatureIds.isEmpty() )
+      {
+        return true;
+      }
+
+      //the intersection test is already done. The features are still fetched with the search
+      //rectangle rather than by id, so that FEATURE_COUNT keeps the first features in provider order
+      fReq.setFlags( fReq.flags() & ~ QgsFeatureRequest::ExactIntersect );
+    }
+
     QgsFeatureIterator fit = layer->getFeatures( fReq );
     QgsFeatureRenderer *r2 = layer->renderer();
     if ( r2 )
@@ -1500,6 +1597,11 @@ namespace QgsWms
         break;
       }
 
+      if ( indexed && !indexedFeatureIds.contains( feature.id() ) )
+      {
+        continue;
+      }
+
       ++featureCounter;
       if ( featureCounter > nFeatures )
       {
@@ -1787,7 +1889,7 @@ namespace QgsWms
                ( mapLayer->minimumScale() <= scaleDenominator && mapLayer->maximumScale() >= scaleDenominator ) )
           {
             layerKeys.push_front( mapLayer->id() );
-            QgsProject::instance()->addMapLayers(
+            QgsServerRequestProject::current()->addMapLayers(
               QList<QgsMapLayer *>() << mapLayer, false, false );
           }
         }
@@ -1843,7 +1945,7 @@ namespace QgsWms
         //we need to find the maplayer objects matching the layer name
         QList<QgsMapLayer *> layersToFilter;
 
-        Q_FOREACH ( QgsMapLayer *layer, QgsProject::instance()->mapLayers() )
+        Q_FOREACH ( QgsMapLayer *layer, QgsServerRequestProject::current()->mapLayers() )
         {
           if ( layer )
           {
@@ -1905,9 +2007,10 @@ namespace QgsWms
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   void QgsRenderer::applyAccessControlLayersFilters( const QStringList &layerList, QHash<QgsMapLayer *, QString> &originalLayerFilters ) const
   {
+    QgsServerMetrics::StageTimer stage( QStringLiteral( "access_control" ) );
     Q_FOREACH ( const QString &layerName, layerList )
     {
-      QList<QgsMapLayer *> mapLayers = QgsProject::instance()->mapLayersByName( layerName );
+      QList<QgsMapLayer *> mapLayers = QgsServerRequestProject::current()->mapLayersByName( layerName );
       Q_FOREACH ( QgsMapLayer *mapLayer, mapLayers )
       {
         QgsOWSServerFilterRestorer::applyAccessControlLayerFilters( mAccessControl, mapLayer, originalLayerFilters );
@@ -2068,7 +2171,7 @@ namespace QgsWms
       QString layerName = layerIdSplit.at( 0 );
       QgsVectorLayer *vLayer = nullptr;
 
-      Q_FOREACH ( QgsMapLayer *layer, QgsProject::instance()->mapLayers() )
+      Q_FOREACH ( QgsMapLayer *layer, QgsServerRequestProject::current()->mapLayers() )
       {
         if ( layer )
         {
@@ -2108,7 +2211,7 @@ namespace QgsWms
 
   void QgsRenderer::clearFeatureSelections( const QStringList &layerIds ) const
   {
-    const QMap<QString, QgsMapLayer *> &layerMap = QgsProject::instance()->mapLayers();
+    const QMap<QString, QgsMapLayer *> &layerMap = QgsServerRequestProject::current()->mapLayers();
 
     Q_FOREACH ( const QString &id, layerIds )
     {
@@ -2325,7 +2428,7 @@ namespace QgsWms
         QString currentLayerId = currentLayerElem.attribute( QStringLiteral( "id" ) );
         if ( !currentLayerId.isEmpty() )
         {
-          QgsMapLayer *currentLayer = QgsProject::instance()->mapLayer( currentLayerId );
+          QgsMapLayer *currentLayer = QgsServerRequestProject::current()->mapLayer( currentLayerId );
           if ( currentLayer )
           {
             QString WMSPropertyAttributesString = currentLayer->customProperty( QStringLiteral( "WMSPropertyAttributes" ) ).toString();
@@ -2413,7 +2516,7 @@ namespace QgsWms
 
     QgsExpressionContext expressionContext;
     expressionContext << QgsExpressionContextUtils::globalScope()
-                      << QgsExpressionContextUtils::projectScope( QgsProject::instance() );
+                      << QgsExpressionContextUtils::projectScope( mProject );
     if ( layer )
       expressionContext << QgsExpressionContextUtils::layerScope( layer );
     expressionContext.setFeature( *feat );
@@ -2547,22 +2650,7 @@ namespace QgsWms
 
   int QgsRenderer::getImageQuality() const
   {
-
-    // First taken from QGIS project
-    int imageQuality = mConfigParser->imageQuality();
-
-    // Then checks if a parameter is given, if so use it instead
-    if ( mParameters.contains( QStringLiteral( "IMAGE_QUALITY" ) ) )
-    {
-      bool conversionSuccess;
-      int imageQualityParameter;
-      imageQualityParameter = mParameters[ QStringLiteral( "IMAGE_QUALITY" )].toInt( &conversionSuccess );
-      if ( conversionSuccess )
-      {
-        imageQuality = imageQualityParameter;
-      }
-    }
-    return imageQuality;
+    return imageQuality( mConfigParser, mParameters );
   }
 
   int QgsRenderer::getWMSPrecision( int defaultValue = 8 ) const
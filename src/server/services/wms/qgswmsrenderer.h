@@ -208,6 +208,10 @@ namespace QgsWms
       //! Clear all feature selections in the given layers
       void clearFeatureSelections( const QStringList &layerIds ) const;
 
+      /** Renders the maps of the first page of a composition concurrently, so that printing the page
+        as a raster image only draws the prerendered images of the maps*/
+      void prerenderComposerMaps( QgsComposition *composition ) const;
+
       //! Applies opacity on layer/group level
       void applyOpacities( const QStringList &layerList, QList< QPair< QgsVectorLayer *, QgsFeatureRenderer *> > &vectorRenderers,
                            QList< QPair< QgsRasterLayer *, QgsRasterRenderer * > > &rasterRenderers,
@@ -0,0 +1,290 @@
+/***************************************************************************
+                              qgswmstilecache.cpp
+                              -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswmstilecache.h"
+#include "qgswmsrenderer.h"
+#include "qgswmsutils.h"
+
+#include "qgsaccesscontrol.h"
+#include "qgsconfigcache.h"
+#include "qgscoordinatereferencesystem.h"
+#include "qgsmessagelog.h"
+#include "qgsproject.h"
+#include "qgsserverinterface.h"
+#include "qgsserverprojectutils.h"
+#include "qgsserversettings.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace QgsWms
+{
+
+  namespace
+  {
+    //! Largest WIDTH and HEIGHT of the requests considered as tiles
+    const int MAX_TILE_SIZE = 1024;
+
+    //! Maximal distance of the BBOX to the grid, as a fraction of the tile size
+    const double GRID_TOLERANCE = 1e-4;
+
+    QString hash( const QString &value )
+    {
+      return QString::fromLatin1( QCryptographicHash::hash( value.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+    }
+
+    QString tileKey( const QString &projectPath, const QString &gridKey, qint64 firstAxisIndex, qint64 secondAxisIndex )
+    {
+      return QStringLiteral( "%1\n%2\n%3,%4" ).arg( projectPath, gridKey ).arg( firstAxisIndex ).arg( secondAxisIndex );
+    }
+  }
+
+  QgsWmsTileCache *QgsWmsTileCache::instance( const QgsServerSettings &settings )
+  {
+    static QgsWmsTileCache *sInstance = settings.tileCacheSize() > 0 ?
+                                        new QgsWmsTileCache( settings.tileCacheSize(), settings.tileCacheDirectory(), settings.metatileSize() ) : nullptr;
+    return sInstance;
+  }
+
+  QgsWmsTileCache::QgsWmsTileCache( qint64 size, const QString &directory, int metatileSize )
+    : mDirectory( directory )
+    , mMetatileSize( std::max( 1, metatileSize ) )
+    , mTiles( static_cast< int >( std::min< qint64 >( size / 1024, std::numeric_limits< int >::max() ) ) )
+  {
+    QObject::connect( QgsConfigCache::instance(), &QgsConfigCache::entryRemoved, [this]( const QString & path )
+    {
+      removeProject( path );
+    } );
+  }
+
+  QImage *QgsWmsTileCache::getMap( QgsServerInterface *serverIface, const QgsProject *project, const QgsServerRequest::Parameters &parameters )
+  {
+    TileGrid grid;
+    QStringList cacheKeyList;
+    bool cache = tileGrid( parameters, grid );
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+    QgsAccessControl *accessControl = serverIface->accessControls();
+    if ( cache && accessControl )
+      cache = accessControl->fillCacheKey( cacheKeyList );
+#endif
+
+    if ( !cache )
+    {
+      QgsRenderer renderer( serverIface, project, parameters, getConfigParser( serverIface, project ) );
+      return renderer.getMap();
+    }
+
+    // all the parameters but the BBOX define the grid
+    QgsServerRequest::Parameters gridParameters = parameters;
+    gridParameters.remove( QStringLiteral( "BBOX" ) );
+    for ( auto it = gridParameters.constBegin(); it != gridParameters.constEnd(); ++it )
+    {
+      cacheKeyList << it.key() + '=' + it.value();
+    }
+    cacheKeyList << QString::number( grid.firstAxisSize, 'g', 12 ) << QString::number( grid.secondAxisSize, 'g', 12 );
+    QString gridKey = cacheKeyList.join( QStringLiteral( "&" ) );
+
+    QString projectPath = project->fileName();
+    QImage tile = cachedTile( projectPath, tileKey( projectPath, gridKey, grid.firstAxisIndex, grid.secondAxisIndex ) );
+    if ( tile.isNull() )
+    {
+      tile = renderMetatile( serverIface, project, parameters, grid, gridKey );
+      if ( tile.isNull() )
+        return nullptr;
+    }
+    return new QImage( tile );
+  }
+
+  bool QgsWmsTileCache::tileGrid( const QgsServerRequest::Parameters &parameters, TileGrid &grid )
+  {
+    int width = parameters.value( QStringLiteral( "WIDTH" ) ).toInt();
+    int height = parameters.value( QStringLiteral( "HEIGHT" ) ).toInt();
+    if ( width <= 0 || height <= 0 || width > MAX_TILE_SIZE || height > MAX_TILE_SIZE )
+      return false;
+
+    QgsRectangle bbox = parseBbox( parameters.value( QStringLiteral( "BBOX" ) ) );
+    if ( bbox.isEmpty() )
+      return false;
+
+    // the BBOX is aligned on a grid of tiles starting at the origin of the CRS
+    grid.firstAxisSize = bbox.width();
+    grid.secondAxisSize = bbox.height();
+    double firstAxisIndex = bbox.xMinimum() / grid.firstAxisSize;
+    double secondAxisIndex = bbox.yMinimum() / grid.secondAxisSize;
+    if ( std::fabs( firstAxisIndex - std::round( firstAxisIndex ) ) > GRID_TOLERANCE
+         || std::fabs( secondAxisIndex - std::round( secondAxisIndex ) ) > GRID_TOLERANCE )
+      return false;
+    grid.firstAxisIndex = static_cast< qint64 >( std::round( firstAxisIndex ) );
+    grid.secondAxisIndex = static_cast< qint64 >( std::round( secondAxisIndex ) );
+
+    // same axis order as QgsRenderer::configureMapSettings()
+    QString crs = parameters.value( QStringLiteral( "CRS" ), parameters.value( QStringLiteral( "SRS" ) ) );
+    bool crs84 = crs.compare( QLatin1String( "CRS:84" ), Qt::CaseInsensitive ) == 0;
+    QgsCoordinateReferenceSystem outputCrs = QgsCoordinateReferenceSystem::fromOgcWmsCrs( crs84 ? QStringLiteral( "EPSG:4326" ) : crs );
+    if ( !outputCrs.isValid() )
+      return false;
+    QString version = parameters.value( QStringLiteral( "VERSION" ), QStringLiteral( "1.3.0" ) );
+    grid.invertedAxis = crs84 != ( version != QLatin1String( "1.1.1" ) && outputCrs.hasAxisInverted() );
+    return true;
+  }
+
+  QImage QgsWmsTileCache::renderMetatile( QgsServerInterface *serverIface, const QgsProject *project, const QgsServerRequest::Parameters &parameters,
+                                          const TileGrid &grid, const QString &gridKey )
+  {
+    int width = parameters.value( QStringLiteral( "WIDTH" ) ).toInt();
+    int height = parameters.value( QStringLiteral( "HEIGHT" ) ).toInt();
+
+    // the metatile must respect the maximum size of the project
+    int metatileSize = mMetatileSize;
+    int maxWidth = QgsServerProjectUtils::wmsMaxWidth( *project );
+    int maxHeight = QgsServerProjectUtils::wmsMaxHeight( *project );
+    while ( metatileSize > 1 && ( ( maxWidth != -1 && metatileSize * width > maxWidth ) || ( maxHeight != -1 && metatileSize * height > maxHeight ) ) )
+    {
+      --metatileSize;
+    }
+
+    // first tile of the metatile along each axis
+    qint64 firstAxisStart = static_cast< qint64 >( std::floor( static_cast< double >( grid.firstAxisIndex ) / metatileSize ) ) * metatileSize;
+    qint64 secondAxisStart = static_cast< qint64 >( std::floor( static_cast< double >( grid.secondAxisIndex ) / metatileSize ) ) * metatileSize;
+
+    QgsServerRequest::Parameters metatileParameters = parameters;
+    metatileParameters.insert( QStringLiteral( "WIDTH" ), QString::number( width * metatileSize ) );
+    metatileParameters.insert( QStringLiteral( "HEIGHT" ), QString::number( height * metatileSize ) );
+    metatileParameters.insert( QStringLiteral( "BBOX" ), QStringLiteral( "%1,%2,%3,%4" )
+                               .arg( qgsDoubleToString( firstAxisStart * grid.firstAxisSize ),
+                                     qgsDoubleToString( secondAxisStart * grid.secondAxisSize ),
+                                     qgsDoubleToString( ( firstAxisStart + metatileSize ) * grid.firstAxisSize ),
+                                     qgsDoubleToString( ( secondAxisStart + metatileSize ) * grid.secondAxisSize ) ) );
+
+    QgsRenderer renderer( serverIface, project, metatileParameters, getConfigParser( serverIface, project ) );
+    std::unique_ptr< QImage > metatile( renderer.getMap() );
+    if ( !metatile )
+      return QImage();
+
+    // slice the metatile, the rows of the image go down along the vertical axis
+    QString projectPath = project->fileName();
+    QImage requestedTile;
+    for ( int i = 0; i < metatileSize; ++i )
+    {
+      for ( int j = 0; j < metatileSize; ++j )
+      {
+        int column = grid.invertedAxis ? j : i;
+        int row = metatileSize - 1 - ( grid.invertedAxis ? i : j );
+        QImage tile = metatile->copy( column * width, row * height, width, height );
+        insertTile( projectPath, tileKey( projectPath, gridKey, firstAxisStart + i, secondAxisStart + j ), tile );
+        if ( firstAxisStart + i == grid.firstAxisIndex && secondAxisStart + j == grid.secondAxisIndex )
+          requestedTile = tile;
+      }
+    }
+    return requestedTile;
+  }
+
+  QImage QgsWmsTileCache::cachedTile( const QString &projectPath, const QString &key )
+  {
+    {
+      QMutexLocker locker( &mMutex );
+      QImage *tile = mTiles.object( key );
+      if ( tile )
+        return *tile;
+    }
+
+    if ( mDirectory.isEmpty() )
+      return QImage();
+
+    // tiles stored before a change of the project are obsolete
+    QString filePath = tileFilePath( projectPath, key );
+    QFileInfo tileInfo( filePath );
+    if ( !tileInfo.exists() )
+      return QImage();
+    if ( tileInfo.lastModified() < QFileInfo( projectPath ).lastModified() )
+    {
+      QFile::remove( filePath );
+      return QImage();
+    }
+
+    QImage tile( filePath );
+    if ( !tile.isNull() )
+    {
+      QMutexLocker locker( &mMutex );
+      mTiles.insert( key, new QImage( tile ), std::max( 1, tile.byteCount() / 1024 ) );
+    }
+    return tile;
+  }
+
+  void QgsWmsTileCache::insertTile( const QString &projectPath, const QString &key, const QImage &tile )
+  {
+    {
+      QMutexLocker locker( &mMutex );
+      mTiles.insert( key, new QImage( tile ), std::max( 1, tile.byteCount() / 1024 ) );
+    }
+
+    if ( mDirectory.isEmpty() )
+      return;
+
+    QString directory = projectDirectory( projectPath );
+    if ( !QDir().mkpath( directory ) )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Cannot create the tile cache directory %1" ).arg( directory ), QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+      return;
+    }
+
+    // other server processes may read the file while it is written
+    QSaveFile file( tileFilePath( projectPath, key ) );
+    if ( !file.open( QIODevice::WriteOnly ) || !tile.save( &file, "PNG" ) || !file.commit() )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Cannot write the tile %1" ).arg( file.fileName() ), QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+    }
+  }
+
+  void QgsWmsTileCache::removeProject( const QString &path )
+  {
+    {
+      QMutexLocker locker( &mMutex );
+      QString prefix = path + '\n';
+      Q_FOREACH ( const QString &key, mTiles.keys() )
+      {
+        if ( key.startsWith( prefix ) )
+          mTiles.remove( key );
+      }
+    }
+
+    if ( !mDirectory.isEmpty() )
+    {
+      QDir( projectDirectory( path ) ).removeRecursively();
+    }
+  }
+
+  QString QgsWmsTileCache::tileFilePath( const QString &projectPath, const QString &key ) const
+  {
+    return projectDirectory( projectPath ) + '/' + hash( key ) + ".png";
+  }
+
+  QString QgsWmsTileCache::projectDirectory( const QString &projectPath ) const
+  {
+    return mDirectory + '/' + hash( projectPath );
+  }
+
+} // namespace QgsWms
@@ -0,0 +1,107 @@
+/***************************************************************************
+                qgswmstilecache.h
+                -----------------
+    begin                : October 2026
+    copyright            : (C) 2026 by QGIS project
+***************************************************************************/
+
+/***************************************************************************
+*                                                                         *
+*   This program is free software; you can redistribute it and/or modify  *
+*   it under the terms of the GNU General Public License as published by  *
+*   the Free Software Foundation; either version 2 of the License, or     *
+*   (at your option) any later version.                                   *
+*                                                                         *
+***************************************************************************/
+
+#ifndef QGSWMSTILECACHE_H
+#define QGSWMSTILECACHE_H
+
+#include "qgsserverrequest.h"
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+class QgsServerInterface;
+class QgsServerSettings;
+class QgsProject;
+
+namespace QgsWms
+{
+
+  /** \ingroup server
+    * Cache of the images rendered for tiled GetMap requests.
+    *
+    * A request is considered as a tile if its BBOX is aligned on a grid of tiles of the
+    * same size starting at the origin of the CRS, which is the case for the usual grids
+    * of tiled clients. The tile is then rendered together with its neighbours as a
+    * metatile, which is sliced into the tiles of the grid. Besides avoiding to render the
+    * same tile several times, this reduces the number of labels cut at the tile borders.
+    *
+    * Tiles are kept in memory with a least recently used policy and optionally stored
+    * on disk. Tiles of a project are removed when QgsConfigCache detects a change of the
+    * project file. Changes of the layer data are not detected.
+    * \since QGIS 3.0
+    */
+  class QgsWmsTileCache
+  {
+    public:
+
+      /** Returns the tile cache configured by \a settings, or nullptr if the tile cache is disabled.
+        */
+      static QgsWmsTileCache *instance( const QgsServerSettings &settings );
+
+      /** Renders the image of a GetMap request, using the cached tiles when the request is a tile.
+        * \param serverIface the server interface
+        * \param project the project of the request
+        * \param parameters the parameters of the request
+        * \returns the image, ownership is transferred to the caller, or nullptr if it could not be rendered
+        */
+      QImage *getMap( QgsServerInterface *serverIface, const QgsProject *project, const QgsServerRequest::Parameters &parameters );
+
+      /** Removes the tiles of the project file \a path.
+        */
+      void removeProject( const QString &path );
+
+    private:
+
+      //! Position of a tile in a grid
+      struct TileGrid
+      {
+        //! Size of the tiles in map units along the axes of the BBOX parameter
+        double firstAxisSize = 0;
+        double secondAxisSize = 0;
+        //! Index of the tile along the axes of the BBOX parameter
+        qint64 firstAxisIndex = 0;
+        qint64 secondAxisIndex = 0;
+        //! True if the first axis of the BBOX parameter is the vertical axis of the image
+        bool invertedAxis = false;
+      };
+
+      QgsWmsTileCache( qint64 size, const QString &directory, int metatileSize );
+
+      //! Returns false if the request is not a tile of a grid
+      static bool tileGrid( const QgsServerRequest::Parameters &parameters, TileGrid &grid );
+
+      //! Renders the metatile around the tile \a grid and caches its tiles
+      QImage renderMetatile( QgsServerInterface *serverIface, const QgsProject *project, const QgsServerRequest::Parameters &parameters,
+                             const TileGrid &grid, const QString &gridKey );
+
+      QImage cachedTile( const QString &projectPath, const QString &key );
+      void insertTile( const QString &projectPath, const QString &key, const QImage &tile );
+      QString tileFilePath( const QString &projectPath, const QString &key ) const;
+      QString projectDirectory( const QString &projectPath ) const;
+
+      QString mDirectory;
+      int mMetatileSize;
+
+      QMutex mMutex;
+      //! Tiles by key, the cost is the size of the image in kilobytes
+      QCache< QString, QImage > mTiles;
+  };
+
+} // namespace QgsWms
+
+#endif
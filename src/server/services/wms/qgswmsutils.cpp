@@ -33,9 +33,9 @@ namespace QgsWms
   }
 
   // Return the wms config parser (Transitional)
-  QgsWmsConfigParser *getConfigParser( QgsServerInterface *serverIface )
+  QgsWmsConfigParser *getConfigParser( QgsServerInterface *serverIface, const QgsProject *project )
   {
-    QString configFilePath = serverIface->configFilePath();
+    QString configFilePath = project ? project->fileName() : serverIface->configFilePath();
 
     QgsWmsConfigParser *parser  = QgsConfigCache::instance()->wmsConfiguration( configFilePath, serverIface->accessControls() );
     if ( !parser )
@@ -94,7 +94,7 @@ namespace QgsWms
                                     QRegularExpression::CaseInsensitiveOption );
 
       QRegularExpressionMatch match = modeExpr.match( format );
-      QString mode = match.captured();
+      QString mode = match.captured( 1 );
       if ( mode.compare( QLatin1String( "16bit" ), Qt::CaseInsensitive ) == 0 )
         return PNG16;
       if ( mode.compare( QLatin1String( "8bit" ), Qt::CaseInsensitive ) == 0 )
@@ -116,9 +116,27 @@ namespace QgsWms
   }
 
 
+  int imageQuality( const QgsWmsConfigParser *configParser, const QgsServerRequest::Parameters &parameters )
+  {
+    // First taken from QGIS project
+    int imageQuality = configParser->imageQuality();
+
+    // Then checks if a parameter is given, if so use it instead
+    if ( parameters.contains( QStringLiteral( "IMAGE_QUALITY" ) ) )
+    {
+      bool conversionSuccess;
+      int imageQualityParameter = parameters[ QStringLiteral( "IMAGE_QUALITY" )].toInt( &conversionSuccess );
+      if ( conversionSuccess )
+      {
+        imageQuality = imageQualityParameter;
+      }
+    }
+    return imageQuality;
+  }
+
   // Write image response
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality )
+                   int imageQuality, const QString &paletteKey )
   {
     ImageOutputFormat outputFormat = parseImageFormat( formatStr );
     QImage  result;
@@ -132,16 +150,10 @@ namespace QgsWms
         saveFormat = "PNG";
         break;
       case PNG8:
-      {
-        QVector<QRgb> colorTable;
-        medianCut( colorTable, 256, img );
-        result = img.convertToFormat( QImage::Format_Indexed8, colorTable,
-                                      Qt::ColorOnly | Qt::ThresholdDither |
-                                      Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
-      }
-      contentType = "image/png";
-      saveFormat = "PNG";
-      break;
+        result = quantizeImage( img, 256, paletteKey );
+        contentType = "image/png";
+        saveFormat = "PNG";
+        break;
       case PNG16:
         result = img.convertToFormat( QImage::Format_ARGB4444_Premultiplied );
         contentType = "image/png";
@@ -60,10 +60,18 @@ namespace QgsWms
   /**
    * Return the wms config parser (Transitional)
    *
+   * The parser of the configuration file of the \a project is returned if it is set, else
+   * the configuration file path of the interface, which is only set by the exclusive requests.
+   *
    * XXX This is needed in the current implementation.
    * This should disappear as soon we get rid of singleton.
    */
-  QgsWmsConfigParser *getConfigParser( QgsServerInterface *serverIface );
+  QgsWmsConfigParser *getConfigParser( QgsServerInterface *serverIface, const QgsProject *project = nullptr );
+
+  /** Returns the image quality of the IMAGE_QUALITY parameter, or the image quality of the project
+   *  if the parameter is not set
+   */
+  int imageQuality( const QgsWmsConfigParser *configParser, const QgsServerRequest::Parameters &parameters );
 
   /** Parse image format parameter
    *  \returns OutputFormat
@@ -71,9 +79,11 @@ namespace QgsWms
   ImageOutputFormat parseImageFormat( const QString &format );
 
   /** Write image response
+   * \param paletteKey key of the palette shared by the 8 bit PNG images of a layer set,
+   * or an empty string to compute a palette for each image
    */
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality = -1 );
+                   int imageQuality = -1, const QString &paletteKey = QString() );
 
   /**
    * Parse bbox parameter
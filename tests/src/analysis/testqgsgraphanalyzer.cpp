@@ -0,0 +1,409 @@
+/***************************************************************************
+  testqgsgraphanalyzer.cpp
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgstestutils.h"
+
+#include "qgsapplication.h"
+#include "qgsgraph.h"
+#include "qgsgraphbuilder.h"
+#include "qgscompactgraph.h"
+#include "qgsgeometry.h"
+#include "qgsgraphanalyzer.h"
+#include "qgsgraphcontractionhierarchy.h"
+#include "qgsnetworkdistancestrategy.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerdirector.h"
+
+#include <QDir>
+
+#include <limits>
+#include <memory>
+
+/** \ingroup UnitTests
+ * Compares the point to point shortest path searches with the full Dijkstra shortest path tree.
+ */
+class TestQgsGraphAnalyzer : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void shortestPath();
+    void aStar();
+    void aStarGeographic();
+    void contractionHierarchy();
+    void contractionHierarchyFile();
+    void compactGraph();
+    void compactGraphSnapshot();
+
+  private:
+    //! Checks that \a path is a connected path from \a start to \a end with the total cost \a cost
+    void checkPath( const QVector<int> &path, int start, int end, double cost );
+
+    QgsGraph *mGraph = nullptr;
+    int mUnreachable = -1;
+};
+
+void TestQgsGraphAnalyzer::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  // 12 x 12 grid with one way streets in every third row and edge costs >= the edge length
+  mGraph = new QgsGraph();
+  const int size = 12;
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int col = 0; col < size; ++col )
+    {
+      mGraph->addVertex( QgsPoint( col * 10, row * 10 ) );
+    }
+  }
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int col = 0; col < size; ++col )
+    {
+      int vertex = row * size + col;
+      double factor = 1.0 + ( ( row * 7 + col * 13 ) % 5 ) / 2.0;
+      if ( col + 1 < size )
+      {
+        mGraph->addEdge( vertex, vertex + 1, QVector< QVariant >() << 10.0 * factor );
+        if ( row % 3 != 0 )
+          mGraph->addEdge( vertex + 1, vertex, QVector< QVariant >() << 10.0 * factor );
+      }
+      if ( row + 1 < size )
+      {
+        mGraph->addEdge( vertex, vertex + size, QVector< QVariant >() << 10.0 * ( 4.0 - factor ) );
+        mGraph->addEdge( vertex + size, vertex, QVector< QVariant >() << 10.0 * ( 4.0 - factor ) );
+      }
+    }
+  }
+  // a vertex without edges
+  mUnreachable = mGraph->addVertex( QgsPoint( -100, -100 ) );
+}
+
+void TestQgsGraphAnalyzer::cleanupTestCase()
+{
+  delete mGraph;
+  QgsApplication::exitQgis();
+}
+
+void TestQgsGraphAnalyzer::checkPath( const QVector<int> &path, int start, int end, double cost )
+{
+  QVERIFY( !path.isEmpty() );
+  QCOMPARE( mGraph->edge( path.first() ).outVertex(), start );
+  QCOMPARE( mGraph->edge( path.last() ).inVertex(), end );
+  double pathCost = 0;
+  for ( int i = 0; i < path.size(); ++i )
+  {
+    if ( i > 0 )
+      QCOMPARE( mGraph->edge( path.at( i ) ).outVertex(), mGraph->edge( path.at( i - 1 ) ).inVertex() );
+    pathCost += mGraph->edge( path.at( i ) ).cost( 0 ).toDouble();
+  }
+  QGSCOMPARENEAR( pathCost, cost, 1e-9 );
+}
+
+void TestQgsGraphAnalyzer::shortestPath()
+{
+  for ( int start = 0; start < mGraph->vertexCount() - 1; start += 7 )
+  {
+    QVector< int > tree;
+    QVector< double > costs;
+    QgsGraphAnalyzer::dijkstra( mGraph, start, 0, &tree, &costs );
+
+    for ( int end = 0; end < mGraph->vertexCount() - 1; end += 5 )
+    {
+      QVector< int > path;
+      double cost = QgsGraphAnalyzer::shortestPath( mGraph, start, end, 0, &path );
+      QGSCOMPARENEAR( cost, costs.at( end ), 1e-9 );
+      if ( start == end )
+        QVERIFY( path.isEmpty() );
+      else
+        checkPath( path, start, end, cost );
+    }
+
+    QVector< int > path;
+    QCOMPARE( QgsGraphAnalyzer::shortestPath( mGraph, start, mUnreachable, 0, &path ), std::numeric_limits<double>::infinity() );
+    QVERIFY( path.isEmpty() );
+  }
+}
+
+void TestQgsGraphAnalyzer::aStar()
+{
+  // the edge costs of the test graph are never smaller than the edge length
+  QgsNetworkDistanceStrategy strategy;
+  strategy.setMinimumCostPerDistance( 1.0 );
+  for ( int start = 0; start < mGraph->vertexCount() - 1; start += 7 )
+  {
+    QVector< double > costs;
+    QgsGraphAnalyzer::dijkstra( mGraph, start, 0, nullptr, &costs );
+
+    for ( int end = 0; end < mGraph->vertexCount() - 1; end += 5 )
+    {
+      QVector< int > path;
+      double cost = QgsGraphAnalyzer::aStar( mGraph, start, end, 0, &strategy, &path );
+      QGSCOMPARENEAR( cost, costs.at( end ), 1e-9 );
+      if ( start != end )
+        checkPath( path, start, end, cost );
+    }
+  }
+}
+
+void TestQgsGraphAnalyzer::aStarGeographic()
+{
+  // grid of streets in a geographic CRS, whose edge lengths are measured on the ellipsoid in meters
+  QgsVectorLayer layer( QStringLiteral( "LineString?crs=epsg:4326" ), QStringLiteral( "streets" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  const int size = 8;
+  QgsFeatureList features;
+  for ( int i = 0; i < size; ++i )
+  {
+    QgsPolyline row;
+    QgsPolyline column;
+    for ( int j = 0; j < size; ++j )
+    {
+      // uneven spacing, so that the shortest paths are unique
+      row << QgsPoint( 10.0 + j * 0.01 + ( j * j ) * 0.001, 60.0 + i * 0.01 );
+      column << QgsPoint( 10.0 + i * 0.01 + ( i * i ) * 0.001, 60.0 + j * 0.01 );
+    }
+    QgsFeature rowFeature;
+    rowFeature.setGeometry( QgsGeometry::fromPolyline( row ) );
+    QgsFeature columnFeature;
+    columnFeature.setGeometry( QgsGeometry::fromPolyline( column ) );
+    features << rowFeature << columnFeature;
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsVectorLayerDirector director( &layer, -1, QString(), QString(), QString(), QgsVectorLayerDirector::DirectionBoth );
+  director.addStrategy( new QgsNetworkDistanceStrategy() );
+  QgsGraphBuilder builder( layer.crs(), true, 0.0, QStringLiteral( "WGS84" ) );
+  QVector< QgsPoint > snappedPoints;
+  director.makeGraph( &builder, QVector< QgsPoint >(), snappedPoints );
+  std::unique_ptr< QgsGraph > graph( builder.graph() );
+  QCOMPARE( graph->vertexCount(), size * size );
+
+  // the edges are hundreds of meters long, while the distances between the points are in degrees
+  const QgsGraphEdge &edge = graph->edge( 0 );
+  QVERIFY( edge.cost( 0 ).toDouble() > 100.0 );
+
+  // the default strategy gives no estimate, which is always safe
+  QgsNetworkDistanceStrategy strategy;
+  QCOMPARE( strategy.minimumCostPerDistance(), 0.0 );
+  QgsCompactGraph compact( graph.get() );
+  for ( int start = 0; start < graph->vertexCount(); start += 3 )
+  {
+    QVector< double > costs;
+    QgsGraphAnalyzer::dijkstra( graph.get(), start, 0, nullptr, &costs );
+    for ( int end = 0; end < graph->vertexCount(); end += 5 )
+    {
+      QGSCOMPARENEAR( QgsGraphAnalyzer::aStar( graph.get(), start, end, 0, &strategy ), costs.at( end ), 1e-6 );
+      QGSCOMPARENEAR( QgsGraphAnalyzer::aStar( &compact, start, end, 0, &strategy ), costs.at( end ), 1e-6 );
+    }
+  }
+}
+
+void TestQgsGraphAnalyzer::contractionHierarchy()
+{
+  QgsGraphContractionHierarchy hierarchy( mGraph, 0 );
+  QVERIFY( hierarchy.isValid() );
+  QVERIFY( hierarchy.isCompatible( mGraph ) );
+  QCOMPARE( hierarchy.vertexCount(), mGraph->vertexCount() );
+
+  for ( int start = 0; start < mGraph->vertexCount() - 1; start += 3 )
+  {
+    QVector< double > costs;
+    QgsGraphAnalyzer::dijkstra( mGraph, start, 0, nullptr, &costs );
+
+    for ( int end = 0; end < mGraph->vertexCount() - 1; ++end )
+    {
+      QVector< int > path;
+      double cost = hierarchy.shortestPath( start, end, &path );
+      QGSCOMPARENEAR( cost, costs.at( end ), 1e-9 );
+      if ( start != end )
+        checkPath( path, start, end, cost );
+    }
+    QCOMPARE( hierarchy.shortestPath( start, mUnreachable ), std::numeric_limits<double>::infinity() );
+  }
+
+  QgsGraph other;
+  other.addVertex( QgsPoint( 0, 0 ) );
+  QVERIFY( !hierarchy.isCompatible( &other ) );
+}
+
+void TestQgsGraphAnalyzer::contractionHierarchyFile()
+{
+  QgsGraphContractionHierarchy hierarchy( mGraph, 0 );
+  QString fileName = QDir::tempPath() + "/testqgsgraphanalyzer.ch";
+  QVERIFY( hierarchy.writeToFile( fileName ) );
+
+  QgsGraphContractionHierarchy restored;
+  QVERIFY( !restored.isValid() );
+  QVERIFY( restored.readFromFile( fileName ) );
+  QVERIFY( restored.isCompatible( mGraph ) );
+  QCOMPARE( restored.shortcutCount(), hierarchy.shortcutCount() );
+
+  for ( int start = 0; start < mGraph->vertexCount(); start += 11 )
+  {
+    for ( int end = 0; end < mGraph->vertexCount(); end += 13 )
+    {
+      QVector< int > path;
+      QVector< int > restoredPath;
+      QCOMPARE( restored.shortestPath( start, end, &restoredPath ), hierarchy.shortestPath( start, end, &path ) );
+      QCOMPARE( restoredPath, path );
+    }
+  }
+
+  // not a hierarchy file
+  QFile file( fileName );
+  QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+  file.write( "not a contraction hierarchy" );
+  file.close();
+  QVERIFY( !restored.readFromFile( fileName ) );
+  QVERIFY( !restored.isValid() );
+  QFile::remove( fileName );
+}
+
+void TestQgsGraphAnalyzer::compactGraph()
+{
+  QgsCompactGraph compact( mGraph );
+  QCOMPARE( compact.vertexCount(), mGraph->vertexCount() );
+  QCOMPARE( compact.edgeCount(), mGraph->edgeCount() );
+  QCOMPARE( compact.strategyCount(), 1 );
+
+  for ( int vertex = 0; vertex < mGraph->vertexCount(); ++vertex )
+  {
+    QCOMPARE( compact.vertexPoint( vertex ), mGraph->vertex( vertex ).point() );
+    QCOMPARE( compact.outEdgesEnd( vertex ) - compact.outEdgesBegin( vertex ), mGraph->vertex( vertex ).outEdges().size() );
+    QCOMPARE( compact.inEdgesEnd( vertex ) - compact.inEdgesBegin( vertex ), mGraph->vertex( vertex ).inEdges().size() );
+    for ( int edge = compact.outEdgesBegin( vertex ); edge < compact.outEdgesEnd( vertex ); ++edge )
+    {
+      const QgsGraphEdge &graphEdge = mGraph->edge( compact.graphEdge( edge ) );
+      QCOMPARE( compact.edgeOutVertex( edge ), vertex );
+      QCOMPARE( graphEdge.outVertex(), vertex );
+      QCOMPARE( compact.edgeInVertex( edge ), graphEdge.inVertex() );
+      QCOMPARE( compact.edgeCost( edge, 0 ), graphEdge.cost( 0 ).toDouble() );
+    }
+    for ( int i = compact.inEdgesBegin( vertex ); i < compact.inEdgesEnd( vertex ); ++i )
+    {
+      QCOMPARE( compact.edgeInVertex( compact.inEdge( i ) ), vertex );
+    }
+  }
+
+  QgsNetworkDistanceStrategy strategy;
+  strategy.setMinimumCostPerDistance( 1.0 );
+  QgsGraphContractionHierarchy hierarchy( &compact, 0 );
+  QVERIFY( hierarchy.isCompatible( &compact ) );
+  for ( int start = 0; start < mGraph->vertexCount() - 1; start += 7 )
+  {
+    QVector< double > costs;
+    QVector< double > compactCosts;
+    QgsGraphAnalyzer::dijkstra( mGraph, start, 0, nullptr, &costs );
+    QgsGraphAnalyzer::dijkstra( &compact, start, 0, nullptr, &compactCosts );
+    QCOMPARE( compactCosts, costs );
+
+    for ( int end = 0; end < mGraph->vertexCount() - 1; end += 5 )
+    {
+      QVector< int > path;
+      QGSCOMPARENEAR( QgsGraphAnalyzer::shortestPath( &compact, start, end, 0, &path ), costs.at( end ), 1e-9 );
+      QGSCOMPARENEAR( QgsGraphAnalyzer::aStar( &compact, start, end, 0, &strategy ), costs.at( end ), 1e-9 );
+      QGSCOMPARENEAR( hierarchy.shortestPath( start, end ), costs.at( end ), 1e-9 );
+      if ( start != end )
+      {
+        QVector< int > graphPath;
+        for ( int edge : path )
+          graphPath << compact.graphEdge( edge );
+        checkPath( graphPath, start, end, costs.at( end ) );
+      }
+    }
+  }
+}
+
+void TestQgsGraphAnalyzer::compactGraphSnapshot()
+{
+  QgsCompactGraph compact( mGraph );
+  QString fileName = QDir::tempPath() + "/testqgsgraphanalyzer.graph";
+  QVERIFY( compact.writeToFile( fileName ) );
+
+  {
+    std::unique_ptr< QgsCompactGraph > restored( QgsCompactGraph::readFromFile( fileName ) );
+    QVERIFY( restored );
+    QCOMPARE( restored->vertexCount(), compact.vertexCount() );
+    QCOMPARE( restored->edgeCount(), compact.edgeCount() );
+    QCOMPARE( restored->strategyCount(), compact.strategyCount() );
+    for ( int vertex = 0; vertex < compact.vertexCount(); ++vertex )
+    {
+      QCOMPARE( restored->vertexPoint( vertex ), compact.vertexPoint( vertex ) );
+      QCOMPARE( restored->outEdgesBegin( vertex ), compact.outEdgesBegin( vertex ) );
+      QCOMPARE( restored->inEdgesBegin( vertex ), compact.inEdgesBegin( vertex ) );
+    }
+    for ( int edge = 0; edge < compact.edgeCount(); ++edge )
+    {
+      QCOMPARE( restored->edgeInVertex( edge ), compact.edgeInVertex( edge ) );
+      QCOMPARE( restored->edgeCost( edge, 0 ), compact.edgeCost( edge, 0 ) );
+      QCOMPARE( restored->graphEdge( edge ), compact.graphEdge( edge ) );
+      QCOMPARE( restored->inEdge( edge ), compact.inEdge( edge ) );
+    }
+    QCOMPARE( QgsGraphAnalyzer::shortestPath( restored.get(), 0, 100, 0 ), QgsGraphAnalyzer::shortestPath( &compact, 0, 100, 0 ) );
+  }
+
+  // corrupted indices, at the position of the integer arrays following the header and the double arrays
+  const qint64 vertexCount = compact.vertexCount();
+  const qint64 edgeCount = compact.edgeCount();
+  const qint64 outOffsetsPos = 24 + sizeof( double ) * ( 2 * vertexCount + compact.strategyCount() * edgeCount );
+  const qint64 edgeInPos = outOffsetsPos + sizeof( qint32 ) * ( vertexCount + 1 + edgeCount );
+  const qint64 inEdgesPos = edgeInPos + sizeof( qint32 ) * ( edgeCount + vertexCount + 1 );
+  const QList< QPair< qint64, qint32 > > corruptions = QList< QPair< qint64, qint32 > >()
+      << qMakePair( outOffsetsPos + static_cast< qint64 >( sizeof( qint32 ) ), static_cast< qint32 >( edgeCount + 10 ) ) // offsets not increasing
+      << qMakePair( edgeInPos, static_cast< qint32 >( vertexCount ) ) // vertex out of range
+      << qMakePair( edgeInPos + 4 * static_cast< qint64 >( sizeof( qint32 ) ), static_cast< qint32 >( -1 ) )
+      << qMakePair( inEdgesPos, static_cast< qint32 >( edgeCount ) ); // edge out of range
+  for ( const auto &corruption : corruptions )
+  {
+    QVERIFY( compact.writeToFile( fileName ) );
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::ReadWrite ) );
+    QVERIFY( file.seek( corruption.first ) );
+    QCOMPARE( file.write( reinterpret_cast< const char * >( &corruption.second ), sizeof( qint32 ) ), static_cast< qint64 >( sizeof( qint32 ) ) );
+    file.close();
+    QVERIFY( !QgsCompactGraph::readFromFile( fileName ) );
+  }
+
+  // an in edge which is in range, but does not end at its vertex
+  int otherEdge = 0;
+  while ( compact.edgeInVertex( otherEdge ) == compact.edgeInVertex( compact.inEdge( 0 ) ) )
+    ++otherEdge;
+  QVERIFY( compact.writeToFile( fileName ) );
+  {
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::ReadWrite ) );
+    QVERIFY( file.seek( inEdgesPos ) );
+    qint32 value = otherEdge;
+    QCOMPARE( file.write( reinterpret_cast< const char * >( &value ), sizeof( qint32 ) ), static_cast< qint64 >( sizeof( qint32 ) ) );
+  }
+  QVERIFY( !QgsCompactGraph::readFromFile( fileName ) );
+
+  // truncated file
+  QVERIFY( compact.writeToFile( fileName ) );
+  QFile file( fileName );
+  QVERIFY( file.resize( 100 ) );
+  QVERIFY( !QgsCompactGraph::readFromFile( fileName ) );
+  QFile::remove( fileName );
+  QVERIFY( !QgsCompactGraph::readFromFile( fileName ) );
+}
+
+QGSTEST_MAIN( TestQgsGraphAnalyzer )
+#include "testqgsgraphanalyzer.moc"
@@ -0,0 +1,433 @@
+/***************************************************************************
+  testqgsinterpolator.cpp
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgstestutils.h"
+
+#include "qgsapplication.h"
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgsgridfilewriter.h"
+#include "qgsidwinterpolator.h"
+#include "qgstininterpolator.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <QDir>
+
+#include <algorithm>
+#include <memory>
+
+#include <gdal.h>
+
+/** \ingroup UnitTests
+ * Checks the neighbour search of the IDW interpolator, the triangulation built by the TIN interpolator
+ * and the grid files interpolated concurrently.
+ */
+class TestQgsInterpolator : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void idwAllPoints();
+    void idwSearchRadius();
+    void idwMaxPoints();
+    void idwGridFormats();
+    void idwNoData();
+    void tinLinearPlane();
+    void tinCloughTocherPlane();
+    void tinMultiPoint();
+    void tinConcurrentGrid_data();
+    void tinConcurrentGrid();
+
+  private:
+    //! Creates a memory layer with the points and values
+    QgsVectorLayer *createLayer( const QList< QgsPoint > &points, const QList< double > &values, bool multiPoint ) const;
+
+    //! IDW value calculated from the points within \a radius, limited to the \a count nearest points
+    bool idwValue( double x, double y, double radius, int count, double &value ) const;
+
+    QList< QgsPoint > mPoints;
+    QList< double > mPlaneValues;
+    QList< double > mRandomValues;
+    QgsVectorLayer *mPlaneLayer = nullptr;
+    QgsVectorLayer *mRandomLayer = nullptr;
+};
+
+static double _planeValue( double x, double y )
+{
+  return 2.0 * x - 3.0 * y + 5.0;
+}
+
+static QList<QgsInterpolator::LayerData> _layerData( QgsVectorLayer *layer )
+{
+  QgsInterpolator::LayerData data;
+  data.vectorLayer = layer;
+  data.zCoordInterpolation = false;
+  data.interpolationAttribute = 0;
+  data.mInputType = QgsInterpolator::POINTS;
+  return QList<QgsInterpolator::LayerData>() << data;
+}
+
+QgsVectorLayer *TestQgsInterpolator::createLayer( const QList< QgsPoint > &points, const QList< double > &values, bool multiPoint ) const
+{
+  QString uri = multiPoint ? QStringLiteral( "MultiPoint?crs=EPSG:3857&field=value:double" ) : QStringLiteral( "Point?crs=EPSG:3857&field=value:double" );
+  QgsVectorLayer *layer = new QgsVectorLayer( uri, QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < points.size(); ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setGeometry( multiPoint ? QgsGeometry::fromMultiPoint( QgsMultiPoint() << points.at( i ) ) : QgsGeometry::fromPoint( points.at( i ) ) );
+    f.setAttribute( 0, values.at( i ) );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+  layer->updateExtents();
+  return layer;
+}
+
+void TestQgsInterpolator::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  GDALAllRegister();
+
+  // the corners make the convex hull the square 0,0 - 1000,1000
+  mPoints << QgsPoint( 0, 0 ) << QgsPoint( 1000, 0 ) << QgsPoint( 1000, 1000 ) << QgsPoint( 0, 1000 );
+  // a regular grid, which has many cocircular points, and random points in between
+  for ( int i = 1; i < 20; ++i )
+  {
+    for ( int j = 1; j < 20; ++j )
+    {
+      mPoints << QgsPoint( i * 50.0, j * 50.0 );
+    }
+  }
+  qsrand( 1 );
+  for ( int i = 0; i < 2000; ++i )
+  {
+    mPoints << QgsPoint( ( qrand() % 100000 ) / 100.0, ( qrand() % 100000 ) / 100.0 );
+  }
+
+  for ( const QgsPoint &point : mPoints )
+  {
+    mPlaneValues << _planeValue( point.x(), point.y() );
+    mRandomValues << ( qrand() % 10000 ) / 10.0;
+  }
+  mPlaneLayer = createLayer( mPoints, mPlaneValues, false );
+  mRandomLayer = createLayer( mPoints, mRandomValues, false );
+  QVERIFY( mPlaneLayer->isValid() );
+  QVERIFY( mRandomLayer->isValid() );
+}
+
+void TestQgsInterpolator::cleanupTestCase()
+{
+  delete mPlaneLayer;
+  delete mRandomLayer;
+  QgsApplication::exitQgis();
+}
+
+bool TestQgsInterpolator::idwValue( double x, double y, double radius, int count, double &value ) const
+{
+  QList< QPair< double, int > > neighbours;
+  for ( int i = 0; i < mPoints.size(); ++i )
+  {
+    double distance = mPoints.at( i ).distance( x, y );
+    if ( radius <= 0 || distance <= radius )
+      neighbours << qMakePair( distance, i );
+  }
+  std::sort( neighbours.begin(), neighbours.end() );
+  if ( count > 0 && neighbours.size() > count )
+    neighbours = neighbours.mid( 0, count );
+
+  double sumCounter = 0;
+  double sumDenominator = 0;
+  for ( const QPair< double, int > &neighbour : neighbours )
+  {
+    double weight = 1 / pow( neighbour.first, 2.0 );
+    sumCounter += weight * mRandomValues.at( neighbour.second );
+    sumDenominator += weight;
+  }
+  if ( sumDenominator == 0.0 )
+    return false;
+  value = sumCounter / sumDenominator;
+  return true;
+}
+
+void TestQgsInterpolator::idwAllPoints()
+{
+  QgsIDWInterpolator interpolator( _layerData( mRandomLayer ) );
+  QCOMPARE( interpolator.prepare(), 0 );
+
+  double value = 0;
+  double expected = 0;
+  for ( int i = 0; i < 50; ++i )
+  {
+    double x = i * 20.0 + 3.3;
+    double y = 1000 - i * 19.0;
+    QCOMPARE( interpolator.interpolatePoint( x, y, value ), 0 );
+    QVERIFY( idwValue( x, y, 0, 0, expected ) );
+    QGSCOMPARENEAR( value, expected, 1e-9 );
+  }
+
+  // points of the data set keep their value
+  QCOMPARE( interpolator.interpolatePoint( mPoints.at( 10 ).x(), mPoints.at( 10 ).y(), value ), 0 );
+  QCOMPARE( value, mRandomValues.at( 10 ) );
+}
+
+void TestQgsInterpolator::idwSearchRadius()
+{
+  QgsIDWInterpolator interpolator( _layerData( mRandomLayer ) );
+  interpolator.setSearchRadius( 40 );
+  QCOMPARE( interpolator.searchRadius(), 40.0 );
+
+  double value = 0;
+  double expected = 0;
+  for ( int i = 0; i < 200; ++i )
+  {
+    double x = ( i % 20 ) * 50.0 + 1.7;
+    double y = ( i / 20 ) * 100.0 + 2.9;
+    bool hasValue = idwValue( x, y, 40, 0, expected );
+    QCOMPARE( interpolator.interpolatePoint( x, y, value ) == 0, hasValue );
+    if ( hasValue )
+      QGSCOMPARENEAR( value, expected, 1e-9 );
+  }
+
+  // no points within the radius
+  QCOMPARE( interpolator.interpolatePoint( -1000, -1000, value ), 1 );
+}
+
+void TestQgsInterpolator::idwMaxPoints()
+{
+  QgsIDWInterpolator interpolator( _layerData( mRandomLayer ) );
+  interpolator.setMaxPoints( 12 );
+  QCOMPARE( interpolator.maxPoints(), 12 );
+
+  double value = 0;
+  double expected = 0;
+  for ( int i = 0; i < 200; ++i )
+  {
+    double x = ( i % 20 ) * 50.0 + 1.7;
+    double y = ( i / 20 ) * 100.0 + 2.9;
+    QCOMPARE( interpolator.interpolatePoint( x, y, value ), 0 );
+    QVERIFY( idwValue( x, y, 0, 12, expected ) );
+    QGSCOMPARENEAR( value, expected, 1e-9 );
+  }
+
+  // both limits
+  interpolator.setSearchRadius( 50 );
+  for ( int i = 0; i < 200; ++i )
+  {
+    double x = ( i % 20 ) * 50.0 + 1.7;
+    double y = ( i / 20 ) * 100.0 + 2.9;
+    bool hasValue = idwValue( x, y, 50, 12, expected );
+    QCOMPARE( interpolator.interpolatePoint( x, y, value ) == 0, hasValue );
+    if ( hasValue )
+      QGSCOMPARENEAR( value, expected, 1e-9 );
+  }
+}
+
+void TestQgsInterpolator::idwGridFormats()
+{
+  QgsIDWInterpolator interpolator( _layerData( mRandomLayer ) );
+  interpolator.setMaxPoints( 8 );
+  QgsRectangle extent( 0, 0, 1000, 800 );
+  // more rows than a single block
+  int columns = 150;
+  int rows = 130;
+
+  QString asciiFile = QDir::tempPath() + "/idw_grid.asc";
+  QgsGridFileWriter asciiWriter( &interpolator, asciiFile, extent, columns, rows, extent.width() / columns, extent.height() / rows );
+  QCOMPARE( asciiWriter.writeFile(), 0 );
+
+  QString tiffFile = QDir::tempPath() + "/idw_grid.tif";
+  QgsGridFileWriter tiffWriter( &interpolator, tiffFile, extent, columns, rows, extent.width() / columns, extent.height() / rows );
+  tiffWriter.setOutputFormat( QgsGridFileWriter::GeoTiff );
+  QCOMPARE( tiffWriter.writeFile(), 0 );
+
+  QVector< float > asciiValues( columns * rows );
+  QVector< float > tiffValues( columns * rows );
+  for ( const QString &file : QStringList() << asciiFile << tiffFile )
+  {
+    GDALDatasetH ds = GDALOpen( file.toUtf8().constData(), GA_ReadOnly );
+    QVERIFY( ds );
+    QCOMPARE( GDALGetRasterXSize( ds ), columns );
+    QCOMPARE( GDALGetRasterYSize( ds ), rows );
+    double geoTransform[6];
+    QCOMPARE( GDALGetGeoTransform( ds, geoTransform ), CE_None );
+    QGSCOMPARENEAR( geoTransform[0], 0.0, 1e-6 );
+    QGSCOMPARENEAR( geoTransform[3], 800.0, 1e-6 );
+    float *values = file == asciiFile ? asciiValues.data() : tiffValues.data();
+    QCOMPARE( GDALRasterIO( GDALGetRasterBand( ds, 1 ), GF_Read, 0, 0, columns, rows, values, columns, rows, GDT_Float32, 0, 0 ), CE_None );
+    GDALClose( ds );
+  }
+
+  // the ascii grid has 8 significant digits
+  double expected = 0;
+  for ( int i = 0; i < asciiValues.size(); i += 97 )
+  {
+    int row = i / columns;
+    int column = i % columns;
+    double x = extent.xMinimum() + ( column + 0.5 ) * extent.width() / columns;
+    double y = extent.yMaximum() - ( row + 0.5 ) * extent.height() / rows;
+    QVERIFY( idwValue( x, y, 0, 8, expected ) );
+    QGSCOMPARENEAR( asciiValues.at( i ), expected, 1e-3 );
+    QGSCOMPARENEAR( tiffValues.at( i ), expected, 1e-3 );
+  }
+}
+
+void TestQgsInterpolator::idwNoData()
+{
+  // only NULL values, so no base data at all. The interpolator is prepared nevertheless, and
+  // the rows interpolated concurrently only read it
+  QgsVectorLayer nullLayer( QStringLiteral( "Point?crs=EPSG:3857&field=value:double" ),
+                            QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 10; ++i )
+  {
+    QgsFeature f( nullLayer.fields() );
+    f.setGeometry( QgsGeometry::fromPoint( QgsPoint( i * 10.0, i * 10.0 ) ) );
+    f.setAttribute( 0, QVariant( QVariant::Double ) );
+    features << f;
+  }
+  QVERIFY( nullLayer.dataProvider()->addFeatures( features ) );
+
+  QgsIDWInterpolator interpolator( _layerData( &nullLayer ) );
+  interpolator.setMaxPoints( 4 );
+  QCOMPARE( interpolator.prepare(), 0 );
+  double value = 0;
+  QCOMPARE( interpolator.interpolatePoint( 5, 5, value ), 1 );
+
+  QgsRectangle extent( 0, 0, 100, 100 );
+  QString asciiFile = QDir::tempPath() + "/idw_nodata.asc";
+  QgsGridFileWriter writer( &interpolator, asciiFile, extent, 100, 100, 1, 1 );
+  QCOMPARE( writer.writeFile(), 0 );
+
+  GDALDatasetH ds = GDALOpen( asciiFile.toUtf8().constData(), GA_ReadOnly );
+  QVERIFY( ds );
+  QVector< float > values( 100 * 100 );
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( ds, 1 ), GF_Read, 0, 0, 100, 100, values.data(), 100, 100, GDT_Float32, 0, 0 ), CE_None );
+  GDALClose( ds );
+  QVERIFY( std::all_of( values.constBegin(), values.constEnd(), []( float v ) { return v == -9999.0f; } ) );
+
+  // an interpolator without input layer gives no grid
+  QgsIDWInterpolator invalid( QList<QgsInterpolator::LayerData>() );
+  QgsGridFileWriter invalidWriter( &invalid, asciiFile, extent, 100, 100, 1, 1 );
+  QVERIFY( invalidWriter.writeFile() != 0 );
+}
+
+void TestQgsInterpolator::tinLinearPlane()
+{
+  QgsTINInterpolator interpolator( _layerData( mPlaneLayer ), QgsTINInterpolator::Linear );
+  QCOMPARE( interpolator.prepare(), 0 );
+
+  double value = 0;
+  for ( int i = 0; i < 500; ++i )
+  {
+    double x = ( i % 25 ) * 39.7 + 11.3;
+    double y = ( i / 25 ) * 49.1 + 7.9;
+    QCOMPARE( interpolator.interpolatePoint( x, y, value ), 0 );
+    QGSCOMPARENEAR( value, _planeValue( x, y ), 1e-6 );
+  }
+
+  // vertices of the triangulation
+  for ( int i = 0; i < mPoints.size(); i += 37 )
+  {
+    QCOMPARE( interpolator.interpolatePoint( mPoints.at( i ).x(), mPoints.at( i ).y(), value ), 0 );
+    QGSCOMPARENEAR( value, mPlaneValues.at( i ), 1e-6 );
+  }
+
+  // outside of the convex hull
+  QVERIFY( interpolator.interpolatePoint( -10, 500, value ) != 0 );
+}
+
+void TestQgsInterpolator::tinCloughTocherPlane()
+{
+  QgsTINInterpolator interpolator( _layerData( mPlaneLayer ), QgsTINInterpolator::CloughTocher );
+  QCOMPARE( interpolator.prepare(), 0 );
+
+  double value = 0;
+  for ( int i = 0; i < 500; ++i )
+  {
+    double x = ( i % 25 ) * 39.7 + 11.3;
+    double y = ( i / 25 ) * 49.1 + 7.9;
+    QCOMPARE( interpolator.interpolatePoint( x, y, value ), 0 );
+    QGSCOMPARENEAR( value, _planeValue( x, y ), 1e-4 );
+  }
+}
+
+void TestQgsInterpolator::tinMultiPoint()
+{
+  std::unique_ptr< QgsVectorLayer > multiPointLayer( createLayer( mPoints, mPlaneValues, true ) );
+  QVERIFY( multiPointLayer->isValid() );
+
+  QgsTINInterpolator interpolator( _layerData( multiPointLayer.get() ), QgsTINInterpolator::Linear );
+  QCOMPARE( interpolator.prepare(), 0 );
+
+  double value = 0;
+  for ( int i = 0; i < 100; ++i )
+  {
+    double x = ( i % 10 ) * 97.1 + 13.3;
+    double y = ( i / 10 ) * 93.7 + 21.9;
+    QCOMPARE( interpolator.interpolatePoint( x, y, value ), 0 );
+    QGSCOMPARENEAR( value, _planeValue( x, y ), 1e-6 );
+  }
+}
+
+void TestQgsInterpolator::tinConcurrentGrid_data()
+{
+  QTest::addColumn< int >( "interpolation" );
+
+  QTest::newRow( "linear" ) << static_cast< int >( QgsTINInterpolator::Linear );
+  QTest::newRow( "clough tocher" ) << static_cast< int >( QgsTINInterpolator::CloughTocher );
+}
+
+void TestQgsInterpolator::tinConcurrentGrid()
+{
+  QFETCH( int, interpolation );
+
+  QgsTINInterpolator interpolator( _layerData( mRandomLayer ), static_cast< QgsTINInterpolator::TINInterpolation >( interpolation ) );
+  QVERIFY( interpolator.supportsConcurrentInterpolation() );
+
+  QgsRectangle extent( 0, 0, 1000, 1000 );
+  int columns = 170;
+  int rows = 150;
+  QString file = QDir::tempPath() + "/tin_grid.tif";
+  QgsGridFileWriter writer( &interpolator, file, extent, columns, rows, extent.width() / columns, extent.height() / rows );
+  writer.setOutputFormat( QgsGridFileWriter::GeoTiff );
+  QCOMPARE( writer.writeFile(), 0 );
+
+  GDALDatasetH ds = GDALOpen( file.toUtf8().constData(), GA_ReadOnly );
+  QVERIFY( ds );
+  QVector< float > values( columns * rows );
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( ds, 1 ), GF_Read, 0, 0, columns, rows, values.data(), columns, rows, GDT_Float32, 0, 0 ), CE_None );
+  GDALClose( ds );
+
+  // the values interpolated by several threads match the ones of a single thread
+  QgsTINInterpolator sequentialInterpolator( _layerData( mRandomLayer ), static_cast< QgsTINInterpolator::TINInterpolation >( interpolation ) );
+  double expected = 0;
+  for ( int i = 0; i < values.size(); i += 7 )
+  {
+    int row = i / columns;
+    int column = i % columns;
+    double x = extent.xMinimum() + ( column + 0.5 ) * extent.width() / columns;
+    double y = extent.yMaximum() - ( row + 0.5 ) * extent.height() / rows;
+    QCOMPARE( sequentialInterpolator.interpolatePoint( x, y, expected ), 0 );
+    QGSCOMPARENEAR( values.at( i ), expected, 1e-3 * std::max( 1.0, std::fabs( expected ) ) );
+  }
+}
+
+QGSTEST_MAIN( TestQgsInterpolator )
+#include "testqgsinterpolator.moc"
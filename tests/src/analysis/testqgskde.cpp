@@ -0,0 +1,265 @@
+/***************************************************************************
+  testqgskde.cpp
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgskde.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <QDir>
+
+#include <algorithm>
+
+#include <gdal.h>
+
+/** \ingroup UnitTests
+ * Checks the tiled kernel density estimation against the kernel functions evaluated for every
+ * pixel and every point.
+ */
+class TestQgsKde : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void fixedRadius_data();
+    void fixedRadius();
+    void variableRadius();
+    void evictedTiles();
+
+  private:
+    //! Compares the output raster with the kernel values summed for each pixel
+    void checkSurface( const QString &file, QgsKernelDensityEstimation::KernelShape shape,
+                       QgsKernelDensityEstimation::OutputValues output, double decay, double fixedRadius );
+
+    QgsVectorLayer *mPointLayer = nullptr;
+};
+
+static double _kernelValue( double distance, double radius, QgsKernelDensityEstimation::KernelShape shape,
+                            QgsKernelDensityEstimation::OutputValues output, double decay )
+{
+  double u = distance / radius;
+  bool scaled = output == QgsKernelDensityEstimation::OutputScaled;
+  switch ( shape )
+  {
+    case QgsKernelDensityEstimation::KernelUniform:
+      return scaled ? 1. / ( M_PI * radius * radius ) : 1.;
+    case QgsKernelDensityEstimation::KernelQuartic:
+      return ( scaled ? 116. / ( 5. * M_PI * radius * radius ) * 15. / 16. : 1. ) * pow( 1. - u * u, 2 );
+    case QgsKernelDensityEstimation::KernelTriweight:
+      return ( scaled ? 128. / ( 35. * M_PI * radius * radius ) * 35. / 32. : 1. ) * pow( 1. - u * u, 3 );
+    case QgsKernelDensityEstimation::KernelEpanechnikov:
+      return ( scaled ? 8. / ( 3. * M_PI * radius * radius ) * 3. / 4. : 1. ) * ( 1. - u * u );
+    case QgsKernelDensityEstimation::KernelTriangular:
+      return ( scaled && decay >= 0 ? 3. / ( ( 1. + 2. * decay ) * M_PI * radius * radius ) : 1. ) * ( 1. - ( 1. - decay ) * u );
+  }
+  return 0;
+}
+
+void TestQgsKde::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  GDALAllRegister();
+
+  mPointLayer = new QgsVectorLayer( QStringLiteral( "Point?crs=EPSG:3857&field=weight:double&field=radius:double" ),
+                                    QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( mPointLayer->isValid() );
+
+  // spread over more than one tile of the output raster, including clusters of nearby points
+  qsrand( 1 );
+  QgsFeatureList features;
+  const double radii[] = { 10, 16, 30 };
+  for ( int i = 0; i < 400; ++i )
+  {
+    QgsFeature f( mPointLayer->fields() );
+    double x = ( qrand() % 100000 ) / 100.0;
+    double y = ( qrand() % 60000 ) / 100.0;
+    if ( i % 4 == 0 )
+    {
+      x = 500 + ( qrand() % 1000 ) / 100.0;
+      y = 300 + ( qrand() % 1000 ) / 100.0;
+    }
+    f.setGeometry( QgsGeometry::fromPoint( QgsPoint( x, y ) ) );
+    f.setAttribute( 0, 1.0 + ( i % 5 ) );
+    f.setAttribute( 1, radii[ i % 3 ] );
+    features << f;
+  }
+  QVERIFY( mPointLayer->dataProvider()->addFeatures( features ) );
+  mPointLayer->updateExtents();
+}
+
+void TestQgsKde::cleanupTestCase()
+{
+  delete mPointLayer;
+  QgsApplication::exitQgis();
+}
+
+void TestQgsKde::checkSurface( const QString &file, QgsKernelDensityEstimation::KernelShape shape,
+                               QgsKernelDensityEstimation::OutputValues output, double decay, double fixedRadius )
+{
+  GDALDatasetH ds = GDALOpen( file.toUtf8().constData(), GA_ReadOnly );
+  QVERIFY( ds );
+  int xSize = GDALGetRasterXSize( ds );
+  int ySize = GDALGetRasterYSize( ds );
+  double geoTransform[6];
+  QCOMPARE( GDALGetGeoTransform( ds, geoTransform ), CE_None );
+  QVector< float > values( xSize * ySize );
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( ds, 1 ), GF_Read, 0, 0, xSize, ySize, values.data(), xSize, ySize, GDT_Float32, 0, 0 ), CE_None );
+  GDALClose( ds );
+  // several tiles in both directions
+  QVERIFY( xSize > 256 && ySize > 256 );
+
+  QVector< double > expected( xSize * ySize, 0.0 );
+  QVector< bool > touched( xSize * ySize, false );
+  QgsFeature f;
+  QgsFeatureIterator fit = mPointLayer->getFeatures();
+  while ( fit.nextFeature( f ) )
+  {
+    QgsPoint p = f.geometry().asPoint();
+    double radius = fixedRadius > 0 ? fixedRadius : f.attribute( 1 ).toDouble();
+    double weight = f.attribute( 0 ).toDouble();
+    for ( int y = 0; y < ySize; ++y )
+    {
+      double cy = geoTransform[3] + ( y + 0.5 ) * geoTransform[5];
+      if ( std::fabs( cy - p.y() ) > radius )
+        continue;
+      for ( int x = 0; x < xSize; ++x )
+      {
+        double cx = geoTransform[0] + ( x + 0.5 ) * geoTransform[1];
+        double distance = sqrt( ( cx - p.x() ) * ( cx - p.x() ) + ( cy - p.y() ) * ( cy - p.y() ) );
+        if ( distance > radius )
+          continue;
+        expected[ y * xSize + x ] += weight * _kernelValue( distance, radius, shape, output, decay );
+        touched[ y * xSize + x ] = true;
+      }
+    }
+  }
+
+  for ( int i = 0; i < values.size(); ++i )
+  {
+    if ( !touched.at( i ) )
+    {
+      QCOMPARE( values.at( i ), -9999.0f );
+      continue;
+    }
+    double tolerance = 1e-5 * std::max( 1.0, std::fabs( expected.at( i ) ) );
+    if ( std::fabs( values.at( i ) - expected.at( i ) ) > tolerance )
+    {
+      QFAIL( QStringLiteral( "pixel %1: expected %2 got %3" ).arg( i ).arg( expected.at( i ) ).arg( values.at( i ) ).toUtf8().constData() );
+    }
+  }
+}
+
+void TestQgsKde::fixedRadius_data()
+{
+  QTest::addColumn< int >( "shape" );
+  QTest::addColumn< int >( "output" );
+  QTest::addColumn< double >( "decay" );
+
+  QTest::newRow( "quartic raw" ) << static_cast< int >( QgsKernelDensityEstimation::KernelQuartic ) << static_cast< int >( QgsKernelDensityEstimation::OutputRaw ) << 0.0;
+  QTest::newRow( "quartic scaled" ) << static_cast< int >( QgsKernelDensityEstimation::KernelQuartic ) << static_cast< int >( QgsKernelDensityEstimation::OutputScaled ) << 0.0;
+  QTest::newRow( "triangular scaled" ) << static_cast< int >( QgsKernelDensityEstimation::KernelTriangular ) << static_cast< int >( QgsKernelDensityEstimation::OutputScaled ) << 0.5;
+  QTest::newRow( "uniform scaled" ) << static_cast< int >( QgsKernelDensityEstimation::KernelUniform ) << static_cast< int >( QgsKernelDensityEstimation::OutputScaled ) << 0.0;
+  QTest::newRow( "triweight raw" ) << static_cast< int >( QgsKernelDensityEstimation::KernelTriweight ) << static_cast< int >( QgsKernelDensityEstimation::OutputRaw ) << 0.0;
+  QTest::newRow( "epanechnikov scaled" ) << static_cast< int >( QgsKernelDensityEstimation::KernelEpanechnikov ) << static_cast< int >( QgsKernelDensityEstimation::OutputScaled ) << 0.0;
+}
+
+void TestQgsKde::fixedRadius()
+{
+  QFETCH( int, shape );
+  QFETCH( int, output );
+  QFETCH( double, decay );
+
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.vectorLayer = mPointLayer;
+  parameters.radius = 20;
+  parameters.weightField = QStringLiteral( "weight" );
+  parameters.pixelSize = 2;
+  parameters.shape = static_cast< QgsKernelDensityEstimation::KernelShape >( shape );
+  parameters.decayRatio = decay;
+  parameters.outputValues = static_cast< QgsKernelDensityEstimation::OutputValues >( output );
+
+  QString file = QDir::tempPath() + "/kde_fixed.tif";
+  QgsKernelDensityEstimation kde( parameters, file, QStringLiteral( "GTiff" ) );
+  QCOMPARE( kde.run(), QgsKernelDensityEstimation::Success );
+
+  checkSurface( file, parameters.shape, parameters.outputValues, decay, parameters.radius );
+}
+
+void TestQgsKde::variableRadius()
+{
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.vectorLayer = mPointLayer;
+  parameters.radius = 0;
+  parameters.radiusField = QStringLiteral( "radius" );
+  parameters.weightField = QStringLiteral( "weight" );
+  parameters.pixelSize = 2;
+  parameters.shape = QgsKernelDensityEstimation::KernelQuartic;
+  parameters.decayRatio = 0;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputScaled;
+
+  QString file = QDir::tempPath() + "/kde_variable.tif";
+  QgsKernelDensityEstimation kde( parameters, file, QStringLiteral( "GTiff" ) );
+  QCOMPARE( kde.run(), QgsKernelDensityEstimation::Success );
+
+  checkSurface( file, parameters.shape, parameters.outputValues, 0, -1 );
+}
+
+void TestQgsKde::evictedTiles()
+{
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.vectorLayer = mPointLayer;
+  parameters.radius = 0;
+  parameters.radiusField = QStringLiteral( "radius" );
+  parameters.weightField = QStringLiteral( "weight" );
+  parameters.pixelSize = 2;
+  parameters.shape = QgsKernelDensityEstimation::KernelQuartic;
+  parameters.decayRatio = 0;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputRaw;
+
+  QString file = QDir::tempPath() + "/kde_evicted.tif";
+  QgsKernelDensityEstimation kde( parameters, file, QStringLiteral( "GTiff" ) );
+  // small batches and a single tile in memory, so that the tiles are written to the output raster
+  // and read back to add the points of the following batches
+  kde.mBatchPoints = 25;
+  kde.mMaxCachedTiles = 1;
+  QCOMPARE( kde.prepare(), QgsKernelDensityEstimation::Success );
+
+  int batches = 0;
+  QgsFeature f;
+  QgsFeatureIterator fit = mPointLayer->getFeatures();
+  while ( fit.nextFeature( f ) )
+  {
+    QCOMPARE( kde.addFeature( f ), QgsKernelDensityEstimation::Success );
+    if ( kde.mPendingPoints.isEmpty() )
+    {
+      ++batches;
+      QVERIFY( kde.mCachedTileCount <= kde.mMaxCachedTiles );
+    }
+  }
+  QVERIFY( batches > 10 );
+  QVERIFY( std::count( kde.mTileWritten.constBegin(), kde.mTileWritten.constEnd(), true ) > 1 );
+  QCOMPARE( kde.finalise(), QgsKernelDensityEstimation::Success );
+
+  checkSurface( file, parameters.shape, parameters.outputValues, 0, -1 );
+}
+
+QGSTEST_MAIN( TestQgsKde )
+#include "testqgskde.moc"
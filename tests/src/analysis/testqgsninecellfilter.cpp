@@ -0,0 +1,158 @@
+/***************************************************************************
+  testqgsninecellfilter.cpp
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+
+#include "qgsaspectfilter.h"
+#include "qgshillshadefilter.h"
+#include "qgsruggednessfilter.h"
+#include "qgsslopefilter.h"
+#include "qgstotalcurvaturefilter.h"
+#include "qgis.h"
+
+#include <QDir>
+
+#include <gdal.h>
+
+static QString _tempFile( const QString &name )
+{
+  return QStringLiteral( "%1/ninecelltest-%2.tif" ).arg( QDir::tempPath(), name );
+}
+
+static QVector<float> _readRaster( const QString &file, int &xSize, int &ySize )
+{
+  QVector<float> values;
+  GDALDatasetH ds = GDALOpen( file.toUtf8().constData(), GA_ReadOnly );
+  if ( !ds )
+    return values;
+
+  xSize = GDALGetRasterXSize( ds );
+  ySize = GDALGetRasterYSize( ds );
+  values.resize( xSize * ySize );
+  if ( GDALRasterIO( GDALGetRasterBand( ds, 1 ), GF_Read, 0, 0, xSize, ySize, values.data(), xSize, ySize, GDT_Float32, 0, 0 ) != CE_None )
+    values.clear();
+  GDALClose( ds );
+  return values;
+}
+
+/** \ingroup UnitTests
+ * Checks that the block based processing of the nine cell filters gives the same results
+ * as evaluating the 3x3 window of every cell on its own.
+ */
+class TestQgsNineCellFilter : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void slope();
+    void aspect();
+    void hillshade();
+    void ruggedness();
+    void totalCurvature();
+
+  private:
+    void checkAgainstWindow( QgsNineCellFilter &filter, const QString &outputFile );
+
+    QString mInputFile;
+};
+
+void TestQgsNineCellFilter::initTestCase()
+{
+  GDALAllRegister();
+  //200 x 200 cells, so the raster is processed in more than one block
+  mInputFile = QStringLiteral( TEST_DATA_DIR ) + "/landsat-f32-b1.tif";
+}
+
+void TestQgsNineCellFilter::checkAgainstWindow( QgsNineCellFilter &filter, const QString &outputFile )
+{
+  QCOMPARE( filter.processRaster( nullptr ), 0 );
+
+  int xSize = 0;
+  int ySize = 0;
+  QVector<float> input = _readRaster( mInputFile, xSize, ySize );
+  QVERIFY( !input.isEmpty() );
+
+  int outXSize = 0;
+  int outYSize = 0;
+  QVector<float> output = _readRaster( outputFile, outXSize, outYSize );
+  QCOMPARE( outXSize, xSize );
+  QCOMPARE( outYSize, ySize );
+
+  float nodata = filter.inputNodataValue();
+  auto cell = [&]( int col, int row ) -> float
+  {
+    if ( col < 0 || row < 0 || col >= xSize || row >= ySize )
+      return nodata;
+    return input.at( row * xSize + col );
+  };
+
+  for ( int row = 0; row < ySize; ++row )
+  {
+    for ( int col = 0; col < xSize; ++col )
+    {
+      float x11 = cell( col - 1, row - 1 );
+      float x21 = cell( col, row - 1 );
+      float x31 = cell( col + 1, row - 1 );
+      float x12 = cell( col - 1, row );
+      float x22 = cell( col, row );
+      float x32 = cell( col + 1, row );
+      float x13 = cell( col - 1, row + 1 );
+      float x23 = cell( col, row + 1 );
+      float x33 = cell( col + 1, row + 1 );
+      float expected = filter.processNineCellWindow( &x11, &x21, &x31, &x12, &x22, &x32, &x13, &x23, &x33 );
+      float actual = output.at( row * xSize + col );
+      QVERIFY2( qgsDoubleNear( actual, expected, 1e-4 * qMax( 1.0f, std::fabs( expected ) ) ),
+                QStringLiteral( "Cell %1/%2: expected %3, got %4" ).arg( col ).arg( row ).arg( expected ).arg( actual ).toLocal8Bit().constData() );
+    }
+  }
+}
+
+void TestQgsNineCellFilter::slope()
+{
+  QString outputFile = _tempFile( QStringLiteral( "slope" ) );
+  QgsSlopeFilter filter( mInputFile, outputFile, QStringLiteral( "GTiff" ) );
+  checkAgainstWindow( filter, outputFile );
+}
+
+void TestQgsNineCellFilter::aspect()
+{
+  QString outputFile = _tempFile( QStringLiteral( "aspect" ) );
+  QgsAspectFilter filter( mInputFile, outputFile, QStringLiteral( "GTiff" ) );
+  checkAgainstWindow( filter, outputFile );
+}
+
+void TestQgsNineCellFilter::hillshade()
+{
+  QString outputFile = _tempFile( QStringLiteral( "hillshade" ) );
+  QgsHillshadeFilter filter( mInputFile, outputFile, QStringLiteral( "GTiff" ), 315, 45 );
+  checkAgainstWindow( filter, outputFile );
+}
+
+void TestQgsNineCellFilter::ruggedness()
+{
+  QString outputFile = _tempFile( QStringLiteral( "ruggedness" ) );
+  QgsRuggednessFilter filter( mInputFile, outputFile, QStringLiteral( "GTiff" ) );
+  checkAgainstWindow( filter, outputFile );
+}
+
+void TestQgsNineCellFilter::totalCurvature()
+{
+  QString outputFile = _tempFile( QStringLiteral( "curvature" ) );
+  QgsTotalCurvatureFilter filter( mInputFile, outputFile, QStringLiteral( "GTiff" ) );
+  checkAgainstWindow( filter, outputFile );
+}
+
+QGSTEST_MAIN( TestQgsNineCellFilter )
+#include "testqgsninecellfilter.moc"
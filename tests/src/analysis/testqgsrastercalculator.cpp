@@ -54,6 +54,7 @@ class TestQgsRasterCalculator : public QObject
 
     void rasterRefOp();
     void dualOpRasterRaster(); //test dual op on raster ref and raster ref
+    void nestedOpsByRow(); //test nested ops calculated row by row with reused matrices
 
     void calcWithLayers();
     void calcWithReprojectedLayers();
@@ -421,6 +422,68 @@ void TestQgsRasterCalculator::dualOpRasterRaster()
   QCOMPARE( result.data()[5], -9999.0 );
 }
 
+void TestQgsRasterCalculator::nestedOpsByRow()
+{
+  QgsRasterBlock m1( Qgis::Float32, 2, 3 );
+  m1.setNoDataValue( -1.0 );
+  m1.setValue( 0, 0, 1.0 );
+  m1.setValue( 0, 1, 2.0 );
+  m1.setValue( 1, 0, -2.0 );
+  m1.setValue( 1, 1, -1.0 ); //nodata
+  m1.setValue( 2, 0, 5.0 );
+  m1.setValue( 2, 1, 4.0 );
+  QMap<QString, QgsRasterBlock *> rasterData;
+  rasterData.insert( QStringLiteral( "raster1" ), &m1 );
+
+  QgsRasterBlock m2( Qgis::Float32, 2, 3 );
+  m2.setNoDataValue( -2.0 );
+  m2.setValue( 0, 0, 3.0 );
+  m2.setValue( 0, 1, -2.0 ); //nodata
+  m2.setValue( 1, 0, 13.0 );
+  m2.setValue( 1, 1, 7.0 );
+  m2.setValue( 2, 0, 15.0 );
+  m2.setValue( 2, 1, 0.0 );
+  rasterData.insert( QStringLiteral( "raster2" ), &m2 );
+
+  // ( raster1 + raster2 ) * ( raster1 - 2 ) / raster2
+  QgsRasterCalcNode node( QgsRasterCalcNode::opDIV,
+                          new QgsRasterCalcNode( QgsRasterCalcNode::opMUL,
+                              new QgsRasterCalcNode( QgsRasterCalcNode::opPLUS, new QgsRasterCalcNode( QStringLiteral( "raster1" ) ), new QgsRasterCalcNode( QStringLiteral( "raster2" ) ) ),
+                              new QgsRasterCalcNode( QgsRasterCalcNode::opMINUS, new QgsRasterCalcNode( QStringLiteral( "raster1" ) ), new QgsRasterCalcNode( 2.0 ) ) ),
+                          new QgsRasterCalcNode( QStringLiteral( "raster2" ) ) );
+
+  QgsRasterMatrix result;
+  result.setNodataValue( -9999 );
+  QVERIFY( node.calculate( rasterData, result ) );
+  QCOMPARE( result.nColumns(), 2 );
+  QCOMPARE( result.nRows(), 3 );
+  QVector<double> expected;
+  for ( int i = 0; i < 6; ++i )
+    expected << result.data()[i];
+  QCOMPARE( expected.at( 0 ), -4.0 / 3.0 );
+  QCOMPARE( expected.at( 1 ), -9999.0 );
+  QCOMPARE( expected.at( 2 ), -44.0 / 13.0 );
+  QCOMPARE( expected.at( 3 ), -9999.0 );
+  QCOMPARE( expected.at( 4 ), 4.0 );
+  QCOMPARE( expected.at( 5 ), -9999.0 ); //division by zero
+
+  //same result row by row, reusing the result and scratch matrices
+  QgsRasterMatrix rowResult;
+  rowResult.setNodataValue( -9999 );
+  QList<QgsRasterMatrix *> scratch;
+  for ( int row = 0; row < 3; ++row )
+  {
+    QVERIFY( node.calculate( rasterData, rowResult, row, scratch ) );
+    QCOMPARE( rowResult.nColumns(), 2 );
+    QCOMPARE( rowResult.nRows(), 1 );
+    QCOMPARE( rowResult.data()[0], expected.at( row * 2 ) );
+    QCOMPARE( rowResult.data()[1], expected.at( row * 2 + 1 ) );
+  }
+  //one scratch matrix per level of right operands
+  QCOMPARE( scratch.count(), 2 );
+  qDeleteAll( scratch );
+}
+
 void TestQgsRasterCalculator::calcWithLayers()
 {
   QgsRasterCalculatorEntry entry1;
@@ -0,0 +1,268 @@
+/***************************************************************************
+  testqgsvectorlayerdirector.cpp
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgstestutils.h"
+
+#include "qgsapplication.h"
+#include "qgsgeometry.h"
+#include "qgsgraph.h"
+#include "qgsgraphbuilder.h"
+#include "qgsnetworkdistancestrategy.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerdirector.h"
+
+#include <QThreadPool>
+
+#include <limits>
+#include <memory>
+
+/** \ingroup UnitTests
+ * Compares the graphs built by QgsVectorLayerDirector with the results of a serial build
+ * and of a linear search for the tie points.
+ */
+class TestQgsVectorLayerDirector : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void tiedPointsEquidistant();
+    void topologyToleranceBoundary();
+    void parallelMatchesSerial();
+
+  private:
+
+    //! Builds the graph of \a layer, returns the snapped \a additionalPoints in \a snappedPoints
+    QgsGraph *makeGraph( QgsVectorLayer *layer, double tolerance, const QVector< QgsPoint > &additionalPoints, QVector< QgsPoint > &snappedPoints );
+
+    //! Returns the point of the lines of \a layer closest to \a point, with a linear search of all segments in feature order
+    QgsPoint closestPointLinear( QgsVectorLayer *layer, const QgsPoint &point );
+
+    //! Returns a line layer, in a projected CRS so that the coordinates are the edge lengths
+    QgsVectorLayer *lineLayer( const QList< QgsPolyline > &lines );
+
+    //! Checks that \a graph has the same vertices and edges, in the same order, as \a expected
+    void compareGraphs( const QgsGraph *graph, const QgsGraph *expected );
+};
+
+void TestQgsVectorLayerDirector::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsVectorLayerDirector::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsGraph *TestQgsVectorLayerDirector::makeGraph( QgsVectorLayer *layer, double tolerance, const QVector< QgsPoint > &additionalPoints, QVector< QgsPoint > &snappedPoints )
+{
+  QgsVectorLayerDirector director( layer, -1, QString(), QString(), QString(), QgsVectorLayerDirector::DirectionBoth );
+  director.addStrategy( new QgsNetworkDistanceStrategy() );
+  QgsGraphBuilder builder( layer->crs(), false, tolerance, QStringLiteral( "NONE" ) );
+  director.makeGraph( &builder, additionalPoints, snappedPoints );
+  return builder.graph();
+}
+
+QgsPoint TestQgsVectorLayerDirector::closestPointLinear( QgsVectorLayer *layer, const QgsPoint &point )
+{
+  double bestDist = std::numeric_limits<double>::infinity();
+  QgsPoint bestPoint;
+  QgsFeature feature;
+  QgsFeatureIterator it = layer->getFeatures();
+  while ( it.nextFeature( feature ) )
+  {
+    QgsPolyline line = feature.geometry().asPolyline();
+    for ( int i = 1; i < line.size(); ++i )
+    {
+      QgsPoint segmentPoint;
+      double dist = point.sqrDistToSegment( line.at( i - 1 ).x(), line.at( i - 1 ).y(), line.at( i ).x(), line.at( i ).y(), segmentPoint );
+      // the first segment wins ties
+      if ( dist < bestDist )
+      {
+        bestDist = dist;
+        bestPoint = segmentPoint;
+      }
+    }
+  }
+  return bestPoint;
+}
+
+QgsVectorLayer *TestQgsVectorLayerDirector::lineLayer( const QList< QgsPolyline > &lines )
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "LineString?crs=epsg:3857" ), QStringLiteral( "lines" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( const QgsPolyline &line : lines )
+  {
+    QgsFeature feature;
+    feature.setGeometry( QgsGeometry::fromPolyline( line ) );
+    features << feature;
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+void TestQgsVectorLayerDirector::compareGraphs( const QgsGraph *graph, const QgsGraph *expected )
+{
+  QCOMPARE( graph->vertexCount(), expected->vertexCount() );
+  for ( int i = 0; i < graph->vertexCount(); ++i )
+  {
+    QCOMPARE( graph->vertex( i ).point(), expected->vertex( i ).point() );
+  }
+  QCOMPARE( graph->edgeCount(), expected->edgeCount() );
+  for ( int i = 0; i < graph->edgeCount(); ++i )
+  {
+    QCOMPARE( graph->edge( i ).outVertex(), expected->edge( i ).outVertex() );
+    QCOMPARE( graph->edge( i ).inVertex(), expected->edge( i ).inVertex() );
+    QCOMPARE( graph->edge( i ).cost( 0 ).toDouble(), expected->edge( i ).cost( 0 ).toDouble() );
+  }
+}
+
+void TestQgsVectorLayerDirector::tiedPointsEquidistant()
+{
+  // two parallel lines, the first additional point is exactly between them
+  std::unique_ptr< QgsVectorLayer > layer( lineLayer( QList< QgsPolyline >()
+      << ( QgsPolyline() << QgsPoint( 0, 0 ) << QgsPoint( 10, 0 ) )
+      << ( QgsPolyline() << QgsPoint( 0, 2 ) << QgsPoint( 10, 2 ) ) ) );
+
+  QVector< QgsPoint > additionalPoints = QVector< QgsPoint >() << QgsPoint( 5, 1 ) << QgsPoint( 4, 3 ) << QgsPoint( 10, 1 );
+  QVector< QgsPoint > snappedPoints;
+  std::unique_ptr< QgsGraph > graph( makeGraph( layer.get(), 0.0, additionalPoints, snappedPoints ) );
+
+  // ties go to the first line, as with a linear search
+  QCOMPARE( snappedPoints.size(), 3 );
+  QCOMPARE( snappedPoints.at( 0 ), QgsPoint( 5, 0 ) );
+  QCOMPARE( snappedPoints.at( 1 ), QgsPoint( 4, 2 ) );
+  QCOMPARE( snappedPoints.at( 2 ), QgsPoint( 10, 0 ) );
+  for ( int i = 0; i < additionalPoints.size(); ++i )
+    QCOMPARE( snappedPoints.at( i ), closestPointLinear( layer.get(), additionalPoints.at( i ) ) );
+
+  // the end points and the two points inside the lines, each split line gives four edges
+  QCOMPARE( graph->vertexCount(), 6 );
+  QCOMPARE( graph->edgeCount(), 8 );
+  double totalCost = 0;
+  for ( int i = 0; i < graph->edgeCount(); ++i )
+    totalCost += graph->edge( i ).cost( 0 ).toDouble();
+  QGSCOMPARENEAR( totalCost, 40.0, 1e-9 );
+}
+
+void TestQgsVectorLayerDirector::topologyToleranceBoundary()
+{
+  // with a tolerance of 0.5, points are merged when they fall in the same 0.5 x 0.5 cell, whose
+  // upper bounds are included. (1.5, 0.5) is exactly on a cell bound, and (1.5, 0.5000001) just
+  // beyond it, so they stay separate vertices although they are much closer than the tolerance
+  std::unique_ptr< QgsVectorLayer > layer( lineLayer( QList< QgsPolyline >()
+      << ( QgsPolyline() << QgsPoint( 0, 0 ) << QgsPoint( 1.0, 0.5 ) )
+      << ( QgsPolyline() << QgsPoint( 1.0, 0.5 ) << QgsPoint( 1.5, 0.5 ) )
+      << ( QgsPolyline() << QgsPoint( 1.5, 0.5 ) << QgsPoint( 1.5, 0.5000001 ) << QgsPoint( 3, 3 ) ) ) );
+
+  QVector< QgsPoint > additionalPoints = QVector< QgsPoint >() << QgsPoint( 1.5, 0.4 );
+  QVector< QgsPoint > snappedPoints;
+  std::unique_ptr< QgsGraph > graph( makeGraph( layer.get(), 0.5, additionalPoints, snappedPoints ) );
+  QCOMPARE( snappedPoints.at( 0 ), QgsPoint( 1.5, 0.5 ) );
+
+  int boundVertex = -1;
+  int beyondVertex = -1;
+  for ( int i = 0; i < graph->vertexCount(); ++i )
+  {
+    if ( graph->vertex( i ).point() == QgsPoint( 1.5, 0.5 ) )
+      boundVertex = i;
+    else if ( graph->vertex( i ).point() == QgsPoint( 1.5, 0.5000001 ) )
+      beyondVertex = i;
+  }
+  QVERIFY( boundVertex >= 0 );
+  QVERIFY( beyondVertex >= 0 );
+  bool connected = false;
+  for ( int i = 0; i < graph->edgeCount(); ++i )
+  {
+    const QgsGraphEdge &edge = graph->edge( i );
+    QVERIFY( edge.outVertex() != edge.inVertex() );
+    if ( edge.outVertex() == boundVertex && edge.inVertex() == beyondVertex )
+    {
+      connected = true;
+      QGSCOMPARENEAR( edge.cost( 0 ).toDouble(), 0.0000001, 1e-12 );
+    }
+  }
+  QVERIFY( connected );
+
+  // the same build on a single thread gives the same graph
+  int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  QVector< QgsPoint > serialSnappedPoints;
+  std::unique_ptr< QgsGraph > serialGraph( makeGraph( layer.get(), 0.5, additionalPoints, serialSnappedPoints ) );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QCOMPARE( serialSnappedPoints, snappedPoints );
+  compareGraphs( graph.get(), serialGraph.get() );
+}
+
+void TestQgsVectorLayerDirector::parallelMatchesSerial()
+{
+  // more lines than fit in a single batch, on a grid so that many points are shared and
+  // many additional points are at the same distance of several segments
+  QList< QgsPolyline > lines;
+  quint32 seed = 1;
+  auto random = [&seed]( int range )
+  {
+    seed = seed * 1103515245 + 12345;
+    return static_cast< int >( ( seed >> 16 ) % range );
+  };
+  for ( int i = 0; i < 2500; ++i )
+  {
+    QgsPolyline line;
+    int x = random( 100 );
+    int y = random( 100 );
+    line << QgsPoint( x, y );
+    for ( int j = random( 3 ); j >= 0; --j )
+    {
+      if ( random( 2 ) )
+        x += random( 5 ) + 1;
+      else
+        y += random( 5 ) + 1;
+      line << QgsPoint( x, y );
+    }
+    lines << line;
+  }
+  std::unique_ptr< QgsVectorLayer > layer( lineLayer( lines ) );
+
+  QVector< QgsPoint > additionalPoints;
+  for ( int i = 0; i < 500; ++i )
+  {
+    // half integer coordinates are often equidistant from two segments
+    additionalPoints << QgsPoint( random( 200 ) / 2.0, random( 200 ) / 2.0 );
+  }
+
+  QVector< QgsPoint > snappedPoints;
+  std::unique_ptr< QgsGraph > graph( makeGraph( layer.get(), 0.0, additionalPoints, snappedPoints ) );
+
+  int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  QVector< QgsPoint > serialSnappedPoints;
+  std::unique_ptr< QgsGraph > serialGraph( makeGraph( layer.get(), 0.0, additionalPoints, serialSnappedPoints ) );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+
+  QCOMPARE( snappedPoints, serialSnappedPoints );
+  for ( int i = 0; i < additionalPoints.size(); ++i )
+  {
+    QCOMPARE( snappedPoints.at( i ), closestPointLinear( layer.get(), additionalPoints.at( i ) ) );
+  }
+
+  compareGraphs( graph.get(), serialGraph.get() );
+}
+
+QGSTEST_MAIN( TestQgsVectorLayerDirector )
+#include "testqgsvectorlayerdirector.moc"
@@ -15,6 +15,7 @@
 
 #include <QDir>
 #include "qgstest.h"
+#include "qgstestutils.h"
 
 #include "qgsapplication.h"
 #include "qgsfeatureiterator.h"
@@ -22,6 +23,10 @@
 #include "qgsrasterlayer.h"
 #include "qgszonalstatistics.h"
 #include "qgsproject.h"
+#include "qgsvectordataprovider.h"
+#include "qgsgeometry.h"
+
+#include <QTextStream>
 
 /** \ingroup UnitTests
  * This is a unit test for the zonal statistics class
@@ -37,10 +42,13 @@ class TestQgsZonalStatistics : public QObject
     void cleanup() {}
 
     void testStatistics();
+    void testMultipleBands();
+    void testBatches();
 
   private:
     QgsVectorLayer *mVectorLayer = nullptr;
     QgsRasterLayer *mRasterLayer = nullptr;
+    QString mTempPath;
 };
 
 void TestQgsZonalStatistics::initTestCase()
@@ -52,6 +60,7 @@ void TestQgsZonalStatistics::initTestCase()
   QString myDataPath( TEST_DATA_DIR ); //defined in CmakeLists.txt
   QString myTestDataPath = myDataPath + "/zonalstatistics/";
   QString myTempPath = QDir::tempPath() + '/';
+  mTempPath = myTempPath;
 
   // copy test data to temp directory
   QDir testDir( myTestDataPath );
@@ -175,5 +184,116 @@ void TestQgsZonalStatistics::testStatistics()
   QCOMPARE( f.attribute( "myqgis2_va" ).toDouble(), 2.0 );
 }
 
+void TestQgsZonalStatistics::testMultipleBands()
+{
+  // copy of the polygons, so that the fields added by the other test do not interfere
+  QStringList extensions = QStringList() << "shp" << "shx" << "dbf" << "prj";
+  Q_FOREACH ( const QString &extension, extensions )
+  {
+    QFile::remove( mTempPath + "polys_bands." + extension );
+    QVERIFY( QFile::copy( QStringLiteral( TEST_DATA_DIR ) + "/zonalstatistics/polys." + extension, mTempPath + "polys_bands." + extension ) );
+  }
+  QgsVectorLayer polygons( mTempPath + "polys_bands.shp", QStringLiteral( "poly" ), QStringLiteral( "ogr" ) );
+  QVERIFY( polygons.isValid() );
+
+  // the second band holds 2 * value + 1 of the first one
+  QFile vrtFile( mTempPath + "edge_problem_bands.vrt" );
+  QVERIFY( vrtFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+  QTextStream vrt( &vrtFile );
+  vrt << "<VRTDataset rasterXSize=\"4\" rasterYSize=\"3\">\n"
+      << "  <GeoTransform>100.379357, 0.000045, 0, -0.960453, 0, -0.000045</GeoTransform>\n"
+      << "  <VRTRasterBand dataType=\"Float32\" band=\"1\">\n"
+      << "    <NoDataValue>nan</NoDataValue>\n"
+      << "    <SimpleSource><SourceFilename relativeToVRT=\"1\">edge_problem.asc</SourceFilename><SourceBand>1</SourceBand></SimpleSource>\n"
+      << "  </VRTRasterBand>\n"
+      << "  <VRTRasterBand dataType=\"Float32\" band=\"2\">\n"
+      << "    <NoDataValue>nan</NoDataValue>\n"
+      << "    <ComplexSource><SourceFilename relativeToVRT=\"1\">edge_problem.asc</SourceFilename><SourceBand>1</SourceBand>"
+      << "<ScaleOffset>1</ScaleOffset><ScaleRatio>2</ScaleRatio></ComplexSource>\n"
+      << "  </VRTRasterBand>\n"
+      << "</VRTDataset>\n";
+  vrtFile.close();
+  QgsRasterLayer raster( mTempPath + "edge_problem_bands.vrt", QStringLiteral( "raster" ), QStringLiteral( "gdal" ) );
+  QVERIFY( raster.isValid() );
+  QCOMPARE( raster.bandCount(), 2 );
+
+  QgsZonalStatistics zs( &polygons, &raster, QList<int>() << 1 << 2, QStringLiteral( "b" ),
+                         QgsZonalStatistics::Count | QgsZonalStatistics::Sum | QgsZonalStatistics::Mean );
+  QCOMPARE( zs.calculateStatistics( nullptr ), 0 );
+
+  QgsFeature f;
+  QgsFeatureRequest request;
+  request.setFilterFid( 0 );
+  QVERIFY( polygons.getFeatures( request ).nextFeature( f ) );
+  QCOMPARE( f.attribute( "b1_count" ).toDouble(), 12.0 );
+  QCOMPARE( f.attribute( "b1_sum" ).toDouble(), 8.0 );
+  QCOMPARE( f.attribute( "b2_count" ).toDouble(), 12.0 );
+  QCOMPARE( f.attribute( "b2_sum" ).toDouble(), 28.0 );
+  QGSCOMPARENEAR( f.attribute( "b2_mean" ).toDouble(), 2.333333333333333, 0.0000001 );
+
+  request.setFilterFid( 1 );
+  QVERIFY( polygons.getFeatures( request ).nextFeature( f ) );
+  QCOMPARE( f.attribute( "b1_count" ).toDouble(), 9.0 );
+  QCOMPARE( f.attribute( "b1_sum" ).toDouble(), 5.0 );
+  QCOMPARE( f.attribute( "b2_count" ).toDouble(), 9.0 );
+  QCOMPARE( f.attribute( "b2_sum" ).toDouble(), 19.0 );
+  QGSCOMPARENEAR( f.attribute( "b2_mean" ).toDouble(), 2.111111111111111, 0.0000001 );
+
+  request.setFilterFid( 2 );
+  QVERIFY( polygons.getFeatures( request ).nextFeature( f ) );
+  QCOMPARE( f.attribute( "b1_count" ).toDouble(), 6.0 );
+  QCOMPARE( f.attribute( "b1_sum" ).toDouble(), 5.0 );
+  QCOMPARE( f.attribute( "b2_count" ).toDouble(), 6.0 );
+  QCOMPARE( f.attribute( "b2_sum" ).toDouble(), 16.0 );
+  QGSCOMPARENEAR( f.attribute( "b2_mean" ).toDouble(), 2.666666666666667, 0.0000001 );
+
+  // invalid band
+  QgsZonalStatistics invalidBand( &polygons, &raster, QList<int>() << 1 << 3, QStringLiteral( "x" ) );
+  QCOMPARE( invalidBand.calculateStatistics( nullptr ), 4 );
+}
+
+void TestQgsZonalStatistics::testBatches()
+{
+  // more features than fit in a single batch, each one covering 64% of a single cell, so that
+  // the precise intersection is used and every feature gets the value of its own cell
+  const double originX = 100.379357;
+  const double originY = -0.960453;
+  const double cellSize = 0.000045;
+  const float values[3][4] = { { 1, 1, 0, 0 }, { 1, 1, 0, 0 }, { 1, 1, 1, 1 } };
+
+  QgsVectorLayer cells( QStringLiteral( "Polygon?crs=epsg:4326&field=row:integer&field=col:integer" ), QStringLiteral( "cells" ), QStringLiteral( "memory" ) );
+  QVERIFY( cells.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 2500; ++i )
+  {
+    int row = ( i / 4 ) % 3;
+    int col = i % 4;
+    double xMin = originX + ( col + 0.1 ) * cellSize;
+    double xMax = originX + ( col + 0.9 ) * cellSize;
+    double yMax = originY - ( row + 0.1 ) * cellSize;
+    double yMin = originY - ( row + 0.9 ) * cellSize;
+    QgsFeature feature( cells.fields() );
+    feature.setAttributes( QgsAttributes() << row << col );
+    feature.setGeometry( QgsGeometry::fromRect( QgsRectangle( xMin, yMin, xMax, yMax ) ) );
+    features << feature;
+  }
+  QVERIFY( cells.dataProvider()->addFeatures( features ) );
+
+  QgsZonalStatistics zs( &cells, mRasterLayer, QStringLiteral( "z" ), 1, QgsZonalStatistics::Count | QgsZonalStatistics::Sum );
+  QCOMPARE( zs.calculateStatistics( nullptr ), 0 );
+
+  int checked = 0;
+  QgsFeature f;
+  QgsFeatureIterator it = cells.getFeatures();
+  while ( it.nextFeature( f ) )
+  {
+    float value = values[ f.attribute( "row" ).toInt()][ f.attribute( "col" ).toInt()];
+    QGSCOMPARENEAR( f.attribute( "zcount" ).toDouble(), 0.64, 0.000001 );
+    QGSCOMPARENEAR( f.attribute( "zsum" ).toDouble(), 0.64 * value, 0.000001 );
+    ++checked;
+  }
+  QCOMPARE( checked, 2500 );
+}
+
 QGSTEST_MAIN( TestQgsZonalStatistics )
 #include "testqgszonalstatistics.moc"
@@ -1248,6 +1248,175 @@ class TestQgsExpression: public QObject
       QCOMPARE( res2.type(), QVariant::Invalid );
     }
 
+    void eval_compiled_data()
+    {
+      QTest::addColumn<QString>( "string" );
+      QTest::addColumn<bool>( "evalError" );
+      QTest::addColumn<QVariant>( "result" );
+
+      QTest::newRow( "int plus" ) << "\"int\" + 1" << false << QVariant( qlonglong( 6 ) );
+      QTest::newRow( "int division" ) << "\"int\" / 2" << false << QVariant( 2.5 );
+      QTest::newRow( "int integer division" ) << "\"int\" // 2" << false << QVariant( 2 );
+      QTest::newRow( "int modulo zero" ) << "\"int\" % 0" << false << QVariant();
+      QTest::newRow( "double times" ) << "\"double\" * 2" << false << QVariant( 5.0 );
+      QTest::newRow( "null plus" ) << "\"null\" + 1" << false << QVariant();
+      QTest::newRow( "double plus string" ) << "\"double\" + \"string\"" << true << QVariant();
+      QTest::newRow( "negate" ) << "-\"int\"" << false << QVariant( qlonglong( -5 ) );
+      QTest::newRow( "compare numbers" ) << "\"int\" > \"double\"" << false << QVariant( 1 );
+      QTest::newRow( "compare strings" ) << "\"string\" = 'abc'" << false << QVariant( 1 );
+      QTest::newRow( "compare null" ) << "\"null\" = 1" << false << QVariant();
+      QTest::newRow( "concat" ) << "\"string\" || 'def'" << false << QVariant( "abcdef" );
+      QTest::newRow( "not" ) << "not ( \"int\" = 5 )" << false << QVariant( 0 );
+      QTest::newRow( "unknown and true" ) << "\"null\" = 1 and \"int\" = 5" << false << QVariant();
+      QTest::newRow( "false and skipped" ) << "\"int\" = 4 and \"string\" / 2 > 0" << false << QVariant( 0 );
+      QTest::newRow( "true or skipped" ) << "\"int\" = 5 or \"string\" / 2 > 0" << false << QVariant( 1 );
+      QTest::newRow( "true and error" ) << "\"int\" = 5 and \"string\" / 2 > 0" << true << QVariant();
+      QTest::newRow( "case" ) << "case when \"int\" > 10 then 'big' when \"int\" > 2 then 'medium' else 'small' end" << false << QVariant( "medium" );
+      QTest::newRow( "case without else" ) << "case when \"int\" > 10 then 'big' end" << false << QVariant();
+      QTest::newRow( "sqrt" ) << "sqrt( \"int\" + 4 )" << false << QVariant( 3.0 );
+      QTest::newRow( "ln null" ) << "ln( \"int\" - 5 )" << false << QVariant();
+      QTest::newRow( "abs string" ) << "abs( \"string\" )" << true << QVariant();
+      QTest::newRow( "in" ) << "\"int\" in ( 4, 5 )" << false << QVariant( 1 );
+      QTest::newRow( "function" ) << "upper( \"string\" ) || \"int\"" << false << QVariant( "ABC5" );
+      QTest::newRow( "static part" ) << "\"int\" * ( 2 + 3 )" << false << QVariant( qlonglong( 25 ) );
+    }
+
+    void eval_compiled()
+    {
+      QFETCH( QString, string );
+      QFETCH( bool, evalError );
+      QFETCH( QVariant, result );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "double" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "string" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "null" ), QVariant::Int ) );
+
+      QgsFeature f;
+      f.setFields( fields );
+      f.setAttributes( QgsAttributes() << QVariant( 5 ) << QVariant( 2.5 ) << QVariant( "abc" ) << QVariant( QVariant::Int ) );
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+
+      // an unprepared expression is evaluated by the tree, a prepared one by the compiled program
+      QgsExpression tree( string );
+      QVariant treeResult = tree.evaluate( &context );
+      QCOMPARE( tree.hasEvalError(), evalError );
+
+      QgsExpression exp( string );
+      QVERIFY( exp.prepare( &context ) );
+      for ( int i = 0; i < 2; ++i )
+      {
+        QVariant res = exp.evaluate( &context );
+        QCOMPARE( exp.hasEvalError(), evalError );
+        QCOMPARE( res.type(), result.type() );
+        QCOMPARE( res, result );
+        QCOMPARE( res.type(), treeResult.type() );
+        QCOMPARE( res, treeResult );
+      }
+    }
+
+    void eval_batch_data()
+    {
+      QTest::addColumn<QString>( "string" );
+
+      QTest::newRow( "arithmetic" ) << "\"int\" * 2 + \"double\"";
+      QTest::newRow( "division" ) << "\"int\" / \"double\"";
+      QTest::newRow( "integer division" ) << "\"double\" // \"int\"";
+      QTest::newRow( "modulo" ) << "\"int\" % 3";
+      QTest::newRow( "power" ) << "\"int\" ^ 2";
+      QTest::newRow( "comparison" ) << "\"int\" > 1 and \"double\" <= 2.5 or not ( \"int\" = 2 )";
+      QTest::newRow( "negate" ) << "-\"int\" - \"double\"";
+      QTest::newRow( "math" ) << "sqrt( \"double\" ) + ln( \"int\" )";
+      QTest::newRow( "not vectorized" ) << "upper( \"string\" ) || \"int\"";
+      QTest::newRow( "case" ) << "case when \"int\" > 1 then \"double\" else 0 end";
+    }
+
+    void eval_batch()
+    {
+      QFETCH( QString, string );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "double" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "string" ), QVariant::String ) );
+
+      // rows with NULL values, zeros and a string are evaluated one by one
+      QList< QVariantList > columns;
+      columns << ( QVariantList() << 1 << 2 << 0 << QVariant( QVariant::Int ) << -3 << 4 )
+              << ( QVariantList() << 2.5 << 0.0 << 1.5 << 3.0 << QVariant( QVariant::Double ) << QVariant( "7" ) )
+              << ( QVariantList() << "a" << "b" << "c" << "d" << "e" << "f" );
+
+      QgsFeatureList features;
+      for ( int row = 0; row < columns.at( 0 ).size(); ++row )
+      {
+        QgsFeature f( fields, row );
+        f.setAttributes( QgsAttributes() << columns.at( 0 ).at( row ) << columns.at( 1 ).at( row ) << columns.at( 2 ).at( row ) );
+        features << f;
+      }
+
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( QgsFeature( 100 ), fields );
+      QgsExpression exp( string );
+      QVERIFY( exp.prepare( &context ) );
+
+      QVariantList expected;
+      Q_FOREACH ( const QgsFeature &f, features )
+      {
+        QgsExpressionContext featureContext = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+        expected << exp.evaluate( &featureContext );
+      }
+
+      QVariantList results = exp.evaluate( features, &context );
+      QCOMPARE( results.size(), expected.size() );
+      for ( int i = 0; i < results.size(); ++i )
+      {
+        QCOMPARE( results.at( i ).type(), expected.at( i ).type() );
+        QCOMPARE( results.at( i ), expected.at( i ) );
+      }
+      QCOMPARE( context.feature().id(), QgsFeatureId( 100 ) );
+
+      results = exp.evaluateColumns( columns, features.size(), &context );
+      QCOMPARE( results.size(), expected.size() );
+      for ( int i = 0; i < results.size(); ++i )
+      {
+        QCOMPARE( results.at( i ).type(), expected.at( i ).type() );
+        QCOMPARE( results.at( i ), expected.at( i ) );
+      }
+    }
+
+    void eval_cached_functions()
+    {
+      QgsFields fields;
+      QgsFeature f( fields, 1 );
+      f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 2 0, 2 2, 0 2, 0 0))" ) ) );
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+
+      QgsExpression exp( QStringLiteral( "area(buffer($geometry, 1)) > 4" ) );
+      QCOMPARE( exp.evaluate( &context ).toBool(), true );
+
+      // the buffer is cached for the geometry of the feature, and for the same distance only
+      QVariant cached;
+      QVERIFY( context.cachedFunctionResult( QStringLiteral( "buffer" ), QVariantList() << QVariant::fromValue( f.geometry() ) << 1, cached ) );
+      QVERIFY( cached.value< QgsGeometry >().area() > 4 );
+      QVERIFY( !context.cachedFunctionResult( QStringLiteral( "buffer" ), QVariantList() << QVariant::fromValue( f.geometry() ) << 2, cached ) );
+      // an equal geometry which is not shared with the feature is not matched
+      QVERIFY( !context.cachedFunctionResult( QStringLiteral( "buffer" ), QVariantList() << QVariant::fromValue( QgsGeometry::fromWkt( f.geometry().exportToWkt() ) ) << 1, cached ) );
+
+      QgsExpression areaExp( QStringLiteral( "$area" ) );
+      QCOMPARE( areaExp.evaluate( &context ).toDouble(), 4.0 );
+
+      // a new geometry is not matched by the results cached for the previous one
+      f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 1 0, 1 1, 0 1, 0 0))" ) ) );
+      context.setFeature( f );
+      QCOMPARE( areaExp.evaluate( &context ).toDouble(), 1.0 );
+      QCOMPARE( exp.evaluate( &context ).toBool(), true );
+      QgsExpression smallBuffer( QStringLiteral( "area(buffer($geometry, 0.1)) < 2" ) );
+      QCOMPARE( smallBuffer.evaluate( &context ).toBool(), true );
+
+      context.clearCachedValues();
+      QVERIFY( !context.cachedFunctionResult( QStringLiteral( "buffer" ), QVariantList() << QVariant::fromValue( f.geometry() ) << 1, cached ) );
+    }
+
     void eval_feature_id()
     {
       QgsFeature f( 100 );
@@ -1546,6 +1715,92 @@ class TestQgsExpression: public QObject
       QCOMPARE( res, result );
     }
 
+    void layerAggregateCache()
+    {
+      QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?field=col1:integer" ), QStringLiteral( "cache_layer" ), QStringLiteral( "memory" ) );
+      QgsFeature f1( layer->fields() );
+      f1.setAttribute( QStringLiteral( "col1" ), 4 );
+      QgsFeature f2( layer->fields() );
+      f2.setAttribute( QStringLiteral( "col1" ), 2 );
+      layer->dataProvider()->addFeatures( QgsFeatureList() << f1 << f2 );
+      QgsProject::instance()->addMapLayer( layer );
+
+      QgsExpression exp( QStringLiteral( "aggregate('cache_layer','sum',\"col1\" * 2)" ) );
+      QgsExpressionContext context;
+      QCOMPARE( exp.evaluate( &context ).toInt(), 12 );
+
+      // the aggregates are not cached by default, the writes made through the provider are seen
+      QVERIFY( !layer->aggregateCacheEnabled() );
+      QgsFeature providerFeature( layer->fields() );
+      providerFeature.setAttribute( QStringLiteral( "col1" ), 1 );
+      QgsFeatureList providerFeatures = QgsFeatureList() << providerFeature;
+      QVERIFY( layer->dataProvider()->addFeatures( providerFeatures ) );
+      context = QgsExpressionContext();
+      QCOMPARE( exp.evaluate( &context ).toInt(), 14 );
+      QgsChangedAttributesMap changedValues;
+      changedValues[ providerFeatures.at( 0 ).id()][ 0 ] = 3;
+      QVERIFY( layer->dataProvider()->changeAttributeValues( changedValues ) );
+      context = QgsExpressionContext();
+      QCOMPARE( exp.evaluate( &context ).toInt(), 18 );
+      QVERIFY( layer->dataProvider()->deleteFeatures( QgsFeatureIds() << providerFeatures.at( 0 ).id() ) );
+      context = QgsExpressionContext();
+      QCOMPARE( exp.evaluate( &context ).toInt(), 12 );
+
+      layer->setAggregateCacheEnabled( true );
+      QVERIFY( layer->aggregateCacheEnabled() );
+
+      // the cached aggregates are discarded when the layer is edited
+      QgsFeature f;
+      QVERIFY( layer->getFeatures( QStringLiteral( "col1 = 2" ) ).nextFeature( f ) );
+      QVERIFY( layer->startEditing() );
+      QVERIFY( layer->changeAttributeValue( f.id(), 0, 5 ) );
+      context = QgsExpressionContext();
+      QCOMPARE( exp.evaluate( &context ).toInt(), 18 );
+      QVERIFY( layer->rollBack() );
+      context = QgsExpressionContext();
+      QCOMPARE( exp.evaluate( &context ).toInt(), 12 );
+
+      bool ok = false;
+      QCOMPARE( layer->aggregate( QgsAggregateCalculator::Max, QStringLiteral( "col1" ), QgsAggregateCalculator::AggregateParameters(), nullptr, &ok ).toInt(), 4 );
+      QVERIFY( ok );
+      QVERIFY( layer->startEditing() );
+      QgsFeature f3( layer->fields() );
+      f3.setAttribute( QStringLiteral( "col1" ), 7 );
+      QVERIFY( layer->addFeature( f3 ) );
+      QCOMPARE( layer->aggregate( QgsAggregateCalculator::Max, QStringLiteral( "col1" ), QgsAggregateCalculator::AggregateParameters(), nullptr, &ok ).toInt(), 7 );
+      QVERIFY( layer->commitChanges() );
+      QCOMPARE( layer->aggregate( QgsAggregateCalculator::Max, QStringLiteral( "col1" ), QgsAggregateCalculator::AggregateParameters(), nullptr, &ok ).toInt(), 7 );
+      context = QgsExpressionContext();
+      QCOMPARE( exp.evaluate( &context ).toInt(), 26 );
+
+      // the writes made through the provider are not reported, until the provider is reloaded
+      QVERIFY( layer->getFeatures( QStringLiteral( "col1 = 7" ) ).nextFeature( f ) );
+      changedValues.clear();
+      changedValues[ f.id()][ 0 ] = 1;
+      QVERIFY( layer->dataProvider()->changeAttributeValues( changedValues ) );
+      context = QgsExpressionContext();
+      QCOMPARE( exp.evaluate( &context ).toInt(), 26 );
+      layer->dataProvider()->forceReload();
+      context = QgsExpressionContext();
+      QCOMPARE( exp.evaluate( &context ).toInt(), 14 );
+
+      // the aggregates of the virtual fields are not cached
+      layer->addExpressionField( QStringLiteral( "\"col1\" * 10" ), QgsField( QStringLiteral( "virtual" ), QVariant::Int ) );
+      QCOMPARE( layer->aggregate( QgsAggregateCalculator::Sum, QStringLiteral( "virtual" ), QgsAggregateCalculator::AggregateParameters(), nullptr, &ok ).toInt(), 70 );
+      QVERIFY( ok );
+      changedValues[ f.id()][ 0 ] = 3;
+      QVERIFY( layer->dataProvider()->changeAttributeValues( changedValues ) );
+      QCOMPARE( layer->aggregate( QgsAggregateCalculator::Sum, QStringLiteral( "virtual" ), QgsAggregateCalculator::AggregateParameters(), nullptr, &ok ).toInt(), 90 );
+      QCOMPARE( layer->aggregate( QgsAggregateCalculator::Sum, QStringLiteral( "\"virtual\" / 10" ), QgsAggregateCalculator::AggregateParameters(), nullptr, &ok ).toInt(), 9 );
+
+      // disabling the cache discards the cached aggregates
+      layer->setAggregateCacheEnabled( false );
+      context = QgsExpressionContext();
+      QCOMPARE( exp.evaluate( &context ).toInt(), 18 );
+
+      QgsProject::instance()->removeMapLayer( layer );
+    }
+
     void relationAggregate_data()
     {
       QTest::addColumn<QString>( "string" );
@@ -1687,6 +1942,21 @@ class TestQgsExpression: public QObject
       QCOMPARE( refVar, expectedVars );
     }
 
+    void referenced_functions()
+    {
+      QSet<QString> expectedFunctions;
+      expectedFunctions << QStringLiteral( "intersects" )
+                        << QStringLiteral( "buffer" )
+                        << QStringLiteral( "$geometry" )
+                        << QStringLiteral( "var" )
+                        << QStringLiteral( "upper" )
+                        << QStringLiteral( "abs" );
+      QgsExpression exp( QStringLiteral( "CASE WHEN intersects(buffer($geometry, 1), @bar) THEN upper(\"a\") ELSE 'b' END IN ('A', abs(\"c\"))" ) );
+      QCOMPARE( exp.hasParserError(), false );
+
+      QCOMPARE( exp.referencedFunctions(), expectedFunctions );
+    }
+
     void referenced_columns_all_attributes()
     {
       QgsExpression exp( QStringLiteral( "attribute($currentfeature,'test')" ) );
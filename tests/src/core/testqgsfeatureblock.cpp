@@ -0,0 +1,275 @@
+/***************************************************************************
+     testqgsfeatureblock.cpp
+     -----------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+
+#include "qgsfeature.h"
+#include "qgsfeatureblock.h"
+#include "qgsfeaturestore.h"
+#include "qgsfield.h"
+#include "qgsfields.h"
+#include "qgsgeometry.h"
+
+class TestQgsFeatureBlock: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init();// will be called before each testfunction is executed.
+    void cleanup();// will be called after every testfunction.
+    void create();
+    void typedValues(); //test values round trip with their type
+    void mixedTypes(); //test column falling back to QVariant
+    void attributeCount();
+    void idGeometryValidity();
+    void implicitSharing();
+    void featureStore();
+
+  private:
+
+    QgsFields mFields;
+};
+
+void TestQgsFeatureBlock::initTestCase()
+{
+  mFields.append( QgsField( QStringLiteral( "int" ), QVariant::Int ) );
+  mFields.append( QgsField( QStringLiteral( "bool" ), QVariant::Bool ) );
+  mFields.append( QgsField( QStringLiteral( "longlong" ), QVariant::LongLong ) );
+  mFields.append( QgsField( QStringLiteral( "double" ), QVariant::Double ) );
+  mFields.append( QgsField( QStringLiteral( "string" ), QVariant::String ) );
+  mFields.append( QgsField( QStringLiteral( "date" ), QVariant::Date ) );
+}
+
+void TestQgsFeatureBlock::cleanupTestCase()
+{
+
+}
+
+void TestQgsFeatureBlock::init()
+{
+
+}
+
+void TestQgsFeatureBlock::cleanup()
+{
+
+}
+
+void TestQgsFeatureBlock::create()
+{
+  QgsFeatureBlock block( mFields );
+  QVERIFY( block.isEmpty() );
+  QCOMPARE( block.count(), 0 );
+  QCOMPARE( block.fields(), mFields );
+  QVERIFY( block.features().isEmpty() );
+}
+
+void TestQgsFeatureBlock::typedValues()
+{
+  QgsFeatureBlock block( mFields );
+
+  QgsFeature f1( mFields, 1 );
+  f1.setAttributes( QgsAttributes() << 5 << true << QVariant( 1234567890123LL ) << 5.5 << QStringLiteral( "first" ) << QDate( 2017, 1, 2 ) );
+  block.append( f1 );
+
+  QgsFeature f2( mFields, 2 );
+  f2.setAttributes( QgsAttributes() << QVariant( QVariant::Int ) << QVariant( QVariant::Bool ) << QVariant( QVariant::LongLong )
+                    << QVariant( QVariant::Double ) << QVariant( QVariant::String ) << QVariant( QVariant::Date ) );
+  block.append( f2 );
+
+  QgsFeature f3( mFields, 3 );
+  f3.setAttributes( QgsAttributes() << QVariant() << false << QVariant() << -1.0 << QString( "" ) << QVariant() );
+  block.append( f3 );
+
+  QgsFeature f4( mFields, 4 );
+  f4.setAttributes( QgsAttributes() << -3 << true << QVariant( -1LL ) << 0.0 << QStringLiteral( "última" ) << QDate( 2017, 3, 4 ) );
+  block.append( f4 );
+
+  QCOMPARE( block.count(), 4 );
+
+  QList< QgsFeature > expected = QList< QgsFeature >() << f1 << f2 << f3 << f4;
+  for ( int i = 0; i < expected.count(); ++i )
+  {
+    QgsAttributes attributes = block.attributes( i );
+    QgsAttributes expectedAttributes = expected.at( i ).attributes();
+    QCOMPARE( attributes.count(), expectedAttributes.count() );
+    for ( int j = 0; j < attributes.count(); ++j )
+    {
+      QCOMPARE( attributes.at( j ).type(), expectedAttributes.at( j ).type() );
+      QCOMPARE( attributes.at( j ).isNull(), expectedAttributes.at( j ).isNull() );
+      QCOMPARE( attributes.at( j ), expectedAttributes.at( j ) );
+      QCOMPARE( block.attribute( i, j ), expectedAttributes.at( j ) );
+    }
+  }
+
+  // empty and null strings are kept apart
+  QVERIFY( !block.attribute( 2, 4 ).isNull() );
+  QCOMPARE( block.attribute( 2, 4 ).toString(), QString( "" ) );
+  QVERIFY( block.attribute( 1, 4 ).isNull() );
+
+  // out of range attributes
+  QVERIFY( !block.attribute( 0, -1 ).isValid() );
+  QVERIFY( !block.attribute( 0, 6 ).isValid() );
+}
+
+void TestQgsFeatureBlock::mixedTypes()
+{
+  QgsFeatureBlock block( mFields );
+
+  QgsFeature f1( mFields, 1 );
+  f1.setAttributes( QgsAttributes() << 5 << true << QVariant( 2LL ) << 1.5 << QStringLiteral( "a" ) << QVariant() );
+  block.append( f1 );
+  QgsFeature f2( mFields, 2 );
+  // values of another type than the field
+  f2.setAttributes( QgsAttributes() << QStringLiteral( "not an int" ) << 3 << QVariant( 3 ) << QVariant( 7LL ) << 8 << QVariant() );
+  block.append( f2 );
+  QgsFeature f3( mFields, 3 );
+  f3.setAttributes( QgsAttributes() << 7 << false << QVariant( 4LL ) << 2.5 << QStringLiteral( "c" ) << QVariant() );
+  block.append( f3 );
+
+  QCOMPARE( block.attributes( 0 ), f1.attributes() );
+  QCOMPARE( block.attributes( 1 ), f2.attributes() );
+  QCOMPARE( block.attributes( 2 ), f3.attributes() );
+  QCOMPARE( block.attribute( 1, 0 ).type(), QVariant::String );
+  QCOMPARE( block.attribute( 1, 2 ).type(), QVariant::Int );
+  QCOMPARE( block.attribute( 2, 2 ).type(), QVariant::LongLong );
+  QCOMPARE( block.attribute( 0, 1 ).type(), QVariant::Bool );
+}
+
+void TestQgsFeatureBlock::attributeCount()
+{
+  // block without fields, the columns are typed from the first value
+  QgsFeatureBlock block;
+
+  QgsFeature f1( 1 );
+  f1.setAttributes( QgsAttributes() << 1 );
+  block.append( f1 );
+  QgsFeature f2( 2 );
+  f2.setAttributes( QgsAttributes() << 2 << QStringLiteral( "b" ) << 2.5 );
+  block.append( f2 );
+  QgsFeature f3( 3 );
+  block.append( f3 );
+  QgsFeature f4( 4 );
+  f4.setAttributes( QgsAttributes() << 4 << QStringLiteral( "d" ) );
+  block.append( f4 );
+
+  QCOMPARE( block.count(), 4 );
+  QCOMPARE( block.attributes( 0 ), f1.attributes() );
+  QCOMPARE( block.attributes( 1 ), f2.attributes() );
+  QCOMPARE( block.attributes( 2 ), f3.attributes() );
+  QCOMPARE( block.attributes( 3 ), f4.attributes() );
+  QVERIFY( !block.attribute( 0, 1 ).isValid() );
+  QVERIFY( !block.attribute( 3, 2 ).isValid() );
+}
+
+void TestQgsFeatureBlock::idGeometryValidity()
+{
+  QgsFeatureBlock block( mFields );
+
+  QgsFeature f1( mFields, 11 );
+  f1.setAttributes( QgsAttributes() << 1 << true << QVariant( 1LL ) << 1.0 << QStringLiteral( "a" ) << QDate( 2017, 1, 1 ) );
+  f1.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Point (1 2)" ) ) );
+  block.append( f1 );
+
+  QgsFeature f2( mFields, 12 );
+  f2.setAttributes( QgsAttributes() << 2 << false << QVariant( 2LL ) << 2.0 << QStringLiteral( "b" ) << QDate( 2017, 1, 2 ) );
+  f2.setValid( false );
+  block.append( f2 );
+
+  QCOMPARE( block.id( 0 ), QgsFeatureId( 11 ) );
+  QCOMPARE( block.id( 1 ), QgsFeatureId( 12 ) );
+  QCOMPARE( block.geometry( 0 ).exportToWkt(), f1.geometry().exportToWkt() );
+  QVERIFY( block.geometry( 1 ).isNull() );
+
+  QgsFeature feature = block.feature( 0 );
+  QCOMPARE( feature.id(), f1.id() );
+  QVERIFY( feature.isValid() );
+  QCOMPARE( feature.fields(), mFields );
+  QCOMPARE( feature.attributes(), f1.attributes() );
+  QCOMPARE( feature.geometry().exportToWkt(), f1.geometry().exportToWkt() );
+  QCOMPARE( feature.attribute( QStringLiteral( "string" ) ).toString(), QStringLiteral( "a" ) );
+
+  feature = block.feature( 1 );
+  QCOMPARE( feature.id(), f2.id() );
+  QVERIFY( !feature.isValid() );
+  QVERIFY( !feature.hasGeometry() );
+  QCOMPARE( feature.attributes(), f2.attributes() );
+
+  QgsFeatureList features = block.features();
+  QCOMPARE( features.count(), 2 );
+  QCOMPARE( features.at( 0 ).id(), f1.id() );
+  QCOMPARE( features.at( 1 ).id(), f2.id() );
+}
+
+void TestQgsFeatureBlock::implicitSharing()
+{
+  QgsFeatureBlock block( mFields );
+  QgsFeature f1( mFields, 1 );
+  f1.setAttributes( QgsAttributes() << 1 << true << QVariant( 1LL ) << 1.0 << QStringLiteral( "a" ) << QDate( 2017, 1, 1 ) );
+  block.append( f1 );
+
+  QgsFeatureBlock copy( block );
+  QgsFeature f2( mFields, 2 );
+  f2.setAttributes( QgsAttributes() << 2 << false << QVariant( 2LL ) << 2.0 << QStringLiteral( "b" ) << QDate( 2017, 1, 2 ) );
+  copy.append( f2 );
+  QCOMPARE( block.count(), 1 );
+  QCOMPARE( copy.count(), 2 );
+
+  QgsFeatureBlock assigned;
+  assigned = copy;
+  assigned.clear();
+  QVERIFY( assigned.isEmpty() );
+  QCOMPARE( assigned.fields(), mFields );
+  QCOMPARE( copy.count(), 2 );
+  QCOMPARE( copy.attribute( 1, 4 ).toString(), QStringLiteral( "b" ) );
+
+  // cleared blocks can be filled again with other types
+  QgsFeature f3( 3 );
+  f3.setAttributes( QgsAttributes() << QStringLiteral( "c" ) );
+  assigned.setFields( QgsFields() );
+  assigned.append( f3 );
+  QCOMPARE( assigned.attribute( 0, 0 ).toString(), QStringLiteral( "c" ) );
+}
+
+void TestQgsFeatureBlock::featureStore()
+{
+  QgsFeatureStore store( mFields, QgsCoordinateReferenceSystem() );
+  QgsFeature f1( 1 );
+  f1.setAttributes( QgsAttributes() << 1 << true << QVariant( 1LL ) << 1.0 << QStringLiteral( "a" ) << QDate( 2017, 1, 1 ) );
+  QgsFeature f2( 2 );
+  f2.setAttributes( QgsAttributes() << 2 << false << QVariant( 2LL ) << 2.0 << QStringLiteral( "b" ) << QDate( 2017, 1, 2 ) );
+  QgsFeatureList features = QgsFeatureList() << f1 << f2;
+  QVERIFY( store.addFeatures( features ) );
+
+  QCOMPARE( store.count(), 2 );
+  QCOMPARE( store.featureBlock().count(), 2 );
+  features = store.features();
+  QCOMPARE( features.count(), 2 );
+  // the features get the fields of the store
+  QCOMPARE( features.at( 0 ).fields(), mFields );
+  QCOMPARE( features.at( 1 ).attribute( QStringLiteral( "string" ) ).toString(), QStringLiteral( "b" ) );
+  QCOMPARE( features.at( 1 ).attributes(), f2.attributes() );
+
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "renamed" ), QVariant::Int ) );
+  store.setFields( fields );
+  QCOMPARE( store.features().at( 0 ).fields(), fields );
+  QCOMPARE( store.features().at( 0 ).attribute( QStringLiteral( "renamed" ) ).toInt(), 1 );
+}
+
+QGSTEST_MAIN( TestQgsFeatureBlock )
+#include "testqgsfeatureblock.moc"
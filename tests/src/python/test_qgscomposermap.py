@@ -18,7 +18,7 @@ import os
 
 from qgis.PyQt.QtCore import QFileInfo
 from qgis.PyQt.QtXml import QDomDocument
-from qgis.PyQt.QtGui import QPainter
+from qgis.PyQt.QtGui import QColor, QImage, QPainter
 
 from qgis.core import (QgsComposerMap,
                        QgsRectangle,
@@ -26,6 +26,7 @@ from qgis.core import (QgsComposerMap,
                        QgsVectorLayer,
                        QgsComposition,
                        QgsMapSettings,
+                       QgsMapRendererSequentialJob,
                        QgsProject,
                        QgsMultiBandColorRenderer,
                        QgsCoordinateReferenceSystem
@@ -223,6 +224,51 @@ class TestQgsComposerMap(unittest.TestCase):
         for i in range(0, 6):
             assert abs(p[i] - pexpected[i]) < ptolerance[i]
 
+    def testPrerenderedImage(self):
+        dpi = 96
+        resolution = self.mComposition.printResolution()
+        self.mComposition.setPrintResolution(dpi)
+        try:
+            self.mComposerMap.setNewExtent(QgsRectangle(0, -128, 256, 0))
+            extent = QgsRectangle(self.mComposerMap.currentMapExtent())
+
+            def page_pixel(page, x_mm, y_mm):
+                return page.pixel(int(x_mm * dpi / 25.4), int(y_mm * dpi / 25.4))
+
+            # the map rendered with the print map settings is drawn as it would be rendered on the page
+            expected = self.mComposition.printPageAsRaster(0)
+            settings = self.mComposerMap.printMapSettings(dpi)
+            job = QgsMapRendererSequentialJob(settings)
+            job.start()
+            job.waitForFinished()
+            self.mComposerMap.setPrerenderedImage(job.renderedImage(), extent, dpi)
+            page = self.mComposition.printPageAsRaster(0)
+            self.assertEqual(page.size(), expected.size())
+            different = 0
+            for y in range(int(20 * dpi / 25.4), int(120 * dpi / 25.4)):
+                for x in range(int(20 * dpi / 25.4), int(220 * dpi / 25.4)):
+                    a = QColor.fromRgba(page.pixel(x, y))
+                    b = QColor.fromRgba(expected.pixel(x, y))
+                    if max(abs(a.red() - b.red()), abs(a.green() - b.green()), abs(a.blue() - b.blue())) > 8:
+                        different += 1
+            self.assertLessEqual(different, page.width())
+
+            # the prerendered image is drawn instead of the layers
+            image = QImage(settings.outputSize(), QImage.Format_ARGB32)
+            image.fill(QColor(255, 0, 255))
+            self.mComposerMap.setPrerenderedImage(image, extent, dpi)
+            self.assertEqual(QColor(page_pixel(self.mComposition.printPageAsRaster(0), 120, 70)).name(), '#ff00ff')
+
+            # but not for another resolution or extent
+            self.mComposerMap.setPrerenderedImage(image, extent, dpi + 1)
+            self.assertNotEqual(QColor(page_pixel(self.mComposition.printPageAsRaster(0), 120, 70)).name(), '#ff00ff')
+            self.mComposerMap.setPrerenderedImage(image, extent, dpi)
+            self.mComposerMap.setNewExtent(QgsRectangle(0, -256, 256, -128))
+            self.assertNotEqual(QColor(page_pixel(self.mComposition.printPageAsRaster(0), 120, 70)).name(), '#ff00ff')
+        finally:
+            self.mComposerMap.setPrerenderedImage(QImage(), QgsRectangle(), 0)
+            self.mComposition.setPrintResolution(resolution)
+
 
 if __name__ == '__main__':
     unittest.main()
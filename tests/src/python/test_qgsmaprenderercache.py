@@ -15,12 +15,22 @@ __revision__ = '$Format:%H$'
 import qgis  # NOQA
 
 from qgis.core import (QgsMapRendererCache,
+                       QgsCoordinateReferenceSystem,
+                       QgsFeature,
+                       QgsFillSymbol,
+                       QgsGeometry,
+                       QgsGradientFillSymbolLayer,
+                       QgsLineSymbol,
+                       QgsMapRendererSequentialJob,
+                       QgsMapSettings,
+                       QgsMarkerSymbol,
                        QgsRectangle,
+                       QgsSingleSymbolRenderer,
                        QgsVectorLayer,
                        QgsProject)
 from qgis.testing import start_app, unittest
-from qgis.PyQt.QtCore import QCoreApplication
-from qgis.PyQt.QtGui import QImage
+from qgis.PyQt.QtCore import QCoreApplication, QSize
+from qgis.PyQt.QtGui import QColor, QImage, QPainter
 from time import sleep
 start_app()
 
@@ -93,10 +103,149 @@ class TestQgsMapRendererCache(unittest.TestCase):
 
         # change extent
         self.assertFalse(cache.init(QgsRectangle(11, 12, 13, 14), 2000))
-        # cache should be cleared
+        # image is no longer valid for the current extent
         self.assertTrue(cache.cacheImage('layer').isNull())
         self.assertFalse(cache.hasCacheImage('layer'))
 
+    def testPreviousImages(self):
+        cache = QgsMapRendererCache()
+        extent = QgsRectangle(1, 2, 3, 4)
+        crs = QgsCoordinateReferenceSystem('EPSG:3857')
+        self.assertFalse(cache.init(extent, 1000, crs))
+
+        im = QImage(200, 200, QImage.Format_RGB32)
+        cache.setCacheImage('layer', im)
+        previous, previous_extent = cache.previousCacheImage('layer')
+        self.assertEqual(previous, im)
+        self.assertEqual(previous_extent, extent)
+
+        # pan: the image is kept for the previous extent
+        self.assertFalse(cache.init(QgsRectangle(2, 2, 4, 4), 1000, crs))
+        self.assertFalse(cache.hasCacheImage('layer'))
+        self.assertTrue(cache.cacheImage('layer').isNull())
+        previous, previous_extent = cache.previousCacheImage('layer')
+        self.assertEqual(previous, im)
+        self.assertEqual(previous_extent, extent)
+
+        # rendering for the new extent replaces it
+        im2 = QImage(200, 200, QImage.Format_ARGB32)
+        cache.setCacheImage('layer', im2)
+        self.assertTrue(cache.hasCacheImage('layer'))
+        previous, previous_extent = cache.previousCacheImage('layer')
+        self.assertEqual(previous, im2)
+        self.assertEqual(previous_extent, QgsRectangle(2, 2, 4, 4))
+
+        # change CRS: the cache is cleared
+        self.assertFalse(cache.init(QgsRectangle(2, 2, 4, 4), 1000, QgsCoordinateReferenceSystem('EPSG:4326')))
+        previous, previous_extent = cache.previousCacheImage('layer')
+        self.assertTrue(previous.isNull())
+
+        # change scale: the cache is cleared
+        cache.setCacheImage('layer', im)
+        self.assertFalse(cache.init(QgsRectangle(2, 2, 4, 4), 2000, QgsCoordinateReferenceSystem('EPSG:4326')))
+        previous, previous_extent = cache.previousCacheImage('layer')
+        self.assertTrue(previous.isNull())
+
+    def _panLayer(self, geometries, symbol):
+        """Returns a layer with the given geometries in WKT, rendered with symbol"""
+        geometry_type = geometries[0].split('(')[0]
+        layer = QgsVectorLayer('%s?crs=epsg:3857' % geometry_type, 'layer', 'memory')
+        features = []
+        for wkt in geometries:
+            feature = QgsFeature()
+            feature.setGeometry(QgsGeometry.fromWkt(wkt))
+            features.append(feature)
+        self.assertTrue(layer.dataProvider().addFeatures(features)[0])
+        layer.setRenderer(QgsSingleSymbolRenderer(symbol))
+        return layer
+
+    def _render(self, layers, extent, cache=None):
+        settings = QgsMapSettings()
+        settings.setOutputSize(QSize(200, 200))
+        settings.setOutputDpi(96)
+        settings.setExtent(extent)
+        settings.setLayers(layers)
+        settings.setDestinationCrs(layers[0].crs())
+        settings.setBackgroundColor(QColor(255, 255, 255))
+        job = QgsMapRendererSequentialJob(settings)
+        if cache:
+            job.setCache(cache)
+        job.start()
+        job.waitForFinished()
+        return job.renderedImage()
+
+    def _renderAfterPan(self, layers, dx, dy):
+        """Renders the layers after a pan of dx, dy pixels with a cache, whose image of the top layer is
+        marked at 100,100, and returns the rendered image, the position of the mark and the full rendering"""
+        extent = QgsRectangle(0, 0, 100, 100)
+        cache = QgsMapRendererCache()
+        self._render(layers, extent, cache)
+
+        # the previous image of the layer shows through where it is reused
+        image = QImage(cache.cacheImage(layers[0].id()))
+        painter = QPainter(image)
+        painter.fillRect(99, 99, 3, 3, QColor(255, 0, 255))
+        painter.end()
+        cache.setCacheImage(layers[0].id(), image)
+
+        # 2 pixels per map unit
+        panned = QgsRectangle(extent.xMinimum() + dx / 2.0, extent.yMinimum() - dy / 2.0,
+                              extent.xMaximum() + dx / 2.0, extent.yMaximum() - dy / 2.0)
+        rendered = self._render(layers, panned, cache)
+        return rendered, (100 - dx, 100 - dy), self._render(layers, panned)
+
+    def assertSameRendering(self, image, expected, mark):
+        different = 0
+        for y in range(expected.height()):
+            for x in range(expected.width()):
+                if abs(x - mark[0]) <= 1 and abs(y - mark[1]) <= 1:
+                    continue
+                a = QColor.fromRgba(image.pixel(x, y))
+                b = QColor.fromRgba(expected.pixel(x, y))
+                if max(abs(a.red() - b.red()), abs(a.green() - b.green()), abs(a.blue() - b.blue())) > 8:
+                    different += 1
+        self.assertEqual(different, 0)
+
+    def testReuseAfterPan(self):
+        """ test that rendering the area exposed by a pan gives the image of a full rendering """
+        points = self._panLayer(['Point(%d %d)' % (x, y) for x in range(-5, 110, 9) for y in range(-5, 110, 13)],
+                                QgsMarkerSymbol.createSimple({'name': 'circle', 'size': '4', 'color': '0,0,255'}))
+        lines = self._panLayer(['LineString(-20 %d, 120 %d)' % (y, y + 17) for y in range(-10, 110, 15)] +
+                               ['LineString(%d -20, %d 50, %d 120)' % (x, x + 8, x) for x in range(-10, 110, 15)],
+                               QgsLineSymbol.createSimple({'color': '0,128,0', 'width': '1.2'}))
+        polygons = self._panLayer(['Polygon((%d %d, %d %d, %d %d, %d %d))' % (x, y, x + 14, y + 3, x + 10, y + 16, x, y)
+                                   for x in range(-10, 110, 20) for y in range(-10, 110, 20)],
+                                  QgsFillSymbol.createSimple({'color': '255,128,0', 'outline_color': '0,0,0', 'outline_width': '0.6'}))
+        layers = [points, lines, polygons]
+
+        for dx, dy in ((37, 0), (-23, 0), (0, 41), (0, -19), (3, 0)):
+            rendered, mark, expected = self._renderAfterPan(layers, dx, dy)
+            self.assertEqual(QColor(rendered.pixel(*mark)).name(), '#ff00ff', (dx, dy))
+            self.assertSameRendering(rendered, expected, mark)
+
+        # not reused after a diagonal pan, or a pan by a fraction of pixel
+        for dx, dy in ((10, 10), (10.5, 0)):
+            rendered, mark, expected = self._renderAfterPan(layers, dx, dy)
+            self.assertNotEqual(QColor(rendered.pixel(int(mark[0]), int(mark[1]))).name(), '#ff00ff', (dx, dy))
+
+    def testNoReuseAfterPan(self):
+        """ test that layers whose rendering depends on the rendered extent are rendered fully after a pan """
+        gradient = QgsFillSymbol([QgsGradientFillSymbolLayer(QColor(255, 0, 0), QColor(0, 0, 255))])
+        for layer in (
+            # symbols larger than the margin along the exposed area
+            self._panLayer(['Point(50 50)'], QgsMarkerSymbol.createSimple({'name': 'circle', 'size': '20'})),
+            self._panLayer(['LineString(-20 50, 120 60)'], QgsLineSymbol.createSimple({'width': '20'})),
+            # symbols depending on the clipped geometry
+            self._panLayer(['LineString(-20 50, 120 60)'], QgsLineSymbol.createSimple({'line_style': 'dash'})),
+            self._panLayer(['Polygon((-20 -20, 120 -20, 120 120, -20 120, -20 -20))'], gradient),
+            # patterns anchored to the origin of the image
+            self._panLayer(['Polygon((-20 -20, 120 -20, 120 120, -20 120, -20 -20))'],
+                           QgsFillSymbol.createSimple({'style': 'b_diagonal'})),
+        ):
+            rendered, mark, expected = self._renderAfterPan([layer], 37, 0)
+            self.assertNotEqual(QColor(rendered.pixel(*mark)).name(), '#ff00ff', layer.renderer().symbol().symbolLayer(0).layerType())
+            self.assertSameRendering(rendered, expected, (-10, -10))
+
     def testRequestRepaintSimple(self):
         """ test requesting repaint with a single dependent layer """
         layer = QgsVectorLayer("Point?field=fldtxt:string",
@@ -15,20 +15,25 @@ __copyright__ = 'Copyright 2015, The QGIS Project'
 __revision__ = '$Format:%H$'
 
 import os
+import shutil
+import tempfile
 
 import qgis  # NOQA
 
 from qgis.core import (QgsProject,
+                       QgsProjectSnapshot,
                        QgsApplication,
                        QgsUnitTypes,
                        QgsCoordinateReferenceSystem,
                        QgsVectorLayer,
+                       QgsVectorLayerJoinInfo,
                        QgsMapLayer)
 from qgis.gui import (QgsLayerTreeMapCanvasBridge,
                       QgsMapCanvas)
 
 from qgis.PyQt.QtTest import QSignalSpy
 from qgis.PyQt.QtCore import QT_VERSION_STR
+from qgis.PyQt.QtXml import QDomDocument
 import sip
 
 from qgis.testing import start_app, unittest
@@ -191,6 +196,188 @@ class TestQgsProject(unittest.TestCase):
         expected = ['polys', 'lines']
         self.assertEqual(sorted(layers_names), sorted(expected))
 
+    def testSnapshot(self):
+        testdata_path = os.path.join(tempfile.mkdtemp(), 'embedded_groups')
+        shutil.copytree(unitTestDataPath('embedded_groups'), testdata_path)
+        prj_path = os.path.join(testdata_path, "project2.qgs")
+        snapshot_path = QgsProjectSnapshot.snapshotPath(prj_path)
+
+        # disabled by default
+        prj = QgsProject()
+        self.assertFalse(prj.useSnapshot())
+        self.assertTrue(prj.read(prj_path))
+        self.assertFalse(os.path.exists(snapshot_path))
+
+        # written when the project is read from its xml
+        prj = QgsProject()
+        prj.setUseSnapshot(True)
+        self.assertTrue(prj.read(prj_path))
+        self.assertTrue(os.path.exists(snapshot_path))
+
+        doc = QDomDocument("qgis")
+        self.assertTrue(QgsProjectSnapshot.read(prj_path, doc))
+        self.assertEqual(doc.documentElement().tagName(), "qgis")
+        xml_doc = QDomDocument("qgis")
+        with open(prj_path, 'rb') as f:
+            self.assertTrue(xml_doc.setContent(f.read()))
+        for tag in ['maplayer', 'layer-tree-layer', 'property']:
+            self.assertEqual(doc.elementsByTagName(tag).count(), xml_doc.elementsByTagName(tag).count())
+
+        # the project read from the snapshot has the same layers
+        prj = QgsProject()
+        prj.setUseSnapshot(True)
+        self.assertTrue(prj.read(prj_path))
+        layers_names = [prj.mapLayer(layer_id).name() for layer_id in prj.layerTreeRoot().findLayerIds()]
+        self.assertEqual(sorted(layers_names), ['lines', 'polys'])
+
+        # the snapshot is outdated when the project file changes
+        with open(prj_path, 'rb') as f:
+            content = f.read()
+        with open(prj_path, 'a') as f:
+            f.write('\n')
+        self.assertFalse(QgsProjectSnapshot.read(prj_path, doc))
+
+        # a snapshot written for a content which is not the current one of the file is never read
+        self.assertTrue(QgsProjectSnapshot.write(prj_path, xml_doc, content))
+        self.assertFalse(QgsProjectSnapshot.read(prj_path, doc))
+        with open(prj_path, 'wb') as f:
+            f.write(content)
+        self.assertTrue(QgsProjectSnapshot.read(prj_path, doc))
+
+        shutil.rmtree(os.path.dirname(testdata_path), True)
+
+    def testSnapshotNamespaces(self):
+        """A snapshot read with namespace processing is the document parsed with namespace processing"""
+        temp_path = tempfile.mkdtemp()
+        prj_path = os.path.join(temp_path, "namespaces.qgs")
+        content = (b'<!DOCTYPE qgis PUBLIC \'http://mrcc.com/qgis.dtd\' \'SYSTEM\'>\n'
+                   b'<qgis version="3.0" xmlns:sld="http://www.opengis.net/sld" xmlns:xlink="http://www.w3.org/1999/xlink">\n'
+                   b'  <title>Namespaces</title>\n'
+                   b'  <sld:StyledLayerDescriptor version="1.1.0">\n'
+                   b'    <sld:NamedLayer><se:Name xmlns:se="http://www.opengis.net/se">layer</se:Name></sld:NamedLayer>\n'
+                   b'    <OnlineResource xlink:href="http://example.com" xml:lang="en"/>\n'
+                   b'    <Rule xmlns="http://www.opengis.net/se"><Name>default</Name><![CDATA[a < b]]></Rule>\n'
+                   b'  </sld:StyledLayerDescriptor>\n'
+                   b'  <!-- comment -->\n'
+                   b'</qgis>\n')
+        with open(prj_path, 'wb') as f:
+            f.write(content)
+
+        # the project writes the snapshot of the document parsed without namespace processing
+        doc = QDomDocument()
+        self.assertTrue(doc.setContent(content)[0])
+        self.assertTrue(QgsProjectSnapshot.write(prj_path, doc, content))
+
+        xml_doc = QDomDocument()
+        self.assertTrue(xml_doc.setContent(content, True)[0])
+        snapshot_doc = QDomDocument()
+        self.assertTrue(QgsProjectSnapshot.read(prj_path, snapshot_doc, True))
+
+        def nodes(node):
+            result = []
+            child = node.firstChild()
+            while not child.isNull():
+                if child.isElement():
+                    element = child.toElement()
+                    attributes = element.attributes()
+                    result.append((element.tagName(), element.namespaceURI(), element.localName(), element.prefix(),
+                                   sorted((attributes.item(i).nodeName(), attributes.item(i).namespaceURI(),
+                                           attributes.item(i).localName(), attributes.item(i).nodeValue())
+                                          for i in range(attributes.count())),
+                                   nodes(child)))
+                elif child.nodeType() != child.DocumentTypeNode:
+                    result.append((child.nodeType(), child.nodeName(), child.nodeValue()))
+                child = child.nextSibling()
+            return result
+
+        self.assertEqual(nodes(snapshot_doc), nodes(xml_doc))
+        self.assertEqual(snapshot_doc.elementsByTagNameNS('http://www.opengis.net/se', 'Name').count(), 2)
+        self.assertFalse(snapshot_doc.documentElement().hasAttribute('xmlns:sld'))
+
+        # without namespace processing, the snapshot is the document of the project
+        snapshot_doc = QDomDocument()
+        self.assertTrue(QgsProjectSnapshot.read(prj_path, snapshot_doc))
+        self.assertEqual(nodes(snapshot_doc), nodes(doc))
+        self.assertTrue(snapshot_doc.documentElement().hasAttribute('xmlns:sld'))
+
+        shutil.rmtree(temp_path, True)
+
+    def testDeferLayerLoading(self):
+        prj = QgsProject()
+        self.assertFalse(prj.deferLayerLoading())
+        prj.setDeferLayerLoading(True)
+        self.assertTrue(prj.read(os.path.join(TEST_DATA_DIR, 'labeling/test-labeling.qgs')))
+
+        # no layer is read with the project
+        self.assertEqual(len(prj.layerStore().mapLayers()), 0)
+        self.assertEqual(prj.count(), 3)
+        self.assertEqual(len(prj.deferredLayerIds()), 3)
+        self.assertEqual(len(prj.layerTreeRoot().findLayerIds()), 3)
+
+        # the getters do not read the deferred layers
+        self.assertFalse(prj.mapLayer('point20140219051601679'))
+        self.assertEqual(prj.mapLayersByName('aoi'), [])
+        self.assertEqual(prj.mapLayers(), {})
+        self.assertEqual(len(prj.deferredLayerIds()), 3)
+
+        # read on request
+        spy = QSignalSpy(prj.layersAdded)
+        layer = prj.readDeferredLayer('point20140219051601679')
+        self.assertTrue(layer)
+        self.assertTrue(layer.isValid())
+        self.assertEqual(layer.name(), 'point')
+        self.assertEqual(len(spy), 1)
+        self.assertEqual(prj.mapLayer('point20140219051601679'), layer)
+        self.assertFalse(prj.readDeferredLayer('point20140219051601679'))
+        self.assertEqual(len(spy), 1)
+        self.assertEqual(len(prj.layerStore().mapLayers()), 1)
+        self.assertEqual(prj.layerTreeRoot().findLayer('point20140219051601679').layer(), layer)
+        self.assertEqual(prj.count(), 3)
+        self.assertEqual(len(prj.deferredLayerIds()), 2)
+        self.assertFalse('point20140219051601679' in prj.deferredLayerIds())
+
+        prj.readDeferredLayers()
+        self.assertEqual(prj.deferredLayerIds(), [])
+        self.assertEqual([l.id() for l in prj.mapLayersByName('aoi')], ['aoi20130902095858570'])
+        self.assertEqual(len(prj.mapLayers()), 3)
+        self.assertEqual(len(prj.layerStore().mapLayers()), 3)
+
+        # removing a deferred layer does not read it
+        prj.read(os.path.join(TEST_DATA_DIR, 'labeling/test-labeling.qgs'))
+        prj.removeMapLayer('aoi20130902095858570')
+        self.assertEqual(prj.count(), 2)
+        self.assertFalse('aoi20130902095858570' in prj.deferredLayerIds())
+        self.assertFalse(prj.readDeferredLayer('aoi20130902095858570'))
+        self.assertFalse(prj.layerTreeRoot().findLayer('aoi20130902095858570'))
+        self.assertEqual(len(prj.layerStore().mapLayers()), 0)
+
+    def testDeferLayerLoadingJoins(self):
+        """The layers joined to a deferred layer are read with it"""
+        temp_path = tempfile.mkdtemp()
+        prj_path = os.path.join(temp_path, 'joins.qgs')
+        prj = QgsProject()
+        target = QgsVectorLayer('Point?field=id:integer', 'target', 'memory')
+        joined = QgsVectorLayer('Point?field=id:integer&field=name:string', 'joined', 'memory')
+        other = QgsVectorLayer('Point?field=id:integer', 'other', 'memory')
+        prj.addMapLayers([target, joined, other])
+        join = QgsVectorLayerJoinInfo()
+        join.setTargetFieldName('id')
+        join.setJoinLayer(joined)
+        join.setJoinFieldName('id')
+        self.assertTrue(target.addJoin(join))
+        self.assertTrue(prj.write(prj_path))
+
+        prj = QgsProject()
+        prj.setDeferLayerLoading(True)
+        self.assertTrue(prj.read(prj_path))
+        self.assertEqual(len(prj.deferredLayerIds()), 3)
+        layer = prj.readDeferredLayer(target.id())
+        self.assertTrue(layer)
+        self.assertEqual(prj.deferredLayerIds(), [other.id()])
+        self.assertEqual(layer.vectorJoins()[0].joinLayer(), prj.mapLayer(joined.id()))
+
+        shutil.rmtree(temp_path, True)
+
     def testInstance(self):
         """ test retrieving global instance """
         self.assertTrue(QgsProject.instance())
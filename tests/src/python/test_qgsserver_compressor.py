@@ -0,0 +1,103 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsServerCompressor.
+
+From build dir, run: ctest -R PyQgsServerCompressor -V
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+import unittest
+import gzip
+import os
+import zlib
+
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+
+from qgis.server import QgsServerCompressor
+
+# Text larger than the chunks of the compressor, with a random part which does not compress well
+DATA = b''.join(b'<Feature fid="%d"><name>feature %d</name></Feature>\n' % (i, i) for i in range(5000)) + os.urandom(50000)
+
+
+class QgsServerCompressorTest(unittest.TestCase):
+
+    def test_acceptedEncoding(self):
+        for accept_encoding, encoding in (
+            ('', QgsServerCompressor.Identity),
+            ('identity', QgsServerCompressor.Identity),
+            ('br', QgsServerCompressor.Identity),
+            ('gzip', QgsServerCompressor.Gzip),
+            ('x-gzip', QgsServerCompressor.Gzip),
+            ('GZIP ; q=0.8', QgsServerCompressor.Gzip),
+            ('deflate', QgsServerCompressor.Deflate),
+            ('gzip, deflate, br', QgsServerCompressor.Gzip),
+            ('deflate, gzip', QgsServerCompressor.Gzip),
+            # the coding with the highest quality wins, gzip when they are equal
+            ('gzip;q=0.5, deflate', QgsServerCompressor.Deflate),
+            ('gzip;q=0.5, deflate;q=0.5', QgsServerCompressor.Gzip),
+            ('gzip;q=0.001', QgsServerCompressor.Gzip),
+            # a quality of 0 means not acceptable
+            ('gzip;q=0', QgsServerCompressor.Identity),
+            ('gzip;q=0, deflate', QgsServerCompressor.Deflate),
+            ('gzip;q=0.0, deflate;q=0', QgsServerCompressor.Identity),
+            # the wildcard applies to the codings which are not listed
+            ('*', QgsServerCompressor.Gzip),
+            ('*;q=0', QgsServerCompressor.Identity),
+            ('*;q=0.5, gzip;q=0', QgsServerCompressor.Deflate),
+            ('deflate, *;q=0', QgsServerCompressor.Deflate),
+        ):
+            self.assertEqual(QgsServerCompressor.acceptedEncoding(accept_encoding), encoding, accept_encoding)
+
+    def test_encodingName(self):
+        self.assertEqual(QgsServerCompressor.encodingName(QgsServerCompressor.Identity), 'identity')
+        self.assertEqual(QgsServerCompressor.encodingName(QgsServerCompressor.Gzip), 'gzip')
+        self.assertEqual(QgsServerCompressor.encodingName(QgsServerCompressor.Deflate), 'deflate')
+
+    def test_isCompressible(self):
+        for content_type in ('text/xml', 'text/xml; subtype=gml/3.1.1', 'text/html;charset=utf-8', 'text/plain',
+                             'application/vnd.ogc.wms_xml', 'application/vnd.ogc.gml', 'application/json',
+                             'application/geo+json; charset=utf-8', 'application/javascript', 'TEXT/XML'):
+            self.assertTrue(QgsServerCompressor.isCompressible(content_type), content_type)
+        for content_type in ('', 'image/png', 'image/jpeg', 'image/png; mode=8bit', 'application/octet-stream',
+                             'application/pdf', 'image/png; charset=xml'):
+            self.assertFalse(QgsServerCompressor.isCompressible(content_type), content_type)
+
+    def test_compress(self):
+        for level in (-1, 1, 9):
+            compressed = bytes(QgsServerCompressor.compress(DATA, QgsServerCompressor.Gzip, level))
+            self.assertEqual(compressed[:2], b'\x1f\x8b')
+            self.assertLess(len(compressed), len(DATA))
+            self.assertEqual(gzip.decompress(compressed), DATA)
+
+            compressed = bytes(QgsServerCompressor.compress(DATA, QgsServerCompressor.Deflate, level))
+            self.assertLess(len(compressed), len(DATA))
+            self.assertEqual(zlib.decompress(compressed), DATA)
+
+        self.assertEqual(gzip.decompress(bytes(QgsServerCompressor.compress(b'', QgsServerCompressor.Gzip))), b'')
+        self.assertEqual(zlib.decompress(bytes(QgsServerCompressor.compress(b'', QgsServerCompressor.Deflate))), b'')
+
+    def test_stream(self):
+        """The parts of a stream make a single compressed body"""
+        for encoding, decompress in ((QgsServerCompressor.Gzip, gzip.decompress),
+                                     (QgsServerCompressor.Deflate, zlib.decompress)):
+            compressor = QgsServerCompressor(encoding)
+            compressed = b''
+            for i in range(0, len(DATA), 7000):
+                compressed += bytes(compressor.compressPart(DATA[i:i + 7000]))
+            compressed += bytes(compressor.finish())
+            self.assertEqual(decompress(compressed), DATA)
+
+        compressor = QgsServerCompressor(QgsServerCompressor.Gzip)
+        self.assertEqual(gzip.decompress(bytes(compressor.finish())), b'')
+
+
+if __name__ == '__main__':
+    unittest.main()
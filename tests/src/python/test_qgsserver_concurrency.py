@@ -0,0 +1,187 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsServer requests handled by several threads.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+
+# Deterministic XML
+os.environ['QT_HASH_SEED'] = '1'
+
+import threading
+import urllib.parse
+
+from qgis.testing import unittest
+from qgis.PyQt.QtCore import QCoreApplication, QEventLoop, QThread
+from qgis.server import QgsConfigCache
+import osgeo.gdal  # NOQA
+from test_qgsserver import QgsServerTestBase
+
+
+class TestQgsServerConcurrency(QgsServerTestBase):
+
+    """Requests handled by worker threads, as with QGIS_SERVER_PARALLEL_REQUESTS"""
+
+    def _query_string(self, params):
+        params = dict(params)
+        params['MAP'] = urllib.parse.quote(self.projectPath)
+        return '?' + '&'.join(['%s=%s' % i for i in sorted(params.items())])
+
+    def _execute_in_threads(self, query_strings):
+        """Executes each request in its own thread, while the main thread runs the
+        event loop which executes the requests that cannot run concurrently"""
+        results = [None] * len(query_strings)
+        threads = []
+
+        def execute(index, query_string):
+            results[index] = self._execute_request(query_string)
+
+        for index, query_string in enumerate(query_strings):
+            thread = threading.Thread(target=execute, args=(index, query_string))
+            threads.append(thread)
+            thread.start()
+
+        while any(thread.is_alive() for thread in threads):
+            QCoreApplication.processEvents(QEventLoop.AllEvents, 10)
+        for thread in threads:
+            thread.join()
+        return results
+
+    def _requests(self):
+        wms = self._query_string({
+            'SERVICE': 'WMS',
+            'VERSION': '1.1.1',
+            'REQUEST': 'GetMap',
+            'LAYERS': 'Country,Hello',
+            'STYLES': '',
+            'FORMAT': 'image/png',
+            'BBOX': '-16817707,-4710778,5696513,14587125',
+            'HEIGHT': '500',
+            'WIDTH': '500',
+            'SRS': 'EPSG:3857'
+        })
+        wfs = self._query_string({
+            'SERVICE': 'WFS',
+            'VERSION': '1.0.0',
+            'REQUEST': 'GetFeature',
+            'TYPENAME': 'Hello'
+        })
+        wcs = self._query_string({
+            'SERVICE': 'WCS',
+            'VERSION': '1.0.0',
+            'REQUEST': 'GetCapabilities'
+        })
+        getfeatureinfo = self._query_string({
+            'SERVICE': 'WMS',
+            'VERSION': '1.1.1',
+            'REQUEST': 'GetFeatureInfo',
+            'LAYERS': 'Country',
+            'QUERY_LAYERS': 'Country',
+            'STYLES': '',
+            'INFO_FORMAT': 'text/xml',
+            'BBOX': '-16817707,-4710778,5696513,14587125',
+            'HEIGHT': '500',
+            'WIDTH': '500',
+            'SRS': 'EPSG:3857',
+            'X': '398',
+            'Y': '220'
+        })
+        return [wms, wfs, wcs, getfeatureinfo]
+
+    def _capabilities(self):
+        return self._query_string({
+            'SERVICE': 'WMS',
+            'VERSION': '1.1.1',
+            'REQUEST': 'GetCapabilities'
+        })
+
+    def _execute_in_thread(self, query_string, timeout):
+        """Executes the request in a worker thread without running the event loop of the main thread,
+        returns the thread, which is still alive if the request waits for the main thread"""
+        thread = threading.Thread(target=self._execute_request, args=(query_string,))
+        thread.start()
+        thread.join(timeout)
+        return thread
+
+    def test_same_responses(self):
+        """Responses are the same as the responses of the main thread"""
+        requests = self._requests()
+        expected = [self._execute_request(query_string) for query_string in requests]
+        for header, body in expected:
+            self.assertFalse(b'ServiceException' in body, body)
+
+        results = self._execute_in_threads(requests * 8)
+        for index, result in enumerate(results):
+            self.assertEqual(result, expected[index % len(requests)], requests[index % len(requests)])
+
+    def test_project_not_loaded(self):
+        """The first requests of a project are executed by the main thread, which loads it"""
+        self.projectPath = os.path.join(self.testdata_path, 'test_project_wfs.qgs')
+        wfs = self._query_string({
+            'SERVICE': 'WFS',
+            'VERSION': '1.0.0',
+            'REQUEST': 'GetFeature',
+            'TYPENAME': 'testlayer'
+        })
+        results = self._execute_in_threads([wfs] * 8)
+        expected = self._execute_request(wfs)
+        self.assertFalse(b'ServiceException' in expected[1], expected[1])
+        for result in results:
+            self.assertEqual(result, expected)
+
+    def test_exclusive_requests(self):
+        """WMS GetCapabilities requests wait for the main thread, GetMap, GetFeatureInfo
+        and WFS requests of a loaded project do not"""
+        self.assertEqual(QThread.currentThread(), QCoreApplication.instance().thread())
+        wms, wfs, wcs, getfeatureinfo = self._requests()
+        # Loads the project
+        self._execute_request(wfs)
+
+        for query_string in (wfs, wms, getfeatureinfo):
+            thread = self._execute_in_thread(query_string, 60)
+            self.assertFalse(thread.is_alive(), query_string)
+
+        thread = self._execute_in_thread(self._capabilities(), 1)
+        self.assertTrue(thread.is_alive())
+        while thread.is_alive():
+            QCoreApplication.processEvents(QEventLoop.AllEvents, 10)
+        thread.join()
+
+    def test_changed_project(self):
+        """The entries of a changed project are removed by the main thread before the next requests"""
+        wms = self._requests()[0]
+        expected = self._execute_request(wms)
+        self._execute_in_threads([wms] * 4)
+
+        # The change is reported to the main thread by the file system watchers
+        os.utime(self.projectPath, None)
+        for i in range(100):
+            if QgsConfigCache.instance().hasChangedEntries():
+                break
+            QCoreApplication.processEvents(QEventLoop.AllEvents, 100)
+        self.assertTrue(QgsConfigCache.instance().hasChangedEntries())
+
+        thread = self._execute_in_thread(wms, 1)
+        self.assertTrue(thread.is_alive())
+        while thread.is_alive():
+            QCoreApplication.processEvents(QEventLoop.AllEvents, 10)
+        thread.join()
+        self.assertFalse(QgsConfigCache.instance().hasChangedEntries())
+
+        results = self._execute_in_threads([wms] * 4)
+        for result in results:
+            self.assertEqual(result, expected)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,254 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the streaming and the compression of the responses of qgis_mapserv.fcgi.
+
+The FastCGI server is run as a CGI program, which handles a single request.
+
+From build dir, run: ctest -R PyQgsServerFcgi -V
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import gzip
+import shutil
+import subprocess
+import tempfile
+import zlib
+import urllib.parse
+
+from qgis.testing import unittest
+import qgis.server
+from utilities import unitTestDataPath
+
+FCGI_BIN = os.path.join(os.environ.get('QGIS_PREFIX_PATH', ''), 'bin', 'qgis_mapserv.fcgi')
+
+# Server plugin whose filter turns the responses of the requests with TEST_STATUS=204 into 204 responses
+PLUGIN_METADATA = """[general]
+name=Response test filter
+description=Filter of the FastCGI response tests
+version=1.0
+qgisMinimumVersion=2.99
+server=True
+"""
+
+PLUGIN = """from qgis.server import QgsServerFilter
+
+
+class StatusFilter(QgsServerFilter):
+
+    def responseComplete(self):
+        handler = self.serverInterface().requestHandler()
+        if handler.parameterMap().get('TEST_STATUS') == '204':
+            handler.clear()
+            handler.setStatusCode(204)
+
+
+class ResponseTestPlugin:
+
+    def __init__(self, serverIface):
+        self.filter = StatusFilter(serverIface)
+        serverIface.registerFilter(self.filter, 100)
+
+
+def serverClassFactory(serverIface):
+    return ResponseTestPlugin(serverIface)
+"""
+
+
+@unittest.skipIf(not os.path.exists(FCGI_BIN), 'qgis_mapserv.fcgi not found')
+class TestQgsServerFcgi(unittest.TestCase):
+
+    """qgis_mapserv.fcgi response streaming and compression tests"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.temp_path = tempfile.mkdtemp()
+        plugin_path = os.path.join(cls.temp_path, 'plugins', 'responsetestfilter')
+        os.makedirs(plugin_path)
+        with open(os.path.join(plugin_path, 'metadata.txt'), 'w') as f:
+            f.write(PLUGIN_METADATA)
+        with open(os.path.join(plugin_path, '__init__.py'), 'w') as f:
+            f.write(PLUGIN)
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.temp_path, True)
+
+    def _request(self, params, headers={}, settings={}, method='GET', plugins=False):
+        """Runs a request and returns its status, its headers and its body"""
+        params = dict(params)
+        params['MAP'] = urllib.parse.quote(os.path.join(unitTestDataPath('qgis_server'), 'test_project.qgs'))
+        env = dict(os.environ)
+        for name in ('QGIS_PLUGINPATH', 'QGIS_SERVER_RESPONSE_COMPRESSION', 'QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD',
+                     'QGIS_SERVER_CAPABILITIES_CONDITIONAL_REQUESTS'):
+            env.pop(name, None)
+        env.update(settings)
+        env.update({
+            'REQUEST_METHOD': method,
+            'QUERY_STRING': '&'.join(['%s=%s' % i for i in sorted(params.items())]),
+            'SERVER_NAME': 'localhost'
+        })
+        for name, value in headers.items():
+            env['HTTP_' + name.upper().replace('-', '_')] = value
+        if plugins:
+            env['QGIS_PLUGINPATH'] = os.path.join(self.temp_path, 'plugins')
+
+        output = subprocess.check_output([FCGI_BIN], env=env, stdin=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        header, body = output.split(b'\n\n', 1)
+        response_headers = {}
+        for line in header.decode('utf-8').splitlines():
+            name, value = line.split(':', 1)
+            response_headers[name] = value.strip()
+        status = int(response_headers.pop('Status', '200'))
+        return status, response_headers, body
+
+    def _capabilities(self, service='WMS', headers={}, settings={}, method='GET', plugins=False, params={}):
+        params = dict(params)
+        params.update({
+            'SERVICE': service,
+            'REQUEST': 'GetCapabilities'
+        })
+        return self._request(params, headers, settings, method, plugins)
+
+    def assertContentLength(self, headers, body):
+        self.assertIn('Content-Length', headers)
+        self.assertEqual(int(headers['Content-Length']), len(body))
+
+    def test_identity(self):
+        """Responses are neither compressed nor streamed by default"""
+        status, headers, body = self._capabilities('WFS', {'Accept-Encoding': 'gzip, deflate'})
+        self.assertEqual(status, 200)
+        self.assertIn(b'WFS_Capabilities', body)
+        self.assertNotIn('Content-Encoding', headers)
+        self.assertContentLength(headers, body)
+
+    def test_compression(self):
+        settings = {'QGIS_SERVER_RESPONSE_COMPRESSION': '1'}
+        status, headers, identity = self._capabilities('WFS', settings=settings)
+        self.assertNotIn('Content-Encoding', headers)
+        self.assertContentLength(headers, identity)
+
+        for accept_encoding, encoding, decompress in (('gzip', 'gzip', gzip.decompress),
+                                                      ('deflate', 'deflate', zlib.decompress),
+                                                      ('gzip;q=0.5, deflate', 'deflate', zlib.decompress)):
+            status, headers, body = self._capabilities('WFS', {'Accept-Encoding': accept_encoding}, settings)
+            self.assertEqual(status, 200)
+            self.assertEqual(headers['Content-Encoding'], encoding)
+            self.assertIn('Accept-Encoding', headers['Vary'])
+            # the length is the one of the compressed body
+            self.assertContentLength(headers, body)
+            self.assertEqual(decompress(body), identity)
+
+        status, headers, body = self._capabilities('WFS', {'Accept-Encoding': 'gzip;q=0'}, settings)
+        self.assertNotIn('Content-Encoding', headers)
+        self.assertEqual(body, identity)
+
+    def test_images_not_compressed(self):
+        status, headers, body = self._request({
+            'SERVICE': 'WMS',
+            'VERSION': '1.3.0',
+            'REQUEST': 'GetMap',
+            'LAYERS': urllib.parse.quote('testlayer èé'),
+            'STYLES': '',
+            'FORMAT': 'image/png',
+            'CRS': 'EPSG:3857',
+            'BBOX': '913190.6389747962,5606005.488876367,913235.426296057,5606035.347090538',
+            'WIDTH': '100',
+            'HEIGHT': '100'
+        }, {'Accept-Encoding': 'gzip'}, {'QGIS_SERVER_RESPONSE_COMPRESSION': '1'})
+        self.assertEqual(headers['Content-Type'], 'image/png')
+        self.assertNotIn('Content-Encoding', headers)
+        self.assertEqual(body[:8], b'\x89PNG\r\n\x1a\n')
+        self.assertContentLength(headers, body)
+
+    def test_already_encoded(self):
+        """The gzip capabilities of the cache are not compressed twice"""
+        status, headers, identity = self._capabilities('WMS')
+        status, headers, body = self._capabilities('WMS', {'Accept-Encoding': 'gzip'},
+                                                   {'QGIS_SERVER_RESPONSE_COMPRESSION': '1'})
+        self.assertEqual(headers['Content-Encoding'], 'gzip')
+        self.assertContentLength(headers, body)
+        self.assertEqual(gzip.decompress(body), identity)
+
+    def test_streaming(self):
+        """Bodies larger than the threshold are sent without Content-Length"""
+        status, headers, identity = self._capabilities('WFS')
+        self.assertGreater(len(identity), 1024)
+
+        status, headers, body = self._capabilities('WFS', settings={'QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD': '1024'})
+        self.assertEqual(status, 200)
+        self.assertNotIn('Content-Length', headers)
+        self.assertEqual(body, identity)
+
+        # a body smaller than the threshold is sent at once
+        status, headers, body = self._capabilities('WFS', settings={'QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD': str(len(identity) + 1)})
+        self.assertContentLength(headers, body)
+        self.assertEqual(body, identity)
+
+        settings = {'QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD': '1024', 'QGIS_SERVER_RESPONSE_COMPRESSION': '1'}
+        for accept_encoding, decompress in (('gzip', gzip.decompress), ('deflate', zlib.decompress)):
+            status, headers, body = self._capabilities('WFS', {'Accept-Encoding': accept_encoding}, settings)
+            self.assertEqual(headers['Content-Encoding'], accept_encoding)
+            self.assertNotIn('Content-Length', headers)
+            self.assertEqual(decompress(body), identity)
+
+    def test_head(self):
+        """HEAD responses have the headers of the uncompressed body and no body"""
+        status, headers, identity = self._capabilities('WFS')
+        settings = {'QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD': '1024', 'QGIS_SERVER_RESPONSE_COMPRESSION': '1'}
+        status, headers, body = self._capabilities('WFS', {'Accept-Encoding': 'gzip'}, settings, 'HEAD')
+        self.assertEqual(status, 200)
+        self.assertNotIn('Content-Encoding', headers)
+        self.assertEqual(int(headers['Content-Length']), len(identity))
+        self.assertEqual(body, b'')
+
+    def test_not_modified(self):
+        """304 responses are not compressed"""
+        settings = {'QGIS_SERVER_CAPABILITIES_CONDITIONAL_REQUESTS': '1', 'QGIS_SERVER_RESPONSE_COMPRESSION': '1'}
+        status, headers, body = self._capabilities('WMS', {'Accept-Encoding': 'deflate'}, settings)
+        self.assertEqual(status, 200)
+        self.assertEqual(headers['Content-Encoding'], 'deflate')
+        etag = headers['ETag']
+
+        status, headers, body = self._capabilities('WMS', {'Accept-Encoding': 'deflate', 'If-None-Match': etag}, settings)
+        self.assertEqual(status, 304)
+        self.assertNotIn('Content-Encoding', headers)
+        self.assertEqual(body, b'')
+
+    @unittest.skipIf(not hasattr(qgis.server, 'QgsServerFilter'), 'server plugins are not available')
+    def test_no_content(self):
+        """204 responses are not compressed"""
+        status, headers, body = self._capabilities('WFS', {'Accept-Encoding': 'gzip'}, {'QGIS_SERVER_RESPONSE_COMPRESSION': '1'},
+                                                   plugins=True, params={'TEST_STATUS': '204'})
+        self.assertEqual(status, 204)
+        self.assertNotIn('Content-Encoding', headers)
+        self.assertEqual(body, b'')
+
+    @unittest.skipIf(not hasattr(qgis.server, 'QgsServerFilter'), 'server plugins are not available')
+    def test_filters_not_streamed(self):
+        """The responses are not streamed when filters are registered, they go through the filters"""
+        status, headers, identity = self._capabilities('WFS')
+        settings = {'QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD': '1024', 'QGIS_SERVER_RESPONSE_COMPRESSION': '1'}
+        status, headers, body = self._capabilities('WFS', {'Accept-Encoding': 'gzip'}, settings, plugins=True)
+        self.assertEqual(headers['Content-Encoding'], 'gzip')
+        self.assertContentLength(headers, body)
+        self.assertEqual(gzip.decompress(body), identity)
+
+        # the filter could replace the body
+        status, headers, body = self._capabilities('WFS', {'Accept-Encoding': 'gzip'}, settings,
+                                                   plugins=True, params={'TEST_STATUS': '204'})
+        self.assertEqual(status, 204)
+        self.assertEqual(body, b'')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,146 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the request timings of QgsServer and its METRICS service.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import re
+import urllib.parse
+
+# The GetPrint maps are rendered by the threads of parallel jobs
+os.environ['QGIS_SERVER_METRICS'] = '1'
+os.environ['QGIS_SERVER_PARALLEL_RENDERING'] = '1'
+
+from qgis.testing import unittest
+import osgeo.gdal  # NOQA
+from test_qgsserver import QgsServerTestBase
+
+METRIC_RE = re.compile(r'^(\w+)\{(.*)\} (\S+)$')
+
+
+class TestQgsServerMetrics(QgsServerTestBase):
+
+    """QGIS Server Server-Timing header and METRICS service tests"""
+
+    def _query_string(self, params):
+        return '?' + '&'.join(['%s=%s' % i for i in sorted(params.items())])
+
+    def _get_map(self):
+        return self._result(self._execute_request(self._query_string({
+            'MAP': urllib.parse.quote(self.projectPath),
+            'SERVICE': 'WMS',
+            'VERSION': '1.1.1',
+            'REQUEST': 'GetMap',
+            'LAYERS': 'Country,Hello',
+            'STYLES': '',
+            'FORMAT': 'image/png',
+            'BBOX': '-16817707,-4710778,5696513,14587125',
+            'HEIGHT': '500',
+            'WIDTH': '500',
+            'SRS': 'EPSG:3857'
+        })))
+
+    def _get_print(self):
+        return self._result(self._execute_request(self._query_string({
+            'MAP': urllib.parse.quote(self.projectPath),
+            'SERVICE': 'WMS',
+            'VERSION': '1.1.1',
+            'REQUEST': 'GetPrint',
+            'TEMPLATE': 'layoutA4',
+            'FORMAT': 'png',
+            'map0:EXTENT': '-33626185.498,-13032965.185,33978427.737,16020257.031',
+            'map0:LAYERS': 'Country,Hello',
+            'HEIGHT': '500',
+            'WIDTH': '500',
+            'CRS': 'EPSG:3857'
+        })))
+
+    def _server_timing(self, headers):
+        """Returns the entries of the Server-Timing header as (name, description, duration)"""
+        self.assertIn('Server-Timing', headers)
+        entries = []
+        for entry in headers['Server-Timing'].split(', '):
+            params = entry.split(';')
+            values = dict(param.split('=', 1) for param in params[1:])
+            self.assertIn('dur', values, entry)
+            self.assertGreaterEqual(int(values['dur']), 0, entry)
+            entries.append((params[0], values.get('desc'), int(values['dur'])))
+        return entries
+
+    def _metrics(self):
+        """Returns the values of the METRICS service by metric name and labels"""
+        body, headers = self._result(self._execute_request('?SERVICE=METRICS'))
+        self.assertEqual(headers['Content-Type'], 'text/plain; version=0.0.4')
+        metrics = {}
+        for line in body.decode('utf-8').splitlines():
+            if line.startswith('#'):
+                continue
+            match = METRIC_RE.match(line)
+            self.assertTrue(match, line)
+            metrics[(match.group(1), match.group(2))] = float(match.group(3))
+        return metrics
+
+    def _layer_metric(self, metrics, metric, name):
+        values = [value for (metric_name, labels), value in metrics.items()
+                  if metric_name == metric and labels.endswith(',name="%s"' % name)]
+        return values[0] if values else 0
+
+    def test_server_timing_getmap(self):
+        body, headers = self._get_map()
+        entries = self._server_timing(headers)
+        names = [entry[0] for entry in entries]
+        for stage in ('config', 'layers', 'render', 'encode'):
+            self.assertIn(stage, names)
+        # one entry by rendered layer, the total is the last entry
+        self.assertEqual(len([entry for entry in entries if entry[0] == 'layer']), 2)
+        self.assertEqual(entries[-1][0], 'total')
+        self.assertLessEqual(sum(entry[2] for entry in entries if entry[0] not in ('layer', 'total')), entries[-1][2] + len(entries))
+
+    def test_server_timing_getprint(self):
+        """The layers of the maps rendered by parallel jobs are reported"""
+        body, headers = self._get_print()
+        self.assertEqual(headers['Content-Type'], 'image/png')
+        entries = self._server_timing(headers)
+        self.assertIn('render', [entry[0] for entry in entries])
+        self.assertEqual(len([entry for entry in entries if entry[0] == 'layer']), 2)
+
+    def test_metrics_service(self):
+        before = self._metrics()
+        self._get_map()
+        self._get_print()
+        after = self._metrics()
+
+        for request in ('GetMap', 'GetPrint'):
+            labels = 'service="WMS",request="%s"' % request
+            count = after[('qgis_server_request_duration_seconds_count', labels)]
+            self.assertEqual(count, before.get(('qgis_server_request_duration_seconds_count', labels), 0) + 1)
+            self.assertEqual(after[('qgis_server_request_duration_seconds_bucket', labels + ',le="+Inf"')], count)
+            self.assertGreater(after[('qgis_server_request_duration_seconds_sum', labels)], 0)
+
+        for name in ('Country', 'Hello'):
+            self.assertEqual(self._layer_metric(after, 'qgis_server_layer_renders_total', name),
+                             self._layer_metric(before, 'qgis_server_layer_renders_total', name) + 2)
+            self.assertEqual(self._layer_metric(after, 'qgis_server_layer_render_errors_total', name), 0)
+        self.assertIn(('qgis_server_stage_seconds_total', 'stage="render"'), after)
+
+    def test_disabled(self):
+        self.server.putenv('QGIS_SERVER_METRICS', '0')
+        try:
+            body, headers = self._get_map()
+            self.assertNotIn('Server-Timing', headers)
+        finally:
+            self.server.putenv('QGIS_SERVER_METRICS', '1')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,90 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the project snapshots read by QgsServer.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import shutil
+import tempfile
+import urllib.parse
+
+from qgis.testing import unittest
+from qgis.PyQt.QtXml import QDomDocument
+from qgis.core import QgsProject, QgsProjectSnapshot
+import osgeo.gdal  # NOQA
+from test_qgsserver import QgsServerTestBase
+
+
+class TestQgsServerProjectSnapshot(QgsServerTestBase):
+
+    """QGIS Server tests of the QGIS_SERVER_PROJECT_SNAPSHOT setting"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestQgsServerProjectSnapshot, cls).setUpClass()
+        cls.temp_path = tempfile.mkdtemp()
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.temp_path, True)
+        super(TestQgsServerProjectSnapshot, cls).tearDownClass()
+
+    def tearDown(self):
+        self.server.putenv('QGIS_SERVER_PROJECT_SNAPSHOT', '')
+        super(TestQgsServerProjectSnapshot, self).tearDown()
+
+    def _write_project(self, name):
+        """Writes a project and a snapshot which is up to date but has another service title,
+        so that the responses tell whether the project is read from its snapshot"""
+        project = QgsProject()
+        project.writeEntry('WMSServiceCapabilities', '/', True)
+        project.writeEntry('WMSServiceTitle', '/', 'Project title')
+        path = os.path.join(self.temp_path, name + '.qgs')
+        self.assertTrue(project.write(path))
+
+        doc = QDomDocument()
+        with open(path, 'rb') as f:
+            content = f.read()
+        self.assertTrue(doc.setContent(content)[0])
+        title = doc.elementsByTagName('WMSServiceTitle').at(0)
+        title.replaceChild(doc.createTextNode('Snapshot title'), title.firstChild())
+        self.assertTrue(QgsProjectSnapshot.write(path, doc, content))
+        return path
+
+    def _service_title(self, path):
+        qs = '?' + '&'.join(['%s=%s' % i for i in sorted({
+            'MAP': urllib.parse.quote(path),
+            'SERVICE': 'WMS',
+            'VERSION': '1.3.0',
+            'REQUEST': 'GetCapabilities'
+        }.items())])
+        header, body = self._execute_request(qs)
+        doc = QDomDocument()
+        self.assertTrue(doc.setContent(body, True)[0], body)
+        service = doc.documentElement().firstChildElement('Service')
+        return service.firstChildElement('Title').text()
+
+    def test_snapshot_disabled(self):
+        """The snapshot is not read when the setting is off"""
+        path = self._write_project('disabled')
+        self.assertEqual(self._service_title(path), 'Project title')
+
+    def test_snapshot_enabled(self):
+        """The snapshot is read with namespace processing when the setting is on"""
+        self.server.putenv('QGIS_SERVER_PROJECT_SNAPSHOT', '1')
+        path = self._write_project('enabled')
+        self.assertEqual(self._service_title(path), 'Snapshot title')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -115,6 +115,96 @@ class TestQgsServerSettings(unittest.TestCase):
         self.assertEqual(self.settings.maxThreads(), 5)
         os.environ.pop(env)
 
+    def test_env_parallel_requests(self):
+        env = "QGIS_SERVER_PARALLEL_REQUESTS"
+
+        self.assertEqual(self.settings.parallelRequests(), 1)
+
+        os.environ[env] = "8"
+        self.settings.load()
+        self.assertEqual(self.settings.parallelRequests(), 8)
+        os.environ.pop(env)
+
+    def test_env_tile_cache(self):
+        self.assertEqual(self.settings.tileCacheSize(), 0)
+        self.assertEqual(self.settings.tileCacheDirectory(), "")
+        self.assertEqual(self.settings.metatileSize(), 4)
+
+        os.environ["QGIS_SERVER_TILE_CACHE_SIZE"] = "1048576"
+        os.environ["QGIS_SERVER_TILE_CACHE_DIRECTORY"] = "/tmp/fake_tiles"
+        os.environ["QGIS_SERVER_METATILE_SIZE"] = "2"
+        self.settings.load()
+        self.assertEqual(self.settings.tileCacheSize(), 1048576)
+        self.assertEqual(self.settings.tileCacheDirectory(), "/tmp/fake_tiles")
+        self.assertEqual(self.settings.metatileSize(), 2)
+        os.environ.pop("QGIS_SERVER_TILE_CACHE_SIZE")
+        os.environ.pop("QGIS_SERVER_TILE_CACHE_DIRECTORY")
+        os.environ.pop("QGIS_SERVER_METATILE_SIZE")
+
+    def test_env_png8_palette_cache(self):
+        env = "QGIS_SERVER_PNG8_PALETTE_CACHE"
+
+        self.assertFalse(self.settings.png8PaletteCache())
+
+        os.environ[env] = "1"
+        self.settings.load()
+        self.assertTrue(self.settings.png8PaletteCache())
+        os.environ.pop(env)
+
+    def test_env_feature_info_index(self):
+        env = "QGIS_SERVER_FEATURE_INFO_INDEX_MAX_FEATURES"
+
+        self.assertEqual(self.settings.featureInfoIndexMaxFeatures(), 0)
+
+        os.environ[env] = "100000"
+        self.settings.load()
+        self.assertEqual(self.settings.featureInfoIndexMaxFeatures(), 100000)
+        os.environ.pop(env)
+
+    def test_env_project_snapshot(self):
+        env = "QGIS_SERVER_PROJECT_SNAPSHOT"
+
+        self.assertFalse(self.settings.projectSnapshot())
+
+        os.environ[env] = "1"
+        self.settings.load()
+        self.assertTrue(self.settings.projectSnapshot())
+        os.environ.pop(env)
+
+    def test_env_metrics(self):
+        env = "QGIS_SERVER_METRICS"
+
+        self.assertFalse(self.settings.metrics())
+
+        os.environ[env] = "1"
+        self.settings.load()
+        self.assertTrue(self.settings.metrics())
+        os.environ.pop(env)
+
+    def test_env_capabilities_cache(self):
+        self.assertEqual(self.settings.capabilitiesCacheDirectory(), "")
+        self.assertFalse(self.settings.capabilitiesConditionalRequests())
+
+        os.environ["QGIS_SERVER_CAPABILITIES_CACHE_DIRECTORY"] = "/tmp/fake_capabilities"
+        os.environ["QGIS_SERVER_CAPABILITIES_CONDITIONAL_REQUESTS"] = "1"
+        self.settings.load()
+        self.assertEqual(self.settings.capabilitiesCacheDirectory(), "/tmp/fake_capabilities")
+        self.assertTrue(self.settings.capabilitiesConditionalRequests())
+        os.environ.pop("QGIS_SERVER_CAPABILITIES_CACHE_DIRECTORY")
+        os.environ.pop("QGIS_SERVER_CAPABILITIES_CONDITIONAL_REQUESTS")
+
+    def test_env_response_compression(self):
+        self.assertFalse(self.settings.responseCompression())
+        self.assertEqual(self.settings.responseFlushThreshold(), 0)
+
+        os.environ["QGIS_SERVER_RESPONSE_COMPRESSION"] = "1"
+        os.environ["QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD"] = "65536"
+        self.settings.load()
+        self.assertTrue(self.settings.responseCompression())
+        self.assertEqual(self.settings.responseFlushThreshold(), 65536)
+        os.environ.pop("QGIS_SERVER_RESPONSE_COMPRESSION")
+        os.environ.pop("QGIS_SERVER_RESPONSE_FLUSH_THRESHOLD")
+
     def test_env_cache_size(self):
         env = "QGIS_SERVER_CACHE_SIZE"
 
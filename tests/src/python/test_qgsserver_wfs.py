@@ -0,0 +1,272 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsServer WFS GetFeature output.
+
+The features written by the server are compared with the output of the
+DOM serializer and of QgsJSONExporter, which GetFeature used to build
+each feature with.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+
+# Deterministic XML
+os.environ['QT_HASH_SEED'] = '1'
+
+import json
+import shutil
+import tempfile
+import urllib.parse
+
+from qgis.testing import unittest
+from qgis.PyQt.QtXml import QDomDocument
+from qgis.core import (
+    NULL,
+    QgsGeometry,
+    QgsJSONExporter,
+    QgsOgcUtils,
+    QgsProject,
+    QgsVectorLayer,
+    QgsWkbTypes,
+)
+import osgeo.gdal  # NOQA
+from test_qgsserver import QgsServerTestBase
+
+GML_NS = 'http://www.opengis.net/gml'
+PRECISION = 3
+
+PROPERTIES = [
+    {'name': 'a < b & "c" \'d\' > e', 'value': 1.5, 'count': 3, 'with space': ']]> & &amp;'},
+    {'name': 'tab\tnew\nline\r', 'value': -0.25, 'count': -7, 'with space': 'ünïcødé €'},
+    {'name': '', 'value': None, 'count': None, 'with space': None},
+]
+
+GEOMETRIES = {
+    'points': [
+        {'type': 'Point', 'coordinates': [8.203496, 44.901483]},
+        {'type': 'Point', 'coordinates': [-0.0001234, 0.98765432]},
+        {'type': 'Point', 'coordinates': [100, -45.5]},
+    ],
+    'multipoints': [
+        {'type': 'MultiPoint', 'coordinates': [[1.123456, 2.654321], [3, 4]]},
+        {'type': 'MultiPoint', 'coordinates': [[-5.5, 6.25]]},
+        {'type': 'MultiPoint', 'coordinates': [[7, 8], [9, 10], [11.0001, 12.9999]]},
+    ],
+    'lines': [
+        {'type': 'LineString', 'coordinates': [[0, 0], [1.5, 2.5], [3.33333, -4.44444]]},
+        {'type': 'LineString', 'coordinates': [[10, 10], [20, 20]]},
+        {'type': 'LineString', 'coordinates': [[-1, -1], [-2, 0], [-3, -1], [-4, 0]]},
+    ],
+    'multilines': [
+        {'type': 'MultiLineString', 'coordinates': [[[0, 0], [1, 1]], [[2, 2], [3, 3.5], [4, 2]]]},
+        {'type': 'MultiLineString', 'coordinates': [[[-10.123456, 5], [10.654321, 5]]]},
+        {'type': 'MultiLineString', 'coordinates': [[[0, 0], [0, 1]], [[1, 0], [1, 1]], [[2, 0], [2, 1]]]},
+    ],
+    'polygons': [
+        {'type': 'Polygon', 'coordinates': [[[0, 0], [10, 0], [10, 10], [0, 10], [0, 0]],
+                                            [[2, 2], [2, 4], [4, 4], [4, 2], [2, 2]]]},
+        {'type': 'Polygon', 'coordinates': [[[20.1234, 20], [30, 20.5678], [25, 30], [20.1234, 20]]]},
+        {'type': 'Polygon', 'coordinates': [[[-5, -5], [-1, -5], [-1, -1], [-5, -1], [-5, -5]]]},
+    ],
+    'multipolygons': [
+        {'type': 'MultiPolygon', 'coordinates': [[[[0, 0], [1, 0], [1, 1], [0, 1], [0, 0]]],
+                                                 [[[2, 2], [5, 2], [5, 5], [2, 5], [2, 2]],
+                                                  [[3, 3], [3, 4], [4, 4], [4, 3], [3, 3]]]]},
+        {'type': 'MultiPolygon', 'coordinates': [[[[-10, 40], [-9.5, 40], [-9.5, 40.5], [-10, 40]]]]},
+        {'type': 'MultiPolygon', 'coordinates': [[[[100, 0], [101, 0], [101, 1], [100, 1], [100, 0]]],
+                                                 [[[102, 0], [103, 0], [103, 1], [102, 1], [102, 0]]]]},
+    ],
+}
+
+
+class TestQgsServerWFS(QgsServerTestBase):
+
+    """QGIS Server WFS GetFeature tests"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestQgsServerWFS, cls).setUpClass()
+        cls.temp_path = tempfile.mkdtemp()
+        cls.wfs_project_path = os.path.join(cls.temp_path, 'wfs_getfeature.qgs')
+
+        project = QgsProject()
+        layers = []
+        for name, geometries in sorted(GEOMETRIES.items()):
+            features = [{'type': 'Feature', 'properties': properties, 'geometry': geometry}
+                        for properties, geometry in zip(PROPERTIES, geometries)]
+            path = os.path.join(cls.temp_path, name + '.geojson')
+            with open(path, 'w', encoding='utf-8') as f:
+                json.dump({'type': 'FeatureCollection', 'features': features}, f, ensure_ascii=False)
+            layer = QgsVectorLayer(path, name, 'ogr')
+            assert layer.isValid(), path
+            layers.append(layer)
+        project.addMapLayers(layers)
+        project.writeEntry('WFSLayers', '/', [layer.id() for layer in layers])
+        for layer in layers:
+            project.writeEntry('WFSLayersPrecision', '/' + layer.id(), PRECISION)
+        assert project.write(cls.wfs_project_path)
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.temp_path, True)
+        super(TestQgsServerWFS, cls).tearDownClass()
+
+    def _get_feature(self, type_name, output_format, geometry_name=None):
+        qs = '?MAP=%s&SERVICE=WFS&VERSION=1.0.0&REQUEST=GetFeature&TYPENAME=%s&OUTPUTFORMAT=%s' % (
+            urllib.parse.quote(self.wfs_project_path), type_name, output_format)
+        if geometry_name:
+            qs += '&GEOMETRYNAME=%s' % geometry_name
+        header, body = self._execute_request(qs)
+        self.assertFalse(b'ServiceException' in body, body)
+        return body
+
+    def _layer(self, type_name):
+        layer = QgsVectorLayer(os.path.join(self.temp_path, type_name + '.geojson'), type_name, 'ogr')
+        self.assertTrue(layer.isValid())
+        return layer
+
+    @staticmethod
+    def _attribute_text(value):
+        if value is None or value == NULL:
+            return ''
+        return str(value)
+
+    @staticmethod
+    def _geometry_gml(geometry, doc, gml3):
+        if gml3:
+            return geometry.geometry().asGML3(doc, PRECISION, GML_NS)
+        if QgsWkbTypes.flatType(geometry.wkbType()) == QgsWkbTypes.MultiLineString:
+            # QgsMultiLineString::asGML2() deletes the line strings of the geometry
+            element = doc.createElementNS(GML_NS, 'MultiLineString')
+            for i in range(geometry.geometry().numGeometries()):
+                member = doc.createElementNS(GML_NS, 'lineStringMember')
+                member.appendChild(geometry.geometry().geometryN(i).asGML2(doc, PRECISION, GML_NS))
+                element.appendChild(member)
+            return element
+        return geometry.geometry().asGML2(doc, PRECISION, GML_NS)
+
+    def _expected_gml_feature(self, feature, type_name, gml3, geometry_name):
+        """Feature member as serialized by QDomDocument"""
+        doc = QDomDocument()
+        feature_element = doc.createElement('gml:featureMember')
+        type_name_element = doc.createElement('qgs:' + type_name)
+        type_name_element.setAttribute('gml:id' if gml3 else 'fid', '%s.%d' % (type_name, feature.id()))
+        feature_element.appendChild(type_name_element)
+
+        geometry = feature.geometry()
+        box = geometry.boundingBox()
+        if geometry_name == 'EXTENT':
+            gml_geometry = QgsGeometry.fromRect(box)
+        elif geometry_name == 'CENTROID':
+            gml_geometry = geometry.centroid()
+        else:
+            gml_geometry = None
+
+        if gml_geometry is not None:
+            if gml3:
+                gml_element = QgsOgcUtils.geometryToGML(gml_geometry, doc, 'GML3', PRECISION)
+            else:
+                gml_element = QgsOgcUtils.geometryToGML(gml_geometry, doc, PRECISION)
+        else:
+            gml_element = self._geometry_gml(geometry, doc, gml3)
+
+        bounded_by = doc.createElement('gml:boundedBy')
+        if gml3:
+            box_element = QgsOgcUtils.rectangleToGMLEnvelope(box, doc, PRECISION)
+        else:
+            box_element = QgsOgcUtils.rectangleToGMLBox(box, doc, PRECISION)
+        box_element.setAttribute('srsName', 'EPSG:4326')
+        gml_element.setAttribute('srsName', 'EPSG:4326')
+        bounded_by.appendChild(box_element)
+        type_name_element.appendChild(bounded_by)
+        geometry_element = doc.createElement('qgs:geometry')
+        geometry_element.appendChild(gml_element)
+        type_name_element.appendChild(geometry_element)
+
+        for field, value in zip(feature.fields(), feature.attributes()):
+            field_element = doc.createElement('qgs:' + field.name().replace(' ', '_'))
+            field_element.appendChild(doc.createTextNode(self._attribute_text(value)))
+            type_name_element.appendChild(field_element)
+
+        doc.appendChild(feature_element)
+        return bytes(doc.toByteArray())
+
+    def _expected_geojson_feature(self, feature, type_name, geometry_name):
+        """Feature as exported by QgsJSONExporter"""
+        layer = self._layer(type_name)
+        exporter = QgsJSONExporter()
+        exporter.setSourceCrs(layer.crs())
+        exporter.setIncludeGeometry(True)
+        geometry = feature.geometry()
+        if geometry_name == 'EXTENT':
+            feature.setGeometry(QgsGeometry.fromRect(geometry.boundingBox()))
+        elif geometry_name == 'CENTROID':
+            feature.setGeometry(geometry.centroid())
+        exporter.setIncludeAttributes(True)
+        exporter.setAttributes(list(range(feature.fields().count())))
+        return exporter.exportFeature(feature, {}, '%s.%d' % (type_name, feature.id()))
+
+    def _check_gml(self, type_name, gml3, geometry_name=None):
+        body = self._get_feature(type_name, 'GML3' if gml3 else 'GML2', geometry_name)
+        features = [self._expected_gml_feature(f, type_name, gml3, geometry_name)
+                    for f in self._layer(type_name).getFeatures()]
+        self.assertEqual(len(features), len(PROPERTIES))
+        expected = b''.join(features) + b'</wfs:FeatureCollection>\n'
+        self.assertTrue(body.endswith(expected),
+                        "GetFeature %s %s %s failed.\nExpected:\n%s\nResponse:\n%s" % (
+                            type_name, 'GML3' if gml3 else 'GML2', geometry_name,
+                            expected.decode('utf-8'), body.decode('utf-8')))
+
+    def _check_geojson(self, type_name, geometry_name=None):
+        body = self._get_feature(type_name, 'GeoJSON', geometry_name)
+        features = [self._expected_geojson_feature(f, type_name, geometry_name)
+                    for f in self._layer(type_name).getFeatures()]
+        self.assertEqual(len(features), len(PROPERTIES))
+        expected = '  ' + ' ,'.join(feature + '\n' for feature in features) + ' ]\n}'
+        self.assertTrue(body.decode('utf-8').endswith(expected),
+                        "GetFeature %s GeoJSON %s failed.\nExpected:\n%s\nResponse:\n%s" % (
+                            type_name, geometry_name, expected, body.decode('utf-8')))
+        # The response must be valid JSON with the escaped attributes
+        collection = json.loads(body.decode('utf-8'))
+        self.assertEqual([f['properties']['name'] for f in collection['features']],
+                         [p['name'] for p in PROPERTIES])
+
+    def test_getfeature_gml2(self):
+        for type_name in sorted(GEOMETRIES):
+            self._check_gml(type_name, False)
+
+    def test_getfeature_gml3(self):
+        for type_name in sorted(GEOMETRIES):
+            self._check_gml(type_name, True)
+
+    def test_getfeature_geojson(self):
+        for type_name in sorted(GEOMETRIES):
+            self._check_geojson(type_name)
+
+    def test_getfeature_extent_centroid(self):
+        for geometry_name in ('EXTENT', 'CENTROID'):
+            for type_name in ('lines', 'polygons', 'multipolygons'):
+                self._check_gml(type_name, False, geometry_name)
+                self._check_gml(type_name, True, geometry_name)
+                self._check_geojson(type_name, geometry_name)
+
+    def test_getfeature_escaping(self):
+        """Attribute values are escaped like QDomDocument does"""
+        body = self._get_feature('points', 'GML2')
+        self.assertTrue(b'<qgs:name>a &lt; b &amp; "c" \'d\' &gt; e</qgs:name>' in body, body)
+        self.assertTrue(b'<qgs:with_space>]]&gt; &amp; &amp;amp;</qgs:with_space>' in body, body)
+        self.assertTrue('<qgs:with_space>ünïcødé €</qgs:with_space>'.encode('utf-8') in body, body)
+        self.assertTrue(b'<qgs:name></qgs:name>' in body, body)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -21,6 +21,7 @@ import os
 # Needed on Qt 5 so that the serialization of XML is consistent among all executions
 os.environ['QT_HASH_SEED'] = '1'
 
+import gzip
 import re
 import urllib.request
 import urllib.parse
@@ -28,9 +29,12 @@ import urllib.error
 
 from qgis.testing import unittest
 from qgis.PyQt.QtCore import QSize
+from qgis.PyQt.QtXml import QDomDocument
 
 import osgeo.gdal  # NOQA
 
+from qgis.server import QgsServerRequest, QgsBufferServerRequest, QgsBufferServerResponse
+
 from test_qgsserver import QgsServerTestBase
 
 # Strip path and content length because path may vary
@@ -279,6 +283,61 @@ class TestQgsServerWMS(QgsServerTestBase):
                 item_found = True
         self.assertTrue(item_found)
 
+    def test_wms_getcapabilities_gzip(self):
+        project = os.path.join(self.testdata_path, "test_project.qgs")
+        qs = "?" + "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(project),
+            "SERVICE": "WMS",
+            "VERSION": "1.3.0",
+            "REQUEST": "GetCapabilities"
+        }.items())])
+
+        header, body = self._execute_request(qs)
+
+        request = QgsBufferServerRequest(qs, QgsServerRequest.GetMethod, {'Accept-Encoding': 'deflate, gzip'})
+        response = QgsBufferServerResponse()
+        self.server.handleRequest(request, response)
+        self.assertEqual(response.headers()['Content-Encoding'], 'gzip')
+        self.assertEqual(gzip.decompress(bytes(response.body())), body)
+
+        # gzip refused by the client
+        request = QgsBufferServerRequest(qs, QgsServerRequest.GetMethod, {'Accept-Encoding': 'gzip;q=0'})
+        response = QgsBufferServerResponse()
+        self.server.handleRequest(request, response)
+        self.assertFalse('Content-Encoding' in response.headers())
+        self.assertEqual(bytes(response.body()), body)
+
+    def test_wms_getcapabilities_cache_document(self):
+        """The documents of the cached capabilities are available to the plugins"""
+        project = os.path.join(self.testdata_path, "test_project.qgs")
+        qs = "?" + "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(project),
+            "SERVICE": "WMS",
+            "VERSION": "1.3.0",
+            "REQUEST": "GetCapabilities"
+        }.items())])
+        cache = self.server.serverInterface().capabilitiesCache()
+        cache.removeCapabilitiesDocument(project)
+
+        try:
+            header, body = self._execute_request(qs)
+            doc = cache.searchCapabilitiesDocument(project, '1.3.0-')
+            self.assertIsNotNone(doc)
+            self.assertEqual(doc.documentElement().tagName(), 'WMS_Capabilities')
+            self.assertEqual(doc.elementsByTagName('Layer').count(), body.count(b'<Layer '))
+
+            # a document inserted by a plugin is served
+            doc = QDomDocument()
+            self.assertTrue(doc.setContent('<WMS_Capabilities version="1.3.0"><Service><Title>Inserted</Title></Service></WMS_Capabilities>')[0])
+            cache.insertCapabilitiesDocument(project, '1.3.0-', doc)
+            header, body = self._execute_request(qs)
+            self.assertIn(b'<Title>Inserted</Title>', body)
+            self.assertNotIn(b'<Layer ', body)
+            title = cache.searchCapabilitiesDocument(project, '1.3.0-').elementsByTagName('Title').at(0)
+            self.assertEqual(title.toElement().text(), 'Inserted')
+        finally:
+            cache.removeCapabilitiesDocument(project)
+
     def test_wms_getmap_invalid_size(self):
         project = os.path.join(self.testdata_path, "test_project_with_size.qgs")
         qs = "?" + "&".join(["%s=%s" % i for i in list({
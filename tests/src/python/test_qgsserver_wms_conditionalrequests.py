@@ -0,0 +1,110 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the conditional WMS GetCapabilities requests of QgsServer.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import gzip
+import urllib.parse
+from email.utils import formatdate, parsedate_to_datetime
+
+os.environ['QGIS_SERVER_CAPABILITIES_CONDITIONAL_REQUESTS'] = '1'
+
+from qgis.testing import unittest
+from qgis.server import QgsBufferServerRequest, QgsBufferServerResponse, QgsServerRequest
+import osgeo.gdal  # NOQA
+from test_qgsserver import QgsServerTestBase
+
+
+class TestQgsServerWMSConditionalRequests(QgsServerTestBase):
+
+    """QGIS Server WMS GetCapabilities ETag and Last-Modified tests"""
+
+    def _get_capabilities(self, headers={}):
+        qs = '?' + '&'.join(['%s=%s' % i for i in sorted({
+            'MAP': urllib.parse.quote(self.projectPath),
+            'SERVICE': 'WMS',
+            'VERSION': '1.3.0',
+            'REQUEST': 'GetCapabilities'
+        }.items())])
+        request = QgsBufferServerRequest(qs, QgsServerRequest.GetMethod, headers)
+        response = QgsBufferServerResponse()
+        self.server.handleRequest(request, response)
+        return response.statusCode(), response.headers(), bytes(response.body())
+
+    def test_etag(self):
+        status, headers, body = self._get_capabilities()
+        self.assertEqual(status, 200)
+        self.assertIn(b'WMS_Capabilities', body)
+        etag = headers['ETag']
+        self.assertTrue(etag.startswith('"') and etag.endswith('"'), etag)
+        self.assertEqual(headers['Vary'], 'Accept-Encoding')
+
+        for if_none_match in (etag, 'W/' + etag, '"other", ' + etag, '*'):
+            status, headers, body = self._get_capabilities({'If-None-Match': if_none_match})
+            self.assertEqual(status, 304, if_none_match)
+            self.assertEqual(body, b'')
+            self.assertEqual(headers['ETag'], etag)
+
+        status, headers, body = self._get_capabilities({'If-None-Match': '"other"'})
+        self.assertEqual(status, 200)
+        self.assertIn(b'WMS_Capabilities', body)
+
+    def test_gzip_etag(self):
+        """The gzip and identity contents have different strong entity tags"""
+        status, headers, identity = self._get_capabilities()
+        etag = headers['ETag']
+
+        status, headers, body = self._get_capabilities({'Accept-Encoding': 'gzip'})
+        self.assertEqual(status, 200)
+        self.assertEqual(headers['Content-Encoding'], 'gzip')
+        self.assertEqual(gzip.decompress(body), identity)
+        gzip_etag = headers['ETag']
+        self.assertEqual(gzip_etag, etag[:-1] + '-gzip"')
+
+        # a client which has the identity content gets the gzip content
+        status, headers, body = self._get_capabilities({'Accept-Encoding': 'gzip', 'If-None-Match': etag})
+        self.assertEqual(status, 200)
+        self.assertEqual(gzip.decompress(body), identity)
+
+        status, headers, body = self._get_capabilities({'Accept-Encoding': 'gzip', 'If-None-Match': gzip_etag})
+        self.assertEqual(status, 304)
+        self.assertEqual(headers['ETag'], gzip_etag)
+
+        # and conversely
+        status, headers, body = self._get_capabilities({'If-None-Match': gzip_etag})
+        self.assertEqual(status, 200)
+        self.assertEqual(body, identity)
+
+    def test_last_modified(self):
+        status, headers, body = self._get_capabilities()
+        last_modified = headers['Last-Modified']
+        modified = parsedate_to_datetime(last_modified).timestamp()
+
+        status, headers, body = self._get_capabilities({'If-Modified-Since': last_modified})
+        self.assertEqual(status, 304)
+        self.assertEqual(body, b'')
+        status, headers, body = self._get_capabilities({'If-Modified-Since': formatdate(modified + 3600, usegmt=True)})
+        self.assertEqual(status, 304)
+
+        status, headers, body = self._get_capabilities({'If-Modified-Since': formatdate(modified - 3600, usegmt=True)})
+        self.assertEqual(status, 200)
+        self.assertIn(b'WMS_Capabilities', body)
+
+        # If-Modified-Since is ignored when If-None-Match is sent
+        status, headers, body = self._get_capabilities({'If-Modified-Since': last_modified, 'If-None-Match': '"other"'})
+        self.assertEqual(status, 200)
+
+
+if __name__ == '__main__':
+    unittest.main()
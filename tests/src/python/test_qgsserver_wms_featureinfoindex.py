@@ -0,0 +1,116 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsServer WMS GetFeatureInfo with the feature info index.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import json
+import shutil
+import tempfile
+import urllib.parse
+import xml.etree.ElementTree as ET
+
+# The index is configured when the server is initialized
+os.environ['QGIS_SERVER_FEATURE_INFO_INDEX_MAX_FEATURES'] = '1000'
+
+from qgis.testing import unittest
+from qgis.core import QgsProject, QgsVectorLayer
+import osgeo.gdal  # NOQA
+from test_qgsserver import QgsServerTestBase
+
+# Feature ids in another order than the features of the file, i.e. the provider order
+FEATURE_IDS = [7, 3, 11, 1, 9, 5, 12, 2, 10, 4, 8, 6]
+
+
+def geometry(rank):
+    """Squares containing the point 60,60 for the even ranks, triangles whose
+    bounding box contains the point but not the geometry for the odd ranks"""
+    if rank % 2 == 0:
+        d = 5 + rank
+        ring = [[60 - d, 60 - d], [60 + d, 60 - d], [60 + d, 60 + d], [60 - d, 60 + d], [60 - d, 60 - d]]
+    else:
+        ring = [[0, 0], [100, 0], [0, 100], [0, 0]]
+    return {'type': 'Polygon', 'coordinates': [ring]}
+
+
+class TestQgsServerWMSFeatureInfoIndex(QgsServerTestBase):
+
+    """QGIS Server WMS GetFeatureInfo tests with the feature info index enabled"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestQgsServerWMSFeatureInfoIndex, cls).setUpClass()
+        cls.temp_path = tempfile.mkdtemp()
+        path = os.path.join(cls.temp_path, 'shapes.geojson')
+        features = [{'type': 'Feature', 'id': fid, 'properties': {'rank': rank}, 'geometry': geometry(rank)}
+                    for rank, fid in enumerate(FEATURE_IDS)]
+        with open(path, 'w') as f:
+            json.dump({'type': 'FeatureCollection', 'features': features}, f)
+        layer = QgsVectorLayer(path, 'shapes', 'ogr')
+        assert layer.isValid(), path
+        assert [f.id() for f in layer.getFeatures()] == FEATURE_IDS
+        project = QgsProject()
+        project.addMapLayer(layer)
+        cls.index_project_path = os.path.join(cls.temp_path, 'featureinfoindex.qgs')
+        assert project.write(cls.index_project_path)
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.temp_path, True)
+        super(TestQgsServerWMSFeatureInfoIndex, cls).tearDownClass()
+
+    def _ranks(self, x, y, feature_count=None):
+        params = {
+            'MAP': urllib.parse.quote(self.index_project_path),
+            'SERVICE': 'WMS',
+            'VERSION': '1.1.1',
+            'REQUEST': 'GetFeatureInfo',
+            'LAYERS': 'shapes',
+            'QUERY_LAYERS': 'shapes',
+            'STYLES': '',
+            'INFO_FORMAT': 'text/xml',
+            'BBOX': '0,0,100,100',
+            'WIDTH': '100',
+            'HEIGHT': '100',
+            'SRS': 'EPSG:4326',
+            'X': str(x),
+            'Y': str(y)
+        }
+        if feature_count is not None:
+            params['FEATURE_COUNT'] = str(feature_count)
+        qs = '?' + '&'.join(['%s=%s' % i for i in sorted(params.items())])
+        header, body = self._execute_request(qs)
+        ranks = []
+        for element in ET.fromstring(body).iter():
+            if element.tag.endswith('Attribute') and element.get('name') == 'rank':
+                ranks.append(int(element.get('value')))
+        return ranks
+
+    def test_exact_hits(self):
+        """Features whose bounding box only contains the point are not returned"""
+        # the index is built by the first request, and used by the next ones
+        for _ in range(2):
+            self.assertEqual(self._ranks(60, 40, 100), [0, 2, 4, 6, 8, 10])
+            self.assertEqual(self._ranks(95, 50, 100), [])
+
+    def test_feature_count_order(self):
+        """FEATURE_COUNT returns the first features in provider order"""
+        for _ in range(2):
+            self.assertEqual(self._ranks(60, 40), [0])
+            self.assertEqual(self._ranks(60, 40, 3), [0, 2, 4])
+            # only the largest squares contain this point
+            self.assertEqual(self._ranks(74, 26, 2), [10])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,180 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the QgsServer WMS GetPrint maps rendered concurrently.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import json
+import shutil
+import tempfile
+import urllib.parse
+
+# The maps of the raster outputs are prerendered with parallel rendering, the
+# layers rendered by the prerendering jobs are reported in the Server-Timing header
+os.environ['QGIS_SERVER_PARALLEL_RENDERING'] = '1'
+os.environ['QGIS_SERVER_METRICS'] = '1'
+
+from qgis.testing import unittest
+from qgis.PyQt.QtGui import QImage, QColor, QPainter
+from qgis.core import (QgsComposerMap,
+                       QgsComposition,
+                       QgsCoordinateReferenceSystem,
+                       QgsFillSymbol,
+                       QgsProject,
+                       QgsSingleSymbolRenderer,
+                       QgsVectorLayer)
+import osgeo.gdal  # NOQA
+from test_qgsserver import QgsServerTestBase
+
+LAYERS = {
+    'red': ([[[10, 10], [60, 10], [60, 90], [10, 90], [10, 10]]], '255,0,0'),
+    'blue': ([[[0, 40], [100, 40], [100, 70], [0, 70], [0, 40]]], '0,0,255'),
+}
+
+
+class TestQgsServerWMSGetPrintParallel(QgsServerTestBase):
+
+    """QGIS Server WMS GetPrint tests with the maps prerendered by parallel jobs"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestQgsServerWMSGetPrintParallel, cls).setUpClass()
+        cls.temp_path = tempfile.mkdtemp()
+
+        project = QgsProject()
+        project.setCrs(QgsCoordinateReferenceSystem('EPSG:4326'))
+        cls.layer_ids = {}
+        for name, (polygon, color) in sorted(LAYERS.items()):
+            path = os.path.join(cls.temp_path, name + '.geojson')
+            with open(path, 'w') as f:
+                json.dump({'type': 'FeatureCollection', 'features': [
+                    {'type': 'Feature', 'properties': {}, 'geometry': {'type': 'Polygon', 'coordinates': polygon}}]}, f)
+            layer = QgsVectorLayer(path, name, 'ogr')
+            assert layer.isValid(), path
+            layer.setRenderer(QgsSingleSymbolRenderer(QgsFillSymbol.createSimple({'color': color, 'outline_style': 'no'})))
+            if name == 'blue':
+                # blended with the items beneath it on the page
+                layer.setBlendMode(QPainter.CompositionMode_Multiply)
+            project.addMapLayer(layer)
+            cls.layer_ids[name] = layer.id()
+
+        composition = QgsComposition(project)
+        composition.setName('twomaps')
+        composition.setPaperSize(297, 210)
+        composition.setPrintResolution(96)
+        for x in (10, 155):
+            composer_map = QgsComposerMap(composition, x, 10, 130, 130)
+            composition.addComposerMap(composer_map)
+        project.layoutManager().addComposition(composition)
+
+        cls.print_project_path = os.path.join(cls.temp_path, 'getprint.qgs')
+        assert project.write(cls.print_project_path)
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.temp_path, True)
+        super(TestQgsServerWMSGetPrintParallel, cls).tearDownClass()
+
+    def tearDown(self):
+        self.server.putenv('QGIS_SERVER_PARALLEL_RENDERING', '1')
+        super(TestQgsServerWMSGetPrintParallel, self).tearDown()
+
+    def _get_print(self, params):
+        params = dict(params)
+        params.update({
+            'SERVICE': 'WMS',
+            'VERSION': '1.1.1',
+            'REQUEST': 'GetPrint',
+            'FORMAT': 'png'
+        })
+        qs = '?' + '&'.join(['%s=%s' % i for i in sorted(params.items())])
+        return self._result(self._execute_request(qs))
+
+    def _two_maps(self, map1_layers):
+        return self._get_print({
+            'MAP': urllib.parse.quote(self.print_project_path),
+            'TEMPLATE': 'twomaps',
+            'CRS': 'EPSG:4326',
+            'map0:EXTENT': '0,0,100,100',
+            'map0:LAYERS': 'red',
+            'map1:EXTENT': '0,0,100,100',
+            'map1:LAYERS': map1_layers
+        })
+
+    def _rendered_layers(self, headers):
+        """Returns the ids of the layers rendered by the prerendering jobs"""
+        layers = []
+        for entry in headers['Server-Timing'].split(', '):
+            params = entry.split(';')
+            if params[0] == 'layer':
+                layers.append(dict(param.split('=', 1) for param in params[1:])['desc'].strip('"'))
+        return sorted(layers)
+
+    def assertImagesEqual(self, body, expected_body):
+        image = QImage.fromData(body, 'PNG').convertToFormat(QImage.Format_ARGB32)
+        expected = QImage.fromData(expected_body, 'PNG').convertToFormat(QImage.Format_ARGB32)
+        self.assertFalse(image.isNull())
+        self.assertEqual(image.size(), expected.size())
+        different = 0
+        for y in range(expected.height()):
+            for x in range(expected.width()):
+                a = QColor.fromRgba(image.pixel(x, y))
+                b = QColor.fromRgba(expected.pixel(x, y))
+                if max(abs(a.red() - b.red()), abs(a.green() - b.green()), abs(a.blue() - b.blue()), abs(a.alpha() - b.alpha())) > 8:
+                    different += 1
+        # allow some antialiasing differences along the edges of the shapes
+        self.assertLessEqual(different, expected.width() + expected.height())
+
+    def test_getprint_basic(self):
+        """The prerendered map gives the reference image"""
+        r, h = self._get_print({
+            'MAP': urllib.parse.quote(self.projectPath),
+            'TEMPLATE': 'layoutA4',
+            'map0:EXTENT': '-33626185.498,-13032965.185,33978427.737,16020257.031',
+            'map0:LAYERS': 'Country,Hello',
+            'HEIGHT': '500',
+            'WIDTH': '500',
+            'CRS': 'EPSG:3857'
+        })
+        self.assertEqual(len(self._rendered_layers(h)), 2)
+        self._img_diff_error(r, h, 'WMS_GetPrint_Basic')
+
+    def test_getprint_two_maps(self):
+        """All the maps of the page are prerendered, as they would be rendered on the page"""
+        body, headers = self._two_maps('red')
+        self.assertEqual(headers['Content-Type'], 'image/png')
+        self.assertEqual(self._rendered_layers(headers), [self.layer_ids['red']] * 2)
+
+        self.server.putenv('QGIS_SERVER_PARALLEL_RENDERING', '0')
+        expected, expected_headers = self._two_maps('red')
+        self.assertEqual(self._rendered_layers(expected_headers), [])
+        self.assertImagesEqual(body, expected)
+
+    def test_getprint_blend_mode(self):
+        """A map with a blend mode is rendered on the page, the other maps are prerendered"""
+        body, headers = self._two_maps('red,blue')
+        self.assertEqual(self._rendered_layers(headers), [self.layer_ids['red']])
+
+        self.server.putenv('QGIS_SERVER_PARALLEL_RENDERING', '0')
+        expected, expected_headers = self._two_maps('red,blue')
+        self.assertImagesEqual(body, expected)
+
+        # the blue band is multiplied with the red square where they overlap, i.e. at 35,55
+        # in map units, 200.5mm,68.5mm on the page of map1 and 55.5mm,68.5mm on the page of map0
+        image = QImage.fromData(body, 'PNG').convertToFormat(QImage.Format_ARGB32)
+        self.assertEqual(image.pixelColor(int(200.5 * 96 / 25.4), int(68.5 * 96 / 25.4)).name(), '#000000')
+        self.assertEqual(image.pixelColor(int(55.5 * 96 / 25.4), int(68.5 * 96 / 25.4)).name(), '#ff0000')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,188 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the 8 bit PNG output of QgsServer WMS GetMap.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import shutil
+import tempfile
+import urllib.parse
+
+# The palette cache is configured when the server is initialized
+os.environ['QGIS_SERVER_PNG8_PALETTE_CACHE'] = '1'
+
+from qgis.testing import unittest
+from qgis.PyQt.QtGui import QImage, QColor
+from qgis.core import QgsProject, QgsRasterLayer
+from osgeo import gdal, osr
+from test_qgsserver import QgsServerTestBase
+
+SIZE = 64
+
+
+def solid_colors(x, y):
+    """16 opaque colors in blocks"""
+    i = (x // 16) * 4 + y // 16
+    return (i * 16, 255 - i * 16, (i * 97) % 256, 255)
+
+
+def gradient(x, y):
+    """4096 opaque colors"""
+    return (x * 4, y * 4, (x + y) * 2, 255)
+
+
+def transparent_colors(x, y):
+    """Few colors with partial transparency"""
+    return [(255, 0, 0, 128), (0, 0, 255, 64), (0, 200, 0, 200), (40, 80, 120, 255)][(x // 32) * 2 + y // 32]
+
+
+def left_colors(x, y):
+    """Colors of the left part of the image"""
+    return (200, 30, 30, 255) if x < SIZE // 2 else (30, 30, 200, 255)
+
+
+def right_colors(x, y):
+    """Colors of another layer set, which shares one color with the left layer"""
+    return (30, 30, 200, 255) if x < SIZE // 2 else (30, 200, 30, 255)
+
+
+RASTERS = {
+    'solid': solid_colors,
+    'gradient': gradient,
+    'transparent': transparent_colors,
+    'left': left_colors,
+    'right': right_colors,
+}
+
+
+class TestQgsServerWMSPng8(QgsServerTestBase):
+
+    """QGIS Server WMS GetMap 8 bit PNG tests"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestQgsServerWMSPng8, cls).setUpClass()
+        cls.temp_path = tempfile.mkdtemp()
+        cls.png8_project_path = os.path.join(cls.temp_path, 'png8.qgs')
+
+        srs = osr.SpatialReference()
+        srs.ImportFromEPSG(4326)
+        project = QgsProject()
+        for name, color in sorted(RASTERS.items()):
+            path = os.path.join(cls.temp_path, name + '.tif')
+            ds = gdal.GetDriverByName('GTiff').Create(path, SIZE, SIZE, 4, gdal.GDT_Byte,
+                                                      ['PHOTOMETRIC=RGB', 'ALPHA=UNASSOCIATED'])
+            ds.SetGeoTransform([0, 1, 0, SIZE, 0, -1])
+            ds.SetProjection(srs.ExportToWkt())
+            pixels = [color(x, y) for y in range(SIZE) for x in range(SIZE)]
+            for band in range(4):
+                ds.GetRasterBand(band + 1).WriteRaster(0, 0, SIZE, SIZE, bytes(p[band] for p in pixels))
+            ds = None
+            layer = QgsRasterLayer(path, name)
+            assert layer.isValid(), path
+            project.addMapLayer(layer)
+        assert project.write(cls.png8_project_path)
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.temp_path, True)
+        super(TestQgsServerWMSPng8, cls).tearDownClass()
+
+    def _get_map(self, layer, image_format, bbox='0,0,%d,%d' % (SIZE, SIZE)):
+        qs = '?' + '&'.join(['%s=%s' % i for i in sorted({
+            'MAP': urllib.parse.quote(self.png8_project_path),
+            'SERVICE': 'WMS',
+            'VERSION': '1.1.1',
+            'REQUEST': 'GetMap',
+            'LAYERS': layer,
+            'STYLES': '',
+            'FORMAT': urllib.parse.quote(image_format),
+            'TRANSPARENT': 'TRUE',
+            'BBOX': bbox,
+            'WIDTH': str(SIZE),
+            'HEIGHT': str(SIZE),
+            'SRS': 'EPSG:4326'
+        }.items())])
+        header, body = self._execute_request(qs)
+        image = QImage.fromData(body, 'PNG')
+        self.assertFalse(image.isNull(), body)
+        return image
+
+    def _get_maps(self, layer):
+        """Returns the 32 bit and 8 bit images of layer"""
+        image = self._get_map(layer, 'image/png')
+        image8 = self._get_map(layer, 'image/png; mode=8bit')
+        self.assertEqual(image8.format(), QImage.Format_Indexed8)
+        self.assertLessEqual(len(image8.colorTable()), 256)
+        return image.convertToFormat(QImage.Format_ARGB32), image8
+
+    def _differences(self, image, image8):
+        """Returns the largest and the mean differences of the channels of the pixels"""
+        image8 = image8.convertToFormat(QImage.Format_ARGB32)
+        largest = 0
+        total = 0
+        for y in range(SIZE):
+            for x in range(SIZE):
+                a = QColor.fromRgba(image.pixel(x, y))
+                b = QColor.fromRgba(image8.pixel(x, y))
+                d = [abs(a.red() - b.red()), abs(a.green() - b.green()), abs(a.blue() - b.blue()), abs(a.alpha() - b.alpha())]
+                largest = max(largest, max(d))
+                total += sum(d)
+        return largest, total / (SIZE * SIZE * 4.0)
+
+    def test_exact_colors(self):
+        """Images with up to 256 colors keep their colors"""
+        image, image8 = self._get_maps('solid')
+        self.assertEqual(len(image8.colorTable()), 16)
+        self.assertEqual(self._differences(image, image8), (0, 0))
+
+    def test_median_cut(self):
+        """Images with more colors are reduced to 256 colors"""
+        image, image8 = self._get_maps('gradient')
+        self.assertGreater(len(set(image.pixel(x, y) for y in range(SIZE) for x in range(SIZE))), 256)
+        self.assertGreater(len(image8.colorTable()), 128)
+        largest, mean = self._differences(image, image8)
+        self.assertLessEqual(largest, 32)
+        self.assertLessEqual(mean, 6)
+
+    def test_transparency(self):
+        """Colors are not darkened by the premultiplied alpha of the rendered image"""
+        image, image8 = self._get_maps('transparent')
+        largest, mean = self._differences(image, image8)
+        self.assertLessEqual(largest, 2)
+        red = QColor.fromRgba(image8.convertToFormat(QImage.Format_ARGB32).pixel(8, 8))
+        self.assertAlmostEqual(red.red(), 255, delta=2)
+        self.assertAlmostEqual(red.alpha(), 128, delta=2)
+
+    def test_palette_cache(self):
+        """The images of a layer set share a palette, to which missing colors are added"""
+        left = self._get_map('left', 'image/png; mode=8bit')
+        self.assertEqual(len(left.colorTable()), 2)
+
+        # same layer set, another extent with the transparent background as new color
+        bbox = '%d,0,%d,%d' % (SIZE // 2, SIZE + SIZE // 2, SIZE)
+        shifted = self._get_map('left', 'image/png; mode=8bit', bbox)
+        self.assertEqual(len(shifted.colorTable()), 3)
+        self.assertEqual(shifted.colorTable()[:2], left.colorTable())
+        image = self._get_map('left', 'image/png', bbox).convertToFormat(QImage.Format_ARGB32)
+        self.assertEqual(self._differences(image, shifted), (0, 0))
+
+        # another layer set has its own palette
+        image, right = self._get_maps('right')
+        self.assertEqual(self._differences(image, right), (0, 0))
+        self.assertEqual(len(right.colorTable()), 2)
+        self.assertNotEqual(right.colorTable(), left.colorTable())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,168 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the QgsServer WMS tile cache.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import json
+import shutil
+import tempfile
+import time
+import urllib.parse
+
+# The tile cache is configured when the server is initialized
+TILE_CACHE_DIRECTORY = tempfile.mkdtemp()
+os.environ['QGIS_SERVER_TILE_CACHE_SIZE'] = str(64 * 1024 * 1024)
+os.environ['QGIS_SERVER_TILE_CACHE_DIRECTORY'] = TILE_CACHE_DIRECTORY
+os.environ['QGIS_SERVER_METATILE_SIZE'] = '2'
+
+from qgis.testing import unittest
+from qgis.PyQt.QtCore import QCoreApplication, QEventLoop
+from qgis.PyQt.QtGui import QImage, QColor
+from qgis.core import QgsFillSymbol, QgsProject, QgsSingleSymbolRenderer, QgsVectorLayer
+import osgeo.gdal  # NOQA
+from test_qgsserver import QgsServerTestBase
+
+TILE_SIZE = 128
+
+# Asymmetric shapes, so that tiles swapped along an axis do not look the same
+SHAPES = [
+    [[[0, 0], [90, 0], [0, 80], [0, 0]]],
+    [[[50, 50], [85, 60], [60, 85], [50, 50]]],
+    [[[-10, -20], [30, 5], [10, 40], [-10, -20]]],
+]
+
+
+class TestQgsServerWMSTileCache(QgsServerTestBase):
+
+    """QGIS Server WMS tile cache tests"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestQgsServerWMSTileCache, cls).setUpClass()
+        cls.temp_path = tempfile.mkdtemp()
+        cls.tiles_project_path = cls._write_project('tiles', SHAPES, '255,0,0')
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.temp_path, True)
+        shutil.rmtree(TILE_CACHE_DIRECTORY, True)
+        super(TestQgsServerWMSTileCache, cls).tearDownClass()
+
+    @classmethod
+    def _write_project(cls, name, shapes, color):
+        path = os.path.join(cls.temp_path, name + '.geojson')
+        if not os.path.exists(path):
+            features = [{'type': 'Feature', 'properties': {'id': i}, 'geometry': {'type': 'Polygon', 'coordinates': shape}}
+                        for i, shape in enumerate(shapes)]
+            with open(path, 'w') as f:
+                json.dump({'type': 'FeatureCollection', 'features': features}, f)
+        layer = QgsVectorLayer(path, 'shapes', 'ogr')
+        assert layer.isValid(), path
+        symbol = QgsFillSymbol.createSimple({'color': color, 'outline_style': 'no'})
+        layer.setRenderer(QgsSingleSymbolRenderer(symbol))
+        project = QgsProject()
+        project.addMapLayer(layer)
+        project_path = os.path.join(cls.temp_path, name + '.qgs')
+        assert project.write(project_path)
+        return project_path
+
+    def _get_map(self, project_path, version, crs, bbox, size=TILE_SIZE):
+        qs = '?' + '&'.join(['%s=%s' % i for i in sorted({
+            'MAP': urllib.parse.quote(project_path),
+            'SERVICE': 'WMS',
+            'VERSION': version,
+            'REQUEST': 'GetMap',
+            'LAYERS': 'shapes',
+            'STYLES': '',
+            'FORMAT': 'image/png',
+            'BBOX': ','.join(str(c) for c in bbox),
+            'WIDTH': str(size),
+            'HEIGHT': str(size),
+            'CRS' if version == '1.3.0' else 'SRS': crs
+        }.items())])
+        header, body = self._execute_request(qs)
+        image = QImage.fromData(body, 'PNG')
+        self.assertFalse(image.isNull(), body)
+        return image.convertToFormat(QImage.Format_ARGB32)
+
+    def _reference(self):
+        """Renders the 2x2 tiles of the metatile at the origin and a margin in a request
+        which is not aligned on the grid, so that it does not use the tile cache"""
+        return self._get_map(self.tiles_project_path, '1.1.1', 'EPSG:4326', [-22.5, -22.5, 90, 90], 320)
+
+    def assertImagesEqual(self, image, expected, msg):
+        self.assertEqual(image.size(), expected.size(), msg)
+        different = 0
+        for y in range(expected.height()):
+            for x in range(expected.width()):
+                a = QColor.fromRgba(image.pixel(x, y))
+                b = QColor.fromRgba(expected.pixel(x, y))
+                if max(abs(a.red() - b.red()), abs(a.green() - b.green()), abs(a.blue() - b.blue()), abs(a.alpha() - b.alpha())) > 8:
+                    different += 1
+        # allow some antialiasing differences along the edges of the shapes
+        self.assertLessEqual(different, expected.width(), msg)
+
+    def _check_tiles(self, version, crs, inverted_axis):
+        reference = self._reference()
+        for _ in range(2):
+            for i, j in ((1, 0), (0, 0), (0, 1), (1, 1)):
+                # tile i along the longitude and j along the latitude, the first request
+                # renders the metatile, the other tiles come from the cache
+                bbox = [45 * i, 45 * j, 45 * (i + 1), 45 * (j + 1)]
+                if inverted_axis:
+                    bbox = [bbox[1], bbox[0], bbox[3], bbox[2]]
+                tile = self._get_map(self.tiles_project_path, version, crs, bbox)
+                expected = reference.copy(64 + TILE_SIZE * i, TILE_SIZE * (1 - j), TILE_SIZE, TILE_SIZE)
+                self.assertImagesEqual(tile, expected, '%s %s tile %d,%d' % (version, crs, i, j))
+
+    def test_metatile_slicing(self):
+        self._check_tiles('1.1.1', 'EPSG:4326', False)
+
+    def test_axis_order(self):
+        # EPSG:4326 has the latitude first in WMS 1.3.0, CRS:84 has the longitude first
+        self._check_tiles('1.3.0', 'EPSG:4326', True)
+        self._check_tiles('1.3.0', 'CRS:84', False)
+
+    def _tile_files(self):
+        files = set()
+        for root, dirs, names in os.walk(TILE_CACHE_DIRECTORY):
+            files.update(os.path.join(root, name) for name in names if name.endswith('.png'))
+        return files
+
+    def test_invalidation(self):
+        world = [[[-180, -90], [180, -90], [180, 90], [-180, 90], [-180, -90]]]
+        project_path = self._write_project('invalidation', [world], '255,0,0')
+        other_files = self._tile_files()
+
+        tile = self._get_map(project_path, '1.1.1', 'EPSG:4326', [0, 0, 45, 45])
+        self.assertEqual(tile.pixelColor(64, 64).name(), '#ff0000')
+        project_files = self._tile_files() - other_files
+        self.assertEqual(len(project_files), 4)
+
+        # the change of the project file removes its tiles from the memory and disk caches
+        time.sleep(1)
+        self._write_project('invalidation', [world], '0,0,255')
+        deadline = time.time() + 10
+        while self._tile_files() & project_files and time.time() < deadline:
+            QCoreApplication.processEvents(QEventLoop.AllEvents, 100)
+        self.assertFalse(self._tile_files() & project_files)
+        self.assertTrue(other_files <= self._tile_files())
+
+        for bbox in ([0, 0, 45, 45], [45, 45, 90, 90]):
+            tile = self._get_map(project_path, '1.1.1', 'EPSG:4326', bbox)
+            self.assertEqual(tile.pixelColor(64, 64).name(), '#0000ff')
+
+
+if __name__ == '__main__':
+    unittest.main()